@@ -28,17 +28,21 @@
 #include "itkLimiterFunctionBase.h"
 #include "itkFixedArray.h"
 #include "itkAdvancedTransform.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include <vnl/vnl_sparse_matrix.h>
 
 #include "itkImageMaskSpatialObject.h"
+#include "itkPackedImageMask.h"
 
 // Needed for checking for B-spline for faster implementation
 #include "itkAdvancedBSplineDeformableTransform.h"
 #include "itkAdvancedCombinationTransform.h"
+#include "itkStackTransform.h"
 
 #include "itkPlatformMultiThreader.h"
 
 #include <memory> // For unique_ptr.
+#include <vector>
 
 namespace itk
 {
@@ -131,6 +135,7 @@ public:
 
   typedef ImageMaskSpatialObject<Self::FixedImageDimension>  FixedImageMaskSpatialObject2Type;
   typedef ImageMaskSpatialObject<Self::MovingImageDimension> MovingImageMaskSpatialObject2Type;
+  typedef PackedImageMask<Self::MovingImageDimension>        MovingImagePackedMaskType;
 
   /** Some useful extra typedefs. */
   typedef typename FixedImageType::PixelType             FixedImagePixelType;
@@ -165,6 +170,9 @@ public:
   typedef typename BSplineOrder2TransformType::Pointer                           BSplineOrder2TransformPointer;
   typedef typename BSplineOrder3TransformType::Pointer                           BSplineOrder3TransformPointer;
 
+  /** Typedef for the stack transform, whose sub transforms each have their own block of parameters. */
+  typedef StackTransform<ScalarType, FixedImageDimension, MovingImageDimension> StackTransformType;
+
   /** Hessian type; for SelfHessian (experimental feature) */
   typedef typename DerivativeType::ValueType  HessianValueType;
   typedef vnl_sparse_matrix<HessianValueType> HessianType;
@@ -173,6 +181,10 @@ public:
   typedef itk::PlatformMultiThreader          ThreaderType;
   typedef typename ThreaderType::WorkUnitInfo ThreadInfoType;
 
+  /** Typedefs for the random number generator. */
+  typedef Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+  typedef typename RandomGeneratorType::Pointer             RandomGeneratorPointer;
+
   /** Public methods ********************/
 
   /** Set the transform, of advanced type. */
@@ -238,6 +250,21 @@ public:
   itkGetConstMacro(UseFixedImageLimiter, bool);
   itkGetConstMacro(UseMovingImageLimiter, bool);
 
+  /** Get the true extrema of the fixed image, as computed by the last call to Initialize(),
+   * when the fixed image limiter is used. */
+  itkGetConstMacro(FixedImageTrueMin, FixedImagePixelType);
+  itkGetConstMacro(FixedImageTrueMax, FixedImagePixelType);
+
+  /** Specify the true extrema of the fixed image (for example, retrieved from a cache), so
+   * that the next call to Initialize() does not need to compute them. */
+  void
+  SetFixedImageTrueExtrema(const FixedImagePixelType trueMin, const FixedImagePixelType trueMax)
+  {
+    this->m_FixedImageTrueMin = trueMin;
+    this->m_FixedImageTrueMax = trueMax;
+    this->m_FixedImageTrueExtremaAreSpecified = true;
+  }
+
   /** You may specify a scaling vector for the moving image derivatives.
    * If the UseMovingImageDerivativeScales is true, the moving image derivatives
    * are multiplied by the moving image derivative scales (element-wise)
@@ -286,6 +313,31 @@ public:
   itkGetConstReferenceMacro(UseMultiThread, bool);
   itkBooleanMacro(UseMultiThread);
 
+  /** Select whether the initial transform of an AdvancedCombinationTransform
+   * is cached at the samples of the image sampler. The samples are added to the
+   * cache of the transform whenever the sampler generates a new sample set, so
+   * this only pays off when the same samples are used in each iteration, for
+   * example with a grid or full sampler.
+   */
+  itkSetMacro(UseInitialTransformCache, bool);
+  itkGetConstMacro(UseInitialTransformCache, bool);
+  itkBooleanMacro(UseInitialTransformCache);
+
+  /** Select whether the derivative is assembled per stack slice, when the transform is a StackTransform.
+   * Each thread then handles the slices of a contiguous range of sub transforms, for all samples, and writes
+   * directly into the parameter blocks of those sub transforms, which do not overlap. So the Jacobian and
+   * derivative updates of a thread stay within a few contiguous parameter blocks, and no cross-thread
+   * reduction of the derivative is needed. Only used by the groupwise metrics that support it.
+   */
+  itkSetMacro(PartitionSamplesByStackSlice, bool);
+  itkGetConstMacro(PartitionSamplesByStackSlice, bool);
+  itkBooleanMacro(PartitionSamplesByStackSlice);
+
+  /** Set/Get the random number generator, for metrics that draw random numbers by themselves (for example, to
+   * sample the last dimension). By default, the global instance is used. */
+  itkSetObjectMacro(RandomGenerator, RandomGeneratorType);
+  itkGetModifiableObjectMacro(RandomGenerator, RandomGeneratorType);
+
   /** Contains calls from GetValueAndDerivative that are thread-unsafe,
    * together with preparation for multi-threading.
    * Note that the only reason why this function is not protected, is
@@ -412,6 +464,9 @@ protected:
   static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
   AccumulateDerivativesThreaderCallback(void * arg);
 
+  /** The random number generator. */
+  RandomGeneratorPointer m_RandomGenerator{ RandomGeneratorType::GetInstance() };
+
   /** Variables for multi-threading. */
   bool m_UseMetricSingleThreaded{ true };
   bool m_UseMultiThread{ false };
@@ -489,6 +544,25 @@ protected:
   virtual void
   CheckNumberOfSamples(unsigned long wanted, unsigned long found) const;
 
+  /** Subtract from the derivative its mean over the last dimension, as used by the groupwise metrics
+   * (with their SubtractMean option). For a B-spline transform, the mean is taken per control point over
+   * the last dimension of the grid, which has size lastDimGridSize. For a stack transform, it is taken per
+   * parameter over the numberOfSubTransforms subtransforms. */
+  static void
+  SubtractMeanOverLastDimension(DerivativeType &   derivative,
+                                const bool         transformIsStackTransform,
+                                const unsigned int lastDimGridSize,
+                                const unsigned int numberOfSubTransforms);
+
+  /** Returns for each of the first numberOfSlices positions in the last dimension of the fixed image the work
+   * unit that handles it, when PartitionSamplesByStackSlice is set: each work unit gets the slices of a contiguous
+   * range of sub transforms of the StackTransform. Returns an empty vector when the derivative should not be
+   * assembled per stack slice, for example because the transform is not a StackTransform. It is assumed that
+   * the initial transform, if any, does not change the last coordinate, like the stack transforms.
+   */
+  std::vector<ThreadIdType>
+  ComputeWorkUnitPerStackSlice(const unsigned int numberOfSlices) const;
+
   /** Methods for image derivative evaluation support **********/
 
   /** Initialize variables for image derivative computation; this
@@ -545,6 +619,15 @@ protected:
   virtual void
   CheckForBSplineTransform(void) const;
 
+  /** Cache the initial transform of a combination transform at the current
+   * samples, if requested and if the samples have changed since the last call,
+   * or if the transform has discarded its cache since then.
+   * Called by BeforeThreadedGetValueAndDerivative, after updating the sampler.
+   * Metrics that update the sampler by themselves should call it as well.
+   */
+  virtual void
+  UpdateInitialTransformCache(void) const;
+
   /** Transform a point from FixedImage domain to MovingImage domain.
    * This function also checks if mapped point is within support region of
    * the transform. It returns true if so, and false otherwise.
@@ -563,7 +646,8 @@ protected:
                             TransformJacobianType &      jacobian,
                             NonZeroJacobianIndicesType & nzji) const;
 
-  /** Convenience method: check if point is inside the moving mask. *****************/
+  /** Convenience method: check if point is inside the moving mask. Uses a packed copy of
+   * the moving mask (created by Initialize()), when the mask is an image mask. *****************/
   virtual bool
   IsInsideMovingMask(const MovingImagePointType & point) const;
 
@@ -572,6 +656,11 @@ protected:
   virtual void
   InitializeLimiters(void);
 
+  /** Compute the true extrema of the fixed image, within the fixed image region and mask. Called by
+   * InitializeLimiters(), unless the extrema were specified by SetFixedImageTrueExtrema(). */
+  void
+  ComputeFixedImageTrueExtrema(void);
+
   /** Inheriting classes can specify whether they use the image limiter functionality
    * Make sure to set it before calling Initialize; default: false. */
   itkSetMacro(UseFixedImageLimiter, bool);
@@ -599,6 +688,18 @@ private:
   double m_RequiredRatioOfValidSamples{ 0.25 };
   bool   m_UseMovingImageDerivativeScales{ false };
   bool   m_ScaleGradientWithRespectToMovingImageOrientation{ false };
+  bool   m_UseInitialTransformCache{ false };
+  bool   m_PartitionSamplesByStackSlice{ false };
+  bool   m_FixedImageTrueExtremaAreSpecified{ false };
+
+  /** The update time of the sample container that was used to fill the initial transform cache, and the time at
+   * which it was used.
+   */
+  mutable ModifiedTimeType m_InitialTransformCacheUpdateMTime{ 0 };
+  mutable TimeStamp        m_InitialTransformCacheTimeStamp;
+
+  /** The packed copy of the moving image mask, used by IsInsideMovingMask(). */
+  typename MovingImagePackedMaskType::ConstPointer m_MovingImagePackedMask;
 
   MovingImageDerivativeScalesType m_MovingImageDerivativeScales{ MovingImageDerivativeScalesType::Filled(1.0) };
 };
@@ -29,6 +29,8 @@
 
 #include "itkTimeProbe.h"
 
+#include <cstdint> // For uint64_t.
+
 namespace itk
 {
 
@@ -93,6 +95,10 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::Initialize(void)
   /** Initialize transform, interpolator, etc. */
   Superclass::Initialize();
 
+  /** Create a packed copy of the moving image mask, for fast IsInsideMovingMask() queries. */
+  this->m_MovingImagePackedMask =
+    MovingImagePackedMaskType::CreateFromSpatialObject(this->m_MovingImageMask.GetPointer());
+
   /** Setup the parameters for the gray value limiters. */
   this->InitializeLimiters();
 
@@ -193,37 +199,15 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::InitializeLimiters(void)
       itkExceptionMacro(<< "No fixed image limiter has been set!");
     }
 
-    itk::TimeProbe timer;
-    timer.Start();
-
-    typedef typename itk::ComputeImageExtremaFilter<FixedImageType> ComputeFixedImageExtremaFilterType;
-    typename ComputeFixedImageExtremaFilterType::Pointer            computeFixedImageExtrema =
-      ComputeFixedImageExtremaFilterType::New();
-    computeFixedImageExtrema->SetInput(this->GetFixedImage());
-    computeFixedImageExtrema->SetImageRegion(this->GetFixedImageRegion());
-    if (this->m_FixedImageMask.IsNotNull())
+    if (this->m_FixedImageTrueExtremaAreSpecified)
     {
-      computeFixedImageExtrema->SetUseMask(true);
-
-      const FixedImageMaskSpatialObject2Type * fMask =
-        dynamic_cast<const FixedImageMaskSpatialObject2Type *>(this->m_FixedImageMask.GetPointer());
-      if (fMask)
-      {
-        computeFixedImageExtrema->SetImageSpatialMask(fMask);
-      }
-      else
-      {
-        computeFixedImageExtrema->SetImageMask(this->GetFixedImageMask());
-      }
+      /** Use the extrema that were specified by SetFixedImageTrueExtrema, just once. */
+      this->m_FixedImageTrueExtremaAreSpecified = false;
+    }
+    else
+    {
+      this->ComputeFixedImageTrueExtrema();
     }
-
-    computeFixedImageExtrema->Update();
-    timer.Stop();
-    elxout << "  Computing the fixed image extrema took " << static_cast<long>(timer.GetMean() * 1000) << " ms."
-           << std::endl;
-
-    this->m_FixedImageTrueMax = computeFixedImageExtrema->GetMaximum();
-    this->m_FixedImageTrueMin = computeFixedImageExtrema->GetMinimum();
 
     this->m_FixedImageMinLimit = static_cast<FixedImageLimiterOutputType>(
       this->m_FixedImageTrueMin -
@@ -297,6 +281,49 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::InitializeLimiters(void)
 } // end InitializeLimiters()
 
 
+/**
+ * ****************** ComputeFixedImageTrueExtrema *****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::ComputeFixedImageTrueExtrema(void)
+{
+  itk::TimeProbe timer;
+  timer.Start();
+
+  typedef typename itk::ComputeImageExtremaFilter<FixedImageType> ComputeFixedImageExtremaFilterType;
+  typename ComputeFixedImageExtremaFilterType::Pointer            computeFixedImageExtrema =
+    ComputeFixedImageExtremaFilterType::New();
+  computeFixedImageExtrema->SetInput(this->GetFixedImage());
+  computeFixedImageExtrema->SetImageRegion(this->GetFixedImageRegion());
+  if (this->m_FixedImageMask.IsNotNull())
+  {
+    computeFixedImageExtrema->SetUseMask(true);
+
+    const FixedImageMaskSpatialObject2Type * fMask =
+      dynamic_cast<const FixedImageMaskSpatialObject2Type *>(this->m_FixedImageMask.GetPointer());
+    if (fMask)
+    {
+      computeFixedImageExtrema->SetImageSpatialMask(fMask);
+    }
+    else
+    {
+      computeFixedImageExtrema->SetImageMask(this->GetFixedImageMask());
+    }
+  }
+
+  computeFixedImageExtrema->Update();
+  timer.Stop();
+  elxout << "  Computing the fixed image extrema took " << static_cast<long>(timer.GetMean() * 1000) << " ms."
+         << std::endl;
+
+  this->m_FixedImageTrueMax = computeFixedImageExtrema->GetMaximum();
+  this->m_FixedImageTrueMin = computeFixedImageExtrema->GetMinimum();
+
+} // end ComputeFixedImageTrueExtrema()
+
+
 /**
  * ********************* InitializeImageSampler ****************************
  */
@@ -732,6 +759,13 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::IsInsideMovingMask(const
   /** If a mask has been set: */
   if (this->m_MovingImageMask.IsNotNull())
   {
+    /** Use the packed copy of the mask, when it was created from the current mask, and the mask has not been modified
+     * since then. */
+    if (this->m_MovingImagePackedMask.IsNotNull() &&
+        this->m_MovingImagePackedMask->IsCreatedFrom(this->m_MovingImageMask.GetPointer()))
+    {
+      return this->m_MovingImagePackedMask->IsInside(point);
+    }
     return this->m_MovingImageMask->IsInsideInWorldSpace(point);
   }
 
@@ -781,12 +815,65 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::BeforeThreadedGetValueAnd
     if (this->m_UseImageSampler)
     {
       this->GetImageSampler()->Update();
+      this->UpdateInitialTransformCache();
     }
   }
 
 } // end BeforeThreadedGetValueAndDerivative()
 
 
+/**
+ * *********************** UpdateInitialTransformCache ***********************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::UpdateInitialTransformCache(void) const
+{
+  if (!this->m_UseInitialTransformCache || !this->m_UseImageSampler)
+  {
+    return;
+  }
+
+  /** Only a combination transform has an initial transform. */
+  CombinationTransformType * combinationTransform =
+    dynamic_cast<CombinationTransformType *>(this->m_AdvancedTransform.GetPointer());
+  if (combinationTransform == nullptr || combinationTransform->GetInitialTransform() == nullptr ||
+      !combinationTransform->GetUseComposition())
+  {
+    return;
+  }
+
+  /** Check if the sampler generated a new sample set since the last time, or if the cache of the transform has been
+   * discarded since then, for example because the initial transform was modified. The transform may be shared with
+   * other metrics, which add their own points to the cache.
+   */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  if (sampleContainer->GetUpdateMTime() == this->m_InitialTransformCacheUpdateMTime &&
+      combinationTransform->GetInitialTransformCacheMTime() < this->m_InitialTransformCacheTimeStamp.GetMTime() &&
+      combinationTransform->GetNumberOfCachedInitialTransformPoints() > 0)
+  {
+    return;
+  }
+
+  /** Collect the sample coordinates and cache the initial transform. */
+  std::vector<FixedImagePointType> fixedPoints;
+  fixedPoints.reserve(sampleContainer->Size());
+  typename ImageSampleContainerType::ConstIterator fiter;
+  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
+  for (fiter = fbegin; fiter != fend; ++fiter)
+  {
+    fixedPoints.push_back((*fiter).Value().m_ImageCoordinates);
+  }
+
+  combinationTransform->CacheInitialTransform(fixedPoints);
+  this->m_InitialTransformCacheUpdateMTime = sampleContainer->GetUpdateMTime();
+  this->m_InitialTransformCacheTimeStamp.Modified();
+
+} // end UpdateInitialTransformCache()
+
+
 /**
  * **************** GetValueThreaderCallback *******
  */
@@ -925,6 +1012,140 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::CheckNumberOfSamples(unsi
 } // end CheckNumberOfSamples()
 
 
+/**
+ * ******************* SubtractMeanOverLastDimension *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::SubtractMeanOverLastDimension(
+  DerivativeType &   derivative,
+  const bool         transformIsStackTransform,
+  const unsigned int lastDimGridSize,
+  const unsigned int numberOfSubTransforms)
+{
+  const unsigned int numberOfParameters = derivative.GetSize();
+
+  if (!transformIsStackTransform)
+  {
+    /** Update derivative per dimension.
+     * Parameters are ordered xxxxxxx yyyyyyy zzzzzzz ttttttt and
+     * per dimension xyz.
+     */
+    const unsigned int numParametersPerDimension = numberOfParameters / MovingImageDimension;
+    const unsigned int numControlPointsPerDimension = numParametersPerDimension / lastDimGridSize;
+    DerivativeType     mean(numControlPointsPerDimension);
+    for (unsigned int d = 0; d < MovingImageDimension; ++d)
+    {
+      /** Compute mean per dimension. */
+      mean.Fill(0.0);
+      const unsigned int starti = numParametersPerDimension * d;
+      for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
+      {
+        const unsigned int index = i % numControlPointsPerDimension;
+        mean[index] += derivative[i];
+      }
+      mean /= static_cast<double>(lastDimGridSize);
+
+      /** Update derivative for every control point per dimension. */
+      for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
+      {
+        const unsigned int index = i % numControlPointsPerDimension;
+        derivative[i] -= mean[index];
+      }
+    }
+  }
+  else
+  {
+    /** Update derivative per dimension.
+     * Parameters are ordered x0x0x0y0y0y0z0z0z0x1x1x1y1y1y1z1z1z1 with
+     * the number the time point index.
+     */
+    const unsigned int numParametersPerLastDimension = numberOfParameters / numberOfSubTransforms;
+    DerivativeType     mean(numParametersPerLastDimension);
+    mean.Fill(0.0);
+
+    /** Compute mean per control point. */
+    for (unsigned int t = 0; t < numberOfSubTransforms; ++t)
+    {
+      const unsigned int startc = numParametersPerLastDimension * t;
+      for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
+      {
+        const unsigned int index = c % numParametersPerLastDimension;
+        mean[index] += derivative[c];
+      }
+    }
+    mean /= static_cast<double>(numberOfSubTransforms);
+
+    /** Update derivative per control point. */
+    for (unsigned int t = 0; t < numberOfSubTransforms; ++t)
+    {
+      const unsigned int startc = numParametersPerLastDimension * t;
+      for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
+      {
+        const unsigned int index = c % numParametersPerLastDimension;
+        derivative[c] -= mean[index];
+      }
+    }
+  }
+
+} // end SubtractMeanOverLastDimension()
+
+
+/**
+ * ******************* ComputeWorkUnitPerStackSlice *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+std::vector<ThreadIdType>
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::ComputeWorkUnitPerStackSlice(
+  const unsigned int numberOfSlices) const
+{
+  if (!this->m_PartitionSamplesByStackSlice || !this->m_UseMultiThread)
+  {
+    return {};
+  }
+
+  /** The stack transform may be the current transform of a combination transform. */
+  const auto * const combinationTransform =
+    dynamic_cast<const CombinationTransformType *>(this->m_AdvancedTransform.GetPointer());
+  const auto * const stackTransform = dynamic_cast<const StackTransformType *>(
+    combinationTransform ? combinationTransform->GetCurrentTransform() : this->m_AdvancedTransform.GetPointer());
+
+  if (stackTransform == nullptr || stackTransform->GetNumberOfSubTransforms() == 0)
+  {
+    return {};
+  }
+
+  const unsigned int  numberOfSubTransforms = stackTransform->GetNumberOfSubTransforms();
+  const std::uint64_t numberOfWorkUnits = Self::GetNumberOfWorkUnits();
+
+  std::vector<ThreadIdType> workUnitPerSlice(numberOfSlices);
+  ContinuousIndex<double, FixedImageDimension> voxelCoord;
+  voxelCoord.Fill(0.0);
+
+  for (unsigned int slice = 0; slice < numberOfSlices; ++slice)
+  {
+    /** The sub transform of a slice follows from the last coordinate of any of its points. */
+    voxelCoord[FixedImageDimension - 1] = slice;
+    FixedImagePointType fixedPoint;
+    this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint(voxelCoord, fixedPoint);
+
+    /** With composition, the current transform is evaluated at the point mapped by the initial transform. */
+    if (combinationTransform && combinationTransform->GetUseComposition() &&
+        combinationTransform->GetInitialTransform() != nullptr)
+    {
+      fixedPoint = combinationTransform->GetInitialTransform()->TransformPoint(fixedPoint);
+    }
+
+    const std::uint64_t subTransformIndex = stackTransform->GetSubTransformIndex(fixedPoint);
+    workUnitPerSlice[slice] = static_cast<ThreadIdType>(subTransformIndex * numberOfWorkUnits / numberOfSubTransforms);
+  }
+  return workUnitPerSlice;
+
+} // end ComputeWorkUnitPerStackSlice()
+
+
 /**
  * ********************* PrintSelf ****************************
  */
@@ -20,6 +20,7 @@
 
 #include "itkAdvancedImageToImageMetric.h"
 #include "itkKernelFunctionBase2.h"
+#include "itkArray2D.h"
 
 
 namespace itk
@@ -113,6 +114,7 @@ public:
   using typename Superclass::MeasureType;
   using typename Superclass::DerivativeType;
   using typename Superclass::DerivativeValueType;
+  using typename Superclass::NumberOfParametersType;
   using typename Superclass::ParametersType;
   using typename Superclass::FixedImagePixelType;
   using typename Superclass::MovingImageRegionType;
@@ -212,6 +214,27 @@ public:
   itkSetMacro(FiniteDifferencePerturbation, double);
   itkGetConstMacro(FiniteDifferencePerturbation, double);
 
+  /** Whether to keep a copy of the joint histogram after each computation, so that other
+   * metrics, which have this metric as their JointPDFSource, may reuse it; default: false.
+   */
+  itkSetMacro(ShareJointPDF, bool);
+  itkGetConstMacro(ShareJointPDF, bool);
+
+  /** Another histogram-based metric on the same image pair (for example within a
+   * CombinationImageToImageMetric), whose joint histogram is reused by this metric,
+   * instead of sampling and binning again. The joint histogram is only reused when the
+   * source has ShareJointPDF switched on, when it has been computed for the same
+   * transform parameters, and when both metrics have the same images, transform, masks,
+   * image sampler, interpolator, histogram bins and Parzen kernels, and limiters of the
+   * same class with the same bounds and thresholds. Otherwise this metric computes its
+   * own joint histogram. The source should be evaluated before this metric, which then
+   * does not update the shared image sampler again. Only the computation of the joint
+   * histogram by ComputePDFs() is shared: the explicit PDF derivatives are always computed
+   * by this metric itself. Default: nullptr.
+   */
+  itkSetConstObjectMacro(JointPDFSource, Self);
+  itkGetConstObjectMacro(JointPDFSource, Self);
+
 protected:
   /** The constructor. */
   ParzenWindowHistogramImageToImageMetric();
@@ -294,6 +317,14 @@ protected:
   KernelFunctionPointer m_MovingKernel;
   KernelFunctionPointer m_DerivativeMovingKernel;
 
+  /** Helper array for storing the values of the JointPDF ratios, for the
+   * low memory variant of the analytic derivative (see ComputeDerivativeLowMemory).
+   * Only allocated when UseExplicitPDFDerivatives is false.
+   */
+  typedef double              PRatioType;
+  typedef Array2D<PRatioType> PRatioArrayType;
+  mutable PRatioArrayType     m_PRatioArray;
+
   /** Threading related parameters. */
   mutable std::vector<JointPDFPointer> m_ThreaderJointPDFs;
 
@@ -306,10 +337,18 @@ protected:
   };
   ParzenWindowHistogramMultiThreaderParameterType m_ParzenWindowHistogramThreaderParameters;
 
+  /** The per-thread joint PDFs are kept zero in between iterations, except for
+   * st_TouchedRegion, the region of bins that is touched by the samples of the
+   * thread. Only this region is accumulated (and reset) by AfterThreadedComputePDFs.
+   * They are zeroed by InitializeThreadingParameters. st_JointPDFIsZero is false when
+   * a full reset is needed (after an exception).
+   */
   struct ParzenWindowHistogramGetValueAndDerivativePerThreadStruct
   {
-    SizeValueType   st_NumberOfPixelsCounted;
-    JointPDFPointer st_JointPDF;
+    SizeValueType      st_NumberOfPixelsCounted;
+    JointPDFPointer    st_JointPDF;
+    JointPDFRegionType st_TouchedRegion;
+    bool               st_JointPDFIsZero;
   };
   itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
                ParzenWindowHistogramGetValueAndDerivativePerThreadStruct,
@@ -329,10 +368,21 @@ protected:
   inline void
   ThreadedComputePDFs(ThreadIdType threadId);
 
-  /** Single-threadedly accumulate results. */
+  /** Accumulate results. The joint PDFs of the threads are accumulated multi-threadedly,
+   * by dividing the rows of the joint PDF over the threads.
+   */
   inline void
   AfterThreadedComputePDFs(void) const;
 
+  /** Returns the region of the joint PDF that is affected by UpdateJointPDFAndDerivatives,
+   * for any pair of (limited) image values within the specified ranges.
+   */
+  JointPDFRegionType
+  ComputeAffectedJointPDFRegion(const RealType & fixedImageMinValue,
+                                const RealType & fixedImageMaxValue,
+                                const RealType & movingImageMinValue,
+                                const RealType & movingImageMaxValue) const;
+
   /** Helper function to launch the threads. */
   static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
   ComputePDFsThreaderCallback(void * arg);
@@ -341,6 +391,34 @@ protected:
   void
   LaunchComputePDFsThreaderCallback(void) const;
 
+  /** Compute the derivative for the low memory variant of the analytic derivative,
+   * by a second loop over the samples. Assumes that m_PRatioArray has already been
+   * computed, such that the derivative equals:
+   *   sum_x dM/dmu(x) * sum_i sum_k PRatio(i,k) * B_f(i,x) * dB_m/dxi(k,x) / et,
+   * where B_f and dB_m are the fixed Parzen window and the derivative of the moving Parzen
+   * window, and et the moving image bin size. Executes multi-threadedly when
+   * m_UseMultiThread == true.
+   */
+  virtual void
+  ComputeDerivativeLowMemory(DerivativeType & derivative) const;
+
+  /** Helper function that adds the contributions of the samples in the range
+   * [begin, end) of the sample container to the low memory derivative.
+   */
+  void
+  ComputeDerivativeLowMemoryOfSamples(const unsigned long begin,
+                                      const unsigned long end,
+                                      const ThreadIdType  threadId,
+                                      DerivativeType &    derivative) const;
+
+  /** Helper function to update the derivative for the low memory variant. */
+  void
+  UpdateDerivativeLowMemory(const RealType &                   fixedImageValue,
+                            const RealType &                   movingImageValue,
+                            const DerivativeType &             imageJacobian,
+                            const NonZeroJacobianIndicesType & nzji,
+                            DerivativeType &                   derivative) const;
+
   /** Compute the Parzen values given an image value and a starting histogram index
    * Compute the values at (parzenWindowIndex - parzenWindowTerm + k) for
    * k = 0 ... kernelsize-1
@@ -514,6 +592,27 @@ private:
   bool          m_UseExplicitPDFDerivatives;
   bool          m_UseFiniteDifferenceDerivative;
   double        m_FiniteDifferencePerturbation;
+
+  /** Variables for sharing the joint histogram with other metrics. */
+  bool                    m_ShareJointPDF;
+  ConstPointer            m_JointPDFSource;
+  mutable JointPDFPointer m_SharedJointPDF;
+  mutable double          m_SharedAlpha;
+  mutable SizeValueType   m_SharedNumberOfPixelsCounted;
+  mutable ParametersType  m_SharedJointPDFParameters;
+
+  /** Store a copy of the (unnormalized) joint histogram, when ShareJointPDF is on. */
+  void
+  StoreSharedJointPDF(const ParametersType & parameters) const;
+
+  /** Copy the joint histogram from the JointPDFSource, when it may be reused. Returns false otherwise. */
+  bool
+  ReuseSharedJointPDF(const ParametersType & parameters) const;
+
+  /** Whether the limiters are the same object, or limit in the same way. */
+  template <class TLimiter>
+  static bool
+  IsSameLimiter(const TLimiter * const limiter1, const TLimiter * const limiter2);
 };
 
 } // end namespace itk
@@ -26,6 +26,9 @@
 #include "itkImageScanlineIterator.h"
 #include <vnl/vnl_math.h>
 
+#include <algorithm> // For copy_n, fill, min and max.
+#include <typeinfo>  // For typeid.
+
 namespace itk
 {
 
@@ -68,6 +71,10 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ParzenWindow
 
   this->m_UseExplicitPDFDerivatives = true;
 
+  this->m_ShareJointPDF = false;
+  this->m_SharedAlpha = 0.0;
+  this->m_SharedNumberOfPixelsCounted = 0;
+
   /** Initialize the m_ParzenWindowHistogramThreaderParameters */
   this->m_ParzenWindowHistogramThreaderParameters.m_Metric = this;
 
@@ -105,6 +112,8 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::PrintSelf(st
   os << indent << "NumberOfMovingHistogramBins: " << this->m_NumberOfMovingHistogramBins << std::endl;
   os << indent << "FixedKernelBSplineOrder: " << this->m_FixedKernelBSplineOrder << std::endl;
   os << indent << "MovingKernelBSplineOrder: " << this->m_MovingKernelBSplineOrder << std::endl;
+  os << indent << "ShareJointPDF: " << this->m_ShareJointPDF << std::endl;
+  os << indent << "JointPDFSource: " << this->m_JointPDFSource.GetPointer() << std::endl;
 
   /*double m_MovingImageNormalizedMin;
   double m_FixedImageNormalizedMin;
@@ -244,6 +253,16 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::InitializeHi
   this->m_JointPDF->SetRegions(jointPDFRegion);
   this->m_JointPDF->Allocate();
 
+  /** Invalidate the shared copy of the joint histogram. */
+  this->m_SharedJointPDF = nullptr;
+  this->m_SharedJointPDFParameters.SetSize(0);
+
+  /** Allocate small amount of memory for the m_PRatioArray. */
+  if (!this->m_UseExplicitPDFDerivatives)
+  {
+    this->m_PRatioArray.SetSize(this->m_NumberOfFixedHistogramBins, this->m_NumberOfMovingHistogramBins);
+  }
+
   if (this->GetUseDerivative())
   {
     /** For the derivatives of the joint PDF define a region starting from {0,0,0}
@@ -441,8 +460,8 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::InitializeTh
   /** Resize and initialize the threading related parameters.
    * The SetSize() functions do not resize the data when this is not
    * needed, which saves valuable re-allocation time.
-   * Filling the potentially large vectors is performed later, in each thread,
-   * which has performance benefits for larger vector sizes.
+   * The joint PDFs of the threads are zeroed here, and kept zero in between iterations
+   * by AfterThreadedComputePDFs().
    */
 
   /** Construct regions for the joint histograms. */
@@ -471,6 +490,7 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::InitializeTh
   {
     this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted =
       NumericTraits<SizeValueType>::Zero;
+    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_TouchedRegion = JointPDFRegionType();
 
     // Initialize the joint pdf
     JointPDFPointer & jointPDF = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_JointPDF;
@@ -483,6 +503,8 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::InitializeTh
       jointPDF->SetRegions(jointPDFRegion);
       jointPDF->Allocate();
     }
+    jointPDF->FillBuffer(NumericTraits<PDFValueType>::ZeroValue());
+    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_JointPDFIsZero = true;
   }
 
 } // end InitializeThreadingParameters()
@@ -1086,10 +1108,18 @@ template <class TFixedImage, class TMovingImage>
 void
 ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFs(const ParametersType & parameters) const
 {
+  /** Reuse the joint histogram of another metric, if possible. */
+  if (this->ReuseSharedJointPDF(parameters))
+  {
+    return;
+  }
+
   /** Option for now to still use the single threaded code. */
   if (!this->m_UseMultiThread)
   {
-    return this->ComputePDFsSingleThreaded(parameters);
+    this->ComputePDFsSingleThreaded(parameters);
+    this->StoreSharedJointPDF(parameters);
+    return;
   }
 
   /** Call non-thread-safe stuff, such as:
@@ -1113,9 +1143,134 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFs(
   /** Gather the results from all threads. */
   this->AfterThreadedComputePDFs();
 
+  /** Keep a copy of the joint histogram for other metrics, if desired. */
+  this->StoreSharedJointPDF(parameters);
+
 } // end ComputePDFs()
 
 
+/**
+ * ******************* StoreSharedJointPDF *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::StoreSharedJointPDF(
+  const ParametersType & parameters) const
+{
+  if (!this->m_ShareJointPDF)
+  {
+    return;
+  }
+
+  /** The histogram is stored before it is normalized by the subclasses. */
+  if (this->m_SharedJointPDF.IsNull())
+  {
+    this->m_SharedJointPDF = JointPDFType::New();
+  }
+  if (this->m_SharedJointPDF->GetLargestPossibleRegion() != this->m_JointPDF->GetLargestPossibleRegion())
+  {
+    this->m_SharedJointPDF->SetRegions(this->m_JointPDF->GetLargestPossibleRegion());
+    this->m_SharedJointPDF->Allocate();
+  }
+  const SizeValueType numberOfBins = this->m_JointPDF->GetLargestPossibleRegion().GetNumberOfPixels();
+  std::copy_n(this->m_JointPDF->GetBufferPointer(), numberOfBins, this->m_SharedJointPDF->GetBufferPointer());
+
+  this->m_SharedAlpha = this->m_Alpha;
+  this->m_SharedNumberOfPixelsCounted = this->m_NumberOfPixelsCounted;
+  this->m_SharedJointPDFParameters = parameters;
+
+} // end StoreSharedJointPDF()
+
+
+/**
+ * ******************* ReuseSharedJointPDF *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+bool
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ReuseSharedJointPDF(
+  const ParametersType & parameters) const
+{
+  const Self * const source = this->m_JointPDFSource.GetPointer();
+  if (source == nullptr || source == this || !source->m_ShareJointPDF || source->m_SharedJointPDF.IsNull())
+  {
+    return false;
+  }
+
+  /** Check that the source computed exactly the same joint histogram as this metric would, from the same samples. */
+  const bool sameSetup =
+    source->GetFixedImage() == this->GetFixedImage() && source->GetMovingImage() == this->GetMovingImage() &&
+    source->GetTransform() == this->GetTransform() && source->GetFixedImageMask() == this->GetFixedImageMask() &&
+    source->GetMovingImageMask() == this->GetMovingImageMask() &&
+    source->GetUseImageSampler() == this->GetUseImageSampler() &&
+    source->GetImageSampler() == this->GetImageSampler() && source->GetInterpolator() == this->GetInterpolator() &&
+    source->GetUseFixedImageLimiter() == this->GetUseFixedImageLimiter() &&
+    source->GetUseMovingImageLimiter() == this->GetUseMovingImageLimiter() &&
+    (!this->GetUseFixedImageLimiter() ||
+     IsSameLimiter(source->GetFixedImageLimiter(), this->GetFixedImageLimiter())) &&
+    (!this->GetUseMovingImageLimiter() ||
+     IsSameLimiter(source->GetMovingImageLimiter(), this->GetMovingImageLimiter())) &&
+    source->m_FixedKernelBSplineOrder == this->m_FixedKernelBSplineOrder &&
+    source->m_MovingKernelBSplineOrder == this->m_MovingKernelBSplineOrder &&
+    source->m_FixedImageBinSize == this->m_FixedImageBinSize &&
+    source->m_MovingImageBinSize == this->m_MovingImageBinSize &&
+    source->m_FixedImageNormalizedMin == this->m_FixedImageNormalizedMin &&
+    source->m_MovingImageNormalizedMin == this->m_MovingImageNormalizedMin &&
+    source->m_SharedJointPDF->GetLargestPossibleRegion() == this->m_JointPDF->GetLargestPossibleRegion();
+  if (!sameSetup || source->m_SharedJointPDFParameters != parameters)
+  {
+    return false;
+  }
+
+  /** This metric still needs the transform parameters, for the derivative. The samples were already updated by the
+   * source, as the image sampler is shared, so it is not updated again.
+   */
+  if (this->m_UseMetricSingleThreaded)
+  {
+    this->SetTransformParameters(parameters);
+    this->UpdateInitialTransformCache();
+  }
+
+  const SizeValueType numberOfBins = this->m_JointPDF->GetLargestPossibleRegion().GetNumberOfPixels();
+  std::copy_n(source->m_SharedJointPDF->GetBufferPointer(), numberOfBins, this->m_JointPDF->GetBufferPointer());
+  this->m_Alpha = source->m_SharedAlpha;
+  this->m_NumberOfPixelsCounted = source->m_SharedNumberOfPixelsCounted;
+  return true;
+
+} // end ReuseSharedJointPDF()
+
+
+/**
+ * ******************* IsSameLimiter *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+template <class TLimiter>
+bool
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::IsSameLimiter(const TLimiter * const limiter1,
+                                                                                  const TLimiter * const limiter2)
+{
+  if (limiter1 == limiter2)
+  {
+    return true;
+  }
+  if (limiter1 == nullptr || limiter2 == nullptr)
+  {
+    return false;
+  }
+
+  /** Different limiter objects of the same class limit in the same way, when they have the same bounds and thresholds.
+   * Each metric component of elastix has its own limiters, which are initialized from its own images.
+   */
+  return typeid(*limiter1) == typeid(*limiter2) && limiter1->GetLowerBound() == limiter2->GetLowerBound() &&
+         limiter1->GetUpperBound() == limiter2->GetUpperBound() &&
+         limiter1->GetLowerThreshold() == limiter2->GetLowerThreshold() &&
+         limiter1->GetUpperThreshold() == limiter2->GetUpperThreshold();
+
+} // end IsSameLimiter()
+
+
 /**
  * ******************* ThreadedComputePDFs *******************
  */
@@ -1125,12 +1280,16 @@ void
 ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ThreadedComputePDFs(ThreadIdType threadId)
 {
   /** Get a handle to the pre-allocated joint PDF for the current thread.
-   * The initialization is performed here, so that it is done multi-threadedly
-   * instead of sequentially in InitializeThreadingParameters().
+   * It is zeroed by InitializeThreadingParameters(), and reset by AfterThreadedComputePDFs().
+   * Only when a previous computation was interrupted by an exception, it is reset here.
    */
-  JointPDFPointer & jointPDF =
-    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId].st_JointPDF;
-  jointPDF->FillBuffer(NumericTraits<PDFValueType>::ZeroValue());
+  auto &            perThreadVariables = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId];
+  JointPDFPointer & jointPDF = perThreadVariables.st_JointPDF;
+  if (!perThreadVariables.st_JointPDFIsZero)
+  {
+    jointPDF->FillBuffer(NumericTraits<PDFValueType>::ZeroValue());
+  }
+  perThreadVariables.st_JointPDFIsZero = false;
 
   /** Get a handle to the sample container. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
@@ -1154,6 +1313,10 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ThreadedComp
 
   /** Create variables to store intermediate results. circumvent false sharing */
   unsigned long numberOfPixelsCounted = 0;
+  RealType      fixedImageMinValue = NumericTraits<RealType>::max();
+  RealType      fixedImageMaxValue = NumericTraits<RealType>::NonpositiveMin();
+  RealType      movingImageMinValue = NumericTraits<RealType>::max();
+  RealType      movingImageMaxValue = NumericTraits<RealType>::NonpositiveMin();
 
   /** Loop over sample container and compute contribution of each sample to pdfs. */
   for (fiter = fbegin; fiter != fend; ++fiter)
@@ -1191,14 +1354,25 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ThreadedComp
       fixedImageValue = this->GetFixedImageLimiter()->Evaluate(fixedImageValue);
       movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue);
 
+      /** Keep track of the range of values, to determine the touched bins. */
+      fixedImageMinValue = std::min(fixedImageMinValue, fixedImageValue);
+      fixedImageMaxValue = std::max(fixedImageMaxValue, fixedImageValue);
+      movingImageMinValue = std::min(movingImageMinValue, movingImageValue);
+      movingImageMaxValue = std::max(movingImageMaxValue, movingImageValue);
+
       /** Compute this sample's contribution to the joint distributions. */
       this->UpdateJointPDFAndDerivatives(fixedImageValue, movingImageValue, nullptr, nullptr, jointPDF.GetPointer());
     }
   } // end iterating over fixed image spatial sample container for loop
 
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
-  this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted =
-    numberOfPixelsCounted;
+  perThreadVariables.st_NumberOfPixelsCounted = numberOfPixelsCounted;
+  perThreadVariables.st_TouchedRegion = JointPDFRegionType();
+  if (numberOfPixelsCounted > 0)
+  {
+    perThreadVariables.st_TouchedRegion = this->ComputeAffectedJointPDFRegion(
+      fixedImageMinValue, fixedImageMaxValue, movingImageMinValue, movingImageMaxValue);
+  }
 
 } // end ThreadedComputePDFs()
 
@@ -1225,6 +1399,72 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::AfterThreade
     this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted = 0;
   }
 
+  /** Accumulate the joint histogram, before any exception may be thrown, so that the
+   * joint PDFs of the threads are properly reset.
+   * The rows of the joint histogram (one per fixed bin) are divided into blocks of
+   * at least a few kilobytes, which are accumulated in parallel. Each bin is thus
+   * written by one work unit only, and only the touched regions of the threads are
+   * visited. These regions are reset to zero, for the next iteration.
+   */
+  const JointPDFSizeType jointPDFSize = this->m_JointPDF->GetBufferedRegion().GetSize();
+  const SizeValueType    numberOfMovingBins = jointPDFSize[0];
+  const SizeValueType    numberOfFixedBins = jointPDFSize[1];
+  PDFValueType * const   jointPDFBuffer = this->m_JointPDF->GetBufferPointer();
+  const auto * const     perThreadVariables = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables;
+
+  const auto accumulateRows = [numberOfThreads, numberOfMovingBins, jointPDFBuffer, perThreadVariables](
+                                const SizeValueType beginRow, const SizeValueType endRow) {
+    std::fill(jointPDFBuffer + beginRow * numberOfMovingBins,
+              jointPDFBuffer + endRow * numberOfMovingBins,
+              NumericTraits<PDFValueType>::ZeroValue());
+
+    for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+    {
+      const JointPDFRegionType & touchedRegion = perThreadVariables[i].st_TouchedRegion;
+      const SizeValueType        touchedBeginColumn = static_cast<SizeValueType>(touchedRegion.GetIndex()[0]);
+      const SizeValueType        touchedEndColumn = touchedBeginColumn + touchedRegion.GetSize()[0];
+      const SizeValueType        touchedBeginRow = static_cast<SizeValueType>(touchedRegion.GetIndex()[1]);
+      const SizeValueType        touchedEndRow = touchedBeginRow + touchedRegion.GetSize()[1];
+      PDFValueType * const       threadBuffer = perThreadVariables[i].st_JointPDF->GetBufferPointer();
+
+      for (SizeValueType row = std::max(beginRow, touchedBeginRow); row < std::min(endRow, touchedEndRow); ++row)
+      {
+        const SizeValueType rowOffset = row * numberOfMovingBins;
+        for (SizeValueType column = touchedBeginColumn; column < touchedEndColumn; ++column)
+        {
+          jointPDFBuffer[rowOffset + column] += threadBuffer[rowOffset + column];
+          threadBuffer[rowOffset + column] = NumericTraits<PDFValueType>::ZeroValue();
+        }
+      }
+    }
+  };
+
+  const SizeValueType minimumBlockSize = 4096 / sizeof(PDFValueType);
+  const SizeValueType numberOfRowsPerBlock =
+    std::max<SizeValueType>(1, (minimumBlockSize + numberOfMovingBins - 1) / numberOfMovingBins);
+  const SizeValueType numberOfBlocks = (numberOfFixedBins + numberOfRowsPerBlock - 1) / numberOfRowsPerBlock;
+
+  if (numberOfBlocks > 1)
+  {
+    this->m_Threader->ParallelizeArray(
+      0,
+      numberOfBlocks,
+      [&accumulateRows, numberOfRowsPerBlock, numberOfFixedBins](const SizeValueType block) {
+        accumulateRows(block * numberOfRowsPerBlock, std::min((block + 1) * numberOfRowsPerBlock, numberOfFixedBins));
+      },
+      nullptr);
+  }
+  else
+  {
+    accumulateRows(0, numberOfFixedBins);
+  }
+
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_TouchedRegion = JointPDFRegionType();
+    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_JointPDFIsZero = true;
+  }
+
   /** Check if enough samples were valid. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
   this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
@@ -1232,39 +1472,55 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::AfterThreade
   /** Compute alpha. */
   this->m_Alpha = 1.0 / static_cast<double>(this->m_NumberOfPixelsCounted);
 
-  /** Accumulate joint histogram. */
-  // could be multi-threaded too, by each thread updating only a part of the JointPDF.
-  typedef ImageScanlineIterator<JointPDFType> JointPDFIteratorType;
-  JointPDFIteratorType                        it(this->m_JointPDF, this->m_JointPDF->GetBufferedRegion());
-  std::vector<JointPDFIteratorType>           itT(numberOfThreads);
-  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
-  {
-    itT[i] = JointPDFIteratorType(this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_JointPDF,
-                                  this->m_JointPDF->GetBufferedRegion());
-  }
+} // end AfterThreadedComputePDFs()
 
-  PDFValueType sum;
-  while (!it.IsAtEnd())
+
+/**
+ * ******************* ComputeAffectedJointPDFRegion *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+auto
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputeAffectedJointPDFRegion(
+  const RealType & fixedImageMinValue,
+  const RealType & fixedImageMaxValue,
+  const RealType & movingImageMinValue,
+  const RealType & movingImageMaxValue) const -> JointPDFRegionType
+{
+  /** The lowest bin numbers affected by a pixel, exactly as in UpdateJointPDFAndDerivatives.
+   * These are non-decreasing functions of the image values.
+   */
+  const auto fixedParzenWindowIndex = [this](const RealType fixedImageValue) {
+    const double fixedImageParzenWindowTerm =
+      fixedImageValue / this->m_FixedImageBinSize - this->m_FixedImageNormalizedMin;
+    return static_cast<OffsetValueType>(std::floor(fixedImageParzenWindowTerm + this->m_FixedParzenTermToIndexOffset));
+  };
+  const auto movingParzenWindowIndex = [this](const RealType movingImageValue) {
+    const double movingImageParzenWindowTerm =
+      movingImageValue / this->m_MovingImageBinSize - this->m_MovingImageNormalizedMin;
+    return static_cast<OffsetValueType>(
+      std::floor(movingImageParzenWindowTerm + this->m_MovingParzenTermToIndexOffset));
+  };
+
+  JointPDFIndexType index;
+  index[0] = movingParzenWindowIndex(movingImageMinValue);
+  index[1] = fixedParzenWindowIndex(fixedImageMinValue);
+
+  JointPDFSizeType size;
+  size[0] = static_cast<SizeValueType>(movingParzenWindowIndex(movingImageMaxValue) - index[0]) +
+            this->m_JointPDFWindow.GetSize()[0];
+  size[1] = static_cast<SizeValueType>(fixedParzenWindowIndex(fixedImageMaxValue) - index[1]) +
+            this->m_JointPDFWindow.GetSize()[1];
+
+  /** The Parzen windows are always inside the joint PDF, but be safe. */
+  JointPDFRegionType region(index, size);
+  if (!region.Crop(this->m_JointPDF->GetLargestPossibleRegion()))
   {
-    while (!it.IsAtEndOfLine())
-    {
-      sum = NumericTraits<PDFValueType>::Zero;
-      for (ThreadIdType i = 0; i < numberOfThreads; ++i)
-      {
-        sum += itT[i].Value();
-        ++itT[i];
-      }
-      it.Set(sum);
-      ++it;
-    }
-    it.NextLine();
-    for (ThreadIdType i = 0; i < numberOfThreads; ++i)
-    {
-      itT[i].NextLine();
-    }
+    region = JointPDFRegionType();
   }
+  return region;
 
-} // end AfterThreadedComputePDFs()
+} // end ComputeAffectedJointPDFRegion()
 
 
 /**
@@ -1307,6 +1563,216 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::LaunchComput
 } // end LaunchComputePDFsThreaderCallback()
 
 
+/**
+ * ******************** ComputeDerivativeLowMemory *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputeDerivativeLowMemory(
+  DerivativeType & derivative) const
+{
+  const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
+
+  /** Option for now to still use the single threaded code. */
+  if (!this->m_UseMultiThread)
+  {
+    derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+    this->ComputeDerivativeLowMemoryOfSamples(0, sampleContainerSize, 0, derivative);
+    return;
+  }
+
+  /** Each work unit adds the contributions of its samples to its own derivative.
+   * These derivatives are reset by the accumulation below.
+   */
+  const ThreadIdType  numberOfWorkUnits = Self::GetNumberOfWorkUnits();
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(numberOfWorkUnits)));
+
+  this->m_Threader->ParallelizeArray(
+    0,
+    numberOfWorkUnits,
+    [this, sampleContainerSize, nrOfSamplesPerThreads](const SizeValueType workUnit) {
+      const ThreadIdType  threadId = static_cast<ThreadIdType>(workUnit);
+      const unsigned long pos_begin = std::min(nrOfSamplesPerThreads * threadId, sampleContainerSize);
+      const unsigned long pos_end = std::min(nrOfSamplesPerThreads * (threadId + 1), sampleContainerSize);
+      this->ComputeDerivativeLowMemoryOfSamples(
+        pos_begin, pos_end, threadId, this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Derivative);
+    },
+    nullptr);
+
+  /** Accumulate the derivatives of all threads. */
+  this->m_ThreaderMetricParameters.st_DerivativePointer = derivative.begin();
+  this->m_ThreaderMetricParameters.st_NormalizationFactor = 1.0;
+
+  this->m_Threader->SetSingleMethod(this->AccumulateDerivativesThreaderCallback,
+                                    const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
+  this->m_Threader->SingleMethodExecute();
+
+} // end ComputeDerivativeLowMemory()
+
+
+/**
+ * ******************** ComputeDerivativeLowMemoryOfSamples *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputeDerivativeLowMemoryOfSamples(
+  const unsigned long begin,
+  const unsigned long end,
+  const ThreadIdType  threadId,
+  DerivativeType &    derivative) const
+{
+  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
+  const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  NonZeroJacobianIndicesType   nzji = NonZeroJacobianIndicesType(nnzji);
+  DerivativeType               imageJacobian(nzji.size());
+
+  /** Create iterator over the samples in the range. */
+  ImageSampleContainerPointer                      sampleContainer = this->GetImageSampler()->GetOutput();
+  typename ImageSampleContainerType::ConstIterator fiter = sampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->Begin();
+  fiter += static_cast<int>(begin);
+  fend += static_cast<int>(end);
+
+  /** Loop over the samples and compute their contributions to the derivative. */
+  for (; fiter != fend; ++fiter)
+  {
+    /** Read fixed coordinates and create some variables. */
+    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+    RealType                    movingImageValue;
+    MovingImageDerivativeType   movingImageDerivative;
+    MovingImagePointType        mappedPoint;
+
+    /** Transform point and check if it is inside the B-spline support region. */
+    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+
+    /** Check if the point is inside the moving mask. */
+    if (sampleOk)
+    {
+      sampleOk = this->IsInsideMovingMask(mappedPoint);
+    }
+
+    /** Compute the moving image value, its derivative, and check
+     * if the point is inside the moving image buffer.
+     */
+    if (sampleOk)
+    {
+      sampleOk = this->m_UseMultiThread
+                   ? this->FastEvaluateMovingImageValueAndDerivative(
+                       mappedPoint, movingImageValue, &movingImageDerivative, threadId)
+                   : this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
+    }
+
+    if (sampleOk)
+    {
+      /** Get the fixed image value. */
+      RealType fixedImageValue = static_cast<RealType>((*fiter).Value().m_ImageValue);
+
+      /** Make sure the values fall within the histogram range. */
+      fixedImageValue = this->GetFixedImageLimiter()->Evaluate(fixedImageValue);
+      movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue, movingImageDerivative);
+
+      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
+      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
+        fixedPoint, movingImageDerivative, imageJacobian, nzji);
+
+      /** Compute this sample's contribution to the derivative. */
+      this->UpdateDerivativeLowMemory(fixedImageValue, movingImageValue, imageJacobian, nzji, derivative);
+
+    } // end sampleOk
+  }   // end loop over sample container
+
+} // end ComputeDerivativeLowMemoryOfSamples()
+
+
+/**
+ * ******************* UpdateDerivativeLowMemory *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::UpdateDerivativeLowMemory(
+  const RealType &                   fixedImageValue,
+  const RealType &                   movingImageValue,
+  const DerivativeType &             imageJacobian,
+  const NonZeroJacobianIndicesType & nzji,
+  DerivativeType &                   derivative) const
+{
+  /** In this function we need to do (see eq. 24 of Thevenaz [3]):
+   *      derivative -= constant * imageJacobian *
+   *          \sum_i \sum_k PRatio(i,k) * dB/dxi(xi,i,k),
+   * with i, k, the fixed and moving histogram bins,
+   * PRatio the precomputed ratio (for mutual information: log( p(i,k) / p(i) )), and
+   * dB/dxi the B-spline derivative.
+   *
+   * Note (1) that we only have to loop over i,k within the support
+   * of the B-spline Parzen-window.
+   * Note (2) that imageJacobian may be sparse.
+   */
+
+  /** Determine the affected region. */
+
+  /** Determine Parzen window arguments (see eq. 6 of Mattes paper [2]). */
+  const double fixedImageParzenWindowTerm =
+    fixedImageValue / this->m_FixedImageBinSize - this->m_FixedImageNormalizedMin;
+  const double movingImageParzenWindowTerm =
+    movingImageValue / this->m_MovingImageBinSize - this->m_MovingImageNormalizedMin;
+
+  /** The lowest bin numbers affected by this pixel: */
+  const int fixedParzenWindowIndex =
+    static_cast<int>(std::floor(fixedImageParzenWindowTerm + this->m_FixedParzenTermToIndexOffset));
+  const int movingParzenWindowIndex =
+    static_cast<int>(std::floor(movingImageParzenWindowTerm + this->m_MovingParzenTermToIndexOffset));
+
+  /** Compute the fixed Parzen values. */
+  ParzenValueContainerType fixedParzenValues(this->m_JointPDFWindow.GetSize()[1]);
+  this->EvaluateParzenValues(
+    fixedImageParzenWindowTerm, fixedParzenWindowIndex, this->m_FixedKernel, fixedParzenValues);
+
+  /** Compute the derivatives of the moving Parzen window. */
+  ParzenValueContainerType derivativeMovingParzenValues(this->m_JointPDFWindow.GetSize()[0]);
+  this->EvaluateParzenValues(
+    movingImageParzenWindowTerm, movingParzenWindowIndex, this->m_DerivativeMovingKernel, derivativeMovingParzenValues);
+
+  /** Get the moving image bin size. */
+  const double et = static_cast<double>(this->m_MovingImageBinSize);
+
+  /** Loop over the Parzen window region and increment sum. */
+  PDFValueType sum = 0.0;
+  for (unsigned int f = 0; f < fixedParzenValues.GetSize(); ++f)
+  {
+    const double fv_et = fixedParzenValues[f] / et;
+    for (unsigned int m = 0; m < derivativeMovingParzenValues.GetSize(); ++m)
+    {
+      sum += this->m_PRatioArray[f + fixedParzenWindowIndex][m + movingParzenWindowIndex] * fv_et *
+             derivativeMovingParzenValues[m];
+    }
+  }
+
+  /** Now compute derivative -= sum * imageJacobian. */
+  if (nzji.size() == this->GetNumberOfParameters())
+  {
+    /** Loop over all Jacobians. */
+    for (unsigned int mu = 0; mu < this->GetNumberOfParameters(); ++mu)
+    {
+      derivative[mu] += static_cast<DerivativeValueType>(imageJacobian[mu] * sum);
+    }
+  }
+  else
+  {
+    /** Loop only over the non-zero Jacobians. */
+    for (unsigned int i = 0; i < imageJacobian.GetSize(); ++i)
+    {
+      const unsigned int mu = nzji[i];
+      derivative[mu] += static_cast<DerivativeValueType>(imageJacobian[i] * sum);
+    }
+  }
+
+} // end UpdateDerivativeLowMemory()
+
+
 /**
  * ************************ ComputePDFsAndPDFDerivatives *******************
  */
@@ -1411,6 +1877,9 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsA
     this->m_Alpha = 1.0 / static_cast<double>(this->m_NumberOfPixelsCounted);
   }
 
+  /** Keep a copy of the joint histogram for other metrics, if desired. */
+  this->StoreSharedJointPDF(parameters);
+
 } // end ComputePDFsAndPDFDerivatives()
 
 
@@ -1635,6 +2104,9 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsA
     }
   }
 
+  /** Keep a copy of the joint histogram for other metrics, if desired. */
+  this->StoreSharedJointPDF(parameters);
+
 } // end ComputePDFsAndIncrementalPDFs()
 
 
@@ -38,9 +38,12 @@
 #include "itkAdvancedTransform.h"
 #include "itkSingleValuedCostFunction.h"
 #include "itkMacro.h"
+#include "itkMultiThreaderBase.h"
 #include "itkSpatialObject.h"
 #include "itkPointSet.h"
 
+#include <memory> // For unique_ptr.
+
 namespace itk
 {
 
@@ -170,6 +173,25 @@ public:
   itkGetConstReferenceMacro(UseMetricSingleThreaded, bool);
   itkBooleanMacro(UseMetricSingleThreaded);
 
+  /** Select the use of multi-threading. */
+  itkSetMacro(UseMultiThread, bool);
+  itkGetConstReferenceMacro(UseMultiThread, bool);
+  itkBooleanMacro(UseMultiThread);
+
+  /** Set the number of threads to use for computations. */
+  virtual void
+  SetNumberOfWorkUnits(ThreadIdType numberOfThreads)
+  {
+    this->m_Threader->SetNumberOfWorkUnits(numberOfThreads);
+  }
+
+  /** Get the number of threads to use for computations. */
+  ThreadIdType
+  GetNumberOfWorkUnits(void) const
+  {
+    return this->m_Threader->GetNumberOfWorkUnits();
+  }
+
 protected:
   SingleValuedPointSetToPointSetMetric();
   ~SingleValuedPointSetToPointSetMetric() override = default;
@@ -188,7 +210,57 @@ protected:
   mutable unsigned int m_NumberOfPointsCounted;
 
   /** Variables for multi-threading. */
-  bool m_UseMetricSingleThreaded;
+  bool                       m_UseMetricSingleThreaded;
+  bool                       m_UseMultiThread;
+  MultiThreaderBase::Pointer m_Threader;
+
+  /** Metrics may perform multi-threading by letting each work unit compute
+   * the value and derivative of a part of the points. These variables are
+   * initialized by InitializeThreadingParameters(), and summed by
+   * AccumulatePerThreadVariables(). Since GetValueAndDerivative is const,
+   * these member variables are mutable.
+   */
+  struct GetValueAndDerivativePerThreadStruct
+  {
+    SizeValueType  st_NumberOfPointsCounted;
+    MeasureType    st_Value;
+    DerivativeType st_Derivative;
+  };
+  itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
+               GetValueAndDerivativePerThreadStruct,
+               PaddedGetValueAndDerivativePerThreadStruct);
+  itkAlignedTypedef(ITK_CACHE_LINE_ALIGNMENT,
+                    PaddedGetValueAndDerivativePerThreadStruct,
+                    AlignedGetValueAndDerivativePerThreadStruct);
+  mutable std::unique_ptr<AlignedGetValueAndDerivativePerThreadStruct[]> m_GetValueAndDerivativePerThreadVariables{
+    nullptr
+  };
+  mutable ThreadIdType m_GetValueAndDerivativePerThreadVariablesSize{ 0 };
+
+  /** Initialize the per-thread variables. Called by Initialize() when multi-threading is used. */
+  virtual void
+  InitializeThreadingParameters(void) const;
+
+  /** Sum the numbers of points counted and the values of all work units, and, when
+   * the derivative is not null, also their derivatives. The derivatives of the
+   * work units are reset for the next iteration, in parallel over the parameters.
+   */
+  void
+  AccumulatePerThreadVariables(MeasureType & value, DerivativeType * derivative) const;
+
+  /** Calls rangeFunction( begin, end, threadId ) for contiguous ranges of [0, size), one per work unit,
+   * when multi-threading is used, and otherwise once, for the whole range, with threadId 0.
+   */
+  template <class TRangeFunction>
+  void
+  ParallelizeOverRanges(const SizeValueType size, const TRangeFunction & rangeFunction) const;
+
+  /** Tells whether ParallelizeOverRanges() divides the work over the per-thread variables. */
+  bool
+  UsesPerThreadVariables(void) const
+  {
+    return this->m_UseMultiThread && (this->m_GetValueAndDerivativePerThreadVariablesSize > 0);
+  }
 
 private:
   SingleValuedPointSetToPointSetMetric(const Self &) = delete;
@@ -36,6 +36,8 @@
 
 #include "itkSingleValuedPointSetToPointSetMetric.h"
 
+#include <algorithm> // For min.
+
 namespace itk
 {
 
@@ -55,6 +57,8 @@ SingleValuedPointSetToPointSetMetric<TFixedPointSet, TMovingPointSet>::SingleVal
   this->m_NumberOfPointsCounted = 0;
 
   this->m_UseMetricSingleThreaded = true;
+  this->m_UseMultiThread = false;
+  this->m_Threader = MultiThreaderBase::New();
 
 } // end Constructor
 
@@ -112,9 +116,134 @@ SingleValuedPointSetToPointSetMetric<TFixedPointSet, TMovingPointSet>::Initializ
     this->m_FixedPointSet->GetSource()->Update();
   }
 
+  /** Initialize some multi-threading related parameters. */
+  if (this->m_UseMultiThread)
+  {
+    this->InitializeThreadingParameters();
+  }
+
 } // end Initialize()
 
 
+/**
+ * ********************* InitializeThreadingParameters ****************************
+ */
+
+template <class TFixedPointSet, class TMovingPointSet>
+void
+SingleValuedPointSetToPointSetMetric<TFixedPointSet, TMovingPointSet>::InitializeThreadingParameters(void) const
+{
+  const ThreadIdType numberOfThreads = this->GetNumberOfWorkUnits();
+
+  /** Only resize the array of structs when needed. */
+  if (this->m_GetValueAndDerivativePerThreadVariablesSize != numberOfThreads)
+  {
+    this->m_GetValueAndDerivativePerThreadVariables.reset(
+      new AlignedGetValueAndDerivativePerThreadStruct[numberOfThreads]);
+    this->m_GetValueAndDerivativePerThreadVariablesSize = numberOfThreads;
+  }
+
+  /** Some initialization. The derivatives are reset after each iteration, by AccumulatePerThreadVariables(). */
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPointsCounted = NumericTraits<SizeValueType>::Zero;
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative.SetSize(this->GetNumberOfParameters());
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative.Fill(
+      NumericTraits<DerivativeValueType>::ZeroValue());
+  }
+
+} // end InitializeThreadingParameters()
+
+
+/**
+ * ********************* AccumulatePerThreadVariables ****************************
+ */
+
+template <class TFixedPointSet, class TMovingPointSet>
+void
+SingleValuedPointSetToPointSetMetric<TFixedPointSet, TMovingPointSet>::AccumulatePerThreadVariables(
+  MeasureType &    value,
+  DerivativeType * derivative) const
+{
+  const ThreadIdType numberOfThreads = this->m_GetValueAndDerivativePerThreadVariablesSize;
+
+  /** Sum the numbers of points counted and the values, and reset them. */
+  this->m_NumberOfPointsCounted = 0;
+  value = NumericTraits<MeasureType>::Zero;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    auto & perThreadVariables = this->m_GetValueAndDerivativePerThreadVariables[i];
+    this->m_NumberOfPointsCounted += perThreadVariables.st_NumberOfPointsCounted;
+    value += perThreadVariables.st_Value;
+    perThreadVariables.st_NumberOfPointsCounted = NumericTraits<SizeValueType>::Zero;
+    perThreadVariables.st_Value = NumericTraits<MeasureType>::Zero;
+  }
+
+  if (derivative == nullptr)
+  {
+    return;
+  }
+
+  /** Sum the derivatives, in parallel over blocks of parameters, and reset them. */
+  const SizeValueType numberOfParameters = this->GetNumberOfParameters();
+  const SizeValueType blockSize = (numberOfParameters + numberOfThreads - 1) / numberOfThreads;
+  this->m_Threader->ParallelizeArray(
+    0,
+    numberOfThreads,
+    [this, derivative, numberOfThreads, numberOfParameters, blockSize](const SizeValueType block) {
+      const SizeValueType       jmin = std::min(block * blockSize, numberOfParameters);
+      const SizeValueType       jmax = std::min(jmin + blockSize, numberOfParameters);
+      const DerivativeValueType zero = NumericTraits<DerivativeValueType>::ZeroValue();
+      for (SizeValueType j = jmin; j < jmax; ++j)
+      {
+        DerivativeValueType sum = zero;
+        for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+        {
+          sum += this->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative[j];
+          this->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative[j] = zero;
+        }
+        (*derivative)[j] = sum;
+      }
+    },
+    nullptr);
+
+} // end AccumulatePerThreadVariables()
+
+
+/**
+ * ******************* ParallelizeOverRanges *******************
+ */
+
+template <class TFixedPointSet, class TMovingPointSet>
+template <class TRangeFunction>
+void
+SingleValuedPointSetToPointSetMetric<TFixedPointSet, TMovingPointSet>::ParallelizeOverRanges(
+  const SizeValueType    size,
+  const TRangeFunction & rangeFunction) const
+{
+  if (this->UsesPerThreadVariables())
+  {
+    const ThreadIdType  numberOfThreads = this->m_GetValueAndDerivativePerThreadVariablesSize;
+    const SizeValueType rangeSize = (size + numberOfThreads - 1) / numberOfThreads;
+    this->m_Threader->ParallelizeArray(
+      0,
+      numberOfThreads,
+      [size, rangeSize, &rangeFunction](const SizeValueType threadId) {
+        const SizeValueType begin = std::min(threadId * rangeSize, size);
+        const SizeValueType end = std::min(begin + rangeSize, size);
+        rangeFunction(begin, end, static_cast<ThreadIdType>(threadId));
+      },
+      nullptr);
+  }
+  else
+  {
+    rangeFunction(0, size, 0);
+  }
+
+} // end ParallelizeOverRanges()
+
+
 /**
  * *********************** BeforeThreadedGetValueAndDerivative ***********************
  */
@@ -148,6 +277,7 @@ SingleValuedPointSetToPointSetMetric<TFixedPointSet, TMovingPointSet>::PrintSelf
   os << "Fixed mask: " << this->m_FixedImageMask.GetPointer() << std::endl;
   os << "Moving mask: " << this->m_MovingImageMask.GetPointer() << std::endl;
   os << "Transform: " << this->m_Transform.GetPointer() << std::endl;
+  os << "UseMultiThread: " << this->m_UseMultiThread << std::endl;
 
 } // end PrintSelf()
 
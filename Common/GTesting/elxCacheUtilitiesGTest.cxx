@@ -0,0 +1,99 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "elxCacheUtilities.h"
+#include "../Core/Main/GTesting/elxCoreMainGTestUtilities.h"
+
+#include <itksys/SystemTools.hxx>
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <string>
+
+// Using-declarations:
+using elx::CacheUtilities;
+using elx::CoreMainGTestUtilities::GetCurrentBinaryDirectoryPath;
+using elx::CoreMainGTestUtilities::GetNameOfTest;
+
+
+// Tests the hash values of some well-known test vectors of the 64-bit FNV-1a hash function.
+GTEST_TEST(CacheUtilities, AddToHash)
+{
+  EXPECT_EQ(CacheUtilities::FnvOffsetBasis, 0xcbf29ce484222325ULL);
+  EXPECT_EQ(CacheUtilities::AddToHash(CacheUtilities::FnvOffsetBasis, "a", 1), 0xaf63dc4c8601ec8cULL);
+  EXPECT_EQ(CacheUtilities::AddToHash(CacheUtilities::FnvOffsetBasis, "foobar", 6), 0x85944171f73967e8ULL);
+  EXPECT_EQ(CacheUtilities::HashToString(0xaf63dc4c8601ec8cULL), "af63dc4c8601ec8c");
+  EXPECT_EQ(CacheUtilities::HashToString(1), "0000000000000001");
+}
+
+
+// Tests that the hash of a file changes when its contents change, while its name stays the same.
+GTEST_TEST(CacheUtilities, AddFileToHash)
+{
+  const std::string directoryPath = GetCurrentBinaryDirectoryPath() + '/' + GetNameOfTest(*this);
+  itksys::SystemTools::MakeDirectory(directoryPath);
+  const std::string fileName = directoryPath + "/file.txt";
+
+  const auto writeFileAndHash = [&fileName](const std::string & contents) {
+    {
+      std::ofstream file(fileName, std::ios::binary);
+      file << contents;
+    }
+    return CacheUtilities::AddFileToHash(CacheUtilities::FnvOffsetBasis, fileName);
+  };
+
+  const auto hash = writeFileAndHash("contents");
+  EXPECT_EQ(writeFileAndHash("contents"), hash);
+  EXPECT_NE(writeFileAndHash("Contents"), hash);
+  EXPECT_NE(writeFileAndHash(std::string(100000, 'x')), writeFileAndHash(std::string(100001, 'x')));
+
+  // A file that cannot be read only adds its name.
+  const std::string nonExistingFileName = directoryPath + "/non-existing-file.txt";
+  EXPECT_EQ(CacheUtilities::AddFileToHash(CacheUtilities::FnvOffsetBasis, nonExistingFileName),
+            CacheUtilities::AddStringToHash(CacheUtilities::FnvOffsetBasis, nonExistingFileName));
+}
+
+
+// Tests that a temporary file keeps the extension of the file (not of its directory), and that committing it renames
+// the temporary file.
+GTEST_TEST(CacheUtilities, MakeTemporaryFileNameAndCommitFile)
+{
+  const std::string directoryPath = GetCurrentBinaryDirectoryPath() + '/' + GetNameOfTest(*this) + ".dir";
+
+  for (const std::string extension : { ".mha", "" })
+  {
+    const std::string fileName = directoryPath + "/file" + extension;
+    itksys::SystemTools::RemoveFile(fileName);
+
+    const std::string temporaryFileName = CacheUtilities::MakeTemporaryFileName(fileName);
+    EXPECT_TRUE(itksys::SystemTools::FileIsDirectory(directoryPath));
+    EXPECT_EQ(itksys::SystemTools::GetFilenamePath(temporaryFileName), directoryPath);
+    EXPECT_EQ(itksys::SystemTools::GetFilenameLastExtension(temporaryFileName), extension);
+    EXPECT_NE(temporaryFileName, fileName);
+
+    {
+      std::ofstream file(temporaryFileName);
+      file << "contents";
+    }
+    EXPECT_TRUE(CacheUtilities::CommitFile(temporaryFileName, fileName));
+    EXPECT_TRUE(itksys::SystemTools::FileExists(fileName, true));
+    EXPECT_FALSE(itksys::SystemTools::FileExists(temporaryFileName));
+  }
+}
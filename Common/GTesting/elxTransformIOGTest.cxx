@@ -979,3 +979,29 @@ GTEST_TEST(Transform, TransformedPointSameAsITKBSpline3D)
   Expect_elx_TransformPoint_yields_same_point_as_ITK<elx::AdvancedBSplineTransform>(itkTransform);
   Expect_elx_TransformPoint_yields_same_point_as_ITK<elx::RecursiveBSplineTransform>(itkTransform);
 }
+
+
+GTEST_TEST(TransformIO, WriteAndReadParametersBinaryFile)
+{
+  const auto        parameters = GeneratePseudoRandomParameters(42, -1.0);
+  const std::string fileName = "TransformIOGTest_WriteAndReadParametersBinaryFile.bin";
+
+  elx::TransformIO::WriteParametersToBinaryFile(parameters, fileName, "double");
+  EXPECT_EQ(elx::TransformIO::ReadParametersFromBinaryFile(fileName, "double", parameters.size()), parameters);
+
+  elx::TransformIO::WriteParametersToBinaryFile(parameters, fileName, "float");
+  const auto parametersReadAsFloat =
+    elx::TransformIO::ReadParametersFromBinaryFile(fileName, "float", parameters.size());
+  ASSERT_EQ(parametersReadAsFloat.size(), parameters.size());
+
+  for (unsigned int i = 0; i < parameters.size(); ++i)
+  {
+    EXPECT_EQ(parametersReadAsFloat[i], static_cast<double>(static_cast<float>(parameters[i])));
+  }
+
+  // The number of parameters must match the size of the file.
+  EXPECT_THROW(elx::TransformIO::ReadParametersFromBinaryFile(fileName, "float", parameters.size() + 1),
+               itk::ExceptionObject);
+  EXPECT_THROW(elx::TransformIO::ReadParametersFromBinaryFile(fileName, "int", parameters.size()),
+               itk::ExceptionObject);
+}
@@ -0,0 +1,190 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkAdvancedCombinationTransform.h"
+#include "elxGTestUtilities.h"
+#include "../Core/Main/GTesting/elxCoreMainGTestUtilities.h"
+
+#include "itkAdvancedRigid2DTransform.h"
+#include "itkAdvancedSimilarity2DTransform.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+// Using-declarations:
+using elx::CoreMainGTestUtilities::CheckNew;
+using elx::GTestUtilities::MakePoint;
+using elx::GTestUtilities::MakeVector;
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+using ScalarType = double;
+using CombinationTransformType = itk::AdvancedCombinationTransform<ScalarType, Dimension>;
+using PointType = CombinationTransformType::InputPointType;
+
+
+std::vector<PointType>
+MakeTestPoints()
+{
+  std::vector<PointType> points;
+  for (int i = -2; i <= 2; ++i)
+  {
+    for (int j = -2; j <= 2; ++j)
+    {
+      points.push_back(MakePoint(3.5 * i, 1.25 * j));
+    }
+  }
+  return points;
+}
+
+
+CombinationTransformType::Pointer
+MakeCombinationTransform()
+{
+  const auto initialTransform = itk::AdvancedRigid2DTransform<ScalarType>::New();
+  initialTransform->SetAngle(0.3);
+  initialTransform->SetTranslation(MakeVector(1.0, -2.0));
+
+  const auto currentTransform = itk::AdvancedSimilarity2DTransform<ScalarType>::New();
+  currentTransform->SetScale(1.1);
+  currentTransform->SetAngle(-0.2);
+
+  const auto combinationTransform = CheckNew<CombinationTransformType>();
+  combinationTransform->SetCurrentTransform(currentTransform);
+  combinationTransform->SetInitialTransform(initialTransform);
+  combinationTransform->SetUseComposition(true);
+  return combinationTransform;
+}
+
+} // namespace
+
+
+// Tests that caching the initial transform does not change the results of the composition.
+GTEST_TEST(AdvancedCombinationTransform, CachedInitialTransformYieldsSameResults)
+{
+  const auto points = MakeTestPoints();
+  const auto combinationTransform = MakeCombinationTransform();
+
+  std::vector<CombinationTransformType::OutputPointType>     expectedMappedPoints;
+  std::vector<CombinationTransformType::SpatialJacobianType> expectedSpatialJacobians;
+  std::vector<CombinationTransformType::JacobianType>        expectedJacobians;
+
+  for (const auto & point : points)
+  {
+    CombinationTransformType::SpatialJacobianType        sj;
+    CombinationTransformType::JacobianType               j;
+    CombinationTransformType::NonZeroJacobianIndicesType nzji;
+    combinationTransform->GetSpatialJacobian(point, sj);
+    combinationTransform->GetJacobian(point, j, nzji);
+    expectedMappedPoints.push_back(combinationTransform->TransformPoint(point));
+    expectedSpatialJacobians.push_back(sj);
+    expectedJacobians.push_back(j);
+  }
+
+  combinationTransform->CacheInitialTransform(points);
+  ASSERT_EQ(combinationTransform->GetNumberOfCachedInitialTransformPoints(), points.size());
+
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    CombinationTransformType::SpatialJacobianType        sj;
+    CombinationTransformType::JacobianType               j;
+    CombinationTransformType::NonZeroJacobianIndicesType nzji;
+    combinationTransform->GetSpatialJacobian(points[i], sj);
+    combinationTransform->GetJacobian(points[i], j, nzji);
+    EXPECT_EQ(combinationTransform->TransformPoint(points[i]), expectedMappedPoints[i]);
+    EXPECT_EQ(sj, expectedSpatialJacobians[i]);
+    EXPECT_EQ(j, expectedJacobians[i]);
+  }
+}
+
+
+// Tests that the cache is cleared when the combination method is changed.
+GTEST_TEST(AdvancedCombinationTransform, ChangingCombinationMethodClearsInitialTransformCache)
+{
+  const auto points = MakeTestPoints();
+  const auto combinationTransform = MakeCombinationTransform();
+
+  combinationTransform->CacheInitialTransform(points);
+  ASSERT_EQ(combinationTransform->GetNumberOfCachedInitialTransformPoints(), points.size());
+
+  combinationTransform->SetUseAddition(true);
+  EXPECT_EQ(combinationTransform->GetNumberOfCachedInitialTransformPoints(), 0U);
+
+  // Addition does not use the cache at all.
+  combinationTransform->CacheInitialTransform(points);
+  EXPECT_EQ(combinationTransform->GetNumberOfCachedInitialTransformPoints(), 0U);
+}
+
+
+// Tests that points cached by different users (for example, the metrics of a multi-metric registration) are added to
+// each other, rather than replacing each other.
+GTEST_TEST(AdvancedCombinationTransform, CachingMorePointsKeepsCachedPoints)
+{
+  const auto combinationTransform = MakeCombinationTransform();
+
+  const std::vector<PointType> firstPoints{ MakePoint(1.0, 2.0), MakePoint(-3.0, 0.5) };
+  const std::vector<PointType> secondPoints{ MakePoint(1.0, 2.0), MakePoint(4.0, -1.5), MakePoint(0.0, 0.0) };
+
+  combinationTransform->CacheInitialTransform(firstPoints);
+  const auto initialTransformCacheMTime = combinationTransform->GetInitialTransformCacheMTime();
+  combinationTransform->CacheInitialTransform(secondPoints);
+
+  // The point that is in both sets is only cached once.
+  EXPECT_EQ(combinationTransform->GetNumberOfCachedInitialTransformPoints(), 4U);
+  EXPECT_EQ(combinationTransform->GetInitialTransformCacheMTime(), initialTransformCacheMTime);
+
+  // When the cache would become too large, it is discarded, and only the new points are cached.
+  combinationTransform->SetMaximumNumberOfCachedInitialTransformPoints(5);
+  combinationTransform->CacheInitialTransform(firstPoints);
+  EXPECT_EQ(combinationTransform->GetNumberOfCachedInitialTransformPoints(), firstPoints.size());
+  EXPECT_GT(combinationTransform->GetInitialTransformCacheMTime(), initialTransformCacheMTime);
+}
+
+
+// Tests that the cache is not used anymore when the initial transform is modified.
+GTEST_TEST(AdvancedCombinationTransform, ModifyingInitialTransformInvalidatesCache)
+{
+  const auto points = MakeTestPoints();
+  const auto initialTransform = itk::AdvancedRigid2DTransform<ScalarType>::New();
+  initialTransform->SetAngle(0.3);
+
+  const auto combinationTransform = CheckNew<CombinationTransformType>();
+  combinationTransform->SetCurrentTransform(itk::AdvancedSimilarity2DTransform<ScalarType>::New());
+  combinationTransform->SetInitialTransform(initialTransform);
+  combinationTransform->SetUseComposition(true);
+
+  combinationTransform->CacheInitialTransform(points);
+  ASSERT_EQ(combinationTransform->GetNumberOfCachedInitialTransformPoints(), points.size());
+
+  initialTransform->SetAngle(-0.4);
+  EXPECT_EQ(combinationTransform->GetNumberOfCachedInitialTransformPoints(), 0U);
+
+  for (const auto & point : points)
+  {
+    CombinationTransformType::SpatialJacobianType expectedSpatialJacobian;
+    CombinationTransformType::SpatialJacobianType actualSpatialJacobian;
+    initialTransform->GetSpatialJacobian(point, expectedSpatialJacobian);
+    combinationTransform->GetSpatialJacobian(point, actualSpatialJacobian);
+    EXPECT_EQ(combinationTransform->TransformPoint(point), initialTransform->TransformPoint(point));
+    EXPECT_EQ(actualSpatialJacobian, expectedSpatialJacobian);
+  }
+}
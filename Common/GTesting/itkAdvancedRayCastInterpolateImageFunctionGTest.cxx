@@ -0,0 +1,150 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "itkAdvancedRayCastInterpolateImageFunction.h"
+#include "elxGTestUtilities.h"
+#include "../Core/Main/GTesting/elxCoreMainGTestUtilities.h"
+
+#include <itkEuler3DTransform.h>
+#include <itkImage.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+// Using-declarations:
+using elx::CoreMainGTestUtilities::CheckNew;
+using elx::GTestUtilities::MakePoint;
+using elx::GTestUtilities::MakeVector;
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using ImageType = itk::Image<float, Dimension>;
+using InterpolatorType = itk::AdvancedRayCastInterpolateImageFunction<ImageType, double>;
+
+
+// Casts a ray the way the interpolator did originally: the planes and corners which bound the volume are calculated
+// for each ray, and the intensities are integrated plane by plane, by GetCurrentIntensity() and
+// IncrementVoxelPointers().
+class ReferenceRayCastHelper : public RayCastHelper<ImageType, double>
+{
+public:
+  double
+  CastRay(const ImageType & image, const OutputPointType & point, const DirectionType & direction, double threshold)
+  {
+    double boundingPlane[6][4];
+    double boundingCorner[8][3];
+
+    this->SetImage(&image);
+    this->ZeroState();
+    EXPECT_TRUE(CalcPlanesAndCorners(image, boundingPlane, boundingCorner));
+    this->Initialise(boundingPlane, boundingCorner);
+
+    if (!this->SetRay(point, direction) || (this->m_RayIntersectionVoxels[0] == nullptr))
+    {
+      return 0.0;
+    }
+
+    double integral = 0.0;
+    for (int plane = 0; plane < this->m_TotalRayVoxelPlanes; ++plane)
+    {
+      const double intensity = this->GetCurrentIntensity();
+      if (intensity > threshold)
+      {
+        integral += intensity - threshold;
+      }
+      this->IncrementVoxelPointers();
+    }
+    return integral * this->GetRayPointSpacing();
+  }
+};
+
+
+// Creates a small volume, having an anisotropic spacing, and a smoothly varying (positive) intensity.
+ImageType::Pointer
+CreateVolume(const itk::Size<Dimension> & size)
+{
+  const auto image = ImageType::New();
+  image->SetRegions(size);
+  image->SetSpacing(MakeVector(1.0, 1.5, 0.75));
+  image->Allocate();
+
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const auto index = it.GetIndex();
+    it.Set(static_cast<float>(2.0 + std::sin(0.7 * index[0] + 0.3 * index[2]) + std::cos(0.5 * index[1])));
+  }
+  return image;
+}
+
+} // namespace
+
+
+// Tests that the digitally reconstructed radiograph (DRR), computed by evaluating the interpolator for the points of a
+// detector plane, is the same as when the planes and corners of the volume are calculated for each ray. Also after
+// setting another input image, having a different size.
+GTEST_TEST(AdvancedRayCastInterpolateImageFunction, SameDRRAsWithPlanesAndCornersPerRay)
+{
+  const auto transform = itk::Euler3DTransform<double>::New();
+  transform->SetRotation(0.1, -0.05, 0.2);
+  transform->SetTranslation(MakeVector(1.0, -2.0, 0.5));
+
+  const auto focalPoint = MakePoint(0.0, 0.0, -50.0);
+  const auto transformedFocalPoint = transform->TransformPoint(focalPoint);
+
+  const auto interpolator = CheckNew<InterpolatorType>();
+  interpolator->SetTransform(transform);
+  interpolator->SetFocalPoint(focalPoint);
+
+  for (const auto & size : { itk::Size<Dimension>{ { 9, 7, 8 } }, itk::Size<Dimension>{ { 6, 10, 5 } } })
+  {
+    const auto volume = CreateVolume(size);
+    interpolator->SetInputImage(volume);
+
+    for (const double threshold : { 0.0, 1.5 })
+    {
+      interpolator->SetThreshold(threshold);
+
+      unsigned int numberOfRaysThroughVolume = 0;
+
+      // The points of the detector plane, of which the outer ones yield rays that miss the volume.
+      for (double x = -12.0; x <= 12.0; x += 1.7)
+      {
+        for (double y = -12.0; y <= 12.0; y += 1.3)
+        {
+          const auto point = MakePoint(x, y, 30.0);
+
+          const double expectedValue =
+            ReferenceRayCastHelper().CastRay(*volume, point, transformedFocalPoint - point, threshold);
+          const double actualValue = interpolator->Evaluate(point);
+
+          EXPECT_NEAR(actualValue, expectedValue, 1e-10 * (1.0 + std::abs(expectedValue)));
+
+          if (expectedValue > 0.0)
+          {
+            ++numberOfRaysThroughVolume;
+          }
+        }
+      }
+      EXPECT_GT(numberOfRaysThroughVolume, 0U);
+    }
+  }
+}
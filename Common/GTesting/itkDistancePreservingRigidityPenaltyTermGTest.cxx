@@ -0,0 +1,226 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "DistancePreservingRigidityPenalty/itkDistancePreservingRigidityPenaltyTerm.h"
+#include "elxGTestUtilities.h"
+#include "../Core/Main/GTesting/elxCoreMainGTestUtilities.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include <itkImage.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkLinearInterpolateImageFunction.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+// Using-declarations:
+using elx::CoreMainGTestUtilities::CheckNew;
+using elx::GTestUtilities::MakePoint;
+using elx::GTestUtilities::MakeSize;
+using elx::GTestUtilities::MakeVector;
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using ImageType = itk::Image<float, Dimension>;
+using PenaltyTermType = itk::DistancePreservingRigidityPenaltyTerm<ImageType, double>;
+using SegmentedImageType = PenaltyTermType::SegmentedImageType;
+using TransformType = itk::AdvancedBSplineDeformableTransform<double, Dimension, 3>;
+
+
+// Creates a B-spline transform, whose valid region is [-3, 12) in each dimension, with some non-zero parameters.
+TransformType::Pointer
+CreateTransform()
+{
+  const auto transform = TransformType::New();
+  transform->SetGridRegion(TransformType::RegionType(MakeSize(8, 8, 8)));
+  transform->SetGridSpacing(MakeVector(3.0, 3.0, 3.0));
+  transform->SetGridOrigin(MakePoint(-6.0, -6.0, -6.0));
+
+  TransformType::ParametersType parameters(transform->GetNumberOfParameters());
+  for (unsigned int i = 0; i < parameters.size(); ++i)
+  {
+    parameters[i] = 0.3 * std::sin(0.37 * i);
+  }
+  transform->SetParametersByValue(parameters);
+  return transform;
+}
+
+
+// Creates a sampled segmented image (the penalty grid), which extends beyond the valid region of the B-spline grid,
+// so that the B-spline support regions of the grid points near its border are not entirely within the B-spline grid.
+// It has two rigid regions, crossing the lower and the upper border of the penalty grid, a rigid point without
+// neighbours in its region, and a non-rigid region (label 7).
+SegmentedImageType::Pointer
+CreateSampledSegmentedImage()
+{
+  const auto image = SegmentedImageType::New();
+  image->SetRegions(MakeSize(12, 12, 12));
+  image->SetSpacing(MakeVector(1.5, 1.5, 1.5));
+  image->SetOrigin(MakePoint(-4.25, -4.25, -4.25));
+  image->Allocate(true);
+
+  for (itk::ImageRegionIteratorWithIndex<SegmentedImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd();
+       ++it)
+  {
+    const auto index = it.GetIndex();
+    if ((index[0] <= 4) && (index[1] <= 4) && (index[2] <= 3))
+    {
+      it.Set(1);
+    }
+    else if ((index[0] >= 7) && (index[1] >= 6) && (index[2] >= 8))
+    {
+      it.Set(2);
+    }
+    else if ((index[0] == 9) && (index[1] == 1) && (index[2] == 9))
+    {
+      it.Set(3);
+    }
+    else if ((index[0] >= 5) && (index[0] <= 6) && (index[2] <= 2))
+    {
+      it.Set(7);
+    }
+  }
+  return image;
+}
+
+
+// Computes the penalty like the original implementation did: for each penalty grid point in a rigid region (label 1 to
+// 5), the neighbours in its 3x3x3 neighbourhood with the same label are counted, including the point itself. When
+// there are more than one, the penalty of each of these neighbours is added, divided by their number and by the number
+// of rigid penalty grid points. Neighbours outside the penalty grid count as background.
+double
+ComputeReferenceValue(const PenaltyTermType &               penaltyTerm,
+                      TransformType &                       transform,
+                      const SegmentedImageType &            segmentedImage,
+                      const TransformType::ParametersType & parameters)
+{
+  transform.SetParameters(parameters);
+
+  const auto region = segmentedImage.GetBufferedRegion();
+  double     value = 0.0;
+
+  for (itk::ImageRegionConstIteratorWithIndex<SegmentedImageType> it(&segmentedImage, region); !it.IsAtEnd(); ++it)
+  {
+    const auto index = it.GetIndex();
+    const int  label = it.Get();
+    if ((label <= 0) || (label >= 6))
+    {
+      continue;
+    }
+
+    std::vector<itk::Index<Dimension>> neighborIndices;
+    for (int kk = 0; kk < 27; ++kk)
+    {
+      const auto neighborIndex = index + itk::Offset<Dimension>{ { kk % 3 - 1, (kk / 3) % 3 - 1, kk / 9 - 1 } };
+      if (region.IsInside(neighborIndex) && (segmentedImage.GetPixel(neighborIndex) == label))
+      {
+        neighborIndices.push_back(neighborIndex);
+      }
+    }
+
+    if (neighborIndices.size() > 1)
+    {
+      itk::Point<double, Dimension> point;
+      segmentedImage.TransformIndexToPhysicalPoint(index, point);
+      const auto transformedPoint = transform.TransformPoint(point);
+
+      for (const auto & neighborIndex : neighborIndices)
+      {
+        itk::Point<double, Dimension> neighborPoint;
+        segmentedImage.TransformIndexToPhysicalPoint(neighborIndex, neighborPoint);
+
+        const double difference = transform.TransformPoint(neighborPoint).SquaredEuclideanDistanceTo(transformedPoint) -
+                                  neighborPoint.SquaredEuclideanDistanceTo(point);
+        value += difference * difference / static_cast<double>(neighborIndices.size()) /
+                 static_cast<double>(penaltyTerm.GetNumberOfRigidGrids());
+      }
+    }
+  }
+  return value;
+}
+
+} // namespace
+
+
+// Tests the value and the derivative on a penalty grid whose B-spline support regions cross the border of the B-spline
+// grid. The value should be the value of the original implementation, and the derivative should be its gradient, as
+// estimated by central differences. Grid points whose support region is not entirely within the B-spline grid are not
+// displaced by the transform, so their parameters do not affect the penalty.
+GTEST_TEST(DistancePreservingRigidityPenaltyTerm, SameAsReferenceWhenSupportRegionsCrossTheBorder)
+{
+  const auto image = ImageType::New();
+  image->SetRegions(MakeSize(8, 8, 8));
+  image->Allocate(true);
+
+  const auto transform = CreateTransform();
+  const auto segmentedImage = CreateSampledSegmentedImage();
+
+  const auto penaltyTerm = CheckNew<PenaltyTermType>();
+  penaltyTerm->SetFixedImage(image);
+  penaltyTerm->SetMovingImage(image);
+  penaltyTerm->SetFixedImageRegion(image->GetBufferedRegion());
+  penaltyTerm->SetInterpolator(itk::LinearInterpolateImageFunction<ImageType, double>::New());
+  penaltyTerm->SetTransform(transform);
+  penaltyTerm->SetSampledSegmentedImage(segmentedImage);
+  penaltyTerm->SetNumberOfWorkUnits(3);
+  penaltyTerm->SetUseMultiThread(true);
+  penaltyTerm->Initialize();
+
+  const auto parameters = transform->GetParameters();
+
+  const double expectedValue = ComputeReferenceValue(*penaltyTerm, *transform, *segmentedImage, parameters);
+  ASSERT_GT(expectedValue, 0.0);
+  EXPECT_NEAR(penaltyTerm->GetValue(parameters), expectedValue, 1e-10 * expectedValue);
+
+  // The central differences of the reference value.
+  const double                    delta = 1e-5;
+  PenaltyTermType::DerivativeType expectedDerivative(parameters.size());
+  for (unsigned int p = 0; p < parameters.size(); ++p)
+  {
+    auto plusParameters = parameters;
+    auto minusParameters = parameters;
+    plusParameters[p] += delta;
+    minusParameters[p] -= delta;
+    expectedDerivative[p] = (ComputeReferenceValue(*penaltyTerm, *transform, *segmentedImage, plusParameters) -
+                             ComputeReferenceValue(*penaltyTerm, *transform, *segmentedImage, minusParameters)) /
+                            (2.0 * delta);
+  }
+  const double tolerance = 1e-5 * expectedDerivative.inf_norm();
+  ASSERT_GT(tolerance, 0.0);
+
+  // Do the multi-threaded evaluation twice, to check that the per-thread derivatives are properly reset.
+  for (const bool useMultiThread : { false, true, true })
+  {
+    PenaltyTermType::MeasureType    actualValue{};
+    PenaltyTermType::DerivativeType actualDerivative;
+    penaltyTerm->SetUseMultiThread(useMultiThread);
+    penaltyTerm->GetValueAndDerivative(parameters, actualValue, actualDerivative);
+
+    EXPECT_NEAR(actualValue, expectedValue, 1e-10 * expectedValue);
+    ASSERT_EQ(actualDerivative.size(), expectedDerivative.size());
+
+    for (unsigned int p = 0; p < expectedDerivative.size(); ++p)
+    {
+      EXPECT_NEAR(actualDerivative[p], expectedDerivative[p], tolerance);
+    }
+  }
+}
@@ -0,0 +1,250 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkErodeMaskImageFilter.h"
+#include "../Core/Main/GTesting/elxCoreMainGTestUtilities.h"
+
+#include "itkParabolicErodeImageFilter.h"
+
+#include <itkImage.h>
+#include <itkImageRegionIterator.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm> // For equal.
+#include <array>
+#include <random>
+#include <vector>
+
+// Using-declaration:
+using elx::CoreMainGTestUtilities::CheckNew;
+
+namespace
+{
+constexpr unsigned int ImageDimension = 3;
+using MaskImageType = itk::Image<unsigned char, ImageDimension>;
+using FilterType = itk::ErodeMaskImageFilter<MaskImageType>;
+
+
+// Creates a mask of random blocks of the specified inside value, on a background of zero.
+MaskImageType::Pointer
+CreateMaskOfRandomBlocks(const unsigned char insideValue)
+{
+  const auto mask = MaskImageType::New();
+  mask->SetRegions(MaskImageType::SizeType{ { 31, 24, 17 } });
+  mask->Allocate(true);
+
+  std::mt19937 randomNumberEngine;
+
+  for (unsigned int blockNumber = 0; blockNumber < 12; ++blockNumber)
+  {
+    MaskImageType::IndexType index;
+    MaskImageType::SizeType  size;
+    for (unsigned int d = 0; d < ImageDimension; ++d)
+    {
+      const auto imageSize = mask->GetBufferedRegion().GetSize(d);
+      index[d] = static_cast<itk::IndexValueType>(randomNumberEngine() % imageSize);
+      size[d] = 1 + randomNumberEngine() % (imageSize - index[d]);
+    }
+    const MaskImageType::RegionType block{ index, size };
+    for (itk::ImageRegionIterator<MaskImageType> it(mask, block); !it.IsAtEnd(); ++it)
+    {
+      it.Set(insideValue);
+    }
+  }
+
+  /** Add a few holes. */
+  for (unsigned int holeNumber = 0; holeNumber < 20; ++holeNumber)
+  {
+    MaskImageType::IndexType index;
+    for (unsigned int d = 0; d < ImageDimension; ++d)
+    {
+      index[d] = static_cast<itk::IndexValueType>(randomNumberEngine() % mask->GetBufferedRegion().GetSize(d));
+    }
+    mask->SetPixel(index, 0);
+  }
+  return mask;
+}
+
+
+// Erodes the mask directly by the ParabolicErodeImageFilter, in the way ErodeMaskImageFilter has always done.
+MaskImageType::Pointer
+ErodeByParabolicErodeImageFilter(const MaskImageType &            mask,
+                                 const FilterType::ScheduleType & schedule,
+                                 const unsigned int               level,
+                                 const bool                       isMovingMask)
+{
+  using ErodeFilterType = itk::ParabolicErodeImageFilter<MaskImageType, MaskImageType>;
+
+  ErodeFilterType::RadiusType radiusArray;
+  for (unsigned int d = 0; d < ImageDimension; ++d)
+  {
+    const double radius = (isMovingMask ? 2.0 : 1.0) * schedule[level][d] + 1.0;
+    radiusArray[d] = radius * radius / 2.0 + 1.0;
+  }
+
+  const auto erosion = CheckNew<ErodeFilterType>();
+  erosion->SetUseImageSpacing(false);
+  erosion->SetScale(radiusArray);
+  erosion->SetInput(&mask);
+  erosion->Update();
+  return erosion->GetOutput();
+}
+
+
+void
+ExpectSameErosionAsParabolicErodeImageFilter(const MaskImageType & mask)
+{
+  FilterType::ScheduleType schedule(3, ImageDimension);
+  const unsigned int       scheduleValues[3][ImageDimension] = { { 4, 4, 2 }, { 2, 2, 1 }, { 1, 1, 0 } };
+  for (unsigned int level = 0; level < 3; ++level)
+  {
+    for (unsigned int d = 0; d < ImageDimension; ++d)
+    {
+      schedule[level][d] = scheduleValues[level][d];
+    }
+  }
+
+  for (const bool isMovingMask : { false, true })
+  {
+    for (unsigned int level = 0; level < 3; ++level)
+    {
+      const auto filter = CheckNew<FilterType>();
+      filter->SetInput(&mask);
+      filter->SetSchedule(schedule);
+      filter->SetIsMovingMask(isMovingMask);
+      filter->SetResolutionLevel(level);
+      filter->Update();
+
+      const auto & actual = *(filter->GetOutput());
+      const auto   expected = ErodeByParabolicErodeImageFilter(mask, schedule, level, isMovingMask);
+
+      ASSERT_EQ(actual.GetBufferedRegion(), expected->GetBufferedRegion());
+
+      const auto numberOfPixels = actual.GetBufferedRegion().GetNumberOfPixels();
+      EXPECT_TRUE(std::equal(actual.GetBufferPointer(),
+                             actual.GetBufferPointer() + numberOfPixels,
+                             expected->GetBufferPointer()));
+    }
+  }
+}
+
+
+// Expects the same erosions as the ParabolicErodeImageFilter, when one filter is updated for each resolution level,
+// one after the other, like the registration does.
+void
+ExpectSameErosionsByReusedFilter(const MaskImageType & mask, const FilterType::ScheduleType & schedule)
+{
+  for (const bool isMovingMask : { false, true })
+  {
+    const auto filter = CheckNew<FilterType>();
+    filter->SetInput(&mask);
+    filter->SetIsMovingMask(isMovingMask);
+
+    for (unsigned int level = 0; level < schedule.rows(); ++level)
+    {
+      filter->SetSchedule(schedule);
+      filter->SetResolutionLevel(level);
+
+      const MaskImageType::Pointer actual = filter->GetOutput();
+      actual->Update();
+      actual->DisconnectPipeline();
+
+      const auto expected = ErodeByParabolicErodeImageFilter(mask, schedule, level, isMovingMask);
+
+      ASSERT_EQ(actual->GetBufferedRegion(), expected->GetBufferedRegion());
+
+      const auto numberOfPixels = actual->GetBufferedRegion().GetNumberOfPixels();
+      EXPECT_TRUE(std::equal(actual->GetBufferPointer(),
+                             actual->GetBufferPointer() + numberOfPixels,
+                             expected->GetBufferPointer()));
+    }
+  }
+}
+
+
+FilterType::ScheduleType
+CreateSchedule(const std::vector<std::array<unsigned int, ImageDimension>> & scheduleValues)
+{
+  FilterType::ScheduleType schedule(static_cast<unsigned int>(scheduleValues.size()), ImageDimension);
+  for (unsigned int level = 0; level < scheduleValues.size(); ++level)
+  {
+    for (unsigned int d = 0; d < ImageDimension; ++d)
+    {
+      schedule[level][d] = scheduleValues[level][d];
+    }
+  }
+  return schedule;
+}
+
+} // namespace
+
+
+// Tests that a zero-one mask (eroded by a box) is eroded exactly like it was by the ParabolicErodeImageFilter.
+GTEST_TEST(ErodeMaskImageFilter, ZeroOneMaskSameAsParabolicErosion)
+{
+  ExpectSameErosionAsParabolicErodeImageFilter(*CreateMaskOfRandomBlocks(1));
+}
+
+
+// Tests that a mask with other values than zero and one is still eroded by the ParabolicErodeImageFilter.
+GTEST_TEST(ErodeMaskImageFilter, OtherMaskSameAsParabolicErosion)
+{
+  ExpectSameErosionAsParabolicErodeImageFilter(*CreateMaskOfRandomBlocks(255));
+}
+
+
+// Tests that a filter that is reused for all resolution levels (computing the erosions of all levels at once, when
+// the boxes are nested) yields the same erosions as the ParabolicErodeImageFilter.
+GTEST_TEST(ErodeMaskImageFilter, ReusedFilterSameAsParabolicErosion)
+{
+  const auto mask = CreateMaskOfRandomBlocks(1);
+
+  // A common schedule, and a schedule whose boxes are nested, but not ordered from large to small.
+  ExpectSameErosionsByReusedFilter(*mask, CreateSchedule({ { 4, 4, 2 }, { 2, 2, 1 }, { 1, 1, 0 } }));
+  ExpectSameErosionsByReusedFilter(*mask, CreateSchedule({ { 1, 1, 0 }, { 4, 4, 2 }, { 1, 1, 1 }, { 2, 2, 1 } }));
+
+  // A schedule whose boxes are not nested, so that each level is eroded separately.
+  ExpectSameErosionsByReusedFilter(*mask, CreateSchedule({ { 4, 1, 1 }, { 1, 4, 1 }, { 0, 0, 0 } }));
+}
+
+
+// Tests that a reused filter erodes the mask again when the mask is modified.
+GTEST_TEST(ErodeMaskImageFilter, ReusedFilterErodesModifiedMask)
+{
+  const auto mask = CreateMaskOfRandomBlocks(1);
+  const auto schedule = CreateSchedule({ { 2, 2, 1 }, { 1, 1, 0 } });
+
+  const auto filter = CheckNew<FilterType>();
+  filter->SetInput(mask);
+  filter->SetSchedule(schedule);
+  filter->Update();
+
+  mask->FillBuffer(1);
+  mask->Modified();
+  filter->SetResolutionLevel(1);
+  filter->Update();
+
+  const auto & output = *(filter->GetOutput());
+  const auto   expected = ErodeByParabolicErodeImageFilter(*mask, schedule, 1, false);
+  EXPECT_TRUE(std::equal(output.GetBufferPointer(),
+                         output.GetBufferPointer() + output.GetBufferedRegion().GetNumberOfPixels(),
+                         expected->GetBufferPointer()));
+}
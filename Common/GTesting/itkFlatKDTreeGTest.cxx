@@ -0,0 +1,217 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "KNNGraphAlphaMutualInformation/KNN/itkFlatKDTree.h"
+#include "../Core/Main/GTesting/elxCoreMainGTestUtilities.h"
+
+#include "KNNGraphAlphaMutualInformation/KNN/itkANNBruteForceTree.h"
+#include "KNNGraphAlphaMutualInformation/KNN/itkANNStandardTreeSearch.h"
+#include "KNNGraphAlphaMutualInformation/KNN/itkListSampleCArray.h"
+#include <itkArray.h>
+#include <itkMultiThreaderBase.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// Using-declarations:
+using elx::CoreMainGTestUtilities::CheckNew;
+
+namespace
+{
+using MeasurementVectorType = itk::Array<double>;
+using ListSampleType = itk::Statistics::ListSampleCArray<MeasurementVectorType, double>;
+using FlatKDTreeType = itk::FlatKDTree<ListSampleType>;
+using BruteForceTreeType = itk::ANNBruteForceTree<ListSampleType>;
+using BruteForceTreeSearchType = itk::ANNStandardTreeSearch<ListSampleType>;
+
+
+// Creates a list sample of the specified number of points, of which the coordinates are uniformly distributed
+// in [0, 1).
+ListSampleType::Pointer
+CreateRandomListSample(const unsigned int numberOfPoints, const unsigned int dimension, std::mt19937 & randomEngine)
+{
+  std::uniform_real_distribution<double> distribution(0.0, 1.0);
+
+  const auto listSample = ListSampleType::New();
+  listSample->SetMeasurementVectorSize(dimension);
+  listSample->Resize(numberOfPoints);
+  for (unsigned int i = 0; i < numberOfPoints; ++i)
+  {
+    for (unsigned int d = 0; d < dimension; ++d)
+    {
+      listSample->SetMeasurement(i, d, distribution(randomEngine));
+    }
+  }
+  listSample->SetActualSize(numberOfPoints);
+  return listSample;
+}
+
+
+// Creates a flat kd-tree of the list sample, built by the specified threader (if any).
+FlatKDTreeType::Pointer
+CreateFlatKDTree(ListSampleType & listSample, const unsigned int bucketSize, itk::MultiThreaderBase * const threader)
+{
+  const auto tree = CheckNew<FlatKDTreeType>();
+  tree->SetBucketSize(bucketSize);
+  tree->SetThreader(threader);
+  tree->SetSample(&listSample);
+  tree->GenerateTree();
+  return tree;
+}
+
+} // namespace
+
+
+// Tests that the flat kd-tree finds the same k nearest neighbours as the ANN brute force tree, for the points of the
+// sample itself, as the KNN metric does, and for other random query points. For several dimensions, bucket sizes and
+// numbers of neighbours, with and without a threader to build the tree.
+GTEST_TEST(FlatKDTree, SameNeighborsAsBruteForceTree)
+{
+  const unsigned int numberOfPoints = 200;
+  const unsigned int numberOfQueryPoints = 50;
+
+  std::mt19937 randomEngine;
+
+  const auto threader = itk::MultiThreaderBase::New();
+  threader->SetNumberOfWorkUnits(3);
+
+  for (const unsigned int dimension : { 1, 2, 3, 5 })
+  {
+    const auto listSample = CreateRandomListSample(numberOfPoints, dimension, randomEngine);
+    const auto queryListSample = CreateRandomListSample(numberOfQueryPoints, dimension, randomEngine);
+
+    const auto bruteForceTree = BruteForceTreeType::New();
+    bruteForceTree->SetSample(listSample);
+    bruteForceTree->GenerateTree();
+
+    for (const unsigned int bucketSize : { 1, 3, 8, 250 })
+    {
+      for (itk::MultiThreaderBase * const treeThreader : { static_cast<itk::MultiThreaderBase *>(nullptr),
+                                                           threader.GetPointer() })
+      {
+        const auto tree = CreateFlatKDTree(*listSample, bucketSize, treeThreader);
+
+        for (const unsigned int k : { 1, 4, 10 })
+        {
+          const auto bruteForceSearcher = BruteForceTreeSearchType::New();
+          bruteForceSearcher->SetKNearestNeighbors(k);
+          bruteForceSearcher->SetBinaryTree(bruteForceTree);
+
+          std::vector<int>    indices(k);
+          std::vector<double> distances(k);
+
+          for (const ListSampleType * const queries : { listSample.GetPointer(), queryListSample.GetPointer() })
+          {
+            for (unsigned int q = 0; q < queries->Size(); ++q)
+            {
+              MeasurementVectorType                       queryPoint;
+              BruteForceTreeSearchType::IndexArrayType    expectedIndices;
+              BruteForceTreeSearchType::DistanceArrayType expectedDistances;
+              queries->GetMeasurementVector(q, queryPoint);
+              bruteForceSearcher->Search(queryPoint, expectedIndices, expectedDistances);
+
+              tree->Search(queries->GetInternalContainer()[q], k, 0.0, indices.data(), distances.data());
+
+              for (unsigned int i = 0; i < k; ++i)
+              {
+                EXPECT_EQ(indices[i], expectedIndices[i]);
+                EXPECT_NEAR(distances[i], expectedDistances[i], 1e-12);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+
+// Tests that when k exceeds the number of points, all points are found, sorted by increasing distance, and that the
+// remaining neighbours get index -1. Unless self matches are allowed, the points of the sample do not find themselves.
+GTEST_TEST(FlatKDTree, KGreaterThanNumberOfPoints)
+{
+  const unsigned int numberOfPoints = 5;
+  const unsigned int k = 8;
+
+  std::mt19937 randomEngine;
+
+  for (const unsigned int dimension : { 1, 3 })
+  {
+    const auto listSample = CreateRandomListSample(numberOfPoints, dimension, randomEngine);
+    const auto queryListSample = CreateRandomListSample(3, dimension, randomEngine);
+
+    for (const unsigned int bucketSize : { 1, 2, 8 })
+    {
+      const auto tree = CreateFlatKDTree(*listSample, bucketSize, nullptr);
+
+      for (const ListSampleType * const queries : { listSample.GetPointer(), queryListSample.GetPointer() })
+      {
+        for (unsigned int q = 0; q < queries->Size(); ++q)
+        {
+          const double * const queryPoint = queries->GetInternalContainer()[q];
+
+          // The expected neighbours: all points, except the query point itself, sorted by distance.
+          std::vector<double> expectedDistances(numberOfPoints);
+          for (unsigned int p = 0; p < numberOfPoints; ++p)
+          {
+            const double * const point = listSample->GetInternalContainer()[p];
+            expectedDistances[p] = 0.0;
+            for (unsigned int d = 0; d < dimension; ++d)
+            {
+              expectedDistances[p] += (queryPoint[d] - point[d]) * (queryPoint[d] - point[d]);
+            }
+          }
+          std::vector<int> expectedIndices(numberOfPoints);
+          std::iota(expectedIndices.begin(), expectedIndices.end(), 0);
+          expectedIndices.erase(std::remove_if(expectedIndices.begin(),
+                                               expectedIndices.end(),
+                                               [&expectedDistances](const int p) {
+                                                 return !ANN_ALLOW_SELF_MATCH && (expectedDistances[p] == 0.0);
+                                               }),
+                                expectedIndices.end());
+          std::sort(expectedIndices.begin(), expectedIndices.end(), [&expectedDistances](const int a, const int b) {
+            return expectedDistances[a] < expectedDistances[b];
+          });
+          ASSERT_GE(expectedIndices.size(), numberOfPoints - 1);
+
+          std::vector<int>    indices(k);
+          std::vector<double> distances(k);
+          tree->Search(queryPoint, k, 0.0, indices.data(), distances.data());
+
+          for (unsigned int i = 0; i < k; ++i)
+          {
+            if (i < expectedIndices.size())
+            {
+              EXPECT_EQ(indices[i], expectedIndices[i]);
+              EXPECT_EQ(distances[i], expectedDistances[expectedIndices[i]]);
+            }
+            else
+            {
+              EXPECT_EQ(indices[i], -1);
+            }
+          }
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,128 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkFlattenedTransform.h"
+#include "elxGTestUtilities.h"
+#include "../Core/Main/GTesting/elxCoreMainGTestUtilities.h"
+
+#include "itkAdvancedRigid2DTransform.h"
+#include <itkImage.h>
+
+#include <gtest/gtest.h>
+
+// Using-declarations:
+using elx::CoreMainGTestUtilities::CheckNew;
+using elx::GTestUtilities::MakePoint;
+using elx::GTestUtilities::MakeVector;
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+using ScalarType = double;
+using FlattenedTransformType = itk::FlattenedTransform<ScalarType, Dimension>;
+using GridImageType = itk::Image<char, Dimension>;
+
+
+itk::AdvancedRigid2DTransform<ScalarType>::Pointer
+MakeRigidTransform()
+{
+  const auto transform = itk::AdvancedRigid2DTransform<ScalarType>::New();
+  transform->SetAngle(0.3);
+  transform->SetTranslation(MakeVector(1.0, -2.0));
+  return transform;
+}
+
+
+GridImageType::Pointer
+MakeGrid()
+{
+  const auto grid = GridImageType::New();
+  grid->SetRegions(itk::Size<Dimension>{ { 11, 8 } });
+  grid->SetOrigin(MakePoint(-2.0, -3.0));
+  grid->SetSpacing(MakeVector(0.5, 0.75));
+  return grid;
+}
+
+} // namespace
+
+
+// Tests that a flattened linear transform yields the same points as the original transform, both inside the domain of
+// the grid (where linear interpolation of a linear transform is exact) and outside (where the original is evaluated).
+GTEST_TEST(FlattenedTransform, SameTransformPointInsideAndOutsideGrid)
+{
+  const auto rigidTransform = MakeRigidTransform();
+  const auto grid = MakeGrid();
+
+  for (const unsigned int gridSpacingFactor : { 1U, 2U, 3U })
+  {
+    const auto field = FlattenedTransformType::SampleDisplacementField(*rigidTransform, *grid, gridSpacingFactor);
+    const auto flattenedTransform = CheckNew<FlattenedTransformType>();
+    flattenedTransform->SetDisplacementField(*field);
+    flattenedTransform->SetFallbackTransform(rigidTransform);
+
+    // The coarsened grid still covers the whole grid domain, including its last voxel.
+    const auto fieldSize = field->GetLargestPossibleRegion().GetSize();
+    for (unsigned int i = 0; i < Dimension; ++i)
+    {
+      EXPECT_GE((fieldSize[i] - 3) * gridSpacingFactor, grid->GetLargestPossibleRegion().GetSize(i) - 1);
+    }
+
+    // Points inside the grid domain, including its corners.
+    for (const double x : { -2.0, -1.3, 0.0, 1.7, 3.0 })
+    {
+      for (const double y : { -3.0, -0.4, 1.1, 2.25 })
+      {
+        const auto point = MakePoint(x, y);
+        const auto expectedPoint = rigidTransform->TransformPoint(point);
+        const auto actualPoint = flattenedTransform->TransformPoint(point);
+        for (unsigned int i = 0; i < Dimension; ++i)
+        {
+          EXPECT_NEAR(actualPoint[i], expectedPoint[i], 1e-10);
+        }
+      }
+    }
+
+    // Points far outside the grid domain.
+    for (const auto point : { MakePoint(-100.0, 0.0), MakePoint(0.0, 50.0), MakePoint(20.0, -30.0) })
+    {
+      EXPECT_EQ(flattenedTransform->TransformPoint(point), rigidTransform->TransformPoint(point));
+
+      FlattenedTransformType::SpatialJacobianType expectedSpatialJacobian;
+      FlattenedTransformType::SpatialJacobianType actualSpatialJacobian;
+      rigidTransform->GetSpatialJacobian(point, expectedSpatialJacobian);
+      flattenedTransform->GetSpatialJacobian(point, actualSpatialJacobian);
+      EXPECT_EQ(actualSpatialJacobian, expectedSpatialJacobian);
+    }
+  }
+}
+
+
+// Tests that without a fallback transform, points outside the grid are not displaced, like in the B-spline transform.
+GTEST_TEST(FlattenedTransform, IdentityOutsideGridWithoutFallbackTransform)
+{
+  const auto rigidTransform = MakeRigidTransform();
+  const auto field = FlattenedTransformType::SampleDisplacementField(*rigidTransform, *MakeGrid(), 2);
+
+  const auto flattenedTransform = CheckNew<FlattenedTransformType>();
+  flattenedTransform->SetDisplacementField(*field);
+
+  const auto point = MakePoint(-100.0, 0.0);
+  EXPECT_EQ(flattenedTransform->TransformPoint(point), point);
+}
@@ -0,0 +1,380 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "GradientDifference/itkGradientDifferenceImageToImageMetric2.h"
+#include "elxGTestUtilities.h"
+#include "../Core/Main/GTesting/elxCoreMainGTestUtilities.h"
+
+#include "itkAdvancedEuler3DTransform.h"
+#include "itkAdvancedRayCastInterpolateImageFunction.h"
+#include "itkImageFullSampler.h"
+#include <itkCastImageFilter.h>
+#include <itkImage.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkNeighborhoodOperatorImageFilter.h>
+#include <itkResampleImageFilter.h>
+#include <itkSobelOperator.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm> // For copy and max_element.
+#include <array>
+#include <cmath>
+#include <numeric> // For accumulate.
+#include <vector>
+
+// Using-declarations:
+using elx::CoreMainGTestUtilities::CheckNew;
+using elx::GTestUtilities::MakePoint;
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using ImageType = itk::Image<float, Dimension>;
+using MetricType = itk::GradientDifferenceImageToImageMetric<ImageType, ImageType>;
+using TransformType = itk::AdvancedEuler3DTransform<double>;
+using InterpolatorType = itk::AdvancedRayCastInterpolateImageFunction<ImageType, double>;
+using ParametersType = MetricType::TransformParametersType;
+
+
+// Gradient difference metric, of which the use of the image sampler can be switched on.
+class SampleBasedGradientDifferenceMetric : public MetricType
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(SampleBasedGradientDifferenceMetric);
+  using Self = SampleBasedGradientDifferenceMetric;
+  using Superclass = MetricType;
+  using Pointer = itk::SmartPointer<Self>;
+  itkNewMacro(Self);
+
+  using Superclass::SetUseImageSampler;
+
+protected:
+  SampleBasedGradientDifferenceMetric() = default;
+  ~SampleBasedGradientDifferenceMetric() override = default;
+};
+
+
+// Creates a small volume around the origin, having a smoothly varying (positive) intensity.
+ImageType::Pointer
+CreateVolume()
+{
+  const auto image = ImageType::New();
+  image->SetRegions(itk::Size<Dimension>{ { 12, 10, 8 } });
+  image->SetOrigin(MakePoint(-5.5, -4.5, -3.5));
+  image->Allocate();
+
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const auto index = it.GetIndex();
+    it.Set(static_cast<float>(2.0 + std::sin(0.7 * index[0] + 0.3 * index[2]) + std::cos(0.5 * index[1])));
+  }
+  return image;
+}
+
+
+// Projects the volume onto the grid of the specified (2D) image, by the ray-cast interpolator.
+ImageType::Pointer
+Project(const ImageType &  volume,
+        const ImageType &  gridImage,
+        TransformType &    transform,
+        InterpolatorType & interpolator)
+{
+  const auto resampler = CheckNew<itk::ResampleImageFilter<ImageType, ImageType>>();
+  resampler->SetInput(&volume);
+  resampler->SetTransform(&transform);
+  resampler->SetInterpolator(&interpolator);
+  resampler->SetDefaultPixelValue(0);
+  resampler->SetSize(gridImage.GetLargestPossibleRegion().GetSize());
+  resampler->SetOutputOrigin(gridImage.GetOrigin());
+  resampler->SetOutputSpacing(gridImage.GetSpacing());
+  resampler->SetOutputDirection(gridImage.GetDirection());
+  resampler->Update();
+  return resampler->GetOutput();
+}
+
+
+// Creates a 2D projection image (a 3D image with a single slice) of the volume, for the specified parameters.
+ImageType::Pointer
+CreateProjection(const ImageType & volume, const ParametersType & parameters)
+{
+  const auto transform = TransformType::New();
+  transform->SetParameters(parameters);
+
+  const auto interpolator = InterpolatorType::New();
+  interpolator->SetTransform(transform);
+  interpolator->SetFocalPoint(MakePoint(0.0, 0.0, -50.0));
+  interpolator->SetInputImage(&volume);
+
+  const auto gridImage = ImageType::New();
+  gridImage->SetRegions(itk::Size<Dimension>{ { 24, 20, 1 } });
+  gridImage->SetOrigin(MakePoint(-11.5, -9.5, 30.0));
+
+  return Project(volume, *gridImage, *transform, *interpolator);
+}
+
+
+// Computes the Sobel gradients of the image, in each direction, with a zero flux Neumann boundary condition.
+std::array<std::vector<double>, Dimension>
+ComputeSobelGradients(const ImageType & image)
+{
+  using RealImageType = itk::Image<double, Dimension>;
+
+  const auto caster = CheckNew<itk::CastImageFilter<ImageType, RealImageType>>();
+  caster->SetInput(&image);
+
+  std::array<std::vector<double>, Dimension> gradients;
+  for (unsigned int d = 0; d < Dimension; ++d)
+  {
+    itk::SobelOperator<double, Dimension> sobelOperator;
+    sobelOperator.SetDirection(d);
+    sobelOperator.CreateDirectional();
+
+    const auto sobelFilter = CheckNew<itk::NeighborhoodOperatorImageFilter<RealImageType, RealImageType>>();
+    sobelFilter->SetOperator(sobelOperator);
+    sobelFilter->SetInput(caster->GetOutput());
+    sobelFilter->Update();
+
+    const RealImageType & output = *(sobelFilter->GetOutput());
+    gradients[d].assign(output.GetBufferPointer(),
+                        output.GetBufferPointer() + output.GetBufferedRegion().GetNumberOfPixels());
+  }
+  return gradients;
+}
+
+
+// Computes the (positive, not rescaled) gradient difference measure for all pixels of the fixed image, the way the
+// metric has always done it.
+double
+ComputeExpectedMeasure(const ImageType &      fixedImage,
+                       const ImageType &      movingImage,
+                       TransformType &        transform,
+                       InterpolatorType &     interpolator,
+                       const ParametersType & parameters)
+{
+  transform.SetParameters(parameters);
+  const auto fixedGradients = ComputeSobelGradients(fixedImage);
+  const auto movedGradients = ComputeSobelGradients(*Project(movingImage, fixedImage, transform, interpolator));
+
+  double measure = 0.0;
+  for (unsigned int d = 0; d < Dimension; ++d)
+  {
+    const auto   numberOfPixels = static_cast<double>(fixedGradients[d].size());
+    const double mean = std::accumulate(fixedGradients[d].cbegin(), fixedGradients[d].cend(), 0.0) / numberOfPixels;
+
+    double variance = 0.0;
+    for (const double gradient : fixedGradients[d])
+    {
+      variance += (gradient - mean) * (gradient - mean);
+    }
+    variance /= numberOfPixels;
+
+    if (variance == 0.0)
+    {
+      continue;
+    }
+
+    // The maximum fixed gradient is at least zero.
+    const double maxFixedGradient =
+      std::max(0.0, *std::max_element(fixedGradients[d].cbegin(), fixedGradients[d].cend()));
+    const double maxMovedGradient = *std::max_element(movedGradients[d].cbegin(), movedGradients[d].cend());
+    const double subtractionFactor = maxFixedGradient / maxMovedGradient;
+
+    for (std::size_t i = 0; i < fixedGradients[d].size(); ++i)
+    {
+      const double diff = fixedGradients[d][i] - subtractionFactor * movedGradients[d][i];
+      measure += variance / (variance + diff * diff);
+    }
+  }
+  return measure;
+}
+
+
+// Creates and initializes a gradient difference metric. When an image sampler is specified, the metric uses it.
+MetricType::Pointer
+CreateMetric(const ImageType &                    fixedImage,
+             const ImageType &                    movingImage,
+             TransformType &                      transform,
+             InterpolatorType &                   interpolator,
+             MetricType::ImageSamplerType * const imageSampler,
+             const ParametersType &               initialParameters)
+{
+  transform.SetParameters(initialParameters);
+
+  const auto metric = CheckNew<SampleBasedGradientDifferenceMetric>();
+  metric->SetFixedImage(&fixedImage);
+  metric->SetMovingImage(&movingImage);
+  metric->SetFixedImageRegion(fixedImage.GetBufferedRegion());
+  metric->SetTransform(&transform);
+  metric->SetInterpolator(&interpolator);
+  metric->SetScales(MetricType::ScalesType(transform.GetNumberOfParameters(), 1.0));
+  metric->SetUseImageSampler(imageSampler != nullptr);
+  metric->SetImageSampler(imageSampler);
+  metric->Initialize();
+  return metric;
+}
+
+
+// Returns the interpolator for the metric, which casts rays through the specified transform.
+InterpolatorType::Pointer
+CreateInterpolator(TransformType & transform)
+{
+  const auto interpolator = CheckNew<InterpolatorType>();
+  interpolator->SetTransform(&transform);
+  interpolator->SetFocalPoint(MakePoint(0.0, 0.0, -50.0));
+  return interpolator;
+}
+
+
+// Creates parameters of the rigid transform: three angles and a translation.
+ParametersType
+CreateParameters(const std::array<double, 6> & values)
+{
+  ParametersType parameters(6);
+  std::copy(values.cbegin(), values.cend(), parameters.begin());
+  return parameters;
+}
+
+
+// Returns the parameters of the transform, for which the fixed image is the projection of the moving image.
+ParametersType
+CreateFixedImageParameters()
+{
+  return CreateParameters({ { 0.02, -0.03, 0.05, 0.5, -0.3, 0.2 } });
+}
+
+
+// Returns the parameters for which the metric is tested. The first ones are also used to initialize the metric.
+std::vector<ParametersType>
+CreateParametersToTest()
+{
+  std::vector<ParametersType> parametersToTest;
+  for (const double factor : { 0.0, 0.5, -1.0 })
+  {
+    parametersToTest.push_back(CreateParameters({ { factor * 0.01,
+                                                    factor * -0.02,
+                                                    factor * 0.03,
+                                                    factor * 0.3,
+                                                    factor * -0.2,
+                                                    factor * 0.4 } }));
+  }
+  return parametersToTest;
+}
+
+} // namespace
+
+
+// Tests that the value and the derivative are those of the gradient difference measure of all fixed image pixels, as
+// computed from the Sobel gradients of the fixed image and the whole projection of the moving image, and the central
+// differences of this measure.
+GTEST_TEST(GradientDifferenceImageToImageMetric, ValueAndDerivativeSameAsForWholeProjection)
+{
+  const auto movingImage = CreateVolume();
+  const auto fixedImage = CreateProjection(*movingImage, CreateFixedImageParameters());
+
+  const auto transform = TransformType::New();
+  const auto interpolator = CreateInterpolator(*transform);
+  const auto initialParameters = CreateParametersToTest().front();
+  const auto metric = CreateMetric(*fixedImage, *movingImage, *transform, *interpolator, nullptr, initialParameters);
+
+  // The metric rescales the measure by a power of ten, determined by its initial value.
+  const double initialMeasure =
+    ComputeExpectedMeasure(*fixedImage, *movingImage, *transform, *interpolator, initialParameters);
+  double rescalingFactor = 1.0;
+  while (initialMeasure / rescalingFactor > 1.0)
+  {
+    rescalingFactor *= 10.0;
+  }
+
+  const auto computeExpectedValue = [&](const ParametersType & parameters) {
+    return -ComputeExpectedMeasure(*fixedImage, *movingImage, *transform, *interpolator, parameters) / rescalingFactor;
+  };
+
+  for (const auto & parameters : CreateParametersToTest())
+  {
+    MetricType::MeasureType    value{};
+    MetricType::DerivativeType derivative;
+    metric->GetValueAndDerivative(parameters, value, derivative);
+
+    const double expectedValue = computeExpectedValue(parameters);
+    EXPECT_LT(expectedValue, 0.0);
+    EXPECT_NEAR(value, expectedValue, 1e-12 * std::abs(expectedValue));
+    EXPECT_NEAR(metric->GetValue(parameters), expectedValue, 1e-12 * std::abs(expectedValue));
+    ASSERT_EQ(derivative.size(), parameters.size());
+
+    const double delta = metric->GetDerivativeDelta();
+    const double tolerance = 1e-9 * derivative.inf_norm();
+    ASSERT_GT(tolerance, 0.0);
+
+    for (unsigned int p = 0; p < parameters.size(); ++p)
+    {
+      auto plusParameters = parameters;
+      auto minusParameters = parameters;
+      plusParameters[p] += delta;
+      minusParameters[p] -= delta;
+
+      const double centralDifference =
+        (computeExpectedValue(plusParameters) - computeExpectedValue(minusParameters)) / (2.0 * delta);
+      EXPECT_NEAR(derivative[p], centralDifference, tolerance);
+    }
+  }
+}
+
+
+// Tests that the value and the derivative, when the metric uses a full image sampler, and only computes the moved
+// gradients at the samples, are the same as when it projects the moving image onto the whole fixed image grid.
+GTEST_TEST(GradientDifferenceImageToImageMetric, SameValueAndDerivativeWithFullImageSampler)
+{
+  const auto movingImage = CreateVolume();
+  const auto fixedImage = CreateProjection(*movingImage, CreateFixedImageParameters());
+
+  const auto transform = TransformType::New();
+  const auto interpolator = CreateInterpolator(*transform);
+  const auto initialParameters = CreateParametersToTest().front();
+  const auto expectedMetric =
+    CreateMetric(*fixedImage, *movingImage, *transform, *interpolator, nullptr, initialParameters);
+
+  const auto sampledTransform = TransformType::New();
+  const auto sampledInterpolator = CreateInterpolator(*sampledTransform);
+  const auto imageSampler = CheckNew<itk::ImageFullSampler<ImageType>>();
+  const auto actualMetric =
+    CreateMetric(*fixedImage, *movingImage, *sampledTransform, *sampledInterpolator, imageSampler, initialParameters);
+
+  for (const auto & parameters : CreateParametersToTest())
+  {
+    MetricType::MeasureType    expectedValue{};
+    MetricType::DerivativeType expectedDerivative;
+    expectedMetric->GetValueAndDerivative(parameters, expectedValue, expectedDerivative);
+
+    MetricType::MeasureType    actualValue{};
+    MetricType::DerivativeType actualDerivative;
+    actualMetric->GetValueAndDerivative(parameters, actualValue, actualDerivative);
+
+    EXPECT_NEAR(actualValue, expectedValue, 1e-9 * std::abs(expectedValue));
+    ASSERT_EQ(actualDerivative.size(), expectedDerivative.size());
+
+    const double tolerance = 1e-6 * expectedDerivative.inf_norm();
+    ASSERT_GT(tolerance, 0.0);
+
+    for (unsigned int p = 0; p < expectedDerivative.size(); ++p)
+    {
+      EXPECT_NEAR(actualDerivative[p], expectedDerivative[p], tolerance);
+    }
+  }
+}
@@ -0,0 +1,219 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// The groupwise metrics to be tested:
+#include "PCAMetric2/itkPCAMetric2.h"
+#include "SumOfPairwiseCorrelationsMetric/itkSumOfPairwiseCorrelationCoefficientsMetric.h"
+#include "VarianceOverLastDimension/itkVarianceOverLastDimensionImageMetric.h"
+
+#include "elxGTestUtilities.h"
+#include "../Core/Main/GTesting/elxCoreMainGTestUtilities.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkImageFullSampler.h"
+#include "itkStackTransform.h"
+#include <itkBSplineInterpolateImageFunction.h>
+#include <itkImage.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+// Using-declarations:
+using elx::CoreMainGTestUtilities::CheckNew;
+using elx::GTestUtilities::MakePoint;
+using elx::GTestUtilities::MakeVector;
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using ImageType = itk::Image<float, Dimension>;
+using TransformType = itk::AdvancedBSplineDeformableTransform<double, Dimension, 3>;
+using AdvancedTransformType = itk::AdvancedTransform<double, Dimension, Dimension>;
+using StackTransformType = itk::StackTransform<double, Dimension, Dimension>;
+using SubTransformType = itk::AdvancedBSplineDeformableTransform<double, Dimension - 1, 3>;
+
+
+// Creates a small 2D+t image, whose intensity profiles vary (not just linearly) over the last dimension.
+ImageType::Pointer
+CreateImage()
+{
+  const auto image = ImageType::New();
+  image->SetRegions(itk::Size<Dimension>{ { 8, 7, 4 } });
+  image->Allocate();
+
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const auto index = it.GetIndex();
+    it.Set(static_cast<float>(10.0 * std::sin(0.7 * index[0] + 0.4 * index[2]) +
+                              5.0 * std::cos(0.5 * index[1] - 0.3 * index[0] * index[2]) + 2.0 * index[2]));
+  }
+  return image;
+}
+
+
+// Creates a B-spline transform whose support covers the image, with some non-zero parameters.
+TransformType::Pointer
+CreateTransform()
+{
+  const auto transform = TransformType::New();
+  transform->SetGridRegion(TransformType::RegionType(itk::Size<Dimension>{ { 9, 9, 9 } }));
+  transform->SetGridSpacing(MakeVector(2.0, 2.0, 1.0));
+  transform->SetGridOrigin(MakePoint(-5.0, -5.0, -3.0));
+
+  TransformType::ParametersType parameters(transform->GetNumberOfParameters());
+  for (unsigned int i = 0; i < parameters.size(); ++i)
+  {
+    parameters[i] = 0.2 * std::sin(0.37 * i);
+  }
+  transform->SetParametersByValue(parameters);
+  return transform;
+}
+
+
+// Creates a stack transform with a B-spline sub transform for each of the 4 slices of the image, with some non-zero
+// parameters.
+StackTransformType::Pointer
+CreateStackTransform()
+{
+  const auto subTransform = SubTransformType::New();
+  subTransform->SetGridRegion(SubTransformType::RegionType(itk::Size<Dimension - 1>{ { 9, 9 } }));
+  subTransform->SetGridSpacing(MakeVector(2.0, 2.0));
+  subTransform->SetGridOrigin(MakePoint(-5.0, -5.0));
+
+  const auto transform = StackTransformType::New();
+  transform->SetNumberOfSubTransforms(4);
+  transform->SetStackOrigin(0.0);
+  transform->SetStackSpacing(1.0);
+  transform->SetAllSubTransforms(subTransform);
+
+  StackTransformType::ParametersType parameters(transform->GetNumberOfParameters());
+  for (unsigned int i = 0; i < parameters.size(); ++i)
+  {
+    parameters[i] = 0.2 * std::sin(0.37 * i);
+  }
+  transform->SetParameters(parameters);
+  return transform;
+}
+
+
+// Expects that the multi-threaded GetValueAndDerivative of the specified metric yields the same value and derivative
+// as the single-threaded implementation. With a stack transform, the multi-threaded derivative is assembled per stack
+// slice.
+template <typename TMetric>
+void
+ExpectSameValueAndDerivativeWhenMultiThreaded(const bool subtractMean, const bool useStackTransform = false)
+{
+  const auto image = CreateImage();
+  const auto bsplineTransform = CreateTransform();
+  const auto stackTransform = CreateStackTransform();
+  AdvancedTransformType * const transform = useStackTransform
+                                              ? static_cast<AdvancedTransformType *>(stackTransform.GetPointer())
+                                              : static_cast<AdvancedTransformType *>(bsplineTransform.GetPointer());
+
+  const auto metric = CheckNew<TMetric>();
+  metric->SetFixedImage(image);
+  metric->SetMovingImage(image);
+  metric->SetFixedImageRegion(image->GetBufferedRegion());
+  metric->SetTransform(transform);
+  metric->SetInterpolator(itk::BSplineInterpolateImageFunction<ImageType, double, double>::New());
+  metric->SetImageSampler(itk::ImageFullSampler<ImageType>::New());
+  metric->SetSubtractMean(subtractMean);
+  metric->SetGridSize(bsplineTransform->GetGridRegion().GetSize());
+  metric->SetTransformIsStackTransform(useStackTransform);
+  metric->SetPartitionSamplesByStackSlice(useStackTransform);
+  metric->SetNumberOfWorkUnits(3);
+  metric->Initialize();
+
+  const auto parameters = transform->GetParameters();
+
+  typename TMetric::MeasureType    expectedValue{};
+  typename TMetric::DerivativeType expectedDerivative;
+  metric->SetUseMultiThread(false);
+  metric->GetValueAndDerivative(parameters, expectedValue, expectedDerivative);
+
+  // Do it twice, to check that the per-thread variables are properly reset.
+  for (int i = 0; i < 2; ++i)
+  {
+    typename TMetric::MeasureType    actualValue{};
+    typename TMetric::DerivativeType actualDerivative;
+    metric->SetUseMultiThread(true);
+    metric->GetValueAndDerivative(parameters, actualValue, actualDerivative);
+
+    EXPECT_NEAR(actualValue, expectedValue, 1e-6 * std::abs(expectedValue));
+    ASSERT_EQ(actualDerivative.size(), expectedDerivative.size());
+
+    const double tolerance = 1e-6 * expectedDerivative.inf_norm();
+    ASSERT_GT(tolerance, 0.0);
+    for (unsigned int p = 0; p < expectedDerivative.size(); ++p)
+    {
+      EXPECT_NEAR(actualDerivative[p], expectedDerivative[p], tolerance);
+    }
+  }
+}
+
+} // namespace
+
+
+GTEST_TEST(PCAMetric2, SameValueAndDerivativeWhenMultiThreaded)
+{
+  for (const bool subtractMean : { false, true })
+  {
+    ExpectSameValueAndDerivativeWhenMultiThreaded<itk::PCAMetric2<ImageType, ImageType>>(subtractMean);
+  }
+}
+
+
+GTEST_TEST(SumOfPairwiseCorrelationCoefficientsMetric, SameValueAndDerivativeWhenMultiThreaded)
+{
+  for (const bool subtractMean : { false, true })
+  {
+    ExpectSameValueAndDerivativeWhenMultiThreaded<
+      itk::SumOfPairwiseCorrelationCoefficientsMetric<ImageType, ImageType>>(subtractMean);
+  }
+}
+
+
+GTEST_TEST(VarianceOverLastDimensionImageMetric, SameValueAndDerivativeWhenMultiThreaded)
+{
+  for (const bool subtractMean : { false, true })
+  {
+    ExpectSameValueAndDerivativeWhenMultiThreaded<itk::VarianceOverLastDimensionImageMetric<ImageType, ImageType>>(
+      subtractMean);
+  }
+}
+
+
+GTEST_TEST(PCAMetric2, SameValueAndDerivativeWhenPartitionedByStackSlice)
+{
+  for (const bool subtractMean : { false, true })
+  {
+    ExpectSameValueAndDerivativeWhenMultiThreaded<itk::PCAMetric2<ImageType, ImageType>>(subtractMean, true);
+  }
+}
+
+
+GTEST_TEST(VarianceOverLastDimensionImageMetric, SameValueAndDerivativeWhenPartitionedByStackSlice)
+{
+  for (const bool subtractMean : { false, true })
+  {
+    ExpectSameValueAndDerivativeWhenMultiThreaded<itk::VarianceOverLastDimensionImageMetric<ImageType, ImageType>>(
+      subtractMean, true);
+  }
+}
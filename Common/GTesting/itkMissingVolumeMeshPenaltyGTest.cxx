@@ -0,0 +1,262 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "MissingStructurePenalty/itkMissingStructurePenalty.h"
+#include "elxGTestUtilities.h"
+#include "../Core/Main/GTesting/elxCoreMainGTestUtilities.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include <itkLineCell.h>
+#include <itkMath.h>
+#include <itkPointSet.h>
+#include <itkTriangleCell.h>
+#include <vnl/algo/vnl_determinant.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+// Using-declarations:
+using elx::CoreMainGTestUtilities::CheckNew;
+using elx::GTestUtilities::MakePoint;
+
+namespace
+{
+
+template <unsigned int VDimension>
+using PenaltyType = itk::MissingVolumeMeshPenalty<itk::PointSet<double, VDimension>, itk::PointSet<double, VDimension>>;
+
+template <unsigned int VDimension>
+using TransformType = itk::AdvancedBSplineDeformableTransform<double, VDimension, 3>;
+
+template <unsigned int VDimension>
+using FaceType = std::array<unsigned int, VDimension>;
+
+
+// Creates a B-spline transform, whose valid region is [-3, 3) in each dimension, with some small non-zero parameters.
+template <unsigned int VDimension>
+typename TransformType<VDimension>::Pointer
+CreateTransform()
+{
+  const auto transform = TransformType<VDimension>::New();
+  transform->SetGridRegion(typename TransformType<VDimension>::RegionType(itk::Size<VDimension>::Filled(7)));
+
+  typename TransformType<VDimension>::SpacingType gridSpacing;
+  gridSpacing.Fill(1.5);
+  transform->SetGridSpacing(gridSpacing);
+
+  typename TransformType<VDimension>::OriginType gridOrigin;
+  gridOrigin.Fill(-4.5);
+  transform->SetGridOrigin(gridOrigin);
+
+  typename TransformType<VDimension>::ParametersType parameters(transform->GetNumberOfParameters());
+  for (unsigned int i = 0; i < parameters.size(); ++i)
+  {
+    parameters[i] = 0.05 * std::sin(0.37 * i);
+  }
+  transform->SetParametersByValue(parameters);
+  return transform;
+}
+
+
+// Computes the signed volume (the determinant) of a face, relative to the origin.
+double
+ComputeSignedVolume(const std::array<itk::Point<double, 2>, 2> & corners)
+{
+  return vnl_determinant(corners[0].GetDataPointer(), corners[1].GetDataPointer());
+}
+
+double
+ComputeSignedVolume(const std::array<itk::Point<double, 3>, 3> & corners)
+{
+  return vnl_determinant(corners[0].GetDataPointer(), corners[1].GetDataPointer(), corners[2].GetDataPointer());
+}
+
+
+// Computes the expected value for a closed mesh whose faces are consistently oriented, and which is star-shaped with
+// respect to the centroid of its (transformed) points: the absolute value of the sum of the signed volumes of the
+// transformed faces, which is the same for any reference point. That is 2 times the area in 2D, and 6 times the volume
+// in 3D.
+template <unsigned int VDimension>
+double
+ComputeExpectedValue(const std::vector<itk::Point<double, VDimension>> & points,
+                     const std::vector<FaceType<VDimension>> &          faces,
+                     const TransformType<VDimension> &                  transform)
+{
+  double sumOfSignedVolumes = 0.0;
+  for (const auto & face : faces)
+  {
+    std::array<itk::Point<double, VDimension>, VDimension> corners;
+    for (unsigned int corner = 0; corner < VDimension; ++corner)
+    {
+      corners[corner] = transform.TransformPoint(points[face[corner]]);
+    }
+    sumOfSignedVolumes += ComputeSignedVolume(corners);
+  }
+  return std::abs(sumOfSignedVolumes);
+}
+
+
+// Creates a penalty for the mesh of the specified points and faces (lines in 2D, triangles in 3D).
+template <unsigned int VDimension>
+typename PenaltyType<VDimension>::Pointer
+CreatePenalty(const std::vector<itk::Point<double, VDimension>> & points,
+              const std::vector<FaceType<VDimension>> &          faces,
+              TransformType<VDimension> &                        transform,
+              const bool                                         useMultiThread)
+{
+  using FixedMeshType = typename PenaltyType<VDimension>::FixedMeshType;
+  using CellInterfaceType = typename PenaltyType<VDimension>::CellInterfaceType;
+  using FaceCellType = typename std::
+    conditional<VDimension == 2, itk::LineCell<CellInterfaceType>, itk::TriangleCell<CellInterfaceType>>::type;
+
+  const auto mesh = FixedMeshType::New();
+  for (unsigned int i = 0; i < points.size(); ++i)
+  {
+    mesh->SetPoint(i, points[i]);
+  }
+  for (unsigned int i = 0; i < faces.size(); ++i)
+  {
+    typename CellInterfaceType::CellAutoPointer cell;
+    cell.TakeOwnership(new FaceCellType);
+    for (unsigned int corner = 0; corner < VDimension; ++corner)
+    {
+      cell->SetPointId(corner, faces[i][corner]);
+    }
+    mesh->SetCell(i, cell);
+  }
+
+  const auto meshContainer = PenaltyType<VDimension>::FixedMeshContainerType::New();
+  meshContainer->Reserve(1);
+  meshContainer->SetElement(0, mesh.GetPointer());
+
+  const auto penalty = CheckNew<PenaltyType<VDimension>>();
+  penalty->SetFixedMeshContainer(meshContainer);
+  penalty->SetTransform(&transform);
+  penalty->SetNumberOfWorkUnits(3);
+  penalty->SetUseMultiThread(useMultiThread);
+  penalty->Initialize();
+  return penalty;
+}
+
+
+// Expects that the value is the area (2D) or volume (3D) of the transformed mesh, up to a constant factor, and that
+// the derivative is its gradient, as estimated by central differences, both single- and multi-threaded.
+template <unsigned int VDimension>
+void
+ExpectValueAndDerivative(const std::vector<itk::Point<double, VDimension>> & points,
+                         const std::vector<FaceType<VDimension>> &          faces)
+{
+  const auto   transform = CreateTransform<VDimension>();
+  const auto   parameters = transform->GetParameters();
+  const double expectedValue = ComputeExpectedValue(points, faces, *transform);
+  ASSERT_GT(expectedValue, 0.0);
+
+  for (const bool useMultiThread : { false, true })
+  {
+    const auto penalty = CreatePenalty(points, faces, *transform, useMultiThread);
+
+    // Do it twice, to check that the per-thread variables are properly reset.
+    for (int i = 0; i < 2; ++i)
+    {
+      typename PenaltyType<VDimension>::MeasureType    value{};
+      typename PenaltyType<VDimension>::DerivativeType derivative;
+      penalty->GetValueAndDerivative(parameters, value, derivative);
+
+      EXPECT_NEAR(value, expectedValue, 1e-10 * expectedValue);
+      EXPECT_NEAR(penalty->GetValue(parameters), expectedValue, 1e-10 * expectedValue);
+      ASSERT_EQ(derivative.size(), parameters.size());
+
+      const double tolerance = 1e-6 * derivative.inf_norm();
+      ASSERT_GT(tolerance, 0.0);
+
+      const double delta = 1e-5;
+      for (unsigned int p = 0; p < parameters.size(); ++p)
+      {
+        auto plusParameters = parameters;
+        auto minusParameters = parameters;
+        plusParameters[p] += delta;
+        minusParameters[p] -= delta;
+
+        const double finiteDifference =
+          (penalty->GetValue(plusParameters) - penalty->GetValue(minusParameters)) / (2.0 * delta);
+        EXPECT_NEAR(derivative[p], finiteDifference, tolerance);
+      }
+    }
+  }
+}
+
+} // namespace
+
+
+// Tests a closed polygon, of which the vertices are on a perturbed circle, around the origin.
+GTEST_TEST(MissingVolumeMeshPenalty, ValueAndDerivativeOfClosedPolygon)
+{
+  constexpr unsigned int numberOfPoints = 7;
+
+  std::vector<itk::Point<double, 2>> points;
+  std::vector<FaceType<2>>           faces;
+  for (unsigned int i = 0; i < numberOfPoints; ++i)
+  {
+    const double angle = 2.0 * itk::Math::pi * i / numberOfPoints;
+    const double radius = 1.5 + 0.1 * std::sin(3.0 * angle);
+    points.push_back(MakePoint(radius * std::cos(angle), radius * std::sin(angle)));
+    faces.push_back({ { i, (i + 1) % numberOfPoints } });
+  }
+  ExpectValueAndDerivative(points, faces);
+}
+
+
+// Tests a closed triangle mesh of an octahedron, of which the vertices are slightly perturbed, and of which the faces
+// are all oriented outward.
+GTEST_TEST(MissingVolumeMeshPenalty, ValueAndDerivativeOfClosedTriangleMesh)
+{
+  // The vertices at the positive and negative x, y and z axes.
+  const std::vector<itk::Point<double, 3>> points{ MakePoint(1.6, 0.1, -0.05), MakePoint(-1.5, -0.05, 0.1),
+                                                   MakePoint(0.05, 1.4, 0.1),  MakePoint(0.1, -1.5, -0.05),
+                                                   MakePoint(-0.1, 0.05, 1.5), MakePoint(0.05, -0.1, -1.4) };
+
+  std::vector<FaceType<3>> faces;
+  for (unsigned int xSide = 0; xSide < 2; ++xSide)
+  {
+    for (unsigned int ySide = 0; ySide < 2; ++ySide)
+    {
+      for (unsigned int zSide = 0; zSide < 2; ++zSide)
+      {
+        const unsigned int x = xSide;
+        const unsigned int y = 2 + ySide;
+        const unsigned int z = 4 + zSide;
+
+        // The face (x, y, z) is oriented outward when an even number of its vertices is at a negative axis.
+        if ((xSide + ySide + zSide) % 2 == 0)
+        {
+          faces.push_back({ { x, y, z } });
+        }
+        else
+        {
+          faces.push_back({ { x, z, y } });
+        }
+      }
+    }
+  }
+  ExpectValueAndDerivative(points, faces);
+}
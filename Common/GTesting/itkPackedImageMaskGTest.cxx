@@ -0,0 +1,169 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkPackedImageMask.h"
+#include "../Core/Main/GTesting/elxCoreMainGTestUtilities.h"
+
+#include <itkEllipseSpatialObject.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+// Using-declaration:
+using elx::CoreMainGTestUtilities::CheckNew;
+
+namespace
+{
+constexpr unsigned int ImageDimension = 3;
+using PackedMaskType = itk::PackedImageMask<ImageDimension>;
+using SpatialObjectType = PackedMaskType::ImageMaskSpatialObjectType;
+using MaskImageType = PackedMaskType::MaskImageType;
+
+
+// Creates a mask image with an oblique geometry, and a few random blocks of non-zero voxels.
+MaskImageType::Pointer
+CreateMaskImage()
+{
+  const auto maskImage = MaskImageType::New();
+  maskImage->SetRegions(MaskImageType::RegionType({ { -2, 3, 1 } }, { { 23, 19, 11 } }));
+  maskImage->Allocate(true);
+
+  MaskImageType::SpacingType spacing;
+  spacing[0] = 0.7;
+  spacing[1] = 1.3;
+  spacing[2] = 2.1;
+  maskImage->SetSpacing(spacing);
+
+  MaskImageType::PointType origin;
+  origin[0] = -5.5;
+  origin[1] = 10.25;
+  origin[2] = 3.0;
+  maskImage->SetOrigin(origin);
+
+  MaskImageType::DirectionType direction;
+  direction.SetIdentity();
+  direction[0][0] = direction[1][1] = std::cos(0.3);
+  direction[0][1] = -std::sin(0.3);
+  direction[1][0] = std::sin(0.3);
+  maskImage->SetDirection(direction);
+
+  std::mt19937 randomNumberEngine;
+
+  for (itk::ImageRegionIteratorWithIndex<MaskImageType> it(maskImage, maskImage->GetBufferedRegion()); !it.IsAtEnd();
+       ++it)
+  {
+    const auto & index = it.GetIndex();
+    if ((index[0] > 2) && (index[0] < 17) && (index[1] > 5) && (index[1] < 20) && (randomNumberEngine() % 5 != 0))
+    {
+      it.Set(static_cast<MaskImageType::PixelType>(1 + randomNumberEngine() % 3));
+    }
+  }
+  return maskImage;
+}
+
+
+SpatialObjectType::Pointer
+CreateSpatialObject(const MaskImageType & maskImage)
+{
+  const auto spatialObject = SpatialObjectType::New();
+  spatialObject->SetImage(&maskImage);
+  spatialObject->Update();
+  return spatialObject;
+}
+
+} // namespace
+
+
+// Tests that IsInside yields the same results as ImageMaskSpatialObject::IsInsideInWorldSpace.
+GTEST_TEST(PackedImageMask, IsInsideSameAsImageMaskSpatialObject)
+{
+  const auto maskImage = CreateMaskImage();
+  const auto spatialObject = CreateSpatialObject(*maskImage);
+  const auto packedMask = PackedMaskType::CreateFromSpatialObject(spatialObject);
+
+  ASSERT_NE(packedMask, nullptr);
+  EXPECT_TRUE(packedMask->IsCreatedFrom(spatialObject));
+  EXPECT_GT(packedMask->GetNumberOfInsideVoxels(), 0U);
+
+  // Check each voxel position.
+  for (itk::ImageRegionIteratorWithIndex<MaskImageType> it(maskImage, maskImage->GetBufferedRegion()); !it.IsAtEnd();
+       ++it)
+  {
+    MaskImageType::PointType point;
+    maskImage->TransformIndexToPhysicalPoint(it.GetIndex(), point);
+    EXPECT_EQ(packedMask->IsInside(point), spatialObject->IsInsideInWorldSpace(point));
+    EXPECT_EQ(packedMask->IsInside(it.GetIndex()), it.Get() != 0);
+  }
+
+  // Check random positions, in and around the image.
+  std::mt19937                           randomNumberEngine;
+  std::uniform_real_distribution<double> distribution(-40.0, 60.0);
+
+  for (unsigned int i = 0; i < 100000; ++i)
+  {
+    MaskImageType::PointType point;
+    for (auto & coordinate : point)
+    {
+      coordinate = distribution(randomNumberEngine);
+    }
+    EXPECT_EQ(packedMask->IsInside(point), spatialObject->IsInsideInWorldSpace(point));
+  }
+}
+
+
+// Tests that a packed mask is only created from an image mask, and that it notices modification of the mask.
+GTEST_TEST(PackedImageMask, CreateFromSpatialObject)
+{
+  const auto ellipse = CheckNew<itk::EllipseSpatialObject<ImageDimension>>();
+  EXPECT_EQ(PackedMaskType::CreateFromSpatialObject(nullptr), nullptr);
+  EXPECT_EQ(PackedMaskType::CreateFromSpatialObject(ellipse), nullptr);
+
+  const auto maskImage = CreateMaskImage();
+  const auto spatialObject = CreateSpatialObject(*maskImage);
+  const auto packedMask = PackedMaskType::CreateFromSpatialObject(spatialObject);
+
+  ASSERT_NE(packedMask, nullptr);
+  EXPECT_FALSE(packedMask->IsCreatedFrom(ellipse));
+  EXPECT_TRUE(packedMask->IsCreatedFrom(spatialObject));
+  maskImage->Modified();
+  EXPECT_FALSE(packedMask->IsCreatedFrom(spatialObject));
+}
+
+
+// Tests that nothing is inside a packed mask of an image that is entirely zero.
+GTEST_TEST(PackedImageMask, ZeroImage)
+{
+  const auto maskImage = MaskImageType::New();
+  maskImage->SetRegions(MaskImageType::SizeType{ { 4, 5, 6 } });
+  maskImage->Allocate(true);
+
+  const auto packedMask = PackedMaskType::CreateFromSpatialObject(CreateSpatialObject(*maskImage));
+
+  ASSERT_NE(packedMask, nullptr);
+  EXPECT_EQ(packedMask->GetNumberOfInsideVoxels(), 0U);
+
+  for (itk::ImageRegionIteratorWithIndex<MaskImageType> it(maskImage, maskImage->GetBufferedRegion()); !it.IsAtEnd();
+       ++it)
+  {
+    EXPECT_FALSE(packedMask->IsInside(it.GetIndex()));
+  }
+}
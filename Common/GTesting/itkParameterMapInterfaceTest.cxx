@@ -138,3 +138,66 @@ GTEST_TEST(ParameterMapInterface, HasParameter)
 
   EXPECT_FALSE(parameterMapInterface->HasParameter("This-is-not-a-key-from-this-map-" + parameterName));
 }
+
+
+GTEST_TEST(ParameterMapInterface, ReadParameterYieldsSameValuesWhenCalledRepeatedly)
+{
+  const auto        parameterMapInterface = ParameterMapInterface::New();
+  const std::string parameterName("Key");
+
+  // Enough values to have them converted in parallel.
+  constexpr unsigned int                     numberOfValues = 10000;
+  ParameterMapInterface::ParameterValuesType strings;
+  std::vector<double>                        expectedValues;
+
+  for (unsigned int i = 0; i < numberOfValues; ++i)
+  {
+    expectedValues.push_back(0.125 * i - 100.0);
+    strings.push_back(itk::NumberToString<double>{}(expectedValues.back()));
+  }
+  parameterMapInterface->SetParameterMap({ { parameterName, strings } });
+
+  for (int i = 0; i < 2; ++i)
+  {
+    std::string         errorMessage;
+    std::vector<double> values(numberOfValues);
+    EXPECT_TRUE(parameterMapInterface->ReadParameter(values, parameterName, 0, numberOfValues - 1, true, errorMessage));
+    EXPECT_EQ(values, expectedValues);
+
+    double value{};
+    EXPECT_TRUE(parameterMapInterface->ReadParameter(value, parameterName, 42, errorMessage));
+    EXPECT_EQ(value, expectedValues[42]);
+
+    const auto retrievedValues = parameterMapInterface->RetrieveValues<double>(parameterName);
+    ASSERT_NE(retrievedValues, nullptr);
+    EXPECT_EQ(*retrievedValues, expectedValues);
+  }
+
+  // Setting another parameter map must not yield values from the previous one.
+  parameterMapInterface->SetParameterMap({ { parameterName, { "1", "2" } } });
+  const auto retrievedValues = parameterMapInterface->RetrieveValues<int>(parameterName);
+  ASSERT_NE(retrievedValues, nullptr);
+  EXPECT_EQ(*retrievedValues, std::vector<int>({ 1, 2 }));
+
+  std::string errorMessage;
+  double      value{};
+  EXPECT_TRUE(parameterMapInterface->ReadParameter(value, parameterName, 1, errorMessage));
+  EXPECT_EQ(value, 2.0);
+}
+
+
+GTEST_TEST(ParameterMapInterface, ReadParameterOnlyThrowsWhenRequestedEntryCannotBeConverted)
+{
+  const auto        parameterMapInterface = ParameterMapInterface::New();
+  const std::string parameterName("Key");
+  parameterMapInterface->SetParameterMap({ { parameterName, { "1.5", "not-a-number" } } });
+
+  for (int i = 0; i < 2; ++i)
+  {
+    std::string errorMessage;
+    double      value{};
+    EXPECT_TRUE(parameterMapInterface->ReadParameter(value, parameterName, 0, errorMessage));
+    EXPECT_EQ(value, 1.5);
+    EXPECT_THROW(parameterMapInterface->ReadParameter(value, parameterName, 1, errorMessage), itk::ExceptionObject);
+  }
+}
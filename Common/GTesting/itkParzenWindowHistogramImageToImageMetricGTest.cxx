@@ -0,0 +1,451 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "itkParzenWindowHistogramImageToImageMetric.h"
+#include "../Core/Main/GTesting/elxCoreMainGTestUtilities.h"
+
+#include "AdvancedMattesMutualInformation/itkParzenWindowMutualInformationImageToImageMetric.h"
+#include "NormalizedMutualInformation/itkParzenWindowNormalizedMutualInformationImageToImageMetric.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkExponentialLimiterFunction.h"
+#include "itkHardLimiterFunction.h"
+#include "itkImageFullSampler.h"
+#include <itkImage.h>
+#include <itkImageRegionIterator.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkLinearInterpolateImageFunction.h>
+#include <itkNearestNeighborInterpolateImageFunction.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Using-declarations:
+using elx::CoreMainGTestUtilities::CheckNew;
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+using ImageType = itk::Image<float, Dimension>;
+using MutualInformationType = itk::ParzenWindowMutualInformationImageToImageMetric<ImageType, ImageType>;
+using NormalizedMutualInformationType =
+  itk::ParzenWindowNormalizedMutualInformationImageToImageMetric<ImageType, ImageType>;
+using HistogramMetricType = itk::ParzenWindowHistogramImageToImageMetric<ImageType, ImageType>;
+using ImageSamplerType = HistogramMetricType::ImageSamplerType;
+using InterpolatorType = HistogramMetricType::InterpolatorType;
+using RealType = HistogramMetricType::RealType;
+using TransformType = itk::AdvancedBSplineDeformableTransform<double, Dimension, 3>;
+
+
+// Creates a 24x24 image, of which the pixel values are a smooth function of the index, scaled by the specified factors.
+ImageType::Pointer
+CreateImage(const double factor0, const double factor1)
+{
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 24, 24 } });
+  image->Allocate();
+
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const auto index = it.GetIndex();
+    it.Set(static_cast<float>(10.0 * std::sin(factor0 * index[0]) * std::cos(factor1 * index[1]) + 0.5 * index[0]));
+  }
+  return image;
+}
+
+
+// Creates a B-spline transform, whose valid region is [-4, 24) in each dimension, with all parameters zero.
+TransformType::Pointer
+CreateTransform()
+{
+  const auto transform = TransformType::New();
+  transform->SetGridRegion(TransformType::RegionType(TransformType::RegionType::SizeType{ { 10, 10 } }));
+
+  TransformType::SpacingType gridSpacing;
+  gridSpacing.Fill(4.0);
+  transform->SetGridSpacing(gridSpacing);
+
+  TransformType::OriginType gridOrigin;
+  gridOrigin.Fill(-8.0);
+  transform->SetGridOrigin(gridOrigin);
+
+  transform->SetParametersByValue(TransformType::ParametersType(transform->GetNumberOfParameters(), 0.0));
+  return transform;
+}
+
+
+// Creates parameters for the transform, scaled by the specified factor.
+TransformType::ParametersType
+CreateParameters(const TransformType & transform, const double factor)
+{
+  TransformType::ParametersType parameters(transform.GetNumberOfParameters());
+  for (unsigned int i = 0; i < parameters.size(); ++i)
+  {
+    parameters[i] = factor * std::sin(0.37 * i);
+  }
+  return parameters;
+}
+
+
+// Mutual information metric, which provides access to the joint histogram, as computed by ComputePDFs.
+class JointHistogramMetric : public MutualInformationType
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(JointHistogramMetric);
+  using Self = JointHistogramMetric;
+  using Superclass = MutualInformationType;
+  using Pointer = itk::SmartPointer<Self>;
+  itkNewMacro(Self);
+
+  // Computes the (unnormalized) joint histogram for the specified parameters, and returns a copy of its bins.
+  std::vector<double>
+  ComputeJointHistogram(const ParametersType & parameters) const
+  {
+    this->ComputePDFs(parameters);
+    const JointPDFType & jointPDF = *(this->m_JointPDF);
+    return std::vector<double>(jointPDF.GetBufferPointer(),
+                               jointPDF.GetBufferPointer() + jointPDF.GetBufferedRegion().GetNumberOfPixels());
+  }
+
+protected:
+  JointHistogramMetric() = default;
+  ~JointHistogramMetric() override = default;
+};
+
+
+// Creates and initializes a histogram-based metric.
+template <typename TMetric>
+typename TMetric::Pointer
+CreateMetric(const ImageType &  fixedImage,
+             const ImageType &  movingImage,
+             TransformType &    transform,
+             ImageSamplerType & imageSampler,
+             InterpolatorType & interpolator,
+             const bool         useExplicitPDFDerivatives,
+             const bool         useMultiThread)
+{
+  const auto metric = CheckNew<TMetric>();
+  metric->SetFixedImage(&fixedImage);
+  metric->SetMovingImage(&movingImage);
+  metric->SetFixedImageRegion(fixedImage.GetBufferedRegion());
+  metric->SetTransform(&transform);
+  metric->SetImageSampler(&imageSampler);
+  metric->SetInterpolator(&interpolator);
+  metric->SetFixedImageLimiter(itk::HardLimiterFunction<RealType, Dimension>::New());
+  metric->SetMovingImageLimiter(itk::ExponentialLimiterFunction<RealType, Dimension>::New());
+  metric->SetNumberOfFixedHistogramBins(32);
+  metric->SetNumberOfMovingHistogramBins(32);
+  metric->SetUseExplicitPDFDerivatives(useExplicitPDFDerivatives);
+  metric->SetNumberOfWorkUnits(3);
+  metric->SetUseMultiThread(useMultiThread);
+  metric->Initialize();
+  return metric;
+}
+
+
+// Expects that both value and derivative of the actual metric are equal to those of the expected metric.
+void
+ExpectSameValueAndDerivative(const HistogramMetricType &                 actualMetric,
+                             const HistogramMetricType &                 expectedMetric,
+                             const HistogramMetricType::ParametersType & parameters)
+{
+  HistogramMetricType::MeasureType    actualValue{};
+  HistogramMetricType::DerivativeType actualDerivative;
+  actualMetric.GetValueAndDerivative(parameters, actualValue, actualDerivative);
+
+  HistogramMetricType::MeasureType    expectedValue{};
+  HistogramMetricType::DerivativeType expectedDerivative;
+  expectedMetric.GetValueAndDerivative(parameters, expectedValue, expectedDerivative);
+
+  EXPECT_NEAR(actualValue, expectedValue, 1e-12 * std::abs(expectedValue));
+  ASSERT_EQ(actualDerivative.size(), expectedDerivative.size());
+
+  const double tolerance = 1e-12 * expectedDerivative.inf_norm();
+  ASSERT_GT(tolerance, 0.0);
+
+  for (unsigned int p = 0; p < expectedDerivative.size(); ++p)
+  {
+    EXPECT_NEAR(actualDerivative[p], expectedDerivative[p], tolerance);
+  }
+}
+
+} // namespace
+
+
+// Tests that mutual information and normalized mutual information have the same value and derivative, when the
+// normalized mutual information reuses the joint histogram of the mutual information, as when both compute their own
+// joint histogram. For several transform parameters, with both the explicit and the low memory PDF derivatives, both
+// single- and multi-threaded.
+GTEST_TEST(ParzenWindowHistogramImageToImageMetric, SharedJointHistogramYieldsSameValueAndDerivative)
+{
+  const auto fixedImage = CreateImage(0.3, 0.25);
+  const auto movingImage = CreateImage(0.27, 0.29);
+  const auto transform = CreateTransform();
+  const auto interpolator = itk::LinearInterpolateImageFunction<ImageType, double>::New();
+
+  // The transform keeps a pointer to the parameters that are passed, so they must outlive the evaluations.
+  const std::vector<TransformType::ParametersType> parametersPerEvaluation{ CreateParameters(*transform, 0.0),
+                                                                            CreateParameters(*transform, 0.5),
+                                                                            CreateParameters(*transform, -0.3) };
+
+  for (const bool useExplicitPDFDerivatives : { false, true })
+  {
+    for (const bool useMultiThread : { false, true })
+    {
+      const auto sharedImageSampler = itk::ImageFullSampler<ImageType>::New();
+      const auto mutualInformation = CreateMetric<MutualInformationType>(*fixedImage,
+                                                                         *movingImage,
+                                                                         *transform,
+                                                                         *sharedImageSampler,
+                                                                         *interpolator,
+                                                                         useExplicitPDFDerivatives,
+                                                                         useMultiThread);
+      const auto sharingNormalizedMutualInformation =
+        CreateMetric<NormalizedMutualInformationType>(*fixedImage,
+                                                      *movingImage,
+                                                      *transform,
+                                                      *sharedImageSampler,
+                                                      *interpolator,
+                                                      useExplicitPDFDerivatives,
+                                                      useMultiThread);
+      mutualInformation->SetShareJointPDF(true);
+      sharingNormalizedMutualInformation->SetJointPDFSource(mutualInformation);
+
+      const auto unsharedMutualInformation =
+        CreateMetric<MutualInformationType>(*fixedImage,
+                                            *movingImage,
+                                            *transform,
+                                            *itk::ImageFullSampler<ImageType>::New(),
+                                            *interpolator,
+                                            useExplicitPDFDerivatives,
+                                            useMultiThread);
+      const auto unsharedNormalizedMutualInformation =
+        CreateMetric<NormalizedMutualInformationType>(*fixedImage,
+                                                      *movingImage,
+                                                      *transform,
+                                                      *itk::ImageFullSampler<ImageType>::New(),
+                                                      *interpolator,
+                                                      useExplicitPDFDerivatives,
+                                                      useMultiThread);
+
+      for (const auto & parameters : parametersPerEvaluation)
+      {
+        // The source is evaluated first, like in a combination metric.
+        ExpectSameValueAndDerivative(*mutualInformation, *unsharedMutualInformation, parameters);
+        ExpectSameValueAndDerivative(
+          *sharingNormalizedMutualInformation, *unsharedNormalizedMutualInformation, parameters);
+      }
+    }
+  }
+}
+
+
+// Tests that the joint histogram of the source is only reused when the source shares it, and when both metrics have
+// the same image sampler and the same interpolator. The source uses a nearest neighbor interpolator. After the source
+// is evaluated, the moving image is modified in place, which only affects the value of a metric that does not reuse
+// the joint histogram of the source.
+GTEST_TEST(ParzenWindowHistogramImageToImageMetric, ReusesJointHistogramOnlyWithSameImageSamplerAndInterpolator)
+{
+  const auto fixedImage = CreateImage(0.3, 0.25);
+  const auto movingImage = CreateImage(0.27, 0.29);
+  const auto transform = CreateTransform();
+  const auto parameters = CreateParameters(*transform, 0.5);
+
+  const auto linearInterpolator = itk::LinearInterpolateImageFunction<ImageType, double>::New();
+  const auto nearestNeighborInterpolator = itk::NearestNeighborInterpolateImageFunction<ImageType, double>::New();
+  const auto imageSampler = itk::ImageFullSampler<ImageType>::New();
+  const auto otherImageSampler = itk::ImageFullSampler<ImageType>::New();
+
+  const auto source = CreateMetric<MutualInformationType>(
+    *fixedImage, *movingImage, *transform, *imageSampler, *nearestNeighborInterpolator, false, true);
+
+  const auto createNormalizedMutualInformation = [&](ImageSamplerType & sampler, InterpolatorType & interpolator) {
+    return CreateMetric<NormalizedMutualInformationType>(
+      *fixedImage, *movingImage, *transform, sampler, interpolator, false, true);
+  };
+
+  const auto sharingMetric = createNormalizedMutualInformation(*imageSampler, *nearestNeighborInterpolator);
+  sharingMetric->SetJointPDFSource(source);
+  const auto sharingMetricWithOtherInterpolator = createNormalizedMutualInformation(*imageSampler, *linearInterpolator);
+  sharingMetricWithOtherInterpolator->SetJointPDFSource(source);
+  const auto sharingMetricWithOtherSampler =
+    createNormalizedMutualInformation(*otherImageSampler, *nearestNeighborInterpolator);
+  sharingMetricWithOtherSampler->SetJointPDFSource(source);
+
+  // The metrics that compute their own joint histogram are all initialized before the moving image is modified, so
+  // that they have the same histogram bins as the source.
+  const auto linearMetric = createNormalizedMutualInformation(*otherImageSampler, *linearInterpolator);
+  const auto nearestNeighborMetric =
+    createNormalizedMutualInformation(*otherImageSampler, *nearestNeighborInterpolator);
+
+  const double originalValue = nearestNeighborMetric->GetValue(parameters);
+
+  source->SetShareJointPDF(true);
+  source->GetValue(parameters);
+
+  // Modify the moving image in place, after the source has computed its joint histogram.
+  for (itk::ImageRegionIterator<ImageType> it(movingImage, movingImage->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    it.Set(0.5f * it.Get() + 1.0f);
+  }
+  movingImage->Modified();
+
+  const double modifiedLinearValue = linearMetric->GetValue(parameters);
+  const double modifiedNearestNeighborValue = nearestNeighborMetric->GetValue(parameters);
+  ASSERT_GT(std::abs(modifiedNearestNeighborValue - originalValue), 1e-6);
+  ASSERT_GT(std::abs(modifiedLinearValue - originalValue), 1e-6);
+
+  // Reused when the source shares its joint histogram, and the image sampler and the interpolator are the same.
+  EXPECT_NEAR(sharingMetric->GetValue(parameters), originalValue, 1e-12 * std::abs(originalValue));
+
+  // Not reused when the interpolator or the image sampler is different.
+  EXPECT_NEAR(sharingMetricWithOtherInterpolator->GetValue(parameters),
+              modifiedLinearValue,
+              1e-12 * std::abs(modifiedLinearValue));
+  EXPECT_NEAR(sharingMetricWithOtherSampler->GetValue(parameters),
+              modifiedNearestNeighborValue,
+              1e-12 * std::abs(modifiedNearestNeighborValue));
+
+  // Not reused when the source has stopped sharing its joint histogram, for example in a later resolution.
+  source->SetShareJointPDF(false);
+  source->GetValue(parameters);
+  EXPECT_NEAR(sharingMetric->GetValue(parameters),
+              modifiedNearestNeighborValue,
+              1e-12 * std::abs(modifiedNearestNeighborValue));
+}
+
+
+// Tests that the normalized mutual information yields the same value and derivative with the fast and low memory
+// version (GetValueAndAnalyticDerivativeLowMemory, which uses ComputePRatioArray), as with the explicit joint
+// histogram derivatives, for several transform parameters, both single- and multi-threaded.
+GTEST_TEST(ParzenWindowHistogramImageToImageMetric, NormalizedMutualInformationLowMemorySameAsExplicitPDFDerivatives)
+{
+  const auto fixedImage = CreateImage(0.3, 0.25);
+  const auto movingImage = CreateImage(0.27, 0.29);
+  const auto transform = CreateTransform();
+  const auto interpolator = itk::LinearInterpolateImageFunction<ImageType, double>::New();
+
+  // The transform keeps a pointer to the parameters that are passed, so they must outlive the evaluations.
+  const std::vector<TransformType::ParametersType> parametersPerEvaluation{ CreateParameters(*transform, 0.0),
+                                                                            CreateParameters(*transform, 0.5),
+                                                                            CreateParameters(*transform, -0.3) };
+
+  for (const bool useMultiThread : { false, true })
+  {
+    const auto createNormalizedMutualInformation = [&](const bool useExplicitPDFDerivatives) {
+      return CreateMetric<NormalizedMutualInformationType>(*fixedImage,
+                                                           *movingImage,
+                                                           *transform,
+                                                           *itk::ImageFullSampler<ImageType>::New(),
+                                                           *interpolator,
+                                                           useExplicitPDFDerivatives,
+                                                           useMultiThread);
+    };
+    const auto lowMemoryMetric = createNormalizedMutualInformation(false);
+    const auto explicitMetric = createNormalizedMutualInformation(true);
+
+    for (const auto & parameters : parametersPerEvaluation)
+    {
+      HistogramMetricType::MeasureType    lowMemoryValue{};
+      HistogramMetricType::DerivativeType lowMemoryDerivative;
+      lowMemoryMetric->GetValueAndDerivative(parameters, lowMemoryValue, lowMemoryDerivative);
+
+      HistogramMetricType::MeasureType    explicitValue{};
+      HistogramMetricType::DerivativeType explicitDerivative;
+      explicitMetric->GetValueAndDerivative(parameters, explicitValue, explicitDerivative);
+
+      EXPECT_NEAR(lowMemoryValue, explicitValue, 1e-12 * std::abs(explicitValue));
+      ASSERT_EQ(lowMemoryDerivative.size(), explicitDerivative.size());
+
+      const double tolerance = 1e-9 * explicitDerivative.inf_norm();
+      ASSERT_GT(tolerance, 0.0);
+
+      for (unsigned int p = 0; p < explicitDerivative.size(); ++p)
+      {
+        EXPECT_NEAR(lowMemoryDerivative[p], explicitDerivative[p], tolerance);
+      }
+    }
+  }
+}
+
+
+// Tests that the multi-threaded joint histogram, accumulated from the bins touched by the threads, equals the joint
+// histogram that is computed single-threadedly, over several iterations. One of the iterations maps most samples
+// outside the moving image, so that it throws an exception after the per-thread joint histograms are filled.
+GTEST_TEST(ParzenWindowHistogramImageToImageMetric, MultiThreadedJointHistogramEqualsSingleThreaded)
+{
+  const auto fixedImage = CreateImage(0.3, 0.25);
+  const auto movingImage = CreateImage(0.27, 0.29);
+  const auto transform = CreateTransform();
+  const auto interpolator = itk::LinearInterpolateImageFunction<ImageType, double>::New();
+
+  // A translation of 20 in the first dimension, which leaves only 4 of the 24 columns of samples inside the moving
+  // image, which is less than the required ratio of valid samples.
+  auto translationParameters = CreateParameters(*transform, 0.0);
+  for (unsigned int i = 0; i < translationParameters.size() / Dimension; ++i)
+  {
+    translationParameters[i] = 20.0;
+  }
+
+  // The transform keeps a pointer to the parameters that are passed, so they must outlive the evaluations.
+  const std::vector<TransformType::ParametersType> parametersPerEvaluation{ CreateParameters(*transform, 0.0),
+                                                                            CreateParameters(*transform, 0.5),
+                                                                            translationParameters,
+                                                                            CreateParameters(*transform, -0.3),
+                                                                            CreateParameters(*transform, 0.5) };
+
+  const auto singleThreadedMetric = CreateMetric<JointHistogramMetric>(*fixedImage,
+                                                                       *movingImage,
+                                                                       *transform,
+                                                                       *itk::ImageFullSampler<ImageType>::New(),
+                                                                       *interpolator,
+                                                                       false,
+                                                                       false);
+  const auto multiThreadedMetric = CreateMetric<JointHistogramMetric>(*fixedImage,
+                                                                      *movingImage,
+                                                                      *transform,
+                                                                      *itk::ImageFullSampler<ImageType>::New(),
+                                                                      *interpolator,
+                                                                      false,
+                                                                      true);
+
+  for (const auto & parameters : parametersPerEvaluation)
+  {
+    if (parameters == translationParameters)
+    {
+      EXPECT_THROW(singleThreadedMetric->ComputeJointHistogram(parameters), itk::ExceptionObject);
+      EXPECT_THROW(multiThreadedMetric->ComputeJointHistogram(parameters), itk::ExceptionObject);
+      continue;
+    }
+
+    const auto expectedJointHistogram = singleThreadedMetric->ComputeJointHistogram(parameters);
+    const auto actualJointHistogram = multiThreadedMetric->ComputeJointHistogram(parameters);
+    ASSERT_EQ(actualJointHistogram.size(), expectedJointHistogram.size());
+
+    const double tolerance = 1e-12 * *std::max_element(expectedJointHistogram.cbegin(), expectedJointHistogram.cend());
+    ASSERT_GT(tolerance, 0.0);
+
+    for (std::size_t bin = 0; bin < expectedJointHistogram.size(); ++bin)
+    {
+      EXPECT_NEAR(actualJointHistogram[bin], expectedJointHistogram[bin], tolerance);
+    }
+  }
+}
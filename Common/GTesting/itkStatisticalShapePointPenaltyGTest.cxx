@@ -0,0 +1,239 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "StatisticalShapePenalty/itkStatisticalShapePointPenalty.h"
+#include "elxGTestUtilities.h"
+#include "../Core/Main/GTesting/elxCoreMainGTestUtilities.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include <itkPointSet.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+// Using-declarations:
+using elx::CoreMainGTestUtilities::CheckNew;
+using elx::GTestUtilities::MakePoint;
+using elx::GTestUtilities::MakeSize;
+using elx::GTestUtilities::MakeVector;
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+constexpr unsigned int NumberOfPoints = 8;
+using PointSetType = itk::PointSet<double, Dimension>;
+using PenaltyType = itk::StatisticalShapePointPenalty<PointSetType, PointSetType>;
+using TransformType = itk::AdvancedBSplineDeformableTransform<double, Dimension, 3>;
+using VnlVectorType = PenaltyType::VnlVectorType;
+using VnlMatrixType = PenaltyType::VnlMatrixType;
+
+
+// Creates a B-spline transform, whose valid region is [-1, 7) in each dimension, with some non-zero parameters.
+TransformType::Pointer
+CreateTransform()
+{
+  const auto transform = TransformType::New();
+  transform->SetGridRegion(TransformType::RegionType(MakeSize(6, 6, 6)));
+  transform->SetGridSpacing(MakeVector(2.0, 2.0, 2.0));
+  transform->SetGridOrigin(MakePoint(-3.0, -3.0, -3.0));
+
+  TransformType::ParametersType parameters(transform->GetNumberOfParameters());
+  for (unsigned int i = 0; i < parameters.size(); ++i)
+  {
+    parameters[i] = 0.2 * std::sin(0.37 * i);
+  }
+  transform->SetParametersByValue(parameters);
+  return transform;
+}
+
+
+// Creates a point set of the (slightly perturbed) corners of a box, inside the valid region of the transform.
+PointSetType::Pointer
+CreatePointSet()
+{
+  const auto pointSet = PointSetType::New();
+  for (unsigned int i = 0; i < NumberOfPoints; ++i)
+  {
+    pointSet->SetPoint(i,
+                       MakePoint(1.0 + 3.0 * (i % 2) + 0.3 * std::sin(i),
+                                 1.0 + 3.0 * ((i / 2) % 2) + 0.2 * std::cos(i),
+                                 1.0 + 3.0 * (i / 4) + 0.25 * std::sin(2.0 * i)));
+  }
+  return pointSet;
+}
+
+
+// Computes the proposal vector of the points, like the penalty does: either the concatenated coordinates, or, for a
+// normalized shape model, the coordinates aligned by their centroid and normalized by their l2-norm, followed by the
+// centroid and the l2-norm.
+VnlVectorType
+ComputeProposalVector(const PointSetType & pointSet, const bool normalizedShapeModel)
+{
+  const unsigned int shapeLength = Dimension * NumberOfPoints;
+  VnlVectorType      proposal(normalizedShapeModel ? shapeLength + Dimension + 1 : shapeLength, 0.0);
+
+  for (unsigned int i = 0; i < NumberOfPoints; ++i)
+  {
+    for (unsigned int d = 0; d < Dimension; ++d)
+    {
+      proposal[i * Dimension + d] = pointSet.GetPoint(i)[d];
+    }
+  }
+
+  if (normalizedShapeModel)
+  {
+    double l2norm = 0.0;
+    for (unsigned int d = 0; d < Dimension; ++d)
+    {
+      double centroid = 0.0;
+      for (unsigned int i = 0; i < NumberOfPoints; ++i)
+      {
+        centroid += proposal[i * Dimension + d] / NumberOfPoints;
+      }
+      for (unsigned int i = 0; i < NumberOfPoints; ++i)
+      {
+        proposal[i * Dimension + d] -= centroid;
+        l2norm += proposal[i * Dimension + d] * proposal[i * Dimension + d];
+      }
+      proposal[shapeLength + d] = centroid;
+    }
+    l2norm = std::sqrt(l2norm / NumberOfPoints);
+    for (unsigned int index = 0; index < shapeLength; ++index)
+    {
+      proposal[index] /= l2norm;
+    }
+    proposal[shapeLength + Dimension] = l2norm;
+  }
+  return proposal;
+}
+
+
+// Creates and initializes a penalty, with a mean shape that differs from the shape of the fixed points, and a positive
+// definite covariance matrix of low rank plus a diagonal.
+PenaltyType::Pointer
+CreatePenalty(const int            shapeModelCalculation,
+              const bool           normalizedShapeModel,
+              const bool           useMultiThread,
+              const PointSetType & pointSet,
+              TransformType &      transform)
+{
+  VnlVectorType      meanVector = ComputeProposalVector(pointSet, normalizedShapeModel);
+  const unsigned int proposalLength = meanVector.size();
+  for (unsigned int index = 0; index < proposalLength; ++index)
+  {
+    meanVector[index] += 0.1 * std::cos(0.7 * index);
+  }
+
+  VnlMatrixType basis(proposalLength, 4);
+  for (unsigned int i = 0; i < proposalLength; ++i)
+  {
+    for (unsigned int k = 0; k < 4; ++k)
+    {
+      basis(i, k) = 0.2 * std::sin(0.5 * (i + 1) * (k + 1));
+    }
+  }
+  VnlMatrixType covarianceMatrix = basis * basis.transpose();
+  for (unsigned int i = 0; i < proposalLength; ++i)
+  {
+    covarianceMatrix(i, i) += 0.05;
+  }
+
+  const auto penalty = CheckNew<PenaltyType>();
+  penalty->SetFixedPointSet(&pointSet);
+  penalty->SetMovingPointSet(&pointSet);
+  penalty->SetTransform(&transform);
+
+  // The penalty takes ownership of the mean vector and the covariance matrix.
+  penalty->SetMeanVector(new VnlVectorType(meanVector));
+  penalty->SetCovarianceMatrix(new VnlMatrixType(covarianceMatrix));
+
+  penalty->SetShapeModelCalculation(shapeModelCalculation);
+  penalty->SetNormalizedShapeModel(normalizedShapeModel);
+  penalty->SetShrinkageIntensity(0.1);
+  penalty->SetBaseVariance(0.5);
+  penalty->SetCentroidXVariance(1.0);
+  penalty->SetCentroidYVariance(1.2);
+  penalty->SetCentroidZVariance(0.9);
+  penalty->SetSizeVariance(0.8);
+  penalty->SetCutOffValue(0.0);
+  penalty->SetCutOffSharpness(2.0);
+  penalty->SetNumberOfWorkUnits(3);
+  penalty->SetUseMultiThread(useMultiThread);
+  penalty->Initialize();
+  return penalty;
+}
+
+} // namespace
+
+
+// Tests that the derivative is the gradient of the value, as estimated by central differences, for each shape model
+// calculation that supports the (non-)normalized shape model, both single- and multi-threaded. The other combinations
+// should be rejected by Initialize().
+GTEST_TEST(StatisticalShapePointPenalty, DerivativeEqualsFiniteDifference)
+{
+  const auto pointSet = CreatePointSet();
+  const auto transform = CreateTransform();
+  const auto parameters = transform->GetParameters();
+
+  for (const int shapeModelCalculation : { 0, 1, 2 })
+  {
+    for (const bool normalizedShapeModel : { false, true })
+    {
+      for (const bool useMultiThread : { false, true })
+      {
+        if (((shapeModelCalculation == 1) && normalizedShapeModel) ||
+            ((shapeModelCalculation == 2) && !normalizedShapeModel))
+        {
+          EXPECT_THROW(
+            CreatePenalty(shapeModelCalculation, normalizedShapeModel, useMultiThread, *pointSet, *transform),
+            itk::ExceptionObject);
+          continue;
+        }
+
+        const auto penalty =
+          CreatePenalty(shapeModelCalculation, normalizedShapeModel, useMultiThread, *pointSet, *transform);
+
+        PenaltyType::MeasureType    value{};
+        PenaltyType::DerivativeType derivative;
+        penalty->GetValueAndDerivative(parameters, value, derivative);
+
+        EXPECT_GT(value, 0.0);
+        EXPECT_NEAR(penalty->GetValue(parameters), value, 1e-12 * value);
+        ASSERT_EQ(derivative.size(), parameters.size());
+
+        const double tolerance = 1e-5 * derivative.inf_norm();
+        ASSERT_GT(tolerance, 0.0);
+
+        const double delta = 1e-6;
+        for (unsigned int p = 0; p < parameters.size(); ++p)
+        {
+          auto plusParameters = parameters;
+          auto minusParameters = parameters;
+          plusParameters[p] += delta;
+          minusParameters[p] -= delta;
+
+          const double finiteDifference =
+            (penalty->GetValue(plusParameters) - penalty->GetValue(minusParameters)) / (2.0 * delta);
+          EXPECT_NEAR(derivative[p], finiteDifference, tolerance);
+        }
+      }
+    }
+  }
+}
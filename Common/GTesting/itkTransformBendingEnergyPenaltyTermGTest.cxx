@@ -0,0 +1,182 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "BendingEnergyPenalty/itkTransformBendingEnergyPenaltyTerm.h"
+#include "../Core/Main/GTesting/elxCoreMainGTestUtilities.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkImageFullSampler.h"
+#include <itkImage.h>
+#include <itkLinearInterpolateImageFunction.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+// Using-declarations:
+using elx::CoreMainGTestUtilities::CheckNew;
+
+namespace
+{
+
+template <unsigned int VDimension>
+using ImageType = itk::Image<float, VDimension>;
+
+template <unsigned int VDimension>
+using PenaltyTermType = itk::TransformBendingEnergyPenaltyTerm<ImageType<VDimension>, double>;
+
+template <unsigned int VDimension>
+using TransformType = itk::AdvancedBSplineDeformableTransform<double, VDimension, 3>;
+
+
+// Creates an image of the specified size and spacing, with its origin at zero.
+template <unsigned int VDimension>
+typename ImageType<VDimension>::Pointer
+CreateImage(const itk::SizeValueType imageSizeValue, const double imageSpacingValue)
+{
+  typename ImageType<VDimension>::SpacingType imageSpacing;
+  imageSpacing.Fill(imageSpacingValue);
+
+  const auto image = ImageType<VDimension>::New();
+  image->SetRegions(itk::Size<VDimension>::Filled(imageSizeValue));
+  image->SetSpacing(imageSpacing);
+  image->Allocate(true);
+  return image;
+}
+
+
+// Creates a B-spline transform, with grid spacing 4, whose valid region covers [-4, 40] in each dimension, with some
+// non-zero parameters.
+template <unsigned int VDimension>
+typename TransformType<VDimension>::Pointer
+CreateTransform()
+{
+  const auto transform = TransformType<VDimension>::New();
+  transform->SetGridRegion(typename TransformType<VDimension>::RegionType(itk::Size<VDimension>::Filled(14)));
+
+  typename TransformType<VDimension>::SpacingType gridSpacing;
+  gridSpacing.Fill(4.0);
+  transform->SetGridSpacing(gridSpacing);
+
+  typename TransformType<VDimension>::OriginType gridOrigin;
+  gridOrigin.Fill(-8.0);
+  transform->SetGridOrigin(gridOrigin);
+
+  typename TransformType<VDimension>::ParametersType parameters(transform->GetNumberOfParameters());
+  for (unsigned int i = 0; i < parameters.size(); ++i)
+  {
+    parameters[i] = 0.5 * std::sin(0.37 * i);
+  }
+  transform->SetParametersByValue(parameters);
+  return transform;
+}
+
+
+// Creates a bending energy penalty term for the specified image and transform, using a full sampler.
+template <unsigned int VDimension>
+typename PenaltyTermType<VDimension>::Pointer
+CreatePenaltyTerm(const ImageType<VDimension> & image, TransformType<VDimension> & transform)
+{
+  const auto penaltyTerm = CheckNew<PenaltyTermType<VDimension>>();
+  penaltyTerm->SetFixedImage(&image);
+  penaltyTerm->SetMovingImage(&image);
+  penaltyTerm->SetFixedImageRegion(image.GetBufferedRegion());
+  penaltyTerm->SetInterpolator(itk::LinearInterpolateImageFunction<ImageType<VDimension>, double>::New());
+  penaltyTerm->SetImageSampler(itk::ImageFullSampler<ImageType<VDimension>>::New());
+  penaltyTerm->SetTransform(&transform);
+  penaltyTerm->SetNumberOfWorkUnits(3);
+  penaltyTerm->Initialize();
+  return penaltyTerm;
+}
+
+
+// Expects that the grid-based derivative is the gradient of the grid-based value, which is a quadratic form, so that
+// central differences are exact, up to rounding errors.
+template <unsigned int VDimension>
+void
+ExpectDerivativeEqualsFiniteDifference(const itk::SizeValueType imageSizeValue, const double imageSpacingValue)
+{
+  const auto image = CreateImage<VDimension>(imageSizeValue, imageSpacingValue);
+  const auto transform = CreateTransform<VDimension>();
+  const auto penaltyTerm = CreatePenaltyTerm(*image, *transform);
+  penaltyTerm->SetUseGridBasedBendingEnergy(true);
+
+  const auto   parameters = transform->GetParameters();
+  const double delta = 1e-3;
+
+  for (const bool useMultiThread : { false, true })
+  {
+    typename PenaltyTermType<VDimension>::MeasureType    value{};
+    typename PenaltyTermType<VDimension>::DerivativeType derivative;
+    penaltyTerm->SetUseMultiThread(useMultiThread);
+    penaltyTerm->GetValueAndDerivative(parameters, value, derivative);
+
+    EXPECT_GT(value, 0.0);
+    EXPECT_NEAR(penaltyTerm->GetValue(parameters), value, 1e-12 * value);
+    ASSERT_EQ(derivative.size(), parameters.size());
+
+    const double tolerance = 1e-6 * derivative.inf_norm();
+    ASSERT_GT(tolerance, 0.0);
+
+    for (unsigned int p = 0; p < parameters.size(); ++p)
+    {
+      auto plusParameters = parameters;
+      auto minusParameters = parameters;
+      plusParameters[p] += delta;
+      minusParameters[p] -= delta;
+
+      const double finiteDifference =
+        (penaltyTerm->GetValue(plusParameters) - penaltyTerm->GetValue(minusParameters)) / (2.0 * delta);
+      EXPECT_NEAR(derivative[p], finiteDifference, tolerance);
+    }
+  }
+}
+
+} // namespace
+
+
+// Tests that the grid-based bending energy approximates the bending energy that is computed by sampling all pixels of
+// a fine image, whose domain is inside the valid region of the B-spline grid. The sampled value is the mean over the
+// pixels, which approaches the integral over the domain, divided by its volume, as the pixels get smaller.
+GTEST_TEST(TransformBendingEnergyPenaltyTerm, GridBasedValueApproximatesFullSamplerValue)
+{
+  constexpr unsigned int Dimension = 2;
+
+  // The image covers [0, 36] in each dimension, with 8 pixels per unit.
+  const auto image = CreateImage<Dimension>(289, 0.125);
+  const auto transform = CreateTransform<Dimension>();
+  const auto penaltyTerm = CreatePenaltyTerm(*image, *transform);
+  const auto parameters = transform->GetParameters();
+
+  penaltyTerm->SetUseGridBasedBendingEnergy(false);
+  const double fullSamplerValue = penaltyTerm->GetValue(parameters);
+  ASSERT_GT(fullSamplerValue, 0.0);
+
+  penaltyTerm->SetUseGridBasedBendingEnergy(true);
+  const double gridBasedValue = penaltyTerm->GetValue(parameters);
+
+  EXPECT_NEAR(gridBasedValue, fullSamplerValue, 0.02 * fullSamplerValue);
+}
+
+
+GTEST_TEST(TransformBendingEnergyPenaltyTerm, GridBasedDerivativeEqualsFiniteDifference)
+{
+  ExpectDerivativeEqualsFiniteDifference<2>(37, 1.0);
+  ExpectDerivativeEqualsFiniteDifference<3>(10, 4.0);
+}
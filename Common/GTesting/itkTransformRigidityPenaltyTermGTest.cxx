@@ -0,0 +1,269 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "RigidityPenalty/itkTransformRigidityPenaltyTerm.h"
+#include "../Core/Main/GTesting/elxCoreMainGTestUtilities.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include <itkImage.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkLinearInterpolateImageFunction.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+// Using-declarations:
+using elx::CoreMainGTestUtilities::CheckNew;
+
+namespace
+{
+
+template <unsigned int VDimension>
+using ImageType = itk::Image<float, VDimension>;
+
+template <unsigned int VDimension>
+using PenaltyTermType = itk::TransformRigidityPenaltyTerm<ImageType<VDimension>, double>;
+
+template <unsigned int VDimension>
+using TransformType = itk::AdvancedBSplineDeformableTransform<double, VDimension, 3>;
+
+
+// Creates a B-spline transform with some non-zero parameters.
+template <unsigned int VDimension>
+typename TransformType<VDimension>::Pointer
+CreateTransform(const itk::Size<VDimension> & gridSize)
+{
+  const auto transform = TransformType<VDimension>::New();
+  transform->SetGridRegion(typename TransformType<VDimension>::RegionType(gridSize));
+
+  typename TransformType<VDimension>::SpacingType gridSpacing;
+  gridSpacing.Fill(2.0);
+  transform->SetGridSpacing(gridSpacing);
+
+  typename TransformType<VDimension>::OriginType gridOrigin;
+  gridOrigin.Fill(-6.0);
+  transform->SetGridOrigin(gridOrigin);
+
+  typename TransformType<VDimension>::ParametersType parameters(transform->GetNumberOfParameters());
+  for (unsigned int i = 0; i < parameters.size(); ++i)
+  {
+    parameters[i] = 0.2 * std::sin(0.37 * i);
+  }
+  transform->SetParametersByValue(parameters);
+  return transform;
+}
+
+
+// Creates a rigidity image on the B-spline grid, which has non-zero rigidity coefficients only in a block in the
+// interior of the grid, at least two grid points away from its border. So most of the grid has zero rigidity.
+template <unsigned int VDimension>
+typename PenaltyTermType<VDimension>::RigidityImageType::Pointer
+CreateRigidityImage(const TransformType<VDimension> & transform)
+{
+  using RigidityImageType = typename PenaltyTermType<VDimension>::RigidityImageType;
+
+  const auto image = RigidityImageType::New();
+  image->SetRegions(transform.GetGridRegion());
+  image->SetSpacing(transform.GetGridSpacing());
+  image->SetOrigin(transform.GetGridOrigin());
+  image->Allocate(true);
+
+  for (itk::ImageRegionIteratorWithIndex<RigidityImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const auto index = it.GetIndex();
+    bool       isInBlock = true;
+    for (unsigned int d = 0; d < VDimension; ++d)
+    {
+      isInBlock = isInBlock && (index[d] >= 6) && (index[d] <= 10);
+    }
+    if (isInBlock)
+    {
+      it.Set(0.4 + 0.05 * index[0]);
+    }
+  }
+  return image;
+}
+
+
+// Creates a rigidity penalty term for the specified transform, using the specified fixed rigidity image.
+template <unsigned int VDimension>
+typename PenaltyTermType<VDimension>::Pointer
+CreatePenaltyTerm(TransformType<VDimension> &                                 transform,
+                  typename PenaltyTermType<VDimension>::RigidityImageType & rigidityImage)
+{
+  const auto image = ImageType<VDimension>::New();
+  image->SetRegions(itk::Size<VDimension>::Filled(8));
+  image->Allocate(true);
+
+  const auto penaltyTerm = CheckNew<PenaltyTermType<VDimension>>();
+  penaltyTerm->SetFixedImage(image);
+  penaltyTerm->SetMovingImage(image);
+  penaltyTerm->SetFixedImageRegion(image->GetBufferedRegion());
+  penaltyTerm->SetInterpolator(itk::LinearInterpolateImageFunction<ImageType<VDimension>, double>::New());
+  penaltyTerm->SetTransform(&transform);
+  penaltyTerm->SetFixedRigidityImage(&rigidityImage);
+  penaltyTerm->SetUseFixedRigidityImage(true);
+  penaltyTerm->SetUseMovingRigidityImage(false);
+  penaltyTerm->SetDilateRigidityImages(false);
+  penaltyTerm->SetNumberOfWorkUnits(3);
+  penaltyTerm->Initialize();
+  return penaltyTerm;
+}
+
+
+// Expects that GetValueAndDerivative yields the same value as GetValue, and the same derivative, whether it is
+// multi-threaded or not. The grid has tiles of which all rigidity coefficients are zero, which are skipped.
+template <unsigned int VDimension>
+void
+ExpectSameValueAndDerivativeWhenMultiThreaded(const itk::Size<VDimension> & gridSize)
+{
+  const auto transform = CreateTransform(gridSize);
+  const auto rigidityImage = CreateRigidityImage(*transform);
+  const auto penaltyTerm = CreatePenaltyTerm(*transform, *rigidityImage);
+
+  const auto parameters = transform->GetParameters();
+
+  const double expectedValue = penaltyTerm->GetValue(parameters);
+  ASSERT_GT(expectedValue, 0.0);
+
+  typename PenaltyTermType<VDimension>::MeasureType    singleThreadedValue{};
+  typename PenaltyTermType<VDimension>::DerivativeType singleThreadedDerivative;
+  penaltyTerm->SetUseMultiThread(false);
+  penaltyTerm->GetValueAndDerivative(parameters, singleThreadedValue, singleThreadedDerivative);
+
+  EXPECT_NEAR(singleThreadedValue, expectedValue, 1e-10 * expectedValue);
+
+  const double tolerance = 1e-10 * singleThreadedDerivative.inf_norm();
+  ASSERT_GT(tolerance, 0.0);
+
+  // Do it twice, to check that the filtered parts are properly reset.
+  for (int i = 0; i < 2; ++i)
+  {
+    typename PenaltyTermType<VDimension>::MeasureType    multiThreadedValue{};
+    typename PenaltyTermType<VDimension>::DerivativeType multiThreadedDerivative;
+    penaltyTerm->SetUseMultiThread(true);
+    penaltyTerm->GetValueAndDerivative(parameters, multiThreadedValue, multiThreadedDerivative);
+
+    EXPECT_NEAR(multiThreadedValue, expectedValue, 1e-10 * expectedValue);
+    ASSERT_EQ(multiThreadedDerivative.size(), singleThreadedDerivative.size());
+
+    for (unsigned int p = 0; p < singleThreadedDerivative.size(); ++p)
+    {
+      EXPECT_NEAR(multiThreadedDerivative[p], singleThreadedDerivative[p], tolerance);
+    }
+  }
+}
+
+} // namespace
+
+
+// Tests that on a 2D grid with rigid parts in its interior only, the derivative is the gradient of the value, as
+// estimated by central differences, for both the single-threaded and the multi-threaded (tiled) implementation. Most
+// of the grid is in tiles of which all rigidity coefficients are zero, so for which the filtering is skipped.
+GTEST_TEST(TransformRigidityPenaltyTerm, DerivativeEqualsFiniteDifference)
+{
+  constexpr unsigned int Dimension = 2;
+
+  const auto transform = CreateTransform(itk::Size<Dimension>{ { 20, 18 } });
+  const auto rigidityImage = CreateRigidityImage(*transform);
+  const auto penaltyTerm = CreatePenaltyTerm(*transform, *rigidityImage);
+
+  const auto   parameters = transform->GetParameters();
+  const double delta = 1e-6;
+
+  for (const bool useMultiThread : { false, true })
+  {
+    PenaltyTermType<Dimension>::MeasureType    value{};
+    PenaltyTermType<Dimension>::DerivativeType derivative;
+    penaltyTerm->SetUseMultiThread(useMultiThread);
+    penaltyTerm->GetValueAndDerivative(parameters, value, derivative);
+
+    ASSERT_EQ(derivative.size(), parameters.size());
+    const double tolerance = 1e-5 * derivative.inf_norm();
+    ASSERT_GT(tolerance, 0.0);
+
+    unsigned int numberOfZeroDerivatives = 0;
+
+    for (unsigned int p = 0; p < parameters.size(); ++p)
+    {
+      auto plusParameters = parameters;
+      auto minusParameters = parameters;
+      plusParameters[p] += delta;
+      minusParameters[p] -= delta;
+
+      const double finiteDifference =
+        (penaltyTerm->GetValue(plusParameters) - penaltyTerm->GetValue(minusParameters)) / (2.0 * delta);
+      EXPECT_NEAR(derivative[p], finiteDifference, tolerance);
+
+      if (derivative[p] == 0.0)
+      {
+        ++numberOfZeroDerivatives;
+      }
+    }
+
+    // The control points that are not near the rigid block do not contribute to the penalty.
+    EXPECT_GT(numberOfZeroDerivatives, parameters.size() / 2);
+  }
+}
+
+
+GTEST_TEST(TransformRigidityPenaltyTerm, SameValueAndDerivativeWhenMultiThreaded)
+{
+  ExpectSameValueAndDerivativeWhenMultiThreaded(itk::Size<2>{ { 20, 18 } });
+  ExpectSameValueAndDerivativeWhenMultiThreaded(itk::Size<3>{ { 19, 18, 17 } });
+}
+
+
+// Tests that the buffers that are reused by subsequent calls, for different parameters, do not affect the results:
+// each call yields the same value and derivative as a newly created penalty term.
+GTEST_TEST(TransformRigidityPenaltyTerm, SameValueAndDerivativeWhenReusingBuffers)
+{
+  constexpr unsigned int Dimension = 2;
+
+  const auto transform = CreateTransform(itk::Size<Dimension>{ { 20, 18 } });
+  const auto rigidityImage = CreateRigidityImage(*transform);
+  const auto penaltyTerm = CreatePenaltyTerm(*transform, *rigidityImage);
+
+  const auto initialParameters = transform->GetParameters();
+  auto       otherParameters = initialParameters;
+  for (unsigned int p = 0; p < otherParameters.size(); ++p)
+  {
+    otherParameters[p] += 0.1 * std::cos(0.23 * p);
+  }
+
+  for (const auto & parameters : { initialParameters, otherParameters, initialParameters })
+  {
+    PenaltyTermType<Dimension>::MeasureType    value{};
+    PenaltyTermType<Dimension>::DerivativeType derivative;
+    penaltyTerm->GetValueAndDerivative(parameters, value, derivative);
+
+    const auto newTransform = CreateTransform(itk::Size<Dimension>{ { 20, 18 } });
+    newTransform->SetParametersByValue(parameters);
+    const auto newPenaltyTerm = CreatePenaltyTerm(*newTransform, *rigidityImage);
+
+    PenaltyTermType<Dimension>::MeasureType    expectedValue{};
+    PenaltyTermType<Dimension>::DerivativeType expectedDerivative;
+    newPenaltyTerm->GetValueAndDerivative(parameters, expectedValue, expectedDerivative);
+
+    EXPECT_EQ(value, expectedValue);
+    EXPECT_EQ(penaltyTerm->GetValue(parameters), newPenaltyTerm->GetValue(parameters));
+    EXPECT_EQ(derivative, expectedDerivative);
+  }
+}
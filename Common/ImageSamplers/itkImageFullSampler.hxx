@@ -100,6 +100,7 @@ ImageFullSampler<TInputImage>::GenerateData(void)
     {
       mask->GetSource()->Update();
     }
+    this->UpdatePackedMask();
 
     /** Loop over the image and check if the points falls within the mask. */
     ImageSampleType tempSample;
@@ -111,7 +112,7 @@ ImageFullSampler<TInputImage>::GenerateData(void)
       /** Translate index to point. */
       inputImage->TransformIndexToPhysicalPoint(index, tempSample.m_ImageCoordinates);
 
-      if (mask->IsInsideInWorldSpace(tempSample.m_ImageCoordinates))
+      if (this->IsInsideMask(tempSample.m_ImageCoordinates))
       {
         /** Get sampled image value. */
         tempSample.m_ImageValue = iter.Get();
@@ -206,7 +207,7 @@ ImageFullSampler<TInputImage>::ThreadedGenerateData(const InputImageRegionType &
       /** Translate index to point. */
       inputImage->TransformIndexToPhysicalPoint(index, tempSample.m_ImageCoordinates);
 
-      if (mask->IsInsideInWorldSpace(tempSample.m_ImageCoordinates))
+      if (this->IsInsideMask(tempSample.m_ImageCoordinates))
       {
         /** Get sampled image value. */
         tempSample.m_ImageValue = iter.Get();
@@ -162,6 +162,7 @@ ImageGridSampler<TInputImage>::GenerateData(void)
     {
       mask->GetSource()->Update();
     }
+    this->UpdatePackedMask();
     /* Ugly loop over the grid; checks also if a sample falls within the mask. */
     for (unsigned int t = 0; t < dim_t; ++t)
     {
@@ -176,7 +177,7 @@ ImageGridSampler<TInputImage>::GenerateData(void)
             // Translate index to point.
             inputImage->TransformIndexToPhysicalPoint(index, tempsample.m_ImageCoordinates);
 
-            if (mask->IsInsideInWorldSpace(tempsample.m_ImageCoordinates))
+            if (this->IsInsideMask(tempsample.m_ImageCoordinates))
             {
               // Get sampled fixed image value.
               tempsample.m_ImageValue = inputImage->GetPixel(index);
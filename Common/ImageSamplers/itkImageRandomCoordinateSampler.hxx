@@ -36,9 +36,6 @@ ImageRandomCoordinateSampler<TInputImage>::ImageRandomCoordinateSampler()
   bsplineInterpolator->SetSplineOrder(3);
   this->m_Interpolator = bsplineInterpolator;
 
-  /** Setup random generator. */
-  this->m_RandomGenerator = RandomGeneratorType::GetInstance();
-
   this->m_UseRandomSampleRegion = false;
   this->m_SampleRegionSize.Fill(1.0);
 
@@ -116,6 +113,7 @@ ImageRandomCoordinateSampler<TInputImage>::GenerateData(void)
     {
       mask->GetSource()->Update();
     }
+    this->UpdatePackedMask();
     /** Set up some variable that are used to make sure we are not forever
      * walking around on this image, trying to look for valid samples. */
     unsigned long numberOfSamplesTried = 0;
@@ -148,7 +146,7 @@ ImageRandomCoordinateSampler<TInputImage>::GenerateData(void)
         this->GenerateRandomCoordinate(smallestContIndex, largestContIndex, sampleContIndex);
         inputImage->TransformContinuousIndexToPhysicalPoint(sampleContIndex, samplePoint);
 
-      } while (!interpolator->IsInsideBuffer(sampleContIndex) || !mask->IsInsideInWorldSpace(samplePoint));
+      } while (!interpolator->IsInsideBuffer(sampleContIndex) || !this->IsInsideMask(samplePoint));
 
       /** Compute the value at the point. */
       sampleValue = static_cast<ImageSampleValueType>(this->m_Interpolator->EvaluateAtContinuousIndex(sampleContIndex));
@@ -339,7 +337,6 @@ ImageRandomCoordinateSampler<TInputImage>::PrintSelf(std::ostream & os, Indent i
   Superclass::PrintSelf(os, indent);
 
   os << indent << "Interpolator: " << this->m_Interpolator.GetPointer() << std::endl;
-  os << indent << "RandomGenerator: " << this->m_RandomGenerator.GetPointer() << std::endl;
 
 } // end PrintSelf()
 
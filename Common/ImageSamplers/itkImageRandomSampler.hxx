@@ -20,9 +20,6 @@
 
 #include "itkImageRandomSampler.h"
 
-#include "itkMersenneTwisterRandomVariateGenerator.h"
-#include "itkImageRandomConstIteratorWithIndex.h"
-
 namespace itk
 {
 
@@ -49,10 +46,27 @@ ImageRandomSampler<TInputImage>::GenerateData(void)
   /** Reserve memory for the output. */
   sampleContainer->Reserve(this->GetNumberOfSamples());
 
-  /** Setup a random iterator over the input image. */
-  typedef ImageRandomConstIteratorWithIndex<InputImageType> RandomIteratorType;
-  RandomIteratorType                                        randIter(inputImage, this->GetCroppedInputImageRegion());
-  randIter.GoToBegin();
+  /** Draws a random index in the cropped input image region, like ImageRandomConstIteratorWithIndex does,
+   * but using the random number generator of this sampler, instead of the global one. */
+  const InputImageRegionType croppedRegion = this->GetCroppedInputImageRegion();
+  const double               numberOfPixels = static_cast<double>(croppedRegion.GetNumberOfPixels());
+  const auto                 generateRandomIndex = [this, &croppedRegion, numberOfPixels] {
+    auto randomPosition =
+      static_cast<unsigned long>(this->m_RandomGenerator->GetVariateWithOpenRange(numberOfPixels - 0.5));
+    InputImageIndexType index;
+    for (unsigned int dim = 0; dim < InputImageDimension; ++dim)
+    {
+      const unsigned long sizeInThisDimension = croppedRegion.GetSize(dim);
+      const unsigned long residual = randomPosition % sizeInThisDimension;
+      index[dim] = residual + croppedRegion.GetIndex(dim);
+      randomPosition -= residual;
+      randomPosition /= sizeInThisDimension;
+    }
+    return index;
+  };
+
+  /** Dummy jump, like the one of ImageRandomConstIteratorWithIndex::GoToBegin(). */
+  generateRandomIndex();
 
   /** Setup an iterator over the output, which is of ImageSampleContainerType. */
   typename ImageSampleContainerType::Iterator      iter;
@@ -60,22 +74,21 @@ ImageRandomSampler<TInputImage>::GenerateData(void)
 
   if (mask.IsNull())
   {
-    /** number of samples + 1, because of the initial ++randIter. */
-    randIter.SetNumberOfSamples(this->GetNumberOfSamples() + 1);
-    /** Advance one, in order to generate the same sequence as when using a mask */
-    ++randIter;
     for (iter = sampleContainer->Begin(); iter != end; ++iter)
     {
-      /** Get the index, transform it to the physical coordinates and put it in the sample. */
-      InputImageIndexType index = randIter.GetIndex();
+      /** Jump to a random position, and transform it to the physical coordinates and put it in the sample. */
+      const InputImageIndexType index = generateRandomIndex();
       inputImage->TransformIndexToPhysicalPoint(index, (*iter).Value().m_ImageCoordinates);
       /** Get the value and put it in the sample. */
-      (*iter).Value().m_ImageValue = randIter.Get();
-      /** Jump to a random position. */
-      ++randIter;
+      (*iter).Value().m_ImageValue = static_cast<ImageSampleValueType>(inputImage->GetPixel(index));
 
     } // end for loop
-  }   // end if no mask
+
+    /** Extra random sample to make sure the same sequence is generated
+     * with and without mask.
+     */
+    generateRandomIndex();
+  } // end if no mask
   else
   {
     /** Update the mask. */
@@ -83,11 +96,14 @@ ImageRandomSampler<TInputImage>::GenerateData(void)
     {
       mask->GetSource()->Update();
     }
+    this->UpdatePackedMask();
 
     /** Make sure we are not eternally trying to find samples: */
-    randIter.SetNumberOfSamples(10 * this->GetNumberOfSamples());
+    const unsigned long maximumNumberOfJumps = 10 * this->GetNumberOfSamples();
+    unsigned long       numberOfJumps = 0;
 
     /** Loop over the sample container. */
+    InputImageIndexType index;
     InputImagePointType inputPoint;
     bool                insideMask = false;
     for (iter = sampleContainer->Begin(); iter != end; ++iter)
@@ -95,10 +111,8 @@ ImageRandomSampler<TInputImage>::GenerateData(void)
       /** Loop until a valid sample is found. */
       do
       {
-        /** Jump to a random position. */
-        ++randIter;
         /** Check if we are not trying eternally to find a valid point. */
-        if (randIter.IsAtEnd())
+        if (++numberOfJumps > maximumNumberOfJumps)
         {
           /** Squeeze the sample container to the size that is still valid. */
           typename ImageSampleContainerType::iterator stlnow = sampleContainer->begin();
@@ -108,23 +122,23 @@ ImageRandomSampler<TInputImage>::GenerateData(void)
           itkExceptionMacro(
             << "Could not find enough image samples within reasonable time. Probably the mask is too small");
         }
-        /** Get the index, and transform it to the physical coordinates. */
-        InputImageIndexType index = randIter.GetIndex();
+        /** Jump to a random position, and transform it to the physical coordinates. */
+        index = generateRandomIndex();
         inputImage->TransformIndexToPhysicalPoint(index, inputPoint);
         /** Check if it's inside the mask. */
-        insideMask = mask->IsInsideInWorldSpace(inputPoint);
+        insideMask = this->IsInsideMask(inputPoint);
       } while (!insideMask);
 
       /** Put the coordinates and the value in the sample. */
       (*iter).Value().m_ImageCoordinates = inputPoint;
-      (*iter).Value().m_ImageValue = randIter.Get();
+      (*iter).Value().m_ImageValue = static_cast<ImageSampleValueType>(inputImage->GetPixel(index));
 
     } // end for loop
 
     /** Extra random sample to make sure the same sequence is generated
      * with and without mask.
      */
-    ++randIter;
+    generateRandomIndex();
   }
 
 } // end GenerateData()
@@ -19,6 +19,7 @@
 #define itkImageRandomSamplerBase_h
 
 #include "itkImageSamplerBase.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
 
 namespace itk
 {
@@ -27,7 +28,7 @@ namespace itk
  *
  * \brief This class is a base class for any image sampler that randomly picks samples.
  *
- * It adds the Set/GetNumberOfSamples function.
+ * It adds the Set/GetNumberOfSamples function, and the random number generator.
  *
  * \ingroup ImageSamplers
  */
@@ -65,6 +66,15 @@ public:
   /** The input image dimension. */
   itkStaticConstMacro(InputImageDimension, unsigned int, Superclass::InputImageDimension);
 
+  /** The random number generator used to generate random samples. */
+  typedef Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+  typedef typename RandomGeneratorType::Pointer             RandomGeneratorPointer;
+
+  /** Set/Get the random number generator. By default, the global instance is used. Concurrent registrations
+   * should each have their own generator, to get reproducible samples. */
+  itkSetObjectMacro(RandomGenerator, RandomGeneratorType);
+  itkGetModifiableObjectMacro(RandomGenerator, RandomGeneratorType);
+
 protected:
   /** The constructor. */
   ImageRandomSamplerBase();
@@ -83,6 +93,8 @@ protected:
   /** Member variable used when threading. */
   std::vector<double> m_RandomNumberList;
 
+  RandomGeneratorPointer m_RandomGenerator{ RandomGeneratorType::GetInstance() };
+
 private:
   /** The deleted copy constructor. */
   ImageRandomSamplerBase(const Self &) = delete;
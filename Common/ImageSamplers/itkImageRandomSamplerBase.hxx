@@ -20,7 +20,6 @@
 
 #include "itkImageRandomSamplerBase.h"
 
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkImageRandomConstIteratorWithIndex.h"
 
 namespace itk
@@ -46,24 +45,19 @@ template <class TInputImage>
 void
 ImageRandomSamplerBase<TInputImage>::BeforeThreadedGenerateData(void)
 {
-  /** Create a random number generator. Also used in the ImageRandomConstIteratorWithIndex. */
-  typedef typename Statistics::MersenneTwisterRandomVariateGenerator::Pointer GeneratorPointer;
-  GeneratorPointer localGenerator = Statistics::MersenneTwisterRandomVariateGenerator::GetInstance();
-  // \todo: should probably be global?
-
   /** Clear the random number list. */
   this->m_RandomNumberList.resize(0);
   this->m_RandomNumberList.reserve(this->m_NumberOfSamples);
 
   /** Fill the list with random numbers. */
   const double numPixels = static_cast<double>(this->GetCroppedInputImageRegion().GetNumberOfPixels());
-  localGenerator->GetVariateWithOpenRange(numPixels - 0.5); // dummy jump
+  this->m_RandomGenerator->GetVariateWithOpenRange(numPixels - 0.5); // dummy jump
   for (unsigned long i = 0; i < this->m_NumberOfSamples; ++i)
   {
-    const double randomPosition = localGenerator->GetVariateWithOpenRange(numPixels - 0.5);
+    const double randomPosition = this->m_RandomGenerator->GetVariateWithOpenRange(numPixels - 0.5);
     this->m_RandomNumberList.push_back(randomPosition);
   }
-  localGenerator->GetVariateWithOpenRange(numPixels - 0.5); // dummy jump
+  this->m_RandomGenerator->GetVariateWithOpenRange(numPixels - 0.5); // dummy jump
 
   /** Initialize variables needed for threads. */
   Superclass::BeforeThreadedGenerateData();
@@ -82,6 +76,7 @@ ImageRandomSamplerBase<TInputImage>::PrintSelf(std::ostream & os, Indent indent)
   Superclass::PrintSelf(os, indent);
 
   os << indent << "NumberOfSamples: " << this->m_NumberOfSamples << std::endl;
+  os << indent << "RandomGenerator: " << this->m_RandomGenerator.GetPointer() << std::endl;
 
 } // end PrintSelf()
 
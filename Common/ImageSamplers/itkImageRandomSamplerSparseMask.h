@@ -19,7 +19,6 @@
 #define itkImageRandomSamplerSparseMask_h
 
 #include "itkImageRandomSamplerBase.h"
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkImageFullSampler.h"
 
 namespace itk
@@ -71,10 +70,6 @@ public:
   typedef typename InputImageType::IndexType InputImageIndexType;
   typedef typename InputImageType::PointType InputImagePointType;
 
-  /** The random number generator used to generate random indices. */
-  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
-  typedef typename RandomGeneratorType::Pointer                  RandomGeneratorPointer;
-
 protected:
   typedef itk::ImageFullSampler<InputImageType>     InternalFullSamplerType;
   typedef typename InternalFullSamplerType::Pointer InternalFullSamplerPointer;
@@ -99,7 +94,6 @@ protected:
   void
   ThreadedGenerateData(const InputImageRegionType & inputRegionForThread, ThreadIdType threadId) override;
 
-  RandomGeneratorPointer     m_RandomGenerator;
   InternalFullSamplerPointer m_InternalFullSampler;
 
 private:
@@ -30,9 +30,6 @@ namespace itk
 template <class TInputImage>
 ImageRandomSamplerSparseMask<TInputImage>::ImageRandomSamplerSparseMask()
 {
-  /** Setup random generator. */
-  this->m_RandomGenerator = RandomGeneratorType::GetInstance();
-
   this->m_InternalFullSampler = InternalFullSamplerType::New();
 
 } // end Constructor
@@ -196,7 +193,6 @@ ImageRandomSamplerSparseMask<TInputImage>::PrintSelf(std::ostream & os, Indent i
   Superclass::PrintSelf(os, indent);
 
   os << indent << "InternalFullSampler: " << this->m_InternalFullSampler.GetPointer() << std::endl;
-  os << indent << "RandomGenerator: " << this->m_RandomGenerator.GetPointer() << std::endl;
 
 } // end PrintSelf()
 
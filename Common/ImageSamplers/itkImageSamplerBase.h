@@ -22,6 +22,7 @@
 #include "itkImageSample.h"
 #include "itkVectorDataContainer.h"
 #include "itkSpatialObject.h"
+#include "itkPackedImageMask.h"
 
 namespace itk
 {
@@ -82,6 +83,8 @@ public:
   typedef typename MaskType::Pointer                        MaskPointer;
   typedef typename MaskType::ConstPointer                   MaskConstPointer;
   typedef std::vector<MaskConstPointer>                     MaskVectorType;
+  typedef PackedImageMask<Self::InputImageDimension>        PackedMaskType;
+  typedef typename PackedMaskType::ConstPointer             PackedMaskConstPointer;
   typedef std::vector<InputImageRegionType>                 InputImageRegionVectorType;
 
   /** ******************** Masks ******************** */
@@ -202,6 +205,21 @@ protected:
   virtual void
   UpdateAllMasks(void);
 
+  /** Creates a packed copy of the (first) mask, for IsInsideMask(), unless the current packed copy is still
+   * up-to-date. Should be called before sampling (and before any threads are started).
+   */
+  void
+  UpdatePackedMask(void);
+
+  /** Tells whether the point is inside the (first) mask. Uses the packed copy of the mask, when available. */
+  bool
+  IsInsideMask(const InputImagePointType & point) const
+  {
+    return (m_PackedMask.IsNotNull() && (m_PackedMask->GetSpatialObject() == m_Mask.GetPointer()))
+             ? m_PackedMask->IsInside(point)
+             : m_Mask->IsInsideInWorldSpace(point);
+  }
+
   /** Checks if the InputImageRegions are a subregion of the
    * LargestPossibleRegions.
    */
@@ -235,6 +253,7 @@ private:
 
   /** Member variables. */
   MaskConstPointer           m_Mask;
+  PackedMaskConstPointer     m_PackedMask;
   MaskVectorType             m_MaskVector;
   unsigned int               m_NumberOfMasks;
   InputImageRegionType       m_InputImageRegion;
@@ -284,6 +284,28 @@ ImageSamplerBase<TInputImage>::UpdateAllMasks(void)
 } // end UpdateAllMasks()
 
 
+/**
+ * ******************* UpdatePackedMask *******************
+ */
+
+template <class TInputImage>
+void
+ImageSamplerBase<TInputImage>::UpdatePackedMask(void)
+{
+  const MaskType * const mask = this->m_Mask.GetPointer();
+
+  if (mask == nullptr)
+  {
+    this->m_PackedMask = nullptr;
+  }
+  else if (this->m_PackedMask.IsNull() || !this->m_PackedMask->IsCreatedFrom(mask))
+  {
+    this->m_PackedMask = PackedMaskType::CreateFromSpatialObject(mask);
+  }
+
+} // end UpdatePackedMask()
+
+
 /**
  * ******************* CheckInputImageRegions *******************
  */
@@ -404,6 +426,9 @@ ImageSamplerBase<TInputImage>::BeforeThreadedGenerateData(void)
     this->m_ThreaderSampleContainer[i] = ImageSampleContainerType::New();
   }
 
+  /** The threads may use the packed mask, but should not create it. */
+  this->UpdatePackedMask();
+
 } // end BeforeThreadedGenerateData()
 
 
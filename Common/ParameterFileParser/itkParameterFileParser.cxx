@@ -20,9 +20,10 @@
 #include "elxDefaultConstructibleSubclass.h"
 
 #include <itksys/SystemTools.hxx>
-#include <itksys/RegularExpression.hxx>
 
+#include <algorithm> // For count and replace.
 #include <fstream>
+#include <utility> // For move.
 
 namespace itk
 {
@@ -146,24 +147,27 @@ ParameterFileParser::CheckLine(const std::string & lineIn, std::string & lineOut
    * 2) Remove everything after comment sign //
    * 3) Remove leading spaces
    * 4) Remove trailing spaces
+   * Plain string operations are used (rather than regular expressions),
+   * as lines may be very long, for example a list of transform parameters.
    */
   lineOut = lineIn;
-  itksys::SystemTools::ReplaceString(lineOut, "\t", " ");
+  std::replace(lineOut.begin(), lineOut.end(), '\t', ' ');
 
-  itksys::RegularExpression commentPart("//");
-  if (commentPart.find(lineOut))
+  const auto commentPos = lineOut.find("//");
+  if (commentPos != std::string::npos)
   {
-    lineOut = lineOut.substr(0, commentPart.start());
+    lineOut.erase(commentPos);
   }
 
-  itksys::RegularExpression leadingSpaces("^[ ]*(.*)");
-  leadingSpaces.find(lineOut);
-  lineOut = leadingSpaces.match(1);
-
-  itksys::RegularExpression trailingSpaces("[ \t]+$");
-  if (trailingSpaces.find(lineOut))
+  const auto firstNonSpacePos = lineOut.find_first_not_of(' ');
+  if (firstNonSpacePos == std::string::npos)
+  {
+    lineOut.clear();
+  }
+  else
   {
-    lineOut = lineOut.substr(0, trailingSpaces.start());
+    lineOut.erase(lineOut.find_last_not_of(' ') + 1);
+    lineOut.erase(0, firstNonSpacePos);
   }
 
   /**
@@ -177,17 +181,13 @@ ParameterFileParser::CheckLine(const std::string & lineIn, std::string & lineOut
    */
 
   /** 1. Check for non-empty lines. */
-  itksys::RegularExpression reNonEmptyLine("[^ ]+");
-  const bool                match1 = reNonEmptyLine.find(lineOut);
-  if (!match1)
+  if (lineOut.empty())
   {
     return false;
   }
 
   /** 2. Check for comments. */
-  itksys::RegularExpression reComment("^//");
-  const bool                match2 = reComment.find(lineOut);
-  if (match2)
+  if (itksys::SystemTools::StringStartsWith(lineOut, "//"))
   {
     return false;
   }
@@ -202,9 +202,10 @@ ParameterFileParser::CheckLine(const std::string & lineIn, std::string & lineOut
   /** Remove brackets. */
   lineOut = lineOut.substr(1, lineOut.size() - 2);
 
-  /** 4. Check: the line should contain at least two words. */
-  itksys::RegularExpression reTwoWords("([ ]+)([^ ]+)");
-  const bool                match4 = reTwoWords.find(lineOut);
+  /** 4. Check: the line should contain at least two words, so a space followed by a non-space. */
+  const auto firstSpacePos = lineOut.find(' ');
+  const bool match4 =
+    (firstSpacePos != std::string::npos) && (lineOut.find_first_not_of(' ', firstSpacePos) != std::string::npos);
   if (!match4)
   {
     const std::string hint = "Line does not contain a parameter name and value.";
@@ -248,17 +249,19 @@ ParameterFileParser::GetParameterFromLine(const std::string & fullLine, const st
 
   /** 3) Get the parameter values. */
   std::vector<std::string> parameterValues;
-  for (const auto & value : splittedLine)
+  parameterValues.reserve(splittedLine.size());
+  for (auto & value : splittedLine)
   {
     if (!value.empty())
     {
-      parameterValues.push_back(value);
+      parameterValues.push_back(std::move(value));
     }
   }
 
-  /** 4) Perform some checks on the parameter name. */
-  itksys::RegularExpression reInvalidCharacters1("[.,:;!@#$%^&-+|<>?]");
-  const bool                match = reInvalidCharacters1.find(parameterName);
+  /** 4) Perform some checks on the parameter name. Note that the characters
+   * from '&' to '+' include the quote and the round brackets.
+   */
+  const bool match = parameterName.find_first_of(".,:;!@#$%^&'()*+|<>?") != std::string::npos;
   if (match)
   {
     const std::string hint = "The parameter \"" + parameterName + "\" contains invalid characters (.,:;!@#$%^&-+|<>?).";
@@ -273,7 +276,7 @@ ParameterFileParser::GetParameterFromLine(const std::string & fullLine, const st
   }
   else
   {
-    this->m_ParameterMap.insert(make_pair(parameterName, parameterValues));
+    this->m_ParameterMap.insert(make_pair(parameterName, std::move(parameterValues)));
   }
 
 } // end GetParameterFromLine()
@@ -289,13 +292,12 @@ ParameterFileParser::SplitLine(const std::string &        fullLine,
                                std::vector<std::string> & splittedLine) const
 {
   splittedLine.clear();
-  splittedLine.resize(1);
 
   /** Count the number of quotes in the line. If it is an odd value, the
    * line contains an error; strings should start and end with a quote, so
    * the total number of quotes is even.
    */
-  std::size_t numQuotes = itksys::SystemTools::CountChar(line.c_str(), '"');
+  auto numQuotes = static_cast<std::size_t>(std::count(line.cbegin(), line.cend(), '"'));
   if (numQuotes % 2 == 1)
   {
     /** An invalid parameter line. */
@@ -303,6 +305,21 @@ ParameterFileParser::SplitLine(const std::string &        fullLine,
     this->ThrowException(fullLine, hint);
   }
 
+  if (numQuotes == 0)
+  {
+    /** Fast path, for example for a long list of numbers: just split the line at each space. */
+    std::size_t beginPos = 0;
+    for (auto spacePos = line.find(' '); spacePos != std::string::npos; spacePos = line.find(' ', beginPos))
+    {
+      splittedLine.emplace_back(line, beginPos, spacePos - beginPos);
+      beginPos = spacePos + 1;
+    }
+    splittedLine.emplace_back(line, beginPos);
+    return;
+  }
+
+  splittedLine.resize(1);
+
   /** Loop over the line. */
   unsigned int index = 0;
   numQuotes = 0;
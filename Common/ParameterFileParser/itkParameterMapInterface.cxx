@@ -18,9 +18,12 @@
 
 #include "itkParameterMapInterface.h"
 
+#include <itkMultiThreaderBase.h>
+
 #include <double-conversion.h>
 
 // Standard C++ header files:
+#include <atomic>
 #include <cmath> // For fpclassify and FP_SUBNORMAL.
 #include <limits>
 #include <type_traits> // For is_floating_point.
@@ -83,6 +86,10 @@ ParameterMapInterface::SetParameterMap(const ParameterMapType & parMap)
   if (!parMap.empty())
   {
     this->m_ParameterMap = parMap;
+
+    /** The converted values of the previous map are no longer valid. */
+    const std::lock_guard<std::mutex> lock(m_ConvertedValuesMutex);
+    m_ConvertedValues.clear();
   }
 
 } // end SetParameterMap()
@@ -104,6 +111,45 @@ ParameterMapInterface::CountNumberOfParameterEntries(const std::string & paramet
 } // end CountNumberOfParameterEntries()
 
 
+/**
+ * **************** ConvertValues ***************
+ */
+
+bool
+ParameterMapInterface::ConvertValues(const std::size_t                         numberOfValues,
+                                     const std::function<bool(std::size_t)> & convertValue)
+{
+  if (numberOfValues < MinimumNumberOfValuesForParallelConversion)
+  {
+    for (std::size_t i = 0; i < numberOfValues; ++i)
+    {
+      if (!convertValue(i))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /** A long list of values, for example the TransformParameters of a B-spline transform: convert in parallel. */
+  std::atomic<bool> success{ true };
+
+  MultiThreaderBase::New()->ParallelizeArray(
+    0,
+    numberOfValues,
+    [&convertValue, &success](const SizeValueType i) {
+      if (!convertValue(i))
+      {
+        success.store(false, std::memory_order_relaxed);
+      }
+    },
+    nullptr);
+
+  return success.load();
+
+} // end ConvertValues()
+
+
 /**
  * **************** ReadParameter ***************
  */
@@ -26,10 +26,15 @@
 
 #include "itkParameterFileParser.h"
 
-#include <algorithm> // For count.
+#include <algorithm> // For count and copy_n.
+#include <functional> // For function.
 #include <iostream>
-#include <memory>      // For unique_ptr.
+#include <map>
+#include <memory> // For unique_ptr and shared_ptr.
+#include <mutex>
 #include <type_traits> // For is_same.
+#include <typeindex>
+#include <utility> // For pair.
 
 namespace itk
 {
@@ -70,6 +75,14 @@ namespace itk
  * Note that some of the templated functions are defined in the header to
  * get it compiling on some platforms.
  *
+ * The values of a parameter are converted to a numeric type only once: the
+ * first time a value of a parameter is requested as a particular numeric type,
+ * all of its values are converted (in parallel, in case of a long list of
+ * values, like the TransformParameters of a B-spline transform), and stored in
+ * a cache. Subsequent requests for the same parameter and type (for example,
+ * at each resolution, or for each entry of a list) are served from the cache.
+ * The cache is cleared by SetParameterMap.
+ *
  * \sa itk::ParameterFileParser
  */
 
@@ -174,6 +187,14 @@ public:
       return false;
     }
 
+    /** Try to get the value from the cache of converted values. */
+    const auto convertedValues = this->GetConvertedValues<T>(parameterName);
+    if (convertedValues != nullptr)
+    {
+      parameterValue = (*convertedValues)[entry_nr];
+      return true;
+    }
+
     /** Cast the string to type T. */
     bool castSuccesful = Self::StringCast(vec[entry_nr], parameterValue);
 
@@ -338,6 +359,15 @@ public:
       itk::NumericTraits<T>::ZeroValue() );
     */
 
+    /** Try to get all parameters at once from the cache of converted values. */
+    const auto convertedValues = this->GetConvertedValues<T>(parameterName);
+    if (convertedValues != nullptr)
+    {
+      std::copy_n(
+        convertedValues->cbegin() + entry_nr_start, entry_nr_end - entry_nr_start + 1, parameterValues.begin());
+      return true;
+    }
+
     /** Get all parameters at once. */
     unsigned int j = 0;
     for (unsigned int i = entry_nr_start; i < entry_nr_end + 1; ++i)
@@ -393,6 +423,13 @@ public:
     {
       return nullptr;
     }
+
+    const auto convertedValues = this->GetConvertedValues<T>(parameterName);
+    if (convertedValues != nullptr)
+    {
+      return std::make_unique<std::vector<T>>(*convertedValues);
+    }
+
     std::vector<T> result;
     result.reserve(found->second.size());
 
@@ -424,11 +461,86 @@ private:
   void
   operator=(const Self &) = delete;
 
+  /** The minimum number of values of a parameter for which the values are converted in parallel. */
+  static constexpr std::size_t MinimumNumberOfValuesForParallelConversion = 4096;
+
+  /** Key and value types of the cache of converted values. The cached value is either a pointer to an
+   * std::vector<T> (with T specified by the type index of the key), or null, when at least one of the values of the
+   * parameter could not be converted to T. */
+  typedef std::pair<std::string, std::type_index>                  ConvertedValuesKeyType;
+  typedef std::shared_ptr<const void>                              ConvertedValuesPointer;
+  typedef std::map<ConvertedValuesKeyType, ConvertedValuesPointer> ConvertedValuesMapType;
+
   /** Member variable to store the parameters. */
   ParameterMapType m_ParameterMap;
 
   bool m_PrintErrorMessages{ true };
 
+  /** The cache of converted values, and the mutex that protects it, as it may be filled by const member functions. */
+  mutable ConvertedValuesMapType m_ConvertedValues;
+  mutable std::mutex             m_ConvertedValuesMutex;
+
+  /** Returns all values of the specified parameter, converted to the numeric type T, from the cache of converted
+   * values (converting and caching them, if they are not yet in the cache). Returns null when the parameter does not
+   * exist, when T is not a numeric type, or when at least one of the values cannot be converted. In that case the
+   * caller should fall back to converting the requested values one by one, to report the appropriate error.
+   */
+  template <typename T>
+  const std::vector<T> *
+  GetConvertedValues(const std::string & parameterName) const
+  {
+    using IsNumericType = std::integral_constant<bool, std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>;
+    return this->GetConvertedValues<T>(parameterName, IsNumericType{});
+  }
+
+
+  template <typename T>
+  const std::vector<T> *
+  GetConvertedValues(const std::string &, std::false_type) const
+  {
+    return nullptr;
+  }
+
+
+  template <typename T>
+  const std::vector<T> *
+  GetConvertedValues(const std::string & parameterName, std::true_type) const
+  {
+    const auto found = m_ParameterMap.find(parameterName);
+    if (found == m_ParameterMap.end())
+    {
+      return nullptr;
+    }
+
+    const std::lock_guard<std::mutex> lock(m_ConvertedValuesMutex);
+
+    const auto insertResult =
+      m_ConvertedValues.insert({ ConvertedValuesKeyType(parameterName, std::type_index(typeid(T))), nullptr });
+    ConvertedValuesPointer & cachedValues = insertResult.first->second;
+
+    if (insertResult.second)
+    {
+      /** Not yet in the cache: convert all values now. */
+      const ParameterValuesType & strings = found->second;
+      const auto                  values = std::make_shared<std::vector<T>>(strings.size());
+
+      if (Self::ConvertValues(strings.size(), [&strings, &values](const std::size_t i) {
+            return Self::StringCast(strings[i], (*values)[i]);
+          }))
+      {
+        cachedValues = values;
+      }
+    }
+    return static_cast<const std::vector<T> *>(cachedValues.get());
+  }
+
+
+  /** Calls convertValue(i) for each index i from 0 to numberOfValues, in parallel when the number of values is at
+   * least MinimumNumberOfValuesForParallelConversion. Returns true when all calls returned true.
+   */
+  static bool
+  ConvertValues(const std::size_t numberOfValues, const std::function<bool(std::size_t)> & convertValue);
+
   /** A templated function to cast strings to a type T.
    * Returns true when casting was successful and false otherwise.
    * We make use of the casting functionality of string streams.
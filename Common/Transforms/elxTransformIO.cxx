@@ -32,7 +32,10 @@
 #include <itkTransformFileReader.h>
 #include <itkTransformFileWriter.h>
 
+#include <algorithm> // For copy_n.
+#include <fstream>
 #include <string>
+#include <vector>
 
 
 std::string
@@ -161,6 +164,97 @@ elastix::TransformIO::Read(const std::string & fileName)
 }
 
 
+void
+elastix::TransformIO::WriteParametersToBinaryFile(const itk::OptimizerParameters<double> & parameters,
+                                                  const std::string &                      fileName,
+                                                  const std::string &                      valueType)
+{
+  std::ofstream outputFileStream(fileName, std::ios::binary);
+
+  if (!outputFileStream.is_open())
+  {
+    itkGenericExceptionMacro(<< "Failed to open binary transform parameters file \"" << fileName << "\" for writing.");
+  }
+
+  const auto numberOfParameters = parameters.GetSize();
+
+  if (valueType == "double")
+  {
+    outputFileStream.write(reinterpret_cast<const char *>(parameters.data_block()),
+                           static_cast<std::streamsize>(numberOfParameters * sizeof(double)));
+  }
+  else if (valueType == "float")
+  {
+    const std::vector<float> values(parameters.begin(), parameters.end());
+    outputFileStream.write(reinterpret_cast<const char *>(values.data()),
+                           static_cast<std::streamsize>(numberOfParameters * sizeof(float)));
+  }
+  else
+  {
+    itkGenericExceptionMacro(<< "Unsupported value type for binary transform parameters: \"" << valueType
+                             << "\". Supported types are \"double\" and \"float\".");
+  }
+
+  if (!outputFileStream)
+  {
+    itkGenericExceptionMacro(<< "Failed to write binary transform parameters file \"" << fileName << "\".");
+  }
+}
+
+
+itk::OptimizerParameters<double>
+elastix::TransformIO::ReadParametersFromBinaryFile(const std::string & fileName,
+                                                   const std::string & valueType,
+                                                   const std::size_t   numberOfParameters)
+{
+  const std::size_t valueSize = (valueType == "double") ? sizeof(double) : (valueType == "float") ? sizeof(float) : 0;
+
+  if (valueSize == 0)
+  {
+    itkGenericExceptionMacro(<< "Unsupported value type for binary transform parameters: \"" << valueType
+                             << "\". Supported types are \"double\" and \"float\".");
+  }
+
+  std::ifstream inputFileStream(fileName, std::ios::binary | std::ios::ate);
+
+  if (!inputFileStream.is_open())
+  {
+    itkGenericExceptionMacro(<< "Failed to open binary transform parameters file \"" << fileName << "\".");
+  }
+
+  const auto fileSize = static_cast<std::size_t>(inputFileStream.tellg());
+
+  if (fileSize != numberOfParameters * valueSize)
+  {
+    itkGenericExceptionMacro(<< "The size of binary transform parameters file \"" << fileName << "\" (" << fileSize
+                             << " bytes) does not match the number of parameters (" << numberOfParameters
+                             << ") of type \"" << valueType << "\".");
+  }
+
+  inputFileStream.seekg(0);
+
+  itk::OptimizerParameters<double> parameters(numberOfParameters);
+
+  if (valueSize == sizeof(double))
+  {
+    /** Read directly into the parameters, avoiding an extra copy. */
+    inputFileStream.read(reinterpret_cast<char *>(parameters.data_block()), static_cast<std::streamsize>(fileSize));
+  }
+  else
+  {
+    std::vector<float> values(numberOfParameters);
+    inputFileStream.read(reinterpret_cast<char *>(values.data()), static_cast<std::streamsize>(fileSize));
+    std::copy_n(values.cbegin(), numberOfParameters, parameters.begin());
+  }
+
+  if (!inputFileStream)
+  {
+    itkGenericExceptionMacro(<< "Failed to read binary transform parameters file \"" << fileName << "\".");
+  }
+  return parameters;
+}
+
+
 std::string
 elastix::TransformIO::MakeDeformationFieldFileName(Configuration &     configuration,
                                                    const std::string & transformParameterFileName)
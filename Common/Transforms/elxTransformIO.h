@@ -25,6 +25,7 @@
 #include <itkTransformBase.h>
 
 #include <cassert>
+#include <cstddef> // For size_t.
 #include <string>
 
 namespace elastix
@@ -104,6 +105,20 @@ public:
   static itk::TransformBase::Pointer
   Read(const std::string & fileName);
 
+  /// Writes the specified parameters to a binary file, as raw values of the specified value type ("double" or
+  /// "float"), in the native byte order, without any header. Throws an exception when the file cannot be written.
+  static void
+  WriteParametersToBinaryFile(const itk::OptimizerParameters<double> & parameters,
+                              const std::string &                      fileName,
+                              const std::string &                      valueType);
+
+  /// Reads the specified number of parameters from a binary file, as written by WriteParametersToBinaryFile. Throws an
+  /// exception when the file cannot be read, or when its size does not match the number of parameters.
+  static itk::OptimizerParameters<double>
+  ReadParametersFromBinaryFile(const std::string & fileName,
+                               const std::string & valueType,
+                               const std::size_t   numberOfParameters);
+
   /// Makes the deformation field file name, as used by BSplineTransformWithDiffusion and DeformationFieldTransform.
   template <typename TElastixTransform>
   static std::string
@@ -20,6 +20,10 @@
 
 #include "itkAdvancedTransform.h"
 #include "itkMacro.h"
+#include "itkTimeStamp.h"
+
+#include <unordered_map>
+#include <vector>
 
 namespace itk
 {
@@ -49,6 +53,11 @@ namespace itk
  * Note: It is mandatory to set a current transform. An initial transform
  * is not mandatory.
  *
+ * When composition is used and the transform is evaluated repeatedly at the
+ * same set of points, the mapped points and spatial Jacobians of the initial
+ * transform at these points can be cached, using CacheInitialTransform().
+ * Only the current transform then needs to be evaluated at these points.
+ *
  * \ingroup Transforms
  */
 
@@ -156,6 +165,46 @@ public:
 
   itkGetConstMacro(UseAddition, bool);
 
+  /** Cache the mapped point and the spatial Jacobian of the initial transform
+   * at each of the specified points, in addition to the points that are cached
+   * already. Whenever the transform is subsequently evaluated at exactly one of
+   * these points, the cached values are used, instead of evaluating the initial
+   * transform again. So multiple users of this transform (for example the
+   * metrics of a multi-metric registration) may each cache their own points.
+   * The cache is only used for composition. It is keyed on the modification
+   * time of the initial transform: it is discarded when the initial transform
+   * is modified or replaced, or when the combination method is changed. It is
+   * also discarded when the number of cached points would otherwise exceed
+   * MaximumNumberOfCachedInitialTransformPoints.
+   */
+  void
+  CacheInitialTransform(const std::vector<InputPointType> & points);
+
+  /** Remove all points from the initial transform cache. */
+  void
+  ClearInitialTransformCache(void);
+
+  /** Return the number of points in the initial transform cache. */
+  SizeValueType
+  GetNumberOfCachedInitialTransformPoints(void) const
+  {
+    return this->IsInitialTransformCacheUpToDate() ? static_cast<SizeValueType>(this->m_InitialTransformCache.size())
+                                                   : 0;
+  }
+
+  /** Return the time at which the initial transform cache was last discarded. A user of the cache that compares
+   * this time to the time at which it cached its points can tell whether its points are still in the cache.
+   */
+  ModifiedTimeType
+  GetInitialTransformCacheMTime(void) const
+  {
+    return this->m_InitialTransformCacheTimeStamp.GetMTime();
+  }
+
+  /** Set/Get the maximum number of points in the initial transform cache. */
+  itkSetMacro(MaximumNumberOfCachedInitialTransformPoints, SizeValueType);
+  itkGetConstMacro(MaximumNumberOfCachedInitialTransformPoints, SizeValueType);
+
   /**  Method to transform a point. */
   OutputPointType
   TransformPoint(const InputPointType & point) const override;
@@ -314,6 +363,16 @@ protected:
   void
   UpdateCombinationMethod(void);
 
+  /** Compute \f$T_0(x)\f$, from the initial transform cache if possible. */
+  inline OutputPointType
+  TransformPointInitialTransform(const InputPointType & point) const;
+
+  /** Compute \f$T_0(x)\f$ and its spatial Jacobian, from the initial transform cache if possible. */
+  inline void
+  GetInitialTransformPointAndSpatialJacobian(const InputPointType & ipp,
+                                             OutputPointType &      opp,
+                                             SpatialJacobianType &  sj) const;
+
   /** ************************************************
    * Methods to transform a point.
    */
@@ -552,6 +611,48 @@ private:
   InitialTransformPointer m_InitialTransform{ nullptr };
   CurrentTransformPointer m_CurrentTransform{ nullptr };
 
+  /** The cached values of the initial transform at a single point. */
+  struct InitialTransformCacheValueType
+  {
+    OutputPointType     m_MappedPoint;
+    SpatialJacobianType m_SpatialJacobian;
+  };
+
+  /** Hash function for the points in the initial transform cache. */
+  struct InitialTransformCacheHashType
+  {
+    std::size_t
+    operator()(const InputPointType & point) const
+    {
+      std::size_t seed = 0;
+      for (unsigned int i = 0; i < SpaceDimension; ++i)
+      {
+        seed ^= std::hash<ScalarType>()(point[i]) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+      }
+      return seed;
+    }
+  };
+
+  typedef std::unordered_map<InputPointType, InitialTransformCacheValueType, InitialTransformCacheHashType>
+    InitialTransformCacheType;
+
+  /** Tells whether the initial transform cache is still valid for the current initial transform. */
+  bool
+  IsInitialTransformCacheUpToDate(void) const
+  {
+    return !this->m_InitialTransformCache.empty() && this->m_InitialTransform.IsNotNull() &&
+           this->m_InitialTransform->GetMTime() == this->m_InitialTransformMTimeOfCache;
+  }
+
+  /** The initial transform cache. The spatial Jacobians are only valid when
+   * the initial transform was able to compute them.
+   */
+  InitialTransformCacheType m_InitialTransformCache;
+  bool                      m_InitialTransformCacheHasSpatialJacobian{ false };
+  ModifiedTimeType          m_InitialTransformMTimeOfCache{ 0 };
+  TimeStamp                 m_InitialTransformCacheTimeStamp;
+  SizeValueType             m_MaximumNumberOfCachedInitialTransformPoints{ 1048576 };
+
   /** Typedefs for function pointers. */
   typedef OutputPointType (Self::*TransformPointFunctionPointer)(const InputPointType &) const;
   typedef void (Self::*GetSparseJacobianFunctionPointer)(const InputPointType &,
@@ -539,6 +539,126 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::SetUseComposition(bool _
 } // end SetUseComposition()
 
 
+/**
+ * ****************** CacheInitialTransform ********************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+void
+AdvancedCombinationTransform<TScalarType, NDimensions>::CacheInitialTransform(
+  const std::vector<InputPointType> & points)
+{
+  /** The cache is only used when the initial transform is composed with the current transform. */
+  if (this->m_InitialTransform.IsNull() || this->m_CurrentTransform.IsNull() || !this->m_UseComposition)
+  {
+    this->ClearInitialTransformCache();
+    return;
+  }
+
+  /** Start a new cache when the initial transform has been modified since the cache was filled, or when the
+   * cache would become too large. Otherwise the points are added to the points that are already cached.
+   */
+  if (!this->IsInitialTransformCacheUpToDate() ||
+      this->m_InitialTransformCache.size() + points.size() > this->m_MaximumNumberOfCachedInitialTransformPoints)
+  {
+    this->ClearInitialTransformCache();
+    this->m_InitialTransformMTimeOfCache = this->m_InitialTransform->GetMTime();
+  }
+
+  /** Not every initial transform implements the spatial Jacobian. In that case
+   * only the mapped points are cached.
+   */
+  this->m_InitialTransformCache.reserve(this->m_InitialTransformCache.size() + points.size());
+  for (const auto & point : points)
+  {
+    if (this->m_InitialTransformCache.count(point) > 0)
+    {
+      continue;
+    }
+
+    InitialTransformCacheValueType value;
+    value.m_MappedPoint = this->m_InitialTransform->TransformPoint(point);
+    if (this->m_InitialTransformCacheHasSpatialJacobian)
+    {
+      try
+      {
+        this->m_InitialTransform->GetSpatialJacobian(point, value.m_SpatialJacobian);
+      }
+      catch (const ExceptionObject &)
+      {
+        this->m_InitialTransformCacheHasSpatialJacobian = false;
+      }
+    }
+    this->m_InitialTransformCache.emplace(point, value);
+  }
+
+} // end CacheInitialTransform()
+
+
+/**
+ * ****************** ClearInitialTransformCache ********************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+void
+AdvancedCombinationTransform<TScalarType, NDimensions>::ClearInitialTransformCache(void)
+{
+  this->m_InitialTransformCache.clear();
+  this->m_InitialTransformCacheHasSpatialJacobian = true;
+  this->m_InitialTransformCacheTimeStamp.Modified();
+
+} // end ClearInitialTransformCache()
+
+
+/**
+ * ****************** TransformPointInitialTransform ********************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+auto
+AdvancedCombinationTransform<TScalarType, NDimensions>::TransformPointInitialTransform(
+  const InputPointType & point) const -> OutputPointType
+{
+  if (this->IsInitialTransformCacheUpToDate())
+  {
+    const auto found = this->m_InitialTransformCache.find(point);
+    if (found != this->m_InitialTransformCache.end())
+    {
+      return found->second.m_MappedPoint;
+    }
+  }
+  return this->m_InitialTransform->TransformPoint(point);
+
+} // end TransformPointInitialTransform()
+
+
+/**
+ * ****************** GetInitialTransformPointAndSpatialJacobian ********************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+void
+AdvancedCombinationTransform<TScalarType, NDimensions>::GetInitialTransformPointAndSpatialJacobian(
+  const InputPointType & ipp,
+  OutputPointType &      opp,
+  SpatialJacobianType &  sj) const
+{
+  if (this->m_InitialTransformCacheHasSpatialJacobian && this->IsInitialTransformCacheUpToDate())
+  {
+    const auto found = this->m_InitialTransformCache.find(ipp);
+    if (found != this->m_InitialTransformCache.end())
+    {
+      opp = found->second.m_MappedPoint;
+      sj = found->second.m_SpatialJacobian;
+      return;
+    }
+  }
+  this->m_InitialTransform->GetSpatialJacobian(ipp, sj);
+  opp = this->m_InitialTransform->TransformPoint(ipp);
+
+} // end GetInitialTransformPointAndSpatialJacobian()
+
+
 /**
  * ****************** UpdateCombinationMethod ********************
  */
@@ -547,6 +667,9 @@ template <typename TScalarType, unsigned int NDimensions>
 void
 AdvancedCombinationTransform<TScalarType, NDimensions>::UpdateCombinationMethod(void)
 {
+  /** The cached values of the initial transform may not be valid anymore. */
+  this->ClearInitialTransformCache();
+
   /** Update the m_SelectedTransformPointFunction and
    * the m_SelectedGetJacobianFunction
    */
@@ -670,7 +793,7 @@ auto
 AdvancedCombinationTransform<TScalarType, NDimensions>::TransformPointUseComposition(const InputPointType & point) const
   -> OutputPointType
 {
-  return this->m_CurrentTransform->TransformPoint(this->m_InitialTransform->TransformPoint(point));
+  return this->m_CurrentTransform->TransformPoint(this->TransformPointInitialTransform(point));
 
 } // end TransformPointUseComposition()
 
@@ -731,7 +854,7 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::GetJacobianUseCompositio
   JacobianType &               j,
   NonZeroJacobianIndicesType & nonZeroJacobianIndices) const
 {
-  this->m_CurrentTransform->GetJacobian(this->m_InitialTransform->TransformPoint(ipp), j, nonZeroJacobianIndices);
+  this->m_CurrentTransform->GetJacobian(this->TransformPointInitialTransform(ipp), j, nonZeroJacobianIndices);
 
 } // end GetJacobianUseComposition()
 
@@ -800,7 +923,7 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::EvaluateJacobianWithImag
   NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const
 {
   this->m_CurrentTransform->EvaluateJacobianWithImageGradientProduct(
-    this->m_InitialTransform->TransformPoint(ipp), movingImageGradient, imageJacobian, nonZeroJacobianIndices);
+    this->TransformPointInitialTransform(ipp), movingImageGradient, imageJacobian, nonZeroJacobianIndices);
 
 } // end EvaluateJacobianWithImageGradientProductUseComposition()
 
@@ -869,8 +992,9 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::GetSpatialJacobianUseCom
                                                                                          SpatialJacobianType & sj) const
 {
   SpatialJacobianType sj0, sj1;
-  this->m_InitialTransform->GetSpatialJacobian(ipp, sj0);
-  this->m_CurrentTransform->GetSpatialJacobian(this->m_InitialTransform->TransformPoint(ipp), sj1);
+  OutputPointType     opp0;
+  this->GetInitialTransformPointAndSpatialJacobian(ipp, opp0, sj0);
+  this->m_CurrentTransform->GetSpatialJacobian(opp0, sj1);
 
   sj = sj1 * sj0;
 
@@ -1048,9 +1172,9 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::GetJacobianOfSpatialJaco
 {
   SpatialJacobianType           sj0;
   JacobianOfSpatialJacobianType jsj1;
-  this->m_InitialTransform->GetSpatialJacobian(ipp, sj0);
-  this->m_CurrentTransform->GetJacobianOfSpatialJacobian(
-    this->m_InitialTransform->TransformPoint(ipp), jsj1, nonZeroJacobianIndices);
+  OutputPointType               opp0;
+  this->GetInitialTransformPointAndSpatialJacobian(ipp, opp0, sj0);
+  this->m_CurrentTransform->GetJacobianOfSpatialJacobian(opp0, jsj1, nonZeroJacobianIndices);
 
   jsj.resize(nonZeroJacobianIndices.size());
   for (unsigned int mu = 0; mu < nonZeroJacobianIndices.size(); ++mu)
@@ -1075,9 +1199,9 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::GetJacobianOfSpatialJaco
 {
   SpatialJacobianType           sj0, sj1;
   JacobianOfSpatialJacobianType jsj1;
-  this->m_InitialTransform->GetSpatialJacobian(ipp, sj0);
-  this->m_CurrentTransform->GetJacobianOfSpatialJacobian(
-    this->m_InitialTransform->TransformPoint(ipp), sj1, jsj1, nonZeroJacobianIndices);
+  OutputPointType               opp0;
+  this->GetInitialTransformPointAndSpatialJacobian(ipp, opp0, sj0);
+  this->m_CurrentTransform->GetJacobianOfSpatialJacobian(opp0, sj1, jsj1, nonZeroJacobianIndices);
 
   sj = sj1 * sj0;
   jsj.resize(nonZeroJacobianIndices.size());
@@ -0,0 +1,127 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkFlattenedTransform_h
+#define itkFlattenedTransform_h
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkImage.h"
+
+namespace itk
+{
+/** \class FlattenedTransform
+ * \brief A first-order B-spline transform that approximates another (typically expensive) transform.
+ *
+ * The coefficients of the B-spline are the displacements of the original transform, sampled at the
+ * nodes of a grid. Inside the valid region of the grid, a point is transformed by linear interpolation
+ * of these displacements. Outside the valid region, the original transform (the "fallback transform")
+ * is evaluated, so that points outside the sampled domain are mapped exactly as before.
+ *
+ * The grid is typically an image grid, possibly coarsened by an integer factor, to limit memory usage.
+ *
+ * \ingroup Transforms
+ */
+
+template <class TScalarType = double, unsigned int NDimensions = 3>
+class ITK_TEMPLATE_EXPORT FlattenedTransform : public AdvancedBSplineDeformableTransform<TScalarType, NDimensions, 1>
+{
+public:
+  /** Standard class typedefs. */
+  typedef FlattenedTransform                                              Self;
+  typedef AdvancedBSplineDeformableTransform<TScalarType, NDimensions, 1> Superclass;
+  typedef SmartPointer<Self>                                              Pointer;
+  typedef SmartPointer<const Self>                                        ConstPointer;
+
+  /** New macro for creation of through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(FlattenedTransform, AdvancedBSplineDeformableTransform);
+
+  /** Dimension of the domain space. */
+  itkStaticConstMacro(SpaceDimension, unsigned int, NDimensions);
+
+  /** Typedefs from the Superclass. */
+  using typename Superclass::ScalarType;
+  using typename Superclass::ParametersType;
+  using typename Superclass::InputPointType;
+  using typename Superclass::OutputPointType;
+  using typename Superclass::SpatialJacobianType;
+  using typename Superclass::SpatialHessianType;
+  using typename Superclass::ContinuousIndexType;
+
+  /** The type of the transform that is flattened, and evaluated outside the grid. */
+  typedef AdvancedTransform<TScalarType, NDimensions, NDimensions> FallbackTransformType;
+  typedef typename FallbackTransformType::ConstPointer             FallbackTransformConstPointer;
+
+  /** Typedefs for the sampled displacements. */
+  typedef Vector<TScalarType, NDimensions>        DisplacementType;
+  typedef Image<DisplacementType, NDimensions>    DisplacementFieldType;
+  typedef typename DisplacementFieldType::Pointer DisplacementFieldPointer;
+  typedef ImageBase<NDimensions>                  GridType;
+
+  /** Set/Get the transform that is evaluated outside the valid region of the grid. */
+  itkSetConstObjectMacro(FallbackTransform, FallbackTransformType);
+  itkGetConstObjectMacro(FallbackTransform, FallbackTransformType);
+
+  /** Samples the specified transform at the nodes of the specified grid, coarsened by the specified integer factor,
+   * and extended by one node on each side. The coarsened grid covers the whole domain of the original grid.
+   */
+  static DisplacementFieldPointer
+  SampleDisplacementField(const FallbackTransformType & transform,
+                          const GridType &              grid,
+                          const unsigned int            gridSpacingFactor = 1);
+
+  /** Sets the grid and the coefficients of this transform, which are the displacements of the specified field. */
+  void
+  SetDisplacementField(const DisplacementFieldType & field);
+
+  /** Transform a point. Outside the valid region, the fallback transform is used (when there is one). */
+  OutputPointType
+  TransformPoint(const InputPointType & point) const override;
+
+  /** Compute the spatial Jacobian. Outside the valid region, the fallback transform is used (when there is one). */
+  void
+  GetSpatialJacobian(const InputPointType & ipp, SpatialJacobianType & sj) const override;
+
+  /** Compute the spatial Hessian. Outside the valid region, the fallback transform is used (when there is one). */
+  void
+  GetSpatialHessian(const InputPointType & ipp, SpatialHessianType & sh) const override;
+
+protected:
+  FlattenedTransform() = default;
+  ~FlattenedTransform() override = default;
+
+  /** Print contents of a FlattenedTransform. */
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  /** Tells whether the specified point should be passed to the fallback transform. */
+  bool
+  IsHandledByFallbackTransform(const InputPointType & point) const;
+
+  FallbackTransformConstPointer m_FallbackTransform;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkFlattenedTransform.hxx"
+#endif
+
+#endif /* itkFlattenedTransform_h */
@@ -0,0 +1,217 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkFlattenedTransform_hxx
+#define itkFlattenedTransform_hxx
+
+#include "itkFlattenedTransform.h"
+
+#include "itkImageRegionConstIterator.h"
+#include "itkTransformToDisplacementFieldFilter.h"
+
+#include <algorithm> // For max.
+
+namespace itk
+{
+
+/**
+ * ******************* SampleDisplacementField ******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+auto
+FlattenedTransform<TScalarType, NDimensions>::SampleDisplacementField(const FallbackTransformType & transform,
+                                                                      const GridType &              grid,
+                                                                      const unsigned int            gridSpacingFactor)
+  -> DisplacementFieldPointer
+{
+  typedef TransformToDisplacementFieldFilter<DisplacementFieldType, TScalarType> FieldGeneratorType;
+  typedef typename GridType::IndexType                                           GridIndexType;
+  typedef typename GridType::SizeType                                            GridSizeType;
+  typedef typename GridType::SpacingType                                         GridSpacingType;
+  typedef typename GridType::PointType                                           GridPointType;
+
+  if (gridSpacingFactor == 0)
+  {
+    itkGenericExceptionMacro(<< "The grid spacing factor should be at least 1.");
+  }
+
+  /** The coarsened grid has one node per gridSpacingFactor voxels, and its last node lies at or beyond the
+   * last voxel of the grid. It is extended by one node on each side, such that every point of the grid
+   * domain lies inside the valid region of the first-order B-spline.
+   */
+  const auto      region = grid.GetLargestPossibleRegion();
+  GridIndexType   gridStart = region.GetIndex();
+  GridSizeType    gridSize;
+  GridSpacingType gridSpacing = grid.GetSpacing();
+  for (unsigned int i = 0; i < NDimensions; ++i)
+  {
+    const SizeValueType numberOfVoxels = std::max<SizeValueType>(region.GetSize(i), 1);
+    gridSize[i] = (numberOfVoxels - 1 + gridSpacingFactor - 1) / gridSpacingFactor + 1 + 2;
+    gridSpacing[i] *= gridSpacingFactor;
+  }
+
+  /** The origin of the coarsened grid is one coarse node before the first voxel. */
+  for (unsigned int i = 0; i < NDimensions; ++i)
+  {
+    gridStart[i] -= static_cast<IndexValueType>(gridSpacingFactor);
+  }
+  GridPointType gridOrigin;
+  grid.TransformIndexToPhysicalPoint(gridStart, gridOrigin);
+
+  const auto fieldGenerator = FieldGeneratorType::New();
+  fieldGenerator->SetSize(gridSize);
+  fieldGenerator->SetOutputOrigin(gridOrigin);
+  fieldGenerator->SetOutputSpacing(gridSpacing);
+  fieldGenerator->SetOutputDirection(grid.GetDirection());
+  fieldGenerator->SetTransform(&transform);
+  fieldGenerator->Update();
+
+  const DisplacementFieldPointer field = fieldGenerator->GetOutput();
+  field->DisconnectPipeline();
+  return field;
+
+} // end SampleDisplacementField()
+
+
+/**
+ * ******************* SetDisplacementField ******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+FlattenedTransform<TScalarType, NDimensions>::SetDisplacementField(const DisplacementFieldType & field)
+{
+  /** The coefficients of a first-order B-spline are the displacements at the
+   * grid nodes, stored per dimension in the order of the grid region.
+   */
+  const auto        gridRegion = field.GetLargestPossibleRegion();
+  const std::size_t numberOfNodes = gridRegion.GetNumberOfPixels();
+  ParametersType    parameters(numberOfNodes * NDimensions);
+
+  ImageRegionConstIterator<DisplacementFieldType> it(&field, gridRegion);
+  for (std::size_t n = 0; !it.IsAtEnd(); ++it, ++n)
+  {
+    const DisplacementType & displacement = it.Value();
+    for (unsigned int i = 0; i < NDimensions; ++i)
+    {
+      parameters[n + i * numberOfNodes] = displacement[i];
+    }
+  }
+
+  this->SetGridOrigin(field.GetOrigin());
+  this->SetGridSpacing(field.GetSpacing());
+  this->SetGridDirection(field.GetDirection());
+  this->SetGridRegion(gridRegion);
+  this->SetParametersByValue(parameters);
+
+} // end SetDisplacementField()
+
+
+/**
+ * ******************* IsHandledByFallbackTransform ******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+bool
+FlattenedTransform<TScalarType, NDimensions>::IsHandledByFallbackTransform(const InputPointType & point) const
+{
+  if (this->m_FallbackTransform.IsNull())
+  {
+    return false;
+  }
+
+  ContinuousIndexType cindex;
+  this->TransformPointToContinuousGridIndex(point, cindex);
+  return !this->InsideValidRegion(cindex);
+
+} // end IsHandledByFallbackTransform()
+
+
+/**
+ * ******************* TransformPoint ******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+auto
+FlattenedTransform<TScalarType, NDimensions>::TransformPoint(const InputPointType & point) const -> OutputPointType
+{
+  if (this->IsHandledByFallbackTransform(point))
+  {
+    return this->m_FallbackTransform->TransformPoint(point);
+  }
+  return Superclass::TransformPoint(point);
+
+} // end TransformPoint()
+
+
+/**
+ * ******************* GetSpatialJacobian ******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+FlattenedTransform<TScalarType, NDimensions>::GetSpatialJacobian(const InputPointType & ipp,
+                                                                 SpatialJacobianType &  sj) const
+{
+  if (this->IsHandledByFallbackTransform(ipp))
+  {
+    this->m_FallbackTransform->GetSpatialJacobian(ipp, sj);
+    return;
+  }
+  Superclass::GetSpatialJacobian(ipp, sj);
+
+} // end GetSpatialJacobian()
+
+
+/**
+ * ******************* GetSpatialHessian ******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+FlattenedTransform<TScalarType, NDimensions>::GetSpatialHessian(const InputPointType & ipp,
+                                                                SpatialHessianType &   sh) const
+{
+  if (this->IsHandledByFallbackTransform(ipp))
+  {
+    this->m_FallbackTransform->GetSpatialHessian(ipp, sh);
+    return;
+  }
+  Superclass::GetSpatialHessian(ipp, sh);
+
+} // end GetSpatialHessian()
+
+
+/**
+ * ******************* PrintSelf ******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+FlattenedTransform<TScalarType, NDimensions>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FallbackTransform: " << this->m_FallbackTransform.GetPointer() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef itkFlattenedTransform_hxx
@@ -21,6 +21,8 @@
 #include "itkAdvancedTransform.h"
 #include "itkIndex.h"
 
+#include <algorithm> // For min and max.
+
 namespace itk
 {
 
@@ -208,6 +210,18 @@ public:
   NumberOfParametersType
   GetNumberOfNonZeroJacobianIndices(void) const override;
 
+  /** Return the index of the sub transform that is used for the specified point,
+   * which is determined by the last coordinate of the point.
+   */
+  unsigned int
+  GetSubTransformIndex(const InputPointType & ipp) const
+  {
+    return std::min(
+      static_cast<unsigned int>(this->m_SubTransformContainer.size() - 1),
+      static_cast<unsigned int>(
+        std::max(0, vnl_math::rnd((ipp[ReducedInputSpaceDimension] - m_StackOrigin) / m_StackSpacing))));
+  }
+
 protected:
   StackTransform();
   ~StackTransform() override = default;
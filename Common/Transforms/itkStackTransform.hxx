@@ -105,12 +105,8 @@ StackTransform<TScalarType, NInputDimensions, NOutputDimensions>::TransformPoint
   }
 
   /** Transform point using right subtransform. */
-  SubTransformOutputPointType oppr;
-  const unsigned int          subt =
-    std::min(static_cast<unsigned int>(this->m_SubTransformContainer.size() - 1),
-             static_cast<unsigned int>(
-               std::max(0, vnl_math::rnd((ipp[ReducedInputSpaceDimension] - m_StackOrigin) / m_StackSpacing))));
-  oppr = this->m_SubTransformContainer[subt]->TransformPoint(ippr);
+  const SubTransformOutputPointType oppr =
+    this->m_SubTransformContainer[this->GetSubTransformIndex(ipp)]->TransformPoint(ippr);
 
   /** Increase dimension of input point. */
   OutputPointType opp;
@@ -143,10 +139,7 @@ StackTransform<TScalarType, NInputDimensions, NOutputDimensions>::GetJacobian(co
   }
 
   /** Get Jacobian from right subtransform. */
-  const unsigned int subt =
-    std::min(static_cast<unsigned int>(this->m_SubTransformContainer.size() - 1),
-             static_cast<unsigned int>(
-               std::max(0, vnl_math::rnd((ipp[ReducedInputSpaceDimension] - m_StackOrigin) / m_StackSpacing))));
+  const unsigned int       subt = this->GetSubTransformIndex(ipp);
   SubTransformJacobianType subjac;
   this->m_SubTransformContainer[subt]->GetJacobian(ippr, subjac, nzji);
 
@@ -48,6 +48,13 @@ namespace itk
  * image and uses bilinear interpolation to integrate each plane of
  * voxels traversed.
  *
+ * Each ray is traversed incrementally, plane by plane: the four voxels
+ * surrounding the ray are addressed by a single pointer, which is moved by
+ * the voxel boundaries crossed in each step. Rays that do not intersect the
+ * volume are not traversed at all. Evaluate() is thread-safe, so that a
+ * digitally reconstructed radiograph (DRR) may be computed by a multi-threaded
+ * ResampleImageFilter, with this interpolator.
+ *
  * \warning This interpolator works for 3-dimensional images only.
  *
  * \ingroup ImageFunctions
@@ -163,6 +170,12 @@ public:
   /** Get a pointer to the Transform.  */
   itkGetConstMacro(Threshold, double);
 
+  /** Set the input image. Also calculates the planes and corners which bound its volume, which are shared by all
+   * rays cast through the image. So the image should be set again, whenever its size or spacing has changed.
+   */
+  void
+  SetInputImage(const InputImageType * ptr) override;
+
   /** Check if a point is inside the image buffer.
    * \warning For efficiency, no validity checking of
    * the input image pointer is done. */
@@ -210,6 +223,14 @@ protected:
   /// Pointer to the interpolator
   InterpolatorPointer m_Interpolator;
 
+  /** The planes (six planes and four parameters: Ax+By+Cz+D) and the eight corners which bound the volume of the
+   * input image in mm, calculated by SetInputImage(). */
+  double m_BoundingPlane[6][4]{};
+  double m_BoundingCorner[8][3]{};
+
+  /// Tells whether the bounding planes are valid (false for an empty input image).
+  bool m_BoundingPlanesAreValid{ false };
+
 private:
   AdvancedRayCastInterpolateImageFunction(const Self &) = delete;
   void
@@ -38,6 +38,8 @@ PURPOSE.  See the above copyright notices for more information.
 
 #include <vnl/vnl_math.h>
 
+#include <cstddef> // For ptrdiff_t.
+
 // Put the helper class in an anonymous namespace so that it is not
 // exposed to the user
 namespace
@@ -171,9 +173,25 @@ public:
   void
   ZeroState();
 
-  /// Initialise the object
+  /** Initialise the object, using the planes and corners which bound the volume, as computed by
+   * CalcPlanesAndCorners() for the image of the ray. The arrays are not copied, so they should stay alive
+   * while the ray is being cast.
+   */
   void
-  Initialise(void);
+  Initialise(const double (*boundingPlane)[4], const double (*boundingCorner)[3]);
+
+  /** \brief
+   * Calculate the planes and corners which define the volume of the specified image.
+   *
+   * Static member function to calculate the positions of the 8 corners of
+   * the volume in mm (as if at the origin), and the equations of the planes
+   * of the 6 sides of the volume. These only depend on the image, so they
+   * may be calculated once, for all rays cast through the image.
+   *
+   * \return False if any of the planes is undefined (for an empty image), true otherwise.
+   */
+  static bool
+  CalcPlanesAndCorners(const InputImageType & image, double boundingPlane[6][4], double boundingCorner[8][3]);
 
 protected:
   /// Calculate the endpoint coordinats of the ray in voxels.
@@ -211,23 +229,9 @@ protected:
   void
   RecordVolumeDimensions(void);
 
-  /// Define the corners of the volume
-  void
-  DefineCorners(void);
-
-  /** \brief
-   * Calculate the planes which define the volume.
-   *
-   * Member function to calculate the equations of the planes of 4 of
-   * the sides of the volume, calculate the positions of the 8 corners
-   * of the volume in mm in World, also calculate the values of the
-   * slopes of the lines which go to make up the volume( defined as
-   * lines in cube x,y,z dirn and then each of these lines has a slope
-   * in the world x,y,z dirn [3]) and finally also to return the length
-   * of the sides of the lines in mm.
-   */
-  void
-  CalcPlanesAndCorners(void);
+  /// Define the corners of the specified volume
+  static void
+  DefineCorners(const InputImageType & image, double boundingCorner[8][3]);
 
   /** \brief
    *  Calculate the ray intercepts with the volume.
@@ -336,9 +340,9 @@ protected:
   /** \brief
       Planes which define the boundary of the volume in mm
       (six planes and four parameters: Ax+By+Cz+D). */
-  double m_BoundingPlane[6][4];
+  const double (*m_BoundingPlane)[4];
   /// The eight corners of the volume (x,y,z coordinates for each).
-  double m_BoundingCorner[8][3];
+  const double (*m_BoundingCorner)[3];
 
   /// The position of the ray
   double m_CurrentRayPositionInMM[3];
@@ -353,14 +357,14 @@ protected:
 
 template <class TInputImage, class TCoordRep>
 void
-RayCastHelper<TInputImage, TCoordRep>::Initialise(void)
+RayCastHelper<TInputImage, TCoordRep>::Initialise(const double (*boundingPlane)[4], const double (*boundingCorner)[3])
 {
-  // Save the dimensions of the volume and calculate the bounding box
+  // Save the dimensions of the volume
   this->RecordVolumeDimensions();
 
-  // Calculate the planes and corners which define the volume.
-  this->DefineCorners();
-  this->CalcPlanesAndCorners();
+  // The planes and corners which define the volume.
+  m_BoundingPlane = boundingPlane;
+  m_BoundingCorner = boundingCorner;
 }
 
 
@@ -391,24 +395,24 @@ RayCastHelper<TInputImage, TCoordRep>::RecordVolumeDimensions(void)
 
 template <class TInputImage, class TCoordRep>
 void
-RayCastHelper<TInputImage, TCoordRep>::DefineCorners(void)
+RayCastHelper<TInputImage, TCoordRep>::DefineCorners(const InputImageType & image, double boundingCorner[8][3])
 {
+  const typename InputImageType::SpacingType spacing = image.GetSpacing();
+  const SizeType                             dim = image.GetLargestPossibleRegion().GetSize();
+
   // Define corner positions as if at the origin
 
-  m_BoundingCorner[0][0] = m_BoundingCorner[1][0] = m_BoundingCorner[2][0] = m_BoundingCorner[3][0] = 0;
+  boundingCorner[0][0] = boundingCorner[1][0] = boundingCorner[2][0] = boundingCorner[3][0] = 0;
 
-  m_BoundingCorner[4][0] = m_BoundingCorner[5][0] = m_BoundingCorner[6][0] = m_BoundingCorner[7][0] =
-    m_VoxelDimensionInX * m_NumberOfVoxelsInX;
+  boundingCorner[4][0] = boundingCorner[5][0] = boundingCorner[6][0] = boundingCorner[7][0] = spacing[0] * dim[0];
 
-  m_BoundingCorner[1][1] = m_BoundingCorner[3][1] = m_BoundingCorner[5][1] = m_BoundingCorner[7][1] =
-    m_VoxelDimensionInY * m_NumberOfVoxelsInY;
+  boundingCorner[1][1] = boundingCorner[3][1] = boundingCorner[5][1] = boundingCorner[7][1] = spacing[1] * dim[1];
 
-  m_BoundingCorner[0][1] = m_BoundingCorner[2][1] = m_BoundingCorner[4][1] = m_BoundingCorner[6][1] = 0;
+  boundingCorner[0][1] = boundingCorner[2][1] = boundingCorner[4][1] = boundingCorner[6][1] = 0;
 
-  m_BoundingCorner[0][2] = m_BoundingCorner[1][2] = m_BoundingCorner[4][2] = m_BoundingCorner[5][2] =
-    m_VoxelDimensionInZ * m_NumberOfVoxelsInZ;
+  boundingCorner[0][2] = boundingCorner[1][2] = boundingCorner[4][2] = boundingCorner[5][2] = spacing[2] * dim[2];
 
-  m_BoundingCorner[2][2] = m_BoundingCorner[3][2] = m_BoundingCorner[6][2] = m_BoundingCorner[7][2] = 0;
+  boundingCorner[2][2] = boundingCorner[3][2] = boundingCorner[6][2] = boundingCorner[7][2] = 0;
 }
 
 
@@ -417,9 +421,13 @@ RayCastHelper<TInputImage, TCoordRep>::DefineCorners(void)
    ----------------------------------------------------------------------- */
 
 template <class TInputImage, class TCoordRep>
-void
-RayCastHelper<TInputImage, TCoordRep>::CalcPlanesAndCorners(void)
+bool
+RayCastHelper<TInputImage, TCoordRep>::CalcPlanesAndCorners(const InputImageType & image,
+                                                            double                 boundingPlane[6][4],
+                                                            double                 boundingCorner[8][3])
 {
+  DefineCorners(image, boundingCorner);
+
   int j;
 
   // find the equations of the planes
@@ -466,14 +474,14 @@ RayCastHelper<TInputImage, TCoordRep>::CalcPlanesAndCorners(void)
     double line2x, line2y, line2z;
 
     // lines from one corner to another in x,y,z dirns
-    line1x = m_BoundingCorner[c1][0] - m_BoundingCorner[c2][0];
-    line2x = m_BoundingCorner[c1][0] - m_BoundingCorner[c3][0];
+    line1x = boundingCorner[c1][0] - boundingCorner[c2][0];
+    line2x = boundingCorner[c1][0] - boundingCorner[c3][0];
 
-    line1y = m_BoundingCorner[c1][1] - m_BoundingCorner[c2][1];
-    line2y = m_BoundingCorner[c1][1] - m_BoundingCorner[c3][1];
+    line1y = boundingCorner[c1][1] - boundingCorner[c2][1];
+    line2y = boundingCorner[c1][1] - boundingCorner[c3][1];
 
-    line1z = m_BoundingCorner[c1][2] - m_BoundingCorner[c2][2];
-    line2z = m_BoundingCorner[c1][2] - m_BoundingCorner[c3][2];
+    line1z = boundingCorner[c1][2] - boundingCorner[c2][2];
+    line2z = boundingCorner[c1][2] - boundingCorner[c3][2];
 
     double A, B, C, D;
 
@@ -483,23 +491,22 @@ RayCastHelper<TInputImage, TCoordRep>::CalcPlanesAndCorners(void)
     C = line1x * line2y - line2x * line1y;
 
     // find constant
-    D = -(A * m_BoundingCorner[c1][0] + B * m_BoundingCorner[c1][1] + C * m_BoundingCorner[c1][2]);
-
-    // initialise plane value and normalise
-    m_BoundingPlane[j][0] = A / std::sqrt(A * A + B * B + C * C);
-    m_BoundingPlane[j][1] = B / std::sqrt(A * A + B * B + C * C);
-    m_BoundingPlane[j][2] = C / std::sqrt(A * A + B * B + C * C);
-    m_BoundingPlane[j][3] = D / std::sqrt(A * A + B * B + C * C);
+    D = -(A * boundingCorner[c1][0] + B * boundingCorner[c1][1] + C * boundingCorner[c1][2]);
 
     if ((A * A + B * B + C * C) == 0)
     {
-      itk::ExceptionObject err(__FILE__, __LINE__);
-      err.SetLocation(ITK_LOCATION);
-      err.SetDescription("Division by zero (planes) "
-                         "- CalcPlanesAndCorners().");
-      throw err;
+      return false;
     }
+
+    // initialise plane value and normalise
+    const double norm = std::sqrt(A * A + B * B + C * C);
+
+    boundingPlane[j][0] = A / norm;
+    boundingPlane[j][1] = B / norm;
+    boundingPlane[j][2] = C / norm;
+    boundingPlane[j][3] = D / norm;
   }
+  return true;
 }
 
 
@@ -1374,31 +1381,118 @@ template <class TInputImage, class TCoordRep>
 bool
 RayCastHelper<TInputImage, TCoordRep>::IntegrateAboveThreshold(double & integral, double threshold)
 {
-  double intensity;
-  //  double posn3D_x, posn3D_y, posn3D_z;
-
   integral = 0.;
 
   // Check if this is a valid ray
 
-  if (!m_ValidRay)
+  if (!m_ValidRay || (m_RayIntersectionVoxels[0] == nullptr))
   {
     return false;
   }
+
   /* Step along the ray as quickly as possible
-     integrating the interpolated intensities. */
+     integrating the interpolated intensities.
+
+     This loop does exactly the same as calling GetCurrentIntensity() and
+     IncrementVoxelPointers() for each plane of voxels, but the traversal
+     direction is resolved only once per ray, and the state of the ray is
+     kept in local variables. The four voxels surrounding the ray are
+     addressed by one pointer and three constant offsets, and the pointer
+     is moved by the voxel boundaries crossed in each step. */
+
+  unsigned int inPlaneAxis1 = 0;
+  unsigned int inPlaneAxis2 = 1;
+
+  switch (m_TraversalDirection)
+  {
+    case TRANSVERSE_IN_X:
+    {
+      inPlaneAxis1 = 1;
+      inPlaneAxis2 = 2;
+      break;
+    }
+    case TRANSVERSE_IN_Y:
+    {
+      inPlaneAxis1 = 0;
+      inPlaneAxis2 = 2;
+      break;
+    }
+    case TRANSVERSE_IN_Z:
+    {
+      inPlaneAxis1 = 0;
+      inPlaneAxis2 = 1;
+      break;
+    }
+    default:
+    {
+      itk::ExceptionObject err(__FILE__, __LINE__);
+      err.SetLocation(ITK_LOCATION);
+      err.SetDescription("The ray traversal direction is unset "
+                         "- IntegrateAboveThreshold().");
+      throw err;
+    }
+  }
 
-  for (m_NumVoxelPlanesTraversed = 0; m_NumVoxelPlanesTraversed < m_TotalRayVoxelPlanes; ++m_NumVoxelPlanesTraversed)
+  const PixelType *    voxel = m_RayIntersectionVoxels[0];
+  const std::ptrdiff_t offset1 = m_RayIntersectionVoxels[1] - voxel;
+  const std::ptrdiff_t offset2 = m_RayIntersectionVoxels[2] - voxel;
+  const std::ptrdiff_t offset3 = m_RayIntersectionVoxels[3] - voxel;
+  const std::ptrdiff_t strideY = m_NumberOfVoxelsInX;
+  const std::ptrdiff_t strideZ = static_cast<std::ptrdiff_t>(m_NumberOfVoxelsInX) * m_NumberOfVoxelsInY;
+
+  const double increment[3] = { m_VoxelIncrement[0], m_VoxelIncrement[1], m_VoxelIncrement[2] };
+  double       position[3] = { m_Position3Dvox[0], m_Position3Dvox[1], m_Position3Dvox[2] };
+  int          voxelIndex[3] = { (int)position[0], (int)position[1], (int)position[2] };
+
+  const int totalRayVoxelPlanes = m_TotalRayVoxelPlanes;
+
+  for (int plane = 0; plane < totalRayVoxelPlanes; ++plane)
   {
-    intensity = this->GetCurrentIntensity();
+    const double a = (double)(voxel[0]);
+    const double b = (double)(voxel[offset1] - a);
+    const double c = (double)(voxel[offset2] - a);
+    const double d = (double)(voxel[offset3] - a - b - c);
+
+    const double y = position[inPlaneAxis1] - std::floor(position[inPlaneAxis1]);
+    const double z = position[inPlaneAxis2] - std::floor(position[inPlaneAxis2]);
+
+    const double intensity = a + b * y + c * z + d * y * z;
 
     if (intensity > threshold)
     {
       integral += intensity - threshold;
     }
-    this->IncrementVoxelPointers();
+
+    position[0] += increment[0];
+    position[1] += increment[1];
+    position[2] += increment[2];
+
+    const int dx = ((int)position[0]) - voxelIndex[0];
+    const int dy = ((int)position[1]) - voxelIndex[1];
+    const int dz = ((int)position[2]) - voxelIndex[2];
+
+    voxelIndex[0] += dx;
+    voxelIndex[1] += dy;
+    voxelIndex[2] += dz;
+
+    voxel += dx + dy * strideY + dz * strideZ;
   }
 
+  /* Store the final state of the ray, as if the voxel pointers had been
+     incremented plane by plane. */
+
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    m_RayIntersectionVoxelIndex[i] += voxelIndex[i] - (int)m_Position3Dvox[i];
+    m_Position3Dvox[i] = position[i];
+  }
+  const std::ptrdiff_t voxelShift = voxel - m_RayIntersectionVoxels[0];
+  for (unsigned int i = 0; i < 4; ++i)
+  {
+    m_RayIntersectionVoxels[i] += voxelShift;
+  }
+  m_NumVoxelPlanesTraversed = totalRayVoxelPlanes;
+
   /* The ray passes through the volume one plane of voxels at a time,
      however, if its moving diagonally the ray points will be further
      apart so account for this by scaling by the distance moved. */
@@ -1429,6 +1523,9 @@ RayCastHelper<TInputImage, TCoordRep>::ZeroState()
   m_VoxelDimensionInY = 0;
   m_VoxelDimensionInZ = 0;
 
+  m_BoundingPlane = nullptr;
+  m_BoundingCorner = nullptr;
+
   for (i = 0; i < 3; ++i)
   {
     m_CurrentRayPositionInMM[i] = 0.;
@@ -1511,6 +1608,24 @@ AdvancedRayCastInterpolateImageFunction<TInputImage, TCoordRep>::PrintSelf(std::
 }
 
 
+/* -----------------------------------------------------------------------
+   SetInputImage
+   ----------------------------------------------------------------------- */
+
+template <class TInputImage, class TCoordRep>
+void
+AdvancedRayCastInterpolateImageFunction<TInputImage, TCoordRep>::SetInputImage(const InputImageType * ptr)
+{
+  this->Superclass::SetInputImage(ptr);
+
+  /** The planes and corners which bound the volume only depend on the image, so
+   * they are calculated here, once, instead of for each ray. */
+  m_BoundingPlanesAreValid =
+    (ptr != nullptr) &&
+    RayCastHelper<TInputImage, TCoordRep>::CalcPlanesAndCorners(*ptr, m_BoundingPlane, m_BoundingCorner);
+}
+
+
 /* -----------------------------------------------------------------------
    Evaluate at image index position
    ----------------------------------------------------------------------- */
@@ -1525,10 +1640,19 @@ AdvancedRayCastInterpolateImageFunction<TInputImage, TCoordRep>::Evaluate(const
 
   DirectionType direction = transformedFocalPoint - point;
 
+  if (!m_BoundingPlanesAreValid)
+  {
+    itk::ExceptionObject err(__FILE__, __LINE__);
+    err.SetLocation(ITK_LOCATION);
+    err.SetDescription("The planes which bound the volume are undefined, as the input image is empty or not set "
+                       "- Evaluate().");
+    throw err;
+  }
+
   RayCastHelper<TInputImage, TCoordRep> ray;
   ray.SetImage(this->m_Image);
   ray.ZeroState();
-  ray.Initialise();
+  ray.Initialise(m_BoundingPlane, m_BoundingCorner);
 
   ray.SetRay(point, direction);
   ray.IntegrateAboveThreshold(integral, m_Threshold);
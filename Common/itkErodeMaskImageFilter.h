@@ -21,6 +21,8 @@
 #include "itkImageToImageFilter.h"
 #include "itkMultiResolutionPyramidImageFilter.h"
 
+#include <vector>
+
 namespace itk
 {
 /**
@@ -48,6 +50,23 @@ namespace itk
  *   the derivative of the metric.\n
  *   --> <tt>radius = static_cast<unsigned long>( 2 * schedule + 1 );</tt>
  *
+ * A mask of an integer pixel type that only has zero and one values (the
+ * most common case) is eroded by a box of the given radius. For such a mask,
+ * this yields exactly the same result as the parabolic erosion, because the
+ * parabolic erosion rounds any voxel within the radius of a zero voxel down
+ * to zero, in each dimension. The box erosion is computed by two passes
+ * along each image line, so its computation time does not depend on the
+ * radius. The lines are processed multi-threaded.
+ *
+ * Moreover, when the boxes of the resolution levels are nested (which is
+ * the case for any common pyramid schedule), the erosions of all resolution
+ * levels of a zero-one mask are computed at once, by the same passes along
+ * the image lines, into a map that stores one byte per voxel: the number of
+ * boxes (from small to large) that fit in the mask around the voxel. The
+ * output for a specific resolution level is then just a threshold of this
+ * map. The map is kept by the filter, so when the same filter is updated for
+ * another resolution level, while the input mask and the schedule are
+ * unchanged, the mask is not eroded again.
  *
  * \sa ParabolicErodeImageFilter
  *
@@ -125,9 +144,16 @@ protected:
   /** Destructor */
   ~ErodeMaskImageFilter() override = default;
 
+  /** The erosion of any part of the mask may depend on the whole mask,
+   * so the whole output is requested.
+   */
+  void
+  EnlargeOutputRequestedRegion(DataObject * output) override;
+
   /** Standard pipeline method. While this class does not implement a
    * ThreadedGenerateData(), its GenerateData() delegates all
-   * calculations to the ParabolicErodeImageFilter, which is multi-threaded.
+   * calculations to either the multi-threaded box erosion of a zero-one
+   * mask, or the ParabolicErodeImageFilter, which is multi-threaded.
    */
   void
   GenerateData(void) override;
@@ -137,9 +163,65 @@ private:
   void
   operator=(const Self &) = delete;
 
+  typedef FixedArray<SizeValueType, ImageDimension> BoxRadiusType;
+
+  /** Returns the radius of the box by which a zero-one mask is eroded, for the specified resolution level. */
+  BoxRadiusType
+  GetBoxRadius(const unsigned int level) const;
+
+  /** Tells whether the buffered pixels of the specified mask are only zero or one. */
+  static bool
+  IsZeroOneMask(const InputImageType & mask);
+
+  /** Erodes one image line of a zero-one mask by the specified radius. The line starts at the specified pixel,
+   * and the specified stride is the distance (in pixels) between subsequent pixels of the line.
+   */
+  static void
+  ErodeZeroOneMaskLine(OutputPixelType * const first,
+                       const SizeValueType     stride,
+                       const SizeValueType     lineLength,
+                       const SizeValueType     radius);
+
+  /** Erodes the input (a zero-one mask) by a box of the specified radius, into the output. */
+  void
+  ErodeZeroOneMask(const BoxRadiusType & radius);
+
+  /** Erodes one image line of the erosion level map, for all boxes at once. The radii of the boxes along the line
+   * are specified from small to large. */
+  static void
+  ErodeErosionLevelMapLine(unsigned char * const              first,
+                           const SizeValueType                stride,
+                           const SizeValueType                lineLength,
+                           const std::vector<SizeValueType> & radii);
+
+  /** Tells whether the erosion level map is up-to-date with the input, the schedule, and IsMovingMask. */
+  bool
+  IsErosionLevelMapUpToDate(void) const;
+
+  /** Computes the erosion level map of the input (a zero-one mask), for all resolution levels at once. Returns false,
+   * without computing the map, when the boxes of the resolution levels are not nested.
+   */
+  bool
+  ComputeErosionLevelMap(void);
+
+  /** Generates the output for the current resolution level from the erosion level map. */
+  void
+  GenerateOutputFromErosionLevelMap(void);
+
   bool         m_IsMovingMask;
   unsigned int m_ResolutionLevel;
   ScheduleType m_Schedule;
+
+  /** The erosion level map, and the rank of the box of each resolution level, from small to large. The other
+   * variables store what the map was computed for.
+   */
+  std::vector<unsigned char>  m_ErosionLevelMap;
+  std::vector<unsigned int>   m_ErosionLevelRanks;
+  const InputImageType *      m_ErosionLevelMapInput;
+  typename TImage::RegionType m_ErosionLevelMapRegion;
+  ScheduleType                m_ErosionLevelMapSchedule;
+  bool                        m_ErosionLevelMapIsMovingMask;
+  TimeStamp                   m_ErosionLevelMapTime;
 };
 
 } // end namespace itk
@@ -19,9 +19,14 @@
 #define _itkErodeMaskImageFilter_hxx
 
 #include "itkErodeMaskImageFilter.h"
+#include "itkImageAlgorithm.h"
+#include "itkImageRegionConstIterator.h"
 #include "itkParabolicErodeImageFilter.h"
 //#include "itkThresholdImageFilter.h"
 
+#include <algorithm> // For min, fill, stable_sort and transform.
+#include <numeric>   // For accumulate.
+
 namespace itk
 {
 
@@ -34,6 +39,8 @@ ErodeMaskImageFilter<TImage>::ErodeMaskImageFilter()
 {
   this->m_IsMovingMask = false;
   this->m_ResolutionLevel = 0;
+  this->m_ErosionLevelMapInput = nullptr;
+  this->m_ErosionLevelMapIsMovingMask = false;
 
   ScheduleType defaultSchedule(1, InputImageDimension);
   defaultSchedule.Fill(NumericTraits<unsigned int>::OneValue());
@@ -42,6 +49,20 @@ ErodeMaskImageFilter<TImage>::ErodeMaskImageFilter()
 } // end Constructor
 
 
+/**
+ * ************* EnlargeOutputRequestedRegion *******************
+ */
+
+template <class TImage>
+void
+ErodeMaskImageFilter<TImage>::EnlargeOutputRequestedRegion(DataObject * output)
+{
+  Superclass::EnlargeOutputRequestedRegion(output);
+  output->SetRequestedRegionToLargestPossibleRegion();
+
+} // end EnlargeOutputRequestedRegion()
+
+
 /**
  * ************* GenerateData *******************
  */
@@ -56,6 +77,27 @@ ErodeMaskImageFilter<TImage>::GenerateData(void)
   typedef typename ErodeFilterType::RadiusType                            RadiusType;
   typedef typename ErodeFilterType::ScalarRealType                        ScalarRealType;
 
+  /** A zero-one mask is eroded by a box, which yields the same result as the parabolic erosion. When possible, the
+   * erosions of all resolution levels are computed at once, and kept for the next update.
+   */
+  if (this->IsErosionLevelMapUpToDate())
+  {
+    this->GenerateOutputFromErosionLevelMap();
+    return;
+  }
+  if (NumericTraits<InputPixelType>::is_integer && IsZeroOneMask(*(this->GetInput())))
+  {
+    if (this->ComputeErosionLevelMap())
+    {
+      this->GenerateOutputFromErosionLevelMap();
+    }
+    else
+    {
+      this->ErodeZeroOneMask(this->GetBoxRadius(this->GetResolutionLevel()));
+    }
+    return;
+  }
+
   /** Get the correct radius. */
   RadiusType     radiusarray;
   ScalarRealType radius = 0.0;
@@ -71,6 +113,7 @@ ErodeMaskImageFilter<TImage>::GenerateData(void)
     {
       radius = 2.0 * schedule + 1.0;
     }
+
     // Very specific computation for the parabolic erosion filter:
     radius = radius * radius / 2.0 + 1.0;
 
@@ -100,6 +143,364 @@ ErodeMaskImageFilter<TImage>::GenerateData(void)
 } // end GenerateData()
 
 
+/**
+ * ************* GetBoxRadius *******************
+ */
+
+template <class TImage>
+auto
+ErodeMaskImageFilter<TImage>::GetBoxRadius(const unsigned int level) const -> BoxRadiusType
+{
+  /** The same radius as for the parabolic erosion, before its very specific computation. */
+  BoxRadiusType boxRadius;
+  for (unsigned int i = 0; i < InputImageDimension; ++i)
+  {
+    const double schedule = static_cast<double>(this->m_Schedule[level][i]);
+    boxRadius[i] = static_cast<SizeValueType>(this->m_IsMovingMask ? (2.0 * schedule + 1.0) : (schedule + 1.0));
+  }
+  return boxRadius;
+
+} // end GetBoxRadius()
+
+
+/**
+ * ************* IsZeroOneMask *******************
+ */
+
+template <class TImage>
+bool
+ErodeMaskImageFilter<TImage>::IsZeroOneMask(const InputImageType & mask)
+{
+  for (ImageRegionConstIterator<InputImageType> it(&mask, mask.GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const InputPixelType pixel = it.Get();
+    if ((pixel != NumericTraits<InputPixelType>::ZeroValue()) && (pixel != NumericTraits<InputPixelType>::OneValue()))
+    {
+      return false;
+    }
+  }
+  return true;
+
+} // end IsZeroOneMask()
+
+
+/**
+ * ************* ErodeZeroOneMaskLine *******************
+ */
+
+template <class TImage>
+void
+ErodeMaskImageFilter<TImage>::ErodeZeroOneMaskLine(OutputPixelType * const first,
+                                                   const SizeValueType     stride,
+                                                   const SizeValueType     lineLength,
+                                                   const SizeValueType     radius)
+{
+  /** Forward pass: mark the one-voxels within the radius after a zero-voxel by a temporary value (two).
+   * The distance to the last zero-voxel is only counted up to the radius. */
+  SizeValueType distance = radius;
+  for (SizeValueType i = 0; i < lineLength; ++i)
+  {
+    OutputPixelType & pixel = first[i * stride];
+    if (pixel == 0)
+    {
+      distance = 0;
+    }
+    else if (distance < radius)
+    {
+      ++distance;
+      pixel = 2;
+    }
+  }
+
+  /** Backward pass: set the one-voxels within the radius before a zero-voxel, and the marked voxels, to zero.
+   * Only the original zero-voxels are considered, as a voxel is read before it may be set to zero. */
+  distance = radius;
+  for (SizeValueType i = lineLength; i > 0; --i)
+  {
+    OutputPixelType & pixel = first[(i - 1) * stride];
+    if (pixel == 0)
+    {
+      distance = 0;
+    }
+    else if (distance < radius)
+    {
+      ++distance;
+      pixel = 0;
+    }
+    else if (pixel == 2)
+    {
+      pixel = 0;
+    }
+  }
+
+} // end ErodeZeroOneMaskLine()
+
+
+/**
+ * ************* ErodeZeroOneMask *******************
+ */
+
+template <class TImage>
+void
+ErodeMaskImageFilter<TImage>::ErodeZeroOneMask(const BoxRadiusType & radius)
+{
+  const InputImageType & input = *(this->GetInput());
+  OutputImageType &      output = *(this->GetOutput());
+
+  const auto region = output.GetRequestedRegion();
+  output.SetBufferedRegion(region);
+  output.Allocate();
+  ImageAlgorithm::Copy(&input, &output, region, region);
+
+  const SizeValueType numberOfPixels = region.GetNumberOfPixels();
+  if (numberOfPixels == 0)
+  {
+    return;
+  }
+
+  /** Erode along each dimension separately. The pixels of a line along dimension d are 'stride' pixels apart,
+   * where 'stride' is the product of the sizes of the dimensions before d. */
+  OutputPixelType * const buffer = output.GetBufferPointer();
+  SizeValueType           stride = 1;
+
+  for (unsigned int d = 0; d < ImageDimension; ++d)
+  {
+    const SizeValueType lineLength = region.GetSize(d);
+    const SizeValueType radiusOfDimension = radius[d];
+
+    if ((lineLength > 1) && (radiusOfDimension > 0))
+    {
+      this->GetMultiThreader()->ParallelizeArray(
+        0,
+        numberOfPixels / lineLength,
+        [buffer, stride, lineLength, radiusOfDimension](const SizeValueType line) {
+          const SizeValueType offset = (line % stride) + (line / stride) * stride * lineLength;
+          ErodeZeroOneMaskLine(buffer + offset, stride, lineLength, radiusOfDimension);
+        },
+        nullptr);
+    }
+    stride *= lineLength;
+  }
+
+} // end ErodeZeroOneMask()
+
+
+/**
+ * ************* ErodeErosionLevelMapLine *******************
+ */
+
+template <class TImage>
+void
+ErodeMaskImageFilter<TImage>::ErodeErosionLevelMapLine(unsigned char * const              first,
+                                                       const SizeValueType                stride,
+                                                       const SizeValueType                lineLength,
+                                                       const std::vector<SizeValueType> & radii)
+{
+  /** A voxel stays inside the erosion by box j, along this line, when all voxels within radius j have a value greater
+   * than j. For each box, 'remaining' counts the voxels that are still within the radius of the last voxel that is
+   * not. As the boxes are nested, the boxes for which a voxel stays inside are always the smallest ones, so the new
+   * value of the voxel is just the number of those boxes.
+   */
+  const std::size_t          numberOfBoxes = radii.size();
+  std::vector<SizeValueType> remaining(numberOfBoxes, 0);
+  std::vector<unsigned char> forwardValues(lineLength);
+
+  /** Forward pass: only consider the voxels before (and at) the current one. */
+  for (SizeValueType i = 0; i < lineLength; ++i)
+  {
+    const unsigned char value = first[i * stride];
+    unsigned char       count = 0;
+    for (std::size_t j = 0; j < numberOfBoxes; ++j)
+    {
+      if (j >= value)
+      {
+        remaining[j] = radii[j] + 1;
+      }
+      if (remaining[j] > 0)
+      {
+        --remaining[j];
+      }
+      else
+      {
+        ++count;
+      }
+    }
+    forwardValues[i] = count;
+  }
+
+  /** Backward pass: consider the voxels after (and at) the current one. A voxel is read before it is overwritten. */
+  std::fill(remaining.begin(), remaining.end(), 0);
+  for (SizeValueType i = lineLength; i > 0; --i)
+  {
+    unsigned char &     pixel = first[(i - 1) * stride];
+    const unsigned char value = pixel;
+    unsigned char       count = 0;
+    for (std::size_t j = 0; j < numberOfBoxes; ++j)
+    {
+      if (j >= value)
+      {
+        remaining[j] = radii[j] + 1;
+      }
+      if (remaining[j] > 0)
+      {
+        --remaining[j];
+      }
+      else
+      {
+        ++count;
+      }
+    }
+    pixel = std::min(forwardValues[i - 1], count);
+  }
+
+} // end ErodeErosionLevelMapLine()
+
+
+/**
+ * ************* IsErosionLevelMapUpToDate *******************
+ */
+
+template <class TImage>
+bool
+ErodeMaskImageFilter<TImage>::IsErosionLevelMapUpToDate(void) const
+{
+  const InputImageType * const input = this->GetInput();
+
+  return !this->m_ErosionLevelMap.empty() && (input == this->m_ErosionLevelMapInput) &&
+         (std::max(input->GetMTime(), input->GetUpdateMTime()) < this->m_ErosionLevelMapTime.GetMTime()) &&
+         (input->GetBufferedRegion() == this->m_ErosionLevelMapRegion) &&
+         (this->GetOutput()->GetRequestedRegion() == this->m_ErosionLevelMapRegion) &&
+         (this->m_Schedule == this->m_ErosionLevelMapSchedule) &&
+         (this->m_IsMovingMask == this->m_ErosionLevelMapIsMovingMask) &&
+         (this->m_ResolutionLevel < this->m_ErosionLevelRanks.size());
+
+} // end IsErosionLevelMapUpToDate()
+
+
+/**
+ * ************* ComputeErosionLevelMap *******************
+ */
+
+template <class TImage>
+bool
+ErodeMaskImageFilter<TImage>::ComputeErosionLevelMap(void)
+{
+  this->m_ErosionLevelMap.clear();
+
+  const InputImageType & input = *(this->GetInput());
+  const auto             region = this->GetOutput()->GetRequestedRegion();
+  const unsigned int     numberOfLevels = this->m_Schedule.rows();
+
+  /** The number of boxes must fit in a byte. */
+  if ((numberOfLevels == 0) || (numberOfLevels > NumericTraits<unsigned char>::max()) ||
+      (this->m_ResolutionLevel >= numberOfLevels) || (input.GetBufferedRegion() != region))
+  {
+    return false;
+  }
+
+  /** Sort the boxes of the resolution levels from small to large, and check that they are nested. */
+  std::vector<BoxRadiusType> radii(numberOfLevels);
+  std::vector<unsigned int>  levels(numberOfLevels);
+  for (unsigned int level = 0; level < numberOfLevels; ++level)
+  {
+    radii[level] = this->GetBoxRadius(level);
+    levels[level] = level;
+  }
+  const auto sumOfRadii = [&radii](const unsigned int level) {
+    return std::accumulate(radii[level].Begin(), radii[level].End(), SizeValueType{});
+  };
+  std::stable_sort(levels.begin(), levels.end(), [&sumOfRadii](const unsigned int lhs, const unsigned int rhs) {
+    return sumOfRadii(lhs) < sumOfRadii(rhs);
+  });
+
+  std::vector<unsigned int> ranks(numberOfLevels);
+  for (unsigned int rank = 0; rank < numberOfLevels; ++rank)
+  {
+    ranks[levels[rank]] = rank;
+    for (unsigned int d = 0; (rank > 0) && (d < ImageDimension); ++d)
+    {
+      if (radii[levels[rank - 1]][d] > radii[levels[rank]][d])
+      {
+        return false;
+      }
+    }
+  }
+
+  /** Initially, all boxes fit around a voxel inside the mask, and none around a voxel outside. */
+  const SizeValueType        numberOfPixels = region.GetNumberOfPixels();
+  std::vector<unsigned char> erosionLevelMap(numberOfPixels);
+  const InputPixelType       zero = NumericTraits<InputPixelType>::ZeroValue();
+  std::transform(input.GetBufferPointer(),
+                 input.GetBufferPointer() + numberOfPixels,
+                 erosionLevelMap.begin(),
+                 [numberOfLevels, zero](const InputPixelType pixel) {
+                   return static_cast<unsigned char>((pixel == zero) ? 0 : numberOfLevels);
+                 });
+
+  /** Erode along each dimension separately, just like ErodeZeroOneMask(), but for all boxes at once. */
+  unsigned char * const buffer = erosionLevelMap.data();
+  SizeValueType         stride = 1;
+
+  for (unsigned int d = 0; (d < ImageDimension) && (numberOfPixels > 0); ++d)
+  {
+    const SizeValueType        lineLength = region.GetSize(d);
+    std::vector<SizeValueType> radiiOfDimension(numberOfLevels);
+    for (unsigned int rank = 0; rank < numberOfLevels; ++rank)
+    {
+      radiiOfDimension[rank] = radii[levels[rank]][d];
+    }
+
+    if (lineLength > 1)
+    {
+      this->GetMultiThreader()->ParallelizeArray(
+        0,
+        numberOfPixels / lineLength,
+        [buffer, stride, lineLength, &radiiOfDimension](const SizeValueType line) {
+          const SizeValueType offset = (line % stride) + (line / stride) * stride * lineLength;
+          ErodeErosionLevelMapLine(buffer + offset, stride, lineLength, radiiOfDimension);
+        },
+        nullptr);
+    }
+    stride *= lineLength;
+  }
+
+  this->m_ErosionLevelMap = std::move(erosionLevelMap);
+  this->m_ErosionLevelRanks = std::move(ranks);
+  this->m_ErosionLevelMapInput = &input;
+  this->m_ErosionLevelMapRegion = region;
+  this->m_ErosionLevelMapSchedule = this->m_Schedule;
+  this->m_ErosionLevelMapIsMovingMask = this->m_IsMovingMask;
+  this->m_ErosionLevelMapTime.Modified();
+  return true;
+
+} // end ComputeErosionLevelMap()
+
+
+/**
+ * ************* GenerateOutputFromErosionLevelMap *******************
+ */
+
+template <class TImage>
+void
+ErodeMaskImageFilter<TImage>::GenerateOutputFromErosionLevelMap(void)
+{
+  OutputImageType & output = *(this->GetOutput());
+  output.SetBufferedRegion(this->m_ErosionLevelMapRegion);
+  output.Allocate();
+
+  /** A voxel is inside the eroded mask when the box of the current resolution level fits around it. */
+  const unsigned int rank = this->m_ErosionLevelRanks[this->m_ResolutionLevel];
+  std::transform(this->m_ErosionLevelMap.cbegin(),
+                 this->m_ErosionLevelMap.cend(),
+                 output.GetBufferPointer(),
+                 [rank](const unsigned char numberOfBoxes) {
+                   return (numberOfBoxes > rank) ? NumericTraits<OutputPixelType>::OneValue()
+                                                 : NumericTraits<OutputPixelType>::ZeroValue();
+                 });
+
+} // end GenerateOutputFromErosionLevelMap()
+
+
 } // end namespace itk
 
 #endif
@@ -269,6 +269,16 @@ protected:
   virtual void
   PreparePyramids(void);
 
+  /** Update the fixed image pyramid. Called by PreparePyramids(). May be overridden,
+   * for example to retrieve the pyramid images from a cache. */
+  virtual void
+  UpdateFixedImagePyramid(void);
+
+  /** Update the moving image pyramid. Called by PreparePyramids(). May be overridden,
+   * for example to retrieve the pyramid images from a cache. */
+  virtual void
+  UpdateMovingImagePyramid(void);
+
   /** Set the current level to be processed. */
   itkSetMacro(CurrentLevel, unsigned long);
 
@@ -192,14 +192,10 @@ MultiResolutionImageRegistrationMethod2<TFixedImage, TMovingImage>::PreparePyram
   }
 
   // Setup the fixed image pyramid
-  this->m_FixedImagePyramid->SetNumberOfLevels(this->m_NumberOfLevels);
-  this->m_FixedImagePyramid->SetInput(this->m_FixedImage);
-  this->m_FixedImagePyramid->UpdateLargestPossibleRegion();
+  this->UpdateFixedImagePyramid();
 
   // Setup the moving image pyramid
-  this->m_MovingImagePyramid->SetNumberOfLevels(this->m_NumberOfLevels);
-  this->m_MovingImagePyramid->SetInput(this->m_MovingImage);
-  this->m_MovingImagePyramid->UpdateLargestPossibleRegion();
+  this->UpdateMovingImagePyramid();
 
   typedef typename FixedImageRegionType::SizeType      SizeType;
   typedef typename FixedImageRegionType::IndexType     IndexType;
@@ -265,6 +261,34 @@ MultiResolutionImageRegistrationMethod2<TFixedImage, TMovingImage>::PreparePyram
 } // end PreparePyramids()
 
 
+/*
+ * Update the fixed image pyramid
+ */
+template <typename TFixedImage, typename TMovingImage>
+void
+MultiResolutionImageRegistrationMethod2<TFixedImage, TMovingImage>::UpdateFixedImagePyramid(void)
+{
+  this->m_FixedImagePyramid->SetNumberOfLevels(this->m_NumberOfLevels);
+  this->m_FixedImagePyramid->SetInput(this->m_FixedImage);
+  this->m_FixedImagePyramid->UpdateLargestPossibleRegion();
+
+} // end UpdateFixedImagePyramid()
+
+
+/*
+ * Update the moving image pyramid
+ */
+template <typename TFixedImage, typename TMovingImage>
+void
+MultiResolutionImageRegistrationMethod2<TFixedImage, TMovingImage>::UpdateMovingImagePyramid(void)
+{
+  this->m_MovingImagePyramid->SetNumberOfLevels(this->m_NumberOfLevels);
+  this->m_MovingImagePyramid->SetInput(this->m_MovingImage);
+  this->m_MovingImagePyramid->UpdateLargestPossibleRegion();
+
+} // end UpdateMovingImagePyramid()
+
+
 /*
  * Starts the Registration Process
  */
@@ -0,0 +1,183 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkPackedImageMask_h
+#define itkPackedImageMask_h
+
+#include "itkImageMaskSpatialObject.h"
+#include "itkObject.h"
+
+#include <cstdint>
+#include <utility> // For pair.
+#include <vector>
+
+namespace itk
+{
+/**
+ * \class PackedImageMask
+ * \brief A compact, read-only copy of an ImageMaskSpatialObject, for fast IsInside queries.
+ *
+ * The voxels of the mask are stored as bits, within the bounding box of the
+ * non-zero voxels of the mask image. For each row of the bounding box (along
+ * the first dimension), the range of non-zero voxels is stored as well. A
+ * query first converts the physical point to the nearest voxel index (just
+ * like ImageMaskSpatialObject), and then checks the bounding box, the range
+ * of the row, and the bit of the voxel. This avoids the virtual calls, the
+ * inverse object-to-world transformation and the byte image lookup of
+ * ImageMaskSpatialObject::IsInsideInWorldSpace, which may be called for each
+ * sample, by the image samplers and the metrics.
+ *
+ * A PackedImageMask can only be created from an ImageMaskSpatialObject whose
+ * object-to-world transform is the identity (which is always the case for the
+ * masks of elastix). It does not follow any later modification of the spatial
+ * object or its image. IsCreatedFrom() may be used to check whether it is
+ * still up-to-date.
+ *
+ * \sa ImageMaskSpatialObject
+ */
+
+template <unsigned int VDimension>
+class ITK_TEMPLATE_EXPORT PackedImageMask : public Object
+{
+public:
+  /** Standard ITK stuff. */
+  typedef PackedImageMask          Self;
+  typedef Object                   Superclass;
+  typedef SmartPointer<Self>       Pointer;
+  typedef SmartPointer<const Self> ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(PackedImageMask, Object);
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  itkStaticConstMacro(ImageDimension, unsigned int, VDimension);
+
+  /** Typedefs. */
+  typedef SpatialObject<VDimension>                        SpatialObjectType;
+  typedef ImageMaskSpatialObject<VDimension>               ImageMaskSpatialObjectType;
+  typedef typename ImageMaskSpatialObjectType::ImageType   MaskImageType;
+  typedef typename MaskImageType::ConstPointer             MaskImageConstPointer;
+  typedef typename MaskImageType::PixelType                MaskPixelType;
+  typedef typename MaskImageType::IndexType                IndexType;
+  typedef typename MaskImageType::RegionType               RegionType;
+  typedef typename MaskImageType::PointType                PointType;
+  typedef std::pair<IndexValueType, IndexValueType>        RunType;
+
+  /** Creates a packed copy of the specified spatial object, when it is an ImageMaskSpatialObject (with an identity
+   * object-to-world transform). Returns null otherwise.
+   */
+  static Pointer
+  CreateFromSpatialObject(const SpatialObjectType * spatialObject);
+
+  /** Tells whether this packed mask was created from the specified spatial object, and whether neither the spatial
+   * object nor its image has been modified afterwards.
+   */
+  bool
+  IsCreatedFrom(const SpatialObjectType * spatialObject) const;
+
+  /** Returns the spatial object that this packed mask was created from. Only to be used for comparison. */
+  const SpatialObjectType *
+  GetSpatialObject(void) const
+  {
+    return m_SpatialObject;
+  }
+
+  /** Tells whether the specified point is inside the mask. Yields the same result as
+   * ImageMaskSpatialObject::IsInsideInWorldSpace(point), for the spatial object that it was created from.
+   */
+  bool
+  IsInside(const PointType & point) const
+  {
+    IndexType index;
+    m_MaskImage->TransformPhysicalPointToIndex(point, index);
+    return this->IsInside(index);
+  }
+
+  /** Tells whether the voxel at the specified index (of the mask image) is inside the mask. */
+  bool
+  IsInside(const IndexType & index) const
+  {
+    if (!m_BoundingBoxRegion.IsInside(index))
+    {
+      return false;
+    }
+
+    /** Compute the row number, within the bounding box. */
+    const IndexType & boxIndex = m_BoundingBoxRegion.GetIndex();
+    const auto &      boxSize = m_BoundingBoxRegion.GetSize();
+
+    SizeValueType row = 0;
+    for (unsigned int i = ImageDimension - 1; i > 0; --i)
+    {
+      row = row * boxSize[i] + static_cast<SizeValueType>(index[i] - boxIndex[i]);
+    }
+
+    /** Check the range of non-zero voxels of the row, and then the bit of the voxel itself. */
+    const IndexValueType x = index[0] - boxIndex[0];
+    const RunType &      run = m_Runs[row];
+    if ((x < run.first) || (x >= run.second))
+    {
+      return false;
+    }
+    const SizeValueType bitNumber = row * boxSize[0] + static_cast<SizeValueType>(x);
+    return ((m_Bits[bitNumber / 64] >> (bitNumber % 64)) & 1) != 0;
+  }
+
+  /** Returns the bounding box of the non-zero voxels, as an image region of the mask image. */
+  itkGetConstReferenceMacro(BoundingBoxRegion, RegionType);
+
+  /** Returns the number of non-zero voxels. */
+  itkGetConstMacro(NumberOfInsideVoxels, SizeValueType);
+
+protected:
+  PackedImageMask() = default;
+  ~PackedImageMask() override = default;
+
+  /** PrintSelf. */
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  PackedImageMask(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+
+  /** Packs the voxels of the specified mask image. */
+  void
+  Pack(const MaskImageType & maskImage);
+
+  /** The mask image is only used for its geometry (to convert points to indices). */
+  MaskImageConstPointer     m_MaskImage;
+  const SpatialObjectType * m_SpatialObject{ nullptr };
+  ModifiedTimeType          m_SpatialObjectMTime{ 0 };
+  ModifiedTimeType          m_MaskImageMTime{ 0 };
+
+  RegionType                 m_BoundingBoxRegion;
+  SizeValueType              m_NumberOfInsideVoxels{ 0 };
+  std::vector<RunType>       m_Runs;
+  std::vector<std::uint64_t> m_Bits;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkPackedImageMask.hxx"
+#endif
+
+#endif // end #ifndef itkPackedImageMask_h
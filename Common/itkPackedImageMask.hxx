@@ -0,0 +1,184 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkPackedImageMask_hxx
+#define itkPackedImageMask_hxx
+
+#include "itkPackedImageMask.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+
+#include <algorithm> // For min and max.
+
+namespace itk
+{
+
+/**
+ * ******************* CreateFromSpatialObject *******************
+ */
+
+template <unsigned int VDimension>
+auto
+PackedImageMask<VDimension>::CreateFromSpatialObject(const SpatialObjectType * const spatialObject) -> Pointer
+{
+  const auto imageMaskSpatialObject = dynamic_cast<const ImageMaskSpatialObjectType *>(spatialObject);
+  if ((imageMaskSpatialObject == nullptr) || (imageMaskSpatialObject->GetImage() == nullptr))
+  {
+    return nullptr;
+  }
+
+  /** The packed mask does not support any object-to-world transformation. */
+  const auto * const objectToWorldTransform = imageMaskSpatialObject->GetObjectToWorldTransform();
+  if (objectToWorldTransform != nullptr)
+  {
+    const auto & matrix = objectToWorldTransform->GetMatrix();
+    const auto & offset = objectToWorldTransform->GetOffset();
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      for (unsigned int j = 0; j < ImageDimension; ++j)
+      {
+        if (matrix[i][j] != ((i == j) ? 1.0 : 0.0))
+        {
+          return nullptr;
+        }
+      }
+      if (offset[i] != 0.0)
+      {
+        return nullptr;
+      }
+    }
+  }
+
+  const MaskImageType & maskImage = *(imageMaskSpatialObject->GetImage());
+  const auto            packedMask = Self::New();
+  packedMask->m_MaskImage = &maskImage;
+  packedMask->m_SpatialObject = spatialObject;
+  packedMask->m_SpatialObjectMTime = spatialObject->GetMTime();
+  packedMask->m_MaskImageMTime = maskImage.GetMTime();
+  packedMask->Pack(maskImage);
+  return packedMask;
+
+} // end CreateFromSpatialObject()
+
+
+/**
+ * ******************* IsCreatedFrom *******************
+ */
+
+template <unsigned int VDimension>
+bool
+PackedImageMask<VDimension>::IsCreatedFrom(const SpatialObjectType * const spatialObject) const
+{
+  return (spatialObject != nullptr) && (spatialObject == m_SpatialObject) &&
+         (spatialObject->GetMTime() == m_SpatialObjectMTime) && (m_MaskImage->GetMTime() == m_MaskImageMTime);
+
+} // end IsCreatedFrom()
+
+
+/**
+ * ******************* Pack *******************
+ */
+
+template <unsigned int VDimension>
+void
+PackedImageMask<VDimension>::Pack(const MaskImageType & maskImage)
+{
+  const RegionType & bufferedRegion = maskImage.GetBufferedRegion();
+
+  /** Compute the bounding box of the non-zero voxels. */
+  IndexType minimumIndex;
+  IndexType maximumIndex;
+  minimumIndex.Fill(NumericTraits<IndexValueType>::max());
+  maximumIndex.Fill(NumericTraits<IndexValueType>::NonpositiveMin());
+  m_NumberOfInsideVoxels = 0;
+
+  for (ImageRegionConstIteratorWithIndex<MaskImageType> it(&maskImage, bufferedRegion); !it.IsAtEnd(); ++it)
+  {
+    if (it.Get() != NumericTraits<MaskPixelType>::ZeroValue())
+    {
+      const IndexType & index = it.GetIndex();
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        minimumIndex[i] = std::min(minimumIndex[i], index[i]);
+        maximumIndex[i] = std::max(maximumIndex[i], index[i]);
+      }
+      ++m_NumberOfInsideVoxels;
+    }
+  }
+
+  m_Runs.clear();
+  m_Bits.clear();
+
+  if (m_NumberOfInsideVoxels == 0)
+  {
+    /** An empty region: nothing is inside. */
+    m_BoundingBoxRegion = RegionType();
+    return;
+  }
+
+  typename RegionType::SizeType boxSize;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    boxSize[i] = static_cast<SizeValueType>(maximumIndex[i] - minimumIndex[i] + 1);
+  }
+  m_BoundingBoxRegion = RegionType(minimumIndex, boxSize);
+
+  /** Store the bits and the runs, row by row (along the first dimension). */
+  const SizeValueType rowLength = boxSize[0];
+  const SizeValueType numberOfVoxels = m_BoundingBoxRegion.GetNumberOfPixels();
+
+  m_Runs.assign(numberOfVoxels / rowLength, RunType(0, 0));
+  m_Bits.assign((numberOfVoxels + 63) / 64, 0);
+
+  SizeValueType voxelNumber = 0;
+  for (ImageRegionConstIterator<MaskImageType> it(&maskImage, m_BoundingBoxRegion); !it.IsAtEnd(); ++it, ++voxelNumber)
+  {
+    if (it.Get() != NumericTraits<MaskPixelType>::ZeroValue())
+    {
+      m_Bits[voxelNumber / 64] |= std::uint64_t{ 1 } << (voxelNumber % 64);
+
+      RunType &            run = m_Runs[voxelNumber / rowLength];
+      const IndexValueType x = static_cast<IndexValueType>(voxelNumber % rowLength);
+      if (run.second == 0)
+      {
+        run.first = x;
+      }
+      run.second = x + 1;
+    }
+  }
+
+} // end Pack()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template <unsigned int VDimension>
+void
+PackedImageMask<VDimension>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "BoundingBoxRegion: " << m_BoundingBoxRegion << std::endl;
+  os << indent << "NumberOfInsideVoxels: " << m_NumberOfInsideVoxels << std::endl;
+
+} // end PrintSelf()
+
+} // end namespace itk
+
+#endif // end #ifndef itkPackedImageMask_hxx
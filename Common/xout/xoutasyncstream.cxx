@@ -0,0 +1,241 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "xoutasyncstream.h"
+
+#include <algorithm> // For copy_n and min.
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace xoutlibrary
+{
+
+/**
+ * \class xoutasyncstream::Buffer
+ * \brief The stream buffer of xoutasyncstream.
+ *
+ * The put area of the stream buffer is a chunk of characters. When the chunk
+ * is full, or when the stream is flushed, the chunk is pushed into the ring
+ * buffer, or dropped when the ring buffer does not have enough room. There is
+ * exactly one producer (the thread writing to the stream) and one consumer
+ * (the background thread), so that the ring buffer only needs two atomic
+ * counters: the total number of characters pushed, and popped.
+ */
+
+class xoutasyncstream::Buffer : public std::streambuf
+{
+public:
+  Buffer(std::ostream & target, const std::size_t capacity)
+    : m_Target(target)
+    , m_Ring((capacity > ChunkSize) ? capacity : ChunkSize)
+  {
+    this->setp(m_Chunk.data(), m_Chunk.data() + m_Chunk.size());
+  }
+
+
+  ~Buffer() override
+  {
+    this->PushChunk();
+    m_Stopping.store(true, std::memory_order_release);
+    m_WakeUp.notify_one();
+    m_Thread.join();
+  }
+
+
+  std::size_t
+  GetNumberOfDroppedCharacters(void) const
+  {
+    return m_NumberOfDroppedCharacters.load(std::memory_order_relaxed);
+  }
+
+protected:
+  int_type
+  overflow(const int_type ch) override
+  {
+    this->PushChunk();
+
+    if (!traits_type::eq_int_type(ch, traits_type::eof()))
+    {
+      *(this->pptr()) = traits_type::to_char_type(ch);
+      this->pbump(1);
+    }
+    return traits_type::not_eof(ch);
+  }
+
+
+  /** Called on a flush (for example by std::endl). Does not wait for the target stream. */
+  int
+  sync(void) override
+  {
+    this->PushChunk();
+    m_FlushRequested.store(true, std::memory_order_release);
+    m_WakeUp.notify_one();
+    return 0;
+  }
+
+private:
+  static constexpr std::size_t ChunkSize = 4096;
+
+  /** Pushes the characters of the put area into the ring buffer (or drops them), and empties the put area. */
+  void
+  PushChunk(void)
+  {
+    const auto size = static_cast<std::size_t>(this->pptr() - this->pbase());
+
+    if (size > 0)
+    {
+      const auto head = m_Head.load(std::memory_order_relaxed);
+      const auto tail = m_Tail.load(std::memory_order_acquire);
+      const auto capacity = m_Ring.size();
+
+      if (capacity - (head - tail) >= size)
+      {
+        const auto begin = head % capacity;
+        const auto sizeOfFirstPart = std::min(size, capacity - begin);
+        std::copy_n(this->pbase(), sizeOfFirstPart, m_Ring.data() + begin);
+        std::copy_n(this->pbase() + sizeOfFirstPart, size - sizeOfFirstPart, m_Ring.data());
+        m_Head.store(head + size, std::memory_order_release);
+      }
+      else
+      {
+        m_NumberOfDroppedCharacters.fetch_add(size, std::memory_order_relaxed);
+      }
+      this->setp(m_Chunk.data(), m_Chunk.data() + m_Chunk.size());
+    }
+  }
+
+
+  /** Writes all characters from the ring buffer to the target stream. Only called by the background thread. */
+  void
+  WritePendingCharacters(void)
+  {
+    const auto head = m_Head.load(std::memory_order_acquire);
+    const auto tail = m_Tail.load(std::memory_order_relaxed);
+
+    if (head != tail)
+    {
+      const auto size = head - tail;
+      const auto capacity = m_Ring.size();
+      const auto begin = tail % capacity;
+      const auto sizeOfFirstPart = std::min(size, capacity - begin);
+      m_Target.write(m_Ring.data() + begin, static_cast<std::streamsize>(sizeOfFirstPart));
+      m_Target.write(m_Ring.data(), static_cast<std::streamsize>(size - sizeOfFirstPart));
+      m_Tail.store(head, std::memory_order_release);
+    }
+  }
+
+
+  /** The function executed by the background thread. */
+  void
+  Run(void)
+  {
+    std::size_t numberOfReportedDroppedCharacters = 0;
+
+    for (;;)
+    {
+      /** Any output pushed before stopping is written by the following call. */
+      const bool stopping = m_Stopping.load(std::memory_order_acquire);
+
+      this->WritePendingCharacters();
+
+      const auto numberOfDroppedCharacters = this->GetNumberOfDroppedCharacters();
+      if (numberOfDroppedCharacters != numberOfReportedDroppedCharacters)
+      {
+        m_Target << "\n[xout: " << (numberOfDroppedCharacters - numberOfReportedDroppedCharacters)
+                 << " characters of output were dropped, because the output could not be written fast enough]\n";
+        numberOfReportedDroppedCharacters = numberOfDroppedCharacters;
+      }
+
+      if (m_FlushRequested.exchange(false, std::memory_order_acq_rel) || stopping)
+      {
+        m_Target.flush();
+      }
+
+      if (stopping)
+      {
+        return;
+      }
+
+      /** The producer notifies without locking the mutex, so a notification may occasionally be missed.
+       * The timeout ensures that the pending output is still written soon afterwards. */
+      std::unique_lock<std::mutex> lock(m_WakeUpMutex);
+      m_WakeUp.wait_for(lock, std::chrono::milliseconds(50), [this] {
+        return m_Stopping.load(std::memory_order_acquire) || m_FlushRequested.load(std::memory_order_acquire) ||
+               (m_Head.load(std::memory_order_acquire) != m_Tail.load(std::memory_order_relaxed));
+      });
+    }
+  }
+
+
+  std::ostream &              m_Target;
+  std::vector<char>           m_Ring;
+  std::array<char, ChunkSize> m_Chunk;
+  std::atomic<std::size_t>    m_Head{ 0 };
+  std::atomic<std::size_t>    m_Tail{ 0 };
+  std::atomic<std::size_t>    m_NumberOfDroppedCharacters{ 0 };
+  std::atomic<bool>           m_FlushRequested{ false };
+  std::atomic<bool>           m_Stopping{ false };
+  std::mutex                  m_WakeUpMutex;
+  std::condition_variable     m_WakeUp;
+  std::thread                 m_Thread{ [this] { this->Run(); } };
+};
+
+
+/**
+ * ************************ Constructor *************************
+ */
+
+xoutasyncstream::xoutasyncstream(std::ostream & target, const std::size_t capacity)
+  : Superclass(nullptr)
+  , m_Buffer(std::make_unique<Buffer>(target, capacity))
+{
+  this->rdbuf(m_Buffer.get());
+
+} // end Constructor
+
+
+/**
+ * ************************ Destructor *************************
+ */
+
+xoutasyncstream::~xoutasyncstream()
+{
+  this->flush();
+  this->rdbuf(nullptr);
+
+} // end Destructor
+
+
+/**
+ * ****************** GetNumberOfDroppedCharacters **************
+ */
+
+std::size_t
+xoutasyncstream::GetNumberOfDroppedCharacters(void) const
+{
+  return m_Buffer->GetNumberOfDroppedCharacters();
+
+} // end GetNumberOfDroppedCharacters()
+
+} // end namespace xoutlibrary
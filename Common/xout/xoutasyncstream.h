@@ -0,0 +1,86 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef xoutasyncstream_h
+#define xoutasyncstream_h
+
+#include <cstddef> // For size_t.
+#include <memory>  // For unique_ptr.
+#include <ostream>
+
+namespace xoutlibrary
+{
+
+/**
+ * \class xoutasyncstream
+ * \brief An output stream that passes its output to a target stream by a background thread.
+ *
+ * The xoutasyncstream class may be used as an output of xout, instead of
+ * (for example) a log file stream or std::cout, in order not to let the
+ * registration wait for slow I/O, for example when the log file is on a
+ * network file system.
+ *
+ * The characters written to the stream are collected in chunks, which are
+ * pushed into a lock-free ring buffer of fixed capacity. A background
+ * thread pops them from the ring buffer, and writes them to the target
+ * stream. A flush (for example by std::endl) does not wait for the target
+ * stream; instead, the background thread flushes the target stream once it
+ * has written all pending output. When the ring buffer is full, a chunk is
+ * dropped (rather than waiting, or allocating more memory), and the number
+ * of dropped characters is reported to the target stream afterwards.
+ *
+ * Like any std::ostream, an xoutasyncstream should only be written to by
+ * one thread at a time. The target stream should not be written to
+ * directly while it is in use by an xoutasyncstream. The destructor writes
+ * all pending output to the target stream, and flushes it.
+ *
+ * \ingroup xout
+ */
+
+class xoutasyncstream : public std::ostream
+{
+public:
+  /** Typedef's. */
+  typedef xoutasyncstream Self;
+  typedef std::ostream    Superclass;
+
+  /** The default capacity of the ring buffer, in number of characters. */
+  static constexpr std::size_t DefaultCapacity = std::size_t{ 1 } << 20;
+
+  /** Constructor. The target stream should stay alive as long as this stream. */
+  explicit xoutasyncstream(std::ostream & target, const std::size_t capacity = DefaultCapacity);
+
+  /** Destructor. Writes all pending output to the target stream, and stops the background thread. */
+  ~xoutasyncstream() override;
+
+  /** Returns the number of characters that were dropped so far, because the ring buffer was full. */
+  std::size_t
+  GetNumberOfDroppedCharacters(void) const;
+
+  xoutasyncstream(const Self &) = delete;
+  Self &
+  operator=(const Self &) = delete;
+
+private:
+  class Buffer;
+
+  const std::unique_ptr<Buffer> m_Buffer;
+};
+
+} // end namespace xoutlibrary
+
+#endif // end #ifndef xoutasyncstream_h
@@ -20,9 +20,21 @@
 
 namespace xoutlibrary
 {
+namespace
+{
+// The xout object of the calling thread, or null when the thread uses the process-wide one.
+thread_local xoutmain * thread_xout = nullptr;
+} // namespace
+
+
 xoutmain &
 get_xout(void)
 {
+  if (thread_xout != nullptr)
+  {
+    return *thread_xout;
+  }
+
   // Note: C++11 "magic statics" ensures that the construction of a local
   // static variable like this is thread-safe.
   static xoutmain local_xout;
@@ -30,4 +42,13 @@ get_xout(void)
   return local_xout;
 }
 
+
+xoutmain *
+set_xout(xoutmain * const arg)
+{
+  xoutmain * const previous = thread_xout;
+  thread_xout = arg;
+  return previous;
+}
+
 } // namespace xoutlibrary
@@ -23,6 +23,7 @@
 #include "xoutsimple.h"
 #include "xoutrow.h"
 #include "xoutcell.h"
+#include "xoutasyncstream.h"
 
 /** Define a namespace alias. */
 namespace xl = xoutlibrary;
@@ -35,11 +36,41 @@ namespace xoutlibrary
 
 /** The main xout class */
 class xoutmain : public xoutbase
-{};
+{
+public:
+  /** Set/Get whether the outputs of this xout object are written asynchronously, by xoutasyncstream
+   * objects. Other streams that receive the same output (like the IterationInfo file of elastix) may
+   * then be written asynchronously as well.
+   */
+  void
+  SetAsynchronous(const bool arg)
+  {
+    m_Asynchronous = arg;
+  }
+
+  bool
+  GetAsynchronous(void) const
+  {
+    return m_Asynchronous;
+  }
 
+private:
+  bool m_Asynchronous{ false };
+};
+
+/** Returns the xout object of the calling thread, when one is set by set_xout().
+ * Otherwise returns the process-wide xout object.
+ */
 xoutmain &
 get_xout(void);
 
+/** Sets the xout object that get_xout() returns for the calling thread, allowing
+ * concurrent registrations to have their own log outputs. Passing null restores
+ * the process-wide xout object. Returns the previously set object (possibly null).
+ */
+xoutmain *
+set_xout(xoutmain * arg);
+
 } // end namespace xoutlibrary
 
 #endif // end #ifndef xoutmain_h
@@ -43,6 +43,9 @@ namespace elastix
  *    The default order is 1. The parameter can be specified for each resolution.\n
  *    If only given for one resolution, that value is used for the other resolutions as well.
  *
+ * When the FixedImageDataCache has an on-disk directory (see FixedImageDataCacheDirectory), the B-spline
+ * coefficients of the moving image pyramid images are cached on disk, keyed by the content of the moving image.
+ *
  * \ingroup Interpolators
  */
 
@@ -108,6 +111,13 @@ public:
   void
   BeforeEachResolution(void) override;
 
+  /** Set the input image, and compute its B-spline coefficients. When the moving image data are cached on disk (see
+   * FixedImageDataCache), the coefficients of the moving image pyramid images are retrieved from the cache, when
+   * available, and stored into the cache otherwise.
+   */
+  void
+  SetInputImage(const InputImageType * inputData) override;
+
 protected:
   /** The constructor. */
   BSplineInterpolator() = default;
@@ -56,6 +56,56 @@ BSplineInterpolator<TElastix>::BeforeEachResolution(void)
 } // end BeforeEachResolution()
 
 
+/**
+ * ***************** SetInputImage ***********************
+ */
+
+template <class TElastix>
+void
+BSplineInterpolator<TElastix>::SetInputImage(const InputImageType * inputData)
+{
+  /** Only the coefficients of the moving image pyramid images are cached, and only when a moving image content key is
+   * specified, which is the case when the cache has a directory for its on-disk data. */
+  FixedImageDataCache * const cache =
+    (this->m_Elastix == nullptr) ? nullptr : this->GetElastix()->GetFixedImageDataCache();
+
+  if ((inputData == nullptr) || (cache == nullptr) || (this->m_Registration == nullptr) ||
+      this->GetElastix()->GetMovingImageDataCacheContentKey().empty())
+  {
+    Superclass1::SetInputImage(inputData);
+    return;
+  }
+
+  const unsigned int level = (this->m_Registration->GetAsITKBaseType())->GetCurrentLevel();
+  if (inputData != this->GetElastix()->GetElxMovingImagePyramidBase()->GetAsITKBaseType()->GetOutput(level))
+  {
+    Superclass1::SetInputImage(inputData);
+    return;
+  }
+
+  const std::string key = this->GetElastix()->MakeMovingImageDataCacheKey(
+    "MovingBSplineCoefficients" + std::to_string(this->GetSplineOrder()),
+    this->GetConfiguration()->GetElastixLevel(),
+    level);
+
+  if (const auto cachedCoefficients = cache->GetImage<CoefficientImageType>(key, false))
+  {
+    /** Skip the B-spline decomposition, which is what Superclass1::SetInputImage() spends its time on. */
+    Superclass1::Superclass::SetInputImage(inputData);
+    this->m_Coefficients = cachedCoefficients;
+    this->m_DataLength = inputData->GetBufferedRegion().GetSize();
+    return;
+  }
+
+  Superclass1::SetInputImage(inputData);
+
+  const auto coefficients = CoefficientImageType::New();
+  coefficients->Graft(this->m_Coefficients.GetPointer());
+  cache->SetImage(key, coefficients.GetPointer(), false);
+
+} // end SetInputImage()
+
+
 } // end namespace elastix
 
 #endif // end #ifndef elxBSplineInterpolator_hxx
@@ -181,6 +181,8 @@ protected:
   using typename Superclass::ParzenValueContainerType;
   using typename Superclass::KernelFunctionType;
   using typename Superclass::NonZeroJacobianIndicesType;
+  using typename Superclass::PRatioType;
+  using typename Superclass::PRatioArrayType;
 
   /**  Get the value and analytic derivative.
    * Called by GetValueAndDerivative if UseFiniteDifferenceDerivative == false.
@@ -225,10 +227,6 @@ protected:
                                 DerivativeType &                   preconditioner,
                                 DerivativeType &                   divisor) const;
 
-  /** Some initialization functions, called by Initialize. */
-  void
-  InitializeHistograms(void) override;
-
   /** Threading related parameters. */
   struct ParzenWindowMutualInformationMultiThreaderParameterType
   {
@@ -259,11 +257,6 @@ private:
   void
   operator=(const Self &) = delete;
 
-  /** Helper array for storing the values of the JointPDF ratios. */
-  typedef double              PRatioType;
-  typedef Array2D<PRatioType> PRatioArrayType;
-  mutable PRatioArrayType     m_PRatioArray;
-
   /** Setting */
   bool m_UseJacobianPreconditioning;
 
@@ -271,16 +264,11 @@ private:
   void
   ComputeDerivativeLowMemorySingleThreaded(DerivativeType & derivative) const;
 
+  /** Computes the derivative for the low memory variant, like the superclass, but
+   * additionally supports the Jacobian preconditioning.
+   */
   void
-  ComputeDerivativeLowMemory(DerivativeType & derivative) const;
-
-  /** Helper function to update the derivative for the low memory variant. */
-  void
-  UpdateDerivativeLowMemory(const RealType &                   fixedImageValue,
-                            const RealType &                   movingImageValue,
-                            const DerivativeType &             imageJacobian,
-                            const NonZeroJacobianIndicesType & nzji,
-                            DerivativeType &                   derivative) const;
+  ComputeDerivativeLowMemory(DerivativeType & derivative) const override;
 
   /** Helper function to compute m_PRatioArray in case of low memory consumption. */
   void
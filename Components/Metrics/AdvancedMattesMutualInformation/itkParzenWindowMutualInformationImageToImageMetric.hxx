@@ -49,26 +49,6 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage,
 } // end constructor
 
 
-/**
- * ********************* InitializeHistograms ******************************
- */
-
-template <class TFixedImage, class TMovingImage>
-void
-ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::InitializeHistograms(void)
-{
-  /** Call Superclass implementation. */
-  this->Superclass::InitializeHistograms();
-
-  /** Allocate small amount of memory for the m_PRatioArray. */
-  if (!this->GetUseExplicitPDFDerivatives())
-  {
-    this->m_PRatioArray.SetSize(this->GetNumberOfFixedHistogramBins(), this->GetNumberOfMovingHistogramBins());
-  }
-
-} // end InitializeHistograms()
-
-
 /**
  * ************************** GetValue **************************
  */
@@ -735,92 +715,6 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Comp
 } // end ComputeValueAndPRatioArray()
 
 
-/**
- * ******************* UpdateDerivativeLowMemory *******************
- */
-
-template <class TFixedImage, class TMovingImage>
-void
-ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::UpdateDerivativeLowMemory(
-  const RealType &                   fixedImageValue,
-  const RealType &                   movingImageValue,
-  const DerivativeType &             imageJacobian,
-  const NonZeroJacobianIndicesType & nzji,
-  DerivativeType &                   derivative) const
-{
-  /** In this function we need to do (see eq. 24 of Thevenaz [3]):
-   *      derivative -= constant * imageJacobian *
-   *          \sum_i \sum_k PRatio(i,k) * dB/dxi(xi,i,k),
-   * with i, k, the fixed and moving histogram bins,
-   * PRatio the precomputed log( p(i,k) / p(i) ), and
-   * dB/dxi the B-spline derivative.
-   *
-   * Note (1) that we only have to loop over i,k within the support
-   * of the B-spline Parzen-window.
-   * Note (2) that imageJacobian may be sparse.
-   */
-
-  /** Determine the affected region. */
-
-  /** Determine Parzen window arguments (see eq. 6 of Mattes paper [2]). */
-  const double fixedImageParzenWindowTerm =
-    fixedImageValue / this->m_FixedImageBinSize - this->m_FixedImageNormalizedMin;
-  const double movingImageParzenWindowTerm =
-    movingImageValue / this->m_MovingImageBinSize - this->m_MovingImageNormalizedMin;
-
-  /** The lowest bin numbers affected by this pixel: */
-  const int fixedParzenWindowIndex =
-    static_cast<int>(std::floor(fixedImageParzenWindowTerm + this->m_FixedParzenTermToIndexOffset));
-  const int movingParzenWindowIndex =
-    static_cast<int>(std::floor(movingImageParzenWindowTerm + this->m_MovingParzenTermToIndexOffset));
-
-  /** Compute the fixed Parzen values. */
-  ParzenValueContainerType fixedParzenValues(this->m_JointPDFWindow.GetSize()[1]);
-  this->EvaluateParzenValues(
-    fixedImageParzenWindowTerm, fixedParzenWindowIndex, this->m_FixedKernel, fixedParzenValues);
-
-  /** Compute the derivatives of the moving Parzen window. */
-  ParzenValueContainerType derivativeMovingParzenValues(this->m_JointPDFWindow.GetSize()[0]);
-  this->EvaluateParzenValues(
-    movingImageParzenWindowTerm, movingParzenWindowIndex, this->m_DerivativeMovingKernel, derivativeMovingParzenValues);
-
-  /** Get the moving image bin size. */
-  const double et = static_cast<double>(this->m_MovingImageBinSize);
-
-  /** Loop over the Parzen window region and increment sum. */
-  PDFValueType sum = 0.0;
-  for (unsigned int f = 0; f < fixedParzenValues.GetSize(); ++f)
-  {
-    const double fv_et = fixedParzenValues[f] / et;
-    for (unsigned int m = 0; m < derivativeMovingParzenValues.GetSize(); ++m)
-    {
-      sum += this->m_PRatioArray[f + fixedParzenWindowIndex][m + movingParzenWindowIndex] * fv_et *
-             derivativeMovingParzenValues[m];
-    }
-  }
-
-  /** Now compute derivative -= sum * imageJacobian. */
-  if (nzji.size() == this->GetNumberOfParameters())
-  {
-    /** Loop over all Jacobians. */
-    for (unsigned int mu = 0; mu < this->GetNumberOfParameters(); ++mu)
-    {
-      derivative[mu] += static_cast<DerivativeValueType>(imageJacobian[mu] * sum);
-    }
-  }
-  else
-  {
-    /** Loop only over the non-zero Jacobians. */
-    for (unsigned int i = 0; i < imageJacobian.GetSize(); ++i)
-    {
-      const unsigned int mu = nzji[i];
-      derivative[mu] += static_cast<DerivativeValueType>(imageJacobian[i] * sum);
-    }
-  }
-
-} // end UpdateDerivativeLowMemory()
-
-
 /**
  * ******************** GetValueAndFiniteDifferenceDerivative *******************
  */
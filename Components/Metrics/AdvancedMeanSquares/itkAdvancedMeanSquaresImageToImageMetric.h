@@ -147,7 +147,8 @@ public:
                         MeasureType &                   value,
                         DerivativeType &                derivative) const override;
 
-  /** Experimental feature: compute SelfHessian */
+  /** Experimental feature: compute SelfHessian. The noise that is added to the moving image derivative (see
+   * SelfHessianNoiseRange) is drawn from a clock-seeded generator, so it is not reproducible by "RandomSeed". */
   void
   GetSelfHessian(const TransformParametersType & parameters, HessianType & H) const override;
 
@@ -207,6 +208,7 @@ protected:
   using typename Superclass::CentralDifferenceGradientFilterType;
   using typename Superclass::MovingImageDerivativeType;
   using typename Superclass::NonZeroJacobianIndicesType;
+  using typename Superclass::RandomGeneratorType;
 
   /** Protected typedefs for SelfHessian */
   typedef SmoothingRecursiveGaussianImageFilter<FixedImageType, FixedImageType>         SmootherType;
@@ -20,7 +20,6 @@
 
 #include "itkAdvancedMeanSquaresImageToImageMetric.h"
 #include <vnl/algo/vnl_matrix_update.h>
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkComputeImageExtremaFilter.h"
 
 #ifdef ELASTIX_USE_OPENMP
@@ -855,11 +854,13 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetSelfHessian
   HessianType &                   H) const
 {
   itkDebugMacro("GetSelfHessian()");
-  typedef Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
 
   /** Initialize some variables. */
   this->m_NumberOfPixelsCounted = 0;
-  RandomGeneratorType::Pointer randomGenerator = RandomGeneratorType::GetInstance();
+
+  /** The noise is drawn from a generator of its own, seeded from the clock. So it neither depends on, nor disturbs,
+   * the random sequence of the registration. */
+  const auto randomGenerator = RandomGeneratorType::New();
   randomGenerator->Initialize();
 
   /** Array that stores dM(x)/dmu, and the sparse jacobian+indices. */
@@ -39,6 +39,11 @@ namespace elastix
  * The parameters used in this class are:
  * \parameter Metric: Select this metric as follows:\n
  *    <tt>(Metric "TransformBendingEnergyPenalty")</tt>
+ * \parameter UseGridBasedBendingEnergy: Compute the bending energy exactly, on the grid of
+ *    a third order B-spline transform, instead of estimating it from the samples. The
+ *    masks are then not taken into account. Falls back to the samples for other transforms.\n
+ *    example: <tt>(UseGridBasedBendingEnergy "true" "false")</tt>\n
+ *    Can be specified for each resolution. The default is "false".
  *
  * \ingroup Metrics
  *
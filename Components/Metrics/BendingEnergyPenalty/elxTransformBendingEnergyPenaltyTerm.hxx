@@ -59,6 +59,12 @@ TransformBendingEnergyPenalty<TElastix>::BeforeEachResolution(void)
     numberOfSamplesForSelfHessian, "NumberOfSamplesForSelfHessian", this->GetComponentLabel(), level, 0);
   this->SetNumberOfSamplesForSelfHessian(numberOfSamplesForSelfHessian);
 
+  /** Set whether the bending energy is computed on the B-spline grid. */
+  bool useGridBasedBendingEnergy = false;
+  this->GetConfiguration()->ReadParameter(
+    useGridBasedBendingEnergy, "UseGridBasedBendingEnergy", this->GetComponentLabel(), level, 0);
+  this->SetUseGridBasedBendingEnergy(useGridBasedBendingEnergy);
+
 } // end BeforeEachResolution()
 
 
@@ -21,6 +21,9 @@
 #include "itkTransformPenaltyTerm.h"
 #include "itkImageGridSampler.h"
 
+#include <array>
+#include <vector>
+
 namespace itk
 {
 
@@ -43,6 +46,14 @@ namespace itk
  *      "Itk::Transforms supporting spatial derivatives"",
  *      Insight Journal, http://hdl.handle.net/10380/3215.
  *
+ * For a third order B-spline transform, the bending energy may alternatively
+ * be computed exactly, on the B-spline grid, see SetUseGridBasedBendingEnergy().
+ * The integral of the squared second order derivatives is then a quadratic
+ * form in the B-spline coefficients, which is computed by small separable
+ * stencils (the Gram matrices of the one-dimensional B-spline derivatives).
+ * It does not need any samples, and the derivative is computed in the same
+ * pass.
+ *
  * \ingroup Metrics
  */
 
@@ -158,6 +169,14 @@ public:
   itkSetMacro(NumberOfSamplesForSelfHessian, unsigned int);
   itkGetConstMacro(NumberOfSamplesForSelfHessian, unsigned int);
 
+  /** Compute the bending energy exactly, on the grid of a third order B-spline transform, instead of estimating it
+   * from the samples. The value is then the integral of the bending energy over the fixed image region (within the
+   * valid region of the B-spline grid), divided by its volume. The masks are not taken into account. Falls back to
+   * the sample-based computation for other transforms. Default: false.
+   */
+  itkSetMacro(UseGridBasedBendingEnergy, bool);
+  itkGetConstMacro(UseGridBasedBendingEnergy, bool);
+
 protected:
   /** Typedefs for indices and points. */
   using typename Superclass::FixedImageIndexType;
@@ -177,6 +196,14 @@ protected:
   /** The destructor. */
   ~TransformBendingEnergyPenaltyTerm() override = default;
 
+  /** Computes the value and the derivative exactly, on the B-spline grid. Returns false, without computing anything,
+   * when the transform is not (or not only) a third order B-spline transform.
+   */
+  bool
+  GetGridBasedValueAndDerivative(const ParametersType & parameters,
+                                 MeasureType &          value,
+                                 DerivativeType &       derivative) const;
+
 private:
   /** The deleted copy constructor. */
   TransformBendingEnergyPenaltyTerm(const Self &) = delete;
@@ -184,7 +211,22 @@ private:
   void
   operator=(const Self &) = delete;
 
+  /** The band of a one-dimensional Gram matrix: the entries (n, n - 3) to (n, n + 3), for each row n. */
+  typedef std::vector<std::array<double, 7>> GramMatrixBandType;
+
+  /** Computes the band of the Gram matrix of the derivatives of the given order (0, 1 or 2) of the cubic B-spline
+   * basis functions, centered at firstIndex, ..., firstIndex + numberOfBasisFunctions - 1, integrated over the
+   * interval [begin, end] (in continuous grid indices).
+   */
+  static GramMatrixBandType
+  ComputeGramMatrixBand(const double         begin,
+                        const double         end,
+                        const IndexValueType firstIndex,
+                        const SizeValueType  numberOfBasisFunctions,
+                        const unsigned int   derivativeOrder);
+
   unsigned int m_NumberOfSamplesForSelfHessian;
+  bool         m_UseGridBasedBendingEnergy;
 };
 
 } // end namespace itk
@@ -19,6 +19,12 @@
 #define itkTransformBendingEnergyPenaltyTerm_hxx
 
 #include "itkTransformBendingEnergyPenaltyTerm.h"
+#include "itkBSplineKernelFunction2.h"
+#include "itkBSplineDerivativeKernelFunction2.h"
+#include "itkBSplineSecondOrderDerivativeKernelFunction2.h"
+
+#include <algorithm> // For max and min.
+#include <cmath>     // For floor and ceil.
 
 #ifdef ELASTIX_USE_OPENMP
 #  include <omp.h>
@@ -40,6 +46,7 @@ TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::TransformBendingEne
   this->SetUseImageSampler(true);
 
   this->m_NumberOfSamplesForSelfHessian = 100000;
+  this->m_UseGridBasedBendingEnergy = false;
 
 } // end Constructor
 
@@ -64,6 +71,17 @@ TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::GetValue(const Para
     return static_cast<MeasureType>(measure);
   }
 
+  /** Compute the bending energy on the B-spline grid, if requested and possible. */
+  if (this->m_UseGridBasedBendingEnergy)
+  {
+    MeasureType    value = NumericTraits<MeasureType>::Zero;
+    DerivativeType derivative;
+    if (this->GetGridBasedValueAndDerivative(parameters, value, derivative))
+    {
+      return value;
+    }
+  }
+
   /** Call non-thread-safe stuff, such as:
    *   this->SetTransformParameters( parameters );
    *   this->GetImageSampler()->Update();
@@ -355,6 +373,12 @@ TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivati
                                                                                    MeasureType &          value,
                                                                                    DerivativeType & derivative) const
 {
+  /** Compute the bending energy on the B-spline grid, if requested and possible. */
+  if (this->m_UseGridBasedBendingEnergy && this->GetGridBasedValueAndDerivative(parameters, value, derivative))
+  {
+    return;
+  }
+
   /** Option for now to still use the single threaded code. */
   if (!this->m_UseMultiThread)
   {
@@ -646,6 +670,296 @@ TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::AfterThreadedGetVal
 } // end AfterThreadedGetValueAndDerivative()
 
 
+/**
+ * ******************* GetGridBasedValueAndDerivative *******************
+ */
+
+template <class TFixedImage, class TScalarType>
+bool
+TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::GetGridBasedValueAndDerivative(
+  const ParametersType & parameters,
+  MeasureType &          value,
+  DerivativeType &       derivative) const
+{
+  /** Check if the transform is a third order B-spline transform. */
+  BSplineOrder3TransformPointer bspline;
+  if (!this->CheckForBSplineTransform2(bspline) || bspline.IsNull())
+  {
+    return false;
+  }
+
+  /** An initial transform is only allowed when it is added, and when it has a zero spatial Hessian,
+   * because only then the spatial Hessian of the transform is the spatial Hessian of the B-spline.
+   */
+  const auto * const combinationTransform =
+    dynamic_cast<const CombinationTransformType *>(this->m_AdvancedTransform.GetPointer());
+  if (combinationTransform != nullptr)
+  {
+    const auto * const initialTransform = combinationTransform->GetInitialTransform();
+    if ((initialTransform != nullptr) &&
+        (!combinationTransform->GetUseAddition() || initialTransform->GetHasNonZeroSpatialHessian()))
+    {
+      return false;
+    }
+  }
+
+  /** Get the geometry of the B-spline grid. The parameters of dimension k are the coefficients
+   * k * numberOfCoefficients, ..., (k + 1) * numberOfCoefficients - 1, in the order of the grid region.
+   */
+  typedef typename BSplineOrder3TransformType::RegionType GridRegionType;
+  const GridRegionType gridRegion = bspline->GetGridRegion();
+  const auto           gridSpacing = bspline->GetGridSpacing();
+  const auto           gridOrigin = bspline->GetGridOrigin();
+  const auto           inverseGridDirection = bspline->GetGridDirection().GetInverse();
+  const SizeValueType  numberOfCoefficients = gridRegion.GetNumberOfPixels();
+  if (parameters.GetSize() != FixedImageDimension * numberOfCoefficients)
+  {
+    return false;
+  }
+
+  /** Do the non-thread-safe stuff, like BeforeThreadedGetValueAndDerivative(), but without the sampler. */
+  if (this->m_UseMetricSingleThreaded)
+  {
+    this->SetTransformParameters(parameters);
+  }
+
+  /** Compute the domain of integration, in continuous grid indices: the bounding box of the fixed image
+   * region, intersected with the valid region of the B-spline grid, [start + 1, start + size - 2].
+   */
+  const FixedImageRegionType & fixedImageRegion = this->GetFixedImageRegion();
+  double                       domainBegin[FixedImageDimension];
+  double                       domainEnd[FixedImageDimension];
+  for (unsigned int i = 0; i < FixedImageDimension; ++i)
+  {
+    domainBegin[i] = NumericTraits<double>::max();
+    domainEnd[i] = NumericTraits<double>::NonpositiveMin();
+  }
+  for (unsigned int corner = 0; corner < (1u << FixedImageDimension); ++corner)
+  {
+    FixedImageIndexType cornerIndex = fixedImageRegion.GetIndex();
+    for (unsigned int i = 0; i < FixedImageDimension; ++i)
+    {
+      if ((corner >> i) & 1)
+      {
+        cornerIndex[i] += static_cast<FixedImageIndexValueType>(fixedImageRegion.GetSize(i)) - 1;
+      }
+    }
+    FixedImagePointType cornerPoint;
+    this->GetFixedImage()->TransformIndexToPhysicalPoint(cornerIndex, cornerPoint);
+
+    for (unsigned int i = 0; i < FixedImageDimension; ++i)
+    {
+      double gridIndex = 0.0;
+      for (unsigned int j = 0; j < FixedImageDimension; ++j)
+      {
+        gridIndex += inverseGridDirection(i, j) * (cornerPoint[j] - gridOrigin[j]);
+      }
+      gridIndex /= gridSpacing[i];
+      domainBegin[i] = std::min(domainBegin[i], gridIndex);
+      domainEnd[i] = std::max(domainEnd[i], gridIndex);
+    }
+  }
+
+  double volumeInGridUnits = 1.0;
+  for (unsigned int i = 0; i < FixedImageDimension; ++i)
+  {
+    const double gridStart = static_cast<double>(gridRegion.GetIndex(i));
+    domainBegin[i] = std::max(domainBegin[i], gridStart + 1.0);
+    domainEnd[i] = std::min(domainEnd[i], gridStart + static_cast<double>(gridRegion.GetSize(i)) - 2.0);
+    if (!(domainEnd[i] > domainBegin[i]))
+    {
+      itkExceptionMacro("The fixed image region does not overlap with the valid region of the B-spline grid.");
+    }
+    volumeInGridUnits *= domainEnd[i] - domainBegin[i];
+  }
+
+  /** Compute the bands of the Gram matrices, for each dimension and each derivative order. */
+  std::array<GramMatrixBandType, 3> gramMatrixBands[FixedImageDimension];
+  SizeValueType                     gridStrides[FixedImageDimension];
+  SizeValueType                     gridStride = 1;
+  for (unsigned int i = 0; i < FixedImageDimension; ++i)
+  {
+    for (unsigned int order = 0; order < 3; ++order)
+    {
+      gramMatrixBands[i][order] = Self::ComputeGramMatrixBand(
+        domainBegin[i], domainEnd[i], gridRegion.GetIndex(i), gridRegion.GetSize(i), order);
+    }
+    gridStrides[i] = gridStride;
+    gridStride *= gridRegion.GetSize(i);
+  }
+
+  /** Applies a band along the lines of the grid in one dimension: output = band * input, or, when
+   * accumulating, output += weight * band * input. The lines are processed in parallel.
+   */
+  const auto applyBand = [this, &gridRegion, &gridStrides, numberOfCoefficients](const GramMatrixBandType & band,
+                                                                                 const unsigned int dimension,
+                                                                                 const double *     input,
+                                                                                 double *           output,
+                                                                                 const bool         accumulate,
+                                                                                 const double       weight) {
+    const SizeValueType lineLength = gridRegion.GetSize(dimension);
+    const SizeValueType stride = gridStrides[dimension];
+
+    const auto applyBandToLine = [&band, input, output, accumulate, weight, lineLength, stride](
+                                   const SizeValueType lineNumber) {
+      const SizeValueType first = (lineNumber / stride) * stride * lineLength + lineNumber % stride;
+      for (SizeValueType n = 0; n < lineLength; ++n)
+      {
+        const std::array<double, 7> & row = band[n];
+        const SizeValueType           mBegin = (n < 3) ? 0 : (n - 3);
+        const SizeValueType           mEnd = std::min(n + 4, lineLength);
+
+        double sum = 0.0;
+        for (SizeValueType m = mBegin; m < mEnd; ++m)
+        {
+          sum += row[m + 3 - n] * input[first + m * stride];
+        }
+
+        double & out = output[first + n * stride];
+        out = accumulate ? (out + weight * sum) : sum;
+      }
+    };
+
+    const SizeValueType numberOfLines = numberOfCoefficients / lineLength;
+    if (this->m_UseMultiThread)
+    {
+      this->m_Threader->ParallelizeArray(0, numberOfLines, applyBandToLine, nullptr);
+    }
+    else
+    {
+      for (SizeValueType lineNumber = 0; lineNumber < numberOfLines; ++lineNumber)
+      {
+        applyBandToLine(lineNumber);
+      }
+    }
+  };
+
+  /** The bending energy of each dimension k of the transform is the quadratic form c_k^T K c_k, with
+   * K = sum_ij w_ij (G_0 x G_1 x ... ), where G_d is the Gram matrix of the derivative of order a_d, the
+   * number of times that d occurs in (i, j). The term for (i, j), with i != j, occurs twice. The weights
+   * w_ij take the grid spacing into account, as well as the normalization by the volume of the domain.
+   * The derivative is 2 K c_k, which is accumulated first, and then used to compute the value as well.
+   */
+  derivative = DerivativeType(this->GetNumberOfParameters());
+  derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+
+  std::vector<double> buffers[2] = { std::vector<double>(numberOfCoefficients),
+                                     std::vector<double>(numberOfCoefficients) };
+
+  RealType measure = NumericTraits<RealType>::Zero;
+  for (unsigned int k = 0; k < FixedImageDimension; ++k)
+  {
+    const double * const coefficients = parameters.data_block() + k * numberOfCoefficients;
+    double * const       derivativeOfDimension = derivative.data_block() + k * numberOfCoefficients;
+
+    for (unsigned int i = 0; i < FixedImageDimension; ++i)
+    {
+      for (unsigned int j = i; j < FixedImageDimension; ++j)
+      {
+        unsigned int orders[FixedImageDimension] = {};
+        ++orders[i];
+        ++orders[j];
+        const double weight = ((i == j) ? 1.0 : 2.0) / (gridSpacing[i] * gridSpacing[i] * gridSpacing[j] *
+                                                        gridSpacing[j] * volumeInGridUnits);
+
+        const double * input = coefficients;
+        for (unsigned int d = 0; d + 1 < FixedImageDimension; ++d)
+        {
+          double * const output = buffers[d % 2].data();
+          applyBand(gramMatrixBands[d][orders[d]], d, input, output, false, 1.0);
+          input = output;
+        }
+        const unsigned int lastDimension = FixedImageDimension - 1;
+        applyBand(gramMatrixBands[lastDimension][orders[lastDimension]],
+                  lastDimension,
+                  input,
+                  derivativeOfDimension,
+                  true,
+                  weight);
+      }
+    }
+
+    /** Compute the value c_k^T K c_k, and the derivative 2 K c_k. */
+    for (SizeValueType n = 0; n < numberOfCoefficients; ++n)
+    {
+      measure += coefficients[n] * derivativeOfDimension[n];
+      derivativeOfDimension[n] *= 2.0;
+    }
+  }
+
+  value = static_cast<MeasureType>(measure);
+  return true;
+
+} // end GetGridBasedValueAndDerivative()
+
+
+/**
+ * ******************* ComputeGramMatrixBand *******************
+ */
+
+template <class TFixedImage, class TScalarType>
+auto
+TransformBendingEnergyPenaltyTerm<TFixedImage, TScalarType>::ComputeGramMatrixBand(
+  const double         begin,
+  const double         end,
+  const IndexValueType firstIndex,
+  const SizeValueType  numberOfBasisFunctions,
+  const unsigned int   derivativeOrder) -> GramMatrixBandType
+{
+  const auto kernel = BSplineKernelFunction2<3>::New();
+  const auto derivativeKernel = BSplineDerivativeKernelFunction2<3>::New();
+  const auto secondOrderDerivativeKernel = BSplineSecondOrderDerivativeKernelFunction2<3>::New();
+
+  const auto evaluate = [&](const double u) {
+    return (derivativeOrder == 0) ? kernel->Evaluate(u)
+                                  : ((derivativeOrder == 1) ? derivativeKernel->Evaluate(u)
+                                                            : secondOrderDerivativeKernel->Evaluate(u));
+  };
+
+  /** The product of two basis functions is a polynomial of degree 6 or less, between the integer knots.
+   * So a four-point Gauss-Legendre quadrature (on [0, 1]) on each piece is exact.
+   */
+  const double nodes[4] = { 0.0694318442029737, 0.3300094782075719, 0.6699905217924281, 0.9305681557970263 };
+  const double weights[4] = { 0.1739274225687269, 0.3260725774312731, 0.3260725774312731, 0.1739274225687269 };
+
+  GramMatrixBandType band(numberOfBasisFunctions);
+  for (auto & row : band)
+  {
+    row.fill(0.0);
+  }
+
+  for (SizeValueType n = 0; n < numberOfBasisFunctions; ++n)
+  {
+    for (SizeValueType delta = 0; (delta <= 3) && (n + delta < numberOfBasisFunctions); ++delta)
+    {
+      /** The overlap of the supports of the basis functions centered at indexN and indexM = indexN + delta. */
+      const double indexN = static_cast<double>(firstIndex) + static_cast<double>(n);
+      const double indexM = indexN + static_cast<double>(delta);
+      const double overlapBegin = std::max(begin, indexM - 2.0);
+      const double overlapEnd = std::min(end, indexN + 2.0);
+
+      double integral = 0.0;
+      for (double pieceBegin = overlapBegin; pieceBegin < overlapEnd;)
+      {
+        const double pieceEnd = std::min(std::floor(pieceBegin) + 1.0, overlapEnd);
+        const double pieceLength = pieceEnd - pieceBegin;
+        for (unsigned int q = 0; q < 4; ++q)
+        {
+          const double u = pieceBegin + nodes[q] * pieceLength;
+          integral += weights[q] * pieceLength * evaluate(u - indexN) * evaluate(u - indexM);
+        }
+        pieceBegin = pieceEnd;
+      }
+
+      band[n][3 + delta] = integral;
+      band[n + delta][3 - delta] = integral;
+    }
+  }
+  return band;
+
+} // end ComputeGramMatrixBand()
+
+
 /**
  * ******************* GetSelfHessian *******************
  */
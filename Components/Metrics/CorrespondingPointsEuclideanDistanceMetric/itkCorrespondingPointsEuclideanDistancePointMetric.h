@@ -23,6 +23,8 @@
 #include "itkPointSet.h"
 #include "itkImage.h"
 
+#include <vector>
+
 namespace itk
 {
 
@@ -31,6 +33,9 @@ namespace itk
  *  and a fixed point-set.
  *  Correspondence is needed.
  *
+ *  When multi-threading is used, the points are divided over the threads,
+ *  which each accumulate their own (sparse) derivative contributions.
+ *
  *
  * \ingroup RegistrationMetrics
  */
@@ -76,6 +81,10 @@ public:
 
   using typename Superclass::NonZeroJacobianIndicesType;
 
+  /** Initialize the metric. Copies the corresponding points, so that they can be divided over the threads. */
+  void
+  Initialize(void) override;
+
   /**  Get the value for single valued optimizers. */
   MeasureType
   GetValue(const TransformParametersType & parameters) const override;
@@ -95,6 +104,18 @@ protected:
   ~CorrespondingPointsEuclideanDistancePointMetric() override = default;
 
 private:
+  /** Computes the sum of the distances between the moving points and the
+   * transformed fixed points, and, when the derivative is not null, its
+   * derivative. Also sets m_NumberOfPointsCounted. When multi-threading is
+   * used, the points are divided over the work units.
+   */
+  void
+  ComputeSumOfDistances(MeasureType & measure, DerivativeType * derivative) const;
+
+  /** The corresponding fixed and moving points, copied by Initialize(). */
+  std::vector<InputPointType>  m_FixedPoints;
+  std::vector<OutputPointType> m_MovingPoints;
+
   CorrespondingPointsEuclideanDistancePointMetric(const Self &) = delete;
   void
   operator=(const Self &) = delete;
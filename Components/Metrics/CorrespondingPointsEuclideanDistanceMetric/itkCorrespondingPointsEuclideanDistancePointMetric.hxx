@@ -33,76 +33,52 @@ CorrespondingPointsEuclideanDistancePointMetric<TFixedPointSet,
   default; // end Constructor
 
 /**
- * ******************* GetValue *******************
+ * ******************* Initialize *******************
  */
 
 template <class TFixedPointSet, class TMovingPointSet>
-auto
-CorrespondingPointsEuclideanDistancePointMetric<TFixedPointSet, TMovingPointSet>::GetValue(
-  const TransformParametersType & parameters) const -> MeasureType
+void
+CorrespondingPointsEuclideanDistancePointMetric<TFixedPointSet, TMovingPointSet>::Initialize(void)
 {
-  /** Sanity checks. */
-  FixedPointSetConstPointer fixedPointSet = this->GetFixedPointSet();
-  if (!fixedPointSet)
-  {
-    itkExceptionMacro(<< "Fixed point set has not been assigned");
-  }
-
-  MovingPointSetConstPointer movingPointSet = this->GetMovingPointSet();
-  if (!movingPointSet)
-  {
-    itkExceptionMacro(<< "Moving point set has not been assigned");
-  }
+  /** Initialize transform, point sets, and the threading parameters. */
+  this->Superclass::Initialize();
 
-  /** Initialize some variables. */
-  this->m_NumberOfPointsCounted = 0;
-  MeasureType     measure = NumericTraits<MeasureType>::Zero;
-  InputPointType  movingPoint;
-  OutputPointType fixedPoint, mappedPoint;
+  /** Copy the corresponding points, so that they can be divided over the threads. */
+  const FixedPointSetConstPointer  fixedPointSet = this->GetFixedPointSet();
+  const MovingPointSetConstPointer movingPointSet = this->GetMovingPointSet();
 
-  /** Make sure the transform parameters are up to date. */
-  this->SetTransformParameters(parameters);
+  this->m_FixedPoints.clear();
+  this->m_MovingPoints.clear();
+  this->m_FixedPoints.reserve(fixedPointSet->GetNumberOfPoints());
+  this->m_MovingPoints.reserve(fixedPointSet->GetNumberOfPoints());
 
-  /** Create iterators. */
   PointIterator pointItFixed = fixedPointSet->GetPoints()->Begin();
   PointIterator pointItMoving = movingPointSet->GetPoints()->Begin();
   PointIterator pointEnd = fixedPointSet->GetPoints()->End();
-
-  /** Loop over the corresponding points. */
-  while (pointItFixed != pointEnd)
+  for (; pointItFixed != pointEnd; ++pointItFixed, ++pointItMoving)
   {
-    /** Get the current corresponding points. */
-    fixedPoint = pointItFixed.Value();
-    movingPoint = pointItMoving.Value();
-
-    /** Transform point and check if it is inside the B-spline support region. */
-    // bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
-    mappedPoint = this->m_Transform->TransformPoint(fixedPoint);
-
-    /** Check if point is inside mask. */
-    bool sampleOk = true;
-    if (sampleOk)
-    {
-      // sampleOk = this->IsInsideMovingMask( mappedPoint );
-      if (this->m_MovingImageMask.IsNotNull())
-      {
-        sampleOk = this->m_MovingImageMask->IsInsideInWorldSpace(mappedPoint);
-      }
-    }
+    this->m_FixedPoints.push_back(pointItFixed.Value());
+    this->m_MovingPoints.push_back(pointItMoving.Value());
+  }
 
-    if (sampleOk)
-    {
-      this->m_NumberOfPointsCounted++;
+} // end Initialize()
 
-      VnlVectorType diffPoint = (movingPoint - mappedPoint).GetVnlVector();
-      measure += diffPoint.magnitude();
 
-    } // end if sampleOk
+/**
+ * ******************* GetValue *******************
+ */
 
-    ++pointItFixed;
-    ++pointItMoving;
+template <class TFixedPointSet, class TMovingPointSet>
+auto
+CorrespondingPointsEuclideanDistancePointMetric<TFixedPointSet, TMovingPointSet>::GetValue(
+  const TransformParametersType & parameters) const -> MeasureType
+{
+  /** Make sure the transform parameters are up to date. */
+  this->SetTransformParameters(parameters);
 
-  } // end loop over all corresponding points
+  /** Compute the sum of the distances. */
+  MeasureType measure = NumericTraits<MeasureType>::Zero;
+  this->ComputeSumOfDistances(measure, nullptr);
 
   return measure / this->m_NumberOfPointsCounted;
 
@@ -141,29 +117,10 @@ CorrespondingPointsEuclideanDistancePointMetric<TFixedPointSet, TMovingPointSet>
   MeasureType &                   value,
   DerivativeType &                derivative) const
 {
-  /** Sanity checks. */
-  FixedPointSetConstPointer fixedPointSet = this->GetFixedPointSet();
-  if (!fixedPointSet)
-  {
-    itkExceptionMacro(<< "Fixed point set has not been assigned");
-  }
-
-  MovingPointSetConstPointer movingPointSet = this->GetMovingPointSet();
-  if (!movingPointSet)
-  {
-    itkExceptionMacro(<< "Moving point set has not been assigned");
-  }
-
   /** Initialize some variables */
-  this->m_NumberOfPointsCounted = 0;
   MeasureType measure = NumericTraits<MeasureType>::Zero;
   derivative = DerivativeType(this->GetNumberOfParameters());
   derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
-  NonZeroJacobianIndicesType nzji(this->m_Transform->GetNumberOfNonZeroJacobianIndices());
-  TransformJacobianType      jacobian;
-
-  InputPointType  movingPoint;
-  OutputPointType fixedPoint, mappedPoint;
 
   /** Call non-thread-safe stuff, such as:
    *   this->SetTransformParameters( parameters );
@@ -180,86 +137,121 @@ CorrespondingPointsEuclideanDistancePointMetric<TFixedPointSet, TMovingPointSet>
    */
   this->BeforeThreadedGetValueAndDerivative(parameters);
 
-  /** Create iterators. */
-  PointIterator pointItFixed = fixedPointSet->GetPoints()->Begin();
-  PointIterator pointItMoving = movingPointSet->GetPoints()->Begin();
-  PointIterator pointEnd = fixedPointSet->GetPoints()->End();
+  /** Compute the sum of the distances and its derivative. */
+  this->ComputeSumOfDistances(measure, &derivative);
+
+  /** Check if enough samples were valid. */
+  //   this->CheckNumberOfSamples(
+  //     fixedPointSet->GetNumberOfPoints(), this->m_NumberOfPointsCounted );
 
-  /** Loop over the corresponding points. */
-  while (pointItFixed != pointEnd)
+  /** Copy the measure to value. */
+  value = measure;
+  if (this->m_NumberOfPointsCounted > 0)
   {
-    /** Get the current corresponding points. */
-    fixedPoint = pointItFixed.Value();
-    movingPoint = pointItMoving.Value();
-
-    /** Transform point and check if it is inside the B-spline support region. */
-    // bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
-    mappedPoint = this->m_Transform->TransformPoint(fixedPoint);
-
-    /** Check if point is inside mask. */
-    bool sampleOk = true;
-    if (sampleOk)
-    {
-      // sampleOk = this->IsInsideMovingMask( mappedPoint );
-      if (this->m_MovingImageMask.IsNotNull())
-      {
-        sampleOk = this->m_MovingImageMask->IsInsideInWorldSpace(mappedPoint);
-      }
-    }
+    derivative /= this->m_NumberOfPointsCounted;
+    value = measure / this->m_NumberOfPointsCounted;
+  }
 
-    if (sampleOk)
-    {
-      this->m_NumberOfPointsCounted++;
+} // end GetValueAndDerivative()
 
-      /** Get the TransformJacobian dT/dmu. */
-      // this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
-      this->m_Transform->GetJacobian(fixedPoint, jacobian, nzji);
 
-      VnlVectorType diffPoint = (movingPoint - mappedPoint).GetVnlVector();
-      MeasureType   distance = diffPoint.magnitude();
-      measure += distance;
+/**
+ * ******************* ComputeSumOfDistances *******************
+ */
 
-      /** Calculate the contributions to the derivatives with respect to each parameter. */
-      if (distance > std::numeric_limits<MeasureType>::epsilon())
+template <class TFixedPointSet, class TMovingPointSet>
+void
+CorrespondingPointsEuclideanDistancePointMetric<TFixedPointSet, TMovingPointSet>::ComputeSumOfDistances(
+  MeasureType &    measure,
+  DerivativeType * derivative) const
+{
+  const std::vector<InputPointType> &  fixedPoints = this->m_FixedPoints;
+  const std::vector<OutputPointType> & movingPoints = this->m_MovingPoints;
+  const SizeValueType                  numberOfPoints = fixedPoints.size();
+
+  /** Computes the sum of the distances, and optionally its derivative, for a range of the corresponding points. */
+  const auto computeSumOfDistancesOfRange =
+    [this, &fixedPoints, &movingPoints](const SizeValueType begin,
+                                        const SizeValueType end,
+                                        MeasureType &       sumOfDistances,
+                                        SizeValueType &     numberOfPointsCounted,
+                                        DerivativeType *    sumOfDerivatives) {
+      NonZeroJacobianIndicesType nzji(this->m_Transform->GetNumberOfNonZeroJacobianIndices());
+      TransformJacobianType      jacobian;
+
+      for (SizeValueType pointNumber = begin; pointNumber < end; ++pointNumber)
       {
-        VnlVectorType diff_2 = diffPoint / distance;
-        if (nzji.size() == this->GetNumberOfParameters())
+        /** Get the current corresponding points. */
+        const InputPointType &  fixedPoint = fixedPoints[pointNumber];
+        const OutputPointType & movingPoint = movingPoints[pointNumber];
+
+        /** Transform point. */
+        const OutputPointType mappedPoint = this->m_Transform->TransformPoint(fixedPoint);
+
+        /** Check if point is inside mask. */
+        if (this->m_MovingImageMask.IsNotNull() && !this->m_MovingImageMask->IsInsideInWorldSpace(mappedPoint))
         {
-          /** Loop over all Jacobians. */
-          derivative -= diff_2 * jacobian;
+          continue;
         }
-        else
-        {
-          /** Only pick the nonzero Jacobians. */
-          for (unsigned int i = 0; i < nzji.size(); ++i)
-          {
-            const unsigned int index = nzji[i];
-            VnlVectorType      column = jacobian.get_column(i);
-            derivative[index] -= dot_product(diff_2, column);
-          }
-        }
-      } // end if distance != 0
 
-    } // end if sampleOk
+        ++numberOfPointsCounted;
 
-    ++pointItFixed;
-    ++pointItMoving;
+        VnlVectorType diffPoint = (movingPoint - mappedPoint).GetVnlVector();
+        MeasureType   distance = diffPoint.magnitude();
+        sumOfDistances += distance;
 
-  } // end loop over all corresponding points
+        /** Calculate the contributions to the derivatives with respect to each parameter. */
+        if ((sumOfDerivatives != nullptr) && (distance > std::numeric_limits<MeasureType>::epsilon()))
+        {
+          /** Get the TransformJacobian dT/dmu. */
+          this->m_Transform->GetJacobian(fixedPoint, jacobian, nzji);
 
-  /** Check if enough samples were valid. */
-  //   this->CheckNumberOfSamples(
-  //     fixedPointSet->GetNumberOfPoints(), this->m_NumberOfPointsCounted );
+          VnlVectorType diff_2 = diffPoint / distance;
+          if (nzji.size() == this->GetNumberOfParameters())
+          {
+            /** Loop over all Jacobians. */
+            *sumOfDerivatives -= diff_2 * jacobian;
+          }
+          else
+          {
+            /** Only pick the nonzero Jacobians. */
+            for (unsigned int i = 0; i < nzji.size(); ++i)
+            {
+              const unsigned int index = nzji[i];
+              VnlVectorType      column = jacobian.get_column(i);
+              (*sumOfDerivatives)[index] -= dot_product(diff_2, column);
+            }
+          }
+        } // end if distance != 0
+      }
+    };
 
-  /** Copy the measure to value. */
-  value = measure;
-  if (this->m_NumberOfPointsCounted > 0)
+  if (this->UsesPerThreadVariables())
   {
-    derivative /= this->m_NumberOfPointsCounted;
-    value = measure / this->m_NumberOfPointsCounted;
+    /** Each work unit handles a contiguous range of points, and adds to its own derivative. */
+    this->ParallelizeOverRanges(
+      numberOfPoints,
+      [this, derivative, &computeSumOfDistancesOfRange](
+        const SizeValueType begin, const SizeValueType end, const ThreadIdType threadId) {
+        auto & perThreadVariables = this->m_GetValueAndDerivativePerThreadVariables[threadId];
+        computeSumOfDistancesOfRange(begin,
+                                     end,
+                                     perThreadVariables.st_Value,
+                                     perThreadVariables.st_NumberOfPointsCounted,
+                                     (derivative != nullptr) ? &perThreadVariables.st_Derivative : nullptr);
+      });
+
+    this->AccumulatePerThreadVariables(measure, derivative);
+  }
+  else
+  {
+    SizeValueType numberOfPointsCounted = 0;
+    measure = NumericTraits<MeasureType>::Zero;
+    computeSumOfDistancesOfRange(0, numberOfPoints, measure, numberOfPointsCounted, derivative);
+    this->m_NumberOfPointsCounted = numberOfPointsCounted;
   }
 
-} // end GetValueAndDerivative()
+} // end ComputeSumOfDistances()
 
 
 } // end namespace itk
@@ -74,6 +74,7 @@ DisplacementMagnitudePenaltyTerm<TFixedImage, TScalarType>::GetValue(const Param
 
   /** Update the imageSampler and get a handle to the sample container. */
   this->GetImageSampler()->Update();
+  this->UpdateInitialTransformCache();
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
 
   /** Create iterator over the sample container. */
@@ -33,6 +33,8 @@
 #include "itkImageRegionIterator.h"
 #include "itkMultiResolutionPyramidImageFilter.h"
 
+#include <vector>
+
 namespace itk
 {
 /**
@@ -63,6 +65,12 @@ namespace itk
  *  resolutions.
  *  - In the publication above, the grid spacing was set as [4, 4, 1].
  *
+ * The penalty grid points in the rigid regions, and their neighbours in the
+ * same rigid region, are collected once, by Initialize(), in a compact list,
+ * ordered along a Morton (Z-order) curve of the penalty grid. Each evaluation
+ * then transforms each of these points once, and processes the pairs of
+ * neighbouring points, in parallel when multi-threading is enabled.
+ *
  * \author Jihun Kim, University of Michigan, Ann Arbor
  * \author Martha M. Matuszak, University of Michigan, Ann Arbor
  * \author Kazuhiro Saitou, University of Michigan, Ann Arbor
@@ -164,6 +172,14 @@ public:
                         MeasureType &          value,
                         DerivativeType &       derivative) const override;
 
+  /** Get value and derivatives for each thread. */
+  void
+  ThreadedGetValueAndDerivative(ThreadIdType threadID) override;
+
+  /** Gather the values and derivatives from all threads */
+  void
+  AfterThreadedGetValueAndDerivative(MeasureType & value, DerivativeType & derivative) const override;
+
   /** Set the B-spline transform in this class.
    * This class expects a BSplineTransform! It is not suited for others.
    */
@@ -217,9 +233,52 @@ private:
   void
   operator=(const Self &) = delete;
 
+  /** A penalty grid point in a rigid region, with the (separable) B-spline weights of its support region. The first
+   * parameter index of the support region is negative when the support region is not entirely within the B-spline grid.
+   */
+  struct RigidGridPointType
+  {
+    InputPointType m_Point;
+    long           m_FirstParameterIndex;
+    double         m_Weights[ImageDimension][4];
+  };
+
+  /** A neighbour of a rigid penalty grid point, in the same rigid region, with its squared distance, and the weight
+   * of its penalty (one divided by the number of neighbours times the number of rigid penalty grid points).
+   */
+  struct RigidGridNeighborType
+  {
+    unsigned int m_Point;
+    double       m_SquaredDistance;
+    double       m_Weight;
+  };
+
+  /** Collects the rigid penalty grid points, their neighbours and their B-spline weights, in Morton order. */
+  void
+  InitializeRigidGridPoints(void);
+
+  /** Transforms the rigid penalty grid points, in parallel when multi-threading is enabled. */
+  void
+  TransformRigidGridPoints(void) const;
+
+  /** Computes the penalty and its derivative, for the rigid penalty grid points in the range [begin, end). */
+  void
+  ComputeValueAndDerivativeOfRigidGridPoints(const unsigned int begin,
+                                             const unsigned int end,
+                                             MeasureType &      value,
+                                             DerivativeType &   derivative) const;
+
   /** Member variables. */
   BSplineTransformPointer m_BSplineTransform;
 
+  /** The rigid penalty grid points (in Morton order), their neighbours, and for each point the range of its
+   * neighbours: m_RigidGridNeighbors[m_RigidGridNeighborOffsets[i]], ..., [m_RigidGridNeighborOffsets[i + 1] - 1].
+   */
+  std::vector<RigidGridPointType>      m_RigidGridPoints;
+  std::vector<RigidGridNeighborType>   m_RigidGridNeighbors;
+  std::vector<unsigned int>            m_RigidGridNeighborOffsets;
+  mutable std::vector<OutputPointType> m_TransformedRigidGridPoints;
+
   mutable MeasureType m_RigidityPenaltyTermValue;
 
   BSplineKnotImagePointer m_BSplineKnotImage;
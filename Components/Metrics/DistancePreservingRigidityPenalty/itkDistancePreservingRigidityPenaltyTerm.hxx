@@ -22,6 +22,12 @@
 
 #include "itkZeroFluxNeumannBoundaryCondition.h"
 #include "itkImageRegionIterator.h"
+#include "itkBSplineKernelFunction.h"
+
+#include <algorithm> // For lower_bound and sort.
+#include <cmath>     // For floor.
+#include <cstdint>
+#include <utility> // For pair.
 
 namespace itk
 {
@@ -153,122 +159,265 @@ DistancePreservingRigidityPenaltyTerm<TFixedImage, TScalarType>::Initialize(void
     }
     ++ki;
   }
+
+  /** Collect the rigid penalty grid points and their neighbours. */
+  this->InitializeRigidGridPoints();
+
 } // end Initialize()
 
 
 /**
- * *********************** GetValue *****************************
+ * *********************** InitializeRigidGridPoints *****************************
  */
 
 template <class TFixedImage, class TScalarType>
-auto
-DistancePreservingRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValue(const ParametersType & parameters) const
-  -> MeasureType
+void
+DistancePreservingRigidityPenaltyTerm<TFixedImage, TScalarType>::InitializeRigidGridPoints(void)
 {
-  /** Set output values to zero. */
-  this->m_RigidityPenaltyTermValue = NumericTraits<MeasureType>::Zero;
+  typedef typename PenaltyGridImageType::IndexType  PenaltyGridIndexType;
+  typedef typename PenaltyGridImageType::OffsetType PenaltyGridOffsetType;
+  typedef ContinuousIndex<double, ImageDimension>   ContinuousIndexType;
 
-  // this->SetTransformParameters( parameters );
-  this->m_BSplineTransform->SetParameters(parameters);
+  this->m_RigidGridPoints.clear();
+  this->m_RigidGridNeighbors.clear();
+  this->m_RigidGridNeighborOffsets.assign(1, 0);
 
-  /** distance-preserving penalty computation */
-  MeasureType penaltyTerm = 0.0;
-  MeasureType penaltyTermBuffer = 0.0;
+  /** The penalty is only implemented for 3D images. */
+  if (ImageDimension != 3)
+  {
+    return;
+  }
 
-  MeasureType dx = 0.0;
-  MeasureType dX = 0.0;
+  /** The penalty grid has the geometry of the sampled segmented image, so the nearest neighbour interpolation of the
+   * segmented image at a penalty grid point is just the value of the sampled segmented image at the same index.
+   */
+  const PenaltyGridImageRegionType penaltyGridRegion = this->m_PenaltyGridImage->GetBufferedRegion();
+  const PenaltyGridIndexType &     penaltyGridStart = penaltyGridRegion.GetIndex();
+  const SegmentedImageType &       sampledSegmentedImage = *(this->m_SampledSegmentedImage);
+
+  const auto getLabel = [&sampledSegmentedImage](const PenaltyGridIndexType & index) {
+    return static_cast<unsigned int>(sampledSegmentedImage.GetPixel(index));
+  };
+
+  /** The offsets of the neighbours in the 3x3x3 neighbourhood, excluding the center. */
+  std::vector<PenaltyGridOffsetType> neighborOffsets;
+  unsigned int                       numberOfNeighborhood = 1;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    numberOfNeighborhood *= 3;
+  }
+  for (unsigned int kk = 0; kk < numberOfNeighborhood; ++kk)
+  {
+    PenaltyGridOffsetType offset;
+    unsigned int          remainder = kk;
+    bool                  isCenter = true;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      offset[i] = static_cast<OffsetValueType>(remainder % 3) - 1;
+      remainder /= 3;
+      isCenter = isCenter && (offset[i] == 0);
+    }
+    if (!isCenter)
+    {
+      neighborOffsets.push_back(offset);
+    }
+  }
+
+  /** Counts the neighbours with the same label, within the penalty grid. Neighbours outside the penalty grid do not
+   * belong to any rigid region.
+   */
+  const auto countNeighbors = [&](const PenaltyGridIndexType & index, const unsigned int label) {
+    unsigned int numberOfNeighbors = 0;
+    for (const auto & offset : neighborOffsets)
+    {
+      const PenaltyGridIndexType neighborIndex = index + offset;
+      if (penaltyGridRegion.IsInside(neighborIndex) && (getLabel(neighborIndex) == label))
+      {
+        ++numberOfNeighbors;
+      }
+    }
+    return numberOfNeighbors;
+  };
+
+  /** Collect the penalty grid points that contribute to the penalty: those in a rigid region (with a label
+   * from 1 to 5), that have at least one neighbour in the same region. Sort them by their Morton code.
+   */
+  std::vector<std::pair<std::uint64_t, PenaltyGridIndexType>> codesAndIndices;
+  for (ImageRegionConstIteratorWithIndex<PenaltyGridImageType> it(this->m_PenaltyGridImage, penaltyGridRegion);
+       !it.IsAtEnd();
+       ++it)
+  {
+    const PenaltyGridIndexType & index = it.GetIndex();
+    const unsigned int           label = getLabel(index);
+    if ((label > 0) && (label < 6) && (countNeighbors(index, label) > 0))
+    {
+      std::uint64_t mortonCode = 0;
+      for (unsigned int bit = 0; bit < 64 / ImageDimension; ++bit)
+      {
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          const auto relativeIndex = static_cast<std::uint64_t>(index[i] - penaltyGridStart[i]);
+          mortonCode |= ((relativeIndex >> bit) & 1) << (bit * ImageDimension + i);
+        }
+      }
+      codesAndIndices.emplace_back(mortonCode, index);
+    }
+  }
+  std::sort(codesAndIndices.begin(),
+            codesAndIndices.end(),
+            [](const std::pair<std::uint64_t, PenaltyGridIndexType> & lhs,
+               const std::pair<std::uint64_t, PenaltyGridIndexType> & rhs) { return lhs.first < rhs.first; });
+
+  /** Map each penalty grid index to its number in the list of rigid penalty grid points. */
+  const auto computeOffsetInPenaltyGrid = [&penaltyGridRegion](const PenaltyGridIndexType & index) {
+    SizeValueType offset = 0;
+    for (unsigned int i = ImageDimension; i > 0; --i)
+    {
+      offset = offset * penaltyGridRegion.GetSize(i - 1) +
+               static_cast<SizeValueType>(index[i - 1] - penaltyGridRegion.GetIndex(i - 1));
+    }
+    return offset;
+  };
+  std::vector<unsigned int> pointNumbers(penaltyGridRegion.GetNumberOfPixels());
+  for (unsigned int pointNumber = 0; pointNumber < codesAndIndices.size(); ++pointNumber)
+  {
+    pointNumbers[computeOffsetInPenaltyGrid(codesAndIndices[pointNumber].second)] = pointNumber;
+  }
 
-  typedef itk::ImageRegionConstIteratorWithIndex<PenaltyGridImageType> PenaltyGridIteratorType;
-  PenaltyGridImageRegionType penaltyGridImageRegion = this->m_PenaltyGridImage->GetBufferedRegion();
+  /** The B-spline kernel and the geometry of the B-spline knot image, for the weights of the support regions. */
+  typedef BSplineKernelFunction<3> BSplineKernelFunctionType;
+  const auto                       bSplineKernel = BSplineKernelFunctionType::New();
 
-  PenaltyGridIteratorType pgi(this->m_PenaltyGridImage, penaltyGridImageRegion);
+  const typename BSplineKnotImageType::SizeType bSplineKnotImageSize =
+    this->m_BSplineKnotImage->GetBufferedRegion().GetSize();
 
-  typename PenaltyGridImageType::IndexType penaltyGridIndex, neighborPenaltyGridIndex;
-  typename PenaltyGridImageType::PointType penaltyGridPoint, neighborPenaltyGridPoint, xn, xf;
+  /** Store the points, with the weights of their support regions, and their neighbours. */
+  this->m_RigidGridPoints.resize(codesAndIndices.size());
+  this->m_RigidGridNeighborOffsets.reserve(codesAndIndices.size() + 1);
 
-  typedef itk::ConstNeighborhoodIterator<PenaltyGridImageType> NeighborhoodIteratorType;
-  typename NeighborhoodIteratorType::RadiusType                radius;
-  radius.Fill(1);
-  NeighborhoodIteratorType ni(radius, this->m_PenaltyGridImage, penaltyGridImageRegion);
-  unsigned int             numberOfNeighborhood = ni.Size();
+  for (unsigned int pointNumber = 0; pointNumber < codesAndIndices.size(); ++pointNumber)
+  {
+    const PenaltyGridIndexType & index = codesAndIndices[pointNumber].second;
+    RigidGridPointType &         rigidGridPoint = this->m_RigidGridPoints[pointNumber];
+    this->m_PenaltyGridImage->TransformIndexToPhysicalPoint(index, rigidGridPoint.m_Point);
 
-  unsigned int numberOfRigidGridsNeighbor;
+    ContinuousIndexType knotIndex;
+    this->m_BSplineKnotImage->TransformPhysicalPointToContinuousIndex(rigidGridPoint.m_Point, knotIndex);
 
-  // interpolation of segmented image
-  typedef itk::NearestNeighborInterpolateImageFunction<SegmentedImageType, double> SegmentedImageInterpolatorType;
-  auto segmentedImageInterpolator = SegmentedImageInterpolatorType::New();
+    rigidGridPoint.m_FirstParameterIndex = 0;
+    long stride = 1;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      const double supportStart = std::floor(knotIndex[i]) - 1.0;
+      for (unsigned int j = 0; j < 4; ++j)
+      {
+        rigidGridPoint.m_Weights[i][j] = bSplineKernel->Evaluate(knotIndex[i] - (supportStart + j));
+      }
 
-  segmentedImageInterpolator->SetInputImage(this->m_SampledSegmentedImage);
+      const long start = static_cast<long>(supportStart);
+      const long knotSize = static_cast<long>(bSplineKnotImageSize[i]);
+      if ((rigidGridPoint.m_FirstParameterIndex < 0) || (start < 0) || (start + 4 > knotSize))
+      {
+        rigidGridPoint.m_FirstParameterIndex = -1;
+      }
+      else
+      {
+        rigidGridPoint.m_FirstParameterIndex += start * stride;
+      }
+      stride *= knotSize;
+    }
 
-  unsigned int pixelValue, pixelValueNeighbor;
+    /** The neighbours with the same label. The center point itself is also counted, for the weight. */
+    const unsigned int label = getLabel(index);
+    const double       weight = 1.0 / static_cast<double>(countNeighbors(index, label) + 1) /
+                          static_cast<double>(this->m_NumberOfRigidGrids);
 
-  /** Penalty term computation */
-  if (MovingImageDimension == 3)
-  {
-    for (pgi.GoToBegin(), ni.GoToBegin(); !pgi.IsAtEnd(); ++pgi, ++ni)
+    for (const auto & offset : neighborOffsets)
     {
-      penaltyGridIndex = pgi.GetIndex();
-
-      this->m_PenaltyGridImage->TransformIndexToPhysicalPoint(penaltyGridIndex, penaltyGridPoint);
+      const PenaltyGridIndexType neighborIndex = index + offset;
+      if (penaltyGridRegion.IsInside(neighborIndex) && (getLabel(neighborIndex) == label))
+      {
+        typename PenaltyGridImageType::PointType neighborPoint;
+        this->m_PenaltyGridImage->TransformIndexToPhysicalPoint(neighborIndex, neighborPoint);
+
+        RigidGridNeighborType neighbor;
+        neighbor.m_Point = pointNumbers[computeOffsetInPenaltyGrid(neighborIndex)];
+        neighbor.m_SquaredDistance = rigidGridPoint.m_Point.SquaredEuclideanDistanceTo(neighborPoint);
+        neighbor.m_Weight = weight;
+        this->m_RigidGridNeighbors.push_back(neighbor);
+      }
+    }
+    this->m_RigidGridNeighborOffsets.push_back(static_cast<unsigned int>(this->m_RigidGridNeighbors.size()));
+  }
 
-      ni.SetLocation(penaltyGridIndex);
+  this->m_TransformedRigidGridPoints.resize(this->m_RigidGridPoints.size());
 
-      pixelValue = static_cast<unsigned int>(segmentedImageInterpolator->Evaluate(penaltyGridPoint));
+} // end InitializeRigidGridPoints()
 
-      if (pixelValue > 0 && pixelValue < 6)
-      {
-        numberOfRigidGridsNeighbor = 0;
 
-        for (unsigned int kk = 0; kk < numberOfNeighborhood; ++kk)
-        {
-          neighborPenaltyGridIndex = ni.GetIndex(kk);
+/**
+ * *********************** TransformRigidGridPoints *****************************
+ */
 
-          this->m_PenaltyGridImage->TransformIndexToPhysicalPoint(neighborPenaltyGridIndex, neighborPenaltyGridPoint);
+template <class TFixedImage, class TScalarType>
+void
+DistancePreservingRigidityPenaltyTerm<TFixedImage, TScalarType>::TransformRigidGridPoints(void) const
+{
+  const auto transformPoint = [this](const SizeValueType pointNumber) {
+    this->m_TransformedRigidGridPoints[pointNumber] =
+      this->m_Transform->TransformPoint(this->m_RigidGridPoints[pointNumber].m_Point);
+  };
 
-          pixelValueNeighbor =
-            static_cast<unsigned int>(segmentedImageInterpolator->Evaluate(neighborPenaltyGridPoint));
+  const SizeValueType numberOfPoints = this->m_RigidGridPoints.size();
+  if (this->m_UseMultiThread)
+  {
+    this->m_Threader->ParallelizeArray(0, numberOfPoints, transformPoint, nullptr);
+  }
+  else
+  {
+    for (SizeValueType pointNumber = 0; pointNumber < numberOfPoints; ++pointNumber)
+    {
+      transformPoint(pointNumber);
+    }
+  }
 
-          if (pixelValue == pixelValueNeighbor)
-          {
-            numberOfRigidGridsNeighbor++;
-          }
-        }
+} // end TransformRigidGridPoints()
 
-        if (numberOfRigidGridsNeighbor > 1)
-        {
-          for (unsigned int kk = 0; kk < numberOfNeighborhood; ++kk)
-          {
-            neighborPenaltyGridIndex = ni.GetIndex(kk);
 
-            this->m_PenaltyGridImage->TransformIndexToPhysicalPoint(neighborPenaltyGridIndex, neighborPenaltyGridPoint);
+/**
+ * *********************** GetValue *****************************
+ */
 
-            pixelValueNeighbor =
-              static_cast<unsigned int>(segmentedImageInterpolator->Evaluate(neighborPenaltyGridPoint));
+template <class TFixedImage, class TScalarType>
+auto
+DistancePreservingRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValue(const ParametersType & parameters) const
+  -> MeasureType
+{
+  /** Set output values to zero. */
+  this->m_RigidityPenaltyTermValue = NumericTraits<MeasureType>::Zero;
 
-            if (pixelValue == pixelValueNeighbor)
-            {
-              xn = this->m_Transform->TransformPoint(neighborPenaltyGridPoint);
-              xf = this->m_Transform->TransformPoint(penaltyGridPoint);
+  // this->SetTransformParameters( parameters );
+  this->m_BSplineTransform->SetParameters(parameters);
 
-              dX = (neighborPenaltyGridPoint[0] - penaltyGridPoint[0]) *
-                     (neighborPenaltyGridPoint[0] - penaltyGridPoint[0]) +
-                   (neighborPenaltyGridPoint[1] - penaltyGridPoint[1]) *
-                     (neighborPenaltyGridPoint[1] - penaltyGridPoint[1]) +
-                   (neighborPenaltyGridPoint[2] - penaltyGridPoint[2]) *
-                     (neighborPenaltyGridPoint[2] - penaltyGridPoint[2]);
+  /** Transform each rigid penalty grid point once. */
+  this->TransformRigidGridPoints();
 
-              dx = (xn[0] - xf[0]) * (xn[0] - xf[0]) + (xn[1] - xf[1]) * (xn[1] - xf[1]) +
-                   (xn[2] - xf[2]) * (xn[2] - xf[2]);
+  /** Distance-preserving penalty computation, over all pairs of neighbouring rigid penalty grid points. */
+  MeasureType penaltyTerm = 0.0;
+  for (unsigned int pointNumber = 0; pointNumber < this->m_RigidGridPoints.size(); ++pointNumber)
+  {
+    const OutputPointType & xf = this->m_TransformedRigidGridPoints[pointNumber];
+    const unsigned int      neighborEnd = this->m_RigidGridNeighborOffsets[pointNumber + 1];
 
-              penaltyTermBuffer = (dx - dX) * (dx - dX);
+    for (unsigned int k = this->m_RigidGridNeighborOffsets[pointNumber]; k < neighborEnd; ++k)
+    {
+      const RigidGridNeighborType & neighbor = this->m_RigidGridNeighbors[k];
+      const OutputPointType &       xn = this->m_TransformedRigidGridPoints[neighbor.m_Point];
 
-              penaltyTerm += penaltyTermBuffer / numberOfRigidGridsNeighbor / (this->m_NumberOfRigidGrids);
-            }
-          } // end for
-        }   // end if
-      }     // end if
-    }       // end for
-  }         // end if ( dimension = 3 )
+      const MeasureType difference = xn.SquaredEuclideanDistanceTo(xf) - neighbor.m_SquaredDistance;
+      penaltyTerm += neighbor.m_Weight * difference * difference;
+    }
+  }
 
   /** Return the rigidity penalty term value. */
   return penaltyTerm;
@@ -311,199 +460,169 @@ DistancePreservingRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDeri
 
   this->m_BSplineTransform->SetParameters(parameters);
 
-  /** Distance-preserving penalty */
-  MeasureType penaltyTermBuffer = 0.0;
-  MeasureType derivativeTermTemp1 = 0.0, derivativeTermTemp2 = 0.0, derivativeTermTemp3 = 0.0;
-
-  unsigned int par1, par2;
-
-  MeasureType dX = 0.0;
-  MeasureType dx = 0.0;
+  /** Transform each rigid penalty grid point once. */
+  this->TransformRigidGridPoints();
 
-  typename PenaltyGridImageType::IndexType penaltyGridIndex, neighborPenaltyGridIndex;
-  typename PenaltyGridImageType::PointType penaltyGridPoint, neighborPenaltyGridPoint, xn, xf;
+  /** Option to still use the single threaded code. */
+  if (!this->m_UseMultiThread)
+  {
+    this->ComputeValueAndDerivativeOfRigidGridPoints(
+      0, static_cast<unsigned int>(this->m_RigidGridPoints.size()), value, derivative);
+    return;
+  }
 
-  typedef itk::BSplineKernelFunction<3> BSplineKernelFunctionType;
-  auto                                  bSplineKernel = BSplineKernelFunctionType::New();
+  /** Launch multi-threading metric */
+  this->LaunchGetValueAndDerivativeThreaderCallback();
 
-  typedef itk::BSplineInterpolationWeightFunction<double, ImageDimension, 3> WeightsFunctionType;
-  typedef typename WeightsFunctionType::ContinuousIndexType                  ContinuousIndexType;
-  typedef double                                                             ContinuousIndexValueType;
+  /** Gather the metric values and derivatives from all threads. */
+  this->AfterThreadedGetValueAndDerivative(value, derivative);
 
-  ContinuousIndexType      tindex;
-  ContinuousIndexValueType tx, ty, tz;
+} // end GetValueAndDerivative()
 
-  ContinuousIndexValueType m, n, p, neighbor_m, neighbor_n, neighbor_p;
 
-  typedef itk::ImageRegionConstIteratorWithIndex<PenaltyGridImageType> PenaltyGridIteratorType;
-  PenaltyGridImageRegionType penaltyGridImageRegion = this->m_PenaltyGridImage->GetBufferedRegion();
-  PenaltyGridIteratorType    pgi(this->m_PenaltyGridImage, penaltyGridImageRegion);
+/**
+ * ******************* ThreadedGetValueAndDerivative *******************
+ */
 
-  // neighborhood iterator
-  typedef itk::ConstNeighborhoodIterator<PenaltyGridImageType> NeighborhoodIteratorType;
-  typename NeighborhoodIteratorType::RadiusType                radius;
-  radius.Fill(1);
-  NeighborhoodIteratorType ni(radius, this->m_PenaltyGridImage, penaltyGridImageRegion);
-  unsigned int             numberOfNeighborhood = ni.Size();
+template <class TFixedImage, class TScalarType>
+void
+DistancePreservingRigidityPenaltyTerm<TFixedImage, TScalarType>::ThreadedGetValueAndDerivative(ThreadIdType threadId)
+{
+  /** Give each thread a contiguous range of rigid penalty grid points (in Morton order), with about the same number
+   * of neighbours.
+   */
+  const ThreadIdType  numberOfThreads = Self::GetNumberOfWorkUnits();
+  const std::uint64_t numberOfNeighbors = this->m_RigidGridNeighbors.size();
+  const auto          findFirstPoint = [this, numberOfThreads, numberOfNeighbors](const ThreadIdType id) {
+    const auto target = static_cast<unsigned int>(numberOfNeighbors * id / numberOfThreads);
+    return static_cast<unsigned int>(std::lower_bound(this->m_RigidGridNeighborOffsets.cbegin(),
+                                                      this->m_RigidGridNeighborOffsets.cend() - 1,
+                                                      target) -
+                                     this->m_RigidGridNeighborOffsets.cbegin());
+  };
+  const unsigned int begin = findFirstPoint(threadId);
+  const unsigned int end = (threadId + 1 < numberOfThreads) ? findFirstPoint(threadId + 1)
+                                                            : static_cast<unsigned int>(this->m_RigidGridPoints.size());
+
+  /** Accumulate into the value and the derivative of this thread. */
+  MeasureType value = NumericTraits<MeasureType>::Zero;
+  this->ComputeValueAndDerivativeOfRigidGridPoints(
+    begin, end, value, this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Derivative);
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value = value;
+
+} // end ThreadedGetValueAndDerivative()
 
-  ContinuousIndexType      tindex_neighbor, ntindex_start, ntindex_neighbor_start;
-  ContinuousIndexValueType tx_neighbor, ty_neighbor, tz_neighbor;
 
-  typename BSplineKnotImageType::SizeType bSplineKnotImageSize =
-    this->m_BSplineKnotImage->GetBufferedRegion().GetSize();
+/**
+ * ******************* AfterThreadedGetValueAndDerivative *******************
+ */
 
-  MeasureType du_dC, du_dC_neighbor;
+template <class TFixedImage, class TScalarType>
+void
+DistancePreservingRigidityPenaltyTerm<TFixedImage, TScalarType>::AfterThreadedGetValueAndDerivative(
+  MeasureType &    value,
+  DerivativeType & derivative) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
 
-  unsigned int numberOfRigidGridsNeighbor;
+  /** Accumulate values. */
+  value = NumericTraits<MeasureType>::Zero;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    value += this->m_GetValueAndDerivativePerThreadVariables[i].st_Value;
 
-  const unsigned int parametersDimension = this->GetNumberOfParameters();
-  unsigned int       numberOfParametersPerDimension = parametersDimension / ImageDimension;
+    /** Reset this variable for the next iteration. */
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
+  }
 
-  // interpolation of segmented image
-  typedef itk::NearestNeighborInterpolateImageFunction<SegmentedImageType, double> SegmentedImageInterpolatorType;
-  auto segmentedImageInterpolator = SegmentedImageInterpolatorType::New();
+  /** Accumulate derivatives (and reset them), multi-threaded. The penalty is already normalized. */
+  this->m_ThreaderMetricParameters.st_DerivativePointer = derivative.begin();
+  this->m_ThreaderMetricParameters.st_NormalizationFactor = NumericTraits<DerivativeValueType>::OneValue();
 
-  segmentedImageInterpolator->SetInputImage(this->m_SampledSegmentedImage);
+  this->m_Threader->SetSingleMethod(this->AccumulateDerivativesThreaderCallback,
+                                    const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
+  this->m_Threader->SingleMethodExecute();
 
-  unsigned int pixelValue, pixelValueNeighbor;
+} // end AfterThreadedGetValueAndDerivative()
 
-  if (MovingImageDimension == 3)
-  {
-    for (pgi.GoToBegin(), ni.GoToBegin(); !pgi.IsAtEnd(); ++pgi, ++ni)
-    {
-      penaltyGridIndex = pgi.GetIndex();
 
-      this->m_PenaltyGridImage->TransformIndexToPhysicalPoint(penaltyGridIndex, penaltyGridPoint);
+/**
+ * ******************* ComputeValueAndDerivativeOfRigidGridPoints *******************
+ */
 
-      pixelValue = static_cast<unsigned int>(segmentedImageInterpolator->Evaluate(penaltyGridPoint));
+template <class TFixedImage, class TScalarType>
+void
+DistancePreservingRigidityPenaltyTerm<TFixedImage, TScalarType>::ComputeValueAndDerivativeOfRigidGridPoints(
+  const unsigned int begin,
+  const unsigned int end,
+  MeasureType &      value,
+  DerivativeType &   derivative) const
+{
+  const unsigned int numberOfParametersPerDimension = this->GetNumberOfParameters() / ImageDimension;
+  const typename BSplineKnotImageType::SizeType bSplineKnotImageSize =
+    this->m_BSplineKnotImage->GetBufferedRegion().GetSize();
 
-      ni.SetLocation(penaltyGridIndex);
+  unsigned int numberOfSupportPoints = 1;
+  long         knotStrides[ImageDimension];
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    numberOfSupportPoints *= 4;
+    knotStrides[i] = (i == 0) ? 1 : (knotStrides[i - 1] * static_cast<long>(bSplineKnotImageSize[i - 1]));
+  }
 
-      /** Penalty term calculation */
-      if (pixelValue > 0 && pixelValue < 6)
+  /** Adds factor[d] times the B-spline weights of the support region of the point, to the derivative of dimension d.
+   */
+  const auto addToDerivative = [&](const RigidGridPointType & rigidGridPoint, const double(&factors)[ImageDimension]) {
+    if (rigidGridPoint.m_FirstParameterIndex < 0)
+    {
+      return;
+    }
+    for (unsigned int mu = 0; mu < numberOfSupportPoints; ++mu)
+    {
+      double       weight = 1.0;
+      long         parameterIndex = rigidGridPoint.m_FirstParameterIndex;
+      unsigned int remainder = mu;
+      for (unsigned int i = 0; i < ImageDimension; ++i)
       {
-        numberOfRigidGridsNeighbor = 0;
+        weight *= rigidGridPoint.m_Weights[i][remainder % 4];
+        parameterIndex += static_cast<long>(remainder % 4) * knotStrides[i];
+        remainder /= 4;
+      }
+      for (unsigned int d = 0; d < ImageDimension; ++d)
+      {
+        derivative[parameterIndex + d * numberOfParametersPerDimension] += factors[d] * weight;
+      }
+    }
+  };
 
-        for (unsigned int kk = 0; kk < numberOfNeighborhood; ++kk)
-        {
-          neighborPenaltyGridIndex = ni.GetIndex(kk);
+  for (unsigned int pointNumber = begin; pointNumber < end; ++pointNumber)
+  {
+    const OutputPointType & xf = this->m_TransformedRigidGridPoints[pointNumber];
+    const unsigned int      neighborEnd = this->m_RigidGridNeighborOffsets[pointNumber + 1];
 
-          this->m_PenaltyGridImage->TransformIndexToPhysicalPoint(neighborPenaltyGridIndex, neighborPenaltyGridPoint);
+    /** The derivative terms of the point itself are accumulated over its neighbours, and added only once. */
+    double pointFactors[ImageDimension] = {};
 
-          pixelValueNeighbor =
-            static_cast<unsigned int>(segmentedImageInterpolator->Evaluate(neighborPenaltyGridPoint));
+    for (unsigned int k = this->m_RigidGridNeighborOffsets[pointNumber]; k < neighborEnd; ++k)
+    {
+      const RigidGridNeighborType & neighbor = this->m_RigidGridNeighbors[k];
+      const OutputPointType &       xn = this->m_TransformedRigidGridPoints[neighbor.m_Point];
 
-          if (pixelValue == pixelValueNeighbor)
-          {
-            numberOfRigidGridsNeighbor++;
-          }
-        }
+      const MeasureType difference = xn.SquaredEuclideanDistanceTo(xf) - neighbor.m_SquaredDistance;
+      value += neighbor.m_Weight * difference * difference;
 
-        if (numberOfRigidGridsNeighbor > 1)
-        {
-          for (unsigned int kk = 0; kk < numberOfNeighborhood; ++kk)
-          {
-            neighborPenaltyGridIndex = ni.GetIndex(kk);
-
-            this->m_PenaltyGridImage->TransformIndexToPhysicalPoint(neighborPenaltyGridIndex, neighborPenaltyGridPoint);
-
-            pixelValueNeighbor =
-              static_cast<unsigned int>(segmentedImageInterpolator->Evaluate(neighborPenaltyGridPoint));
-
-            if (pixelValue == pixelValueNeighbor)
-            {
-              xn = this->m_Transform->TransformPoint(neighborPenaltyGridPoint);
-              xf = this->m_Transform->TransformPoint(penaltyGridPoint);
-
-              dX = (neighborPenaltyGridPoint[0] - penaltyGridPoint[0]) *
-                     (neighborPenaltyGridPoint[0] - penaltyGridPoint[0]) +
-                   (neighborPenaltyGridPoint[1] - penaltyGridPoint[1]) *
-                     (neighborPenaltyGridPoint[1] - penaltyGridPoint[1]) +
-                   (neighborPenaltyGridPoint[2] - penaltyGridPoint[2]) *
-                     (neighborPenaltyGridPoint[2] - penaltyGridPoint[2]);
-
-              dx = (xn[0] - xf[0]) * (xn[0] - xf[0]) + (xn[1] - xf[1]) * (xn[1] - xf[1]) +
-                   (xn[2] - xf[2]) * (xn[2] - xf[2]);
-
-              penaltyTermBuffer = (dx - dX) * (dx - dX);
-
-              value += penaltyTermBuffer / numberOfRigidGridsNeighbor / (this->m_NumberOfRigidGrids);
-
-              // find neighboring B-Spline control points
-              this->m_BSplineKnotImage->TransformPhysicalPointToContinuousIndex(penaltyGridPoint, tindex);
-              this->m_BSplineKnotImage->TransformPhysicalPointToContinuousIndex(neighborPenaltyGridPoint,
-                                                                                tindex_neighbor);
-
-              tx = tindex[0];
-              ty = tindex[1];
-              tz = tindex[2];
-
-              tx_neighbor = tindex_neighbor[0];
-              ty_neighbor = tindex_neighbor[1];
-              tz_neighbor = tindex_neighbor[2];
-
-              for (unsigned dd = 0; dd < ImageDimension; ++dd)
-              {
-                ntindex_start[dd] = static_cast<ContinuousIndexValueType>(floor(tindex[dd])) - 1.0;
-                ntindex_neighbor_start[dd] = static_cast<ContinuousIndexValueType>(floor(tindex_neighbor[dd])) - 1.0;
-              }
-
-              derivativeTermTemp1 =
-                4 * (dx - dX) * (xn[0] - xf[0]) / numberOfRigidGridsNeighbor / (this->m_NumberOfRigidGrids);
-              derivativeTermTemp2 =
-                4 * (dx - dX) * (xn[1] - xf[1]) / numberOfRigidGridsNeighbor / (this->m_NumberOfRigidGrids);
-              derivativeTermTemp3 =
-                4 * (dx - dX) * (xn[2] - xf[2]) / numberOfRigidGridsNeighbor / (this->m_NumberOfRigidGrids);
-
-              for (unsigned int kk = 0; kk < 4; ++kk)
-              {
-                p = ntindex_start[2] + kk;
-                neighbor_p = ntindex_neighbor_start[2] + kk;
-
-                for (unsigned int jj = 0; jj < 4; ++jj)
-                {
-                  n = ntindex_start[1] + jj;
-                  neighbor_n = ntindex_neighbor_start[1] + jj;
-
-                  for (unsigned int ii = 0; ii < 4; ++ii)
-                  {
-                    m = ntindex_start[0] + ii;
-                    neighbor_m = ntindex_neighbor_start[0] + ii;
-
-                    // neighborhood of (i',j',k')
-                    du_dC_neighbor = (bSplineKernel->Evaluate(tx_neighbor - neighbor_m)) *
-                                     (bSplineKernel->Evaluate(ty_neighbor - neighbor_n)) *
-                                     (bSplineKernel->Evaluate(tz_neighbor - neighbor_p));
-
-                    par1 = static_cast<unsigned int>(neighbor_m) +
-                           bSplineKnotImageSize[0] * static_cast<unsigned int>(neighbor_n) +
-                           bSplineKnotImageSize[0] * bSplineKnotImageSize[1] * static_cast<unsigned int>(neighbor_p);
-
-                    derivative[par1] += derivativeTermTemp1 * du_dC_neighbor;
-                    derivative[par1 + numberOfParametersPerDimension] += derivativeTermTemp2 * du_dC_neighbor;
-                    derivative[par1 + 2 * numberOfParametersPerDimension] += derivativeTermTemp3 * du_dC_neighbor;
-
-                    // neighborhood of (i,j,k)
-                    du_dC = (bSplineKernel->Evaluate(tx - m)) * (bSplineKernel->Evaluate(ty - n)) *
-                            (bSplineKernel->Evaluate(tz - p));
-
-                    par2 = static_cast<unsigned int>(m) + bSplineKnotImageSize[0] * static_cast<unsigned int>(n) +
-                           bSplineKnotImageSize[0] * bSplineKnotImageSize[1] * static_cast<unsigned int>(p);
-
-                    derivative[par2] -= derivativeTermTemp1 * du_dC;
-                    derivative[par2 + numberOfParametersPerDimension] -= derivativeTermTemp2 * du_dC;
-                    derivative[par2 + 2 * numberOfParametersPerDimension] -= derivativeTermTemp3 * du_dC;
-                  }
-                }
-              }
-            }
-          } // end for
-        }   // end if
+      double neighborFactors[ImageDimension];
+      for (unsigned int d = 0; d < ImageDimension; ++d)
+      {
+        neighborFactors[d] = 4.0 * neighbor.m_Weight * difference * (xn[d] - xf[d]);
+        pointFactors[d] -= neighborFactors[d];
       }
-    } // end for
-  }   // end if ( dimension = 3 )
+      addToDerivative(this->m_RigidGridPoints[neighbor.m_Point], neighborFactors);
+    }
+    addToDerivative(this->m_RigidGridPoints[pointNumber], pointFactors);
+  }
 
-} // end GetValueAndDerivative()
+} // end ComputeValueAndDerivativeOfRigidGridPoints()
 
 
 /**
@@ -28,6 +28,14 @@ namespace elastix
  * \class GradientDifferenceMetric
  * \brief An metric based on the itk::GradientDifferenceImageToImageMetric.
  *
+ * The parameters used in this class are:
+ * \parameter Metric: Select this metric as follows:\n
+ *    <tt>(Metric "GradientDifference")</tt>
+ * \parameter UseImageSampler: Compute the measure only at the pixels selected by
+ *    the ImageSampler, instead of at all pixels of the fixed image. Then the moving
+ *    image is only projected onto the pixels around the samples, at each evaluation.\n
+ *    example: <tt>(UseImageSampler "true")</tt>\n
+ *    The default is "false".
  *
  * \ingroup Metrics
  *
@@ -117,6 +125,12 @@ public:
   using typename Superclass2::RegistrationPointer;
   typedef typename Superclass2::ITKBaseType ITKBaseType;
 
+  /** Reads UseImageSampler. This is done before the registration connects the
+   * image sampler to the metric.
+   */
+  int
+  BeforeAll(void) override;
+
   /** Sets up a timer to measure the initialization time and
    * calls the Superclass' implementation.
    */
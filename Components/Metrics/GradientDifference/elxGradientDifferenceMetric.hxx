@@ -24,6 +24,23 @@
 namespace elastix
 {
 
+/**
+ * ******************* BeforeAll ***********************
+ */
+
+template <class TElastix>
+int
+GradientDifferenceMetric<TElastix>::BeforeAll(void)
+{
+  bool useImageSampler = false;
+  this->GetConfiguration()->ReadParameter(useImageSampler, "UseImageSampler", this->GetComponentLabel(), 0, 0);
+  this->SetUseImageSampler(useImageSampler);
+
+  return 0;
+
+} // end BeforeAll()
+
+
 /**
  * ******************* Initialize ***********************
  */
@@ -45,6 +45,8 @@
 #include "itkAdvancedCombinationTransform.h"
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
 
+#include <vector>
+
 namespace itk
 {
 /** \class GradientDifferenceImageToImageMetric
@@ -64,6 +66,22 @@ namespace itk
  * on it. Values at these non-grid position of the Fixed image are
  * interpolated using a user-selected Interpolator.
  *
+ * By default, the measure is computed for all pixels of the fixed image
+ * region, which requires the moving image to be projected onto the whole
+ * fixed image grid, at each evaluation. When UseImageSampler is switched on
+ * (by a subclass), the measure is only computed at the pixels selected by
+ * the image sampler. Then only the moved intensities of the pixels in the
+ * Sobel neighborhoods of these samples are computed, by the ray-cast
+ * interpolator, and the range of the moved gradients is taken over the
+ * samples. The fixed image gradients are computed once, in Initialize(), in
+ * both cases.
+ *
+ * The derivative is computed by central differences, each of which needs a
+ * new projection of the moving image. This projection is not differentiable
+ * by the ray-cast interpolator, so there is no analytic derivative, not even
+ * for a rigid transform. The perturbations are evaluated one by one, as the
+ * interpolator casts its rays through a single transform.
+ *
  * Implementation of this class is based on:
  * Hipwell, J. H., et. al. (2003), "Intensity-Based 2-D-3D Registration of
  * Cerebral Angiograms,", IEEE Transactions on Medical Imaging,
@@ -110,6 +128,7 @@ public:
   using typename Superclass::MovingImageType;
   using typename Superclass::FixedImageConstPointer;
   using typename Superclass::MovingImageConstPointer;
+  using typename Superclass::ImageSampleContainerType;
   typedef typename TFixedImage::PixelType      FixedImagePixelType;
   typedef typename TMovingImage::PixelType     MovedImagePixelType;
   typedef typename MovingImageType::RegionType MovingImageRegionType;
@@ -178,7 +197,16 @@ protected:
   void
   ComputeVariance(void) const;
 
-  /** Compute the similarity measure using a specified subtraction factor. */
+  /** Select the pixels of the fixed image region that are inside the fixed image mask. */
+  void
+  ComputeSampleOffsets(void);
+
+  /** Compute the moved image gradients, and their range, at the pixels selected by the image sampler. */
+  void
+  ComputeMovedGradientsAtSamples(void) const;
+
+  /** Compute the similarity measure using a specified subtraction factor. Assumes that the moved gradient images are
+   * up-to-date, for the specified parameters. */
   MeasureType
   ComputeMeasure(const TransformParametersType & parameters, const double * subtractionFactor) const;
 
@@ -222,6 +250,23 @@ private:
 
   typename MovedSobelFilter::Pointer m_MovedSobelFilters[Self::MovedImageDimension];
 
+  /** The buffer offsets of the selected pixels, in the fixed and the moved gradient images. */
+  std::vector<OffsetValueType> m_FixedSampleOffsets;
+  std::vector<OffsetValueType> m_MovedSampleOffsets;
+
+  /** When the image sampler is used: the buffer offsets of the sampled pixels in the fixed gradient images, and the
+   * moved image gradients at these pixels (for each fixed image dimension).
+   */
+  mutable std::vector<OffsetValueType>        m_FixedOffsetsOfSamples;
+  mutable std::vector<MovedGradientPixelType> m_MovedGradientsAtSamples;
+
+  /** When the image sampler is used: the moved image intensities of the pixels, and the evaluation at which each of
+   * them was computed, so that each of them is computed only once per evaluation.
+   */
+  mutable std::vector<RealType>      m_MovedValuesAtPixels;
+  mutable std::vector<unsigned long> m_MovedValueStamps;
+  mutable unsigned long              m_EvaluationStamp;
+
   ScalesType                  m_Scales;
   double                      m_DerivativeDelta;
   double                      m_Rescalingfactor;
@@ -40,6 +40,7 @@
 #include "itkRescaleIntensityImageFilter.h"
 #include "itkImageFileWriter.h"
 
+#include <algorithm> // For min and max.
 #include <iostream>
 #include <iomanip>
 #include <stdio.h>
@@ -77,6 +78,9 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::GradientDiffere
 
   this->m_DerivativeDelta = 0.001;
   this->m_Rescalingfactor = 1.0;
+  this->m_EvaluationStamp = 0;
+
+  this->SetUseImageSampler(false);
 }
 
 
@@ -127,7 +131,12 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::Initialize(void
   this->m_TransformMovingImageFilter->SetOutputOrigin(this->m_FixedImage->GetOrigin());
   this->m_TransformMovingImageFilter->SetOutputSpacing(this->m_FixedImage->GetSpacing());
   this->m_TransformMovingImageFilter->SetOutputDirection(this->m_FixedImage->GetDirection());
-  this->m_TransformMovingImageFilter->Update();
+
+  /** With an image sampler, the moved image is only evaluated at the pixels around the samples. */
+  if (!this->GetUseImageSampler())
+  {
+    this->m_TransformMovingImageFilter->Update();
+  }
 
   this->m_CastMovedImageFilter->SetInput(this->m_TransformMovingImageFilter->GetOutput());
 
@@ -139,12 +148,22 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::Initialize(void
     this->m_MovedSobelFilters[iFilter]->OverrideBoundaryCondition(&this->m_MovedBoundCond);
     this->m_MovedSobelFilters[iFilter]->SetOperator(this->m_MovedSobelOperators[iFilter]);
     this->m_MovedSobelFilters[iFilter]->SetInput(this->m_CastMovedImageFilter->GetOutput());
-    this->m_MovedSobelFilters[iFilter]->UpdateLargestPossibleRegion();
+    if (!this->GetUseImageSampler())
+    {
+      this->m_MovedSobelFilters[iFilter]->UpdateLargestPossibleRegion();
+    }
   }
 
   /** Compute the variance */
   ComputeVariance();
 
+  /** Select the pixels at which the measure is evaluated. With an image sampler, they are selected by the sampler. */
+  this->m_MovedValueStamps.clear();
+  if (!this->GetUseImageSampler())
+  {
+    this->ComputeSampleOffsets();
+  }
+
   /* Rescale the similarity measure between 0-1; */
   MeasureType tmpmeasure = this->GetValue(this->m_Transform->GetParameters());
 
@@ -182,6 +201,12 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputeMovedGra
 
   for (iDimension = 0; iDimension < FixedImageDimension; ++iDimension)
   {
+    /** The gradients are not used in a direction in which the fixed image has no variance. */
+    if (this->m_Variance[iDimension] == NumericTraits<MovedGradientPixelType>::ZeroValue())
+    {
+      continue;
+    }
+
     typedef itk::ImageRegionConstIteratorWithIndex<MovedGradientImageType> IteratorType;
 
     IteratorType iterate(m_MovedSobelFilters[iDimension]->GetOutput(), this->GetFixedImageRegion());
@@ -331,6 +356,171 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputeVariance
 } // end ComputeVariance()
 
 
+/**
+ * ******************** ComputeSampleOffsets ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputeSampleOffsets(void)
+{
+  /** The fixed image mask is evaluated only once, here, instead of for each
+   * pixel, for each dimension, at each evaluation of the measure. The pixels
+   * are stored as buffer offsets into the fixed and the moved gradient images.
+   */
+  const FixedGradientImageType & fixedGradientImage = *(this->m_FixedSobelFilters[0]->GetOutput());
+  const MovedGradientImageType & movedGradientImage = *(this->m_MovedSobelFilters[0]->GetOutput());
+
+  this->m_FixedSampleOffsets.clear();
+  this->m_MovedSampleOffsets.clear();
+
+  typedef itk::ImageRegionConstIteratorWithIndex<FixedGradientImageType> IteratorType;
+
+  for (IteratorType iterate(&fixedGradientImage, this->GetFixedImageRegion()); !iterate.IsAtEnd(); ++iterate)
+  {
+    const typename FixedImageType::IndexType & currentIndex = iterate.GetIndex();
+
+    /** if fixedMask is given */
+    if (!this->m_FixedImageMask.IsNull())
+    {
+      typename FixedImageType::PointType point;
+      this->m_FixedImage->TransformIndexToPhysicalPoint(currentIndex, point);
+
+      if (!this->m_FixedImageMask->IsInsideInWorldSpace(point))
+      {
+        continue;
+      }
+    }
+
+    this->m_FixedSampleOffsets.push_back(fixedGradientImage.ComputeOffset(currentIndex));
+    this->m_MovedSampleOffsets.push_back(movedGradientImage.ComputeOffset(currentIndex));
+  }
+
+} // end ComputeSampleOffsets()
+
+
+/**
+ * ******************** ComputeMovedGradientsAtSamples ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputeMovedGradientsAtSamples(void) const
+{
+  typedef typename FixedGradientImageType::IndexType IndexType;
+  typedef typename FixedGradientImageType::PointType PointType;
+
+  /** The moved image has the same grid as the fixed (gradient) image. */
+  const FixedGradientImageType & fixedGradientImage = *(this->m_FixedSobelFilters[0]->GetOutput());
+  const auto &                   region = fixedGradientImage.GetBufferedRegion();
+  const IndexType                regionIndex = region.GetIndex();
+  const auto                     regionSize = region.GetSize();
+  const auto &                   rayTransform = *(this->m_TransformMovingImageFilter->GetTransform());
+
+  /** A moved pixel may be in the Sobel neighborhood of multiple samples, but its intensity is computed only once
+   * per evaluation, just like the ResampleImageFilter does, including its conversion to the fixed pixel type.
+   */
+  const std::size_t numberOfPixels = region.GetNumberOfPixels();
+  if (this->m_MovedValueStamps.size() != numberOfPixels)
+  {
+    this->m_MovedValueStamps.assign(numberOfPixels, 0);
+    this->m_MovedValuesAtPixels.resize(numberOfPixels);
+    this->m_EvaluationStamp = 0;
+  }
+  const unsigned long evaluationStamp = ++this->m_EvaluationStamp;
+  const double        minimumValue = static_cast<double>(NumericTraits<FixedImagePixelType>::NonpositiveMin());
+  const double        maximumValue = static_cast<double>(NumericTraits<FixedImagePixelType>::max());
+
+  const auto getMovedValue = [this, &fixedGradientImage, &rayTransform, evaluationStamp, minimumValue, maximumValue](
+                               const IndexType & index) {
+    const OffsetValueType offset = fixedGradientImage.ComputeOffset(index);
+    if (this->m_MovedValueStamps[offset] != evaluationStamp)
+    {
+      PointType point;
+      fixedGradientImage.TransformIndexToPhysicalPoint(index, point);
+      const double value = this->m_Interpolator->Evaluate(rayTransform.TransformPoint(point));
+      this->m_MovedValuesAtPixels[offset] =
+        static_cast<RealType>(static_cast<FixedImagePixelType>(std::min(std::max(value, minimumValue), maximumValue)));
+      this->m_MovedValueStamps[offset] = evaluationStamp;
+    }
+    return this->m_MovedValuesAtPixels[offset];
+  };
+
+  /** Select the sampled pixels. */
+  const ImageSampleContainerType & sampleContainer = *(this->GetImageSampler()->GetOutput());
+  this->m_FixedOffsetsOfSamples.clear();
+  this->m_FixedOffsetsOfSamples.reserve(sampleContainer.Size());
+  this->m_MovedGradientsAtSamples.clear();
+  this->m_MovedGradientsAtSamples.reserve(sampleContainer.Size() * FixedImageDimension);
+
+  typename ImageSampleContainerType::ConstIterator fiter;
+  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer.Begin();
+  typename ImageSampleContainerType::ConstIterator fend = sampleContainer.End();
+
+  for (fiter = fbegin; fiter != fend; ++fiter)
+  {
+    IndexType index;
+    if (!fixedGradientImage.TransformPhysicalPointToIndex((*fiter).Value().m_ImageCoordinates, index))
+    {
+      continue;
+    }
+    this->m_FixedOffsetsOfSamples.push_back(fixedGradientImage.ComputeOffset(index));
+
+    /** Apply the Sobel operators to the neighborhood of the sampled pixel, with a zero flux Neumann boundary
+     * condition, just like the moved Sobel filters. */
+    for (unsigned int iDimension = 0; iDimension < FixedImageDimension; ++iDimension)
+    {
+      MovedGradientPixelType gradient = NumericTraits<MovedGradientPixelType>::ZeroValue();
+
+      if (this->m_Variance[iDimension] != NumericTraits<MovedGradientPixelType>::ZeroValue())
+      {
+        const auto & sobelOperator = this->m_MovedSobelOperators[iDimension];
+
+        for (unsigned int k = 0; k < sobelOperator.Size(); ++k)
+        {
+          if (sobelOperator[k] == NumericTraits<MovedGradientPixelType>::ZeroValue())
+          {
+            continue;
+          }
+          const auto neighborOffset = sobelOperator.GetOffset(k);
+          IndexType  neighborIndex;
+          for (unsigned int j = 0; j < FixedImageDimension; ++j)
+          {
+            const IndexValueType lastIndex = regionIndex[j] + static_cast<IndexValueType>(regionSize[j]) - 1;
+            neighborIndex[j] = std::min(std::max(index[j] + neighborOffset[j], regionIndex[j]), lastIndex);
+          }
+          gradient += sobelOperator[k] * getMovedValue(neighborIndex);
+        }
+      }
+      this->m_MovedGradientsAtSamples.push_back(gradient);
+    }
+  }
+
+  /** Check if enough samples were valid. */
+  const std::size_t numberOfSamples = this->m_FixedOffsetsOfSamples.size();
+  this->CheckNumberOfSamples(sampleContainer.Size(), numberOfSamples);
+  if (numberOfSamples == 0)
+  {
+    itkExceptionMacro(<< "ERROR: none of the samples is inside the fixed image.");
+  }
+
+  /** Compute the range of the moved image gradients at the samples. */
+  for (unsigned int iDimension = 0; iDimension < FixedImageDimension; ++iDimension)
+  {
+    this->m_MinMovedGradient[iDimension] = this->m_MovedGradientsAtSamples[iDimension];
+    this->m_MaxMovedGradient[iDimension] = this->m_MovedGradientsAtSamples[iDimension];
+
+    for (std::size_t i = 1; i < numberOfSamples; ++i)
+    {
+      const MovedGradientPixelType gradient = this->m_MovedGradientsAtSamples[i * FixedImageDimension + iDimension];
+      this->m_MinMovedGradient[iDimension] = std::min(this->m_MinMovedGradient[iDimension], gradient);
+      this->m_MaxMovedGradient[iDimension] = std::max(this->m_MaxMovedGradient[iDimension], gradient);
+    }
+  }
+
+} // end ComputeMovedGradientsAtSamples()
+
+
 /**
  * ******************** ComputeMeasure ******************************
  */
@@ -355,83 +545,43 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputeMeasure(
    * - Now you can call GetValueAndDerivative multi-threaded.
    */
   this->BeforeThreadedGetValueAndDerivative(parameters);
-  // this->SetTransformParameters( parameters );
 
-  unsigned int iDimension;
-  this->m_TransformMovingImageFilter->Modified();
-  this->m_TransformMovingImageFilter->UpdateLargestPossibleRegion();
+  /** The moved image gradients are already updated by GetValue(), for these parameters, either for the whole fixed
+   * image region, or at the samples, so they do not need to be recomputed here.
+   */
+  const bool        useSamples = this->GetUseImageSampler();
+  const std::size_t numberOfSamples =
+    useSamples ? this->m_FixedOffsetsOfSamples.size() : this->m_FixedSampleOffsets.size();
   MeasureType measure = NumericTraits<MeasureType>::Zero;
 
-  typename FixedImageType::IndexType currentIndex;
-  typename FixedImageType::PointType point;
-
-  for (iDimension = 0; iDimension < FixedImageDimension; ++iDimension)
+  for (unsigned int iDimension = 0; iDimension < FixedImageDimension; ++iDimension)
   {
+    const MovedGradientPixelType variance = this->m_Variance[iDimension];
 
-    if (this->m_Variance[iDimension] == NumericTraits<MovedGradientPixelType>::ZeroValue())
+    if (variance == NumericTraits<MovedGradientPixelType>::ZeroValue())
     {
       continue;
     }
 
-    /** Iterate over the fixed and moving gradient images
+    /** Loop over the selected pixels of the fixed and moving gradient images
      *  calculating the similarity measure
      */
+    const FixedGradientPixelType * const fixedGradients =
+      this->m_FixedSobelFilters[iDimension]->GetOutput()->GetBufferPointer();
+    const MovedGradientPixelType * const movedGradients =
+      useSamples ? nullptr : this->m_MovedSobelFilters[iDimension]->GetOutput()->GetBufferPointer();
 
-    MovedGradientPixelType movedGradient;
-    FixedGradientPixelType fixedGradient;
-    MovedGradientPixelType diff;
-
-    typedef itk::ImageRegionConstIteratorWithIndex<FixedGradientImageType> FixedIteratorType;
-
-    FixedIteratorType fixedIterator(this->m_FixedSobelFilters[iDimension]->GetOutput(), this->GetFixedImageRegion());
-
-    typedef itk::ImageRegionConstIteratorWithIndex<MovedGradientImageType> MovedIteratorType;
-
-    MovedIteratorType movedIterator(this->m_MovedSobelFilters[iDimension]->GetOutput(), this->GetFixedImageRegion());
-
-    this->m_FixedSobelFilters[iDimension]->UpdateLargestPossibleRegion();
-    this->m_MovedSobelFilters[iDimension]->UpdateLargestPossibleRegion();
-
-    bool sampleOK = false;
-
-    if (this->m_FixedImageMask.IsNull())
+    for (std::size_t i = 0; i < numberOfSamples; ++i)
     {
-      sampleOK = true;
+      const MovedGradientPixelType movedGradient =
+        useSamples ? this->m_MovedGradientsAtSamples[i * FixedImageDimension + iDimension]
+                   : movedGradients[this->m_MovedSampleOffsets[i]];
+      const FixedGradientPixelType fixedGradient =
+        fixedGradients[useSamples ? this->m_FixedOffsetsOfSamples[i] : this->m_FixedSampleOffsets[i]];
+      const MovedGradientPixelType diff = fixedGradient - subtractionFactor[iDimension] * movedGradient;
+      measure += variance / (variance + diff * diff);
     }
 
-    while (!fixedIterator.IsAtEnd())
-    {
-      /** Get current index */
-      currentIndex = fixedIterator.GetIndex();
-      this->m_FixedImage->TransformIndexToPhysicalPoint(currentIndex, point);
-
-      /** if fixedMask is given */
-      if (!this->m_FixedImageMask.IsNull())
-      {
-
-        if (this->m_FixedImageMask->IsInsideInWorldSpace(point)) // sample is good
-        {
-          sampleOK = true;
-        }
-        else // sample no good
-        {
-          sampleOK = false;
-        }
-      }
-
-      if (sampleOK)
-      {
-        movedGradient = movedIterator.Get();
-        fixedGradient = fixedIterator.Get();
-        diff = fixedGradient - subtractionFactor[iDimension] * movedGradient;
-        measure += this->m_Variance[iDimension] / (this->m_Variance[iDimension] + diff * diff);
-
-      } // end if sampleOK
-
-      ++fixedIterator;
-      ++movedIterator;
-    } // end while fixedIterator
-
   } // end for iDimension
 
   return measure /= -this->m_Rescalingfactor; // negative for minimization
@@ -451,17 +601,34 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::GetValue(
   unsigned int iFilter;
   unsigned int iDimension;
   this->SetTransformParameters(parameters);
-  this->m_TransformMovingImageFilter->Modified();
-  this->m_TransformMovingImageFilter->UpdateLargestPossibleRegion();
 
-  /** Update the gradient images */
-  for (iFilter = 0; iFilter < MovedImageDimension; ++iFilter)
+  if (this->GetUseImageSampler())
   {
-    this->m_MovedSobelFilters[iFilter]->UpdateLargestPossibleRegion();
+    /** Compute the moved image gradients, and their range, only at the samples. */
+    this->GetImageSampler()->Update();
+    this->ComputeMovedGradientsAtSamples();
   }
+  else
+  {
+    this->m_TransformMovingImageFilter->Modified();
+    this->m_TransformMovingImageFilter->UpdateLargestPossibleRegion();
 
-  /** Compute the range of the moved image gradients */
-  this->ComputeMovedGradientRange();
+    /** Update the gradient images, except those in a direction in which the
+     * fixed image has no variance (for example the third direction of a 2D
+     * projection image), as they do not contribute to the measure. */
+    for (iFilter = 0; iFilter < MovedImageDimension; ++iFilter)
+    {
+      if ((iFilter < FixedImageDimension) &&
+          (this->m_Variance[iFilter] == NumericTraits<MovedGradientPixelType>::ZeroValue()))
+      {
+        continue;
+      }
+      this->m_MovedSobelFilters[iFilter]->UpdateLargestPossibleRegion();
+    }
+
+    /** Compute the range of the moved image gradients */
+    this->ComputeMovedGradientRange();
+  }
 
   MovedGradientPixelType subtractionFactor[FixedImageDimension];
   MeasureType            currentMeasure;
@@ -0,0 +1,160 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkFlatKDTree_h
+#define itkFlatKDTree_h
+
+#include "itkBinaryTreeBase.h"
+#include "itkMultiThreaderBase.h"
+#include <ANN/ANN.h> // For ANN_ALLOW_SELF_MATCH.
+
+#include <vector>
+
+namespace itk
+{
+
+/**
+ * \class FlatKDTree
+ *
+ * \brief A kd-tree, stored in flat arrays, which can be built and searched by multiple threads.
+ *
+ * Contrary to the ANN trees, the nodes of this tree are not allocated one by one.
+ * The tree is a complete binary tree, stored as an implicit array: the children
+ * of node i are the nodes 2i+1 and 2i+2. Each node splits its range of points
+ * at the median, along the dimension of the largest spread, until the number of
+ * points in a range (a bucket) is at most the bucket size. Only the splitting
+ * dimension and value of each node are stored, the ranges follow from the
+ * number of points. After the construction, the points are copied in the order
+ * of the buckets, so that the points of a bucket are contiguous in memory.
+ *
+ * The construction proceeds level by level, in parallel over the nodes of a
+ * level. The Search() function does not modify the tree, so that multiple
+ * threads may search the tree simultaneously.
+ *
+ * \ingroup ANNwrap
+ */
+
+template <class TListSample>
+class ITK_TEMPLATE_EXPORT FlatKDTree : public BinaryTreeBase<TListSample>
+{
+public:
+  /** Standard itk. */
+  typedef FlatKDTree                  Self;
+  typedef BinaryTreeBase<TListSample> Superclass;
+  typedef SmartPointer<Self>          Pointer;
+  typedef SmartPointer<const Self>    ConstPointer;
+
+  /** New method for creating an object using a factory. */
+  itkNewMacro(Self);
+
+  /** ITK type info. */
+  itkTypeMacro(FlatKDTree, BinaryTreeBase);
+
+  /** Typedef's from Superclass. */
+  using typename Superclass::SampleType;
+  using typename Superclass::MeasurementVectorType;
+  using typename Superclass::MeasurementVectorSizeType;
+  using typename Superclass::TotalAbsoluteFrequencyType;
+
+  /** Typedef's. */
+  typedef unsigned int BucketSizeType;
+
+  /** Set and get the bucket size: the maximum number of points in a bucket. */
+  itkSetClampMacro(BucketSize, BucketSizeType, 1, NumericTraits<BucketSizeType>::max());
+  itkGetConstMacro(BucketSize, BucketSizeType);
+
+  /** Set and get the threader used to build the tree, typically the threader of the metric
+   * that uses the tree. When no threader is set, the tree is built by the calling thread.
+   */
+  itkSetObjectMacro(Threader, MultiThreaderBase);
+  itkGetModifiableObjectMacro(Threader, MultiThreaderBase);
+
+  /** Generate the tree. */
+  void
+  GenerateTree(void) override;
+
+  /** Search the k nearest neighbours of the query point qp. The indices and the squared
+   * distances of the neighbours are stored in ind and dists, which should both have room
+   * for k elements, sorted by increasing distance. When the tree has less than k points,
+   * the remaining neighbours get index -1. Like the ANN trees, points at distance zero are
+   * skipped, unless ANN_ALLOW_SELF_MATCH is set. With an error bound eps > 0, the distance
+   * of the i-th neighbour may be up to a factor (1 + eps) larger than the true distance.
+   * This function is thread-safe.
+   */
+  void
+  Search(const double * qp, unsigned int k, double eps, int * ind, double * dists) const;
+
+protected:
+  /** Constructor. */
+  FlatKDTree();
+
+  /** Destructor. */
+  ~FlatKDTree() override = default;
+
+  /** PrintSelf. */
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Member variables. */
+  BucketSizeType m_BucketSize;
+
+private:
+  FlatKDTree(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+
+  /** The state of a single search. */
+  struct SearchStateType
+  {
+    const double * m_QueryPoint;
+    unsigned int   m_K;
+    double         m_MaximumError;
+    int *          m_Indices;
+    double *       m_Distances;
+    double *       m_Offsets;
+  };
+
+  /** Searches the node with the specified range of points, at the specified depth. */
+  void
+  SearchNode(std::size_t       node,
+             std::size_t       begin,
+             std::size_t       end,
+             unsigned int      depth,
+             double            boxDistance,
+             SearchStateType & state) const;
+
+  /** The threader used to build the tree, if any. */
+  MultiThreaderBase::Pointer m_Threader;
+
+  /** The tree: the number of levels of internal nodes, and their splitting dimensions and values. */
+  unsigned int              m_NumberOfLevels;
+  std::vector<unsigned int> m_SplitDimensions;
+  std::vector<double>       m_SplitValues;
+
+  /** The points, in the order of the buckets, and their indices in the sample. */
+  std::vector<double> m_Points;
+  std::vector<int>    m_PointIndices;
+  unsigned int        m_Dimension;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkFlatKDTree.hxx"
+#endif
+
+#endif // end #ifndef itkFlatKDTree_h
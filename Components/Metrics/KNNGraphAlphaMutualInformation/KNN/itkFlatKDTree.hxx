@@ -0,0 +1,293 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkFlatKDTree_hxx
+#define itkFlatKDTree_hxx
+
+#include "itkFlatKDTree.h"
+
+#include <algorithm> // For nth_element.
+#include <numeric>   // For iota.
+
+namespace itk
+{
+
+/**
+ * ************************ Constructor *************************
+ */
+
+template <class TListSample>
+FlatKDTree<TListSample>::FlatKDTree()
+{
+  this->m_BucketSize = 1;
+  this->m_Threader = nullptr;
+  this->m_NumberOfLevels = 0;
+  this->m_Dimension = 0;
+} // end Constructor
+
+
+/**
+ * ************************ GenerateTree *************************
+ */
+
+template <class TListSample>
+void
+FlatKDTree<TListSample>::GenerateTree(void)
+{
+  const std::size_t  numberOfPoints = this->GetActualNumberOfDataPoints();
+  const unsigned int dim = this->GetDataDimension();
+  const auto * const data = this->GetSample()->GetInternalContainer();
+
+  /** Compute the number of levels of internal nodes, such that no bucket has more
+   * than m_BucketSize points. The largest range of a level has ceil( n / 2^level ) points.
+   */
+  this->m_NumberOfLevels = 0;
+  for (std::size_t largestRange = numberOfPoints; largestRange > this->m_BucketSize;
+       largestRange = (largestRange + 1) / 2)
+  {
+    ++this->m_NumberOfLevels;
+  }
+  const std::size_t numberOfNodes = (std::size_t{ 1 } << this->m_NumberOfLevels) - 1;
+  this->m_SplitDimensions.assign(numberOfNodes, 0);
+  this->m_SplitValues.assign(numberOfNodes, 0.0);
+  this->m_Dimension = dim;
+
+  /** The indices of the points, reordered while building the tree. */
+  std::vector<int> indices(numberOfPoints);
+  std::iota(indices.begin(), indices.end(), 0);
+
+  /** The boundaries of the ranges of the nodes of the current level. */
+  std::vector<std::size_t> boundaries{ 0, numberOfPoints };
+
+  /** Build the tree level by level. The nodes of a level have disjoint ranges,
+   * so they can be split in parallel.
+   */
+  for (unsigned int level = 0; level < this->m_NumberOfLevels; ++level)
+  {
+    const std::size_t firstNode = (std::size_t{ 1 } << level) - 1;
+    const std::size_t numberOfNodesOfLevel = std::size_t{ 1 } << level;
+
+    const auto splitNode = [this, data, dim, firstNode, &indices, &boundaries](const SizeValueType j) {
+      const std::size_t begin = boundaries[j];
+      const std::size_t end = boundaries[j + 1];
+      const std::size_t middle = begin + (end - begin) / 2;
+      if (middle == end)
+      {
+        return;
+      }
+
+      /** Split along the dimension with the largest spread. */
+      unsigned int splitDimension = 0;
+      double       largestSpread = -1.0;
+      for (unsigned int d = 0; d < dim; ++d)
+      {
+        double minimum = data[indices[begin]][d];
+        double maximum = minimum;
+        for (std::size_t p = begin + 1; p < end; ++p)
+        {
+          const double value = data[indices[p]][d];
+          minimum = std::min(minimum, value);
+          maximum = std::max(maximum, value);
+        }
+        if (maximum - minimum > largestSpread)
+        {
+          largestSpread = maximum - minimum;
+          splitDimension = d;
+        }
+      }
+
+      /** Split at the median. */
+      std::nth_element(indices.begin() + begin,
+                       indices.begin() + middle,
+                       indices.begin() + end,
+                       [data, splitDimension](const int a, const int b) {
+                         return data[a][splitDimension] < data[b][splitDimension];
+                       });
+      this->m_SplitDimensions[firstNode + j] = splitDimension;
+      this->m_SplitValues[firstNode + j] = data[indices[middle]][splitDimension];
+    };
+
+    if (this->m_Threader)
+    {
+      this->m_Threader->ParallelizeArray(0, numberOfNodesOfLevel, splitNode, nullptr);
+    }
+    else
+    {
+      for (SizeValueType j = 0; j < numberOfNodesOfLevel; ++j)
+      {
+        splitNode(j);
+      }
+    }
+
+    /** Compute the ranges of the next level. */
+    std::vector<std::size_t> nextBoundaries(2 * numberOfNodesOfLevel + 1);
+    for (std::size_t j = 0; j < numberOfNodesOfLevel; ++j)
+    {
+      nextBoundaries[2 * j] = boundaries[j];
+      nextBoundaries[2 * j + 1] = boundaries[j] + (boundaries[j + 1] - boundaries[j]) / 2;
+    }
+    nextBoundaries.back() = numberOfPoints;
+    boundaries.swap(nextBoundaries);
+  }
+
+  /** Copy the points in the order of the buckets. */
+  this->m_Points.resize(numberOfPoints * dim);
+  for (std::size_t p = 0; p < numberOfPoints; ++p)
+  {
+    std::copy_n(data[indices[p]], dim, this->m_Points.begin() + p * dim);
+  }
+  this->m_PointIndices.swap(indices);
+
+} // end GenerateTree()
+
+
+/**
+ * ************************ Search *************************
+ */
+
+template <class TListSample>
+void
+FlatKDTree<TListSample>::Search(const double *     qp,
+                                const unsigned int k,
+                                const double       eps,
+                                int *              ind,
+                                double *           dists) const
+{
+  std::fill_n(ind, k, -1);
+  std::fill_n(dists, k, NumericTraits<double>::max());
+  if ((k == 0) || this->m_PointIndices.empty())
+  {
+    return;
+  }
+
+  /** The offsets of the query point to the box of the current node, per dimension. They are
+   * stored per thread, so that they are not allocated for each query.
+   */
+  thread_local std::vector<double> offsets;
+  offsets.assign(this->m_Dimension, 0.0);
+
+  SearchStateType state;
+  state.m_QueryPoint = qp;
+  state.m_K = k;
+  state.m_MaximumError = (1.0 + eps) * (1.0 + eps);
+  state.m_Indices = ind;
+  state.m_Distances = dists;
+  state.m_Offsets = offsets.data();
+
+  this->SearchNode(0, 0, this->m_PointIndices.size(), 0, 0.0, state);
+
+} // end Search()
+
+
+/**
+ * ************************ SearchNode *************************
+ */
+
+template <class TListSample>
+void
+FlatKDTree<TListSample>::SearchNode(const std::size_t  node,
+                                    const std::size_t  begin,
+                                    const std::size_t  end,
+                                    const unsigned int depth,
+                                    const double       boxDistance,
+                                    SearchStateType &  state) const
+{
+  const unsigned int dim = this->m_Dimension;
+  const unsigned int k = state.m_K;
+
+  if (depth == this->m_NumberOfLevels)
+  {
+    /** A bucket: check all its points, which are contiguous in memory. */
+    const double * point = this->m_Points.data() + begin * dim;
+    for (std::size_t p = begin; p < end; ++p, point += dim)
+    {
+      double distance = 0.0;
+      for (unsigned int d = 0; d < dim; ++d)
+      {
+        const double diff = state.m_QueryPoint[d] - point[d];
+        distance += diff * diff;
+      }
+
+      /** Insert the point in the sorted list of the k nearest neighbours. */
+      if ((distance < state.m_Distances[k - 1]) && (ANN_ALLOW_SELF_MATCH || (distance != 0.0)))
+      {
+        unsigned int i = k - 1;
+        for (; (i > 0) && (state.m_Distances[i - 1] > distance); --i)
+        {
+          state.m_Distances[i] = state.m_Distances[i - 1];
+          state.m_Indices[i] = state.m_Indices[i - 1];
+        }
+        state.m_Distances[i] = distance;
+        state.m_Indices[i] = this->m_PointIndices[p];
+      }
+    }
+    return;
+  }
+
+  const unsigned int splitDimension = this->m_SplitDimensions[node];
+  const double       diff = state.m_QueryPoint[splitDimension] - this->m_SplitValues[node];
+  const std::size_t  middle = begin + (end - begin) / 2;
+
+  /** First visit the child at the side of the query point, then the other child, if it may still be close enough. */
+  if (diff < 0.0)
+  {
+    this->SearchNode(2 * node + 1, begin, middle, depth + 1, boxDistance, state);
+  }
+  else
+  {
+    this->SearchNode(2 * node + 2, middle, end, depth + 1, boxDistance, state);
+  }
+
+  const double oldOffset = state.m_Offsets[splitDimension];
+  const double farBoxDistance = boxDistance - oldOffset * oldOffset + diff * diff;
+  if (farBoxDistance * state.m_MaximumError < state.m_Distances[k - 1])
+  {
+    state.m_Offsets[splitDimension] = diff;
+    if (diff < 0.0)
+    {
+      this->SearchNode(2 * node + 2, middle, end, depth + 1, farBoxDistance, state);
+    }
+    else
+    {
+      this->SearchNode(2 * node + 1, begin, middle, depth + 1, farBoxDistance, state);
+    }
+    state.m_Offsets[splitDimension] = oldOffset;
+  }
+
+} // end SearchNode()
+
+
+/**
+ * ************************ PrintSelf *************************
+ */
+
+template <class TListSample>
+void
+FlatKDTree<TListSample>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "BucketSize: " << this->m_BucketSize << std::endl;
+  os << indent << "NumberOfLevels: " << this->m_NumberOfLevels << std::endl;
+  os << indent << "Threader: " << this->m_Threader.GetPointer() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef itkFlatKDTree_hxx
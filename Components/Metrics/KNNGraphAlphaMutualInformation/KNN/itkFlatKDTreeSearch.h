@@ -0,0 +1,105 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkFlatKDTreeSearch_h
+#define itkFlatKDTreeSearch_h
+
+#include "itkBinaryTreeSearchBase.h"
+#include "itkFlatKDTree.h"
+
+namespace itk
+{
+
+/**
+ * \class FlatKDTreeSearch
+ *
+ * \brief Searches the k nearest neighbours in a FlatKDTree.
+ *
+ * Contrary to the ANN searchers, SearchKNearestNeighbors() may be called
+ * by multiple threads simultaneously.
+ *
+ * \ingroup ANNwrap
+ */
+
+template <class TListSample>
+class ITK_TEMPLATE_EXPORT FlatKDTreeSearch : public BinaryTreeSearchBase<TListSample>
+{
+public:
+  /** Standard itk. */
+  typedef FlatKDTreeSearch                  Self;
+  typedef BinaryTreeSearchBase<TListSample> Superclass;
+  typedef SmartPointer<Self>                Pointer;
+  typedef SmartPointer<const Self>          ConstPointer;
+
+  /** New method for creating an object using a factory. */
+  itkNewMacro(Self);
+
+  /** ITK type info. */
+  itkTypeMacro(FlatKDTreeSearch, BinaryTreeSearchBase);
+
+  /** Typedefs from Superclass. */
+  using typename Superclass::ListSampleType;
+  using typename Superclass::BinaryTreeType;
+  using typename Superclass::MeasurementVectorType;
+  using typename Superclass::IndexArrayType;
+  using typename Superclass::DistanceArrayType;
+
+  /** The flat kd-tree. */
+  typedef FlatKDTree<ListSampleType> FlatKDTreeType;
+
+  /** Set the binary tree, which should be a FlatKDTree. */
+  void
+  SetBinaryTree(BinaryTreeType * tree) override;
+
+  /** Set and get the error bound eps. */
+  itkSetClampMacro(ErrorBound, double, 0.0, 1e14);
+  itkGetConstMacro(ErrorBound, double);
+
+  /** Search the nearest neighbours of a query point qp. */
+  void
+  Search(const MeasurementVectorType & qp, IndexArrayType & ind, DistanceArrayType & dists) override;
+
+  /** Search the nearest neighbours of a query point qp, storing their indices and squared
+   * distances in ind and dists, which should both have room for k elements. Thread-safe.
+   */
+  void
+  SearchKNearestNeighbors(const double * qp, int * ind, double * dists) const
+  {
+    this->m_BinaryTreeAsFlatKDTreeType->Search(qp, this->m_KNearestNeighbors, this->m_ErrorBound, ind, dists);
+  }
+
+protected:
+  FlatKDTreeSearch();
+  ~FlatKDTreeSearch() override = default;
+
+  /** Member variables. */
+  double                           m_ErrorBound;
+  typename FlatKDTreeType::Pointer m_BinaryTreeAsFlatKDTreeType;
+
+private:
+  FlatKDTreeSearch(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkFlatKDTreeSearch.hxx"
+#endif
+
+#endif // end #ifndef itkFlatKDTreeSearch_h
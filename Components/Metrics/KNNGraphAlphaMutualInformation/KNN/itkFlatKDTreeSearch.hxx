@@ -0,0 +1,102 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkFlatKDTreeSearch_hxx
+#define itkFlatKDTreeSearch_hxx
+
+#include "itkFlatKDTreeSearch.h"
+
+namespace itk
+{
+
+/**
+ * ************************ Constructor *************************
+ */
+
+template <class TListSample>
+FlatKDTreeSearch<TListSample>::FlatKDTreeSearch()
+{
+  this->m_ErrorBound = 0.0;
+  this->m_BinaryTreeAsFlatKDTreeType = nullptr;
+} // end Constructor
+
+
+/**
+ * ************************ SetBinaryTree *************************
+ */
+
+template <class TListSample>
+void
+FlatKDTreeSearch<TListSample>::SetBinaryTree(BinaryTreeType * tree)
+{
+  this->Superclass::SetBinaryTree(tree);
+  if (tree)
+  {
+    FlatKDTreeType * testPtr = dynamic_cast<FlatKDTreeType *>(tree);
+    if (testPtr)
+    {
+      if (testPtr != this->m_BinaryTreeAsFlatKDTreeType)
+      {
+        this->m_BinaryTreeAsFlatKDTreeType = testPtr;
+        this->Modified();
+      }
+    }
+    else
+    {
+      itkExceptionMacro(<< "ERROR: The tree is not of type FlatKDTree.");
+    }
+  }
+  else
+  {
+    if (this->m_BinaryTreeAsFlatKDTreeType.IsNotNull())
+    {
+      this->m_BinaryTreeAsFlatKDTreeType = nullptr;
+      this->Modified();
+    }
+  }
+
+} // end SetBinaryTree
+
+
+/**
+ * ************************ Search *************************
+ */
+
+template <class TListSample>
+void
+FlatKDTreeSearch<TListSample>::Search(const MeasurementVectorType & qp,
+                                      IndexArrayType &              ind,
+                                      DistanceArrayType &           dists)
+{
+  /** Copy the query point, which is not necessarily contiguous. */
+  const unsigned int  dim = this->m_DataDimension;
+  std::vector<double> queryPoint(dim);
+  for (unsigned int i = 0; i < dim; ++i)
+  {
+    queryPoint[i] = qp[i];
+  }
+
+  ind.SetSize(this->m_KNearestNeighbors);
+  dists.SetSize(this->m_KNearestNeighbors);
+  this->SearchKNearestNeighbors(queryPoint.data(), ind.data_block(), dists.data_block());
+
+} // end Search
+
+
+} // end namespace itk
+
+#endif // end #ifndef itkFlatKDTreeSearch_hxx
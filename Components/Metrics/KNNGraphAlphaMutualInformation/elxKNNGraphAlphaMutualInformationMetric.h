@@ -37,7 +37,9 @@ namespace elastix
  *    Choose a value between 0.0 and 1.0. The default is 0.5.
  * \parameter TreeType: The type of the kNN binary tree. \n
  *    <tt>(TreeType "BDTree" "BruteForceTree")</tt> \n
- *    Choose one of { KDTree, BDTree, BruteForceTree }. \n
+ *    Choose one of { KDTree, BDTree, BruteForceTree, FlatKDTree }. \n
+ *    The FlatKDTree is built and searched multi-threaded, and only supports the
+ *    BucketSize, the Standard TreeSearchType and the ErrorBound. \n
  *    The default is "KDTree" for all resolutions.
  * \parameter BucketSize: The maximum number of samples in one bucket. \n
  *    This parameter influences the calculation time only, and is not appropiate for the BruteForceTree. \n
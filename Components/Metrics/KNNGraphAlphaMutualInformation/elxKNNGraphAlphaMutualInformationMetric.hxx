@@ -91,6 +91,11 @@ KNNGraphAlphaMutualInformationMetric<TElastix>::BeforeEachResolution(void)
   {
     silentShrink = true;
   }
+  else if (treeType == "FlatKDTree")
+  {
+    silentSplit = true;
+    silentShrink = true;
+  }
   else if (treeType == "BruteForceTree")
   {
     silentBS = true;
@@ -162,6 +167,10 @@ KNNGraphAlphaMutualInformationMetric<TElastix>::BeforeEachResolution(void)
   {
     this->SetANNBruteForceTree();
   }
+  else if (treeType == "FlatKDTree")
+  {
+    this->SetFlatKDTree(bucketSize);
+  }
   else
   {
     itkExceptionMacro(<< "ERROR: there is no tree type \"" << treeType << "\" implemented.");
@@ -195,8 +204,17 @@ KNNGraphAlphaMutualInformationMetric<TElastix>::BeforeEachResolution(void)
   this->m_Configuration->ReadParameter(squaredSearchRadius, "SquaredSearchRadius", 0, silentSR);
   this->m_Configuration->ReadParameter(squaredSearchRadius, "SquaredSearchRadius", level, true);
 
-  /** Set the tree searcher. */
-  if (treeSearchType == "Standard")
+  /** Set the tree searcher. The flat kd tree has its own (standard) searcher. */
+  if (treeType == "FlatKDTree")
+  {
+    if (treeSearchType != "Standard")
+    {
+      itkExceptionMacro(<< "ERROR: the tree searcher type \"" << treeSearchType
+                        << "\" is not implemented for the FlatKDTree. Use \"Standard\".");
+    }
+    this->SetFlatKDTreeSearch(kNearestNeighbours, errorBound);
+  }
+  else if (treeSearchType == "Standard")
   {
     this->SetANNStandardTreeSearch(kNearestNeighbours, errorBound);
   }
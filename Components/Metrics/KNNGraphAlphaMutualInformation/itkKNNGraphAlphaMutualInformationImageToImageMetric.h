@@ -31,11 +31,13 @@
 #include "itkANNkDTree.h"
 #include "itkANNbdTree.h"
 #include "itkANNBruteForceTree.h"
+#include "itkFlatKDTree.h"
 
 /** Supported tree searchers. */
 #include "itkANNStandardTreeSearch.h"
 #include "itkANNFixedRadiusTreeSearch.h"
 #include "itkANNPriorityTreeSearch.h"
+#include "itkFlatKDTreeSearch.h"
 
 /** Include for the spatial derivatives. */
 #include "itkArray2D.h"
@@ -153,6 +155,7 @@ public:
   typedef ANNkDTree<ListSampleType>           ANNkDTreeType;
   typedef ANNbdTree<ListSampleType>           ANNbdTreeType;
   typedef ANNBruteForceTree<ListSampleType>   ANNBruteForceTreeType;
+  typedef FlatKDTree<ListSampleType>          FlatKDTreeType;
 
   /** Typedefs for tree searchers. */
   typedef BinaryTreeSearchBase<ListSampleType>      BinaryKNNTreeSearchType;
@@ -160,6 +163,7 @@ public:
   typedef ANNStandardTreeSearch<ListSampleType>     ANNStandardTreeSearchType;
   typedef ANNFixedRadiusTreeSearch<ListSampleType>  ANNFixedRadiusTreeSearchType;
   typedef ANNPriorityTreeSearch<ListSampleType>     ANNPriorityTreeSearchType;
+  typedef FlatKDTreeSearch<ListSampleType>          FlatKDTreeSearchType;
 
   typedef typename BinaryKNNTreeSearchType::IndexArrayType    IndexArrayType;
   typedef typename BinaryKNNTreeSearchType::DistanceArrayType DistanceArrayType;
@@ -169,7 +173,7 @@ public:
 
   /**
    * *** Set trees: ***
-   * Currently kd, bd, and brute force trees are supported.
+   * Currently kd, bd, brute force, and flat kd trees are supported.
    */
 
   /** Set ANNkDTree. */
@@ -201,9 +205,15 @@ public:
   void
   SetANNBruteForceTree(void);
 
+  /** Set FlatKDTree. Contrary to the ANN trees, this tree is built and searched
+   * multi-threaded. It should be combined with the FlatKDTreeSearch.
+   */
+  void
+  SetFlatKDTree(unsigned int bucketSize);
+
   /**
    * *** Set tree searchers: ***
-   * Currently standard, fixed radius, and priority tree searchers are supported.
+   * Currently standard, fixed radius, priority, and flat kd tree searchers are supported.
    */
 
   /** Set ANNStandardTreeSearch. */
@@ -218,6 +228,10 @@ public:
   void
   SetANNPriorityTreeSearch(unsigned int kNearestNeighbors, double errorBound);
 
+  /** Set FlatKDTreeSearch. */
+  void
+  SetFlatKDTreeSearch(unsigned int kNearestNeighbors, double errorBound);
+
   /**
    * *** Standard metric stuff: ***
    */
@@ -291,6 +305,10 @@ private:
   typedef Array2D<double>                         SpatialDerivativeType;
   typedef std::vector<SpatialDerivativeType>      SpatialDerivativeContainerType;
 
+  /** Typedef's for the k nearest neighbours of all samples, stored sample after sample. */
+  typedef std::vector<int>    NeighborIndicesContainerType;
+  typedef std::vector<double> NeighborDistancesContainerType;
+
   /** This function takes the fixed image samples from the ImageSampler
    * and puts them in the listSampleFixed, together with the fixed feature
    * image samples. Also the corresponding moving image values and moving
@@ -311,6 +329,18 @@ private:
                                                    TransformJacobianIndicesContainerType & jacobiansIndices,
                                                    SpatialDerivativeContainerType &        spatialDerivatives) const;
 
+  /** This function generates the tree of a list sample, connects it to the
+   * searcher, and searches the k nearest neighbours of all samples. Their
+   * indices and squared distances are stored, k per sample. This is done
+   * multi-threaded for the flat kd tree, and single-threaded otherwise.
+   */
+  void
+  GenerateTreeAndSearchNearestNeighbors(BinaryKNNTreeType *              tree,
+                                        BinaryKNNTreeSearchType *        searcher,
+                                        const ListSamplePointer &        listSample,
+                                        NeighborIndicesContainerType &   indices,
+                                        NeighborDistancesContainerType & distances) const;
+
   /** This function calculates the spatial derivative of the
    * featureNr feature image at the point mappedPoint.
    * \todo move this to base class.
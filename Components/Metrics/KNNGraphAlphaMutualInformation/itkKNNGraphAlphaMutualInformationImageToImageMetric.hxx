@@ -20,6 +20,8 @@
 
 #include "itkKNNGraphAlphaMutualInformationImageToImageMetric.h"
 
+#include <algorithm> // For copy_n.
+
 namespace itk
 {
 
@@ -161,6 +163,29 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Set
 } // end SetANNBruteForceTree()
 
 
+/**
+ * ************************ SetFlatKDTree *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::SetFlatKDTree(unsigned int bucketSize)
+{
+  auto tmpPtrF = FlatKDTreeType::New();
+  auto tmpPtrM = FlatKDTreeType::New();
+  auto tmpPtrJ = FlatKDTreeType::New();
+
+  tmpPtrF->SetBucketSize(bucketSize);
+  tmpPtrM->SetBucketSize(bucketSize);
+  tmpPtrJ->SetBucketSize(bucketSize);
+
+  this->m_BinaryKNNTreeFixed = tmpPtrF;
+  this->m_BinaryKNNTreeMoving = tmpPtrM;
+  this->m_BinaryKNNTreeJoint = tmpPtrJ;
+
+} // end SetFlatKDTree()
+
+
 /**
  * ************************ SetANNStandardTreeSearch *************************
  */
@@ -253,6 +278,35 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Set
 } // end SetANNPriorityTreeSearch()
 
 
+/**
+ * ************************ SetFlatKDTreeSearch *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::SetFlatKDTreeSearch(
+  unsigned int kNearestNeighbors,
+  double       errorBound)
+{
+  auto tmpPtrF = FlatKDTreeSearchType::New();
+  auto tmpPtrM = FlatKDTreeSearchType::New();
+  auto tmpPtrJ = FlatKDTreeSearchType::New();
+
+  tmpPtrF->SetKNearestNeighbors(kNearestNeighbors);
+  tmpPtrM->SetKNearestNeighbors(kNearestNeighbors);
+  tmpPtrJ->SetKNearestNeighbors(kNearestNeighbors);
+
+  tmpPtrF->SetErrorBound(errorBound);
+  tmpPtrM->SetErrorBound(errorBound);
+  tmpPtrJ->SetErrorBound(errorBound);
+
+  this->m_BinaryKNNTreeSearcherFixed = tmpPtrF;
+  this->m_BinaryKNNTreeSearcherMoving = tmpPtrM;
+  this->m_BinaryKNNTreeSearcherJoint = tmpPtrJ;
+
+} // end SetFlatKDTreeSearch()
+
+
 /**
  * ********************* Initialize *****************************
  */
@@ -322,31 +376,38 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
   /**
    * *************** Generate the three trees ******************
    *
-   * and connect them to the searchers.
+   * and search the k nearest neighbours of all samples.
    */
 
-  /** Generate the tree for the fixed image samples. */
-  this->m_BinaryKNNTreeFixed->SetSample(listSampleFixed);
-  this->m_BinaryKNNTreeFixed->GenerateTree();
-
-  /** Generate the tree for the moving image samples. */
-  this->m_BinaryKNNTreeMoving->SetSample(listSampleMoving);
-  this->m_BinaryKNNTreeMoving->GenerateTree();
-
-  /** Generate the tree for the joint image samples. */
-  this->m_BinaryKNNTreeJoint->SetSample(listSampleJoint);
-  this->m_BinaryKNNTreeJoint->GenerateTree();
-
-  /** Initialize tree searchers. */
-  this->m_BinaryKNNTreeSearcherFixed->SetBinaryTree(this->m_BinaryKNNTreeFixed);
-  this->m_BinaryKNNTreeSearcherMoving->SetBinaryTree(this->m_BinaryKNNTreeMoving);
-  this->m_BinaryKNNTreeSearcherJoint->SetBinaryTree(this->m_BinaryKNNTreeJoint);
+  NeighborIndicesContainerType   neighborIndices_F, neighborIndices_M, neighborIndices_J;
+  NeighborDistancesContainerType neighborDistances_F, neighborDistances_M, neighborDistances_J;
+
+  /** For the fixed image samples. */
+  this->GenerateTreeAndSearchNearestNeighbors(this->m_BinaryKNNTreeFixed,
+                                              this->m_BinaryKNNTreeSearcherFixed,
+                                              listSampleFixed,
+                                              neighborIndices_F,
+                                              neighborDistances_F);
+
+  /** For the moving image samples. */
+  this->GenerateTreeAndSearchNearestNeighbors(this->m_BinaryKNNTreeMoving,
+                                              this->m_BinaryKNNTreeSearcherMoving,
+                                              listSampleMoving,
+                                              neighborIndices_M,
+                                              neighborDistances_M);
+
+  /** For the joint image samples. */
+  this->GenerateTreeAndSearchNearestNeighbors(this->m_BinaryKNNTreeJoint,
+                                              this->m_BinaryKNNTreeSearcherJoint,
+                                              listSampleJoint,
+                                              neighborIndices_J,
+                                              neighborDistances_J);
 
   /**
    * *************** Estimate the \alpha MI ******************
    *
-   * This is done by searching for the nearest neighbours of each point
-   * and calculating the distances.
+   * This is done by using the nearest neighbours of each point
+   * and the distances to them.
    *
    * The estimate for the alpha - mutual information is given by:
    *
@@ -377,9 +438,6 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
 
   /** Temporary variables. */
   typedef typename NumericTraits<MeasureType>::AccumulateType AccumulateType;
-  MeasurementVectorType                                       z_F, z_M, z_J;
-  IndexArrayType                                              indices_F, indices_M, indices_J;
-  DistanceArrayType                                           distances_F, distances_M, distances_J;
 
   MeasureType    H, G;
   AccumulateType sumG = NumericTraits<AccumulateType>::Zero;
@@ -396,15 +454,10 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
   /** Loop over all query points, i.e. all samples. */
   for (unsigned long i = 0; i < this->m_NumberOfPixelsCounted; ++i)
   {
-    /** Get the i-th query point. */
-    listSampleFixed->GetMeasurementVector(i, z_F);
-    listSampleMoving->GetMeasurementVector(i, z_M);
-    listSampleJoint->GetMeasurementVector(i, z_J);
-
-    /** Search for the K nearest neighbours of the current query point. */
-    this->m_BinaryKNNTreeSearcherFixed->Search(z_F, indices_F, distances_F);
-    this->m_BinaryKNNTreeSearcherMoving->Search(z_M, indices_M, distances_M);
-    this->m_BinaryKNNTreeSearcherJoint->Search(z_J, indices_J, distances_J);
+    /** Get the distances to the K nearest neighbours of the current query point. */
+    const double * distances_F = neighborDistances_F.data() + i * k;
+    const double * distances_M = neighborDistances_M.data() + i * k;
+    const double * distances_J = neighborDistances_J.data() + i * k;
 
     /** Add the distances between the points to get the total graph length.
      * The outcommented implementation calculates: sum J/sqrt(F*M)
@@ -546,31 +599,38 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
   /**
    * *************** Generate the three trees ******************
    *
-   * and connect them to the searchers.
+   * and search the k nearest neighbours of all samples.
    */
 
-  /** Generate the tree for the fixed image samples. */
-  this->m_BinaryKNNTreeFixed->SetSample(listSampleFixed);
-  this->m_BinaryKNNTreeFixed->GenerateTree();
-
-  /** Generate the tree for the moving image samples. */
-  this->m_BinaryKNNTreeMoving->SetSample(listSampleMoving);
-  this->m_BinaryKNNTreeMoving->GenerateTree();
-
-  /** Generate the tree for the joint image samples. */
-  this->m_BinaryKNNTreeJoint->SetSample(listSampleJoint);
-  this->m_BinaryKNNTreeJoint->GenerateTree();
-
-  /** Initialize tree searchers. */
-  this->m_BinaryKNNTreeSearcherFixed->SetBinaryTree(this->m_BinaryKNNTreeFixed);
-  this->m_BinaryKNNTreeSearcherMoving->SetBinaryTree(this->m_BinaryKNNTreeMoving);
-  this->m_BinaryKNNTreeSearcherJoint->SetBinaryTree(this->m_BinaryKNNTreeJoint);
+  NeighborIndicesContainerType   neighborIndices_F, neighborIndices_M, neighborIndices_J;
+  NeighborDistancesContainerType neighborDistances_F, neighborDistances_M, neighborDistances_J;
+
+  /** For the fixed image samples. */
+  this->GenerateTreeAndSearchNearestNeighbors(this->m_BinaryKNNTreeFixed,
+                                              this->m_BinaryKNNTreeSearcherFixed,
+                                              listSampleFixed,
+                                              neighborIndices_F,
+                                              neighborDistances_F);
+
+  /** For the moving image samples. */
+  this->GenerateTreeAndSearchNearestNeighbors(this->m_BinaryKNNTreeMoving,
+                                              this->m_BinaryKNNTreeSearcherMoving,
+                                              listSampleMoving,
+                                              neighborIndices_M,
+                                              neighborDistances_M);
+
+  /** For the joint image samples. */
+  this->GenerateTreeAndSearchNearestNeighbors(this->m_BinaryKNNTreeJoint,
+                                              this->m_BinaryKNNTreeSearcherJoint,
+                                              listSampleJoint,
+                                              neighborIndices_J,
+                                              neighborDistances_J);
 
   /**
    * *************** Estimate the \alpha MI and its derivatives ******************
    *
-   * This is done by searching for the nearest neighbours of each point
-   * and calculating the distances.
+   * This is done by using the nearest neighbours of each point
+   * and the distances to them.
    *
    * The estimate for the alpha - mutual information is given by:
    *
@@ -601,9 +661,7 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
 
   /** Temporary variables. */
   typedef typename NumericTraits<MeasureType>::AccumulateType AccumulateType;
-  MeasurementVectorType                                       z_F, z_M, z_J, z_M_ip, z_J_ip, diff_M, diff_J;
-  IndexArrayType                                              indices_F, indices_M, indices_J;
-  DistanceArrayType                                           distances_F, distances_M, distances_J;
+  MeasurementVectorType                                       z_M, z_M_ip, z_J_ip, diff_M, diff_J;
   MeasureType                                                 distance_F, distance_M, distance_J;
 
   MeasureType    H, G, Gpow;
@@ -627,14 +685,14 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
   for (unsigned long i = 0; i < this->m_NumberOfPixelsCounted; ++i)
   {
     /** Get the i-th query point. */
-    listSampleFixed->GetMeasurementVector(i, z_F);
     listSampleMoving->GetMeasurementVector(i, z_M);
-    listSampleJoint->GetMeasurementVector(i, z_J);
 
-    /** Search for the k nearest neighbours of the current query point. */
-    this->m_BinaryKNNTreeSearcherFixed->Search(z_F, indices_F, distances_F);
-    this->m_BinaryKNNTreeSearcherMoving->Search(z_M, indices_M, distances_M);
-    this->m_BinaryKNNTreeSearcherJoint->Search(z_J, indices_J, distances_J);
+    /** Get the k nearest neighbours of the current query point. */
+    const int *    indices_M = neighborIndices_M.data() + i * k;
+    const int *    indices_J = neighborIndices_J.data() + i * k;
+    const double * distances_F = neighborDistances_F.data() + i * k;
+    const double * distances_M = neighborDistances_M.data() + i * k;
+    const double * distances_J = neighborDistances_J.data() + i * k;
 
     /** Variables to compute the measure and its derivative. */
     AccumulateType Gamma_F = NumericTraits<AccumulateType>::Zero;
@@ -894,6 +952,66 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::
 } // end ComputeListSampleValuesAndDerivativePlusJacobian()
 
 
+/**
+ * ************************ GenerateTreeAndSearchNearestNeighbors *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::GenerateTreeAndSearchNearestNeighbors(
+  BinaryKNNTreeType *              tree,
+  BinaryKNNTreeSearchType *        searcher,
+  const ListSamplePointer &        listSample,
+  NeighborIndicesContainerType &   indices,
+  NeighborDistancesContainerType & distances) const
+{
+  /** A flat kd tree is built by the threader of this metric, when it is multi-threaded. */
+  auto * const flatKDTree = dynamic_cast<FlatKDTreeType *>(tree);
+  if (flatKDTree)
+  {
+    flatKDTree->SetThreader(this->m_UseMultiThread ? this->m_Threader.GetPointer() : nullptr);
+  }
+
+  /** Generate the tree and connect it to the searcher. */
+  tree->SetSample(listSample);
+  tree->GenerateTree();
+  searcher->SetBinaryTree(tree);
+
+  const unsigned long numberOfSamples = this->m_NumberOfPixelsCounted;
+  const unsigned int  k = searcher->GetKNearestNeighbors();
+  indices.resize(numberOfSamples * k);
+  distances.resize(numberOfSamples * k);
+
+  /** The flat kd tree searcher is thread-safe, so that all samples can be searched in parallel. */
+  const auto * const flatKDTreeSearcher = dynamic_cast<const FlatKDTreeSearchType *>(searcher);
+  if (flatKDTreeSearcher && this->m_UseMultiThread)
+  {
+    const auto * const data = listSample->GetInternalContainer();
+    this->m_Threader->ParallelizeArray(
+      0,
+      numberOfSamples,
+      [flatKDTreeSearcher, data, k, &indices, &distances](const SizeValueType i) {
+        flatKDTreeSearcher->SearchKNearestNeighbors(data[i], indices.data() + i * k, distances.data() + i * k);
+      },
+      nullptr);
+    return;
+  }
+
+  /** Otherwise, search the samples one by one. */
+  MeasurementVectorType z;
+  IndexArrayType        sampleIndices;
+  DistanceArrayType     sampleDistances;
+  for (unsigned long i = 0; i < numberOfSamples; ++i)
+  {
+    listSample->GetMeasurementVector(i, z);
+    searcher->Search(z, sampleIndices, sampleDistances);
+    std::copy_n(sampleIndices.data_block(), k, indices.begin() + i * k);
+    std::copy_n(sampleDistances.data_block(), k, distances.begin() + i * k);
+  }
+
+} // end GenerateTreeAndSearchNearestNeighbors()
+
+
 /**
  * ************************ EvaluateMovingFeatureImageDerivatives *************************
  */
@@ -26,6 +26,8 @@
 #include "itkVectorContainer.h"
 #include "vnl_adjugate_fixed.h"
 
+#include <vector>
+
 namespace itk
 {
 
@@ -38,6 +40,12 @@ namespace itk
  * M.A. Viergever and J.P.W. Pluim "Registration of structurally dissimilar \n
  * images in MRI-based brachytherapy ", Phys. Med. Biol. 59 (2014) 4033-4045.\n
  * http://stacks.iop.org/0031-9155/59/4033
+ *
+ * The faces of the meshes are copied into compact arrays by Initialize(). When multi-threading is used,
+ * the points are transformed in parallel, the volumes of the faces are computed in parallel, and the
+ * derivatives with respect to the points are gathered from their faces in parallel, before being
+ * multiplied by the Jacobians of the transform.
+ *
  * \ingroup RegistrationMetrics
  */
 template <class TFixedPointSet, class TMovingPointSet>
@@ -168,6 +176,24 @@ protected:
   mutable MappedMeshContainerPointer     m_MappedMeshContainer;
 
 private:
+  /** A compact (structure-of-arrays) representation of the faces of a mesh. The point identifiers of
+   * the faces are stored contiguously, and the corners (face * dimension + corner) of the faces that
+   * each point belongs to are stored in compressed row format, so that the derivatives with respect to
+   * the points can be gathered from their faces without any write conflicts.
+   */
+  struct MeshFacesType
+  {
+    std::vector<FixedMeshPointIdentifier> FacePointIds;
+    std::vector<SizeValueType>            PointCornerOffsets;
+    std::vector<SizeValueType>            PointCorners;
+  };
+
+  /** Builds the compact representation of the faces of a mesh. */
+  void
+  BuildMeshFaces(const FixedMeshType & fixedMesh, MeshFacesType & meshFaces) const;
+
+  std::vector<MeshFacesType> m_MeshFaces;
+
   void
   SubVector(const VectorType & fullVector, SubVectorType & subVector, const unsigned int leaveOutIndex) const;
 
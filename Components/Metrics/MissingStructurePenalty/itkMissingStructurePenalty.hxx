@@ -58,6 +58,7 @@ MissingVolumeMeshPenalty<TFixedPointSet, TMovingPointSet>::Initialize(void)
 
   const FixedMeshContainerElementIdentifier numberOfMeshes = this->m_FixedMeshContainer->Size();
   this->m_MappedMeshContainer->Reserve(numberOfMeshes);
+  this->m_MeshFaces.resize(numberOfMeshes);
 
   for (FixedMeshContainerElementIdentifier meshId = 0; meshId < numberOfMeshes; ++meshId)
   {
@@ -80,7 +81,16 @@ MissingVolumeMeshPenalty<TFixedPointSet, TMovingPointSet>::Initialize(void)
     mappedMesh->SetCellData(nullptr);
 
     this->m_MappedMeshContainer->SetElement(meshId, mappedMesh);
+
+    this->BuildMeshFaces(*fixedMesh, this->m_MeshFaces[meshId]);
   }
+
+  /** Initialize some multi-threading related parameters. */
+  if (this->m_UseMultiThread)
+  {
+    this->InitializeThreadingParameters();
+  }
+
 } // end Initialize()
 
 
@@ -164,14 +174,12 @@ MissingVolumeMeshPenalty<TFixedPointSet, TMovingPointSet>::GetValueAndDerivative
   derivative = DerivativeType(this->GetNumberOfParameters());
   derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
 
-  NonZeroJacobianIndicesType nzji(this->m_Transform->GetNumberOfNonZeroJacobianIndices());
-  TransformJacobianType      jacobian;
+  const bool         useMultiThread = this->UsesPerThreadVariables();
+  const unsigned int dimension = FixedPointSetDimension;
+  const MeasureType  eps = 0.00001;
 
   const FixedMeshContainerElementIdentifier numberOfMeshes = this->m_FixedMeshContainer->Size();
 
-  typename MeshPointsContainerType::Pointer pointCentroids = FixedMeshType::PointsContainer::New();
-  pointCentroids->resize(numberOfMeshes);
-
   for (FixedMeshContainerElementIdentifier meshId = 0; meshId < numberOfMeshes;
        ++meshId) // loop over all meshes in container
   {
@@ -182,145 +190,255 @@ MissingVolumeMeshPenalty<TFixedPointSet, TMovingPointSet>::GetValueAndDerivative
     const FixedMeshPointer           mappedMesh = this->m_MappedMeshContainer->ElementAt(meshId);
     const MeshPointsContainerPointer mappedPoints = mappedMesh->GetPoints();
 
-    typename FixedMeshType::PointType &              pointCentroid = pointCentroids->ElementAt(meshId);
-    typedef typename FixedMeshType::PointsContainer  FixedMeshPointsContainerType;
-    typename FixedMeshType::PointsContainer::Pointer derivPoints = FixedMeshPointsContainerType::New();
+    const MeshFacesType & meshFaces = this->m_MeshFaces[meshId];
+    const SizeValueType   numberOfFaces = meshFaces.FacePointIds.size() / dimension;
 
-    derivPoints->resize(numberOfPoints);
+    /** The signs of the volumes of the faces, of this evaluation. */
+    std::vector<signed char> faceSigns(numberOfFaces);
 
-    MeshPointsContainerConstIteratorType fixedPointIt = fixedPoints->Begin();
-    MeshPointsContainerIteratorType      mappedPointIt = mappedPoints->Begin();
-    MeshPointsContainerConstIteratorType fixedPointEnd = fixedPoints->End();
+    /** Transform all points. */
+    this->ParallelizeOverRanges(
+      numberOfPoints,
+      [this, &fixedPoints, &mappedPoints](const SizeValueType begin, const SizeValueType end, ThreadIdType) {
+        for (SizeValueType pointIndex = begin; pointIndex < end; ++pointIndex)
+        {
+          mappedPoints->ElementAt(pointIndex) = this->m_Transform->TransformPoint(fixedPoints->ElementAt(pointIndex));
+        }
+      });
 
-    for (; fixedPointIt != fixedPointEnd; ++fixedPointIt, ++mappedPointIt)
+    MeshPointType pointCentroid;
+    pointCentroid.Fill(0.0);
+    for (unsigned int pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex)
     {
-      const OutputPointType mappedPoint = this->m_Transform->TransformPoint(fixedPointIt->Value());
-      mappedPointIt.Value() = mappedPoint;
-      pointCentroid.GetVnlVector() += mappedPoint.GetVnlVector();
+      for (unsigned int d = 0; d < dimension; ++d)
+      {
+        pointCentroid[d] += mappedPoints->ElementAt(pointIndex)[d];
+      }
+    }
+    for (unsigned int d = 0; d < dimension; ++d)
+    {
+      pointCentroid[d] /= numberOfPoints;
     }
-    pointCentroid.GetVnlVector() /= numberOfPoints;
 
-    typename FixedMeshType::CellsContainerConstIterator cellBegin = fixedMesh->GetCells()->Begin();
-    typename FixedMeshType::CellsContainerConstIterator cellEnd = fixedMesh->GetCells()->End();
+    /** Compute the (pseudo) volumes of the faces, and store the signs of the faces that contribute to the
+     * derivative. Each work unit sums the absolute volumes of a range of faces.
+     */
+    this->ParallelizeOverRanges(
+      numberOfFaces,
+      [this, &meshFaces, &faceSigns, &mappedPoints, &pointCentroid, &value, useMultiThread, dimension, eps](
+        const SizeValueType begin, const SizeValueType end, const ThreadIdType threadId) {
+        MeasureType sumAbsVolume = 0.0;
 
-    typename CellInterfaceType::PointIdIterator beginpointer;
-    float                                       sumSignedVolume = 0.0;
-    float                                       sumAbsVolume = 0.0;
+        for (SizeValueType face = begin; face < end; ++face)
+        {
+          const FixedMeshPointIdentifier * pointIds = meshFaces.FacePointIds.data() + face * dimension;
+          MeasureType                      signedVolume = 0.0;
 
-    const float eps = 0.00001;
+          switch (dimension)
+          {
+            case 2:
+            {
+              const VectorType p1 = mappedPoints->ElementAt(pointIds[0]) - pointCentroid;
+              const VectorType p2 = mappedPoints->ElementAt(pointIds[1]) - pointCentroid;
+              signedVolume = vnl_determinant(p1.GetDataPointer(), p2.GetDataPointer());
+            }
+            break;
+            case 3:
+            {
+              const VectorType p1 = mappedPoints->ElementAt(pointIds[0]) - pointCentroid;
+              const VectorType p2 = mappedPoints->ElementAt(pointIds[1]) - pointCentroid;
+              const VectorType p3 = mappedPoints->ElementAt(pointIds[2]) - pointCentroid;
+              signedVolume = vnl_determinant(p1.GetDataPointer(), p2.GetDataPointer(), p3.GetDataPointer());
+            }
+            break;
+            case 4:
+            {
+              const VectorConstPointer p1 = mappedPoints->ElementAt(pointIds[0]).GetDataPointer();
+              const VectorConstPointer p2 = mappedPoints->ElementAt(pointIds[1]).GetDataPointer();
+              const VectorConstPointer p3 = mappedPoints->ElementAt(pointIds[2]).GetDataPointer();
+              const VectorConstPointer p4 = mappedPoints->ElementAt(pointIds[3]).GetDataPointer();
+              signedVolume = vnl_determinant(p1, p2, p3, p4);
+            }
+            break;
+            default:
+              break;
+          }
 
-    for (; cellBegin != cellEnd; ++cellBegin)
-    {
-      beginpointer = cellBegin->Value()->PointIdsBegin();
-      float signedVolume; // = vnl_determinant(fullMatrix.GetVnlMatrix());
+          /** Only the faces of 2D and 3D meshes contribute to the derivative. */
+          const int sign = (dimension <= 3) ? ((signedVolume > eps) - (signedVolume < -eps)) : 0;
+          faceSigns[face] = static_cast<signed char>(sign);
+          sumAbsVolume += std::abs(signedVolume);
+        }
 
-      // const VectorType::const_pointer p1,p2,p3,p4;
-      switch (static_cast<unsigned int>(FixedPointSetDimension))
-      {
-        case 2:
+        if (useMultiThread)
+        {
+          this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value += sumAbsVolume;
+        }
+        else
+        {
+          value += sumAbsVolume;
+        }
+      });
+
+    /** Gather the derivative with respect to each point from its faces, and multiply it by the Jacobian.
+     * Each work unit adds the contributions of a range of points to its own derivative.
+     */
+    this->ParallelizeOverRanges(
+      numberOfPoints,
+      [this,
+       &meshFaces,
+       &faceSigns,
+       &fixedPoints,
+       &mappedPoints,
+       &pointCentroid,
+       &derivative,
+       useMultiThread,
+       dimension](const SizeValueType begin, const SizeValueType end, const ThreadIdType threadId) {
+        DerivativeType & threadDerivative =
+          useMultiThread ? this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Derivative : derivative;
+
+        NonZeroJacobianIndicesType nzji(this->m_Transform->GetNumberOfNonZeroJacobianIndices());
+        TransformJacobianType      jacobian;
+
+        for (SizeValueType pointIndex = begin; pointIndex < end; ++pointIndex)
         {
-          const FixedMeshPointIdentifier p1Id = *beginpointer;
-          ++beginpointer;
-          const VectorType               p1 = mappedPoints->GetElement(p1Id) - pointCentroid;
-          const FixedMeshPointIdentifier p2Id = *beginpointer;
-          ++beginpointer;
-          const VectorType p2 = mappedPoints->GetElement(p2Id) - pointCentroid;
+          VectorType derivPoint;
+          derivPoint.Fill(0.0);
+          bool hasDerivative = false;
 
-          signedVolume = vnl_determinant(p1.GetDataPointer(), p2.GetDataPointer());
+          const SizeValueType cornerEnd = meshFaces.PointCornerOffsets[pointIndex + 1];
+          for (SizeValueType c = meshFaces.PointCornerOffsets[pointIndex]; c < cornerEnd; ++c)
+          {
+            const SizeValueType face = meshFaces.PointCorners[c] / dimension;
+            const unsigned int  corner = meshFaces.PointCorners[c] % dimension;
+            const int           sign = faceSigns[face];
+            if (sign == 0)
+            {
+              continue;
+            }
+            hasDerivative = true;
+
+            const FixedMeshPointIdentifier * pointIds = meshFaces.FacePointIds.data() + face * dimension;
+            switch (dimension)
+            {
+              case 2:
+              {
+                /** The derivative of det( p1, p2 ) with respect to p1 is ( p2[1], -p2[0] ),
+                 * and with respect to p2 it is ( -p1[1], p1[0] ).
+                 */
+                const VectorType q = mappedPoints->ElementAt(pointIds[1 - corner]) - pointCentroid;
+                const int        s = (corner == 0) ? sign : -sign;
+                derivPoint[0] += s * q[1];
+                derivPoint[1] -= s * q[0];
+              }
+              break;
+              case 3:
+              {
+                /** The derivative of det( p1, p2, p3 ) with respect to a corner is the cross product
+                 * of the next two corners, in cyclic order.
+                 */
+                const VectorType q1 = mappedPoints->ElementAt(pointIds[(corner + 1) % 3]) - pointCentroid;
+                const VectorType q2 = mappedPoints->ElementAt(pointIds[(corner + 2) % 3]) - pointCentroid;
+                derivPoint[0] += sign * (q1[1] * q2[2] - q1[2] * q2[1]);
+                derivPoint[1] += sign * (q1[2] * q2[0] - q1[0] * q2[2]);
+                derivPoint[2] += sign * (q1[0] * q2[1] - q1[1] * q2[0]);
+              }
+              break;
+              default:
+                break;
+            }
+          }
 
-          const int sign = (signedVolume > eps) - (signedVolume < -eps);
-          if (sign != 0)
+          if (!hasDerivative)
           {
-            derivPoints->at(p1Id)[0] += sign * p2[1];
-            derivPoints->at(p1Id)[1] -= sign * p2[0];
-            derivPoints->at(p2Id)[0] -= sign * p1[1];
-            derivPoints->at(p2Id)[1] += sign * p1[0];
+            continue;
           }
-        }
-        break;
-        case 3:
-        {
-          const FixedMeshPointIdentifier p1Id = *beginpointer;
-          ++beginpointer;
-          const VectorType               p1 = mappedPoints->GetElement(p1Id) - pointCentroid;
-          const FixedMeshPointIdentifier p2Id = *beginpointer;
-          ++beginpointer;
-          const VectorType               p2 = mappedPoints->GetElement(p2Id) - pointCentroid;
-          const FixedMeshPointIdentifier p3Id = *beginpointer;
-          ++beginpointer;
-          const VectorType p3 = mappedPoints->GetElement(p3Id) - pointCentroid;
 
-          signedVolume = vnl_determinant(p1.GetDataPointer(), p2.GetDataPointer(), p3.GetDataPointer());
+          /** Get the TransformJacobian dT/dmu. */
+          this->m_Transform->GetJacobian(fixedPoints->ElementAt(pointIndex), jacobian, nzji);
+          if (nzji.size() == this->GetNumberOfParameters())
+          {
+            /** Loop over all Jacobians. */
+            threadDerivative += derivPoint.GetVnlVector() * jacobian;
+          }
+          else
+          {
+            /** Only pick the nonzero Jacobians. */
+            for (unsigned int i = 0; i < nzji.size(); ++i)
+            {
+              const unsigned int index = nzji[i];
+              VnlVectorType      column = jacobian.get_column(i);
+              threadDerivative[index] += dot_product(derivPoint.GetVnlVector(), column);
+            }
+          }
+        } // end loop over all points
+      });
 
-          const int sign = ((signedVolume > eps) - (signedVolume < -eps));
+  } // end loop over all meshes in container
 
-          if (sign != 0)
-          {
-            derivPoints->at(p1Id)[0] += sign * (p2[1] * p3[2] - p2[2] * p3[1]);
-            derivPoints->at(p1Id)[1] += sign * (p2[2] * p3[0] - p2[0] * p3[2]);
-            derivPoints->at(p1Id)[2] += sign * (p2[0] * p3[1] - p2[1] * p3[0]);
+  if (useMultiThread)
+  {
+    this->AccumulatePerThreadVariables(value, &derivative);
+  }
 
-            derivPoints->at(p2Id)[0] += sign * (p1[2] * p3[1] - p1[1] * p3[2]);
-            derivPoints->at(p2Id)[1] += sign * (p1[0] * p3[2] - p1[2] * p3[0]);
-            derivPoints->at(p2Id)[2] += sign * (p1[1] * p3[0] - p1[0] * p3[1]);
+} // end GetValueAndDerivative()
 
-            derivPoints->at(p3Id)[0] += sign * (p1[1] * p2[2] - p1[2] * p2[1]);
-            derivPoints->at(p3Id)[1] += sign * (p1[2] * p2[0] - p1[0] * p2[2]);
-            derivPoints->at(p3Id)[2] += sign * (p1[0] * p2[1] - p1[1] * p2[0]);
-          }
-        }
 
-        break;
-        case 4:
-        {
-          const VectorConstPointer p1 = mappedPoints->GetElement(*beginpointer++).GetDataPointer();
-          const VectorConstPointer p2 = mappedPoints->GetElement(*beginpointer++).GetDataPointer();
-          const VectorConstPointer p3 = mappedPoints->GetElement(*beginpointer++).GetDataPointer();
-          const VectorConstPointer p4 = mappedPoints->GetElement(*beginpointer++).GetDataPointer();
-          signedVolume = vnl_determinant(p1, p2, p3, p4);
-        }
-        break;
-        default:
-          std::cout << "no dimensions higher than 4" << std::endl;
-      }
+/**
+ * ******************* BuildMeshFaces *******************
+ */
 
-      sumSignedVolume += signedVolume;
-      sumAbsVolume += std::abs(signedVolume);
-    }
+template <class TFixedPointSet, class TMovingPointSet>
+void
+MissingVolumeMeshPenalty<TFixedPointSet, TMovingPointSet>::BuildMeshFaces(const FixedMeshType & fixedMesh,
+                                                                          MeshFacesType &       meshFaces) const
+{
+  const unsigned int  dimension = FixedPointSetDimension;
+  const SizeValueType numberOfPoints = fixedMesh.GetNumberOfPoints();
 
-    /** Create iterators. */
-    fixedPointIt = fixedPoints->Begin();
-    unsigned int pointIndex;
-    /** Loop over points. */
-    for (pointIndex = 0; fixedPointIt != fixedPointEnd; ++fixedPointIt, ++pointIndex)
+  /** Copy the first dimension point identifiers of each cell. Cells with fewer points are not faces. */
+  meshFaces.FacePointIds.clear();
+  meshFaces.FacePointIds.reserve(fixedMesh.GetNumberOfCells() * dimension);
+
+  typename FixedMeshType::CellsContainerConstIterator cellIt = fixedMesh.GetCells()->Begin();
+  typename FixedMeshType::CellsContainerConstIterator cellEnd = fixedMesh.GetCells()->End();
+  for (; cellIt != cellEnd; ++cellIt)
+  {
+    const CellInterfaceType * cell = cellIt->Value();
+    if (cell->GetNumberOfPoints() < dimension)
     {
-      /** Get the TransformJacobian dT/dmu. */
-      this->m_Transform->GetJacobian(fixedPointIt.Value(), jacobian, nzji);
-      if (nzji.size() == this->GetNumberOfParameters())
-      {
-        /** Loop over all Jacobians. */
-        derivative += derivPoints->at(pointIndex).GetVnlVector() * jacobian; //* sumAbsVolumeEps;
-      }
-      else
+      continue;
+    }
+    typename CellInterfaceType::PointIdConstIterator pointIdIt = cell->PointIdsBegin();
+    for (unsigned int d = 0; d < dimension; ++d, ++pointIdIt)
+    {
+      if (*pointIdIt >= numberOfPoints)
       {
-        /** Only pick the nonzero Jacobians. */
-        for (unsigned int i = 0; i < nzji.size(); ++i)
-        {
-          const unsigned int index = nzji[i];
-          VnlVectorType      column = jacobian.get_column(i);
-          derivative[index] += dot_product(derivPoints->at(pointIndex).GetVnlVector(), column); // *sumAbsVolumeEps;
-        }
+        itkExceptionMacro(<< "The mesh contains a cell with point identifier " << *pointIdIt << ", while it only has "
+                          << numberOfPoints << " points");
       }
+      meshFaces.FacePointIds.push_back(*pointIdIt);
+    }
+  }
+  /** Store the corners of the faces per point, by a counting sort. */
+  meshFaces.PointCornerOffsets.assign(numberOfPoints + 1, 0);
+  for (const FixedMeshPointIdentifier pointId : meshFaces.FacePointIds)
+  {
+    ++meshFaces.PointCornerOffsets[pointId + 1];
+  }
+  for (SizeValueType pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex)
+  {
+    meshFaces.PointCornerOffsets[pointIndex + 1] += meshFaces.PointCornerOffsets[pointIndex];
+  }
 
-    } // end loop over all corresponding points
-
-    /** Check if enough samples were valid. */
-
-    /** Copy the measure to value. */
-    value += sumAbsVolume;
+  std::vector<SizeValueType> nextCorner(meshFaces.PointCornerOffsets.begin(), meshFaces.PointCornerOffsets.end() - 1);
+  meshFaces.PointCorners.resize(meshFaces.FacePointIds.size());
+  for (SizeValueType corner = 0; corner < meshFaces.FacePointIds.size(); ++corner)
+  {
+    meshFaces.PointCorners[nextCorner[meshFaces.FacePointIds[corner]]++] = corner;
+  }
 
-  } // end loop over all meshes in container
-} // end GetValueAndDerivative()
+} // end BuildMeshFaces()
 
 
 /**
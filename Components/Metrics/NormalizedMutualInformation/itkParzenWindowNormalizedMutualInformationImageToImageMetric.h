@@ -39,6 +39,11 @@ namespace itk
  * Construction of the PDFs is implemented in the superclass
  * ParzenWindowHistogramImageToImageMetric.
  *
+ * The derivative is either computed from the explicit joint histogram
+ * derivatives (UseExplicitPDFDerivatives == true), or by a second,
+ * multi-threaded loop over the samples, which avoids storing the large
+ * joint histogram derivatives (UseExplicitPDFDerivatives == false).
+ *
  * This implementation of the NormalizedMutualInformation is based on the
  * AdvancedImageToImageMetric, which means that:
  * \li It uses the ImageSampler-framework
@@ -136,7 +141,9 @@ public:
   MeasureType
   GetValue(const ParametersType & parameters) const override;
 
-  /**  Get the value and derivatives for single valued optimizers. */
+  /**  Get the value and derivatives for single valued optimizers.
+   * Calls GetValueAndAnalyticDerivativeLowMemory when UseExplicitPDFDerivatives == false.
+   */
   void
   GetValueAndDerivative(const ParametersType & parameters,
                         MeasureType &          Value,
@@ -179,6 +186,23 @@ protected:
   using typename Superclass::ParzenValueContainerType;
   using typename Superclass::KernelFunctionType;
   using typename Superclass::NonZeroJacobianIndicesType;
+  using typename Superclass::PRatioType;
+
+  /** Get the value and analytic derivative, without the explicit joint histogram derivatives.
+   * The joint histogram is computed by a first (multi-threaded) loop over the samples,
+   * and the derivative by a second one, see ComputeDerivativeLowMemory.
+   */
+  virtual void
+  GetValueAndAnalyticDerivativeLowMemory(const ParametersType & parameters,
+                                         MeasureType &          value,
+                                         DerivativeType &       derivative) const;
+
+  /** Compute m_PRatioArray for the low memory variant of the derivative:
+   * PRatio(i,k) = alpha ( NMI log(p(i,k)) - log(pf(k)) - log(pm(i)) ) / Ej.
+   * Assumes the marginal pdfs are already log'ed.
+   */
+  virtual void
+  ComputePRatioArray(const double nMI, const double jointEntropy) const;
 
   /** Replace the marginal probabilities by log(probabilities)
    * Changes the input pdf since they are not needed anymore! */
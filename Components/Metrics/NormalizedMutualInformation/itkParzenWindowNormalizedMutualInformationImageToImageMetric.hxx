@@ -22,6 +22,7 @@
 #include "itkParzenWindowNormalizedMutualInformationImageToImageMetric.h"
 
 #include "itkImageLinearConstIteratorWithIndex.h"
+#include "itkImageScanlineConstIterator.h"
 #include <vnl/vnl_math.h>
 
 namespace itk
@@ -182,6 +183,13 @@ ParzenWindowNormalizedMutualInformationImageToImageMetric<TFixedImage, TMovingIm
   derivative = DerivativeType(this->GetNumberOfParameters());
   derivative.Fill(NumericTraits<double>::ZeroValue());
 
+  /** Avoid the large joint histogram derivatives, if desired. */
+  if (!this->GetUseExplicitPDFDerivatives())
+  {
+    this->GetValueAndAnalyticDerivativeLowMemory(parameters, value, derivative);
+    return;
+  }
+
   /** Construct the JointPDF, JointPDFDerivatives, and Alpha. */
   this->ComputePDFsAndPDFDerivatives(parameters);
 
@@ -274,6 +282,96 @@ ParzenWindowNormalizedMutualInformationImageToImageMetric<TFixedImage, TMovingIm
 } // end GetValueAndDerivative
 
 
+/**
+ * ******************** GetValueAndAnalyticDerivativeLowMemory *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowNormalizedMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::
+  GetValueAndAnalyticDerivativeLowMemory(const ParametersType & parameters,
+                                         MeasureType &          value,
+                                         DerivativeType &       derivative) const
+{
+  /** Construct the JointPDF and Alpha.
+   * This function contains a loop over the samples.
+   * It executes multi-threadedly when m_UseMultiThread == true.
+   */
+  this->ComputePDFs(parameters);
+
+  /** Normalize the pdfs: p = alpha h */
+  this->NormalizeJointPDF(this->m_JointPDF, this->m_Alpha);
+
+  /** Compute the fixed and moving marginal pdf by summing over the histogram */
+  this->ComputeMarginalPDF(this->m_JointPDF, this->m_FixedImageMarginalPDF, 0);
+  this->ComputeMarginalPDF(this->m_JointPDF, this->m_MovingImageMarginalPDF, 1);
+
+  /** Replace the probabilities by log(probabilities) */
+  this->ComputeLogMarginalPDF(this->m_FixedImageMarginalPDF);
+  this->ComputeLogMarginalPDF(this->m_MovingImageMarginalPDF);
+
+  /** Compute the measure and joint entropy (which we both need to compute the derivative) */
+  MeasureType       jointEntropy = 0.0;
+  const MeasureType nMI = this->ComputeNormalizedMutualInformation(jointEntropy);
+  value = static_cast<MeasureType>(-1.0 * nMI);
+
+  /** Compute the intermediate m_PRatioArray, see GetValueAndDerivative. */
+  this->ComputePRatioArray(nMI, jointEntropy);
+
+  /* Compute the derivative.
+   * This function contains a second loop over the samples.
+   * It executes multi-threadedly when m_UseMultiThread == true.
+   */
+  this->ComputeDerivativeLowMemory(derivative);
+
+} // end GetValueAndAnalyticDerivativeLowMemory()
+
+
+/**
+ * ******************* ComputePRatioArray *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowNormalizedMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::ComputePRatioArray(
+  const double nMI,
+  const double jointEntropy) const
+{
+  /** Setup iterators. */
+  typedef ImageScanlineConstIterator<JointPDFType> JointPDFIteratorType;
+
+  JointPDFIteratorType jointPDFit(this->m_JointPDF, this->m_JointPDF->GetLargestPossibleRegion());
+
+  /** The same pRatio as in GetValueAndDerivative, now multiplied by alpha/Ej beforehand. */
+  const double alpha_Ej = this->m_Alpha / jointEntropy;
+
+  /** Loop over the joint histogram. */
+  const unsigned int numberOfFixedBins = this->m_FixedImageMarginalPDF.GetSize();
+  const unsigned int numberOfMovingBins = this->m_MovingImageMarginalPDF.GetSize();
+  for (unsigned int fixedIndex = 0; fixedIndex < numberOfFixedBins; ++fixedIndex)
+  {
+    const double logFixedImagePDFValue = this->m_FixedImageMarginalPDF[fixedIndex];
+    for (unsigned int movingIndex = 0; movingIndex < numberOfMovingBins; ++movingIndex)
+    {
+      const double logMovingImagePDFValue = this->m_MovingImageMarginalPDF[movingIndex];
+      const double jointPDFValue = jointPDFit.Value();
+
+      /** Check for non-zero bin contribution. */
+      PRatioType pRatio = NumericTraits<PRatioType>::ZeroValue();
+      if (jointPDFValue > 1e-16)
+      {
+        pRatio = static_cast<PRatioType>(
+          alpha_Ej * (nMI * std::log(jointPDFValue) - logFixedImagePDFValue - logMovingImagePDFValue));
+      }
+      this->m_PRatioArray[fixedIndex][movingIndex] = pRatio;
+      ++jointPDFit;
+    }
+    jointPDFit.NextLine();
+  }
+
+} // end ComputePRatioArray()
+
+
 } // end namespace itk
 
 #endif // end #ifndef itkParzenWindowNormalizedMutualInformationImageToImageMetric_hxx
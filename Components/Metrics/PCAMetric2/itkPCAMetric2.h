@@ -92,6 +92,12 @@ public:
   using typename Superclass::FixedImageLimiterOutputType;
   using typename Superclass::MovingImageLimiterOutputType;
   using typename Superclass::MovingImageDerivativeScalesType;
+  typedef typename DerivativeType::ValueType DerivativeValueType;
+  using typename Superclass::ThreaderType;
+  using typename Superclass::ThreadInfoType;
+
+  typedef vnl_matrix<RealType>            MatrixType;
+  typedef vnl_matrix<DerivativeValueType> DerivativeMatrixType;
 
   /** The fixed image dimension. */
   itkStaticConstMacro(FixedImageDimension, unsigned int, FixedImageType::ImageDimension);
@@ -108,6 +114,11 @@ public:
   GetDerivative(const TransformParametersType & parameters, DerivativeType & derivative) const override;
 
   /** Get value and derivatives for multiple valued optimizers. */
+  void
+  GetValueAndDerivativeSingleThreaded(const TransformParametersType & parameters,
+                                      MeasureType &                   Value,
+                                      DerivativeType &                Derivative) const;
+
   void
   GetValueAndDerivative(const TransformParametersType & parameters,
                         MeasureType &                   Value,
@@ -122,7 +133,7 @@ public:
 
 protected:
   PCAMetric2();
-  ~PCAMetric2() override = default;
+  ~PCAMetric2() override;
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
 
@@ -141,6 +152,7 @@ protected:
   using typename Superclass::CentralDifferenceGradientFilterType;
   using typename Superclass::MovingImageDerivativeType;
   using typename Superclass::NonZeroJacobianIndicesType;
+  using typename Superclass::RandomGeneratorType;
 
   /** Computes the innerproduct of transform Jacobian with moving image gradient.
    * The results are stored in imageJacobian, which is supposed
@@ -151,6 +163,82 @@ protected:
                                         const MovingImageDerivativeType & movingImageDerivative,
                                         DerivativeType &                  imageJacobian) const override;
 
+  struct PCAMetric2MultiThreaderParameterType
+  {
+    Self * m_Metric;
+  };
+
+  PCAMetric2MultiThreaderParameterType m_PCAMetric2ThreaderParameters;
+
+  struct PCAMetric2GetSamplesPerThreadStruct
+  {
+    SizeValueType                    st_NumberOfPixelsCounted;
+    MatrixType                       st_DataBlock;
+    std::vector<FixedImagePointType> st_ApprovedSamples;
+    DerivativeType                   st_Derivative;
+    vnl_vector<RealType>             st_ColumnSum;
+    MatrixType                       st_Covariance;
+  };
+
+  itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
+               PCAMetric2GetSamplesPerThreadStruct,
+               PaddedPCAMetric2GetSamplesPerThreadStruct);
+
+  itkAlignedTypedef(ITK_CACHE_LINE_ALIGNMENT,
+                    PaddedPCAMetric2GetSamplesPerThreadStruct,
+                    AlignedPCAMetric2GetSamplesPerThreadStruct);
+
+  mutable AlignedPCAMetric2GetSamplesPerThreadStruct * m_PCAMetric2GetSamplesPerThreadVariables;
+  mutable ThreadIdType                                 m_PCAMetric2GetSamplesPerThreadVariablesSize;
+
+  /** Get the samples and derivative contributions for each thread. */
+  inline void
+  ThreadedGetSamples(ThreadIdType threadID);
+
+  inline void
+  ThreadedComputeCovariance(ThreadIdType threadID);
+
+  inline void
+  ThreadedComputeDerivative(ThreadIdType threadID);
+
+  /** Compute the derivative contributions of the approved samples of the thread sampleThreadId, by the thread
+   * threadId. When the derivative is assembled per stack slice, only the slices of the sub transforms of threadId are
+   * handled.
+   */
+  void
+  ThreadedComputeDerivativeOfSamples(const ThreadIdType sampleThreadId, const ThreadIdType threadId);
+
+  /** Gather the samples and derivatives from all threads. */
+  inline void
+  AfterThreadedGetSamples(MeasureType & value) const;
+
+  inline void
+  AfterThreadedComputeDerivative(DerivativeType & derivative) const;
+
+  /** Helper function to launch the threads. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  GetSamplesThreaderCallback(void * arg);
+
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeCovarianceThreaderCallback(void * arg);
+
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeDerivativeThreaderCallback(void * arg);
+
+  /** Helper functions to launch the threads. */
+  void
+  LaunchGetSamplesThreaderCallback(void) const;
+
+  void
+  LaunchComputeCovarianceThreaderCallback(void) const;
+
+  void
+  LaunchComputeDerivativeThreaderCallback(void) const;
+
+  /** Initialize some multi-threading related parameters. */
+  void
+  InitializeThreadingParameters(void) const override;
+
 private:
   PCAMetric2(const Self &) = delete;
   void
@@ -172,6 +260,22 @@ private:
 
   /** Bool to indicate if the transform used is a stacktransform. Set by elx files. */
   bool m_TransformIsStackTransform{ false };
+
+  /** Slowest varying dimension and its size, set by Initialize(). */
+  unsigned int m_G{ 0 };
+  unsigned int m_LastDimIndex{ 0 };
+
+  /** Matrices, needed for derivative calculation */
+  mutable std::vector<unsigned int> m_PixelStartIndex;
+  mutable MatrixType                m_Atmm;
+  mutable vnl_vector<RealType>      m_ColumnMean;
+  mutable DerivativeMatrixType      m_vSAtmm;
+  mutable DerivativeMatrixType      m_CSv;
+  mutable DerivativeMatrixType      m_Sv;
+  mutable DerivativeMatrixType      m_vdSdmu_part1;
+
+  /** The work unit of each slice, when the derivative is assembled per stack slice (PartitionSamplesByStackSlice). */
+  mutable std::vector<ThreadIdType> m_WorkUnitPerStackSlice;
 };
 
 } // end namespace itk
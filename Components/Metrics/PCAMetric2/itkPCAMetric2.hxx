@@ -20,7 +20,6 @@
 
 #include "itkPCAMetric2.h"
 
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include <vnl/algo/vnl_matrix_update.h>
 #include "itkImage.h"
 #include <vnl/algo/vnl_svd.h>
@@ -41,9 +40,27 @@ PCAMetric2<TFixedImage, TMovingImage>::PCAMetric2()
   this->SetUseImageSampler(true);
   this->SetUseFixedImageLimiter(false);
   this->SetUseMovingImageLimiter(false);
+
+  // Multi-threading structs
+  this->m_PCAMetric2GetSamplesPerThreadVariables = nullptr;
+  this->m_PCAMetric2GetSamplesPerThreadVariablesSize = 0;
+
+  /** Initialize the m_PCAMetric2ThreaderParameters. */
+  this->m_PCAMetric2ThreaderParameters.m_Metric = this;
 } // end constructor
 
 
+/**
+ * ******************* Destructor *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+PCAMetric2<TFixedImage, TMovingImage>::~PCAMetric2()
+{
+  delete[] this->m_PCAMetric2GetSamplesPerThreadVariables;
+} // end Destructor
+
+
 /**
  * ******************* Initialize *******************
  */
@@ -56,8 +73,8 @@ PCAMetric2<TFixedImage, TMovingImage>::Initialize(void)
   Superclass::Initialize();
 
   /** Retrieve slowest varying dimension and its size. */
-  // const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
-  // const unsigned int G = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
+  this->m_LastDimIndex = this->GetFixedImage()->GetImageDimension() - 1;
+  this->m_G = this->GetFixedImage()->GetLargestPossibleRegion().GetSize(this->m_LastDimIndex);
 
 } // end Initialize()
 
@@ -74,6 +91,36 @@ PCAMetric2<TFixedImage, TMovingImage>::PrintSelf(std::ostream & os, Indent inden
 } // end PrintSelf()
 
 
+/**
+ * ********************* InitializeThreadingParameters ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PCAMetric2<TFixedImage, TMovingImage>::InitializeThreadingParameters(void) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+
+  /** Only resize the array of structs when needed. */
+  if (this->m_PCAMetric2GetSamplesPerThreadVariablesSize != numberOfThreads)
+  {
+    delete[] this->m_PCAMetric2GetSamplesPerThreadVariables;
+    this->m_PCAMetric2GetSamplesPerThreadVariables = new AlignedPCAMetric2GetSamplesPerThreadStruct[numberOfThreads];
+    this->m_PCAMetric2GetSamplesPerThreadVariablesSize = numberOfThreads;
+  }
+
+  /** Some initialization. */
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    this->m_PCAMetric2GetSamplesPerThreadVariables[i].st_NumberOfPixelsCounted = NumericTraits<SizeValueType>::Zero;
+    this->m_PCAMetric2GetSamplesPerThreadVariables[i].st_Derivative.SetSize(this->GetNumberOfParameters());
+  }
+
+  this->m_PixelStartIndex.resize(numberOfThreads);
+
+} // end InitializeThreadingParameters()
+
+
 /**
  * ******************* SampleRandom *******************
  */
@@ -85,9 +132,8 @@ PCAMetric2<TFixedImage, TMovingImage>::SampleRandom(const int n, const int m, st
   /** Empty list of last dimension positions. */
   numbers.clear();
 
-  /** Initialize random number generator. */
-  Statistics::MersenneTwisterRandomVariateGenerator::Pointer randomGenerator =
-    Statistics::MersenneTwisterRandomVariateGenerator::GetInstance();
+  /** The random number generator of this metric. */
+  RandomGeneratorType * const randomGenerator = this->m_RandomGenerator;
 
   /** Sample additional at fixed timepoint. */
   for (unsigned int i = 0; i < m_NumAdditionalSamplesFixed; ++i)
@@ -350,14 +396,14 @@ PCAMetric2<TFixedImage, TMovingImage>::GetDerivative(const TransformParametersTy
 
 
 /**
- * ******************* GetValueAndDerivative *******************
+ * ******************* GetValueAndDerivativeSingleThreaded *******************
  */
 
 template <class TFixedImage, class TMovingImage>
 void
-PCAMetric2<TFixedImage, TMovingImage>::GetValueAndDerivative(const TransformParametersType & parameters,
-                                                             MeasureType &                   value,
-                                                             DerivativeType &                derivative) const
+PCAMetric2<TFixedImage, TMovingImage>::GetValueAndDerivativeSingleThreaded(const TransformParametersType & parameters,
+                                                                           MeasureType &                   value,
+                                                                           DerivativeType & derivative) const
 {
   itkDebugMacro("GetValueAndDerivative( " << parameters << " ) ");
   /** Define derivative and Jacobian types. */
@@ -610,76 +656,547 @@ PCAMetric2<TFixedImage, TMovingImage>::GetValueAndDerivative(const TransformPara
   /** Subtract mean from derivative elements. */
   if (this->m_SubtractMean)
   {
-    if (!this->m_TransformIsStackTransform)
+    this->SubtractMeanOverLastDimension(derivative, this->m_TransformIsStackTransform, this->m_GridSize[lastDim], G);
+  }
+
+  /** Return the measure value. */
+  value = measure;
+
+} // end GetValueAndDerivativeSingleThreaded()
+
+
+/**
+ * ******************* GetValueAndDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PCAMetric2<TFixedImage, TMovingImage>::GetValueAndDerivative(const TransformParametersType & parameters,
+                                                             MeasureType &                   value,
+                                                             DerivativeType &                derivative) const
+{
+  /** Option for now to still use the single threaded code. */
+  if (!this->m_UseMultiThread)
+  {
+    return this->GetValueAndDerivativeSingleThreaded(parameters, value, derivative);
+  }
+
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   * Because of these calls GetValueAndDerivative itself is not thread-safe,
+   * so cannot be called multiple times simultaneously.
+   */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
+
+  this->InitializeThreadingParameters();
+
+  /** Launch multi-threading GetSamples */
+  this->LaunchGetSamplesThreaderCallback();
+
+  /** Gather the samples of all threads and compute the eigensystem. */
+  this->AfterThreadedGetSamples(value);
+
+  /** When the derivative is assembled per stack slice, all threads write into the derivative of the first thread,
+   * each into the parameter blocks of its own sub transforms.
+   */
+  this->m_WorkUnitPerStackSlice = this->ComputeWorkUnitPerStackSlice(this->m_G);
+  if (!this->m_WorkUnitPerStackSlice.empty())
+  {
+    this->m_PCAMetric2GetSamplesPerThreadVariables[0].st_Derivative.Fill(0.0);
+  }
+
+  /** Launch multi-threading ComputeDerivative */
+  this->LaunchComputeDerivativeThreaderCallback();
+
+  /** Sum derivative contributions from all threads */
+  this->AfterThreadedComputeDerivative(derivative);
+
+} // end GetValueAndDerivative()
+
+
+/**
+ * ******************* ThreadedGetSamples *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PCAMetric2<TFixedImage, TMovingImage>::ThreadedGetSamples(ThreadIdType threadId)
+{
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const unsigned long         sampleContainerSize = sampleContainer->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+  /** Create iterator over the sample container. */
+  typename ImageSampleContainerType::ConstIterator threader_fiter;
+  typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator threader_fend = sampleContainer->Begin();
+  threader_fbegin += (int)pos_begin;
+  threader_fend += (int)pos_end;
+
+  std::vector<FixedImagePointType> SamplesOK;
+  MatrixType                       datablock(pos_end - pos_begin, this->m_G);
+
+  unsigned int pixelIndex = 0;
+  for (threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter)
+  {
+    /** Read fixed coordinates. */
+    FixedImagePointType fixedPoint = (*threader_fiter).Value().m_ImageCoordinates;
+
+    /** Transform sampled point to voxel coordinates. */
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex(fixedPoint, voxelCoord);
+
+    unsigned int numSamplesOk = 0;
+
+    /** Loop over t */
+    for (unsigned int d = 0; d < this->m_G; ++d)
     {
-      /** Update derivative per dimension.
-       * Parameters are ordered xxxxxxx yyyyyyy zzzzzzz ttttttt and
-       * per dimension xyz.
-       */
-      const unsigned int lastDimGridSize = this->m_GridSize[lastDim];
-      const unsigned int numParametersPerDimension =
-        this->GetNumberOfParameters() / this->GetMovingImage()->GetImageDimension();
-      const unsigned int numControlPointsPerDimension = numParametersPerDimension / lastDimGridSize;
-      DerivativeType     mean(numControlPointsPerDimension);
-      for (unsigned int d = 0; d < this->GetMovingImage()->GetImageDimension(); ++d)
+      /** Initialize some variables. */
+      RealType             movingImageValue;
+      MovingImagePointType mappedPoint;
+
+      /** Set fixed point's last dimension to lastDimPosition. */
+      voxelCoord[this->m_LastDimIndex] = d;
+
+      /** Transform sampled point back to world coordinates. */
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint(voxelCoord, fixedPoint);
+
+      /** Transform point and check if it is inside the B-spline support region. */
+      bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+
+      /** Check if point is inside mask. */
+      if (sampleOk)
       {
-        /** Compute mean per dimension. */
-        mean.Fill(0.0);
-        const unsigned int starti = numParametersPerDimension * d;
-        for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
-        {
-          const unsigned int index = i % numControlPointsPerDimension;
-          mean[index] += derivative[i];
-        }
-        mean /= static_cast<RealType>(lastDimGridSize);
+        sampleOk = this->IsInsideMovingMask(mappedPoint);
+      }
 
-        /** Update derivative for every control point per dimension. */
-        for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
-        {
-          const unsigned int index = i % numControlPointsPerDimension;
-          derivative[i] -= mean[index];
-        }
+      if (sampleOk)
+      {
+        sampleOk = this->FastEvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, nullptr, threadId);
       }
+
+      if (sampleOk)
+      {
+        numSamplesOk++;
+        datablock(pixelIndex, d) = movingImageValue;
+      } // end if sampleOk
+
+    } // end loop over t
+
+    if (numSamplesOk == this->m_G)
+    {
+      SamplesOK.push_back(fixedPoint);
+      pixelIndex++;
+    }
+
+  } // end loop over image sample container
+
+  /** Sum the columns of the data block, to compute their mean over all threads. */
+  vnl_vector<RealType> columnSum(this->m_G, NumericTraits<RealType>::Zero);
+  for (unsigned int i = 0; i < pixelIndex; ++i)
+  {
+    for (unsigned int j = 0; j < this->m_G; ++j)
+    {
+      columnSum(j) += datablock(i, j);
+    }
+  }
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_PCAMetric2GetSamplesPerThreadVariables[threadId].st_NumberOfPixelsCounted = pixelIndex;
+  this->m_PCAMetric2GetSamplesPerThreadVariables[threadId].st_DataBlock = datablock.extract(pixelIndex, this->m_G);
+  this->m_PCAMetric2GetSamplesPerThreadVariables[threadId].st_ApprovedSamples = SamplesOK;
+  this->m_PCAMetric2GetSamplesPerThreadVariables[threadId].st_ColumnSum = columnSum;
+
+} // end ThreadedGetSamples()
+
+
+/**
+ * ******************* AfterThreadedGetSamples *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PCAMetric2<TFixedImage, TMovingImage>::AfterThreadedGetSamples(MeasureType & value) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+  const unsigned int G = this->m_G;
+
+  /** Accumulate the number of pixels. */
+  this->m_NumberOfPixelsCounted = this->m_PCAMetric2GetSamplesPerThreadVariables[0].st_NumberOfPixelsCounted;
+  for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+  {
+    this->m_NumberOfPixelsCounted += this->m_PCAMetric2GetSamplesPerThreadVariables[i].st_NumberOfPixelsCounted;
+  }
+
+  /** Check if enough samples were valid. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
+  const unsigned int N = this->m_NumberOfPixelsCounted;
+
+  /** Calculate mean of columns */
+  this->m_ColumnMean.set_size(G);
+  this->m_ColumnMean.fill(NumericTraits<RealType>::Zero);
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    this->m_ColumnMean += this->m_PCAMetric2GetSamplesPerThreadVariables[i].st_ColumnSum;
+  }
+  this->m_ColumnMean /= RealType(N);
+
+  /** Center the data blocks, and compute their contributions to the covariance matrix, multi-threaded. */
+  this->LaunchComputeCovarianceThreaderCallback();
+
+  /** Gather the centered data blocks and the covariance matrix contributions of all threads. */
+  MatrixType   Amm(N, G);
+  MatrixType   C(G, G, NumericTraits<RealType>::Zero);
+  unsigned int row_start = 0;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    Amm.update(this->m_PCAMetric2GetSamplesPerThreadVariables[i].st_DataBlock, row_start, 0);
+    C += this->m_PCAMetric2GetSamplesPerThreadVariables[i].st_Covariance;
+    this->m_PixelStartIndex[i] = row_start;
+    row_start += this->m_PCAMetric2GetSamplesPerThreadVariables[i].st_DataBlock.rows();
+  }
+  C /= static_cast<RealType>(RealType(N) - 1.0);
+  this->m_Atmm = Amm.transpose();
+
+  vnl_diag_matrix<RealType> S(G);
+  S.fill(NumericTraits<RealType>::Zero);
+  for (unsigned int j = 0; j < G; ++j)
+  {
+    S(j, j) = 1.0 / sqrt(C(j, j));
+  }
+
+  /** Compute correlation matrix K */
+  MatrixType K(S * C * S);
+
+  /** Compute eigenvalues and eigenvectors of K */
+  vnl_symmetric_eigensystem<RealType> eig(K);
+
+  /** The measure is the sum of weighted eigenvalues, see GetValue(). */
+  RealType   sumWeightedEigenValues = itk::NumericTraits<RealType>::Zero;
+  MatrixType eigenVectorMatrix(G, G);
+  for (unsigned int i = 0; i < G; ++i)
+  {
+    sumWeightedEigenValues += (i + 1) * eig.get_eigenvalue(G - i - 1);
+    eigenVectorMatrix.set_column(i, (eig.get_eigenvector(G - i - 1)).normalize());
+  }
+
+  value = sumWeightedEigenValues;
+
+  MatrixType eigenVectorMatrixTranspose(eigenVectorMatrix.transpose());
+
+  /** Sub components of metric derivative */
+  vnl_diag_matrix<DerivativeValueType> dSdmu_part1(G);
+  for (unsigned int d = 0; d < G; ++d)
+  {
+    double S_sqr = S(d, d) * S(d, d);
+    double S_qub = S_sqr * S(d, d);
+    dSdmu_part1(d, d) = -S_qub;
+  }
+
+  this->m_vSAtmm = eigenVectorMatrixTranspose * S * this->m_Atmm;
+  this->m_CSv = C * S * eigenVectorMatrix;
+  this->m_Sv = S * eigenVectorMatrix;
+  this->m_vdSdmu_part1 = eigenVectorMatrixTranspose * dSdmu_part1;
+
+} // end AfterThreadedGetSamples()
+
+
+/**
+ * **************** GetSamplesThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_TYPE
+PCAMetric2<TFixedImage, TMovingImage>::GetSamplesThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+
+  PCAMetric2MultiThreaderParameterType * temp =
+    static_cast<PCAMetric2MultiThreaderParameterType *>(infoStruct->UserData);
+
+  temp->m_Metric->ThreadedGetSamples(threadId);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end GetSamplesThreaderCallback()
+
+
+/**
+ * *********************** LaunchGetSamplesThreaderCallback ***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PCAMetric2<TFixedImage, TMovingImage>::LaunchGetSamplesThreaderCallback(void) const
+{
+  /** Setup local threader. */
+  auto local_threader = ThreaderType::New();
+  local_threader->SetNumberOfWorkUnits(Self::GetNumberOfWorkUnits());
+  local_threader->SetSingleMethod(this->GetSamplesThreaderCallback,
+                                  const_cast<void *>(static_cast<const void *>(&this->m_PCAMetric2ThreaderParameters)));
+
+  /** Launch. */
+  local_threader->SingleMethodExecute();
+
+} // end LaunchGetSamplesThreaderCallback()
+
+
+/**
+ * ******************* ThreadedComputeCovariance *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PCAMetric2<TFixedImage, TMovingImage>::ThreadedComputeCovariance(ThreadIdType threadId)
+{
+  /** Center the data block of this thread. */
+  MatrixType & datablock = this->m_PCAMetric2GetSamplesPerThreadVariables[threadId].st_DataBlock;
+  for (unsigned int i = 0; i < datablock.rows(); ++i)
+  {
+    for (unsigned int j = 0; j < this->m_G; ++j)
+    {
+      datablock(i, j) -= this->m_ColumnMean(j);
     }
-    else
+  }
+
+  /** Compute its contribution to the (unnormalized) covariance matrix. */
+  this->m_PCAMetric2GetSamplesPerThreadVariables[threadId].st_Covariance = datablock.transpose() * datablock;
+
+} // end ThreadedComputeCovariance()
+
+
+/**
+ * **************** ComputeCovarianceThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_TYPE
+PCAMetric2<TFixedImage, TMovingImage>::ComputeCovarianceThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+
+  PCAMetric2MultiThreaderParameterType * temp =
+    static_cast<PCAMetric2MultiThreaderParameterType *>(infoStruct->UserData);
+
+  temp->m_Metric->ThreadedComputeCovariance(threadId);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeCovarianceThreaderCallback()
+
+
+/**
+ * ************** LaunchComputeCovarianceThreaderCallback **********
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PCAMetric2<TFixedImage, TMovingImage>::LaunchComputeCovarianceThreaderCallback(void) const
+{
+  /** Setup local threader. */
+  auto local_threader = ThreaderType::New();
+  local_threader->SetNumberOfWorkUnits(Self::GetNumberOfWorkUnits());
+  local_threader->SetSingleMethod(this->ComputeCovarianceThreaderCallback,
+                                  const_cast<void *>(static_cast<const void *>(&this->m_PCAMetric2ThreaderParameters)));
+
+  /** Launch. */
+  local_threader->SingleMethodExecute();
+
+} // end LaunchComputeCovarianceThreaderCallback()
+
+
+/**
+ * ******************* ThreadedComputeDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PCAMetric2<TFixedImage, TMovingImage>::ThreadedComputeDerivative(ThreadIdType threadId)
+{
+  if (!this->m_WorkUnitPerStackSlice.empty())
+  {
+    /** Assemble the derivative per stack slice: this thread handles the slices of its own sub transforms, for the
+     * approved samples of all threads.
+     */
+    const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+    for (ThreadIdType sampleThreadId = 0; sampleThreadId < numberOfThreads; ++sampleThreadId)
     {
-      /** Update derivative per dimension.
-       * Parameters are ordered x0x0x0y0y0y0z0z0z0x1x1x1y1y1y1z1z1z1 with
-       * the number the time point index.
-       */
-      const unsigned int numParametersPerLastDimension = this->GetNumberOfParameters() / G;
-      DerivativeType     mean(numParametersPerLastDimension);
-      mean.Fill(0.0);
-
-      /** Compute mean per control point. */
-      for (unsigned int t = 0; t < G; ++t)
+      this->ThreadedComputeDerivativeOfSamples(sampleThreadId, threadId);
+    }
+    return;
+  }
+
+  DerivativeType & derivative = this->m_PCAMetric2GetSamplesPerThreadVariables[threadId].st_Derivative;
+  derivative.Fill(0.0);
+
+  this->ThreadedComputeDerivativeOfSamples(threadId, threadId);
+
+} // end ThreadedComputeDerivative()
+
+
+/**
+ * ******************* ThreadedComputeDerivativeOfSamples *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PCAMetric2<TFixedImage, TMovingImage>::ThreadedComputeDerivativeOfSamples(const ThreadIdType sampleThreadId,
+                                                                          const ThreadIdType threadId)
+{
+  /** Create variables to store intermediate results in. When the derivative is assembled per stack slice, only the
+   * slices of the sub transforms of this thread are handled, and the contributions go to the derivative of the first
+   * thread.
+   */
+  const bool       perStackSlice = !this->m_WorkUnitPerStackSlice.empty();
+  DerivativeType & derivative =
+    this->m_PCAMetric2GetSamplesPerThreadVariables[perStackSlice ? 0 : threadId].st_Derivative;
+
+  const std::vector<FixedImagePointType> & approvedSamples =
+    this->m_PCAMetric2GetSamplesPerThreadVariables[sampleThreadId].st_ApprovedSamples;
+  const unsigned int pixelStartIndex = this->m_PixelStartIndex[sampleThreadId];
+
+  /** Initialize some variables. */
+  RealType                  movingImageValue;
+  MovingImagePointType      mappedPoint;
+  MovingImageDerivativeType movingImageDerivative;
+
+  TransformJacobianType      jacobian;
+  DerivativeType             imageJacobian(this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices());
+  NonZeroJacobianIndicesType nzjis(this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices());
+
+  /** Second loop over the approved fixed image samples of this thread. */
+  for (unsigned int i = 0; i < approvedSamples.size(); ++i)
+  {
+    const unsigned int pixelIndex = pixelStartIndex + i;
+
+    /** Read fixed coordinates. */
+    FixedImagePointType fixedPoint = approvedSamples[i];
+
+    /** Transform sampled point to voxel coordinates. */
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex(fixedPoint, voxelCoord);
+
+    for (unsigned int d = 0; d < this->m_G; ++d)
+    {
+      if (perStackSlice && this->m_WorkUnitPerStackSlice[d] != threadId)
       {
-        const unsigned int startc = numParametersPerLastDimension * t;
-        for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
-        {
-          const unsigned int index = c % numParametersPerLastDimension;
-          mean[index] += derivative[c];
-        }
+        continue;
       }
-      mean /= static_cast<RealType>(G);
 
-      /** Update derivative per control point. */
-      for (unsigned int t = 0; t < G; ++t)
+      /** Set fixed point's last dimension to lastDimPosition. */
+      voxelCoord[this->m_LastDimIndex] = d;
+
+      /** Transform sampled point back to world coordinates. */
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint(voxelCoord, fixedPoint);
+      this->TransformPoint(fixedPoint, mappedPoint);
+
+      this->FastEvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative, threadId);
+
+      /** Get the TransformJacobian dT/dmu */
+      this->EvaluateTransformJacobian(fixedPoint, jacobian, nzjis);
+
+      /** Compute the innerproduct (dM/dx)^T (dT/dmu). */
+      this->EvaluateTransformJacobianInnerProduct(jacobian, movingImageDerivative, imageJacobian);
+
+      /** build metric derivative components */
+      for (unsigned int p = 0; p < nzjis.size(); ++p)
       {
-        const unsigned int startc = numParametersPerLastDimension * t;
-        for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
+        DerivativeValueType tmp = 0.0;
+        for (unsigned int z = 0; z < this->m_G; ++z)
         {
-          const unsigned int index = c % numParametersPerLastDimension;
-          derivative[c] -= mean[index];
-        }
-      }
-    }
+          tmp += z * (this->m_vSAtmm[z][pixelIndex] * imageJacobian[p] * this->m_Sv[d][z] +
+                      this->m_vdSdmu_part1[z][d] * this->m_Atmm[d][pixelIndex] * imageJacobian[p] * this->m_CSv[d][z]);
+        } // end loop over eigenvalues
+        derivative[nzjis[p]] += tmp;
+      } // end loop over non-zero jacobian indices
+
+    } // end loop over last dimension
+
+  } // end second loop over sample container
+
+} // end ThreadedComputeDerivativeOfSamples()
+
+
+/**
+ * ******************* AfterThreadedComputeDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PCAMetric2<TFixedImage, TMovingImage>::AfterThreadedComputeDerivative(DerivativeType & derivative) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+
+  /** When the derivative is assembled per stack slice, all contributions are already in the first derivative. */
+  derivative = this->m_PCAMetric2GetSamplesPerThreadVariables[0].st_Derivative;
+  for (ThreadIdType i = 1; i < numberOfThreads && this->m_WorkUnitPerStackSlice.empty(); ++i)
+  {
+    derivative += this->m_PCAMetric2GetSamplesPerThreadVariables[i].st_Derivative;
   }
 
-  /** Return the measure value. */
-  value = measure;
+  derivative *= (2.0 / (DerivativeValueType(this->m_NumberOfPixelsCounted) - 1.0)); // normalize
 
-} // end GetValueAndDerivative()
+  /** Subtract mean from derivative elements. */
+  if (this->m_SubtractMean)
+  {
+    this->SubtractMeanOverLastDimension(
+      derivative, this->m_TransformIsStackTransform, this->m_GridSize[this->m_LastDimIndex], this->m_G);
+  }
+
+} // end AfterThreadedComputeDerivative()
+
+
+/**
+ * **************** ComputeDerivativeThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_TYPE
+PCAMetric2<TFixedImage, TMovingImage>::ComputeDerivativeThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+
+  PCAMetric2MultiThreaderParameterType * temp =
+    static_cast<PCAMetric2MultiThreaderParameterType *>(infoStruct->UserData);
+
+  temp->m_Metric->ThreadedComputeDerivative(threadId);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeDerivativeThreaderCallback()
+
+
+/**
+ * ************** LaunchComputeDerivativeThreaderCallback **********
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PCAMetric2<TFixedImage, TMovingImage>::LaunchComputeDerivativeThreaderCallback(void) const
+{
+  /** Setup local threader. */
+  auto local_threader = ThreaderType::New();
+  local_threader->SetNumberOfWorkUnits(Self::GetNumberOfWorkUnits());
+  local_threader->SetSingleMethod(this->ComputeDerivativeThreaderCallback,
+                                  const_cast<void *>(static_cast<const void *>(&this->m_PCAMetric2ThreaderParameters)));
+
+  /** Launch. */
+  local_threader->SingleMethodExecute();
+
+} // end LaunchComputeDerivativeThreaderCallback()
 
 
 } // end namespace itk
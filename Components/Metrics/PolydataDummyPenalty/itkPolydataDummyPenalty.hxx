@@ -98,6 +98,13 @@ MeshPenalty<TFixedPointSet, TMovingPointSet>::Initialize(void)
 
     this->m_MappedMeshContainer->SetElement(meshId, mappedMesh);
   }
+
+  /** Initialize some multi-threading related parameters. */
+  if (this->m_UseMultiThread)
+  {
+    this->InitializeThreadingParameters();
+  }
+
 } // end Initialize()
 
 
@@ -194,7 +201,7 @@ MeshPenalty<TFixedPointSet, TMovingPointSet>::GetValueAndDerivative(const Transf
     const FixedMeshConstPointer           fixedMesh = fixedMeshContainer->ElementAt(meshId);
     const MeshPointsContainerConstPointer fixedPoints = fixedMesh->GetPoints();
     // const MeshPointDataContainerConstPointer fixedNormals =  fixedMesh->GetPointData();
-    // const unsigned int numberOfPoints = fixedPoints->Size();
+    const unsigned int numberOfPoints = fixedPoints->Size();
 
     const FixedMeshPointer           mappedMesh = this->m_MappedMeshContainer->ElementAt(meshId);
     const MeshPointsContainerPointer mappedPoints = mappedMesh->GetPoints();
@@ -203,20 +210,17 @@ MeshPenalty<TFixedPointSet, TMovingPointSet>::GetValueAndDerivative(const Transf
     // FixedMeshType::PointsContainer::Pointer derivPoints = FixedMeshType::PointsContainer::New();
     // derivPoints->resize(numberOfPoints);
 
-    MeshPointsContainerConstIteratorType fixedPointIt = fixedPoints->Begin();
-    MeshPointsContainerIteratorType      mappedPointIt = mappedPoints->Begin();
-    MeshPointsContainerConstIteratorType fixedPointEnd = fixedPoints->End();
-
-    // MeshPointDataContainerConstIteratorType fixedPointDataIt =fixedNormals->Begin();
-    // MeshPointDataContainerIteratorType mappedPointDataIt = mappedNormals->Begin();
-
-    /* Transform all points and their normals by current transformation*/
-    for (; fixedPointIt != fixedPointEnd; ++fixedPointIt, ++mappedPointIt) //,++fixedPointDataIt,++mappedPointDataIt)
-    {
-      const OutputPointType mappedPoint = this->m_Transform->TransformPoint(fixedPointIt->Value());
-      mappedPointIt.Value() = mappedPoint;
-      // this->TransformPointNormal(fixedPointIt->Value(),  fixedPointDataIt->Value(), mappedPointDataIt->Value()  );
-    }
+    /* Transform all points by current transformation, in contiguous ranges of points, one per work unit.
+     * The points containers are vector containers, so the points are accessed by their index.
+     */
+    this->ParallelizeOverRanges(
+      numberOfPoints,
+      [this, &fixedPoints, &mappedPoints](const SizeValueType begin, const SizeValueType end, ThreadIdType) {
+        for (SizeValueType pointIndex = begin; pointIndex < end; ++pointIndex)
+        {
+          mappedPoints->ElementAt(pointIndex) = this->m_Transform->TransformPoint(fixedPoints->ElementAt(pointIndex));
+        }
+      });
   } // end of loop over meshes
 
   // Since this is a dummy metric always return value = 0 and derivative = [0,...,0]
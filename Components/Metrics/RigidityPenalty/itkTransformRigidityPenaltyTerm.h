@@ -35,6 +35,9 @@
 #include "itkBinaryBallStructuringElement.h"
 #include "itkImageRegionIterator.h"
 
+#include <map>
+#include <utility> // For pair.
+
 namespace itk
 {
 /**
@@ -158,6 +161,7 @@ public:
   typedef typename NeighborhoodType::SizeType                                         NeighborhoodSizeType;
   typedef ImageRegionIterator<CoefficientImageType>                                   CoefficientImageIteratorType;
   typedef NeighborhoodOperatorImageFilter<CoefficientImageType, CoefficientImageType> NOIFType;
+  typedef typename NOIFType::Pointer                                                  NOIFPointer;
   typedef NeighborhoodIterator<CoefficientImageType>                                  NeighborhoodIteratorType;
   typedef typename NeighborhoodIteratorType::RadiusType                               RadiusType;
 
@@ -318,9 +322,21 @@ private:
   void
   CreateNDOperator(NeighborhoodType & F, const std::string & whichF, const CoefficientImageSpacingType & spacing) const;
 
-  /** Private function used for the filtering. It performs 1D separable filtering. */
+  /** Private function used for the filtering. It performs 1D separable filtering, by the mini-pipeline of
+   * m_SeparableFilters that belongs to the operator whichF and the coefficient image whichImage. The output
+   * of this mini-pipeline is overwritten by the next call for the same operator and coefficient image.
+   */
   CoefficientImagePointer
-  FilterSeparable(const CoefficientImageType *, const std::vector<NeighborhoodType> & Operators) const;
+  FilterSeparable(const CoefficientImageType *          image,
+                  const std::vector<NeighborhoodType> & Operators,
+                  const std::string &                   whichF,
+                  const unsigned int                    whichImage) const;
+
+  /** Private function that allocates the subpart and filtered subpart images of
+   * GetValueAndDerivative(), so that they match the B-spline grid.
+   */
+  void
+  AllocateDerivativeBuffers(void) const;
 
   /** Member variables. */
   BSplineTransformPointer m_BSplineTransform;
@@ -356,6 +372,20 @@ private:
   RigidityImagePointer             m_MovingRigidityImageDilated;
   bool                             m_UseFixedRigidityImage;
   bool                             m_UseMovingRigidityImage;
+
+  /** Buffers that are reused by each call of GetValue() and GetValueAndDerivative(). They are allocated
+   * per resolution by Initialize(), and only reallocated when the B-spline grid is changed afterwards.
+   */
+  typedef std::vector<CoefficientImagePointer>                                     CoefficientImageVectorType;
+  typedef std::map<std::pair<std::string, unsigned int>, std::vector<NOIFPointer>> SeparableFilterMapType;
+
+  mutable SeparableFilterMapType                  m_SeparableFilters;
+  mutable std::vector<CoefficientImageVectorType> m_OrthonormalityConditionParts;
+  mutable std::vector<CoefficientImageVectorType> m_PropernessConditionParts;
+  mutable std::vector<CoefficientImageVectorType> m_LinearityConditionParts;
+  mutable CoefficientImageVectorType              m_FilteredOrthonormalityConditionParts;
+  mutable CoefficientImageVectorType              m_FilteredPropernessConditionParts;
+  mutable CoefficientImageVectorType              m_FilteredLinearityConditionParts;
 };
 
 } // end namespace itk
@@ -22,6 +22,8 @@
 
 #include "itkZeroFluxNeumannBoundaryCondition.h"
 
+#include <algorithm> // For min.
+
 namespace itk
 {
 
@@ -161,6 +163,9 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::Initialize(void)
     this->DilateRigidityImages();
   }
 
+  /** Allocate the buffers of GetValueAndDerivative(), once for this resolution. */
+  this->AllocateDerivativeBuffers();
+
   /** Reset the filling bool. */
   this->m_RigidityCoefficientImageIsFilled = false;
 
@@ -536,20 +541,8 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValue(const Parameter
   /** For all dimensions ... */
   for (unsigned int i = 0; i < ImageDimension; ++i)
   {
-    /** ... create the filtered images ... */
-    ui_FA[i] = CoefficientImageType::New();
-    ui_FB[i] = CoefficientImageType::New();
-    ui_FD[i] = CoefficientImageType::New();
-    ui_FE[i] = CoefficientImageType::New();
-    ui_FG[i] = CoefficientImageType::New();
-    if (ImageDimension == 3)
-    {
-      ui_FC[i] = CoefficientImageType::New();
-      ui_FF[i] = CoefficientImageType::New();
-      ui_FH[i] = CoefficientImageType::New();
-      ui_FI[i] = CoefficientImageType::New();
-    }
-    /** ... and the apropiate operators.
+    /** ... create the apropiate operators. The filtered images are the
+     * outputs of the filters of FilterSeparable(), which are reused.
      * The operators C, D and E from the paper are here created
      * by Create1DOperator D, E and G, because of the 3D case and history.
      */
@@ -575,17 +568,17 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValue(const Parameter
   /** Filter the inputImages. */
   for (unsigned int i = 0; i < ImageDimension; ++i)
   {
-    ui_FA[i] = this->FilterSeparable(inputImages[i], Operators_A);
-    ui_FB[i] = this->FilterSeparable(inputImages[i], Operators_B);
-    ui_FD[i] = this->FilterSeparable(inputImages[i], Operators_D);
-    ui_FE[i] = this->FilterSeparable(inputImages[i], Operators_E);
-    ui_FG[i] = this->FilterSeparable(inputImages[i], Operators_G);
+    ui_FA[i] = this->FilterSeparable(inputImages[i], Operators_A, "FA", i);
+    ui_FB[i] = this->FilterSeparable(inputImages[i], Operators_B, "FB", i);
+    ui_FD[i] = this->FilterSeparable(inputImages[i], Operators_D, "FD", i);
+    ui_FE[i] = this->FilterSeparable(inputImages[i], Operators_E, "FE", i);
+    ui_FG[i] = this->FilterSeparable(inputImages[i], Operators_G, "FG", i);
     if (ImageDimension == 3)
     {
-      ui_FC[i] = this->FilterSeparable(inputImages[i], Operators_C);
-      ui_FF[i] = this->FilterSeparable(inputImages[i], Operators_F);
-      ui_FH[i] = this->FilterSeparable(inputImages[i], Operators_H);
-      ui_FI[i] = this->FilterSeparable(inputImages[i], Operators_I);
+      ui_FC[i] = this->FilterSeparable(inputImages[i], Operators_C, "FC", i);
+      ui_FF[i] = this->FilterSeparable(inputImages[i], Operators_F, "FF", i);
+      ui_FH[i] = this->FilterSeparable(inputImages[i], Operators_H, "FH", i);
+      ui_FI[i] = this->FilterSeparable(inputImages[i], Operators_I, "FI", i);
     }
   }
 
@@ -979,20 +972,8 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
   /** For all dimensions ... */
   for (unsigned int i = 0; i < ImageDimension; ++i)
   {
-    /** ... create the filtered images ... */
-    ui_FA[i] = CoefficientImageType::New();
-    ui_FB[i] = CoefficientImageType::New();
-    ui_FD[i] = CoefficientImageType::New();
-    ui_FE[i] = CoefficientImageType::New();
-    ui_FG[i] = CoefficientImageType::New();
-    if (ImageDimension == 3)
-    {
-      ui_FC[i] = CoefficientImageType::New();
-      ui_FF[i] = CoefficientImageType::New();
-      ui_FH[i] = CoefficientImageType::New();
-      ui_FI[i] = CoefficientImageType::New();
-    }
-    /** ... and the apropiate operators.
+    /** ... create the apropiate operators. The filtered images are the
+     * outputs of the filters of FilterSeparable(), which are reused.
      * The operators C, D and E from the paper are here created
      * by Create1DOperator D, E and G, because of the 3D case and history.
      */
@@ -1018,17 +999,17 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
   /** Filter the inputImages. */
   for (unsigned int i = 0; i < ImageDimension; ++i)
   {
-    ui_FA[i] = this->FilterSeparable(inputImages[i], Operators_A);
-    ui_FB[i] = this->FilterSeparable(inputImages[i], Operators_B);
-    ui_FD[i] = this->FilterSeparable(inputImages[i], Operators_D);
-    ui_FE[i] = this->FilterSeparable(inputImages[i], Operators_E);
-    ui_FG[i] = this->FilterSeparable(inputImages[i], Operators_G);
+    ui_FA[i] = this->FilterSeparable(inputImages[i], Operators_A, "FA", i);
+    ui_FB[i] = this->FilterSeparable(inputImages[i], Operators_B, "FB", i);
+    ui_FD[i] = this->FilterSeparable(inputImages[i], Operators_D, "FD", i);
+    ui_FE[i] = this->FilterSeparable(inputImages[i], Operators_E, "FE", i);
+    ui_FG[i] = this->FilterSeparable(inputImages[i], Operators_G, "FG", i);
     if (ImageDimension == 3)
     {
-      ui_FC[i] = this->FilterSeparable(inputImages[i], Operators_C);
-      ui_FF[i] = this->FilterSeparable(inputImages[i], Operators_F);
-      ui_FH[i] = this->FilterSeparable(inputImages[i], Operators_H);
-      ui_FI[i] = this->FilterSeparable(inputImages[i], Operators_I);
+      ui_FC[i] = this->FilterSeparable(inputImages[i], Operators_C, "FC", i);
+      ui_FF[i] = this->FilterSeparable(inputImages[i], Operators_F, "FF", i);
+      ui_FH[i] = this->FilterSeparable(inputImages[i], Operators_H, "FH", i);
+      ui_FI[i] = this->FilterSeparable(inputImages[i], Operators_I, "FI", i);
     }
   }
 
@@ -1073,37 +1054,19 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
     }
   }
 
-  /** Create orthonormality and properness parts. */
-  std::vector<std::vector<CoefficientImagePointer>> OCparts(ImageDimension);
-  std::vector<std::vector<CoefficientImagePointer>> PCparts(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; ++i)
+  /** Make sure that the buffers match the B-spline grid. Normally they are already allocated by Initialize(). */
+  if (this->m_FilteredLinearityConditionParts.empty() ||
+      this->m_FilteredLinearityConditionParts[0]->GetLargestPossibleRegion() !=
+        inputImages[0]->GetLargestPossibleRegion())
   {
-    OCparts[i].resize(ImageDimension);
-    PCparts[i].resize(ImageDimension);
-    for (unsigned int j = 0; j < ImageDimension; ++j)
-    {
-      OCparts[i][j] = CoefficientImageType::New();
-      OCparts[i][j]->SetRegions(inputImages[0]->GetLargestPossibleRegion());
-      OCparts[i][j]->Allocate();
-      PCparts[i][j] = CoefficientImageType::New();
-      PCparts[i][j]->SetRegions(inputImages[0]->GetLargestPossibleRegion());
-      PCparts[i][j]->Allocate();
-    }
+    this->AllocateDerivativeBuffers();
   }
 
-  /** Create linearity parts. */
-  unsigned int                                      NofLParts = 3 * ImageDimension - 3;
-  std::vector<std::vector<CoefficientImagePointer>> LCparts(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; ++i)
-  {
-    LCparts[i].resize(NofLParts);
-    for (unsigned int j = 0; j < NofLParts; ++j)
-    {
-      LCparts[i][j] = CoefficientImageType::New();
-      LCparts[i][j]->SetRegions(inputImages[0]->GetLargestPossibleRegion());
-      LCparts[i][j]->Allocate();
-    }
-  }
+  /** Get the orthonormality, properness and linearity parts. */
+  const unsigned int                                        NofLParts = 3 * ImageDimension - 3;
+  const std::vector<std::vector<CoefficientImagePointer>> & OCparts = this->m_OrthonormalityConditionParts;
+  const std::vector<std::vector<CoefficientImagePointer>> & PCparts = this->m_PropernessConditionParts;
+  const std::vector<std::vector<CoefficientImagePointer>> & LCparts = this->m_LinearityConditionParts;
 
   /** Create iterators over all parts. */
   std::vector<std::vector<CoefficientImageIteratorType>> itOCp(ImageDimension);
@@ -1567,47 +1530,10 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
    * Create all necessary iterators and operators.
    ************************************************************************* */
 
-  /** Create filtered orthonormality, properness and linearity parts. */
-  std::vector<CoefficientImagePointer> OCpartsF(ImageDimension);
-  std::vector<CoefficientImagePointer> PCpartsF(ImageDimension);
-  std::vector<CoefficientImagePointer> LCpartsF(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; ++i)
-  {
-    OCpartsF[i] = CoefficientImageType::New();
-    OCpartsF[i]->SetRegions(inputImages[0]->GetLargestPossibleRegion());
-    OCpartsF[i]->Allocate();
-    PCpartsF[i] = CoefficientImageType::New();
-    PCpartsF[i]->SetRegions(inputImages[0]->GetLargestPossibleRegion());
-    PCpartsF[i]->Allocate();
-    LCpartsF[i] = CoefficientImageType::New();
-    LCpartsF[i]->SetRegions(inputImages[0]->GetLargestPossibleRegion());
-    LCpartsF[i]->Allocate();
-  }
-
-  /** Create neighborhood iterators over the subparts. */
-  std::vector<std::vector<NeighborhoodIteratorType>> nitOCp(ImageDimension);
-  std::vector<std::vector<NeighborhoodIteratorType>> nitPCp(ImageDimension);
-  std::vector<std::vector<NeighborhoodIteratorType>> nitLCp(ImageDimension);
-  RadiusType                                         radius;
-  radius.Fill(1);
-  for (unsigned int i = 0; i < ImageDimension; ++i)
-  {
-    nitOCp[i].resize(ImageDimension);
-    nitPCp[i].resize(ImageDimension);
-    nitLCp[i].resize(NofLParts);
-    for (unsigned int j = 0; j < ImageDimension; ++j)
-    {
-      nitOCp[i][j] = NeighborhoodIteratorType(radius, OCparts[i][j], OCparts[i][j]->GetLargestPossibleRegion());
-      nitOCp[i][j].GoToBegin();
-      nitPCp[i][j] = NeighborhoodIteratorType(radius, PCparts[i][j], PCparts[i][j]->GetLargestPossibleRegion());
-      nitPCp[i][j].GoToBegin();
-    }
-    for (unsigned int j = 0; j < NofLParts; ++j)
-    {
-      nitLCp[i][j] = NeighborhoodIteratorType(radius, LCparts[i][j], LCparts[i][j]->GetLargestPossibleRegion());
-      nitLCp[i][j].GoToBegin();
-    }
-  }
+  /** Get the filtered orthonormality, properness and linearity parts. */
+  const std::vector<CoefficientImagePointer> & OCpartsF = this->m_FilteredOrthonormalityConditionParts;
+  const std::vector<CoefficientImagePointer> & PCpartsF = this->m_FilteredPropernessConditionParts;
+  const std::vector<CoefficientImagePointer> & LCpartsF = this->m_FilteredLinearityConditionParts;
 
   /** Create iterators over the filtered parts. */
   std::vector<CoefficientImageIteratorType> itOCpf(ImageDimension);
@@ -1623,12 +1549,6 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
     itLCpf[i].GoToBegin();
   }
 
-  /** Create a neigborhood iterator over the rigidity image. */
-  NeighborhoodIteratorType nit_RCI(
-    radius, this->m_RigidityCoefficientImage, this->m_RigidityCoefficientImage->GetLargestPossibleRegion());
-  nit_RCI.GoToBegin();
-  unsigned int neighborhoodSize = nit_RCI.Size();
-
   /** Create ND operators. */
   NeighborhoodType Operator_A, Operator_B, Operator_C, Operator_D, Operator_E, Operator_F, Operator_G, Operator_H,
     Operator_I;
@@ -1652,95 +1572,140 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
     }
   }
 
-  /** TASK 7A:
-   * Calculate the filtered versions of the orthonormality subparts.
-   * These are F_A * {subpart_0} + F_B * {subpart_1},
-   * and (for 3D) + F_C * {subpart_2}, for all dimensions.
+  /** TASK 7:
+   * Calculate the filtered versions of the orthonormality, properness and
+   * linearity subparts, in a single pass over the coefficient grid.
+   * For the orthonormality and properness these are
+   * F_A * {subpart_0} + F_B * {subpart_1}, and (for 3D) + F_C * {subpart_2},
+   * for all dimensions. For the linearity these are
+   * sum_{i=1}^{NofLParts} F_{D,E,G,F,H,I} * {subpart_i}.
+   * All subparts are multiplied by the rigidity coefficients c(k) of the
+   * neighborhood, so that a pixel whose neighborhood has only zero rigidity
+   * coefficients has zero filtered values. The grid is divided into regions
+   * that are processed by separate threads, and each region is divided into
+   * tiles. A tile of which the neighborhood has only zero rigidity coefficients
+   * is just filled with zeros, so that the stencil is only applied to the tiles
+   * that overlap with the rigid parts of the grid.
    ************************************************************************* */
 
-  if (this->m_CalculateOrthonormalityCondition)
-  {
-    while (!itOCpf[0].IsAtEnd())
-    {
-      /** Create and reset tmp with zeros. */
-      std::vector<double> tmp(ImageDimension, 0.0);
+  RadiusType radius;
+  radius.Fill(1);
 
-      /** Loop over all dimensions. */
-      for (unsigned int i = 0; i < ImageDimension; ++i)
-      {
-        /** Loop over the neighborhood. */
-        for (unsigned int k = 0; k < neighborhoodSize; ++k)
-        {
-          /** Calculation of the inner product. */
-          tmp[i] += Operator_A.GetElement(k)   // FA *
-                    * nitOCp[i][0].GetPixel(k) // subpart[ i ][ 0 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          tmp[i] += Operator_B.GetElement(k)   // FB *
-                    * nitOCp[i][1].GetPixel(k) // subpart[ i ][ 1 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          if (ImageDimension == 3)
-          {
-            tmp[i] += Operator_C.GetElement(k)   // FC *
-                      * nitOCp[i][2].GetPixel(k) // subpart[ i ][ 2 ]
-                      * nit_RCI.GetPixel(k);     // c(k)
-          }
-        } // end loop over neighborhood
+  const RigidityImageRegionType gridRegion = this->m_RigidityCoefficientImage->GetLargestPossibleRegion();
 
-        /** Set the result in the filtered part. */
-        itOCpf[i].Set(tmp[i]);
+  /** The size of a tile, in each dimension. */
+  const SizeValueType tileSize = 8;
 
-      } // end loop over dimension i
+  const auto filterSubpartsOfTile = [&](const RigidityImageRegionType & region) {
+    /** Create a neigborhood iterator over the rigidity image. */
+    NeighborhoodIteratorType nit_RCI(radius, this->m_RigidityCoefficientImage, region);
+    const unsigned int       neighborhoodSize = nit_RCI.Size();
 
-      /** Increase all iterators. */
-      ++nit_RCI;
-      for (unsigned int i = 0; i < ImageDimension; ++i)
+    /** Create neighborhood iterators over the subparts. */
+    std::vector<std::vector<NeighborhoodIteratorType>> nitOCp(ImageDimension);
+    std::vector<std::vector<NeighborhoodIteratorType>> nitPCp(ImageDimension);
+    std::vector<std::vector<NeighborhoodIteratorType>> nitLCp(ImageDimension);
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      if (this->m_CalculateOrthonormalityCondition)
       {
-        ++itOCpf[i];
         for (unsigned int j = 0; j < ImageDimension; ++j)
         {
-          ++nitOCp[i][j];
+          nitOCp[i].push_back(NeighborhoodIteratorType(radius, OCparts[i][j], region));
         }
       }
-    } // end while
-  }   // end if do orthonormality
+      if (this->m_CalculatePropernessCondition)
+      {
+        for (unsigned int j = 0; j < ImageDimension; ++j)
+        {
+          nitPCp[i].push_back(NeighborhoodIteratorType(radius, PCparts[i][j], region));
+        }
+      }
+      if (this->m_CalculateLinearityCondition)
+      {
+        for (unsigned int j = 0; j < NofLParts; ++j)
+        {
+          nitLCp[i].push_back(NeighborhoodIteratorType(radius, LCparts[i][j], region));
+        }
+      }
+    }
 
-  /** TASK 7B:
-   * Calculate the filtered versions of the properness subparts.
-   * These are F_A * {subpart_0} + F_B * {subpart_1},
-   * and (for 3D) + F_C * {subpart_2}, for all dimensions.
-   ************************************************************************* */
+    /** Create iterators over the filtered parts. */
+    std::vector<CoefficientImageIteratorType> itOCpfRegion(ImageDimension);
+    std::vector<CoefficientImageIteratorType> itPCpfRegion(ImageDimension);
+    std::vector<CoefficientImageIteratorType> itLCpfRegion(ImageDimension);
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      itOCpfRegion[i] = CoefficientImageIteratorType(OCpartsF[i], region);
+      itPCpfRegion[i] = CoefficientImageIteratorType(PCpartsF[i], region);
+      itLCpfRegion[i] = CoefficientImageIteratorType(LCpartsF[i], region);
+    }
 
-  nit_RCI.GoToBegin();
-  if (this->m_CalculatePropernessCondition)
-  {
-    while (!itPCpf[0].IsAtEnd())
+    std::vector<ScalarType> rigidityCoefficients(neighborhoodSize);
+
+    while (!nit_RCI.IsAtEnd())
     {
-      /** Create and reset tmp with zeros. */
-      std::vector<double> tmp(ImageDimension, 0.0);
+      /** Copy the rigidity coefficients of the neighborhood, and check whether they are all zero. */
+      bool isRigidityZero = true;
+      for (unsigned int k = 0; k < neighborhoodSize; ++k)
+      {
+        rigidityCoefficients[k] = nit_RCI.GetPixel(k);
+        isRigidityZero = isRigidityZero && (rigidityCoefficients[k] == NumericTraits<ScalarType>::ZeroValue());
+      }
 
       /** Loop over all dimensions. */
       for (unsigned int i = 0; i < ImageDimension; ++i)
       {
-        /** Loop over the neighborhood. */
-        for (unsigned int k = 0; k < neighborhoodSize; ++k)
+        /** Create and reset tmp with zeros. */
+        double tmpOC = 0.0;
+        double tmpPC = 0.0;
+        double tmpLC = 0.0;
+
+        if (!isRigidityZero)
         {
-          /** Calculation of the inner product. */
-          tmp[i] += Operator_A.GetElement(k)   // FA *
-                    * nitPCp[i][0].GetPixel(k) // subpart[ i ][ 0 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          tmp[i] += Operator_B.GetElement(k)   // FB *
-                    * nitPCp[i][1].GetPixel(k) // subpart[ i ][ 1 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          if (ImageDimension == 3)
+          /** Loop over the neighborhood. */
+          for (unsigned int k = 0; k < neighborhoodSize; ++k)
           {
-            tmp[i] += Operator_C.GetElement(k)   // FC *
-                      * nitPCp[i][2].GetPixel(k) // subpart[ i ][ 2 ]
-                      * nit_RCI.GetPixel(k);     // c(k)
-          }
-        } // end loop over neighborhood
+            const ScalarType c = rigidityCoefficients[k];
+
+            /** Calculation of the inner products. */
+            if (this->m_CalculateOrthonormalityCondition)
+            {
+              tmpOC += Operator_A.GetElement(k) * nitOCp[i][0].GetPixel(k) * c; // FA * subpart[ i ][ 0 ] * c(k)
+              tmpOC += Operator_B.GetElement(k) * nitOCp[i][1].GetPixel(k) * c; // FB * subpart[ i ][ 1 ] * c(k)
+              if (ImageDimension == 3)
+              {
+                tmpOC += Operator_C.GetElement(k) * nitOCp[i][2].GetPixel(k) * c; // FC * subpart[ i ][ 2 ] * c(k)
+              }
+            }
+            if (this->m_CalculatePropernessCondition)
+            {
+              tmpPC += Operator_A.GetElement(k) * nitPCp[i][0].GetPixel(k) * c; // FA * subpart[ i ][ 0 ] * c(k)
+              tmpPC += Operator_B.GetElement(k) * nitPCp[i][1].GetPixel(k) * c; // FB * subpart[ i ][ 1 ] * c(k)
+              if (ImageDimension == 3)
+              {
+                tmpPC += Operator_C.GetElement(k) * nitPCp[i][2].GetPixel(k) * c; // FC * subpart[ i ][ 2 ] * c(k)
+              }
+            }
+            if (this->m_CalculateLinearityCondition)
+            {
+              tmpLC += Operator_D.GetElement(k) * nitLCp[i][0].GetPixel(k) * c; // FD * subpart[ i ][ 0 ] * c(k)
+              tmpLC += Operator_E.GetElement(k) * nitLCp[i][1].GetPixel(k) * c; // FE * subpart[ i ][ 1 ] * c(k)
+              tmpLC += Operator_G.GetElement(k) * nitLCp[i][2].GetPixel(k) * c; // FG * subpart[ i ][ 2 ] * c(k)
+              if (ImageDimension == 3)
+              {
+                tmpLC += Operator_F.GetElement(k) * nitLCp[i][3].GetPixel(k) * c; // FF * subpart[ i ][ 3 ] * c(k)
+                tmpLC += Operator_H.GetElement(k) * nitLCp[i][4].GetPixel(k) * c; // FH * subpart[ i ][ 4 ] * c(k)
+                tmpLC += Operator_I.GetElement(k) * nitLCp[i][5].GetPixel(k) * c; // FI * subpart[ i ][ 5 ] * c(k)
+              }
+            }
+          } // end loop over neighborhood
+        }
 
-        /** Set the result in the filtered part. */
-        itPCpf[i].Set(tmp[i]);
+        /** Set the results in the filtered parts. */
+        itOCpfRegion[i].Set(tmpOC);
+        itPCpfRegion[i].Set(tmpPC);
+        itLCpfRegion[i].Set(tmpLC);
 
       } // end loop over dimension i
 
@@ -1748,95 +1713,104 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
       ++nit_RCI;
       for (unsigned int i = 0; i < ImageDimension; ++i)
       {
-        ++itPCpf[i];
-        for (unsigned int j = 0; j < ImageDimension; ++j)
+        ++itOCpfRegion[i];
+        ++itPCpfRegion[i];
+        ++itLCpfRegion[i];
+        for (auto & nit : nitOCp[i])
+        {
+          ++nit;
+        }
+        for (auto & nit : nitPCp[i])
+        {
+          ++nit;
+        }
+        for (auto & nit : nitLCp[i])
         {
-          ++nitPCp[i][j];
+          ++nit;
         }
       }
     } // end while
-  }   // end if do properness
-
-  /** TASK 7C:
-   * Calculate the filtered versions of the linearity subparts.
-   * These are sum_{i=1}^{NofLParts} F_{D,E,G,F,H,I} * {subpart_i}.
-   ************************************************************************* */
+  };
 
-  nit_RCI.GoToBegin();
-  if (this->m_CalculateLinearityCondition)
-  {
-    while (!itLCpf[0].IsAtEnd())
+  const auto filterSubparts = [&](const RigidityImageRegionType & region) {
+    /** Compute the number of tiles of the region. */
+    SizeValueType numberOfTiles[ImageDimension];
+    SizeValueType totalNumberOfTiles = 1;
+    for (unsigned int d = 0; d < ImageDimension; ++d)
     {
-      /** Create and reset tmp with zeros. */
-      std::vector<double> tmp(ImageDimension, 0.0);
+      numberOfTiles[d] = (region.GetSize(d) + tileSize - 1) / tileSize;
+      totalNumberOfTiles *= numberOfTiles[d];
+    }
 
-      /** Loop over all dimensions. */
-      for (unsigned int i = 0; i < ImageDimension; ++i)
+    /** Loop over the tiles. */
+    for (SizeValueType t = 0; t < totalNumberOfTiles; ++t)
+    {
+      /** Get the region of the tile, cropped to the region. */
+      RigidityImageRegionType tile;
+      SizeValueType           remainder = t;
+      for (unsigned int d = 0; d < ImageDimension; ++d)
       {
-        /** Loop over the neighborhood. */
-        for (unsigned int k = 0; k < neighborhoodSize; ++k)
-        {
-          /** Calculation of the inner product. */
-          tmp[i] += Operator_D.GetElement(k)   // FD *
-                    * nitLCp[i][0].GetPixel(k) // subpart[ i ][ 0 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          tmp[i] += Operator_E.GetElement(k)   // FE *
-                    * nitLCp[i][1].GetPixel(k) // subpart[ i ][ 1 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          tmp[i] += Operator_G.GetElement(k)   // FG *
-                    * nitLCp[i][2].GetPixel(k) // subpart[ i ][ 1 ]
-                    * nit_RCI.GetPixel(k);     // c(k)
-          if (ImageDimension == 3)
-          {
-            tmp[i] += Operator_F.GetElement(k)   // FF *
-                      * nitLCp[i][3].GetPixel(k) // subpart[ i ][ 1 ]
-                      * nit_RCI.GetPixel(k);     // c(k)
-            tmp[i] += Operator_H.GetElement(k)   // FH *
-                      * nitLCp[i][4].GetPixel(k) // subpart[ i ][ 1 ]
-                      * nit_RCI.GetPixel(k);     // c(k)
-            tmp[i] += Operator_I.GetElement(k)   // FI *
-                      * nitLCp[i][5].GetPixel(k) // subpart[ i ][ 1 ]
-                      * nit_RCI.GetPixel(k);     // c(k)
-          }
-        } // end loop over neighborhood
-
-        /** Set the result in the filtered part. */
-        itLCpf[i].Set(tmp[i]);
+        const SizeValueType tileIndex = remainder % numberOfTiles[d];
+        remainder /= numberOfTiles[d];
+        tile.SetIndex(d, region.GetIndex(d) + static_cast<IndexValueType>(tileIndex * tileSize));
+        tile.SetSize(d, std::min(tileSize, region.GetSize(d) - tileIndex * tileSize));
+      }
 
-      } // end loop over dimension i
+      /** Check whether the rigidity coefficients of the neighborhood of the tile are all zero.
+       * Outside the grid, the neighborhood iterators repeat the border values, which are
+       * already in the cropped neighborhood.
+       */
+      RigidityImageRegionType tileNeighborhood = tile;
+      tileNeighborhood.PadByRadius(radius);
+      tileNeighborhood.Crop(gridRegion);
+      bool isRigidityZero = true;
+      for (RigidityImageIteratorType it(this->m_RigidityCoefficientImage, tileNeighborhood);
+           isRigidityZero && !it.IsAtEnd();
+           ++it)
+      {
+        isRigidityZero = (it.Get() == NumericTraits<RigidityPixelType>::ZeroValue());
+      }
 
-      /** Increase all iterators. */
-      ++nit_RCI;
-      for (unsigned int i = 0; i < ImageDimension; ++i)
+      if (isRigidityZero)
       {
-        ++itLCpf[i];
-        for (unsigned int j = 0; j < NofLParts; ++j)
+        /** Set the filtered parts of the tile to zero. */
+        for (unsigned int i = 0; i < ImageDimension; ++i)
         {
-          ++nitLCp[i][j];
+          for (const auto & filteredPart : { OCpartsF[i], PCpartsF[i], LCpartsF[i] })
+          {
+            for (CoefficientImageIteratorType it(filteredPart, tile); !it.IsAtEnd(); ++it)
+            {
+              it.Set(NumericTraits<ScalarType>::ZeroValue());
+            }
+          }
         }
       }
-    } // end while
-  }   // end if do linearity
-
-  /** TASK 8:
-   * Add it all to create the final derivative images.
-   ************************************************************************* */
+      else
+      {
+        filterSubpartsOfTile(tile);
+      }
+    } // end loop over tiles
+  };
 
-  /** Create derivative images, each holding a component of the vector field. */
-  std::vector<CoefficientImagePointer> derivativeImages(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; ++i)
+  if (this->m_UseMultiThread)
   {
-    derivativeImages[i] = CoefficientImageType::New();
-    derivativeImages[i]->SetRegions(inputImages[i]->GetLargestPossibleRegion());
-    derivativeImages[i]->Allocate();
+    this->m_Threader->template ParallelizeImageRegion<ImageDimension>(gridRegion, filterSubparts, nullptr);
   }
+  else
+  {
+    filterSubparts(gridRegion);
+  }
+
+  /** TASK 8:
+   * Add it all to create the final derivative. The derivative is stored
+   * directly, component after component of the vector field, in the same
+   * pass over the filtered parts.
+   ************************************************************************* */
 
-  /** Create iterators over the derivative images. */
-  std::vector<CoefficientImageIteratorType> itDIs(ImageDimension);
+  /** Reset the iterators over the filtered parts. */
+  const SizeValueType numberOfGridPoints = gridRegion.GetNumberOfPixels();
   for (unsigned int i = 0; i < ImageDimension; ++i)
   {
-    itDIs[i] = CoefficientImageIteratorType(derivativeImages[i], derivativeImages[i]->GetLargestPossibleRegion());
-    itDIs[i].GoToBegin();
     itOCpf[i].GoToBegin();
     itPCpf[i].GoToBegin();
     itLCpf[i].GoToBegin();
@@ -1848,7 +1822,7 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
   MeasureType gradMagOC = NumericTraits<MeasureType>::Zero;
   MeasureType gradMagPC = NumericTraits<MeasureType>::Zero;
   double      rigidityCoefficientSumSqr = rigidityCoefficientSum * rigidityCoefficientSum;
-  while (!itDIs[0].IsAtEnd())
+  for (SizeValueType k = 0; k < numberOfGridPoints; ++k)
   {
     for (unsigned int i = 0; i < ImageDimension; ++i)
     {
@@ -1879,34 +1853,20 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::GetValueAndDerivative(co
       {
         tmpDIs += tmpPC;
       }
-      itDIs[i].Set(tmpDIs);
+      derivative[i * numberOfGridPoints + k] = tmpDIs / rigidityCoefficientSum;
 
       /** Update iterators. */
-      ++itDIs[i];
       ++itOCpf[i];
       ++itPCpf[i];
       ++itLCpf[i];
     }
-  } // end while
+  } // end for
 
   /** Set the gradient magnitudes of the several terms. */
   this->m_LinearityConditionGradientMagnitude = std::sqrt(gradMagLC);
   this->m_OrthonormalityConditionGradientMagnitude = std::sqrt(gradMagOC);
   this->m_PropernessConditionGradientMagnitude = std::sqrt(gradMagPC);
 
-  /** Rearrange to create a derivative. */
-  unsigned int j = 0;
-  for (unsigned int i = 0; i < ImageDimension; ++i)
-  {
-    itDIs[i].GoToBegin();
-    while (!itDIs[i].IsAtEnd())
-    {
-      derivative[j] = itDIs[i].Get() / rigidityCoefficientSum;
-      ++itDIs[i];
-      j++;
-    } // end while
-  }   // end for
-
 } // end GetValueAndDerivative()
 
 
@@ -2163,23 +2123,38 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::Create1DOperator(
 
 template <class TFixedImage, class TScalarType>
 auto
-TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::FilterSeparable(
-  const CoefficientImageType *          image,
-  const std::vector<NeighborhoodType> & Operators) const -> CoefficientImagePointer
+TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::FilterSeparable(const CoefficientImageType *          image,
+                                                                        const std::vector<NeighborhoodType> & Operators,
+                                                                        const std::string &                   whichF,
+                                                                        const unsigned int whichImage) const
+  -> CoefficientImagePointer
 {
-  /** Create filters, supply them with boundary conditions and operators. */
-  std::vector<typename NOIFType::Pointer> filters(ImageDimension);
-  for (unsigned int i = 0; i < ImageDimension; ++i)
+  /** Get the filters of this operator and image. They are created only once, so that their
+   * output buffers are reused by the following calls.
+   */
+  std::vector<NOIFPointer> & filters = this->m_SeparableFilters[std::make_pair(whichF, whichImage)];
+  if (filters.empty())
   {
-    filters[i] = NOIFType::New();
-    filters[i]->SetOperator(Operators[i]);
+    /** Create the filters and set up the mini-pipeline. */
+    filters.resize(ImageDimension);
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      filters[i] = NOIFType::New();
+    }
+    for (unsigned int i = 1; i < ImageDimension; ++i)
+    {
+      filters[i]->SetInput(filters[i - 1]->GetOutput());
+    }
   }
 
-  /** Set up the mini-pipline. */
+  /** Supply the filters with the operators, which depend on the grid spacing.
+   * The coefficient images may be modified in place by the transform, so force the execution.
+   */
   filters[0]->SetInput(image);
-  for (unsigned int i = 1; i < ImageDimension; ++i)
+  for (unsigned int i = 0; i < ImageDimension; ++i)
   {
-    filters[i]->SetInput(filters[i - 1]->GetOutput());
+    filters[i]->SetOperator(Operators[i]);
+    filters[i]->Modified();
   }
 
   /** Execute the mini-pipeline. */
@@ -2191,6 +2166,56 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::FilterSeparable(
 } // end FilterSeparable()
 
 
+/**
+ * ********************* AllocateDerivativeBuffers ******************
+ */
+
+template <class TFixedImage, class TScalarType>
+void
+TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::AllocateDerivativeBuffers(void) const
+{
+  const RigidityImageRegionType region =
+    this->m_BSplineTransform->GetCoefficientImages()[0]->GetLargestPossibleRegion();
+  const unsigned int NofLParts = 3 * ImageDimension - 3;
+
+  const auto createImage = [&region] {
+    const CoefficientImagePointer image = CoefficientImageType::New();
+    image->SetRegions(region);
+    image->Allocate();
+    return image;
+  };
+
+  /** Create the orthonormality, properness and linearity parts. */
+  this->m_OrthonormalityConditionParts.assign(ImageDimension, CoefficientImageVectorType(ImageDimension));
+  this->m_PropernessConditionParts.assign(ImageDimension, CoefficientImageVectorType(ImageDimension));
+  this->m_LinearityConditionParts.assign(ImageDimension, CoefficientImageVectorType(NofLParts));
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    for (unsigned int j = 0; j < ImageDimension; ++j)
+    {
+      this->m_OrthonormalityConditionParts[i][j] = createImage();
+      this->m_PropernessConditionParts[i][j] = createImage();
+    }
+    for (unsigned int j = 0; j < NofLParts; ++j)
+    {
+      this->m_LinearityConditionParts[i][j] = createImage();
+    }
+  }
+
+  /** Create the filtered parts. */
+  this->m_FilteredOrthonormalityConditionParts.resize(ImageDimension);
+  this->m_FilteredPropernessConditionParts.resize(ImageDimension);
+  this->m_FilteredLinearityConditionParts.resize(ImageDimension);
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    this->m_FilteredOrthonormalityConditionParts[i] = createImage();
+    this->m_FilteredPropernessConditionParts[i] = createImage();
+    this->m_FilteredLinearityConditionParts[i] = createImage();
+  }
+
+} // end AllocateDerivativeBuffers()
+
+
 /**
  * ************************ CreateNDOperator *********************
  */
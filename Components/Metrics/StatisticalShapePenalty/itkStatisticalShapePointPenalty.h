@@ -35,6 +35,7 @@
 #include <vnl/algo/vnl_svd_economy.h>
 
 #include <string>
+#include <vector>
 
 namespace itk
 {
@@ -42,6 +43,11 @@ namespace itk
  * \brief Computes the Mahalanobis distance between the transformed shape and a mean shape.
  *  A model mean and covariance are required.
  *
+ * The derivative is computed by first computing the gradient of the distance with respect to the
+ * proposal shape vector, which only requires a single (low-rank) back-projection by the eigenvectors,
+ * and then multiplying this gradient by the sparse Jacobians of the transformed points. Both the
+ * transformation of the points and this sparse product may be performed multi-threaded.
+ *
  * \author F.F. Berendsen, Image Sciences Institute, UMC Utrecht, The Netherlands
  * \note This work was funded by the projects Care4Me and Mediate.
  * \note If you use the StatisticalShapePenalty anywhere we would appreciate if you cite the following article:\n
@@ -93,10 +99,7 @@ public:
   typedef typename OutputPointType::CoordRepType CoordRepType;
   typedef vnl_vector<CoordRepType>               VnlVectorType;
   typedef vnl_matrix<CoordRepType>               VnlMatrixType;
-  // typedef itk::Array<VnlVectorType *> ProposalDerivativeType;
-  typedef typename std::vector<VnlVectorType *> ProposalDerivativeType;
-  // typedef typename vnl_vector<VnlVectorType *> ProposalDerivativeType; //Cannot be linked
-  typedef vnl_svd_economy<CoordRepType> PCACovarianceType;
+  typedef vnl_svd_economy<CoordRepType>          PCACovarianceType;
 
   /** Initialization. */
   void
@@ -180,17 +183,20 @@ private:
   void
   operator=(const Self &) = delete;
 
+  /** Computes result = matrix * vector, over the contiguous rows of the matrix. */
   void
-  FillProposalVector(const OutputPointType & fixedPoint, const unsigned int vertexindex) const;
+  MultiplyMatrixVector(const VnlMatrixType & matrix, const VnlVectorType & vector, VnlVectorType & result) const;
 
+  /** Precomputes the matrices and scales that are used by CalculateValue(), at the end of Initialize(). */
   void
-  FillProposalDerivative(const OutputPointType & fixedPoint, const unsigned int vertexindex) const;
+  PrecomputeProjectionMatrices(const unsigned int shapeLength);
 
+  /** Transforms all fixed points, and copies their coordinates into the proposal vector. */
   void
-  UpdateCentroidAndAlignProposalVector(const unsigned int shapeLength) const;
+  FillProposalVector(void) const;
 
   void
-  UpdateCentroidAndAlignProposalDerivative(const unsigned int shapeLength) const;
+  UpdateCentroidAndAlignProposalVector(const unsigned int shapeLength) const;
 
   void
   UpdateL2(const unsigned int shapeLength) const;
@@ -198,28 +204,31 @@ private:
   void
   NormalizeProposalVector(const unsigned int shapeLength) const;
 
-  void
-  UpdateL2AndNormalizeProposalDerivative(const unsigned int shapeLength) const;
-
+  /** Computes the value, and, when weightedDifferenceVector is not null, the weighted difference vector,
+   * which is the gradient of the value with respect to the proposal vector, multiplied by the value.
+   */
   void
   CalculateValue(MeasureType &   value,
                  VnlVectorType & differenceVector,
-                 VnlVectorType & centerrotated,
-                 VnlVectorType & eigrot) const;
+                 VnlVectorType * weightedDifferenceVector) const;
+
+  /** Back-propagates the gradient with respect to the proposal vector through the size normalization
+   * and the centroid alignment, yielding the gradient with respect to the transformed point coordinates.
+   */
+  void
+  BackPropagateProposalGradient(VnlVectorType & proposalGradient, const unsigned int shapeLength) const;
 
+  /** Computes the derivative by multiplying the gradient with respect to the transformed point
+   * coordinates by the sparse Jacobians of the transform.
+   */
   void
-  CalculateDerivative(DerivativeType &      derivative,
-                      const MeasureType &   value,
-                      const VnlVectorType & differenceVector,
-                      const VnlVectorType & centerrotated,
-                      const VnlVectorType & eigrot,
-                      const unsigned int    shapeLength) const;
+  CalculateDerivative(DerivativeType & derivative, const VnlVectorType & shapeGradient) const;
 
   void
   CalculateCutOffValue(MeasureType & value) const;
 
   void
-  CalculateCutOffDerivative(typename DerivativeType::element_type & derivativeElement, const MeasureType & value) const;
+  CalculateCutOffDerivative(DerivativeType & derivative, const MeasureType & value) const;
 
   const VnlVectorType * m_MeanVector;
   const VnlMatrixType * m_CovarianceMatrix;
@@ -243,15 +252,22 @@ private:
 
   VnlVectorType * m_EigenValuesRegularized;
 
-  mutable ProposalDerivativeType * m_ProposalDerivative;
-  unsigned int                     m_ProposalLength;
-  bool                             m_NormalizedShapeModel;
-  int                              m_ShapeModelCalculation;
-  double                           m_ShrinkageIntensity;
-  double                           m_BaseVariance;
-  double                           m_BaseStd;
-  mutable VnlVectorType            m_ProposalVector;
-  mutable VnlVectorType            m_MeanValues;
+  /** The transposed eigenvectors, so that the projection onto the eigenvectors and the back-projection
+   * are both computed over contiguous rows, and the inverse standard deviations of the proposal elements.
+   */
+  VnlMatrixType m_EigenVectorsTransposed;
+  VnlVectorType m_InverseStds;
+
+  std::vector<InputPointType> m_FixedPoints;
+
+  unsigned int          m_ProposalLength;
+  bool                  m_NormalizedShapeModel;
+  int                   m_ShapeModelCalculation;
+  double                m_ShrinkageIntensity;
+  double                m_BaseVariance;
+  double                m_BaseStd;
+  mutable VnlVectorType m_ProposalVector;
+  mutable VnlVectorType m_MeanValues;
 
   double m_CutOffValue;
   double m_CutOffSharpness;
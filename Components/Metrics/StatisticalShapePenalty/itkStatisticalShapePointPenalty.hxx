@@ -19,6 +19,9 @@
 #define itkStatisticalShapePointPenalty_hxx
 
 #include "itkStatisticalShapePointPenalty.h"
+
+#include <vnl/vnl_c_vector.h>
+
 #include <cmath>
 
 namespace itk
@@ -34,7 +37,6 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::StatisticalShapeP
   this->m_EigenVectors = nullptr;
   this->m_EigenValues = nullptr;
   this->m_EigenValuesRegularized = nullptr;
-  this->m_ProposalDerivative = nullptr;
   this->m_InverseCovarianceMatrix = nullptr;
 
   this->m_ShrinkageIntensityNeedsUpdate = true;
@@ -76,11 +78,6 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::~StatisticalShape
     delete this->m_EigenValuesRegularized;
     this->m_EigenValuesRegularized = nullptr;
   }
-  if (this->m_ProposalDerivative != nullptr)
-  {
-    delete this->m_ProposalDerivative;
-    this->m_ProposalDerivative = nullptr;
-  }
   if (this->m_InverseCovarianceMatrix != nullptr)
   {
     delete this->m_InverseCovarianceMatrix;
@@ -334,9 +331,79 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::Initialize(void)
       this->m_EigenValuesRegularized = nullptr;
   }
 
+  /** Copy the fixed points, so that they can be divided over the threads. */
+  this->m_FixedPoints.clear();
+  this->m_FixedPoints.reserve(this->GetFixedPointSet()->GetNumberOfPoints());
+  PointIterator pointItFixed = this->GetFixedPointSet()->GetPoints()->Begin();
+  PointIterator pointEnd = this->GetFixedPointSet()->GetPoints()->End();
+  for (; pointItFixed != pointEnd; ++pointItFixed)
+  {
+    this->m_FixedPoints.push_back(pointItFixed.Value());
+  }
+
+  this->PrecomputeProjectionMatrices(shapeLength);
+
 } // end Initialize()
 
 
+/**
+ * ******************* PrecomputeProjectionMatrices *******************
+ */
+
+template <class TFixedPointSet, class TMovingPointSet>
+void
+StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::PrecomputeProjectionMatrices(
+  const unsigned int shapeLength)
+{
+  switch (this->m_ShapeModelCalculation)
+  {
+    case 0: // full covariance
+    {
+      /** The value only depends on the symmetric part of the inverse covariance matrix. Symmetrizing it
+       * (which only removes round-off errors of the inversion) makes Sigma^-1 * diff the exact gradient.
+       */
+      if (this->m_InverseCovarianceMatrix != nullptr)
+      {
+        VnlMatrixType & inverseCovariance = *this->m_InverseCovarianceMatrix;
+        for (unsigned int i = 0; i < inverseCovariance.rows(); ++i)
+        {
+          for (unsigned int j = i + 1; j < inverseCovariance.cols(); ++j)
+          {
+            const CoordRepType average = 0.5 * (inverseCovariance(i, j) + inverseCovariance(j, i));
+            inverseCovariance(i, j) = average;
+            inverseCovariance(j, i) = average;
+          }
+        }
+      }
+      break;
+    }
+    case 1: // decomposed covariance (uniform regularization)
+    case 2: // decomposed scaled covariance (element specific regularization)
+    {
+      this->m_EigenVectorsTransposed = this->m_EigenVectors->transpose();
+      break;
+    }
+    default:
+      break;
+  }
+
+  /** The proposal elements are scaled by their inverse standard deviations by option 2. */
+  if (this->m_ShapeModelCalculation == 2)
+  {
+    const double centroidStds[3] = { this->m_CentroidXStd, this->m_CentroidYStd, this->m_CentroidZStd };
+
+    this->m_InverseStds.set_size(this->m_ProposalLength);
+    this->m_InverseStds.fill(1.0 / this->m_BaseStd);
+    for (unsigned int d = 0; d < Self::FixedPointSetDimension; ++d)
+    {
+      this->m_InverseStds[shapeLength + d] = 1.0 / centroidStds[d];
+    }
+    this->m_InverseStds[shapeLength + Self::FixedPointSetDimension] = 1.0 / this->m_SizeStd;
+  }
+
+} // end PrecomputeProjectionMatrices()
+
+
 /**
  * ******************* GetValue *******************
  */
@@ -354,12 +421,8 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::GetValue(
   }
 
   /** Initialize some variables */
-  // this->m_NumberOfPointsCounted = 0;
   MeasureType value = NumericTraits<MeasureType>::Zero;
 
-  // InputPointType movingPoint;
-  OutputPointType fixedPoint;
-
   /** Make sure the transform parameters are up to date. */
   this->SetTransformParameters(parameters);
 
@@ -369,22 +432,7 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::GetValue(
   /** Part 1:
    * - Copy point positions in proposal vector
    */
-
-  /** Create iterators. */
-  PointIterator pointItFixed = fixedPointSet->GetPoints()->Begin();
-  PointIterator pointEnd = fixedPointSet->GetPoints()->End();
-
-  unsigned int vertexindex = 0;
-  /** Loop over the corresponding points. */
-  while (pointItFixed != pointEnd)
-  {
-    fixedPoint = pointItFixed.Value();
-    this->FillProposalVector(fixedPoint, vertexindex);
-
-    this->m_NumberOfPointsCounted++;
-    ++pointItFixed;
-    vertexindex += Self::FixedPointSetDimension;
-  } // end loop over all corresponding points
+  this->FillProposalVector();
 
   if (this->m_NormalizedShapeModel)
   {
@@ -405,10 +453,7 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::GetValue(
   }
 
   VnlVectorType differenceVector;
-  VnlVectorType centerrotated;
-  VnlVectorType eigrot;
-
-  this->CalculateValue(value, differenceVector, centerrotated, eigrot);
+  this->CalculateValue(value, differenceVector, nullptr);
 
   return value;
 
@@ -454,43 +499,20 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::GetValueAndDeriva
   }
 
   /** Initialize some variables */
-  // this->m_NumberOfPointsCounted = 0;
   value = NumericTraits<MeasureType>::Zero;
   derivative = DerivativeType(this->GetNumberOfParameters());
   derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
 
-  // InputPointType movingPoint;
-  OutputPointType fixedPoint;
-
   /** Make sure the transform parameters are up to date. */
   this->SetTransformParameters(parameters);
 
   const unsigned int shapeLength = Self::FixedPointSetDimension * fixedPointSet->GetNumberOfPoints();
-
   this->m_ProposalVector.set_size(this->m_ProposalLength);
-  this->m_ProposalDerivative = new ProposalDerivativeType(this->GetNumberOfParameters(), nullptr);
 
   /** Part 1:
    * - Copy point positions in proposal vector
-   * - Copy point derivatives in proposal derivative vector
    */
-
-  /** Create iterators. */
-  PointIterator pointItFixed = fixedPointSet->GetPoints()->Begin();
-  PointIterator pointEnd = fixedPointSet->GetPoints()->End();
-
-  unsigned int vertexindex = 0;
-  /** Loop over the corresponding points. */
-  while (pointItFixed != pointEnd)
-  {
-    fixedPoint = pointItFixed.Value();
-    this->FillProposalVector(fixedPoint, vertexindex);
-    this->FillProposalDerivative(fixedPoint, vertexindex);
-
-    this->m_NumberOfPointsCounted++;
-    ++pointItFixed;
-    vertexindex += Self::FixedPointSetDimension;
-  } // end loop over all corresponding points
+  this->FillProposalVector();
 
   if (this->m_NormalizedShapeModel)
   {
@@ -498,52 +520,40 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::GetValueAndDeriva
      * - Calculate shape centroid
      * - put centroid values in proposal
      * - update proposal vector with aligned shape
-     * - Calculate centroid derivatives and update proposal derivative vectors
-     * - put centroid derivatives values in proposal derivatives
-     * - update proposal derivatives
      */
     this->UpdateCentroidAndAlignProposalVector(shapeLength);
-    this->UpdateCentroidAndAlignProposalDerivative(shapeLength);
 
     /** Part 3:
      * - Calculate l2-norm from aligned shapes
      * - put l2-norm value in proposal vector
      * - update proposal vector with size normalized shape
-     * - Calculate l2-norm derivatice from updated proposal vector
-     * - put l2-norm derivative value in proposal derivative vectors
-     * - update proposal derivatives
      */
     this->UpdateL2(shapeLength);
-    this->UpdateL2AndNormalizeProposalDerivative(shapeLength);
     this->NormalizeProposalVector(shapeLength);
 
   } // end if(m_NormalizedShapeModel)
 
-  // TODO this declaration instantiates a zero sized vector, but it will be reassigned anyways.
+  /** Part 4:
+   * - Calculate the value and the gradient with respect to the proposal vector
+   */
   VnlVectorType differenceVector;
-  VnlVectorType centerrotated;
-  VnlVectorType eigrot;
-
-  this->CalculateValue(value, differenceVector, centerrotated, eigrot);
+  VnlVectorType proposalGradient;
+  this->CalculateValue(value, differenceVector, &proposalGradient);
 
   if (value != 0.0)
   {
-    this->CalculateDerivative(derivative, value, differenceVector, centerrotated, eigrot, shapeLength);
-  }
-  else
-  {
-    typename ProposalDerivativeType::iterator proposalDerivativeIt = this->m_ProposalDerivative->begin();
-    typename ProposalDerivativeType::iterator proposalDerivativeEnd = this->m_ProposalDerivative->end();
-    for (; proposalDerivativeIt != proposalDerivativeEnd; ++proposalDerivativeIt)
+    /** Part 5:
+     * - Back-propagate the gradient through the size normalization and the centroid alignment
+     * - multiply the gradient by the Jacobians of the transformed points
+     */
+    proposalGradient /= value;
+    if (this->m_NormalizedShapeModel)
     {
-      if (*proposalDerivativeIt != nullptr)
-      {
-        delete (*proposalDerivativeIt);
-      }
+      this->BackPropagateProposalGradient(proposalGradient, shapeLength);
     }
+    this->CalculateDerivative(derivative, proposalGradient);
+    this->CalculateCutOffDerivative(derivative, value);
   }
-  delete this->m_ProposalDerivative;
-  this->m_ProposalDerivative = nullptr;
 
   this->CalculateCutOffValue(value);
 
@@ -551,71 +561,51 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::GetValueAndDeriva
 
 
 /**
- * ******************* FillProposalVector *******************
+ * ******************* MultiplyMatrixVector *******************
  */
 
 template <class TFixedPointSet, class TMovingPointSet>
 void
-StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::FillProposalVector(const OutputPointType & fixedPoint,
-                                                                                  const unsigned int vertexindex) const
+StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::MultiplyMatrixVector(const VnlMatrixType & matrix,
+                                                                                    const VnlVectorType & vector,
+                                                                                    VnlVectorType &       result) const
 {
-  OutputPointType mappedPoint;
-  /** Get the current corresponding points. */
-  mappedPoint = this->m_Transform->TransformPoint(fixedPoint);
+  result.set_size(matrix.rows());
+  this->ParallelizeOverRanges(
+    matrix.rows(), [&matrix, &vector, &result](const SizeValueType begin, const SizeValueType end, ThreadIdType) {
+      for (SizeValueType row = begin; row < end; ++row)
+      {
+        result[row] = vnl_c_vector<CoordRepType>::dot_product(matrix[row], vector.data_block(), matrix.cols());
+      }
+    });
 
-  /** Copy n-D coordinates into big Shape vector. Aligning the centroids is done later. */
-  for (unsigned int d = 0; d < Self::FixedPointSetDimension; ++d)
-  {
-    this->m_ProposalVector[vertexindex + d] = mappedPoint[d];
-  }
-} // end FillProposalVector()
+} // end MultiplyMatrixVector()
 
 
 /**
- * ******************* FillProposalDerivative *******************
+ * ******************* FillProposalVector *******************
  */
 
 template <class TFixedPointSet, class TMovingPointSet>
 void
-StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::FillProposalDerivative(
-  const OutputPointType & fixedPoint,
-  const unsigned int      vertexindex) const
+StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::FillProposalVector(void) const
 {
-  /**
-   * A (column) vector is constructed for each mu, only if that mu affects the shape penalty.
-   * I.e. if there is at least one point of the mesh with non-zero derivatives,
-   * a full column vector is instantiated (which can contain zeros for many other points)
-   *
-   * m_ProposalDerivative is a container with either full shape-vector-sized derivative vectors or NULL-s. Example:
-   *
-   * mu1: [ [ dx1/dmu1 , dy1/dmu1 , dz1/dmu1 ] , [ 0 , 0 , 0 ] , [ dx3/dmu1 , dy3/dmu1 , dz3/dmu1 ] , [...] ]^T
-   * mu2: Null
-   * mu3: [ [ 0 , 0 , 0 ] , [ dx2/dmu3 , dy2/dmu3 , dz2/dmu3 ] , [ dx3/dmu3 , dy3/dmu3 , dz3/dmu3 ] , [...] ]^T
-   *
+  /** Transform all points, and copy their n-D coordinates into the big shape vector.
+   * Aligning the centroids is done later.
    */
+  this->ParallelizeOverRanges(
+    this->m_FixedPoints.size(), [this](const SizeValueType begin, const SizeValueType end, ThreadIdType) {
+      for (SizeValueType pointNumber = begin; pointNumber < end; ++pointNumber)
+      {
+        const OutputPointType mappedPoint = this->m_Transform->TransformPoint(this->m_FixedPoints[pointNumber]);
+        for (unsigned int d = 0; d < Self::FixedPointSetDimension; ++d)
+        {
+          this->m_ProposalVector[pointNumber * Self::FixedPointSetDimension + d] = mappedPoint[d];
+        }
+      }
+    });
 
-  NonZeroJacobianIndicesType nzji(this->m_Transform->GetNumberOfNonZeroJacobianIndices());
-
-  /** Get the TransformJacobian dT/dmu. */
-  TransformJacobianType jacobian;
-  this->m_Transform->GetJacobian(fixedPoint, jacobian, nzji);
-
-  for (unsigned int i = 0; i < nzji.size(); ++i)
-  {
-    const unsigned int mu = nzji[i];
-    if ((*this->m_ProposalDerivative)[mu] == nullptr)
-    {
-      /** Create the big column vector if it does not yet exist for this mu*/
-      (*this->m_ProposalDerivative)[mu] = new VnlVectorType(this->m_ProposalLength, 0.0);
-      // memory will be freed in CalculateDerivative()
-    }
-
-    /** The column vector exists for this mu, so copy the jacobians for this point into the big vector. */
-    for (unsigned int d = 0; d < Self::FixedPointSetDimension; ++d)
-    {
-      (*(*this->m_ProposalDerivative)[mu])[vertexindex + d] = jacobian.get_column(i)[d];
-    }
-  }
+  this->m_NumberOfPointsCounted = this->m_FixedPoints.size();
 
 } // end FillProposalVector()
 
@@ -656,44 +646,6 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::UpdateCentroidAnd
 } // end UpdateCentroidAndAlignProposalVector()
 
 
-/**
- * ******************* UpdateCentroidAndAlignProposalDerivative *******************
- */
-
-template <class TFixedPointSet, class TMovingPointSet>
-void
-StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::UpdateCentroidAndAlignProposalDerivative(
-  const unsigned int shapeLength) const
-{
-  typename ProposalDerivativeType::iterator proposalDerivativeIt = m_ProposalDerivative->begin();
-  typename ProposalDerivativeType::iterator proposalDerivativeEnd = m_ProposalDerivative->end();
-  while (proposalDerivativeIt != proposalDerivativeEnd)
-  {
-    if (*proposalDerivativeIt != nullptr)
-    {
-      for (unsigned int d = 0; d < Self::FixedPointSetDimension; ++d)
-      {
-        double & centroid_dDerivative = (**proposalDerivativeIt)[shapeLength + d];
-        centroid_dDerivative = 0; // initialize accumulators to zero
-
-        for (unsigned int index = 0; index < shapeLength; index += Self::FixedPointSetDimension)
-        {
-          centroid_dDerivative += (**proposalDerivativeIt)[index + d]; // sum all x derivatives
-        }
-
-        centroid_dDerivative /= this->GetFixedPointSet()->GetNumberOfPoints(); // divide sum to get average
-
-        for (unsigned int index = 0; index < shapeLength; index += Self::FixedPointSetDimension)
-        {
-          (**proposalDerivativeIt)[index + d] -= centroid_dDerivative; // subtract average
-        }
-      }
-    }
-    ++proposalDerivativeIt;
-  }
-} // end UpdateCentroidAndAlignProposalDerivative()
-
-
 /**
  * ******************* UpdateL2 *******************
  */
@@ -737,57 +689,16 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::NormalizeProposal
 } // end NormalizeProposalVector()
 
 
-/**
- * ******************* UpdateL2AndNormalizeProposalDerivative *******************
- */
-
-template <class TFixedPointSet, class TMovingPointSet>
-void
-StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::UpdateL2AndNormalizeProposalDerivative(
-  const unsigned int shapeLength) const
-{
-  double & l2norm = this->m_ProposalVector[shapeLength + Self::FixedPointSetDimension];
-
-  typename ProposalDerivativeType::iterator proposalDerivativeIt = this->m_ProposalDerivative->begin();
-  typename ProposalDerivativeType::iterator proposalDerivativeEnd = this->m_ProposalDerivative->end();
-
-  while (proposalDerivativeIt != proposalDerivativeEnd)
-  {
-    if (*proposalDerivativeIt != nullptr)
-    {
-      double & l2normDerivative = (**proposalDerivativeIt)[shapeLength + Self::FixedPointSetDimension];
-      l2normDerivative = 0; // initialize to zero
-      // loop over all shape coordinates of the aligned shape
-      for (unsigned int index = 0; index < shapeLength; ++index)
-      {
-        l2normDerivative += this->m_ProposalVector[index] * (**proposalDerivativeIt)[index];
-      }
-      l2normDerivative /= (l2norm * sqrt((double)(this->GetFixedPointSet()->GetNumberOfPoints())));
-
-      // loop over all shape coordinates of the aligned shape
-      for (unsigned int index = 0; index < shapeLength; ++index)
-      {
-        // update normalized shape derivatives
-        (**proposalDerivativeIt)[index] = (**proposalDerivativeIt)[index] / l2norm -
-                                          this->m_ProposalVector[index] * l2normDerivative / (l2norm * l2norm);
-      }
-    }
-    ++proposalDerivativeIt;
-  }
-
-} // end UpdateL2AndNormalizeProposalDerivative()
-
-
 /**
  * ******************* CalculateValue *******************
  */
 
 template <class TFixedPointSet, class TMovingPointSet>
 void
-StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::CalculateValue(MeasureType &   value,
-                                                                              VnlVectorType & differenceVector,
-                                                                              VnlVectorType & centerrotated,
-                                                                              VnlVectorType & eigrot) const
+StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::CalculateValue(
+  MeasureType &   value,
+  VnlVectorType & differenceVector,
+  VnlVectorType * weightedDifferenceVector) const
 {
   differenceVector = this->m_ProposalVector - *m_MeanVector;
 
@@ -795,62 +706,129 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::CalculateValue(Me
   {
     case 0: // full covariance
     {
-      value = sqrt(bracket(differenceVector, *this->m_InverseCovarianceMatrix, differenceVector));
-      break;
-    }
-    case 1: // decomposed covariance (uniform regularization)
-    {
-      centerrotated = differenceVector * (*m_EigenVectors);                /** diff^T * V */
-      eigrot = element_quotient(centerrotated, *m_EigenValuesRegularized); /** diff^T * V * Lambda^-1 */
-      if (this->m_ShrinkageIntensity != 0)
+      /** innerproduct diff^T * Sigma^-1 * diff */
+      VnlVectorType inverseCovarianceTimesDifference;
+      this->MultiplyMatrixVector(*this->m_InverseCovarianceMatrix, differenceVector, inverseCovarianceTimesDifference);
+      value = sqrt(dot_product(differenceVector, inverseCovarianceTimesDifference));
+      if (weightedDifferenceVector != nullptr)
       {
-        /** innerproduct diff^T * V * Lambda^-1 * V^T * diff  +  1/(sigma_0*Beta)* diff^T*diff*/
-        value = sqrt(dot_product(eigrot, centerrotated) + dot_product(differenceVector, differenceVector) /
-                                                            (this->m_ShrinkageIntensity * this->m_BaseVariance));
-      }
-      else
-      {
-        /** innerproduct diff^T * V * Lambda^-1 * V^T * diff*/
-        value = sqrt(dot_product(eigrot, centerrotated));
+        weightedDifferenceVector->swap(inverseCovarianceTimesDifference);
       }
       break;
     }
+    case 1: // decomposed covariance (uniform regularization)
     case 2: // decomposed scaled covariance (element specific regularization)
     {
-      const unsigned int               shapeLength = this->m_ProposalLength - Self::FixedPointSetDimension - 1;
-      typename VnlVectorType::iterator diffElementIt = differenceVector.begin();
-      for (unsigned int diffElementIndex = 0; diffElementIndex < shapeLength; ++diffElementIndex, ++diffElementIt)
+      /** Option 2 evaluates with the EigenValues and EigenVectors of the scaled CovarianceMatrix. */
+      if (this->m_ShapeModelCalculation == 2)
       {
-        *diffElementIt /= this->m_BaseStd;
+        differenceVector = element_product(differenceVector, this->m_InverseStds);
       }
-      differenceVector[shapeLength] /= this->m_CentroidXStd;
-      differenceVector[shapeLength + 1] /= this->m_CentroidYStd;
-      differenceVector[shapeLength + 2] /= this->m_CentroidZStd;
-      differenceVector[shapeLength + 3] /= this->m_SizeStd;
 
-      centerrotated = differenceVector * (*this->m_EigenVectors);                /** diff^T * V */
-      eigrot = element_quotient(centerrotated, *this->m_EigenValuesRegularized); /** diff^T * V * Lambda^-1 */
+      /** For option 1, the regularization is scaled by the base variance. */
+      const double shrinkage =
+        this->m_ShrinkageIntensity * ((this->m_ShapeModelCalculation == 1) ? this->m_BaseVariance : 1.0);
+
+      VnlVectorType centerrotated;
+      this->MultiplyMatrixVector(this->m_EigenVectorsTransposed, differenceVector, centerrotated); /** V^T * diff */
+      const VnlVectorType eigrot =
+        element_quotient(centerrotated, *this->m_EigenValuesRegularized); /** diff^T * V * Lambda^-1 */
+
       if (this->m_ShrinkageIntensity != 0)
       {
-        /** innerproduct diff^T * ~V * I * ~V^T * diff  +  1/(Beta)* diff^T*diff*/
-        value =
-          sqrt(dot_product(eigrot, centerrotated) + differenceVector.squared_magnitude() / this->m_ShrinkageIntensity);
+        /** innerproduct diff^T * V * Lambda^-1 * V^T * diff  +  1/(sigma_0*Beta)* diff^T*diff*/
+        value = sqrt(dot_product(eigrot, centerrotated) + differenceVector.squared_magnitude() / shrinkage);
       }
       else
       {
-        /** innerproduct diff^T * V * I * V^T * diff*/
+        /** innerproduct diff^T * V * Lambda^-1 * V^T * diff*/
         value = sqrt(dot_product(eigrot, centerrotated));
       }
 
+      if (weightedDifferenceVector != nullptr)
+      {
+        /** A single low-rank back-projection V * Lambda^-1 * V^T * diff, instead of projecting
+         * the derivative of the proposal vector with respect to each parameter.
+         */
+        this->MultiplyMatrixVector(*this->m_EigenVectors, eigrot, *weightedDifferenceVector);
+        if (this->m_ShrinkageIntensity != 0)
+        {
+          *weightedDifferenceVector += differenceVector / shrinkage;
+        }
+        if (this->m_ShapeModelCalculation == 2)
+        {
+          *weightedDifferenceVector = element_product(*weightedDifferenceVector, this->m_InverseStds);
+        }
+      }
       break;
     }
     default:
+    {
+      if (weightedDifferenceVector != nullptr)
+      {
+        weightedDifferenceVector->set_size(this->m_ProposalLength);
+        weightedDifferenceVector->fill(0.0);
+      }
       break;
+    }
   }
 
 } // end CalculateValue()
 
 
+/**
+ * ******************* BackPropagateProposalGradient *******************
+ */
+
+template <class TFixedPointSet, class TMovingPointSet>
+void
+StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::BackPropagateProposalGradient(
+  VnlVectorType &    proposalGradient,
+  const unsigned int shapeLength) const
+{
+  /** The proposal vector contains the normalized shape n = a / l, the centroid c and the l2-norm l,
+   * computed from the aligned shape a = x - c. Their derivatives with respect to the point coordinates x
+   * (as computed before by the proposal derivatives) are:
+   *   dl = a^T * da / ( l * N ),  dn = da / l - a * dl / l^2,  dc_d = mean_i( dx_(i,d) ),  da = dx - dc,
+   * since l = sqrt( a^T * a / N ). Applying the transposes of these linear maps to the gradient g yields the
+   * gradient with respect to x.
+   */
+  const double numberOfPoints = static_cast<double>(this->GetFixedPointSet()->GetNumberOfPoints());
+  const double l2norm = this->m_ProposalVector[shapeLength + Self::FixedPointSetDimension];
+
+  /** Through the size normalization: h = g_n / l + ( g_l - g_n^T * a / l^2 ) * a / ( l * N ). */
+  double gradientDotNormalizedShape = 0.0;
+  for (unsigned int index = 0; index < shapeLength; ++index)
+  {
+    gradientDotNormalizedShape += proposalGradient[index] * this->m_ProposalVector[index];
+  }
+  const double l2normGradient = proposalGradient[shapeLength + Self::FixedPointSetDimension] -
+                                gradientDotNormalizedShape / l2norm; /** g_l - g_n^T * a / l^2, with a = n * l */
+  const double alignedShapeFactor = l2normGradient / numberOfPoints;
+
+  for (unsigned int index = 0; index < shapeLength; ++index)
+  {
+    proposalGradient[index] = proposalGradient[index] / l2norm + alignedShapeFactor * this->m_ProposalVector[index];
+  }
+
+  /** Through the centroid alignment: q_(i,d) = h_(i,d) + ( g_c_d - sum_j h_(j,d) ) / N. */
+  for (unsigned int d = 0; d < Self::FixedPointSetDimension; ++d)
+  {
+    double sum = 0.0;
+    for (unsigned int index = d; index < shapeLength; index += Self::FixedPointSetDimension)
+    {
+      sum += proposalGradient[index];
+    }
+    const double correction = (proposalGradient[shapeLength + d] - sum) / numberOfPoints;
+    for (unsigned int index = d; index < shapeLength; index += Self::FixedPointSetDimension)
+    {
+      proposalGradient[index] += correction;
+    }
+  }
+
+} // end BackPropagateProposalGradient()
+
+
 /**
  * ******************* CalculateDerivative *******************
  */
@@ -859,91 +837,46 @@ template <class TFixedPointSet, class TMovingPointSet>
 void
 StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::CalculateDerivative(
   DerivativeType &      derivative,
-  const MeasureType &   value,
-  const VnlVectorType & differenceVector,
-  const VnlVectorType & centerrotated,
-  const VnlVectorType & eigrot,
-  const unsigned int    shapeLength) const
+  const VnlVectorType & shapeGradient) const
 {
-  typename ProposalDerivativeType::iterator proposalDerivativeIt = this->m_ProposalDerivative->begin();
-  typename ProposalDerivativeType::iterator proposalDerivativeEnd = this->m_ProposalDerivative->end();
+  /** Each work unit adds the products of the gradient and the Jacobians of a range of points to its own derivative.
+   * The Jacobians are only computed here, so that they are never stored for all points at once.
+   */
+  const bool useMultiThread = this->UsesPerThreadVariables();
 
-  typename DerivativeType::iterator derivativeIt = derivative.begin();
+  this->ParallelizeOverRanges(
+    this->m_FixedPoints.size(),
+    [this, &derivative, &shapeGradient, useMultiThread](
+      const SizeValueType begin, const SizeValueType end, const ThreadIdType threadId) {
+      DerivativeType & threadDerivative =
+        useMultiThread ? this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Derivative : derivative;
 
-  for (; proposalDerivativeIt != proposalDerivativeEnd; ++proposalDerivativeIt, ++derivativeIt)
-  {
-    if (*proposalDerivativeIt != nullptr)
-    {
-      switch (this->m_ShapeModelCalculation)
+      NonZeroJacobianIndicesType nzji(this->m_Transform->GetNumberOfNonZeroJacobianIndices());
+      TransformJacobianType      jacobian;
+
+      for (SizeValueType pointNumber = begin; pointNumber < end; ++pointNumber)
       {
-        case 0: // full covariance
-        {
-          /**innerproduct diff^T * Sigma^-1 * d/dmu (diff), where iterated over mu-s*/
-          *derivativeIt = bracket(differenceVector, *m_InverseCovarianceMatrix, (**proposalDerivativeIt)) / value;
-          this->CalculateCutOffDerivative(*derivativeIt, value);
-          break;
-        }
-        case 1: // decomposed covariance (uniform regularization)
-        {
-          if (this->m_ShrinkageIntensity != 0)
-          {
-            /** Innerproduct diff^T * V * Lambda^-1 * V^T * d/dmu(diff)
-             * + 1/(Beta*sigma_0^2)*diff^T* d/dmu(diff), where iterated over mu-s
-             */
-            *derivativeIt = (dot_product(eigrot, this->m_EigenVectors->transpose() * (**proposalDerivativeIt)) +
-                             dot_product(differenceVector, **proposalDerivativeIt) /
-                               (this->m_ShrinkageIntensity * this->m_BaseVariance)) /
-                            value;
-            this->CalculateCutOffDerivative(*derivativeIt, value);
-          }
-          else // m_ShrinkageIntensity==0
-          {
-            /**innerproduct diff^T * V * Lambda^-1 * V^T * d/dmu (diff), where iterated over mu-s*/
-            *derivativeIt = (dot_product(eigrot, this->m_EigenVectors->transpose() * (**proposalDerivativeIt))) / value;
-            this->CalculateCutOffDerivative(*derivativeIt, value);
-          }
-          break;
-        }
-        case 2: // decomposed scaled covariance (element specific regularization)
+        /** Get the TransformJacobian dT/dmu. */
+        this->m_Transform->GetJacobian(this->m_FixedPoints[pointNumber], jacobian, nzji);
+
+        const CoordRepType * pointGradient = shapeGradient.data_block() + pointNumber * Self::FixedPointSetDimension;
+        for (unsigned int i = 0; i < nzji.size(); ++i)
         {
-          // first scale proposalDerivatives with their sigma's in order to evaluate
-          // with the EigenValues and EigenVectors of the scaled CovarianceMatrix
-          typename VnlVectorType::iterator propDerivElementIt = (*proposalDerivativeIt)->begin();
-          for (unsigned int propDerivElementIndex = 0; propDerivElementIndex < shapeLength;
-               ++propDerivElementIndex, ++propDerivElementIt)
-          {
-            (*propDerivElementIt) /= this->m_BaseStd;
-          }
-          (**proposalDerivativeIt)[shapeLength] /= this->m_CentroidXStd;
-          (**proposalDerivativeIt)[shapeLength + 1] /= this->m_CentroidYStd;
-          (**proposalDerivativeIt)[shapeLength + 2] /= this->m_CentroidZStd;
-          (**proposalDerivativeIt)[shapeLength + 3] /= this->m_SizeStd;
-          if (this->m_ShrinkageIntensity != 0)
-          {
-            /** innerproduct diff^T * V * Lambda^-1 * V^T * d/dmu(diff)
-             * + 1/(Beta*sigma_0^2)*diff^T* d/dmu(diff), where iterated over mu-s
-             */
-            *derivativeIt = (dot_product(eigrot, this->m_EigenVectors->transpose() * (**proposalDerivativeIt)) +
-                             dot_product(differenceVector, **proposalDerivativeIt) / this->m_ShrinkageIntensity) /
-                            value;
-            this->CalculateCutOffDerivative(*derivativeIt, value);
-          }
-          else // m_ShrinkageIntensity==0
+          DerivativeValueType sum = NumericTraits<DerivativeValueType>::ZeroValue();
+          for (unsigned int d = 0; d < Self::FixedPointSetDimension; ++d)
           {
-            /**innerproduct diff^T * V * Lambda^-1 * V^T * d/dmu (diff), where iterated over mu-s*/
-            *derivativeIt = (dot_product(eigrot, this->m_EigenVectors->transpose() * (**proposalDerivativeIt))) / value;
-            this->CalculateCutOffDerivative(*derivativeIt, value);
+            sum += pointGradient[d] * jacobian(d, i);
           }
-          break;
+          threadDerivative[nzji[i]] += sum;
         }
-        default:
-        {
-        }
-
-          delete (*proposalDerivativeIt);
-          // nzjacs++;
       }
-    }
+    });
+
+  if (useMultiThread)
+  {
+    MeasureType dummyValue = NumericTraits<MeasureType>::Zero;
+    this->AccumulatePerThreadVariables(dummyValue, &derivative);
+    this->m_NumberOfPointsCounted = this->m_FixedPoints.size();
   }
 
 } // end CalculateDerivative()
@@ -973,12 +906,12 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::CalculateCutOffVa
 template <class TFixedPointSet, class TMovingPointSet>
 void
 StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::CalculateCutOffDerivative(
-  typename DerivativeType::element_type & derivativeElement,
-  const MeasureType &                     value) const
+  DerivativeType &    derivative,
+  const MeasureType & value) const
 {
   if (this->m_CutOffValue > 0.0)
   {
-    derivativeElement *= 1.0 / (1.0 + std::exp(this->m_CutOffSharpness * (this->m_CutOffValue - value)));
+    derivative *= 1.0 / (1.0 + std::exp(this->m_CutOffSharpness * (this->m_CutOffValue - value)));
   }
 } // end CalculateCutOffDerivative()
 
@@ -24,6 +24,7 @@
 #include "itkImageRandomCoordinateSampler.h"
 #include "itkNearestNeighborInterpolateImageFunction.h"
 #include "itkExtractImageFilter.h"
+#include <vnl/vnl_diag_matrix.h>
 
 namespace itk
 {
@@ -93,6 +94,12 @@ public:
   using typename Superclass::FixedImageLimiterOutputType;
   using typename Superclass::MovingImageLimiterOutputType;
   using typename Superclass::MovingImageDerivativeScalesType;
+  typedef typename DerivativeType::ValueType DerivativeValueType;
+  using typename Superclass::ThreaderType;
+  using typename Superclass::ThreadInfoType;
+
+  typedef vnl_matrix<RealType>            MatrixType;
+  typedef vnl_matrix<DerivativeValueType> DerivativeMatrixType;
 
   /** The fixed image dimension. */
   itkStaticConstMacro(FixedImageDimension, unsigned int, FixedImageType::ImageDimension);
@@ -109,6 +116,11 @@ public:
   GetDerivative(const TransformParametersType & parameters, DerivativeType & derivative) const override;
 
   /** Get value and derivatives for multiple valued optimizers. */
+  void
+  GetValueAndDerivativeSingleThreaded(const TransformParametersType & parameters,
+                                      MeasureType &                   Value,
+                                      DerivativeType &                Derivative) const;
+
   void
   GetValueAndDerivative(const TransformParametersType & parameters,
                         MeasureType &                   Value,
@@ -123,7 +135,7 @@ public:
 
 protected:
   SumOfPairwiseCorrelationCoefficientsMetric();
-  ~SumOfPairwiseCorrelationCoefficientsMetric() override = default;
+  ~SumOfPairwiseCorrelationCoefficientsMetric() override;
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
 
@@ -142,6 +154,7 @@ protected:
   using typename Superclass::CentralDifferenceGradientFilterType;
   using typename Superclass::MovingImageDerivativeType;
   using typename Superclass::NonZeroJacobianIndicesType;
+  using typename Superclass::RandomGeneratorType;
 
   /** Computes the innerproduct of transform Jacobian with moving image gradient.
    * The results are stored in imageJacobian, which is supposed
@@ -151,6 +164,75 @@ protected:
                                         const MovingImageDerivativeType & movingImageDerivative,
                                         DerivativeType &                  imageJacobian) const override;
 
+  struct SumOfPairwiseCorrelationsMultiThreaderParameterType
+  {
+    Self * m_Metric;
+  };
+
+  SumOfPairwiseCorrelationsMultiThreaderParameterType m_SumOfPairwiseCorrelationsThreaderParameters;
+
+  struct SumOfPairwiseCorrelationsGetSamplesPerThreadStruct
+  {
+    SizeValueType                    st_NumberOfPixelsCounted;
+    MatrixType                       st_DataBlock;
+    std::vector<FixedImagePointType> st_ApprovedSamples;
+    DerivativeType                   st_Derivative;
+    vnl_vector<RealType>             st_ColumnSum;
+    MatrixType                       st_Covariance;
+  };
+
+  itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
+               SumOfPairwiseCorrelationsGetSamplesPerThreadStruct,
+               PaddedSumOfPairwiseCorrelationsGetSamplesPerThreadStruct);
+
+  itkAlignedTypedef(ITK_CACHE_LINE_ALIGNMENT,
+                    PaddedSumOfPairwiseCorrelationsGetSamplesPerThreadStruct,
+                    AlignedSumOfPairwiseCorrelationsGetSamplesPerThreadStruct);
+
+  mutable AlignedSumOfPairwiseCorrelationsGetSamplesPerThreadStruct * m_SumOfPairwiseCorrelationsPerThreadVariables;
+  mutable ThreadIdType m_SumOfPairwiseCorrelationsPerThreadVariablesSize;
+
+  /** Get the samples and derivative contributions for each thread. */
+  inline void
+  ThreadedGetSamples(ThreadIdType threadID);
+
+  inline void
+  ThreadedComputeCovariance(ThreadIdType threadID);
+
+  inline void
+  ThreadedComputeDerivative(ThreadIdType threadID);
+
+  /** Gather the samples and derivatives from all threads. */
+  inline void
+  AfterThreadedGetSamples(MeasureType & value) const;
+
+  inline void
+  AfterThreadedComputeDerivative(DerivativeType & derivative) const;
+
+  /** Helper function to launch the threads. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  GetSamplesThreaderCallback(void * arg);
+
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeCovarianceThreaderCallback(void * arg);
+
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeDerivativeThreaderCallback(void * arg);
+
+  /** Helper functions to launch the threads. */
+  void
+  LaunchGetSamplesThreaderCallback(void) const;
+
+  void
+  LaunchComputeCovarianceThreaderCallback(void) const;
+
+  void
+  LaunchComputeDerivativeThreaderCallback(void) const;
+
+  /** Initialize some multi-threading related parameters. */
+  void
+  InitializeThreadingParameters(void) const override;
+
 private:
   SumOfPairwiseCorrelationCoefficientsMetric(const Self &) = delete;
   void
@@ -172,6 +254,20 @@ private:
 
   /** Bool to indicate if the transform used is a stacktransform. Set by elx files. */
   bool m_TransformIsStackTransform{ true };
+
+  /** Slowest varying dimension and its size, set by Initialize(). */
+  unsigned int m_G{ 0 };
+  unsigned int m_LastDimIndex{ 0 };
+
+  /** Matrices, needed for derivative calculation */
+  mutable std::vector<unsigned int>            m_PixelStartIndex;
+  mutable MatrixType                           m_Atmm;
+  mutable vnl_vector<RealType>                 m_ColumnMean;
+  mutable DerivativeMatrixType                 m_KAtZscore;
+  mutable DerivativeMatrixType                 m_KAtZscoreAmm;
+  mutable vnl_diag_matrix<RealType>            m_S;
+  mutable vnl_diag_matrix<DerivativeValueType> m_dSdmu_part1;
+  mutable RealType                             m_KFrobeniusNorm{ 0.0 };
 };
 
 } // end namespace itk
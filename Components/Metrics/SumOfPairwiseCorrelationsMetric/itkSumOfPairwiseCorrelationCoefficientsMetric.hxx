@@ -20,7 +20,6 @@
 
 #include "itkSumOfPairwiseCorrelationCoefficientsMetric.h"
 
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include <vnl/algo/vnl_matrix_update.h>
 #include "itkImage.h"
 #include <numeric>
@@ -37,9 +36,27 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::SumOfPair
   this->SetUseImageSampler(true);
   this->SetUseFixedImageLimiter(false);
   this->SetUseMovingImageLimiter(false);
+
+  // Multi-threading structs
+  this->m_SumOfPairwiseCorrelationsPerThreadVariables = nullptr;
+  this->m_SumOfPairwiseCorrelationsPerThreadVariablesSize = 0;
+
+  /** Initialize the m_SumOfPairwiseCorrelationsThreaderParameters. */
+  this->m_SumOfPairwiseCorrelationsThreaderParameters.m_Metric = this;
 } // end constructor
 
 
+/**
+ * ******************* Destructor *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::~SumOfPairwiseCorrelationCoefficientsMetric()
+{
+  delete[] this->m_SumOfPairwiseCorrelationsPerThreadVariables;
+} // end Destructor
+
+
 /**
  * ******************* Initialize *******************
  */
@@ -50,6 +67,10 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::Initializ
 {
   /** Initialize transform, interpolator, etc. */
   Superclass::Initialize();
+
+  /** Retrieve slowest varying dimension and its size. */
+  this->m_LastDimIndex = this->GetFixedImage()->GetImageDimension() - 1;
+  this->m_G = this->GetFixedImage()->GetLargestPossibleRegion().GetSize(this->m_LastDimIndex);
 } // end Initialize()
 
 
@@ -65,6 +86,38 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::PrintSelf
 } // end PrintSelf()
 
 
+/**
+ * ********************* InitializeThreadingParameters ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::InitializeThreadingParameters(void) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+
+  /** Only resize the array of structs when needed. */
+  if (this->m_SumOfPairwiseCorrelationsPerThreadVariablesSize != numberOfThreads)
+  {
+    delete[] this->m_SumOfPairwiseCorrelationsPerThreadVariables;
+    this->m_SumOfPairwiseCorrelationsPerThreadVariables =
+      new AlignedSumOfPairwiseCorrelationsGetSamplesPerThreadStruct[numberOfThreads];
+    this->m_SumOfPairwiseCorrelationsPerThreadVariablesSize = numberOfThreads;
+  }
+
+  /** Some initialization. */
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    this->m_SumOfPairwiseCorrelationsPerThreadVariables[i].st_NumberOfPixelsCounted =
+      NumericTraits<SizeValueType>::Zero;
+    this->m_SumOfPairwiseCorrelationsPerThreadVariables[i].st_Derivative.SetSize(this->GetNumberOfParameters());
+  }
+
+  this->m_PixelStartIndex.resize(numberOfThreads);
+
+} // end InitializeThreadingParameters()
+
+
 /**
  * ******************* SampleRandom *******************
  */
@@ -78,9 +131,8 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::SampleRan
   /** Empty list of last dimension positions. */
   numbers.clear();
 
-  /** Initialize random number generator. */
-  Statistics::MersenneTwisterRandomVariateGenerator::Pointer randomGenerator =
-    Statistics::MersenneTwisterRandomVariateGenerator::GetInstance();
+  /** The random number generator of this metric. */
+  RandomGeneratorType * const randomGenerator = this->m_RandomGenerator;
 
   /** Sample additional at fixed timepoint. */
   for (unsigned int i = 0; i < m_NumAdditionalSamplesFixed; ++i)
@@ -303,12 +355,12 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetDeriva
 
 
 /**
- * ******************* GetValueAndDerivative *******************
+ * ******************* GetValueAndDerivativeSingleThreaded *******************
  */
 
 template <class TFixedImage, class TMovingImage>
 void
-SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValueAndDerivativeSingleThreaded(
   const TransformParametersType & parameters,
   MeasureType &                   value,
   DerivativeType &                derivative) const
@@ -534,76 +586,490 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValueA
   /** Subtract mean from derivative elements. */
   if (this->m_SubtractMean)
   {
-    if (!this->m_TransformIsStackTransform)
+    this->SubtractMeanOverLastDimension(derivative, this->m_TransformIsStackTransform, this->m_GridSize[lastDim], G);
+  }
+
+  /** Return the measure value. */
+  value = measure;
+
+} // end GetValueAndDerivativeSingleThreaded()
+
+
+/**
+ * ******************* GetValueAndDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
+  const TransformParametersType & parameters,
+  MeasureType &                   value,
+  DerivativeType &                derivative) const
+{
+  /** Option for now to still use the single threaded code. */
+  if (!this->m_UseMultiThread)
+  {
+    return this->GetValueAndDerivativeSingleThreaded(parameters, value, derivative);
+  }
+
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   * Because of these calls GetValueAndDerivative itself is not thread-safe,
+   * so cannot be called multiple times simultaneously.
+   */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
+
+  this->InitializeThreadingParameters();
+
+  /** Launch multi-threading GetSamples */
+  this->LaunchGetSamplesThreaderCallback();
+
+  /** Gather the samples of all threads and compute the correlation matrix. */
+  this->AfterThreadedGetSamples(value);
+
+  /** Launch multi-threading ComputeDerivative */
+  this->LaunchComputeDerivativeThreaderCallback();
+
+  /** Sum derivative contributions from all threads */
+  this->AfterThreadedComputeDerivative(derivative);
+
+} // end GetValueAndDerivative()
+
+
+/**
+ * ******************* ThreadedGetSamples *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::ThreadedGetSamples(ThreadIdType threadId)
+{
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const unsigned long         sampleContainerSize = sampleContainer->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+  /** Create iterator over the sample container. */
+  typename ImageSampleContainerType::ConstIterator threader_fiter;
+  typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator threader_fend = sampleContainer->Begin();
+  threader_fbegin += (int)pos_begin;
+  threader_fend += (int)pos_end;
+
+  std::vector<FixedImagePointType> SamplesOK;
+  MatrixType                       datablock(pos_end - pos_begin, this->m_G);
+
+  unsigned int pixelIndex = 0;
+  for (threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter)
+  {
+    /** Read fixed coordinates. */
+    FixedImagePointType fixedPoint = (*threader_fiter).Value().m_ImageCoordinates;
+
+    /** Transform sampled point to voxel coordinates. */
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex(fixedPoint, voxelCoord);
+
+    unsigned int numSamplesOk = 0;
+
+    /** Loop over t */
+    for (unsigned int d = 0; d < this->m_G; ++d)
     {
-      /** Update derivative per dimension.
-       * Parameters are ordered xxxxxxx yyyyyyy zzzzzzz ttttttt and
-       * per dimension xyz.
-       */
-      const unsigned int lastDimGridSize = this->m_GridSize[lastDim];
-      const unsigned int numParametersPerDimension =
-        this->GetNumberOfParameters() / this->GetMovingImage()->GetImageDimension();
-      const unsigned int numControlPointsPerDimension = numParametersPerDimension / lastDimGridSize;
-      DerivativeType     mean(numControlPointsPerDimension);
-      for (unsigned int d = 0; d < this->GetMovingImage()->GetImageDimension(); ++d)
+      /** Initialize some variables. */
+      RealType             movingImageValue;
+      MovingImagePointType mappedPoint;
+
+      /** Set fixed point's last dimension to lastDimPosition. */
+      voxelCoord[this->m_LastDimIndex] = d;
+
+      /** Transform sampled point back to world coordinates. */
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint(voxelCoord, fixedPoint);
+
+      /** Transform point and check if it is inside the B-spline support region. */
+      bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+
+      /** Check if point is inside mask. */
+      if (sampleOk)
       {
-        /** Compute mean per dimension. */
-        mean.Fill(0.0);
-        const unsigned int starti = numParametersPerDimension * d;
-        for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
-        {
-          const unsigned int index = i % numControlPointsPerDimension;
-          mean[index] += derivative[i];
-        }
-        mean /= static_cast<double>(lastDimGridSize);
-
-        /** Update derivative for every control point per dimension. */
-        for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
-        {
-          const unsigned int index = i % numControlPointsPerDimension;
-          derivative[i] -= mean[index];
-        }
+        sampleOk = this->IsInsideMovingMask(mappedPoint);
       }
-    }
-    else
-    {
-      /** Update derivative per dimension.
-       * Parameters are ordered x0x0x0y0y0y0z0z0z0x1x1x1y1y1y1z1z1z1 with
-       * the number the time point index.
-       */
-      const unsigned int numParametersPerLastDimension = this->GetNumberOfParameters() / G;
-      DerivativeType     mean(numParametersPerLastDimension);
-      mean.Fill(0.0);
-
-      /** Compute mean per control point. */
-      for (unsigned int t = 0; t < G; ++t)
+
+      if (sampleOk)
       {
-        const unsigned int startc = numParametersPerLastDimension * t;
-        for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
-        {
-          const unsigned int index = c % numParametersPerLastDimension;
-          mean[index] += derivative[c];
-        }
+        sampleOk = this->FastEvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, nullptr, threadId);
       }
-      mean /= static_cast<double>(G);
 
-      /** Update derivative per control point. */
-      for (unsigned int t = 0; t < G; ++t)
+      if (sampleOk)
       {
-        const unsigned int startc = numParametersPerLastDimension * t;
-        for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
-        {
-          const unsigned int index = c % numParametersPerLastDimension;
-          derivative[c] -= mean[index];
-        }
-      }
+        numSamplesOk++;
+        datablock(pixelIndex, d) = movingImageValue;
+      } // end if sampleOk
+
+    } // end loop over t
+
+    if (numSamplesOk == this->m_G)
+    {
+      SamplesOK.push_back(fixedPoint);
+      pixelIndex++;
+    }
+
+  } // end loop over image sample container
+
+  /** Sum the columns of the data block, to compute their mean over all threads. */
+  vnl_vector<RealType> columnSum(this->m_G, NumericTraits<RealType>::Zero);
+  for (unsigned int i = 0; i < pixelIndex; ++i)
+  {
+    for (unsigned int j = 0; j < this->m_G; ++j)
+    {
+      columnSum(j) += datablock(i, j);
     }
   }
 
-  /** Return the measure value. */
-  value = measure;
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_SumOfPairwiseCorrelationsPerThreadVariables[threadId].st_NumberOfPixelsCounted = pixelIndex;
+  this->m_SumOfPairwiseCorrelationsPerThreadVariables[threadId].st_DataBlock = datablock.extract(pixelIndex, this->m_G);
+  this->m_SumOfPairwiseCorrelationsPerThreadVariables[threadId].st_ApprovedSamples = SamplesOK;
+  this->m_SumOfPairwiseCorrelationsPerThreadVariables[threadId].st_ColumnSum = columnSum;
 
-} // end GetValueAndDerivative()
+} // end ThreadedGetSamples()
+
+
+/**
+ * ******************* AfterThreadedGetSamples *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::AfterThreadedGetSamples(
+  MeasureType & value) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+  const unsigned int G = this->m_G;
+
+  /** Accumulate the number of pixels. */
+  this->m_NumberOfPixelsCounted = this->m_SumOfPairwiseCorrelationsPerThreadVariables[0].st_NumberOfPixelsCounted;
+  for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+  {
+    this->m_NumberOfPixelsCounted += this->m_SumOfPairwiseCorrelationsPerThreadVariables[i].st_NumberOfPixelsCounted;
+  }
+
+  /** Check if enough samples were valid. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
+  const unsigned int N = this->m_NumberOfPixelsCounted;
+
+  /** Calculate mean of columns */
+  this->m_ColumnMean.set_size(G);
+  this->m_ColumnMean.fill(NumericTraits<RealType>::Zero);
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    this->m_ColumnMean += this->m_SumOfPairwiseCorrelationsPerThreadVariables[i].st_ColumnSum;
+  }
+  this->m_ColumnMean /= RealType(N);
+
+  /** Center the data blocks, and compute their contributions to the covariance matrix, multi-threaded. */
+  this->LaunchComputeCovarianceThreaderCallback();
+
+  /** Gather the centered data blocks and the covariance matrix contributions of all threads. */
+  MatrixType   Amm(N, G);
+  MatrixType   C(G, G, NumericTraits<RealType>::Zero);
+  unsigned int row_start = 0;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    Amm.update(this->m_SumOfPairwiseCorrelationsPerThreadVariables[i].st_DataBlock, row_start, 0);
+    C += this->m_SumOfPairwiseCorrelationsPerThreadVariables[i].st_Covariance;
+    this->m_PixelStartIndex[i] = row_start;
+    row_start += this->m_SumOfPairwiseCorrelationsPerThreadVariables[i].st_DataBlock.rows();
+  }
+  C /= static_cast<RealType>(RealType(N) - 1.0);
+  this->m_Atmm = Amm.transpose();
+
+  this->m_S.set_size(G);
+  this->m_S.fill(NumericTraits<RealType>::Zero);
+  for (unsigned int j = 0; j < G; ++j)
+  {
+    this->m_S(j, j) = 1.0 / sqrt(C(j, j));
+  }
+
+  DerivativeMatrixType K(this->m_S * C * this->m_S);
+  this->m_KFrobeniusNorm = K.fro_norm();
+
+  value = RealType(1.0 - (this->m_KFrobeniusNorm / RealType(G)));
+
+  /** Sub components of metric derivative */
+  this->m_dSdmu_part1.set_size(G);
+  for (unsigned int d = 0; d < G; ++d)
+  {
+    double S_sqr = this->m_S(d, d) * this->m_S(d, d);
+    double S_qub = S_sqr * this->m_S(d, d);
+    this->m_dSdmu_part1(d, d) = -S_qub / (DerivativeValueType(N) - 1.0);
+  }
+
+  const DerivativeMatrixType AtZscore((Amm * this->m_S).transpose());
+  this->m_KAtZscore = K * AtZscore;
+  this->m_KAtZscoreAmm = this->m_KAtZscore * Amm;
+
+} // end AfterThreadedGetSamples()
+
+
+/**
+ * **************** GetSamplesThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_TYPE
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::GetSamplesThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+
+  SumOfPairwiseCorrelationsMultiThreaderParameterType * temp =
+    static_cast<SumOfPairwiseCorrelationsMultiThreaderParameterType *>(infoStruct->UserData);
+
+  temp->m_Metric->ThreadedGetSamples(threadId);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end GetSamplesThreaderCallback()
+
+
+/**
+ * *********************** LaunchGetSamplesThreaderCallback ***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::LaunchGetSamplesThreaderCallback(void) const
+{
+  /** Setup local threader. */
+  auto local_threader = ThreaderType::New();
+  local_threader->SetNumberOfWorkUnits(Self::GetNumberOfWorkUnits());
+  local_threader->SetSingleMethod(
+    this->GetSamplesThreaderCallback,
+    const_cast<void *>(static_cast<const void *>(&this->m_SumOfPairwiseCorrelationsThreaderParameters)));
+
+  /** Launch. */
+  local_threader->SingleMethodExecute();
+
+} // end LaunchGetSamplesThreaderCallback()
+
+
+/**
+ * ******************* ThreadedComputeCovariance *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::ThreadedComputeCovariance(ThreadIdType threadId)
+{
+  /** Center the data block of this thread. */
+  MatrixType & datablock = this->m_SumOfPairwiseCorrelationsPerThreadVariables[threadId].st_DataBlock;
+  for (unsigned int i = 0; i < datablock.rows(); ++i)
+  {
+    for (unsigned int j = 0; j < this->m_G; ++j)
+    {
+      datablock(i, j) -= this->m_ColumnMean(j);
+    }
+  }
+
+  /** Compute its contribution to the (unnormalized) covariance matrix. */
+  this->m_SumOfPairwiseCorrelationsPerThreadVariables[threadId].st_Covariance = datablock.transpose() * datablock;
+
+} // end ThreadedComputeCovariance()
+
+
+/**
+ * **************** ComputeCovarianceThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_TYPE
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::ComputeCovarianceThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+
+  SumOfPairwiseCorrelationsMultiThreaderParameterType * temp =
+    static_cast<SumOfPairwiseCorrelationsMultiThreaderParameterType *>(infoStruct->UserData);
+
+  temp->m_Metric->ThreadedComputeCovariance(threadId);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeCovarianceThreaderCallback()
+
+
+/**
+ * ************** LaunchComputeCovarianceThreaderCallback **********
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::LaunchComputeCovarianceThreaderCallback(void) const
+{
+  /** Setup local threader. */
+  auto local_threader = ThreaderType::New();
+  local_threader->SetNumberOfWorkUnits(Self::GetNumberOfWorkUnits());
+  local_threader->SetSingleMethod(
+    this->ComputeCovarianceThreaderCallback,
+    const_cast<void *>(static_cast<const void *>(&this->m_SumOfPairwiseCorrelationsThreaderParameters)));
+
+  /** Launch. */
+  local_threader->SingleMethodExecute();
+
+} // end LaunchComputeCovarianceThreaderCallback()
+
+
+/**
+ * ******************* ThreadedComputeDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::ThreadedComputeDerivative(ThreadIdType threadId)
+{
+  /** Create variables to store intermediate results in. */
+  DerivativeType & derivative = this->m_SumOfPairwiseCorrelationsPerThreadVariables[threadId].st_Derivative;
+  derivative.Fill(0.0);
+
+  const std::vector<FixedImagePointType> & approvedSamples =
+    this->m_SumOfPairwiseCorrelationsPerThreadVariables[threadId].st_ApprovedSamples;
+  const unsigned int pixelStartIndex = this->m_PixelStartIndex[threadId];
+
+  /** Initialize some variables. */
+  RealType                  movingImageValue;
+  MovingImagePointType      mappedPoint;
+  MovingImageDerivativeType movingImageDerivative;
+
+  TransformJacobianType      jacobian;
+  DerivativeType             imageJacobian(this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices());
+  NonZeroJacobianIndicesType nzjis(this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices());
+
+  /** Second loop over the approved fixed image samples of this thread. */
+  for (unsigned int i = 0; i < approvedSamples.size(); ++i)
+  {
+    const unsigned int pixelIndex = pixelStartIndex + i;
+
+    /** Read fixed coordinates. */
+    FixedImagePointType fixedPoint = approvedSamples[i];
+
+    /** Transform sampled point to voxel coordinates. */
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex(fixedPoint, voxelCoord);
+
+    for (unsigned int d = 0; d < this->m_G; ++d)
+    {
+      /** Set fixed point's last dimension to lastDimPosition. */
+      voxelCoord[this->m_LastDimIndex] = d;
+
+      /** Transform sampled point back to world coordinates. */
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint(voxelCoord, fixedPoint);
+      this->TransformPoint(fixedPoint, mappedPoint);
+
+      this->FastEvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative, threadId);
+
+      /** Get the TransformJacobian dT/dmu */
+      this->EvaluateTransformJacobian(fixedPoint, jacobian, nzjis);
+
+      /** Compute the innerproduct (dM/dx)^T (dT/dmu). */
+      this->EvaluateTransformJacobianInnerProduct(jacobian, movingImageDerivative, imageJacobian);
+
+      /** build metric derivative components */
+      const DerivativeValueType weight =
+        this->m_KAtZscore[d][pixelIndex] * this->m_S(d, d) +
+        this->m_dSdmu_part1(d, d) * this->m_Atmm[d][pixelIndex] * this->m_KAtZscoreAmm[d][d];
+      for (unsigned int p = 0; p < nzjis.size(); ++p)
+      {
+        derivative[nzjis[p]] += weight * imageJacobian[p];
+      } // end loop over non-zero jacobian indices
+
+    } // end loop over t
+
+  } // end second loop over sample container
+
+} // end ThreadedComputeDerivative()
+
+
+/**
+ * ******************* AfterThreadedComputeDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::AfterThreadedComputeDerivative(
+  DerivativeType & derivative) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+  const unsigned int N = this->m_NumberOfPixelsCounted;
+
+  derivative = this->m_SumOfPairwiseCorrelationsPerThreadVariables[0].st_Derivative;
+  for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+  {
+    derivative += this->m_SumOfPairwiseCorrelationsPerThreadVariables[i].st_Derivative;
+  }
+
+  derivative *= -static_cast<DerivativeValueType>(2.0) /
+                (static_cast<DerivativeValueType>(N - static_cast<DerivativeValueType>(1.0)) *
+                 (this->m_KFrobeniusNorm * RealType(this->m_G))); // normalize
+
+  /** Subtract mean from derivative elements. */
+  if (this->m_SubtractMean)
+  {
+    this->SubtractMeanOverLastDimension(
+      derivative, this->m_TransformIsStackTransform, this->m_GridSize[this->m_LastDimIndex], this->m_G);
+  }
+
+} // end AfterThreadedComputeDerivative()
+
+
+/**
+ * **************** ComputeDerivativeThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_TYPE
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::ComputeDerivativeThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+
+  SumOfPairwiseCorrelationsMultiThreaderParameterType * temp =
+    static_cast<SumOfPairwiseCorrelationsMultiThreaderParameterType *>(infoStruct->UserData);
+
+  temp->m_Metric->ThreadedComputeDerivative(threadId);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeDerivativeThreaderCallback()
+
+
+/**
+ * ************** LaunchComputeDerivativeThreaderCallback **********
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage, TMovingImage>::LaunchComputeDerivativeThreaderCallback(
+  void) const
+{
+  /** Setup local threader. */
+  auto local_threader = ThreaderType::New();
+  local_threader->SetNumberOfWorkUnits(Self::GetNumberOfWorkUnits());
+  local_threader->SetSingleMethod(
+    this->ComputeDerivativeThreaderCallback,
+    const_cast<void *>(static_cast<const void *>(&this->m_SumOfPairwiseCorrelationsThreaderParameters)));
+
+  /** Launch. */
+  local_threader->SingleMethodExecute();
+
+} // end LaunchComputeDerivativeThreaderCallback()
 
 
 } // end namespace itk
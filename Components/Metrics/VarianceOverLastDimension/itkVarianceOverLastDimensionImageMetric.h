@@ -120,6 +120,8 @@ public:
   using typename Superclass::FixedImageLimiterOutputType;
   using typename Superclass::MovingImageLimiterOutputType;
   using typename Superclass::MovingImageDerivativeScalesType;
+  using typename Superclass::DerivativeValueType;
+  using typename Superclass::NumberOfParametersType;
 
   /** The fixed image dimension. */
   itkStaticConstMacro(FixedImageDimension, unsigned int, FixedImageType::ImageDimension);
@@ -136,6 +138,11 @@ public:
   GetDerivative(const TransformParametersType & parameters, DerivativeType & derivative) const override;
 
   /** Get value and derivatives for multiple valued optimizers. */
+  void
+  GetValueAndDerivativeSingleThreaded(const TransformParametersType & parameters,
+                                      MeasureType &                   Value,
+                                      DerivativeType &                Derivative) const;
+
   void
   GetValueAndDerivative(const TransformParametersType & parameters,
                         MeasureType &                   Value,
@@ -168,6 +175,9 @@ protected:
   using typename Superclass::CentralDifferenceGradientFilterType;
   using typename Superclass::MovingImageDerivativeType;
   using typename Superclass::NonZeroJacobianIndicesType;
+  using typename Superclass::RandomGeneratorType;
+  using typename Superclass::ThreadInfoType;
+  using typename Superclass::MultiThreaderParameterType;
 
   /** Computes the innerproduct of transform Jacobian with moving image gradient.
    * The results are stored in imageJacobian, which is supposed
@@ -177,6 +187,24 @@ protected:
                                         const MovingImageDerivativeType & movingImageDerivative,
                                         DerivativeType &                  imageJacobian) const override;
 
+  /** Get value and derivatives for each thread. */
+  inline void
+  ThreadedGetValueAndDerivative(ThreadIdType threadID) override;
+
+  /** Gather the values and derivatives from all threads. */
+  inline void
+  AfterThreadedGetValueAndDerivative(MeasureType & value, DerivativeType & derivative) const override;
+
+  /** Compute the derivative contributions of the sub transforms that are assigned to the specified thread, when
+   * the derivative is assembled per stack slice (PartitionSamplesByStackSlice).
+   */
+  void
+  ThreadedComputeDerivativePerStackSlice(const ThreadIdType threadId) const;
+
+  /** Helper function to launch the threads that assemble the derivative per stack slice. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeDerivativePerStackSliceThreaderCallback(void * arg);
+
 private:
   VarianceOverLastDimensionImageMetric(const Self &) = delete;
   void
@@ -203,6 +231,18 @@ private:
 
   /** Bool to indicate if the transform used is a stacktransform. Set by elx files. */
   bool m_TransformIsStackTransform{ false };
+
+  /** Last dimension positions per sample, drawn before launching the threads
+   * when the last dimension is sampled randomly, because SampleRandom() is not thread-safe.
+   */
+  mutable std::vector<int> m_RandomLastDimPositions;
+
+  /** When the derivative is assembled per stack slice: the work unit of each slice, and the weight and the moving
+   * image derivative at each sample and last dimension position, stored by the first threaded pass.
+   */
+  mutable std::vector<ThreadIdType>              m_WorkUnitPerStackSlice;
+  mutable std::vector<RealType>                  m_StackSliceWeights;
+  mutable std::vector<MovingImageDerivativeType> m_StackSliceMovingImageDerivatives;
 };
 
 } // end namespace itk
@@ -19,8 +19,8 @@
 #define itkVarianceOverLastDimensionImageMetric_hxx
 
 #include "itkVarianceOverLastDimensionImageMetric.h"
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include <vnl/algo/vnl_matrix_update.h>
+#include <algorithm>
 #include <numeric>
 
 namespace itk
@@ -130,9 +130,8 @@ VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::SampleRandom(co
   /** Empty list of last dimension positions. */
   numbers.clear();
 
-  /** Initialize random number generator. */
-  Statistics::MersenneTwisterRandomVariateGenerator::Pointer randomGenerator =
-    Statistics::MersenneTwisterRandomVariateGenerator::GetInstance();
+  /** The random number generator of this metric. */
+  RandomGeneratorType * const randomGenerator = this->m_RandomGenerator;
 
   /** Sample additional at fixed timepoint. */
   for (unsigned int i = 0; i < m_NumAdditionalSamplesFixed; ++i)
@@ -345,12 +344,12 @@ VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::GetDerivative(
 
 
 /**
- * ******************* GetValueAndDerivative *******************
+ * ******************* GetValueAndDerivativeSingleThreaded *******************
  */
 
 template <class TFixedImage, class TMovingImage>
 void
-VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::GetValueAndDerivativeSingleThreaded(
   const TransformParametersType & parameters,
   MeasureType &                   value,
   DerivativeType &                derivative) const
@@ -529,76 +528,437 @@ VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::GetValueAndDeri
   /** Subtract mean from derivative elements. */
   if (this->m_SubtractMean)
   {
-    if (!this->m_TransformIsStackTransform)
+    this->SubtractMeanOverLastDimension(
+      derivative, this->m_TransformIsStackTransform, this->m_GridSize[lastDim], lastDimSize);
+  }
+
+  /** Return the measure value. */
+  value = measure;
+
+} // end GetValueAndDerivativeSingleThreaded()
+
+
+/**
+ * ******************* GetValueAndDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
+  const TransformParametersType & parameters,
+  MeasureType &                   value,
+  DerivativeType &                derivative) const
+{
+  /** Option for now to still use the single threaded code. */
+  if (!this->m_UseMultiThread)
+  {
+    return this->GetValueAndDerivativeSingleThreaded(parameters, value, derivative);
+  }
+
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   * Because of these calls GetValueAndDerivative itself is not thread-safe,
+   * so cannot be called multiple times simultaneously.
+   * This is however needed in the CombinationImageToImageMetric.
+   * In that case, you need to:
+   * - switch the use of this function to on, using m_UseMetricSingleThreaded = true
+   * - call BeforeThreadedGetValueAndDerivative once (single-threaded) before
+   *   calling GetValueAndDerivative
+   * - switch the use of this function to off, using m_UseMetricSingleThreaded = false
+   * - Now you can call GetValueAndDerivative multi-threaded.
+   */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
+
+  /** The random number generator is not thread-safe, so draw the last
+   * dimension positions of all samples beforehand, in sample order.
+   */
+  if (this->m_SampleLastDimensionRandomly)
+  {
+    const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+    const unsigned int lastDimSize = this->GetFixedImage()->GetLargestPossibleRegion().GetSize(lastDim);
+    const unsigned int realNumLastDimPositions = this->m_NumSamplesLastDimension + this->m_NumAdditionalSamplesFixed;
+    const std::size_t  numberOfSamples = this->GetImageSampler()->GetOutput()->Size();
+
+    std::vector<int> lastDimPositions;
+    this->m_RandomLastDimPositions.resize(numberOfSamples * realNumLastDimPositions);
+    for (std::size_t i = 0; i < numberOfSamples; ++i)
     {
-      /** Update derivative per dimension.
-       * Parameters are ordered xxxxxxx yyyyyyy zzzzzzz ttttttt and
-       * per dimension xyz.
-       */
-      const unsigned int lastDimGridSize = this->m_GridSize[lastDim];
-      const unsigned int numParametersPerDimension =
-        this->GetNumberOfParameters() / this->GetMovingImage()->GetImageDimension();
-      const unsigned int numControlPointsPerDimension = numParametersPerDimension / lastDimGridSize;
-      DerivativeType     mean(numControlPointsPerDimension);
-      for (unsigned int d = 0; d < this->GetMovingImage()->GetImageDimension(); ++d)
+      this->SampleRandom(this->m_NumSamplesLastDimension, lastDimSize, lastDimPositions);
+      std::copy(lastDimPositions.begin(),
+                lastDimPositions.end(),
+                this->m_RandomLastDimPositions.begin() + i * realNumLastDimPositions);
+    }
+  }
+
+  /** When the derivative is assembled per stack slice, the first pass only stores the derivative weights and
+   * moving image derivatives of all samples, at all last dimension positions.
+   */
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+  this->m_WorkUnitPerStackSlice =
+    this->ComputeWorkUnitPerStackSlice(this->GetFixedImage()->GetLargestPossibleRegion().GetSize(lastDim));
+  if (!this->m_WorkUnitPerStackSlice.empty())
+  {
+    const unsigned int realNumLastDimPositions =
+      this->m_SampleLastDimensionRandomly ? this->m_NumSamplesLastDimension + this->m_NumAdditionalSamplesFixed
+                                          : static_cast<unsigned int>(this->m_WorkUnitPerStackSlice.size());
+    const std::size_t numberOfEntries = this->GetImageSampler()->GetOutput()->Size() * realNumLastDimPositions;
+    this->m_StackSliceWeights.resize(numberOfEntries);
+    this->m_StackSliceMovingImageDerivatives.resize(numberOfEntries);
+  }
+
+  /** Launch multi-threading metric */
+  this->LaunchGetValueAndDerivativeThreaderCallback();
+
+  /** Gather the metric values and derivatives from all threads. */
+  this->AfterThreadedGetValueAndDerivative(value, derivative);
+
+} // end GetValueAndDerivative()
+
+
+/**
+ * ******************* ThreadedGetValueAndDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivative(ThreadIdType threadId)
+{
+  /** Get a handle to the pre-allocated derivative for the current thread.
+   * It is reset at the end of each iteration by the accumulate functions.
+   */
+  DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Derivative;
+
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const unsigned long         sampleContainerSize = sampleContainer->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+  /** Create iterator over the sample container. */
+  typename ImageSampleContainerType::ConstIterator threader_fiter;
+  typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator threader_fend = sampleContainer->Begin();
+
+  threader_fbegin += (int)pos_begin;
+  threader_fend += (int)pos_end;
+
+  /** Retrieve slowest varying dimension and its size. */
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+  const unsigned int lastDimSize = this->GetFixedImage()->GetLargestPossibleRegion().GetSize(lastDim);
+
+  /** Get real last dim samples. */
+  const unsigned int realNumLastDimPositions = this->m_SampleLastDimensionRandomly
+                                                 ? this->m_NumSamplesLastDimension + this->m_NumAdditionalSamplesFixed
+                                                 : lastDimSize;
+
+  /** Create variables to store intermediate results in. */
+  const NumberOfParametersType            nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  TransformJacobianType                   jacobian;
+  DerivativeType                          imageJacobian(nnzji);
+  std::vector<NonZeroJacobianIndicesType> nzjis(realNumLastDimPositions, NonZeroJacobianIndicesType());
+  std::vector<RealType>                   MT(realNumLastDimPositions);
+  std::vector<DerivativeType>             dMTdmu(realNumLastDimPositions);
+
+  /** Create variables to store intermediate results. circumvent false sharing */
+  unsigned long numberOfPixelsCounted = 0;
+  MeasureType   measure = NumericTraits<MeasureType>::Zero;
+
+  /** Whether the derivative is assembled afterwards, per stack slice, by ThreadedComputeDerivativePerStackSlice. */
+  const bool        perStackSlice = !this->m_WorkUnitPerStackSlice.empty();
+  std::vector<bool> isValid(realNumLastDimPositions);
+
+  /** Loop over the fixed image samples to calculate the variance over time for every sample position. */
+  unsigned long sampleIndex = pos_begin;
+  for (threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter, ++sampleIndex)
+  {
+    /** Read fixed coordinates. */
+    FixedImagePointType fixedPoint = (*threader_fiter).Value().m_ImageCoordinates;
+
+    /** Initialize MT vector. */
+    std::fill(MT.begin(), MT.end(), itk::NumericTraits<RealType>::ZeroValue());
+
+    /** Transform sampled point to voxel coordinates. */
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex(fixedPoint, voxelCoord);
+
+    /** Loop over the slowest varying dimension. */
+    float        sumValues = 0.0;
+    float        sumValuesSquared = 0.0;
+    unsigned int numSamplesOk = 0;
+
+    /** First loop over t: compute M(T(x,t)), dM(T(x,t))/dmu, nzji and store. */
+    for (unsigned int d = 0; d < realNumLastDimPositions; ++d)
+    {
+      /** Initialize some variables. */
+      RealType                  movingImageValue;
+      MovingImagePointType      mappedPoint;
+      MovingImageDerivativeType movingImageDerivative;
+
+      /** Set fixed point's last dimension to lastDimPosition. */
+      voxelCoord[lastDim] = this->m_SampleLastDimensionRandomly
+                              ? this->m_RandomLastDimPositions[sampleIndex * realNumLastDimPositions + d]
+                              : d;
+
+      /** Transform sampled point back to world coordinates. */
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint(voxelCoord, fixedPoint);
+
+      /** Transform point and check if it is inside the B-spline support region. */
+      bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+
+      /** Check if point is inside mask. */
+      if (sampleOk)
       {
-        /** Compute mean per dimension. */
-        mean.Fill(0.0);
-        const unsigned int starti = numParametersPerDimension * d;
-        for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
-        {
-          const unsigned int index = i % numControlPointsPerDimension;
-          mean[index] += derivative[i];
-        }
-        mean /= static_cast<double>(lastDimGridSize);
+        sampleOk = this->IsInsideMovingMask(mappedPoint);
+      }
 
-        /** Update derivative for every control point per dimension. */
-        for (unsigned int i = starti; i < starti + numParametersPerDimension; ++i)
+      /** Compute the moving image value and check if the point is
+       * inside the moving image buffer. */
+      if (sampleOk)
+      {
+        sampleOk = this->FastEvaluateMovingImageValueAndDerivative(
+          mappedPoint, movingImageValue, &movingImageDerivative, threadId);
+      }
+
+      if (sampleOk)
+      {
+        /** Update value terms **/
+        numSamplesOk++;
+        sumValues += movingImageValue;
+        sumValuesSquared += movingImageValue * movingImageValue;
+        MT[d] = movingImageValue;
+        isValid[d] = true;
+
+        if (perStackSlice)
         {
-          const unsigned int index = i % numControlPointsPerDimension;
-          derivative[i] -= mean[index];
+          /** Only store the moving image derivative; the Jacobian is evaluated by the per slice pass. */
+          this->m_StackSliceMovingImageDerivatives[sampleIndex * realNumLastDimPositions + d] = movingImageDerivative;
+          continue;
         }
+
+        /** Get the TransformJacobian dT/dmu. */
+        this->EvaluateTransformJacobian(fixedPoint, jacobian, nzjis[d]);
+
+        /** Compute the innerproduct (dM/dx)^T (dT/dmu). */
+        this->EvaluateTransformJacobianInnerProduct(jacobian, movingImageDerivative, imageJacobian);
+
+        /** Store values. */
+        dMTdmu[d] = imageJacobian;
       }
+      else
+      {
+        isValid[d] = false;
+        dMTdmu[d] = DerivativeType(nnzji);
+        dMTdmu[d].Fill(itk::NumericTraits<DerivativeValueType>::ZeroValue());
+        nzjis[d] = NonZeroJacobianIndicesType(nnzji, 0);
+      } // end if sampleOk
     }
-    else
+
+    if (perStackSlice)
     {
-      /** Update derivative per dimension.
-       * Parameters are ordered x0x0x0y0y0y0z0z0z0x1x1x1y1y1y1z1z1z1 with
-       * the number the time point index.
-       */
-      const unsigned int numParametersPerLastDimension = this->GetNumberOfParameters() / lastDimSize;
-      DerivativeType     mean(numParametersPerLastDimension);
-      mean.Fill(0.0);
+      /** Store the weights of the moving image derivatives, which are zero at invalid positions. */
+      const float expectedValue = (numSamplesOk > 0) ? sumValues / static_cast<float>(numSamplesOk) : 0.0f;
+      for (unsigned int d = 0; d < realNumLastDimPositions; ++d)
+      {
+        this->m_StackSliceWeights[sampleIndex * realNumLastDimPositions + d] =
+          isValid[d] ? 2.0 * (MT[d] - expectedValue) / static_cast<float>(numSamplesOk) : 0.0;
+      }
+    }
 
-      /** Compute mean per control point. */
-      for (unsigned int t = 0; t < lastDimSize; ++t)
+    if (numSamplesOk > 0)
+    {
+      numberOfPixelsCounted++;
+
+      /** Compute average intensity value. */
+      const float expectedValue = sumValues / static_cast<float>(numSamplesOk);
+      /** Add this variance to the variance sum. */
+      const float expectedSquaredValue = sumValuesSquared / static_cast<float>(numSamplesOk);
+      measure += expectedSquaredValue - expectedValue * expectedValue;
+
+      /** Second loop over t: update derivative. */
+      for (unsigned int d = 0; d < realNumLastDimPositions && !perStackSlice; ++d)
       {
-        const unsigned int startc = numParametersPerLastDimension * t;
-        for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
+        for (unsigned int j = 0; j < nzjis[d].size(); ++j)
         {
-          const unsigned int index = c % numParametersPerLastDimension;
-          mean[index] += derivative[c];
+          derivative[nzjis[d][j]] += (2.0 * (MT[d] - expectedValue) * dMTdmu[d][j]) / static_cast<float>(numSamplesOk);
         }
       }
-      mean /= static_cast<double>(lastDimSize);
+    }
+  } // end for loop over the image sample container
 
-      /** Update derivative per control point. */
-      for (unsigned int t = 0; t < lastDimSize; ++t)
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted = numberOfPixelsCounted;
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value = measure;
+
+} // end ThreadedGetValueAndDerivative()
+
+
+/**
+ * ******************* AfterThreadedGetValueAndDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::AfterThreadedGetValueAndDerivative(
+  MeasureType &    value,
+  DerivativeType & derivative) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+
+  /** Accumulate the number of pixels. */
+  this->m_NumberOfPixelsCounted = this->m_GetValueAndDerivativePerThreadVariables[0].st_NumberOfPixelsCounted;
+  for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+  {
+    this->m_NumberOfPixelsCounted += this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted;
+
+    /** Reset this variable for the next iteration. */
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted = 0;
+  }
+
+  /** Check if enough samples were valid. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
+
+  /** Compute average over variances and normalize with initial variance. */
+  const float normalization = static_cast<float>(this->m_NumberOfPixelsCounted * this->m_InitialVariance);
+
+  /** Accumulate values. */
+  value = NumericTraits<MeasureType>::Zero;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    value += this->m_GetValueAndDerivativePerThreadVariables[i].st_Value;
+
+    /** Reset this variable for the next iteration. */
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
+  }
+  value /= normalization;
+
+  /** Accumulate and normalize the derivatives multi-threadedly. When the derivative is assembled per stack
+   * slice, each thread writes directly into the parameter blocks of its own sub transforms instead.
+   */
+  derivative.SetSize(this->GetNumberOfParameters());
+  this->m_ThreaderMetricParameters.st_DerivativePointer = derivative.begin();
+  this->m_ThreaderMetricParameters.st_NormalizationFactor = normalization;
+
+  if (this->m_WorkUnitPerStackSlice.empty())
+  {
+    this->m_Threader->SetSingleMethod(this->AccumulateDerivativesThreaderCallback,
+                                      const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
+  }
+  else
+  {
+    derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+    this->m_Threader->SetSingleMethod(this->ComputeDerivativePerStackSliceThreaderCallback,
+                                      const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
+  }
+  this->m_Threader->SingleMethodExecute();
+
+  /** Subtract mean from derivative elements. */
+  if (this->m_SubtractMean)
+  {
+    const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+    const unsigned int lastDimSize = this->GetFixedImage()->GetLargestPossibleRegion().GetSize(lastDim);
+    this->SubtractMeanOverLastDimension(
+      derivative, this->m_TransformIsStackTransform, this->m_GridSize[lastDim], lastDimSize);
+  }
+
+} // end AfterThreadedGetValueAndDerivative()
+
+
+/**
+ * ******************* ThreadedComputeDerivativePerStackSlice *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::ThreadedComputeDerivativePerStackSlice(
+  const ThreadIdType threadId) const
+{
+  DerivativeValueType * const derivative = this->m_ThreaderMetricParameters.st_DerivativePointer;
+  const DerivativeValueType   normalization = 1.0 / this->m_ThreaderMetricParameters.st_NormalizationFactor;
+
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const unsigned long         sampleContainerSize = sampleContainer->Size();
+
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+  const unsigned int realNumLastDimPositions =
+    this->m_SampleLastDimensionRandomly ? this->m_NumSamplesLastDimension + this->m_NumAdditionalSamplesFixed
+                                        : static_cast<unsigned int>(this->m_WorkUnitPerStackSlice.size());
+
+  /** Create variables to store intermediate results in. */
+  TransformJacobianType      jacobian;
+  DerivativeType             imageJacobian(this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices());
+  NonZeroJacobianIndicesType nzji;
+
+  /** Loop over all samples, but only over the last dimension positions whose sub transform belongs to this
+   * thread. The parameter blocks of the sub transforms do not overlap, so each thread can write directly
+   * into the derivative.
+   */
+  typename ImageSampleContainerType::ConstIterator fiter = sampleContainer->Begin();
+  for (unsigned long sampleIndex = 0; sampleIndex < sampleContainerSize; ++sampleIndex, ++fiter)
+  {
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex((*fiter).Value().m_ImageCoordinates, voxelCoord);
+
+    for (unsigned int d = 0; d < realNumLastDimPositions; ++d)
+    {
+      const std::size_t entry = sampleIndex * realNumLastDimPositions + d;
+      const int         slice =
+        this->m_SampleLastDimensionRandomly ? this->m_RandomLastDimPositions[entry] : static_cast<int>(d);
+      const RealType weight = this->m_StackSliceWeights[entry];
+
+      if (this->m_WorkUnitPerStackSlice[slice] != threadId || weight == 0.0)
       {
-        const unsigned int startc = numParametersPerLastDimension * t;
-        for (unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c)
-        {
-          const unsigned int index = c % numParametersPerLastDimension;
-          derivative[c] -= mean[index];
-        }
+        continue;
+      }
+
+      /** Set fixed point's last dimension to the slice, and transform it back to world coordinates. */
+      voxelCoord[lastDim] = slice;
+      FixedImagePointType fixedPoint;
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint(voxelCoord, fixedPoint);
+
+      /** Compute the innerproduct (dM/dx)^T (dT/dmu), and update the derivative. */
+      this->EvaluateTransformJacobian(fixedPoint, jacobian, nzji);
+      this->EvaluateTransformJacobianInnerProduct(
+        jacobian, this->m_StackSliceMovingImageDerivatives[entry], imageJacobian);
+
+      for (unsigned int j = 0; j < nzji.size(); ++j)
+      {
+        derivative[nzji[j]] += weight * imageJacobian[j] * normalization;
       }
     }
   }
 
-  /** Return the measure value. */
-  value = measure;
+} // end ThreadedComputeDerivativePerStackSlice()
 
-} // end GetValueAndDerivative()
+
+/**
+ * ******************* ComputeDerivativePerStackSliceThreaderCallback *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+VarianceOverLastDimensionImageMetric<TFixedImage, TMovingImage>::ComputeDerivativePerStackSliceThreaderCallback(
+  void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+
+  MultiThreaderParameterType * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
+
+  static_cast<const Self *>(temp->st_Metric)->ThreadedComputeDerivativePerStackSlice(threadId);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeDerivativePerStackSliceThreaderCallback()
 
 
 } // end namespace itk
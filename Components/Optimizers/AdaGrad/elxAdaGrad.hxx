@@ -96,6 +96,9 @@ AdaGrad<TElastix>::BeforeRegistration(void)
 
   this->m_SettingsVector.clear();
 
+  /** Draw random numbers from the random number generator of this registration. */
+  this->m_RandomGenerator = this->GetElastix()->GetRandomGenerator();
+
 } // end BeforeRegistration()
 
 
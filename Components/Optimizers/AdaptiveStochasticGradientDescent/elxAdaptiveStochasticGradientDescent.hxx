@@ -84,6 +84,9 @@ AdaptiveStochasticGradientDescent<TElastix>::BeforeRegistration(void)
 
   this->m_SettingsVector.clear();
 
+  /** Draw random numbers from the random number generator of this registration. */
+  this->m_RandomGenerator = this->GetElastix()->GetRandomGenerator();
+
 } // end BeforeRegistration()
 
 
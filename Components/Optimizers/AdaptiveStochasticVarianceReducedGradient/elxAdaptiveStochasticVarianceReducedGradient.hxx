@@ -105,6 +105,9 @@ AdaptiveStochasticVarianceReducedGradient<TElastix>::BeforeRegistration(void)
 
   this->m_SettingsVector.clear();
 
+  /** Draw random numbers from the random number generator of this registration. */
+  this->m_RandomGenerator = this->GetElastix()->GetRandomGenerator();
+
 } // end BeforeRegistration()
 
 
@@ -549,6 +552,7 @@ AdaptiveStochasticVarianceReducedGradient<TElastix>::ResumeOptimization(void)
       samplerVec[m] = dynamic_cast<ImageRandomSamplerBaseType *>(sampler.GetPointer());
 
       randomSamplerVec[m] = ImageRandomSamplerType::New();
+      randomSamplerVec[m]->SetRandomGenerator(this->m_RandomGenerator);
       randomSamplerVec[m]->SetInput(samplerVec[m]->GetInput());
       randomSamplerVec[m]->SetInputImageRegion(samplerVec[m]->GetInputImageRegion());
       randomSamplerVec[m]->SetMask(samplerVec[m]->GetMask());
@@ -586,6 +590,7 @@ AdaptiveStochasticVarianceReducedGradient<TElastix>::ResumeOptimization(void)
       samplerVec[m] = dynamic_cast<ImageRandomSamplerBaseType *>(sampler.GetPointer());
 
       subRandomSamplerVec[m] = ImageRandomSamplerType::New();
+      subRandomSamplerVec[m]->SetRandomGenerator(this->m_RandomGenerator);
       //       subRandomSamplerVec[ m ]->SetInput( randomSamplerVec[ m ] ->GetInput());
       //       subRandomSamplerVec[ m ]->SetInputImageRegion( randomSamplerVec[ m ]->
       //         GetInputImageRegion() );
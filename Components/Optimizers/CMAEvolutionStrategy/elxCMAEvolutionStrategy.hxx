@@ -100,6 +100,9 @@ CMAEvolutionStrategy<TElastix>::BeforeRegistration(void)
   this->GetIterationInfoAt("5b:MaximumD") << std::showpoint << std::fixed;
   this->GetIterationInfoAt("5c:MinimumD") << std::showpoint << std::fixed;
 
+  /** Draw random numbers from the random number generator of this registration. */
+  this->m_RandomGenerator = this->GetElastix()->GetRandomGenerator();
+
 } // end BeforeRegistration
 
 
@@ -71,6 +71,9 @@ PreconditionedGradientDescent<TElastix>::BeforeRegistration(void)
   this->GetIterationInfoAt("4a:||Gradient||") << std::showpoint << std::fixed;
   this->GetIterationInfoAt("4b:||SearchDir||") << std::showpoint << std::fixed;
 
+  /** Draw random numbers from the random number generator of this registration. */
+  this->m_RandomGenerator = this->GetElastix()->GetRandomGenerator();
+
 } // end BeforeRegistration()
 
 
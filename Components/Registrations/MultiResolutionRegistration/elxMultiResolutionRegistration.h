@@ -157,9 +157,36 @@ protected:
   virtual void
   SetComponents(void);
 
+  /** Update the fixed image pyramid. When a FixedImageDataCache is specified, the pyramid
+   * images are retrieved from the cache, when available, or stored into the cache otherwise. */
+  void
+  UpdateFixedImagePyramid(void) override;
+
+  /** Update the moving image pyramid. When the FixedImageDataCache has an on-disk directory, the pyramid
+   * images are retrieved from its disk, when available, or stored onto its disk otherwise. */
+  void
+  UpdateMovingImagePyramid(void) override;
+
 private:
   elxOverrideGetSelfMacro;
 
+  /** Grafts the images stored by the keys makeKey(level) onto the outputs of the specified pyramid. Returns false
+   * (without grafting) when any of them is not in the cache. */
+  template <class TPyramid, class TMakeKey>
+  static bool
+  RetrieveImagePyramidFromCache(FixedImageDataCache & cache,
+                                TPyramid &            pyramid,
+                                const TMakeKey &      makeKey,
+                                const bool            keepInMemory);
+
+  /** Stores the output images of the specified pyramid by the keys makeKey(level), when all of them are computed. */
+  template <class TPyramid, class TMakeKey>
+  static void
+  StoreImagePyramidInCache(FixedImageDataCache & cache,
+                           TPyramid &            pyramid,
+                           const TMakeKey &      makeKey,
+                           const bool            keepInMemory);
+
   /** The deleted copy constructor. */
   MultiResolutionRegistration(const Self &) = delete;
   /** The deleted assignment operator. */
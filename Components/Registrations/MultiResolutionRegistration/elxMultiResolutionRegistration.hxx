@@ -21,6 +21,7 @@
 #include "elxMultiResolutionRegistration.h"
 #include <vnl/vnl_math.h>
 #include "itkTimeProbe.h"
+#include <vector>
 
 namespace elastix
 {
@@ -152,6 +153,151 @@ MultiResolutionRegistration<TElastix>::SetComponents(void)
 } // end SetComponents()
 
 
+/**
+ * ******************* UpdateFixedImagePyramid ***********************
+ */
+
+template <class TElastix>
+void
+MultiResolutionRegistration<TElastix>::UpdateFixedImagePyramid(void)
+{
+  FixedImageDataCache * const cache = this->GetElastix()->GetFixedImageDataCache();
+
+  if (cache == nullptr)
+  {
+    Superclass1::UpdateFixedImagePyramid();
+    return;
+  }
+
+  FixedImagePyramidType & pyramid = *(this->GetModifiableFixedImagePyramid());
+  pyramid.SetNumberOfLevels(this->GetNumberOfLevels());
+  pyramid.SetInput(this->GetFixedImage());
+
+  const unsigned int elastixLevel = this->GetConfiguration()->GetElastixLevel();
+  const auto         makeKey = [this, elastixLevel](const unsigned int level) {
+    return this->GetElastix()->MakeFixedImageDataCacheKey("FixedImagePyramid", elastixLevel, level);
+  };
+
+  if (!RetrieveImagePyramidFromCache(*cache, pyramid, makeKey, true))
+  {
+    Superclass1::UpdateFixedImagePyramid();
+    StoreImagePyramidInCache(*cache, pyramid, makeKey, true);
+  }
+
+} // end UpdateFixedImagePyramid()
+
+
+/**
+ * ******************* UpdateMovingImagePyramid ***********************
+ */
+
+template <class TElastix>
+void
+MultiResolutionRegistration<TElastix>::UpdateMovingImagePyramid(void)
+{
+  FixedImageDataCache * const cache = this->GetElastix()->GetFixedImageDataCache();
+
+  if ((cache == nullptr) || this->GetElastix()->GetMovingImageDataCacheContentKey().empty())
+  {
+    Superclass1::UpdateMovingImagePyramid();
+    return;
+  }
+
+  MovingImagePyramidType & pyramid = *(this->GetModifiableMovingImagePyramid());
+  pyramid.SetNumberOfLevels(this->GetNumberOfLevels());
+  pyramid.SetInput(this->GetMovingImage());
+
+  /** The moving image data are only stored on disk, as the moving image usually differs for each registration. */
+  const unsigned int elastixLevel = this->GetConfiguration()->GetElastixLevel();
+  const auto         makeKey = [this, elastixLevel](const unsigned int level) {
+    return this->GetElastix()->MakeMovingImageDataCacheKey("MovingImagePyramid", elastixLevel, level);
+  };
+
+  if (!RetrieveImagePyramidFromCache(*cache, pyramid, makeKey, false))
+  {
+    Superclass1::UpdateMovingImagePyramid();
+    StoreImagePyramidInCache(*cache, pyramid, makeKey, false);
+  }
+
+} // end UpdateMovingImagePyramid()
+
+
+/**
+ * ******************* RetrieveImagePyramidFromCache ***********************
+ */
+
+template <class TElastix>
+template <class TPyramid, class TMakeKey>
+bool
+MultiResolutionRegistration<TElastix>::RetrieveImagePyramidFromCache(FixedImageDataCache & cache,
+                                                                     TPyramid &            pyramid,
+                                                                     const TMakeKey &      makeKey,
+                                                                     const bool            keepInMemory)
+{
+  typedef typename TPyramid::OutputImageType ImageType;
+
+  const unsigned int numberOfLevels = pyramid.GetNumberOfLevels();
+
+  /** Look for the pyramid images in the cache. */
+  std::vector<typename ImageType::Pointer> cachedImages;
+  for (unsigned int level = 0; level < numberOfLevels; ++level)
+  {
+    const auto cachedImage = cache.GetImage<ImageType>(makeKey(level), keepInMemory);
+    if (cachedImage == nullptr)
+    {
+      return false;
+    }
+    cachedImages.push_back(cachedImage);
+  }
+
+  /** Graft the cached images onto the pyramid outputs, and mark them as up-to-date,
+   * so that the pyramid does not need to be executed. */
+  pyramid.UpdateOutputInformation();
+  for (unsigned int level = 0; level < numberOfLevels; ++level)
+  {
+    ImageType & output = *(pyramid.GetOutput(level));
+    output.Graft(cachedImages[level]);
+    output.DataHasBeenGenerated();
+  }
+  return true;
+
+} // end RetrieveImagePyramidFromCache()
+
+
+/**
+ * ******************* StoreImagePyramidInCache ***********************
+ */
+
+template <class TElastix>
+template <class TPyramid, class TMakeKey>
+void
+MultiResolutionRegistration<TElastix>::StoreImagePyramidInCache(FixedImageDataCache & cache,
+                                                                TPyramid &            pyramid,
+                                                                const TMakeKey &      makeKey,
+                                                                const bool            keepInMemory)
+{
+  typedef typename TPyramid::OutputImageType ImageType;
+
+  const unsigned int numberOfLevels = pyramid.GetNumberOfLevels();
+
+  /** Store the pyramid images in the cache, unless the pyramid did not compute all of them. */
+  for (unsigned int level = 0; level < numberOfLevels; ++level)
+  {
+    if (pyramid.GetOutput(level)->GetBufferedRegion().GetNumberOfPixels() == 0)
+    {
+      return;
+    }
+  }
+  for (unsigned int level = 0; level < numberOfLevels; ++level)
+  {
+    const auto image = ImageType::New();
+    image->Graft(pyramid.GetOutput(level));
+    cache.SetImage(makeKey(level), image.GetPointer(), keepInMemory);
+  }
+
+} // end StoreImagePyramidInCache()
+
+
 /**
  * ************************* UpdateMasks ************************
  **/
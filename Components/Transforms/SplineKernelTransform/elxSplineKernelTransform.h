@@ -70,6 +70,22 @@ namespace elastix
  * Default: 0.3. You cannot specify this parameter for each resolution differently.\n
  * Valid values are withing -1.0 and 0.5. 0.5 means incompressible.
  * Negative values are a bit odd, but possible. See Wikipedia on PoissonRatio.
+ * \parameter SplineUseDecoupledSolver: for the ThinPlateSpline, ThinPlateR2LogRSpline
+ * and VolumeSpline the system of equations for the spline weights decouples per
+ * dimension. When set to true, only the much smaller decoupled system is solved,
+ * which is much faster and needs less memory for many landmarks. Ignored for the
+ * other kernel types.\n
+ *   example: <tt>(SplineUseDecoupledSolver "true")</tt>\n
+ * Default: false. You cannot specify this parameter for each resolution differently.
+ * \parameter SplineFarFieldApproximationTolerance: when larger than zero, clusters
+ * of landmarks far away from a point are approximated by a single landmark when
+ * transforming points, which makes transforming points much faster for many landmarks.
+ * A cluster is approximated if its radius is smaller than the tolerance times its
+ * distance to the point. Ignored for the ElasticBodySpline and
+ * ElasticBodyReciprocalSpline.\n
+ *   example: <tt>(SplineFarFieldApproximationTolerance 0.2)</tt>\n
+ * Default: 0.0, i.e. exact evaluation. You cannot specify this parameter for each
+ * resolution differently.
  *
  * \commandlinearg -fp: a file specifying a set of points that will serve
  * as fixed image landmarks.\n
@@ -104,6 +120,11 @@ namespace elastix
  *   example: <tt>(SplinePoissonRatio 0.3 )</tt>\n
  * Valid values are withing -1.0 and 0.5. 0.5 means incompressible.
  * Negative values are a bit odd, but possible. See Wikipedia on PoissonRatio.
+ * \transformparameter SplineUseDecoupledSolver: see above. Optional.\n
+ *   example: <tt>(SplineUseDecoupledSolver "true")</tt>\n
+ * \transformparameter SplineFarFieldApproximationTolerance: see above. Optional.
+ * Use this to speed up transformix for transforms with many landmarks.\n
+ *   example: <tt>(SplineFarFieldApproximationTolerance 0.2)</tt>\n
  * \transformparameter FixedImageLandmarks: The landmark positions in the
  * fixed image, in world coordinates. Positions written as x1 y1 [z1] x2 y2 [z2] etc.\n
  *   example: <tt>(FixedImageLandmarks 10.0 11.0 12.0 4.0 4.0 4.0 6.0 6.0 6.0 )</tt>
@@ -220,6 +241,12 @@ protected:
   virtual bool
   SetKernelType(const std::string & kernelType);
 
+  /** Read the SplineUseDecoupledSolver and SplineFarFieldApproximationTolerance
+   * options and pass them to the kernel transform.
+   */
+  virtual void
+  ReadAccelerationParameters(void);
+
   /** Read source landmarks from fp file
    * \li Try reading -fp file
    */
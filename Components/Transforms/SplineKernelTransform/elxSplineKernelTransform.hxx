@@ -187,6 +187,9 @@ SplineKernelTransform<TElastix>::BeforeRegistration(void)
   this->GetConfiguration()->ReadParameter(matrixInversionMethod, "TPSMatrixInversionMethod", 0, true);
   this->m_KernelTransform->SetMatrixInversionMethod(matrixInversionMethod);
 
+  /** Set the accelerated evaluation options, before setting the landmarks. */
+  this->ReadAccelerationParameters();
+
   /** Load fixed image (source) landmark positions. */
   this->DetermineSourceLandmarks();
 
@@ -207,6 +210,33 @@ SplineKernelTransform<TElastix>::BeforeRegistration(void)
 } // end BeforeRegistration()
 
 
+/**
+ * ************************* ReadAccelerationParameters *********************
+ */
+
+template <class TElastix>
+void
+SplineKernelTransform<TElastix>::ReadAccelerationParameters(void)
+{
+  /** Solve the decoupled scalar system, if the kernel allows it. */
+  bool useDecoupledSolver = false;
+  this->GetConfiguration()->ReadParameter(
+    useDecoupledSolver, "SplineUseDecoupledSolver", this->GetComponentLabel(), 0, -1, false);
+  this->m_KernelTransform->SetUseDecoupledSolver(useDecoupledSolver);
+
+  /** Tolerance of the far-field approximation; 0 means exact evaluation. */
+  double farFieldApproximationTolerance = 0.0;
+  this->GetConfiguration()->ReadParameter(farFieldApproximationTolerance,
+                                          "SplineFarFieldApproximationTolerance",
+                                          this->GetComponentLabel(),
+                                          0,
+                                          -1,
+                                          false);
+  this->m_KernelTransform->SetFarFieldApproximationTolerance(farFieldApproximationTolerance);
+
+} // end ReadAccelerationParameters()
+
+
 /**
  * ************************* DetermineSourceLandmarks *********************
  */
@@ -402,6 +432,9 @@ SplineKernelTransform<TElastix>::ReadFromFile(void)
   this->GetConfiguration()->ReadParameter(poissonRatio, "SplinePoissonRatio", this->GetComponentLabel(), 0, -1);
   this->m_KernelTransform->SetPoissonRatio(poissonRatio);
 
+  /** Set the accelerated evaluation options, before setting the landmarks. */
+  this->ReadAccelerationParameters();
+
   /** Read number of parameters. */
   unsigned int numberOfParameters = 0;
   this->GetConfiguration()->ReadParameter(numberOfParameters, "NumberOfParameters", 0);
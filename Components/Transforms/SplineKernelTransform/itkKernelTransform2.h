@@ -39,7 +39,9 @@ PURPOSE.  See the above copyright notices for more information.
 #include "itkVector.h"
 #include "itkMatrix.h"
 #include "itkPointSet.h"
+#include "itkPlatformMultiThreader.h"
 #include <deque>
+#include <vector>
 #include <math.h>
 #include <vnl/vnl_matrix_fixed.h>
 #include <vnl/vnl_matrix.h>
@@ -190,6 +192,20 @@ public:
   OutputPointType
   TransformPoint(const InputPointType & thisPoint) const override;
 
+  /** Compute the position of a batch of points in the new space.
+   * The points are distributed over the work units of the internal
+   * threader, each of which calls TransformPoint() for its share.
+   */
+  virtual void
+  TransformPoints(const std::vector<InputPointType> & inputPoints, std::vector<OutputPointType> & outputPoints) const;
+
+  /** Set the number of work units used by TransformPoints() and ComputeK(). */
+  virtual void
+  SetNumberOfWorkUnits(ThreadIdType numberOfThreads)
+  {
+    this->m_Threader->SetNumberOfWorkUnits(numberOfThreads);
+  }
+
   /** These vector transforms are not implemented for this transform. */
   OutputVectorType
   TransformVector(const InputVectorType &) const override
@@ -299,6 +315,41 @@ public:
   itkSetMacro(MatrixInversionMethod, std::string);
   itkGetConstReferenceMacro(MatrixInversionMethod, std::string);
 
+  /** Solve for the weights with the decoupled (scalar) system.
+   * For kernels with G = g * I (see m_FastComputationPossible) the L matrix is
+   * the Kronecker product of a scalar (n + d + 1)^2 matrix with I_d. When this
+   * option is on, only the scalar matrix is built and decomposed, which saves a
+   * factor d^2 in memory and d^3 in decomposition time. For other kernels
+   * this option is ignored.
+   */
+  virtual void
+  SetUseDecoupledSolver(bool _arg)
+  {
+    if (this->m_UseDecoupledSolver != _arg)
+    {
+      this->m_UseDecoupledSolver = _arg;
+      this->m_LMatrixComputed = false;
+      this->m_LInverseComputed = false;
+      this->m_LMatrixDecompositionComputed = false;
+      this->Modified();
+    }
+  }
+  itkGetConstMacro(UseDecoupledSolver, bool);
+  itkBooleanMacro(UseDecoupledSolver);
+
+  /** Tolerance of the far-field approximation used by TransformPoint().
+   * The source landmarks are organised in a kd-tree. The contribution of a
+   * cluster of landmarks with radius r at distance R of the input point is
+   * replaced by a second order expansion around the cluster center whenever
+   * r < tol * R. The approximation error decreases with the cube of the
+   * tolerance. A tolerance of 0 (the default) gives the exact evaluation.
+   * Typical values are in the range 0.1 - 0.3. Only used for kernels with
+   * G = g * I.
+   */
+  virtual void
+  SetFarFieldApproximationTolerance(double _arg);
+  itkGetConstMacro(FarFieldApproximationTolerance, double);
+
   /** Must be provided. */
   void
   GetSpatialJacobian(const InputPointType & ipp, SpatialJacobianType & sj) const override
@@ -409,6 +460,15 @@ protected:
   virtual void
   ComputeG(const InputVectorType & landmarkVector, GMatrixType & GMatrix) const;
 
+  /** Compute the scalar kernel g(r) and its first and second derivative with
+   * respect to r, for kernels with G(x) = g(|x|) * I. Used by the far-field
+   * approximation, which expands the kernel up to second order around the
+   * center of a landmark cluster. Must be reimplemented by subclasses that
+   * set m_FastComputationPossible.
+   */
+  virtual void
+  ComputeRadialKernel(const ScalarType r, ScalarType & g, ScalarType & dg, ScalarType & d2g) const;
+
   /** Compute a G(x) for a point to itself (i.e. for the block
    * diagonal elements of the matrix K. Parameter indicates for which
    * landmark the reflexive G is to be computed. The default
@@ -452,6 +512,21 @@ protected:
   void
   ReorganizeW(void);
 
+  /** Whether the decoupled scalar system is actually used. */
+  bool
+  GetDecoupledSolverIsUsed(void) const
+  {
+    return this->m_UseDecoupledSolver && this->m_FastComputationPossible;
+  }
+
+  /** Build the kd-tree for the far-field approximation, using the current D matrix. */
+  void
+  ComputeFarFieldTree(void);
+
+  /** Compute the deformation contribution using the far-field approximation. */
+  void
+  ComputeFarFieldDeformationContribution(const InputPointType & inputPoint, OutputPointType & result) const;
+
   /** Stiffness parameter. */
   double m_Stiffness;
 
@@ -535,6 +610,60 @@ private:
   void
   operator=(const Self &) = delete;
 
+  /** Typedefs for multi-threading. */
+  typedef itk::PlatformMultiThreader ThreaderType;
+  typedef ThreaderType::WorkUnitInfo ThreadInfoType;
+
+  struct MultiThreaderParameterType
+  {
+    Self *                              t_Self;
+    const std::vector<InputPointType> * t_InputPoints;
+    std::vector<OutputPointType> *      t_OutputPoints;
+  };
+
+  /** Multi-threaded ComputeK() and TransformPoints() callbacks. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeKThreaderCallback(void * arg);
+
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  TransformPointsThreaderCallback(void * arg);
+
+  /** Compute the rows of the K matrix assigned to this thread. */
+  void
+  ThreadedComputeK(ThreadIdType threadId);
+
+  /** A node of the far-field kd-tree. The landmarks of the node are
+   * m_FarFieldLandmarkOrder[ begin, end ). Leaves have no children (-1).
+   * The moments of the weights w_i around the center, with d_i = p_i - center,
+   * are sum_i w_i, sum_i w_i d_i^T, and sum_i w_i[ k ] d_i d_i^T for each k.
+   */
+  typedef Matrix<ScalarType, NDimensions, NDimensions> MomentMatrixType;
+  struct FarFieldNodeType
+  {
+    InputPointType   m_Center;
+    ScalarType       m_Radius;
+    OutputVectorType m_WeightSum;
+    MomentMatrixType m_FirstMoment;
+    MomentMatrixType m_SecondMoment[NDimensions];
+    unsigned long    m_Begin;
+    unsigned long    m_End;
+    long             m_LeftChild;
+    long             m_RightChild;
+  };
+
+  /** Recursively build a kd-tree node over m_FarFieldLandmarkOrder[ begin, end ). */
+  long
+  BuildFarFieldNode(unsigned long begin, unsigned long end);
+
+  ThreaderType::Pointer m_Threader{ ThreaderType::New() };
+
+  bool   m_UseDecoupledSolver{ false };
+  double m_FarFieldApproximationTolerance{ 0.0 };
+
+  std::vector<FarFieldNodeType> m_FarFieldTree;
+  std::vector<unsigned long>    m_FarFieldLandmarkOrder;
+  std::vector<InputPointType>   m_FarFieldLandmarks;
+
   TScalarType m_PoissonRatio;
 
   /** Using SVD or QR decomposition. */
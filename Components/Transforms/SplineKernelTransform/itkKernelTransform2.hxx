@@ -35,6 +35,8 @@ PURPOSE.  See the above copyright notices for more information.
 #define _itkKernelTransform2_hxx
 
 #include "itkKernelTransform2.h"
+#include <algorithm> // For nth_element.
+#include <numeric>   // For iota.
 
 namespace itk
 {
@@ -110,6 +112,7 @@ KernelTransform2<TScalarType, NDimensions>::SetSourceLandmarks(PointSetType * la
     this->m_LMatrixComputed = false;
     this->m_LInverseComputed = false;
     this->m_LMatrixDecompositionComputed = false;
+    this->m_FarFieldTree.clear();
 
     // you must recompute L and Linv - this does not require the targ landmarks
     this->ComputeLInverse();
@@ -161,6 +164,21 @@ KernelTransform2<TScalarType, NDimensions>::ComputeG(const InputVectorType &, GM
 } // end ComputeG()
 
 
+/**
+ * **************** ComputeRadialKernel ***********************************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+KernelTransform2<TScalarType, NDimensions>::ComputeRadialKernel(const ScalarType,
+                                                                ScalarType &,
+                                                                ScalarType &,
+                                                                ScalarType &) const
+{
+  itkExceptionMacro(<< "ComputeRadialKernel() should be reimplemented in the subclass !!");
+} // end ComputeRadialKernel()
+
+
 /**
  * ******************* ComputeReflexiveG *******************
  */
@@ -286,10 +304,29 @@ KernelTransform2<TScalarType, NDimensions>::ComputeWMatrix(void)
     itkExceptionMacro(<< "ERROR: invalid matrix inversion method (" << this->m_MatrixInversionMethod << ")");
   }
 
+  /** The decoupled system has one column per dimension. Interleave them
+   * to obtain the W matrix of the full system.
+   */
+  if (this->GetDecoupledSolverIsUsed())
+  {
+    const WMatrixType decoupledW = this->m_WMatrix;
+    this->m_WMatrix.set_size(NDimensions * decoupledW.rows(), 1);
+    for (unsigned int i = 0; i < decoupledW.rows(); ++i)
+    {
+      for (unsigned int dim = 0; dim < NDimensions; ++dim)
+      {
+        this->m_WMatrix(i * NDimensions + dim, 0) = decoupledW(i, dim);
+      }
+    }
+  }
+
   /** Reorganize W. */
   this->ReorganizeW();
   this->m_WMatrixComputed = true;
 
+  /** Update the weights of the far-field approximation. */
+  this->ComputeFarFieldTree();
+
 } // end ComputeWMatrix()
 
 
@@ -322,6 +359,27 @@ KernelTransform2<TScalarType, NDimensions>::ComputeLInverse(void)
     itkExceptionMacro(<< "ERROR: invalid matrix inversion method (" << this->m_MatrixInversionMethod << ")");
   }
 
+  /** The inverse of the full L matrix is the Kronecker product of the inverse
+   * of the decoupled L matrix with I_d.
+   */
+  if (this->GetDecoupledSolverIsUsed())
+  {
+    const LMatrixType  decoupledLInverse = this->m_LMatrixInverse;
+    const unsigned int size = decoupledLInverse.rows();
+    this->m_LMatrixInverse.set_size(NDimensions * size, NDimensions * size);
+    this->m_LMatrixInverse.fill(0.0);
+    for (unsigned int i = 0; i < size; ++i)
+    {
+      for (unsigned int j = 0; j < size; ++j)
+      {
+        for (unsigned int dim = 0; dim < NDimensions; ++dim)
+        {
+          this->m_LMatrixInverse(i * NDimensions + dim, j * NDimensions + dim) = decoupledLInverse(i, j);
+        }
+      }
+    }
+  }
+
 } // end ComputeLInverse()
 
 
@@ -334,13 +392,14 @@ void
 KernelTransform2<TScalarType, NDimensions>::ComputeL(void)
 {
   const unsigned long     numberOfLandmarks = this->m_SourceLandmarks->GetNumberOfPoints();
-  vnl_matrix<TScalarType> O2(NDimensions * (NDimensions + 1), NDimensions * (NDimensions + 1), 0);
+  const unsigned int      blockSize = this->GetDecoupledSolverIsUsed() ? 1 : NDimensions;
+  vnl_matrix<TScalarType> O2(blockSize * (NDimensions + 1), blockSize * (NDimensions + 1), 0);
 
   this->ComputeP();
   this->ComputeK();
 
-  this->m_LMatrix.set_size(NDimensions * (numberOfLandmarks + NDimensions + 1),
-                           NDimensions * (numberOfLandmarks + NDimensions + 1));
+  this->m_LMatrix.set_size(blockSize * (numberOfLandmarks + NDimensions + 1),
+                           blockSize * (numberOfLandmarks + NDimensions + 1));
   this->m_LMatrix.fill(0.0);
   this->m_LMatrix.update(this->m_KMatrix, 0, 0);
   this->m_LMatrix.update(this->m_PMatrix, 0, this->m_KMatrix.columns());
@@ -361,46 +420,100 @@ void
 KernelTransform2<TScalarType, NDimensions>::ComputeK(void)
 {
   const unsigned long numberOfLandmarks = this->m_SourceLandmarks->GetNumberOfPoints();
+  const unsigned int  blockSize = this->GetDecoupledSolverIsUsed() ? 1 : NDimensions;
   GMatrixType         G;
   const auto          G_ref = G.as_ref();
 
-  this->m_KMatrix.set_size(NDimensions * numberOfLandmarks, NDimensions * numberOfLandmarks);
+  this->m_KMatrix.set_size(blockSize * numberOfLandmarks, blockSize * numberOfLandmarks);
   this->m_KMatrix.fill(0.0);
 
+  // Compute the block diagonal elements, i.e. kernel for pi->pi
+  // Can ignore GMatrix, since p1 - p1 = 0
   PointsIterator p1 = this->m_SourceLandmarks->GetPoints()->Begin();
-  PointsIterator end = this->m_SourceLandmarks->GetPoints()->End();
-
-  // K matrix is symmetric, so only evaluate the upper triangle and
-  // store the values in both the upper and lower triangle
-  unsigned int i = 0;
-  while (p1 != end)
+  for (unsigned long i = 0; i < numberOfLandmarks; ++i, ++p1)
   {
-    PointsIterator p2 = p1; // start at the diagonal element
-    unsigned int   j = i;
-
-    // Compute the block diagonal element, i.e. kernel for pi->pi
-    // Can ignore GMatrix, since p1 - p1 = 0
     this->ComputeReflexiveG(p1, G);
-    this->m_KMatrix.update(G_ref, i * NDimensions, i * NDimensions);
-    p2++;
-    j++;
+    if (blockSize == 1)
+    {
+      this->m_KMatrix(i, i) = G(0, 0);
+    }
+    else
+    {
+      this->m_KMatrix.update(G_ref, i * NDimensions, i * NDimensions);
+    }
+  }
 
-    // Compute the upper (and copy into lower) triangular part of K
-    while (p2 != end)
+  // Compute the off-diagonal elements multi-threaded
+  MultiThreaderParameterType temp;
+  temp.t_Self = this;
+  temp.t_InputPoints = nullptr;
+  temp.t_OutputPoints = nullptr;
+  this->m_Threader->SetSingleMethod(this->ComputeKThreaderCallback, &temp);
+  this->m_Threader->SingleMethodExecute();
+
+} // end ComputeK()
+
+
+/**
+ * ******************* ComputeKThreaderCallback *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+KernelTransform2<TScalarType, NDimensions>::ComputeKThreaderCallback(void * arg)
+{
+  ThreadInfoType *             infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType                 threadId = infoStruct->WorkUnitID;
+  MultiThreaderParameterType * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
+
+  temp->t_Self->ThreadedComputeK(threadId);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeKThreaderCallback()
+
+
+/**
+ * ******************* ThreadedComputeK *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+KernelTransform2<TScalarType, NDimensions>::ThreadedComputeK(ThreadIdType threadId)
+{
+  const PointsContainer * points = this->m_SourceLandmarks->GetPoints();
+  const unsigned long     numberOfLandmarks = this->m_SourceLandmarks->GetNumberOfPoints();
+  const ThreadIdType      numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+  const bool              decoupled = this->GetDecoupledSolverIsUsed();
+  GMatrixType             G;
+  const auto              G_ref = G.as_ref();
+
+  // K matrix is symmetric, so only evaluate the upper triangle and
+  // store the values in both the upper and lower triangle.
+  // The rows are distributed cyclically over the threads, since
+  // the upper triangular part of a row gets shorter further down.
+  for (unsigned long i = threadId; i < numberOfLandmarks; i += numberOfThreads)
+  {
+    const InputPointType & p1 = points->ElementAt(i);
+    for (unsigned long j = i + 1; j < numberOfLandmarks; ++j)
     {
-      const InputVectorType s = p1.Value() - p2.Value();
+      const InputVectorType s = p1 - points->ElementAt(j);
       this->ComputeG(s, G);
       // write value in upper and lower triangle of matrix
-      this->m_KMatrix.update(G_ref, i * NDimensions, j * NDimensions);
-      this->m_KMatrix.update(G_ref, j * NDimensions, i * NDimensions);
-      p2++;
-      j++;
+      if (decoupled)
+      {
+        this->m_KMatrix(i, j) = G(0, 0);
+        this->m_KMatrix(j, i) = G(0, 0);
+      }
+      else
+      {
+        this->m_KMatrix.update(G_ref, i * NDimensions, j * NDimensions);
+        this->m_KMatrix.update(G_ref, j * NDimensions, i * NDimensions);
+      }
     }
-    p1++;
-    i++;
   }
 
-} // end ComputeK()
+} // end ThreadedComputeK()
 
 
 /**
@@ -420,6 +533,22 @@ KernelTransform2<TScalarType, NDimensions>::ComputeP(void)
   InputPointType p;
   p.Fill(0.0f);
 
+  /** The decoupled P matrix has rows [ p_i^T 1 ]. */
+  if (this->GetDecoupledSolverIsUsed())
+  {
+    this->m_PMatrix.set_size(numberOfLandmarks, NDimensions + 1);
+    for (unsigned long i = 0; i < numberOfLandmarks; ++i)
+    {
+      this->m_SourceLandmarks->GetPoint(i, &p);
+      for (unsigned int j = 0; j < NDimensions; ++j)
+      {
+        this->m_PMatrix(i, j) = p[j];
+      }
+      this->m_PMatrix(i, NDimensions) = 1.0;
+    }
+    return;
+  }
+
   this->m_PMatrix.set_size(NDimensions * numberOfLandmarks, NDimensions * (NDimensions + 1));
   this->m_PMatrix.fill(0.0f);
 
@@ -451,6 +580,22 @@ KernelTransform2<TScalarType, NDimensions>::ComputeY(void)
   typename VectorSetType::ConstIterator displacement = this->m_Displacements->Begin();
   const unsigned long                   numberOfLandmarks = this->m_SourceLandmarks->GetNumberOfPoints();
 
+  /** The decoupled Y matrix has one column per dimension. */
+  if (this->GetDecoupledSolverIsUsed())
+  {
+    this->m_YMatrix.set_size(numberOfLandmarks + NDimensions + 1, NDimensions);
+    this->m_YMatrix.fill(0.0);
+    for (unsigned long i = 0; i < numberOfLandmarks; ++i)
+    {
+      for (unsigned int j = 0; j < NDimensions; ++j)
+      {
+        this->m_YMatrix(i, j) = displacement.Value()[j];
+      }
+      ++displacement;
+    }
+    return;
+  }
+
   this->m_YMatrix.set_size(NDimensions * (numberOfLandmarks + NDimensions + 1), 1);
   this->m_YMatrix.fill(0.0);
 
@@ -525,7 +670,14 @@ KernelTransform2<TScalarType, NDimensions>::TransformPoint(const InputPointType
 {
   OutputPointType opp;
   opp.Fill(NumericTraits<typename OutputPointType::ValueType>::ZeroValue());
-  this->ComputeDeformationContribution(thisPoint, opp);
+  if (this->m_FarFieldTree.empty())
+  {
+    this->ComputeDeformationContribution(thisPoint, opp);
+  }
+  else
+  {
+    this->ComputeFarFieldDeformationContribution(thisPoint, opp);
+  }
 
   // Add the rotational part of the Affine component
   for (unsigned int j = 0; j < NDimensions; ++j)
@@ -547,6 +699,305 @@ KernelTransform2<TScalarType, NDimensions>::TransformPoint(const InputPointType
 } // end TransformPoint()
 
 
+/**
+ * ******************* TransformPoints *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+KernelTransform2<TScalarType, NDimensions>::TransformPoints(const std::vector<InputPointType> & inputPoints,
+                                                            std::vector<OutputPointType> &      outputPoints) const
+{
+  outputPoints.resize(inputPoints.size());
+
+  /** Fill the threader parameter struct with information. */
+  MultiThreaderParameterType temp;
+  temp.t_Self = const_cast<Self *>(this);
+  temp.t_InputPoints = &inputPoints;
+  temp.t_OutputPoints = &outputPoints;
+
+  /** Use a local threader, so that this function can be called concurrently. */
+  auto local_threader = ThreaderType::New();
+  local_threader->SetNumberOfWorkUnits(this->m_Threader->GetNumberOfWorkUnits());
+  local_threader->SetSingleMethod(this->TransformPointsThreaderCallback, &temp);
+  local_threader->SingleMethodExecute();
+
+} // end TransformPoints()
+
+
+/**
+ * ******************* TransformPointsThreaderCallback *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+KernelTransform2<TScalarType, NDimensions>::TransformPointsThreaderCallback(void * arg)
+{
+  ThreadInfoType *             infoStruct = static_cast<ThreadInfoType *>(arg);
+  const ThreadIdType           threadId = infoStruct->WorkUnitID;
+  const ThreadIdType           numberOfThreads = infoStruct->NumberOfWorkUnits;
+  MultiThreaderParameterType * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
+
+  const std::vector<InputPointType> & inputPoints = *(temp->t_InputPoints);
+  std::vector<OutputPointType> &      outputPoints = *(temp->t_OutputPoints);
+
+  /** Compute the range of points for this thread. */
+  const std::size_t numberOfPoints = inputPoints.size();
+  const std::size_t chunkSize = (numberOfPoints + numberOfThreads - 1) / numberOfThreads;
+  const std::size_t begin = std::min<std::size_t>(threadId * chunkSize, numberOfPoints);
+  const std::size_t end = std::min<std::size_t>(begin + chunkSize, numberOfPoints);
+
+  for (std::size_t i = begin; i < end; ++i)
+  {
+    outputPoints[i] = temp->t_Self->TransformPoint(inputPoints[i]);
+  }
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end TransformPointsThreaderCallback()
+
+
+/**
+ * ******************* SetFarFieldApproximationTolerance *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+KernelTransform2<TScalarType, NDimensions>::SetFarFieldApproximationTolerance(double tolerance)
+{
+  tolerance = tolerance > 0.0 ? tolerance : 0.0;
+  if (this->m_FarFieldApproximationTolerance != tolerance)
+  {
+    this->m_FarFieldApproximationTolerance = tolerance;
+    if (this->m_WMatrixComputed)
+    {
+      this->ComputeFarFieldTree();
+    }
+    this->Modified();
+  }
+
+} // end SetFarFieldApproximationTolerance()
+
+
+/**
+ * ******************* ComputeFarFieldTree *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+KernelTransform2<TScalarType, NDimensions>::ComputeFarFieldTree(void)
+{
+  this->m_FarFieldTree.clear();
+  this->m_FarFieldLandmarkOrder.clear();
+  this->m_FarFieldLandmarks.clear();
+
+  const unsigned long numberOfLandmarks = this->m_SourceLandmarks->GetNumberOfPoints();
+  if (!(this->m_FarFieldApproximationTolerance > 0.0) || !this->m_FastComputationPossible || numberOfLandmarks == 0)
+  {
+    return;
+  }
+
+  /** Copy the landmarks, for fast random access. */
+  this->m_FarFieldLandmarks.reserve(numberOfLandmarks);
+  PointsIterator sp = this->m_SourceLandmarks->GetPoints()->Begin();
+  for (unsigned long lnd = 0; lnd < numberOfLandmarks; ++lnd, ++sp)
+  {
+    this->m_FarFieldLandmarks.push_back(sp->Value());
+  }
+
+  this->m_FarFieldLandmarkOrder.resize(numberOfLandmarks);
+  std::iota(this->m_FarFieldLandmarkOrder.begin(), this->m_FarFieldLandmarkOrder.end(), 0UL);
+
+  this->BuildFarFieldNode(0, numberOfLandmarks);
+
+} // end ComputeFarFieldTree()
+
+
+/**
+ * ******************* BuildFarFieldNode *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+long
+KernelTransform2<TScalarType, NDimensions>::BuildFarFieldNode(unsigned long begin, unsigned long end)
+{
+  /** Nodes with at most this number of landmarks are not split further. */
+  const unsigned long maximumLeafSize = 16;
+
+  FarFieldNodeType node;
+  node.m_Begin = begin;
+  node.m_End = end;
+  node.m_LeftChild = -1;
+  node.m_RightChild = -1;
+  node.m_Center.Fill(0.0);
+  node.m_WeightSum.Fill(0.0);
+  node.m_FirstMoment.Fill(0.0);
+  for (unsigned int odim = 0; odim < NDimensions; ++odim)
+  {
+    node.m_SecondMoment[odim].Fill(0.0);
+  }
+
+  /** Compute the center, the summed weights and the bounding box. */
+  InputPointType lower = this->m_FarFieldLandmarks[this->m_FarFieldLandmarkOrder[begin]];
+  InputPointType upper = lower;
+  for (unsigned long k = begin; k < end; ++k)
+  {
+    const unsigned long    lnd = this->m_FarFieldLandmarkOrder[k];
+    const InputPointType & point = this->m_FarFieldLandmarks[lnd];
+    for (unsigned int dim = 0; dim < NDimensions; ++dim)
+    {
+      node.m_Center[dim] += point[dim];
+      node.m_WeightSum[dim] += this->m_DMatrix(dim, lnd);
+      lower[dim] = std::min(lower[dim], point[dim]);
+      upper[dim] = std::max(upper[dim], point[dim]);
+    }
+  }
+  for (unsigned int dim = 0; dim < NDimensions; ++dim)
+  {
+    node.m_Center[dim] /= static_cast<ScalarType>(end - begin);
+  }
+
+  /** The radius of the smallest sphere around the center enclosing all
+   * landmarks, and the moments of the weights around the center.
+   */
+  node.m_Radius = 0.0;
+  for (unsigned long k = begin; k < end; ++k)
+  {
+    const unsigned long   lnd = this->m_FarFieldLandmarkOrder[k];
+    const InputVectorType d = this->m_FarFieldLandmarks[lnd] - node.m_Center;
+    node.m_Radius = std::max(node.m_Radius, static_cast<ScalarType>(d.GetNorm()));
+    for (unsigned int odim = 0; odim < NDimensions; ++odim)
+    {
+      const ScalarType w = this->m_DMatrix(odim, lnd);
+      for (unsigned int i = 0; i < NDimensions; ++i)
+      {
+        node.m_FirstMoment(odim, i) += w * d[i];
+        for (unsigned int j = 0; j < NDimensions; ++j)
+        {
+          node.m_SecondMoment[odim](i, j) += w * d[i] * d[j];
+        }
+      }
+    }
+  }
+
+  const long nodeIndex = static_cast<long>(this->m_FarFieldTree.size());
+  this->m_FarFieldTree.push_back(node);
+
+  /** Split at the median along the dimension with the largest extent. */
+  if (end - begin > maximumLeafSize)
+  {
+    unsigned int splitDimension = 0;
+    for (unsigned int dim = 1; dim < NDimensions; ++dim)
+    {
+      if (upper[dim] - lower[dim] > upper[splitDimension] - lower[splitDimension])
+      {
+        splitDimension = dim;
+      }
+    }
+
+    const unsigned long middle = begin + (end - begin) / 2;
+    const auto &        landmarks = this->m_FarFieldLandmarks;
+    std::nth_element(this->m_FarFieldLandmarkOrder.begin() + begin,
+                     this->m_FarFieldLandmarkOrder.begin() + middle,
+                     this->m_FarFieldLandmarkOrder.begin() + end,
+                     [&landmarks, splitDimension](const unsigned long a, const unsigned long b) {
+                       return landmarks[a][splitDimension] < landmarks[b][splitDimension];
+                     });
+
+    /** Note that the tree may be reallocated during the recursion. */
+    const long leftChild = this->BuildFarFieldNode(begin, middle);
+    const long rightChild = this->BuildFarFieldNode(middle, end);
+    this->m_FarFieldTree[nodeIndex].m_LeftChild = leftChild;
+    this->m_FarFieldTree[nodeIndex].m_RightChild = rightChild;
+  }
+
+  return nodeIndex;
+
+} // end BuildFarFieldNode()
+
+
+/**
+ * ******************* ComputeFarFieldDeformationContribution *******************
+ *
+ * Barnes-Hut like evaluation of the deformation contribution. For clusters
+ * of landmarks that are far enough from the input point, the kernel is
+ * expanded up to second order around the cluster center c. With y = x - c,
+ * R = |y|, u = y / R and d_i = p_i - c:
+ *   sum_i w_i g(|y - d_i|) ~ g(R) sum_i w_i - g'(R) sum_i w_i (u^T d_i)
+ *     + 1/2 sum_i w_i d_i^T H d_i,
+ * where H = g''(R) u u^T + g'(R) / R (I - u u^T) is the Hessian of g(|y|).
+ * A first order (let alone zeroth order) expansion is not sufficient,
+ * since the TPS weights largely cancel within a cluster.
+ * Only valid for kernels with G = g * I.
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+KernelTransform2<TScalarType, NDimensions>::ComputeFarFieldDeformationContribution(const InputPointType & thisPoint,
+                                                                                   OutputPointType &      opp) const
+{
+  const ScalarType tolerance = this->m_FarFieldApproximationTolerance;
+  GMatrixType      Gmatrix;
+
+  /** The tree is balanced, so its depth is at most about 64. */
+  long         stack[128];
+  unsigned int stackSize = 0;
+  stack[stackSize++] = 0;
+
+  while (stackSize > 0)
+  {
+    const FarFieldNodeType & node = this->m_FarFieldTree[stack[--stackSize]];
+    const InputVectorType    toCenter = thisPoint - node.m_Center;
+
+    const ScalarType         distance = toCenter.GetNorm();
+
+    if (node.m_Radius < tolerance * distance)
+    {
+      /** Far field: a single evaluation of the kernel for the whole cluster. */
+      ScalarType g, dg, d2g;
+      this->ComputeRadialKernel(distance, g, dg, d2g);
+      const InputVectorType u = toCenter / distance;
+      for (unsigned int odim = 0; odim < NDimensions; ++odim)
+      {
+        ScalarType firstOrder = 0.0;
+        ScalarType uQu = 0.0;
+        ScalarType traceQ = 0.0;
+        for (unsigned int i = 0; i < NDimensions; ++i)
+        {
+          firstOrder += node.m_FirstMoment(odim, i) * u[i];
+          traceQ += node.m_SecondMoment[odim](i, i);
+          for (unsigned int j = 0; j < NDimensions; ++j)
+          {
+            uQu += u[i] * node.m_SecondMoment[odim](i, j) * u[j];
+          }
+        }
+        opp[odim] += g * node.m_WeightSum[odim] - dg * firstOrder +
+                     0.5 * (d2g * uQu + dg / distance * (traceQ - uQu));
+      }
+    }
+    else if (node.m_LeftChild < 0)
+    {
+      /** Near field: exact evaluation for all landmarks in the leaf. */
+      for (unsigned long k = node.m_Begin; k < node.m_End; ++k)
+      {
+        const unsigned long lnd = this->m_FarFieldLandmarkOrder[k];
+        this->ComputeG(thisPoint - this->m_FarFieldLandmarks[lnd], Gmatrix);
+        for (unsigned int odim = 0; odim < NDimensions; ++odim)
+        {
+          opp[odim] += Gmatrix(0, 0) * this->m_DMatrix(odim, lnd);
+        }
+      }
+    }
+    else
+    {
+      stack[stackSize++] = node.m_LeftChild;
+      stack[stackSize++] = node.m_RightChild;
+    }
+  }
+
+} // end ComputeFarFieldDeformationContribution()
+
+
 /**
  * ******************* SetIdentity *******************
  *
@@ -649,6 +1100,7 @@ KernelTransform2<TScalarType, NDimensions>::SetFixedParameters(const ParametersT
   this->m_LMatrixComputed = false;
   this->m_LInverseComputed = false;
   this->m_LMatrixDecompositionComputed = false;
+  this->m_FarFieldTree.clear();
 
   // you must recompute L and Linv - this does not require the targ lms
   this->ComputeLInverse();
@@ -895,6 +1347,9 @@ KernelTransform2<TScalarType, NDimensions>::PrintSelf(std::ostream & os, Indent
   os << indent << "FastComputationPossible: " << this->m_FastComputationPossible << std::endl;
   os << indent << "PoissonRatio: " << this->m_PoissonRatio << std::endl;
   os << indent << "MatrixInversionMethod: " << this->m_MatrixInversionMethod << std::endl;
+  os << indent << "UseDecoupledSolver: " << this->m_UseDecoupledSolver << std::endl;
+  os << indent << "FarFieldApproximationTolerance: " << this->m_FarFieldApproximationTolerance << std::endl;
+  os << indent << "FarFieldTree: " << this->m_FarFieldTree.size() << " nodes" << std::endl;
 
   /** Just print the sizes of these matrices, not their contents. */
   os << indent << "LMatrix: " << this->m_LMatrix.rows() << " x " << this->m_LMatrix.cols() << std::endl;
@@ -52,6 +52,21 @@ ThinPlateR2LogRSplineKernelTransform2<TScalarType, NDimensions>::ComputeG(const
 }
 
 
+template <class TScalarType, unsigned int NDimensions>
+void
+ThinPlateR2LogRSplineKernelTransform2<TScalarType, NDimensions>::ComputeRadialKernel(const ScalarType r,
+                                                                                     ScalarType &     g,
+                                                                                     ScalarType &     dg,
+                                                                                     ScalarType &     d2g) const
+{
+  const TScalarType logR = (r > 1e-8) ? std::log(r) : NumericTraits<TScalarType>::Zero;
+  g = r * r * logR;
+  dg = 2.0 * r * logR + r;
+  d2g = 2.0 * logR + 3.0;
+
+} // end ComputeRadialKernel()
+
+
 template <class TScalarType, unsigned int NDimensions>
 void
 ThinPlateR2LogRSplineKernelTransform2<TScalarType, NDimensions>::ComputeDeformationContribution(
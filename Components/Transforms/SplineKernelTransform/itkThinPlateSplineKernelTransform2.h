@@ -110,6 +110,10 @@ protected:
   void
   ComputeG(const InputVectorType & x, GMatrixType & GMatrix) const override;
 
+  /** Compute the scalar kernel g(r) = r and its first and second derivative. */
+  void
+  ComputeRadialKernel(const ScalarType r, ScalarType & g, ScalarType & dg, ScalarType & d2g) const override;
+
   /** Compute the contribution of the landmarks weighted by the kernel function
    * to the global deformation of the space.
    */
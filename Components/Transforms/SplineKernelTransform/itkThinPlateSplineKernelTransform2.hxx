@@ -55,6 +55,20 @@ ThinPlateSplineKernelTransform2<TScalarType, NDimensions>::ComputeG(const InputV
 } // end ComputeG()
 
 
+template <class TScalarType, unsigned int NDimensions>
+void
+ThinPlateSplineKernelTransform2<TScalarType, NDimensions>::ComputeRadialKernel(const ScalarType r,
+                                                                               ScalarType &     g,
+                                                                               ScalarType &     dg,
+                                                                               ScalarType &     d2g) const
+{
+  g = r;
+  dg = 1.0;
+  d2g = 0.0;
+
+} // end ComputeRadialKernel()
+
+
 /**
  * ******************* ComputeDeformationContribution *******************
  */
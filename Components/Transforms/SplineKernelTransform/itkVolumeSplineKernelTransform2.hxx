@@ -55,6 +55,20 @@ VolumeSplineKernelTransform2<TScalarType, NDimensions>::ComputeG(const InputVect
 } // end ComputeG()
 
 
+template <class TScalarType, unsigned int NDimensions>
+void
+VolumeSplineKernelTransform2<TScalarType, NDimensions>::ComputeRadialKernel(const ScalarType r,
+                                                                            ScalarType &     g,
+                                                                            ScalarType &     dg,
+                                                                            ScalarType &     d2g) const
+{
+  g = r * r * r;
+  dg = 3.0 * r * r;
+  d2g = 6.0 * r;
+
+} // end ComputeRadialKernel()
+
+
 template <class TScalarType, unsigned int NDimensions>
 void
 VolumeSplineKernelTransform2<TScalarType, NDimensions>::ComputeDeformationContribution(const InputPointType & thisPoint,
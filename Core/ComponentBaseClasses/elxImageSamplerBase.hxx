@@ -20,6 +20,7 @@
 #define elxImageSamplerBase_hxx
 
 #include "elxImageSamplerBase.h"
+#include "itkImageRandomSamplerBase.h"
 
 namespace elastix
 {
@@ -62,6 +63,14 @@ ImageSamplerBase<TElastix>::BeforeEachResolutionBase(void)
     this->GetAsITKBaseType()->SetUseMultiThread(false);
   }
 
+  /** Random samplers draw from the random number generator of this registration. */
+  typedef itk::ImageRandomSamplerBase<InputImageType> RandomSamplerType;
+  RandomSamplerType * randomSampler = dynamic_cast<RandomSamplerType *>(this->GetAsITKBaseType());
+  if (randomSampler != nullptr)
+  {
+    randomSampler->SetRandomGenerator(this->GetElastix()->GetRandomGenerator());
+  }
+
 } // end BeforeEachResolutionBase()
 
 
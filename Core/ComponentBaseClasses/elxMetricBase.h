@@ -23,6 +23,8 @@
 
 #include "elxBaseComponentSE.h"
 #include "itkAdvancedImageToImageMetric.h"
+#include "itkSingleValuedPointSetToPointSetMetric.h"
+#include "itkParzenWindowHistogramImageToImageMetric.h"
 #include "itkImageGridSampler.h"
 #include "itkPointSet.h"
 
@@ -63,6 +65,34 @@ namespace elastix
  *    CheckNumberOfSamples. \n
  *    example: <tt>(RequiredRatioOfValidSamples 0.1)</tt> \n
  *    The default is 0.25.
+ * \parameter UseInitialTransformCache: Whether the metric caches the mapped points
+ *    and spatial Jacobians of the initial transform at the samples, when the initial
+ *    transform is composed with the current transform. Only the current transform is
+ *    then evaluated in each iteration. This only pays off when the same samples are used
+ *    in every iteration, for example with the Grid or Full sampler, or with
+ *    (NewSamplesEveryIteration "false"). Can be given for each resolution or for all
+ *    resolutions at once. \n
+ *    example: <tt>(UseInitialTransformCache "true")</tt> \n
+ *    The default is false.
+ * \parameter PartitionSamplesByStackSlice: Whether a groupwise metric (VarianceOverLastDimensionMetric
+ *    or PCAMetric2) with a stack transform (EulerStackTransform, AffineLogStackTransform,
+ *    BSplineStackTransform, etc.) assembles its derivative per slice of the stack, letting each
+ *    thread compute the derivative contributions of the slices of its own sub transforms. The
+ *    threads then write into disjoint parts of the derivative, instead of each accumulating a
+ *    full-size derivative that is summed afterwards. Only has an effect when multi-threading is
+ *    used. Can be given for each resolution or for all resolutions at once. \n
+ *    example: <tt>(PartitionSamplesByStackSlice "true")</tt> \n
+ *    The default is false.
+ * \parameter ShareJointHistogram: Whether a histogram-based metric (like AdvancedMattesMutualInformation
+ *    or NormalizedMutualInformation) within a multi-metric registration reuses the joint histogram
+ *    of the first preceding histogram-based metric, instead of sampling and binning again. The
+ *    histogram is only reused when both metrics have the same images, masks, image sampler,
+ *    interpolator, histogram bins and Parzen kernels, and limiters of the same type with the same
+ *    bounds (as determined by the limit range ratios); otherwise each metric computes its own. So
+ *    only a single ImageSampler and a single Interpolator should be specified, which are then used
+ *    by all metrics. Can be given for each resolution or for all resolutions at once. \n
+ *    example: <tt>(ShareJointHistogram "false" "true")</tt> \n
+ *    The default is false.
  *
  * \ingroup Metrics
  * \ingroup ComponentBaseClasses
@@ -126,6 +156,12 @@ public:
                                                      CoordinateRepresentationType>>
     MovingPointSetType;
 
+  /** Typedef for point set metrics. */
+  typedef itk::SingleValuedPointSetToPointSetMetric<FixedPointSetType, MovingPointSetType> PointSetMetricType;
+
+  /** Typedef for histogram-based metrics, which may share their joint histogram. */
+  typedef itk::ParzenWindowHistogramImageToImageMetric<FixedImageType, MovingImageType> HistogramMetricType;
+
   /** Typedefs for sampler support. */
   typedef typename AdvancedMetricType::ImageSamplerType ImageSamplerBaseType;
 
@@ -155,6 +191,12 @@ public:
   void
   BeforeEachResolutionBase(void) override;
 
+  /** Execute stuff after each resolution:
+   * \li Store the fixed image extrema into the FixedImageDataCache, if there is one.
+   */
+  void
+  AfterEachResolutionBase(void) override;
+
   /** Execute stuff after each iteration:
    * \li Optionally compute the exact metric value and plot it to screen.
    */
@@ -238,6 +280,10 @@ protected:
 private:
   elxDeclarePureVirtualGetSelfMacro(ITKBaseType);
 
+  /** Makes a key for the FixedImageDataCache, specific to this metric, elastix level and resolution. */
+  std::string
+  GetFixedImageDataCacheKey(const std::string & name, const unsigned int level) const;
+
   /** The deleted copy constructor. */
   MetricBase(const Self &) = delete;
   /** The deleted assignment operator. */
@@ -158,6 +158,21 @@ MetricBase<TElastix>::BeforeEachResolutionBase(void)
       useMultiThreading, "UseMultiThreadingForMetrics", this->GetComponentLabel(), level, 0);
 
     thisAsAdvanced->SetUseMultiThread(useMultiThreading);
+
+    /** Should the initial transform be cached at the samples? */
+    bool useInitialTransformCache = false;
+    this->GetConfiguration()->ReadParameter(
+      useInitialTransformCache, "UseInitialTransformCache", this->GetComponentLabel(), level, 0, false);
+    thisAsAdvanced->SetUseInitialTransformCache(useInitialTransformCache);
+
+    /** Should the groupwise derivative be assembled per stack slice? */
+    bool partitionSamplesByStackSlice = false;
+    this->GetConfiguration()->ReadParameter(
+      partitionSamplesByStackSlice, "PartitionSamplesByStackSlice", this->GetComponentLabel(), level, 0, false);
+    thisAsAdvanced->SetPartitionSamplesByStackSlice(partitionSamplesByStackSlice);
+
+    /** Metrics that sample randomly draw from the random number generator of this registration. */
+    thisAsAdvanced->SetRandomGenerator(this->GetElastix()->GetRandomGenerator());
     if (useMultiThreading)
     {
       std::string tmp = this->m_Configuration->GetCommandLineArgument("-threads");
@@ -168,11 +183,142 @@ MetricBase<TElastix>::BeforeEachResolutionBase(void)
       }
     }
 
+    /** Retrieve the fixed image extrema from the cache, when available. */
+    FixedImageDataCache * const cache = this->GetElastix()->GetFixedImageDataCache();
+    if ((cache != nullptr) && thisAsAdvanced->GetUseFixedImageLimiter())
+    {
+      FixedImageDataCache::ValuesType extrema;
+      if (cache->GetValues(this->GetFixedImageDataCacheKey("FixedImageTrueExtrema", level), extrema) &&
+          (extrema.size() == 2))
+      {
+        typedef typename AdvancedMetricType::FixedImagePixelType FixedImagePixelType;
+        thisAsAdvanced->SetFixedImageTrueExtrema(static_cast<FixedImagePixelType>(extrema[0]),
+                                                 static_cast<FixedImagePixelType>(extrema[1]));
+      }
+    }
+
   } // end advanced metric
 
+  /** Cast this to PointSetMetricType. */
+  PointSetMetricType * thisAsPointSetMetric = dynamic_cast<PointSetMetricType *>(this);
+
+  /** Point set metrics may use multi-threading as well. */
+  if (thisAsPointSetMetric != nullptr)
+  {
+    /** Should the metric use multi-threading? */
+    bool useMultiThreading = true;
+    this->GetConfiguration()->ReadParameter(
+      useMultiThreading, "UseMultiThreadingForMetrics", this->GetComponentLabel(), level, 0);
+
+    thisAsPointSetMetric->SetUseMultiThread(useMultiThreading);
+    if (useMultiThreading)
+    {
+      std::string tmp = this->m_Configuration->GetCommandLineArgument("-threads");
+      if (!tmp.empty())
+      {
+        const unsigned int nrOfThreads = atoi(tmp.c_str());
+        thisAsPointSetMetric->SetNumberOfWorkUnits(nrOfThreads);
+      }
+    }
+
+  } // end point set metric
+
+  /** Cast this to HistogramMetricType. */
+  HistogramMetricType * thisAsHistogramMetric = dynamic_cast<HistogramMetricType *>(this);
+
+  /** Histogram-based metrics may reuse the joint histogram of a preceding histogram-based metric. */
+  if (thisAsHistogramMetric != nullptr)
+  {
+    /** Stop keeping a copy of the joint histogram, unless a succeeding metric (which is handled after this one)
+     * reuses it in this resolution.
+     */
+    thisAsHistogramMetric->SetShareJointPDF(false);
+
+    bool shareJointHistogram = false;
+    this->GetConfiguration()->ReadParameter(
+      shareJointHistogram, "ShareJointHistogram", this->GetComponentLabel(), level, 0);
+
+    /** Find the first histogram-based metric that precedes this one. */
+    HistogramMetricType * source = nullptr;
+    if (shareJointHistogram)
+    {
+      const unsigned int numberOfMetrics = this->GetElastix()->GetNumberOfMetrics();
+      for (unsigned int i = 0; (i < numberOfMetrics) && (source == nullptr); ++i)
+      {
+        MetricBase * const metric = this->GetElastix()->GetElxMetricBase(i);
+        if (metric == this)
+        {
+          break;
+        }
+        source = dynamic_cast<HistogramMetricType *>(metric);
+      }
+
+      if (source == nullptr)
+      {
+        xl::xout["warning"] << "WARNING: ShareJointHistogram is set for " << this->GetComponentLabel()
+                            << ", but no histogram-based metric precedes it.\n"
+                            << "  The joint histogram is not shared." << std::endl;
+      }
+    }
+
+    /** The joint histogram is only reused when both metrics get their samples from the same image sampler. */
+    if ((source != nullptr) && (source->GetImageSampler() != thisAsHistogramMetric->GetImageSampler()))
+    {
+      xl::xout["warning"] << "WARNING: ShareJointHistogram is set for " << this->GetComponentLabel()
+                          << ", but it does not have the same ImageSampler as the preceding histogram-based metric.\n"
+                          << "  The joint histogram is not shared. Specify a single ImageSampler for all metrics."
+                          << std::endl;
+      source = nullptr;
+    }
+
+    if (source != nullptr)
+    {
+      source->SetShareJointPDF(true);
+    }
+    thisAsHistogramMetric->SetJointPDFSource(source);
+
+  } // end histogram metric
+
 } // end BeforeEachResolutionBase()
 
 
+/**
+ * ******************* AfterEachResolutionBase ******************
+ */
+
+template <class TElastix>
+void
+MetricBase<TElastix>::AfterEachResolutionBase(void)
+{
+  /** Store the fixed image extrema that were used during this resolution into the cache. */
+  FixedImageDataCache * const cache = this->GetElastix()->GetFixedImageDataCache();
+  const AdvancedMetricType *  thisAsAdvanced = dynamic_cast<const AdvancedMetricType *>(this);
+
+  if ((cache != nullptr) && (thisAsAdvanced != nullptr) && thisAsAdvanced->GetUseFixedImageLimiter())
+  {
+    const unsigned int level = this->m_Registration->GetAsITKBaseType()->GetCurrentLevel();
+    cache->SetValues(this->GetFixedImageDataCacheKey("FixedImageTrueExtrema", level),
+                     { static_cast<double>(thisAsAdvanced->GetFixedImageTrueMin()),
+                       static_cast<double>(thisAsAdvanced->GetFixedImageTrueMax()) });
+  }
+
+} // end AfterEachResolutionBase()
+
+
+/**
+ * ******************* GetFixedImageDataCacheKey ******************
+ */
+
+template <class TElastix>
+std::string
+MetricBase<TElastix>::GetFixedImageDataCacheKey(const std::string & name, const unsigned int level) const
+{
+  return this->GetElastix()->MakeFixedImageDataCacheKey(
+    name + this->GetComponentLabel(), this->GetConfiguration()->GetElastixLevel(), level);
+
+} // end GetFixedImageDataCacheKey()
+
+
 /**
  * ******************* AfterEachIterationBase ******************
  */
@@ -28,6 +28,9 @@
 #include "itkImageMaskSpatialObject.h"
 #include "itkErodeMaskImageFilter.h"
 
+#include <map>
+#include <utility> // For pair.
+
 namespace elastix
 {
 
@@ -212,6 +215,14 @@ protected:
 private:
   elxDeclarePureVirtualGetSelfMacro(ITKBaseType);
 
+  /** The erosion filters, for each mask and pyramid. They are kept during the registration, because an erosion filter
+   * computes the erosions of all resolution levels at once.
+   */
+  mutable std::map<std::pair<const FixedMaskImageType *, const FixedImagePyramidType *>, FixedMaskErodeFilterPointer>
+    m_FixedMaskErodeFilters;
+  mutable std::map<std::pair<const MovingMaskImageType *, const MovingImagePyramidType *>, MovingMaskErodeFilterPointer>
+    m_MovingMaskErodeFilters;
+
   /** The deleted copy constructor. */
   RegistrationBase(const Self &) = delete;
   /** The deleted assignment operator. */
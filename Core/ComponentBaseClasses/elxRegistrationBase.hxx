@@ -116,8 +116,29 @@ RegistrationBase<TElastix>::GenerateFixedMaskSpatialObject(const FixedMaskImageT
     return fixedMaskSpatialObject;
   }
 
-  /** Erode, and convert to spatial object. */
-  FixedMaskErodeFilterPointer erosion = FixedMaskErodeFilterType::New();
+  /** Retrieve the eroded mask from the cache, when available. Only the first fixed mask is cached. */
+  FixedImageDataCache * const cache = this->GetElastix()->GetFixedImageDataCache();
+  const bool                  useCache = (cache != nullptr) && (maskImage == this->GetElastix()->GetFixedMask());
+  const std::string           cacheKey = this->GetElastix()->MakeFixedImageDataCacheKey(
+    "ErodedFixedMask", this->GetConfiguration()->GetElastixLevel(), level);
+
+  if (useCache)
+  {
+    const auto cachedMask = cache->GetImage<FixedMaskImageType>(cacheKey);
+    if (cachedMask != nullptr)
+    {
+      fixedMaskSpatialObject->SetImage(cachedMask);
+      fixedMaskSpatialObject->Update();
+      return fixedMaskSpatialObject;
+    }
+  }
+
+  /** Erode, and convert to spatial object. The erosion filter of this mask is reused for the next resolution levels. */
+  FixedMaskErodeFilterPointer & erosion = this->m_FixedMaskErodeFilters[std::make_pair(maskImage, pyramid)];
+  if (erosion.IsNull())
+  {
+    erosion = FixedMaskErodeFilterType::New();
+  }
   erosion->SetInput(maskImage);
   erosion->SetSchedule(pyramid->GetSchedule());
   erosion->SetIsMovingMask(false);
@@ -145,6 +166,11 @@ RegistrationBase<TElastix>::GenerateFixedMaskSpatialObject(const FixedMaskImageT
   /** Release some memory. */
   erodedFixedMaskAsImage->DisconnectPipeline();
 
+  if (useCache)
+  {
+    cache->SetImage(cacheKey, erodedFixedMaskAsImage.GetPointer());
+  }
+
   fixedMaskSpatialObject->SetImage(erodedFixedMaskAsImage);
   fixedMaskSpatialObject->Update();
   return fixedMaskSpatialObject;
@@ -178,8 +204,12 @@ RegistrationBase<TElastix>::GenerateMovingMaskSpatialObject(const MovingMaskImag
     return movingMaskSpatialObject;
   }
 
-  /** Erode, and convert to spatial object. */
-  MovingMaskErodeFilterPointer erosion = MovingMaskErodeFilterType::New();
+  /** Erode, and convert to spatial object. The erosion filter of this mask is reused for the next resolution levels. */
+  MovingMaskErodeFilterPointer & erosion = this->m_MovingMaskErodeFilters[std::make_pair(maskImage, pyramid)];
+  if (erosion.IsNull())
+  {
+    erosion = MovingMaskErodeFilterType::New();
+  }
   erosion->SetInput(maskImage);
   erosion->SetSchedule(pyramid->GetSchedule());
   erosion->SetIsMovingMask(true);
@@ -436,6 +436,27 @@ ResamplerBase<TElastix>::CreateItkResultImage(void)
   const auto progressObserver =
     BaseComponent::IsElastixLibrary() ? nullptr : ProgressCommandType::CreateAndConnect(*(this->GetAsITKBaseType()));
 
+  /** Resample straight into the caller-provided result image buffer, if there is one that fits.
+   * The output must then not be released before the update, as that would discard the buffer.
+   */
+  const auto resultImageBuffer = dynamic_cast<OutputImageType *>(this->m_Elastix->GetResultImageBuffer());
+  if (resultImageBuffer != nullptr)
+  {
+    this->GetAsITKBaseType()->UpdateOutputInformation();
+    OutputImageType & output = *(this->GetAsITKBaseType()->GetOutput());
+
+    if (resultImageBuffer->GetPixelContainer()->Size() == output.GetLargestPossibleRegion().GetNumberOfPixels())
+    {
+      this->GetAsITKBaseType()->ReleaseDataBeforeUpdateFlagOff();
+      output.SetPixelContainer(resultImageBuffer->GetPixelContainer());
+    }
+    else
+    {
+      xl::xout["warning"] << "WARNING: The size of the result image buffer does not match the result image.\n"
+                          << "  A new buffer is allocated for the result image instead." << std::endl;
+    }
+  }
+
   /** Do the resampling. */
   try
   {
@@ -497,77 +518,56 @@ ResamplerBase<TElastix>::CreateItkResultImage(void)
   typedef itk::CastImageFilter<InputImageType, itk::Image<float, InputImageType::ImageDimension>>  CastFilterFloat;
   typedef itk::CastImageFilter<InputImageType, itk::Image<double, InputImageType::ImageDimension>> CastFilterDouble;
 
-  /** cast the image to the correct output image Type */
-  if (resultImagePixelType == "char")
-  {
-    auto castFilter = CastFilterChar::New();
+  /** Cast the image to the correct output image type. When the output pixel type is equal to the
+   * pixel type of the resampler, the cast is done in place, avoiding a copy of the image.
+   */
+  const auto castImage = [&infoChanger](const auto castFilter) -> itk::DataObject::Pointer {
     castFilter->SetInput(infoChanger->GetOutput());
+    castFilter->InPlaceOn();
     castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    return castFilter->GetOutput();
+  };
+
+  if (resultImagePixelType == "char")
+  {
+    resultImage = castImage(CastFilterChar::New());
   }
   if (resultImagePixelType == "unsigned char")
   {
-    auto castFilter = CastFilterUChar::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = castImage(CastFilterUChar::New());
   }
   else if (resultImagePixelType == "short")
   {
-    auto castFilter = CastFilterShort::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = castImage(CastFilterShort::New());
   }
   else if (resultImagePixelType == "ushort" ||
            resultImagePixelType == "unsigned short") // <-- ushort for backwards compatibility
   {
-    auto castFilter = CastFilterUShort::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = castImage(CastFilterUShort::New());
   }
   else if (resultImagePixelType == "int")
   {
-    auto castFilter = CastFilterInt::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = castImage(CastFilterInt::New());
   }
   else if (resultImagePixelType == "unsigned int")
   {
-    auto castFilter = CastFilterUInt::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = castImage(CastFilterUInt::New());
   }
   else if (resultImagePixelType == "long")
   {
-    auto castFilter = CastFilterLong::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = castImage(CastFilterLong::New());
   }
   else if (resultImagePixelType == "unsigned long")
   {
-    auto castFilter = CastFilterULong::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = castImage(CastFilterULong::New());
   }
   else if (resultImagePixelType == "float")
   {
-    auto castFilter = CastFilterFloat::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = castImage(CastFilterFloat::New());
   }
   else if (resultImagePixelType == "double")
   {
-    auto castFilter = CastFilterDouble::New();
-    castFilter->SetInput(infoChanger->GetOutput());
-    castFilter->Update();
-    resultImage = castFilter->GetOutput();
+    resultImage = castImage(CastFilterDouble::New());
   }
 
   if (resultImage.IsNull())
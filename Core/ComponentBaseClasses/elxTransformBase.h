@@ -25,6 +25,7 @@
 #include "elxElastixBase.h"
 #include "itkAdvancedTransform.h"
 #include "itkAdvancedCombinationTransform.h"
+#include "itkFlattenedTransform.h"
 #include "elxComponentDatabase.h"
 #include "elxProgressCommand.h"
 
@@ -53,6 +54,35 @@ namespace elastix
  *   "Compose" by composition: \f$T(x) = T_1 ( T_0(x) )\f$.\n
  *   example: <tt>(HowToCombineTransforms "Add")</tt>\n
  *   Default: "Add".
+ * \parameter FlattenInitialTransform: Whether or not to replace the initial transform (the chain
+ *   of transforms given by -t0 or by the previous parameter files) by a single dense field,
+ *   sampled once on the fixed image grid. Every evaluation of the initial transform then costs
+ *   one linear interpolation, instead of one evaluation per transform in the chain. Outside the
+ *   fixed image domain the original initial transform is evaluated. The flattened initial
+ *   transform is only used during the optimization: the final resampling uses the original
+ *   initial transform, to which the transform parameter file still refers, so that its result
+ *   is the same as the result of transformix. The flattened initial transform has no
+ *   spatial Hessian, so it cannot be combined with penalty terms that need one, like the
+ *   TransformBendingEnergyPenalty.\n
+ *   example: <tt>(FlattenInitialTransform "true")</tt>\n
+ *   Default: "false".
+ * \parameter FlattenInitialTransformGridSpacing: The distance between the nodes of the flattened
+ *   initial transform, in voxels of the fixed image. Larger values reduce memory usage, at the cost
+ *   of a coarser approximation of the initial transform.\n
+ *   example: <tt>(FlattenInitialTransformGridSpacing 4)</tt>\n
+ *   Default: the smallest value for which the flattened initial transform has at most 4194304 nodes.
+ * \parameter WriteTransformParametersToBinaryFile: When "true", the transform parameters are not
+ *   written as text to the TransformParameters line of the transform parameter file, but to a
+ *   binary file next to it (with extension ".bin"), which the transform parameter file refers to
+ *   by TransformParametersBinaryFileName. Recommended for transforms with a large number of
+ *   parameters, like B-splines with a fine control point grid: the binary file is much smaller,
+ *   and is read without text parsing.\n
+ *   example: <tt>(WriteTransformParametersToBinaryFile "true")</tt>\n
+ *   Default: "false".
+ * \parameter TransformParametersBinaryValueType: The value type of the binary transform
+ *   parameters file, either "double" (exact), or "float" (half the size, but rounded).\n
+ *   example: <tt>(TransformParametersBinaryValueType "float")</tt>\n
+ *   Default: "double".
  *
  * \transformparameter UseDirectionCosines: Controls whether to use or ignore the
  * direction cosines (world matrix, transform matrix) set in the images.
@@ -99,6 +129,31 @@ namespace elastix
  * The number of entries is stored the NumberOfParameters entry.
  * \transformparameter NumberOfParameters: the length of the transform parameter vector.\n
  * example <tt>(NumberOfParameters 722)</tt>\n
+ * \transformparameter FlattenTransformChain: Whether or not transformix should replace this transform,
+ * together with its chain of initial transforms (InitialTransformParametersFileName), by a single
+ * transform, when resampling the input image. If all transforms in the chain are linear, they are
+ * composed into a single affine transform. Otherwise the chain is sampled once at the output grid
+ * (Size, Index, Spacing, Origin, Direction), so that resampling evaluates only one first-order
+ * B-spline per voxel, instead of each transform in the chain. Outside the output grid, the
+ * original chain is evaluated.\n
+ * example <tt>(FlattenTransformChain "true")</tt>\n
+ * Default: "false".
+ * \transformparameter FlattenedTransformChainCacheDirectory: A directory to cache the sampled
+ * transform chain, when FlattenTransformChain is "true". The sampled chain is stored in a file
+ * whose name contains a hash of the contents of the chain and of the output grid. Repeated
+ * transformix calls with the same chain and output grid load this file, instead of sampling the
+ * chain again.\n
+ * example <tt>(FlattenedTransformChainCacheDirectory "/tmp/elastix-cache")</tt>\n
+ * Default: "", no caching.
+ * \transformparameter TransformParametersBinaryFileName: the name of a binary file that contains
+ * the transform parameter vector, instead of the TransformParameters entry. The file contains
+ * NumberOfParameters raw values, in the native byte order, without header. A relative path is
+ * relative to the directory of the transform parameter file.\n
+ * example <tt>(TransformParametersBinaryFileName "TransformParameters.0.bin")</tt>\n
+ * \transformparameter TransformParametersBinaryValueType: the value type of the binary file
+ * specified by TransformParametersBinaryFileName, either "double" or "float".\n
+ * example <tt>(TransformParametersBinaryValueType "double")</tt>\n
+ * Default: "double".
  * \transformparameter InitialTransformParametersFileName: The location/name of an initial
  * transform that will be loaded when loading the current transform parameter file. Note
  * that transform parameter file can also contain an initial transform. Recursively all
@@ -171,6 +226,11 @@ public:
   typedef CombinationTransformType                                                   ITKBaseType;
   typedef typename CombinationTransformType::InitialTransformType                    InitialTransformType;
 
+  /** Typedef's for flattening a chain of transforms. */
+  typedef itk::FlattenedTransform<CoordRepType, FixedImageDimension> FlattenedTransformType;
+  typedef typename FlattenedTransformType::DisplacementFieldType      FlattenedFieldImageType;
+  typedef typename FlattenedTransformType::GridType                   FlattenedGridType;
+
   /** Typedef's for parameters. */
   using ValueType = double;
   using ParametersType = itk::OptimizerParameters<ValueType>;
@@ -260,6 +320,19 @@ public:
   void
   SetFinalParameters(void);
 
+  /** Lets the resampler use a single transform that is equivalent to this transform together with its chain of
+   * initial transforms, when FlattenTransformChain is "true". To be called by transformix, after ReadFromFile.
+   */
+  void
+  FlattenTransformChainForResampler(void);
+
+  /** Returns a hash (as hexadecimal string) of the contents of this transform and its chain of initial transforms,
+   * including the contents of the files they have read their data from (like a deformation field), and of the
+   * specified additional data (for example, a description of an output grid).
+   */
+  std::string
+  ComputeTransformChainHash(const std::string & additionalData = {}) const;
+
 protected:
   /** The default-constructor. */
   TransformBase() = default;
@@ -312,7 +385,29 @@ private:
   void
   BeforeRegistrationBase(void) override;
 
+  /** Replace the initial transform by a first-order B-spline transform, that samples
+   * the initial transform on the (possibly coarsened) fixed image grid.
+   */
+  void
+  FlattenInitialTransform(void);
+
+  /** Samples the specified transform on the specified grid, coarsened by the specified factor, and extended by one
+   * node on each side, and returns the displacements.
+   */
+  static typename FlattenedFieldImageType::Pointer
+  SampleDisplacementField(const InitialTransformType & transform,
+                          const FlattenedGridType &    grid,
+                          const unsigned int           gridSpacingFactor = 1);
+
+  /** Returns a first-order B-spline transform, whose coefficients are the displacements of the specified field, and
+   * which falls back to the specified transform (if any) outside the grid.
+   */
+  static typename FlattenedTransformType::Pointer
+  CreateFlattenedTransform(const FlattenedFieldImageType & field,
+                           const InitialTransformType *    fallbackTransform = nullptr);
+
   /** Execute stuff after the registration:
+   * \li Restore the original initial transform, if it was flattened.
    * \li Get and set the final parameters for the resampler.
    */
   void
@@ -358,7 +453,9 @@ private:
       return "NoInitialTransform";
     }
 
-    const Self * t0 = dynamic_cast<const Self *>(this->GetInitialTransform());
+    const Self * t0 = this->m_UnflattenedInitialTransform
+                        ? dynamic_cast<const Self *>(this->m_UnflattenedInitialTransform.GetPointer())
+                        : dynamic_cast<const Self *>(this->GetInitialTransform());
     return t0->GetTransformParametersFileName();
   }
 
@@ -377,6 +474,9 @@ private:
 
   /** Boolean to decide whether or not the transform parameters are written. */
   bool m_ReadWriteTransformParameters{ true };
+
+  /** The original initial transform, in case it is replaced by a flattened one. */
+  typename InitialTransformType::Pointer m_UnflattenedInitialTransform;
 };
 
 } // end namespace elastix
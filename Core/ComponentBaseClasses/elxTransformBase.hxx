@@ -20,6 +20,7 @@
 
 #include "elxTransformBase.h"
 
+#include "elxCacheUtilities.h"
 #include "elxConversion.h"
 #include "elxElastixMain.h"
 #include "elxTransformIO.h"
@@ -30,8 +31,10 @@
 #include <itksys/SystemTools.hxx>
 #include "itkVector.h"
 #include "itkTransformToDisplacementFieldFilter.h"
+#include "itkAdvancedMatrixOffsetTransformBase.h"
 #include "itkTransformToDeterminantOfSpatialJacobianSource.h"
 #include "itkTransformToSpatialJacobianSource.h"
+#include "itkImageFileReader.h"
 #include "itkImageFileWriter.h"
 #include "itkImageGridSampler.h"
 #include "itkContinuousIndex.h"
@@ -42,7 +45,9 @@
 #include "itkTransformMeshFilter.h"
 #include "itkCommonEnums.h"
 
+#include <algorithm> // For max.
 #include <cassert>
+#include <cstdint> // For uint64_t.
 #include <fstream>
 #include <iomanip> // For setprecision.
 
@@ -187,9 +192,313 @@ TransformBase<TElastix>::BeforeRegistrationBase(void)
     }
   }
 
+  /** Check if the initial transform should be flattened into a single dense field. */
+  bool flattenInitialTransform = false;
+  this->m_Configuration->ReadParameter(flattenInitialTransform, "FlattenInitialTransform", 0, false);
+  if (flattenInitialTransform && this->GetInitialTransform() != nullptr)
+  {
+    this->FlattenInitialTransform();
+  }
+
 } // end BeforeRegistrationBase()
 
 
+/**
+ * ******************* FlattenInitialTransform ******************
+ */
+
+template <class TElastix>
+void
+TransformBase<TElastix>::FlattenInitialTransform(void)
+{
+  const FixedImageType * fixedImage = this->m_Elastix->GetFixedImage();
+  InitialTransformType * initialTransform = this->GetAsITKBaseType()->GetModifiableInitialTransform();
+  if (fixedImage == nullptr || initialTransform == nullptr)
+  {
+    return;
+  }
+
+  /** The distance between the nodes of the flattened initial transform, in voxels. By default, the smallest
+   * distance for which the number of nodes does not exceed the maximum, as sampling the initial transform on
+   * the full resolution grid of a large 3D image would take too much memory.
+   */
+  constexpr double maximumNumberOfNodes = 4194304.0;
+  const auto       fixedImageSize = fixedImage->GetLargestPossibleRegion().GetSize();
+
+  unsigned int gridSpacing = 1;
+  for (;; ++gridSpacing)
+  {
+    double numberOfNodes = 1.0;
+    for (unsigned int i = 0; i < FixedImageDimension; ++i)
+    {
+      numberOfNodes *= (std::max<std::size_t>(fixedImageSize[i], 1) + gridSpacing - 2) / gridSpacing + 3;
+    }
+    if (numberOfNodes <= maximumNumberOfNodes)
+    {
+      break;
+    }
+  }
+  this->m_Configuration->ReadParameter(gridSpacing, "FlattenInitialTransformGridSpacing", 0, false);
+
+  const auto field = Self::SampleDisplacementField(*initialTransform, *fixedImage, gridSpacing);
+  const auto flattenedTransform = Self::CreateFlattenedTransform(*field, initialTransform);
+
+  /** Keep the original chain alive, since it is still needed when writing the transform parameter file,
+   * and replace it by the flattened transform. The original chain is restored after the registration.
+   */
+  this->m_UnflattenedInitialTransform = initialTransform;
+  this->SetInitialTransform(flattenedTransform);
+
+  elxout << "The initial transform has been flattened into a dense field of "
+         << field->GetLargestPossibleRegion().GetNumberOfPixels() << " nodes, " << gridSpacing
+         << " voxel(s) apart." << std::endl;
+
+} // end FlattenInitialTransform()
+
+
+/**
+ * ******************* SampleDisplacementField ******************
+ */
+
+template <class TElastix>
+auto
+TransformBase<TElastix>::SampleDisplacementField(const InitialTransformType & transform,
+                                                 const FlattenedGridType &    grid,
+                                                 const unsigned int           gridSpacingFactor)
+  -> typename FlattenedFieldImageType::Pointer
+{
+  try
+  {
+    return FlattenedTransformType::SampleDisplacementField(transform, grid, gridSpacingFactor);
+  }
+  catch (itk::ExceptionObject & excp)
+  {
+    /** Add information to the exception. */
+    excp.SetLocation("TransformBase - SampleDisplacementField()");
+    std::string err_str = excp.GetDescription();
+    err_str += "\nError occurred while flattening a transform.\n";
+    excp.SetDescription(err_str);
+
+    /** Pass the exception to an higher level. */
+    throw excp;
+  }
+
+} // end SampleDisplacementField()
+
+
+/**
+ * ******************* CreateFlattenedTransform ******************
+ */
+
+template <class TElastix>
+auto
+TransformBase<TElastix>::CreateFlattenedTransform(const FlattenedFieldImageType &    field,
+                                                  const InitialTransformType * const fallbackTransform) ->
+  typename FlattenedTransformType::Pointer
+{
+  const auto flattenedTransform = FlattenedTransformType::New();
+  flattenedTransform->SetDisplacementField(field);
+  flattenedTransform->SetFallbackTransform(fallbackTransform);
+  return flattenedTransform;
+
+} // end CreateFlattenedTransform()
+
+
+/**
+ * ******************* FlattenTransformChainForResampler ******************
+ */
+
+template <class TElastix>
+void
+TransformBase<TElastix>::FlattenTransformChainForResampler(void)
+{
+  bool flattenTransformChain = false;
+  this->m_Configuration->ReadParameter(flattenTransformChain, "FlattenTransformChain", 0, false);
+  if (!flattenTransformChain)
+  {
+    return;
+  }
+
+  auto &              resampler = *(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType());
+  const ITKBaseType & transform = *(this->GetAsITKBaseType());
+
+  if (transform.IsLinear())
+  {
+    /** A chain of linear transforms is itself an affine transform. Its matrix and
+     * offset follow from mapping the origin, and the unit vectors.
+     */
+    typedef itk::AdvancedMatrixOffsetTransformBase<CoordRepType, FixedImageDimension, FixedImageDimension>
+      AffineTransformType;
+
+    InputPointType point;
+    point.Fill(0.0);
+    const auto offset = transform.TransformPoint(point);
+
+    typename AffineTransformType::MatrixType matrix;
+    for (unsigned int j = 0; j < FixedImageDimension; ++j)
+    {
+      point.Fill(0.0);
+      point[j] = 1.0;
+      const auto mappedPoint = transform.TransformPoint(point);
+      for (unsigned int i = 0; i < FixedImageDimension; ++i)
+      {
+        matrix[i][j] = mappedPoint[i] - offset[i];
+      }
+    }
+
+    const auto affineTransform = AffineTransformType::New();
+    affineTransform->SetMatrix(matrix);
+    affineTransform->SetTranslation(offset.GetVectorFromOrigin());
+    resampler.SetTransform(affineTransform);
+
+    elxout << "The transform chain has been composed into a single affine transform." << std::endl;
+    return;
+  }
+
+  /** The output grid of the resampler. */
+  const auto grid = itk::Image<char, FixedImageDimension>::New();
+  grid->SetRegions(typename FlattenedGridType::RegionType(resampler.GetOutputStartIndex(), resampler.GetSize()));
+  grid->SetOrigin(resampler.GetOutputOrigin());
+  grid->SetSpacing(resampler.GetOutputSpacing());
+  grid->SetDirection(resampler.GetOutputDirection());
+
+  std::string cacheDirectory;
+  this->m_Configuration->ReadParameter(cacheDirectory, "FlattenedTransformChainCacheDirectory", 0, false);
+
+  std::string cacheFileName;
+  if (!cacheDirectory.empty())
+  {
+    /** The cache file is identified by the contents of the chain, and by the output grid. */
+    std::ostringstream gridDescription;
+    gridDescription << std::setprecision(17) << grid->GetLargestPossibleRegion() << grid->GetOrigin()
+                    << grid->GetSpacing() << grid->GetDirection();
+
+    cacheFileName = cacheDirectory + "/FlattenedTransformChain_" +
+                    this->ComputeTransformChainHash(gridDescription.str()) + ".mha";
+  }
+
+  typename FlattenedFieldImageType::Pointer field;
+
+  if (!cacheFileName.empty() && itksys::SystemTools::FileExists(cacheFileName))
+  {
+    try
+    {
+      const auto reader = itk::ImageFileReader<FlattenedFieldImageType>::New();
+      reader->SetFileName(cacheFileName);
+      reader->Update();
+      field = reader->GetOutput();
+      elxout << "The flattened transform chain has been read from the cache file " << cacheFileName << std::endl;
+    }
+    catch (const itk::ExceptionObject & excp)
+    {
+      /** For example, a file that is still being written by another process. Just sample the chain again. */
+      xl::xout["warning"] << "WARNING: Failed to read the flattened transform chain from " << cacheFileName << ":\n"
+                          << excp.GetDescription() << std::endl;
+    }
+  }
+
+  if (field == nullptr)
+  {
+    field = Self::SampleDisplacementField(transform, *grid);
+
+    if (!cacheFileName.empty())
+    {
+      /** Write to a temporary file first, and then rename it, so that other processes
+       * never read a partially written cache file.
+       */
+      const std::string temporaryFileName = CacheUtilities::MakeTemporaryFileName(cacheFileName);
+      try
+      {
+        const auto writer = itk::ImageFileWriter<FlattenedFieldImageType>::New();
+        writer->SetFileName(temporaryFileName);
+        writer->SetInput(field);
+        writer->Update();
+        if (!CacheUtilities::CommitFile(temporaryFileName, cacheFileName))
+        {
+          xl::xout["warning"] << "WARNING: Failed to store the flattened transform chain as " << cacheFileName
+                              << std::endl;
+        }
+      }
+      catch (const itk::ExceptionObject & excp)
+      {
+        xl::xout["warning"] << "WARNING: Failed to write the flattened transform chain to " << cacheFileName << ":\n"
+                            << excp.GetDescription() << std::endl;
+        itksys::SystemTools::RemoveFile(temporaryFileName);
+      }
+    }
+    elxout << "The transform chain has been flattened into a dense field of "
+           << field->GetLargestPossibleRegion().GetNumberOfPixels() << " nodes." << std::endl;
+  }
+
+  /** Outside the output grid, the flattened transform falls back to the original chain. */
+  resampler.SetTransform(Self::CreateFlattenedTransform(*field, &transform));
+
+} // end FlattenTransformChainForResampler()
+
+
+/**
+ * ******************* ComputeTransformChainHash ******************
+ */
+
+template <class TElastix>
+std::string
+TransformBase<TElastix>::ComputeTransformChainHash(const std::string & additionalData) const
+{
+  std::uint64_t hash = CacheUtilities::FnvOffsetBasis;
+
+  const auto addBytes = [&hash](const void * const data, const std::size_t numberOfBytes) {
+    hash = CacheUtilities::AddToHash(hash, data, numberOfBytes);
+  };
+  const auto addString = [&hash](const std::string & str) { hash = CacheUtilities::AddStringToHash(hash, str); };
+  const auto addParameters = [&addBytes](const itk::OptimizerParameters<double> & parameters) {
+    const auto size = static_cast<std::uint64_t>(parameters.size());
+    addBytes(&size, sizeof(size));
+    addBytes(parameters.data_block(), parameters.size() * sizeof(double));
+  };
+
+  addString(additionalData);
+
+  const InitialTransformType * transform = this->GetAsITKBaseType();
+
+  while (transform != nullptr)
+  {
+    addString(transform->GetNameOfClass());
+    addParameters(transform->GetFixedParameters());
+    addParameters(transform->GetParameters());
+
+    const auto elxTransform = dynamic_cast<const Self *>(transform);
+    if (elxTransform == nullptr)
+    {
+      break;
+    }
+
+    /** The transform specific parameters, like the B-spline grid, or the file name of a deformation field. */
+    addString(elxTransform->elxGetClassName());
+    addString(Conversion::ParameterMapToString(elxTransform->CreateDerivedTransformParametersMap()));
+
+    /** The contents of the files that the transform has read its data from, as those files may have been
+     * overwritten (under the same name) since the cache file was written.
+     */
+    for (const char * const fileNameParameter : { "DeformationFieldFileName", "SubTransforms" })
+    {
+      for (const auto & fileName : elxTransform->GetConfiguration()->GetValuesOfParameter(fileNameParameter))
+      {
+        hash = CacheUtilities::AddFileToHash(hash, fileName);
+      }
+    }
+
+    const auto & combinationTransform = *(elxTransform->GetAsITKBaseType());
+    const bool   useComposition = combinationTransform.GetUseComposition();
+    addBytes(&useComposition, sizeof(useComposition));
+
+    transform = combinationTransform.GetInitialTransform();
+  }
+
+  return CacheUtilities::HashToString(hash);
+
+} // end ComputeTransformChainHash()
+
+
 /**
  * ******************* GetInitialTransform **********************
  */
@@ -246,6 +555,16 @@ template <class TElastix>
 void
 TransformBase<TElastix>::AfterRegistrationBase(void)
 {
+  /** Restore the original initial transform, in case it was flattened. The final resampling, and any
+   * next registration that uses this transform as initial transform, should use the exact chain, just
+   * like transformix does when it reads the transform parameter file.
+   */
+  if (this->m_UnflattenedInitialTransform)
+  {
+    this->SetInitialTransform(this->m_UnflattenedInitialTransform);
+    this->m_UnflattenedInitialTransform = nullptr;
+  }
+
   /** Set the final Parameters. */
   this->SetFinalParameters();
 
@@ -273,7 +592,30 @@ TransformBase<TElastix>::ReadFromFile(void)
     const auto itkParameterValues =
       this->m_Configuration->template RetrieveValuesOfParameter<double>("ITKTransformParameters");
 
-    if (itkParameterValues == nullptr)
+    /** The name of the binary file containing the TransformParameters, if any. */
+    std::string binaryFileName;
+    this->m_Configuration->ReadParameter(binaryFileName, "TransformParametersBinaryFileName", 0, false);
+
+    if ((itkParameterValues == nullptr) && !binaryFileName.empty())
+    {
+      /** Read the parameters straight from the binary file, without text parsing. */
+      unsigned int numberOfParameters = 0;
+      this->m_Configuration->ReadParameter(numberOfParameters, "NumberOfParameters", 0);
+
+      std::string valueType = "double";
+      this->m_Configuration->ReadParameter(valueType, "TransformParametersBinaryValueType", 0, false);
+
+      /** A relative path is relative to the directory of the transform parameter file that refers to it. */
+      const std::string parameterFileDirectory =
+        itksys::SystemTools::GetFilenamePath(this->m_Configuration->GetParameterFileName());
+      if (!itksys::SystemTools::FileIsFullPath(binaryFileName) && !parameterFileDirectory.empty())
+      {
+        binaryFileName = parameterFileDirectory + '/' + binaryFileName;
+      }
+
+      m_TransformParameters = TransformIO::ReadParametersFromBinaryFile(binaryFileName, valueType, numberOfParameters);
+    }
+    else if (itkParameterValues == nullptr)
     {
       /** Get the number of TransformParameters. */
       unsigned int numberOfParameters = 0;
@@ -492,6 +834,32 @@ TransformBase<TElastix>::WriteToFile(xl::xoutsimple & transformationParameterInf
     }
   }
 
+  /** Possibly move the TransformParameters from the text file to a binary file. */
+  bool writeTransformParametersToBinaryFile = false;
+  configuration.ReadParameter(writeTransformParametersToBinaryFile, "WriteTransformParametersToBinaryFile", 0, false);
+
+  if (writeTransformParametersToBinaryFile && !m_TransformParametersFileName.empty() &&
+      (parameterMap.count("TransformParameters") > 0))
+  {
+    std::string valueType = "double";
+    configuration.ReadParameter(valueType, "TransformParametersBinaryValueType", 0, false);
+
+    /** The binary file is written next to the transform parameter file, which refers to it by its file name only, so
+     * that both files may be moved together. Only the extension of the file name (not of its directory) is replaced.
+     */
+    const std::string parameterFileDirectory = itksys::SystemTools::GetFilenamePath(m_TransformParametersFileName);
+    const std::string binaryFileName =
+      itksys::SystemTools::GetFilenameWithoutLastExtension(m_TransformParametersFileName) + ".bin";
+    const std::string binaryFilePath =
+      parameterFileDirectory.empty() ? binaryFileName : (parameterFileDirectory + '/' + binaryFileName);
+
+    TransformIO::WriteParametersToBinaryFile(param, binaryFilePath, valueType);
+
+    parameterMap.erase("TransformParameters");
+    parameterMap["TransformParametersBinaryFileName"] = { binaryFileName };
+    parameterMap["TransformParametersBinaryValueType"] = { valueType };
+  }
+
   const auto writeCompositeTransform =
     configuration.template RetrieveValuesOfParameter<bool>("WriteITKCompositeTransform");
 
@@ -245,6 +245,16 @@ Configuration::Initialize(const CommandLineArgumentMapType &                _arg
   /** Store the command line arguments. */
   this->m_CommandLineArgumentMap = _arg;
 
+  /** When "elastix --serve" passes a parameter map that it parsed before, "-p" still specifies its file, which is
+   * printed to the log file, and relative to which the files that are referred to by the parameters are found.
+   */
+  const std::string p = this->GetCommandLineArgument("-p");
+  if (!p.empty())
+  {
+    this->SetParameterFileName(p.c_str());
+    this->m_ParameterFileParser->SetParameterFileName(p);
+  }
+
   this->m_ParameterMapInterface->SetParameterMap(AddDataFromExternalTransformFile(m_ParameterFileName, inputMap));
 
   /** Silently check in the parameter file if error messages should be printed. */
@@ -0,0 +1,143 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "elxCacheUtilities.h"
+
+#include <itksys/SystemTools.hxx>
+
+#include <fstream>
+#include <iomanip> // For setw and setfill.
+#include <random>  // For random_device.
+#include <sstream>
+
+namespace elastix
+{
+
+/** Definition of the static constexpr data member, as required before C++17, when it is odr-used. */
+constexpr std::uint64_t CacheUtilities::FnvOffsetBasis;
+
+
+/**
+ * *********************** AddToHash ***************************
+ */
+
+std::uint64_t
+CacheUtilities::AddToHash(std::uint64_t hash, const void * const data, const std::size_t numberOfBytes)
+{
+  const auto bytes = static_cast<const unsigned char *>(data);
+
+  for (std::size_t i = 0; i < numberOfBytes; ++i)
+  {
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  }
+  return hash;
+
+} // end AddToHash()
+
+
+/**
+ * *********************** AddStringToHash ***************************
+ */
+
+std::uint64_t
+CacheUtilities::AddStringToHash(const std::uint64_t hash, const std::string & str)
+{
+  return AddToHash(hash, str.c_str(), str.size() + 1);
+
+} // end AddStringToHash()
+
+
+/**
+ * *********************** AddFileToHash ***************************
+ */
+
+std::uint64_t
+CacheUtilities::AddFileToHash(std::uint64_t hash, const std::string & fileName)
+{
+  hash = AddStringToHash(hash, fileName);
+
+  std::ifstream file(fileName, std::ios::binary);
+  if (!file.is_open())
+  {
+    return hash;
+  }
+
+  /** Read the file in chunks, as it may be large (for example, a deformation field). */
+  char buffer[65536];
+  while (file.read(buffer, sizeof(buffer)) || (file.gcount() > 0))
+  {
+    hash = AddToHash(hash, buffer, static_cast<std::size_t>(file.gcount()));
+  }
+  return hash;
+
+} // end AddFileToHash()
+
+
+/**
+ * *********************** HashToString ***************************
+ */
+
+std::string
+CacheUtilities::HashToString(const std::uint64_t hash)
+{
+  std::ostringstream stream;
+  stream << std::hex << std::setfill('0') << std::setw(16) << hash;
+  return stream.str();
+
+} // end HashToString()
+
+
+/**
+ * *********************** MakeTemporaryFileName ***************************
+ */
+
+std::string
+CacheUtilities::MakeTemporaryFileName(const std::string & fileName)
+{
+  itksys::SystemTools::MakeDirectory(itksys::SystemTools::GetFilenamePath(fileName));
+
+  /** Only look for the extension in the file name, not in the name of its directory. */
+  const auto fileNameStart = fileName.find_last_of("/\\");
+  const auto extensionPosition = fileName.rfind('.');
+  const auto stemEnd = ((extensionPosition == std::string::npos) ||
+                        ((fileNameStart != std::string::npos) && (extensionPosition < fileNameStart)))
+                         ? fileName.size()
+                         : extensionPosition;
+
+  return fileName.substr(0, stemEnd) + "_tmp" + std::to_string(std::random_device{}()) + fileName.substr(stemEnd);
+
+} // end MakeTemporaryFileName()
+
+
+/**
+ * *********************** CommitFile ***************************
+ */
+
+bool
+CacheUtilities::CommitFile(const std::string & temporaryFileName, const std::string & fileName)
+{
+  if (itksys::SystemTools::RenameFile(temporaryFileName, fileName))
+  {
+    return true;
+  }
+  itksys::SystemTools::RemoveFile(temporaryFileName);
+  return false;
+
+} // end CommitFile()
+
+} // end namespace elastix
@@ -0,0 +1,78 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef elxCacheUtilities_h
+#define elxCacheUtilities_h
+
+#include <cstddef> // For size_t.
+#include <cstdint> // For uint64_t.
+#include <string>
+
+namespace elastix
+{
+/**
+ * \class CacheUtilities
+ *
+ * \brief A class that contains utility functions for caches whose entries
+ * are identified by a hash of their content, and may be stored on disk.
+ *
+ * The hash function is the 64-bit FNV-1a hash, which (unlike std::hash)
+ * yields the same value on each platform, so that on-disk cache entries
+ * can be shared between runs, processes, and computers.
+ *
+ * \ingroup Kernel
+ */
+class CacheUtilities
+{
+public:
+  /** The offset basis of the 64-bit FNV-1a hash function: the hash value of an empty sequence of bytes. */
+  static constexpr std::uint64_t FnvOffsetBasis = 14695981039346656037ULL;
+
+  /** Adds the specified bytes to the specified hash value. */
+  static std::uint64_t
+  AddToHash(std::uint64_t hash, const void * const data, const std::size_t numberOfBytes);
+
+  /** Adds the specified string, including its terminating null character, to the specified hash value. */
+  static std::uint64_t
+  AddStringToHash(const std::uint64_t hash, const std::string & str);
+
+  /** Adds the name and the contents of the specified file to the specified hash value. When the file cannot be
+   * read, only its name is added. */
+  static std::uint64_t
+  AddFileToHash(std::uint64_t hash, const std::string & fileName);
+
+  /** Returns the specified hash value as a string of 16 hexadecimal digits. */
+  static std::string
+  HashToString(const std::uint64_t hash);
+
+  /** Returns a unique name for a temporary file, to be renamed to the specified file name by CommitFile(). Creates
+   * the directory of the file, when it does not yet exist. The extension of the specified file name is kept at the
+   * end, as image file writers select their ImageIO by the extension.
+   */
+  static std::string
+  MakeTemporaryFileName(const std::string & fileName);
+
+  /** Renames the specified temporary file to the specified file name, so that other processes never read a
+   * partially written file. Removes the temporary file and returns false when the file could not be renamed.
+   */
+  static bool
+  CommitFile(const std::string & temporaryFileName, const std::string & fileName);
+};
+
+} // end namespace elastix
+
+#endif // end #ifndef elxCacheUtilities_h
@@ -19,7 +19,7 @@
 #include <Core/elxVersionMacros.h>
 #include "elxConversion.h"
 #include <sstream>
-#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include <itkProcessObject.h>
 
 namespace elastix
 {
@@ -342,12 +342,10 @@ ElastixBase::BeforeAllBase(void)
    * the default in the MersenneTwister code.
    * Use silent parameter file readout, to avoid annoying warning when
    * starting elastix */
-  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
-  typedef RandomGeneratorType::IntegerType                       SeedType;
-  unsigned int                                                   randomSeed = 121212;
+  typedef RandomGeneratorType::IntegerType SeedType;
+  unsigned int                             randomSeed = 121212;
   this->GetConfiguration()->ReadParameter(randomSeed, "RandomSeed", 0, false);
-  RandomGeneratorType::Pointer randomGenerator = RandomGeneratorType::GetInstance();
-  randomGenerator->SetSeed(static_cast<SeedType>(randomSeed));
+  this->m_RandomGenerator->SetSeed(static_cast<SeedType>(randomSeed));
 
   /** Return a value. */
   return returndummy;
@@ -419,6 +417,10 @@ ElastixBase::BeforeAllTransformixBase(void)
     check = this->GetConfiguration()->GetCommandLineArgument("-tp");
     elxout << "-tp       " << check << std::endl;
   }
+
+  /** Limit the number of threads of this transformation. */
+  this->ApplyThreadBudgetToComponents();
+
   /** Check the very important UseDirectionCosines parameter. */
   bool retudc = this->GetConfiguration()->ReadParameter(this->m_UseDirectionCosines, "UseDirectionCosines", 0);
   if (!retudc)
@@ -445,9 +447,61 @@ ElastixBase::BeforeRegistrationBase(void)
   this->m_IterationInfo.SetOutputs(xl::xout.GetCOutputs());
   this->m_IterationInfo.SetOutputs(xl::xout.GetXOutputs());
 
+  /** Limit the number of threads of this registration. */
+  this->ApplyThreadBudgetToComponents();
+
 } // end BeforeRegistrationBase()
 
 
+/**
+ * ************************ ApplyThreadBudgetToComponents ******************
+ */
+
+void
+ElastixBase::ApplyThreadBudgetToComponents(void) const
+{
+  if (!BaseComponent::IsElastixLibrary())
+  {
+    /** The maximum number of threads is then already set process-wide, by ElastixMain. */
+    return;
+  }
+
+  const std::string threadsString = this->GetConfiguration()->GetCommandLineArgument("-threads");
+  if (threadsString.empty())
+  {
+    return;
+  }
+
+  const int numberOfThreads = atoi(threadsString.c_str());
+  if (numberOfThreads <= 0)
+  {
+    return;
+  }
+
+  for (const ObjectContainerType * const container : { this->GetRegistrationContainer(),
+                                                       this->GetFixedImagePyramidContainer(),
+                                                       this->GetMovingImagePyramidContainer(),
+                                                       this->GetImageSamplerContainer(),
+                                                       this->GetResamplerContainer() })
+  {
+    if (container == nullptr)
+    {
+      continue;
+    }
+    for (const auto & component : container->CastToSTLConstContainer())
+    {
+      const auto processObject = dynamic_cast<itk::ProcessObject *>(component.GetPointer());
+      if (processObject != nullptr)
+      {
+        processObject->SetNumberOfWorkUnits(numberOfThreads);
+        processObject->GetMultiThreader()->SetMaximumNumberOfThreads(numberOfThreads);
+      }
+    }
+  }
+
+} // end ApplyThreadBudgetToComponents()
+
+
 /**
  * ********************** GetResultImage *************************
  */
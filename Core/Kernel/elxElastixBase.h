@@ -31,6 +31,7 @@
 #include "elxBaseComponent.h"
 #include "elxComponentDatabase.h"
 #include "elxConfiguration.h"
+#include "elxFixedImageDataCache.h"
 #include "elxMacro.h"
 #include "xoutmain.h"
 
@@ -38,12 +39,14 @@
 #include <itkChangeInformationImageFilter.h>
 #include <itkDataObject.h>
 #include <itkImageFileReader.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
 #include <itkObject.h>
 #include <itkTimeProbe.h>
 #include <itkVectorContainer.h>
 
 #include <fstream>
 #include <iomanip>
+#include <memory> // For unique_ptr.
 
 /** Like itkGet/SetObjectMacro, but in these macros the itkDebugMacro is
  * not called. Besides, they are not virtual, since
@@ -132,6 +135,8 @@ namespace elastix
  *    elastix with "nice".
  * \commandlinearg -threads: optional argument for both elastix and transformix to
  *    specify the maximum number of threads used by this process. Default: no maximum. \n
+ *    When elastix is used as a library, it specifies the number of threads of this
+ *    registration only, rather than of the whole process. \n
  *    example: <tt>-threads 2</tt> \n
  * \commandlinearg -in: optional argument for transformix with the file name of an input image. \n
  *    example: <tt>-in inputImage.mhd</tt> \n
@@ -175,6 +180,9 @@ public:
   typedef ComponentDatabaseType::IndexType DBIndexType;
   typedef std::vector<double>              FlatDirectionCosinesType;
 
+  /** The type of the random number generator of this registration. */
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+
   /** Type for representation of the transform coordinates. */
   typedef double CoordRepType; // itk::CostFunction::ParametersValueType
 
@@ -244,6 +252,10 @@ public:
   elxGetObjectMacro(ResultImageContainer, DataObjectContainerType);
   elxSetObjectMacro(ResultImageContainer, DataObjectContainerType);
 
+  /** Set/Get the (optional) caller-provided image whose buffer the result image is resampled into. */
+  elxGetObjectMacro(ResultImageBuffer, DataObjectType);
+  elxSetObjectMacro(ResultImageBuffer, DataObjectType);
+
   /** Set/Get the result image container. */
   elxGetObjectMacro(ResultDeformationFieldContainer, DataObjectContainerType);
   elxSetObjectMacro(ResultDeformationFieldContainer, DataObjectContainerType);
@@ -286,6 +298,48 @@ public:
   elxGetNumberOfMacro(ResultImage);
   elxGetNumberOfMacro(ResultDeformationField);
 
+  /** Set/Get the cache of fixed image data, which may be shared by subsequent registrations
+   * against the same fixed image. Null (default) means that no such data is cached.
+   */
+  elxSetObjectMacro(FixedImageDataCache, FixedImageDataCache);
+  elxGetObjectMacro(FixedImageDataCache, FixedImageDataCache);
+
+  /** Set/Get the content key of the fixed image data, as generated by FixedImageDataCache::MakeContentKey() when the
+   * cache of fixed image data has a directory for its on-disk data, and by FixedImageDataCache::MakeParametersKey()
+   * otherwise. */
+  itkSetStringMacro(FixedImageDataCacheContentKey);
+  itkGetStringMacro(FixedImageDataCacheContentKey);
+
+  /** Set/Get the content key of the moving image data, as generated by FixedImageDataCache::MakeMovingContentKey()
+   * when the cache of fixed image data has a directory for its on-disk data. Empty otherwise, meaning that no moving
+   * image data are cached. */
+  itkSetStringMacro(MovingImageDataCacheContentKey);
+  itkGetStringMacro(MovingImageDataCacheContentKey);
+
+  /** Get the random number generator of this registration, seeded by the "RandomSeed" parameter. It is passed to
+   * the components that draw random numbers (random samplers, some metrics and optimizers), instead of the global
+   * instance, so that concurrent registrations do not share (and disturb) each other's random sequence.
+   */
+  elxGetObjectMacro(RandomGenerator, RandomGeneratorType);
+
+  /** Makes a key for the cache of fixed image data, prefixed by the content key of the fixed image data. */
+  std::string
+  MakeFixedImageDataCacheKey(const std::string & name,
+                             const unsigned int  elastixLevel,
+                             const unsigned int  resolution) const
+  {
+    return m_FixedImageDataCacheContentKey + FixedImageDataCache::MakeKey(name, elastixLevel, resolution);
+  }
+
+  /** Makes a key for the on-disk cache of moving image data, prefixed by the content key of the moving image data. */
+  std::string
+  MakeMovingImageDataCacheKey(const std::string & name,
+                              const unsigned int  elastixLevel,
+                              const unsigned int  resolution) const
+  {
+    return m_MovingImageDataCacheContentKey + FixedImageDataCache::MakeKey(name, elastixLevel, resolution);
+  }
+
   /** Set/Get the initial transform
    * The type is ObjectType, but the pointer should actually point
    * to an itk::Transform type (or inherited from that one).
@@ -428,6 +482,9 @@ protected:
 
   std::ofstream m_IterationInfoFile;
 
+  /** Writes to m_IterationInfoFile by a background thread, when xout is asynchronous. */
+  std::unique_ptr<xl::xoutasyncstream> m_AsynchronousIterationInfoFile;
+
   /** Convenient mini class to load the files specified by a filename container
    * The function GenerateImageContainer can be used without instantiating an
    * object of this class, since it is static. It has 2 arguments: the
@@ -513,6 +570,14 @@ private:
   void
   operator=(const Self &) = delete;
 
+  /** When elastix is used as a library, applies the "-threads" command line argument to the
+   * number of work units of those components that are ITK process objects. Instead of setting
+   * the process-wide maximum number of threads, the thread budget is then specific to this
+   * registration, so that concurrent registrations do not interfere with each other.
+   */
+  void
+  ApplyThreadBudgetToComponents(void) const;
+
   xl::xoutrow m_IterationInfo;
 
   int m_DefaultOutputPrecision;
@@ -540,6 +605,9 @@ private:
   /** The result image container. These are stored as pointers to itk::DataObject. */
   DataObjectContainerPointer m_ResultImageContainer;
 
+  /** The (optional) caller-provided result image buffer. */
+  DataObjectPointer m_ResultImageBuffer;
+
   /** The result deformation field container. These are stored as pointers to itk::DataObject. */
   DataObjectContainerPointer m_ResultDeformationFieldContainer;
 
@@ -553,6 +621,14 @@ private:
   ObjectPointer m_InitialTransform;
   ObjectPointer m_FinalTransform;
 
+  /** The (optional) cache of fixed image data. */
+  FixedImageDataCache::Pointer m_FixedImageDataCache;
+  std::string                  m_FixedImageDataCacheContentKey;
+  std::string                  m_MovingImageDataCacheContentKey;
+
+  /** The random number generator of this registration. */
+  const RandomGeneratorType::Pointer m_RandomGenerator{ RandomGeneratorType::New() };
+
   /** Use or ignore direction cosines. */
   bool m_UseDirectionCosines;
 };
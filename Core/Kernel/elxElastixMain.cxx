@@ -57,25 +57,32 @@ struct Data
 
 Data g_data;
 
-} // end unnamed namespace
 
 /**
- * ********************* xoutSetup ******************************
+ * ********************* SetupXout ******************************
  *
- * NB: this function is a global function, not part of the ElastixMain
- * class!!
+ * Configures the specified main xout object, using the specified
+ * target cells and log file stream. The log file and std::cout are
+ * written via logOutput and coutOutput, which may either refer to
+ * these streams directly, or to asynchronous streams wrapping them.
  */
 
 int
-elastix::xoutSetup(const char * logfilename, bool setupLogging, bool setupCout)
+SetupXout(xl::xoutmain & mainXout,
+          Data &         data,
+          const char *   logfilename,
+          bool           setupLogging,
+          bool           setupCout,
+          std::ostream & logOutput,
+          std::ostream & coutOutput)
 {
   int returndummy = 0;
 
   if (setupLogging)
   {
     /** Open the logfile for writing. */
-    g_data.LogFileStream.open(logfilename);
-    if (!g_data.LogFileStream.is_open())
+    data.LogFileStream.open(logfilename);
+    if (!data.LogFileStream.is_open())
     {
       std::cerr << "ERROR: LogFile cannot be opened!" << std::endl;
       return 1;
@@ -85,40 +92,59 @@ elastix::xoutSetup(const char * logfilename, bool setupLogging, bool setupCout)
   /** Set std::cout and the logfile as outputs of xout. */
   if (setupLogging)
   {
-    returndummy |= xl::xout.AddOutput("log", &g_data.LogFileStream);
+    returndummy |= mainXout.AddOutput("log", &logOutput);
   }
   if (setupCout)
   {
-    returndummy |= xl::xout.AddOutput("cout", &std::cout);
+    returndummy |= mainXout.AddOutput("cout", &coutOutput);
   }
 
-  /** Set outputs of LogOnly and CoutOnly. */
-  returndummy |= g_data.LogOnlyXout.AddOutput("log", &g_data.LogFileStream);
-  returndummy |= g_data.CoutOnlyXout.AddOutput("cout", &std::cout);
+  /** Set outputs of LogOnly and CoutOnly. CoutOnly writes nothing when std::cout is not set up. */
+  returndummy |= data.LogOnlyXout.AddOutput("log", &logOutput);
+  if (setupCout)
+  {
+    returndummy |= data.CoutOnlyXout.AddOutput("cout", &coutOutput);
+  }
 
   /** Copy the outputs to the warning-, error- and standard-xouts. */
-  g_data.WarningXout.SetOutputs(xl::xout.GetCOutputs());
-  g_data.ErrorXout.SetOutputs(xl::xout.GetCOutputs());
-  g_data.StandardXout.SetOutputs(xl::xout.GetCOutputs());
+  data.WarningXout.SetOutputs(mainXout.GetCOutputs());
+  data.ErrorXout.SetOutputs(mainXout.GetCOutputs());
+  data.StandardXout.SetOutputs(mainXout.GetCOutputs());
 
-  g_data.WarningXout.SetOutputs(xl::xout.GetXOutputs());
-  g_data.ErrorXout.SetOutputs(xl::xout.GetXOutputs());
-  g_data.StandardXout.SetOutputs(xl::xout.GetXOutputs());
+  data.WarningXout.SetOutputs(mainXout.GetXOutputs());
+  data.ErrorXout.SetOutputs(mainXout.GetXOutputs());
+  data.StandardXout.SetOutputs(mainXout.GetXOutputs());
 
   /** Link the warning-, error- and standard-xouts to xout. */
-  returndummy |= xl::xout.AddTargetCell("warning", &g_data.WarningXout);
-  returndummy |= xl::xout.AddTargetCell("error", &g_data.ErrorXout);
-  returndummy |= xl::xout.AddTargetCell("standard", &g_data.StandardXout);
-  returndummy |= xl::xout.AddTargetCell("logonly", &g_data.LogOnlyXout);
-  returndummy |= xl::xout.AddTargetCell("coutonly", &g_data.CoutOnlyXout);
+  returndummy |= mainXout.AddTargetCell("warning", &data.WarningXout);
+  returndummy |= mainXout.AddTargetCell("error", &data.ErrorXout);
+  returndummy |= mainXout.AddTargetCell("standard", &data.StandardXout);
+  returndummy |= mainXout.AddTargetCell("logonly", &data.LogOnlyXout);
+  returndummy |= mainXout.AddTargetCell("coutonly", &data.CoutOnlyXout);
 
   /** Format the output. */
-  xl::xout["standard"] << std::fixed;
-  xl::xout["standard"] << std::showpoint;
+  mainXout["standard"] << std::fixed;
+  mainXout["standard"] << std::showpoint;
 
   /** Return a value. */
   return returndummy;
 
+} // end SetupXout()
+
+} // end unnamed namespace
+
+/**
+ * ********************* xoutSetup ******************************
+ *
+ * NB: this function is a global function, not part of the ElastixMain
+ * class!!
+ */
+
+int
+elastix::xoutSetup(const char * logfilename, bool setupLogging, bool setupCout)
+{
+  return SetupXout(xl::xout, g_data, logfilename, setupLogging, setupCout, g_data.LogFileStream, std::cout);
+
 } // end xoutSetup()
 
 
@@ -129,18 +155,73 @@ namespace elastix
  * ********************* xoutManager ******************************
  */
 
-xoutManager::xoutManager(const std::string & logFileName, const bool setupLogging, const bool setupCout)
+/** The xout objects owned by a manager that was constructed by its explicit constructor. The asynchronous streams
+ * (if any) are declared after the target cells, so that they are destructed first, writing their pending output to
+ * the log file before it is closed. */
+struct xoutManager::InstanceData
 {
-  if (xoutSetup(logFileName.c_str(), setupLogging, setupCout))
+  xl::xoutmain                         MainXout;
+  Data                                 TargetCells;
+  std::unique_ptr<xl::xoutasyncstream> AsynchronousLogFileStream;
+  std::unique_ptr<xl::xoutasyncstream> AsynchronousCout;
+  xl::xoutmain *                       PreviousXout{ nullptr };
+};
+
+
+xoutManager::xoutManager(const std::string & logFileName,
+                         const bool          setupLogging,
+                         const bool          setupCout,
+                         const bool          asynchronous)
+  : m_InstanceData(std::make_unique<InstanceData>())
+{
+  std::ostream * logOutput = &(m_InstanceData->TargetCells.LogFileStream);
+  std::ostream * coutOutput = &std::cout;
+
+  if (asynchronous)
+  {
+    if (setupLogging)
+    {
+      m_InstanceData->AsynchronousLogFileStream = std::make_unique<xl::xoutasyncstream>(*logOutput);
+      logOutput = m_InstanceData->AsynchronousLogFileStream.get();
+    }
+    if (setupCout)
+    {
+      m_InstanceData->AsynchronousCout = std::make_unique<xl::xoutasyncstream>(*coutOutput);
+      coutOutput = m_InstanceData->AsynchronousCout.get();
+    }
+    m_InstanceData->MainXout.SetAsynchronous(true);
+  }
+
+  if (SetupXout(m_InstanceData->MainXout,
+                m_InstanceData->TargetCells,
+                logFileName.c_str(),
+                setupLogging,
+                setupCout,
+                *logOutput,
+                *coutOutput))
   {
     itkGenericExceptionMacro("Error while setting up xout");
   }
+
+  /** From now on, xout refers to the xout of this manager, within the current thread. */
+  m_InstanceData->PreviousXout = xl::set_xout(&(m_InstanceData->MainXout));
 }
 
-xoutManager::Guard::~Guard()
+
+xoutManager::xoutManager() = default;
+
+
+xoutManager::~xoutManager()
 {
-  xl::get_xout() = {};
-  g_data = {};
+  if (m_InstanceData)
+  {
+    xl::set_xout(m_InstanceData->PreviousXout);
+  }
+  else
+  {
+    xl::get_xout() = {};
+    g_data = {};
+  }
 }
 
 
@@ -170,6 +251,7 @@ ElastixMain::ElastixMain()
   this->m_MovingMaskContainer = nullptr;
 
   this->m_ResultImageContainer = nullptr;
+  this->m_ResultImageBuffer = nullptr;
 
   this->m_FinalTransform = nullptr;
   this->m_InitialTransform = nullptr;
@@ -396,10 +478,14 @@ ElastixMain::Run(void)
   elastixBase.SetFixedMaskContainer(this->GetModifiableFixedMaskContainer());
   elastixBase.SetMovingMaskContainer(this->GetModifiableMovingMaskContainer());
   elastixBase.SetResultImageContainer(this->GetModifiableResultImageContainer());
+  elastixBase.SetResultImageBuffer(this->GetModifiableResultImageBuffer());
 
   /** Set the initial transform, if it happens to be there. */
   elastixBase.SetInitialTransform(this->GetModifiableInitialTransform());
 
+  /** Set the cache of fixed image data, if it happens to be there. */
+  elastixBase.SetFixedImageDataCache(this->GetModifiableFixedImageDataCache());
+
   /** Set the original fixed image direction cosines (relevant in case the
    * UseDirectionCosines parameter was set to false.
    */
@@ -904,8 +990,10 @@ ElastixMain::SetMaximumNumberOfThreads(void) const
   /** Get the number of threads from the command line. */
   std::string maximumNumberOfThreadsString = this->m_Configuration->GetCommandLineArgument("-threads");
 
-  /** If supplied, set the maximum number of threads. */
-  if (!maximumNumberOfThreadsString.empty())
+  /** If supplied, set the maximum number of threads. When elastix is used as a library, the maximum is not set
+   * process-wide, as multiple registrations may run concurrently. The number of threads is then applied per
+   * registration, by ElastixBase. */
+  if (!maximumNumberOfThreadsString.empty() && !BaseComponent::IsElastixLibrary())
   {
     const int maximumNumberOfThreads = atoi(maximumNumberOfThreadsString.c_str());
     itk::MultiThreaderBase::SetGlobalMaximumNumberOfThreads(maximumNumberOfThreads);
@@ -28,6 +28,7 @@
 // Standard C++ header files:
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
 
 
@@ -61,24 +62,27 @@ class xoutManager
 public:
   ITK_DISALLOW_COPY_AND_MOVE(xoutManager);
 
-  /** This explicit constructor does set up the "xout" output streams. */
-  explicit xoutManager(const std::string & logfilename, const bool setupLogging, const bool setupCout);
+  /** This explicit constructor does set up "xout" output streams that are owned by the manager, and makes them the
+   * "xout" of the calling thread, until the manager is destructed. It allows multiple registrations to run
+   * concurrently (each in its own thread), within the same process, each having its own log. When `asynchronous` is
+   * true, the log file and std::cout are written by background threads (see xl::xoutasyncstream), so that the
+   * registration does not have to wait for them. */
+  explicit xoutManager(const std::string & logfilename,
+                       const bool          setupLogging,
+                       const bool          setupCout,
+                       const bool          asynchronous = false);
 
-  /** The default-constructor only just constructs a manager object */
-  xoutManager() = default;
+  /** The default-constructor only just constructs a manager object, for the process-wide "xout" set up by
+   * xoutSetup. */
+  xoutManager();
 
   /** The destructor closes the "xout" output streams. */
-  ~xoutManager() = default;
+  ~xoutManager();
 
 private:
-  struct Guard
-  {
-    ITK_DISALLOW_COPY_AND_MOVE(Guard);
-    Guard() = default;
-    ~Guard();
-  };
-
-  const Guard m_Guard{};
+  struct InstanceData;
+
+  const std::unique_ptr<InstanceData> m_InstanceData;
 };
 
 
@@ -209,6 +213,13 @@ public:
   itkSetObjectMacro(ResultDeformationFieldContainer, DataObjectContainerType);
   itkGetModifiableObjectMacro(ResultDeformationFieldContainer, DataObjectContainerType);
 
+  /** Set/Get an (optional) caller-provided image, whose buffer the result image
+   * is resampled into, instead of allocating a new one. Only used when its pixel
+   * type and number of pixels match those of the result image.
+   */
+  itkSetObjectMacro(ResultImageBuffer, DataObjectType);
+  itkGetModifiableObjectMacro(ResultImageBuffer, DataObjectType);
+
   /** Set/Get the configuration object. */
   itkSetObjectMacro(Configuration, ConfigurationType);
   itkGetModifiableObjectMacro(Configuration, ConfigurationType);
@@ -239,6 +250,11 @@ public:
   itkSetObjectMacro(InitialTransform, ObjectType);
   itkGetModifiableObjectMacro(InitialTransform, ObjectType);
 
+  /** Set/Get the cache of fixed image data, which may be shared by subsequent registrations
+   * against the same fixed image, using the same parameter maps. Optional. */
+  itkSetObjectMacro(FixedImageDataCache, FixedImageDataCache);
+  itkGetModifiableObjectMacro(FixedImageDataCache, FixedImageDataCache);
+
   /** Set/Get the original fixed image direction as a flat array
    * (d11 d21 d31 d21 d22 etc ) */
   virtual void
@@ -306,6 +322,7 @@ public:
   /** Set maximum number of threads, which is read from the command line arguments.
    * Syntax:
    * -threads \<int\>
+   * Only sets the process-wide maximum when elastix is not used as a library.
    */
   virtual void
   SetMaximumNumberOfThreads(void) const;
@@ -348,12 +365,16 @@ protected:
   DataObjectContainerPointer m_MovingMaskContainer;
   DataObjectContainerPointer m_ResultImageContainer;
   DataObjectContainerPointer m_ResultDeformationFieldContainer;
+  DataObjectPointer          m_ResultImageBuffer;
 
   /** A transform that is the result of registration. */
   ObjectPointer m_FinalTransform;
 
   /** The initial transform. */
   ObjectPointer m_InitialTransform;
+
+  /** The cache of fixed image data. */
+  FixedImageDataCache::Pointer m_FixedImageDataCache;
   /** Transformation parameters map containing parameters that is the
    *  result of registration.
    */
@@ -95,6 +95,14 @@ namespace elastix
  *  image, which relates voxel coordinates to world coordinates. Ignoring it
  *  may easily lead to left/right swaps for example, which could skrew up a
  *  (medical) analysis.
+ * \parameter FixedImageDataCacheDirectory: Directory in which the fixed image
+ *    pyramid, the eroded fixed masks and the fixed image extrema are cached on
+ *    disk, keyed by a hash of the fixed image, the fixed mask and the relevant
+ *    parameters, so that subsequent runs with the same fixed side of the
+ *    registration do not need to compute them again. Only used when no
+ *    FixedImageDataCache is passed to elastix by other means.\n
+ *    example: <tt>(FixedImageDataCacheDirectory "/tmp/elastix_cache")</tt>\n
+ *    Default: "" (no on-disk cache).
  *
  * \ingroup Kernel
  */
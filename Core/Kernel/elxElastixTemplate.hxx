@@ -190,6 +190,46 @@ ElastixTemplate<TFixedImage, TMovingImage>::Run(void)
       this->GetMovingMaskFileNameContainer(), "Moving Mask", useDirCos));
   }
 
+  /** Use an on-disk cache of fixed image data, when a directory is specified by the parameter file. */
+  std::string fixedImageDataCacheDirectory;
+  this->GetConfiguration()->ReadParameter(fixedImageDataCacheDirectory, "FixedImageDataCacheDirectory", 0, false);
+  if (!fixedImageDataCacheDirectory.empty() && (this->GetFixedImageDataCache() == nullptr))
+  {
+    const auto fixedImageDataCache = FixedImageDataCache::New();
+    fixedImageDataCache->SetDirectory(fixedImageDataCacheDirectory);
+    this->SetFixedImageDataCache(fixedImageDataCache);
+  }
+
+  /** The keys of fixed image data are prefixed by a key of the parameters that affect them, so that a cache that is
+   * shared by registrations with different parameter maps does not mix up their data. The keys of on-disk fixed image
+   * data are prefixed by the content key of all fixed images and fixed masks (and those parameters). Moving image data
+   * are only cached on disk, by the content key of the (first) moving image. */
+  const FixedImageDataCache * const fixedImageDataCache = this->GetFixedImageDataCache();
+  if (fixedImageDataCache != nullptr)
+  {
+    if (std::string(fixedImageDataCache->GetDirectory()).empty())
+    {
+      this->SetFixedImageDataCacheContentKey(FixedImageDataCache::MakeParametersKey(*(this->GetConfiguration())));
+    }
+    else
+    {
+      std::vector<const FixedImageType *> fixedImages;
+      for (unsigned int i = 0; i < this->GetNumberOfFixedImages(); ++i)
+      {
+        fixedImages.push_back(this->GetFixedImage(i));
+      }
+      std::vector<const FixedMaskType *> fixedMasks;
+      for (unsigned int i = 0; i < this->GetNumberOfFixedMasks(); ++i)
+      {
+        fixedMasks.push_back(this->GetFixedMask(i));
+      }
+      this->SetFixedImageDataCacheContentKey(
+        FixedImageDataCache::MakeContentKey(fixedImages, fixedMasks, *(this->GetConfiguration())));
+      this->SetMovingImageDataCacheContentKey(
+        FixedImageDataCache::MakeMovingContentKey(*(this->GetMovingImage()), *(this->GetConfiguration())));
+    }
+  }
+
   /** Print the time spent on reading images. */
   this->m_Timer0.Stop();
   elxout << "Reading images took " << static_cast<unsigned long>(this->m_Timer0.GetMean() * 1000) << " ms.\n"
@@ -373,6 +413,9 @@ ElastixTemplate<TFixedImage, TMovingImage>::ApplyTransform(void)
     timer.Start();
     elxout << "Resampling image and writing to disk ..." << std::endl;
 
+    /** Possibly let the resampler use a single transform, instead of the whole transform chain. */
+    this->GetElxTransformBase()->FlattenTransformChainForResampler();
+
     /** Create a name for the final result. */
     std::string resultImageFormat = "mhd";
     this->GetConfiguration()->ReadParameter(resultImageFormat, "ResultImageFormat", 0, false);
@@ -1012,6 +1055,9 @@ ElastixTemplate<TFixedImage, TMovingImage>::OpenIterationInfoFile(void)
   /** Remove the current iteration info output file, if any. */
   this->GetIterationInfo().RemoveOutput("IterationInfoFile");
 
+  /** Write any pending asynchronous output to the current file, before closing it. */
+  this->m_AsynchronousIterationInfoFile.reset();
+
   if (this->m_IterationInfoFile.is_open())
   {
     this->m_IterationInfoFile.close();
@@ -1030,6 +1076,12 @@ ElastixTemplate<TFixedImage, TMovingImage>::OpenIterationInfoFile(void)
   {
     xl::xout["error"] << "ERROR: File \"" << fileName << "\" could not be opened!" << std::endl;
   }
+  else if (xl::xout.GetAsynchronous())
+  {
+    /** Let a background thread write the iteration info to this file, just like the log. */
+    this->m_AsynchronousIterationInfoFile = std::make_unique<xl::xoutasyncstream>(this->m_IterationInfoFile);
+    this->GetIterationInfo().AddOutput("IterationInfoFile", this->m_AsynchronousIterationInfoFile.get());
+  }
   else
   {
     /** Add this file to the list of outputs of IterationInfo. */
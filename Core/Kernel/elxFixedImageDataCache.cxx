@@ -0,0 +1,340 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "elxFixedImageDataCache.h"
+
+#include <cctype>  // For isalnum.
+#include <fstream>
+
+namespace elastix
+{
+
+/**
+ * *********************** MakeKey ***************************
+ */
+
+std::string
+FixedImageDataCache::MakeKey(const std::string & name, const unsigned int elastixLevel, const unsigned int resolution)
+{
+  return name + '(' + std::to_string(elastixLevel) + ',' + std::to_string(resolution) + ')';
+
+} // end MakeKey()
+
+
+/**
+ * *********************** AddParametersToHash ***************************
+ */
+
+std::uint64_t
+FixedImageDataCache::AddParametersToHash(std::uint64_t hash, const Configuration & configuration)
+{
+  /** The parameters that may affect the fixed image pyramid (as read by the fixed image pyramid components), the eroded
+   * fixed masks (whose erosion radius depends on the pyramid schedule), or the fixed image extrema.
+   */
+  static const std::vector<std::string> parameterNames{ "FixedImageDimension",
+                                                        "FixedInternalImagePixelType",
+                                                        "UseDirectionCosines",
+                                                        "Registration",
+                                                        "NumberOfResolutions",
+                                                        "FixedImagePyramid",
+                                                        "ImagePyramidSchedule",
+                                                        "FixedImagePyramidSchedule",
+                                                        "FixedImagePyramid0Schedule",
+                                                        "ImagePyramidRescaleSchedule",
+                                                        "FixedImagePyramidRescaleSchedule",
+                                                        "ImagePyramidSmoothingSchedule",
+                                                        "FixedImagePyramidSmoothingSchedule",
+                                                        "ImagePyramidUseShrinkImageFilter",
+                                                        "ComputePyramidImagesPerResolution",
+                                                        "OpenCLFixedGenericImagePyramidUseOpenCL",
+                                                        "ErodeMask",
+                                                        "ErodeFixedMask",
+                                                        "ErodeFixedMask0",
+                                                        "Metric",
+                                                        "FixedLimitRangeRatio" };
+
+  return AddParameterValuesToHash(hash, configuration, parameterNames);
+
+} // end AddParametersToHash()
+
+
+/**
+ * *********************** AddMovingParametersToHash ***************************
+ */
+
+std::uint64_t
+FixedImageDataCache::AddMovingParametersToHash(std::uint64_t hash, const Configuration & configuration)
+{
+  /** The parameters that may affect the moving image pyramid (as read by the moving image pyramid components). The
+   * B-spline coefficients are stored by a key that includes the spline order, so the interpolator parameters are not
+   * needed here.
+   */
+  static const std::vector<std::string> parameterNames{ "MovingImageDimension",
+                                                        "MovingInternalImagePixelType",
+                                                        "UseDirectionCosines",
+                                                        "Registration",
+                                                        "NumberOfResolutions",
+                                                        "MovingImagePyramid",
+                                                        "ImagePyramidSchedule",
+                                                        "MovingImagePyramidSchedule",
+                                                        "MovingImagePyramid0Schedule",
+                                                        "ImagePyramidRescaleSchedule",
+                                                        "MovingImagePyramidRescaleSchedule",
+                                                        "ImagePyramidSmoothingSchedule",
+                                                        "MovingImagePyramidSmoothingSchedule",
+                                                        "ImagePyramidUseShrinkImageFilter",
+                                                        "ComputePyramidImagesPerResolution",
+                                                        "OpenCLMovingGenericImagePyramidUseOpenCL" };
+
+  return AddParameterValuesToHash(hash, configuration, parameterNames);
+
+} // end AddMovingParametersToHash()
+
+
+/**
+ * *********************** AddParameterValuesToHash ***************************
+ */
+
+std::uint64_t
+FixedImageDataCache::AddParameterValuesToHash(std::uint64_t                    hash,
+                                              const Configuration &            configuration,
+                                              const std::vector<std::string> & parameterNames)
+{
+  for (const auto & parameterName : parameterNames)
+  {
+    hash = CacheUtilities::AddStringToHash(hash, parameterName);
+
+    for (const auto & value : configuration.GetValuesOfParameter(parameterName))
+    {
+      hash = CacheUtilities::AddStringToHash(hash, value);
+    }
+  }
+  return hash;
+
+} // end AddParameterValuesToHash()
+
+
+/**
+ * *********************** MakeParametersKey ***************************
+ */
+
+std::string
+FixedImageDataCache::MakeParametersKey(const Configuration & configuration)
+{
+  return HashToContentKey(AddParametersToHash(CacheUtilities::FnvOffsetBasis, configuration));
+
+} // end MakeParametersKey()
+
+
+/**
+ * *********************** HashToContentKey ***************************
+ */
+
+std::string
+FixedImageDataCache::HashToContentKey(const std::uint64_t hash)
+{
+  return CacheUtilities::HashToString(hash) + '_';
+
+} // end HashToContentKey()
+
+
+/**
+ * *********************** MakeFileName ***************************
+ */
+
+std::string
+FixedImageDataCache::MakeFileName(const std::string & key, const std::string & extension) const
+{
+  if (m_Directory.empty())
+  {
+    return {};
+  }
+
+  /** Only keep alphanumeric characters of the key, to get a valid file name on any file system. */
+  std::string baseName = key;
+  for (auto & character : baseName)
+  {
+    if (!std::isalnum(static_cast<unsigned char>(character)))
+    {
+      character = '_';
+    }
+  }
+  return m_Directory + '/' + baseName + extension;
+
+} // end MakeFileName()
+
+
+/**
+ * *********************** CommitFile ***************************
+ */
+
+void
+FixedImageDataCache::CommitFile(const std::string & temporaryFileName, const std::string & fileName)
+{
+  if (!CacheUtilities::CommitFile(temporaryFileName, fileName))
+  {
+    xl::xout["warning"] << "WARNING: Failed to store " << fileName << " in the fixed image data cache." << std::endl;
+  }
+
+} // end CommitFile()
+
+
+/**
+ * *********************** GetDataObject ***************************
+ */
+
+auto
+FixedImageDataCache::GetDataObject(const std::string & key) const -> DataObjectPointer
+{
+  const std::lock_guard<std::mutex> lock(m_Mutex);
+
+  const auto found = m_DataObjectMap.find(key);
+  return (found == m_DataObjectMap.end()) ? nullptr : found->second;
+
+} // end GetDataObject()
+
+
+/**
+ * *********************** SetDataObject ***************************
+ */
+
+void
+FixedImageDataCache::SetDataObject(const std::string & key, DataObjectType * const dataObject)
+{
+  const std::lock_guard<std::mutex> lock(m_Mutex);
+  m_DataObjectMap[key] = dataObject;
+
+} // end SetDataObject()
+
+
+/**
+ * *********************** GetValues ***************************
+ */
+
+bool
+FixedImageDataCache::GetValues(const std::string & key, ValuesType & values)
+{
+  {
+    const std::lock_guard<std::mutex> lock(m_Mutex);
+
+    const auto found = m_ValuesMap.find(key);
+    if (found != m_ValuesMap.end())
+    {
+      values = found->second;
+      return true;
+    }
+  }
+
+  /** Look for the values on disk. */
+  const std::string fileName = this->MakeFileName(key, ".txt");
+  if (fileName.empty())
+  {
+    return false;
+  }
+  std::ifstream file(fileName);
+  if (!file.is_open())
+  {
+    return false;
+  }
+
+  ValuesType valuesFromFile;
+  double     value;
+  while (file >> value)
+  {
+    valuesFromFile.push_back(value);
+  }
+  if (!file.eof())
+  {
+    xl::xout["warning"] << "WARNING: Failed to read " << fileName << " from the fixed image data cache." << std::endl;
+    return false;
+  }
+
+  const std::lock_guard<std::mutex> lock(m_Mutex);
+  values = m_ValuesMap[key] = valuesFromFile;
+  return true;
+
+} // end GetValues()
+
+
+/**
+ * *********************** SetValues ***************************
+ */
+
+void
+FixedImageDataCache::SetValues(const std::string & key, const ValuesType & values)
+{
+  {
+    const std::lock_guard<std::mutex> lock(m_Mutex);
+    m_ValuesMap[key] = values;
+  }
+
+  const std::string fileName = this->MakeFileName(key, ".txt");
+  if (fileName.empty())
+  {
+    return;
+  }
+
+  /** Write to a temporary file first, so that concurrent runs never read a partially written file. */
+  const std::string temporaryFileName = CacheUtilities::MakeTemporaryFileName(fileName);
+  {
+    std::ofstream file(temporaryFileName);
+    file << std::setprecision(std::numeric_limits<double>::max_digits10);
+    for (const double value : values)
+    {
+      file << value << '\n';
+    }
+    if (!file)
+    {
+      xl::xout["warning"] << "WARNING: Failed to write " << fileName << " to the fixed image data cache." << std::endl;
+      file.close();
+      itksys::SystemTools::RemoveFile(temporaryFileName);
+      return;
+    }
+  }
+  CommitFile(temporaryFileName, fileName);
+
+} // end SetValues()
+
+
+/**
+ * *********************** Clear ***************************
+ */
+
+void
+FixedImageDataCache::Clear(void)
+{
+  const std::lock_guard<std::mutex> lock(m_Mutex);
+  m_DataObjectMap.clear();
+  m_ValuesMap.clear();
+
+} // end Clear()
+
+
+/**
+ * *********************** GetNumberOfEntries ***************************
+ */
+
+std::size_t
+FixedImageDataCache::GetNumberOfEntries(void) const
+{
+  const std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_DataObjectMap.size() + m_ValuesMap.size();
+
+} // end GetNumberOfEntries()
+
+} // end namespace elastix
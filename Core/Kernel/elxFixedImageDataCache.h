@@ -0,0 +1,321 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef elxFixedImageDataCache_h
+#define elxFixedImageDataCache_h
+
+#include "elxCacheUtilities.h"
+#include "elxConfiguration.h"
+
+#include "itkDataObject.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include <itksys/SystemTools.hxx>
+
+#include <cstdint>
+#include <iomanip> // For setprecision.
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace elastix
+{
+
+/**
+ * \class FixedImageDataCache
+ *
+ * \brief Stores data that only depends on the fixed side of a registration,
+ * so that it can be reused by subsequent registrations.
+ *
+ * When many moving images are registered against the same fixed image (and
+ * fixed mask), using the same parameter map, the fixed image pyramid, the
+ * eroded fixed masks and the fixed image extrema are the same for each of
+ * those registrations. A FixedImageDataCache may then be shared by those
+ * registrations, to compute these data only once.
+ *
+ * The cache does not check whether the fixed image or the fixed mask have
+ * changed. It is the responsibility of the user to call Clear() whenever any
+ * of them is modified. Changes of the parameter map are taken into account
+ * by prefixing the keys by a parameters key, as generated by
+ * MakeParametersKey().
+ *
+ * The data are stored by a key, that is generated by MakeKey(). Access to
+ * the cache is thread-safe.
+ *
+ * Optionally, the cache also stores its images and values on disk, in the
+ * directory specified by SetDirectory(), so that they can be reused by
+ * subsequent runs of elastix (for example, a parameter sweep that does not
+ * change the fixed side of the registration). GetImage() and GetValues()
+ * then first look in memory, and then on disk. On disk, the data may
+ * outlive any change of the fixed image, the fixed mask or the parameter
+ * map, so the key of on-disk data should be prefixed by a content key, as
+ * generated by MakeContentKey(). The directory should be specified before
+ * the cache is being used by a registration.
+ *
+ * With an on-disk cache, data that only depend on the moving image (its
+ * pyramid, and the B-spline coefficients of its pyramid images) are stored
+ * as well, prefixed by a content key of the moving image, as generated by
+ * MakeMovingContentKey(). They are only stored on disk, not kept in memory,
+ * as the moving image usually differs for each registration.
+ *
+ * \ingroup Kernel
+ */
+
+class FixedImageDataCache : public itk::Object
+{
+public:
+  /** Standard.*/
+  typedef FixedImageDataCache           Self;
+  typedef itk::Object                   Superclass;
+  typedef itk::SmartPointer<Self>       Pointer;
+  typedef itk::SmartPointer<const Self> ConstPointer;
+
+  itkNewMacro(Self);
+  itkTypeMacro(FixedImageDataCache, Object);
+
+  typedef itk::DataObject         DataObjectType;
+  typedef DataObjectType::Pointer DataObjectPointer;
+  typedef std::vector<double>     ValuesType;
+
+  /** Set/Get the directory of the on-disk cache. Empty (default) means that the data are only stored in memory. */
+  itkSetStringMacro(Directory);
+  itkGetStringMacro(Directory);
+
+  /** Makes a key for the data with the specified name, for the specified elastix level and resolution. */
+  static std::string
+  MakeKey(const std::string & name, const unsigned int elastixLevel, const unsigned int resolution);
+
+  /** Makes a key that identifies the values of those parameters of the specified configuration that may affect the
+   * fixed image data. The key consists of hexadecimal digits, followed by an underscore, so that it can be used as a
+   * prefix of other keys.
+   */
+  static std::string
+  MakeParametersKey(const Configuration & configuration);
+
+  /** Makes a key that identifies the content of all the specified fixed images and fixed masks (any of which may be
+   * null), together with the values of those parameters of the specified configuration that may affect the fixed
+   * image data. The key consists of hexadecimal digits, followed by an underscore, so that it can be used as a prefix
+   * of other keys.
+   */
+  template <typename TImage, typename TMask>
+  static std::string
+  MakeContentKey(const std::vector<const TImage *> & images,
+                 const std::vector<const TMask *> &  masks,
+                 const Configuration &               configuration)
+  {
+    std::uint64_t hash = AddImagesToHash(CacheUtilities::FnvOffsetBasis, images);
+    hash = AddImagesToHash(hash, masks);
+    return HashToContentKey(AddParametersToHash(hash, configuration));
+  }
+
+  /** Makes a key that identifies the content of the specified moving image, together with the values of those
+   * parameters of the specified configuration that may affect the moving image data (the moving image pyramid). The
+   * key has the same format as the one of MakeContentKey().
+   */
+  template <typename TImage>
+  static std::string
+  MakeMovingContentKey(const TImage & image, const Configuration & configuration)
+  {
+    return HashToContentKey(
+      AddMovingParametersToHash(AddImageToHash(CacheUtilities::FnvOffsetBasis, image), configuration));
+  }
+
+  /** Returns the data object stored by the specified key, or null when there is none. */
+  DataObjectPointer
+  GetDataObject(const std::string & key) const;
+
+  /** Stores the specified data object by the specified key. */
+  void
+  SetDataObject(const std::string & key, DataObjectType * dataObject);
+
+  /** Returns the image stored by the specified key, or null when there is none. When the image is not in memory,
+   * but it is found in the directory of the on-disk cache, it is read from disk (and kept in memory, unless
+   * keepInMemory is false).
+   */
+  template <typename TImage>
+  typename TImage::Pointer
+  GetImage(const std::string & key, const bool keepInMemory = true)
+  {
+    if (const auto dataObject = this->GetDataObject(key))
+    {
+      return dynamic_cast<TImage *>(dataObject.GetPointer());
+    }
+
+    const std::string fileName = this->MakeFileName(key, ".mha");
+    if (fileName.empty() || !itksys::SystemTools::FileExists(fileName.c_str(), true))
+    {
+      return nullptr;
+    }
+
+    const auto reader = itk::ImageFileReader<TImage>::New();
+    reader->SetFileName(fileName);
+    try
+    {
+      reader->Update();
+    }
+    catch (const itk::ExceptionObject & excp)
+    {
+      xl::xout["warning"] << "WARNING: Failed to read " << fileName << " from the fixed image data cache.\n"
+                          << excp.GetDescription() << std::endl;
+      return nullptr;
+    }
+
+    const typename TImage::Pointer image = reader->GetOutput();
+    image->DisconnectPipeline();
+    if (keepInMemory)
+    {
+      this->SetDataObject(key, image);
+    }
+    return image;
+  }
+
+  /** Stores the specified image by the specified key, in memory (unless keepInMemory is false), and (when a directory
+   * is specified) on disk. */
+  template <typename TImage>
+  void
+  SetImage(const std::string & key, TImage * const image, const bool keepInMemory = true)
+  {
+    if (keepInMemory)
+    {
+      this->SetDataObject(key, image);
+    }
+
+    const std::string fileName = this->MakeFileName(key, ".mha");
+    if (fileName.empty() || (image == nullptr))
+    {
+      return;
+    }
+
+    /** Write to a temporary file first, so that concurrent runs never read a partially written file. */
+    const std::string temporaryFileName = CacheUtilities::MakeTemporaryFileName(fileName);
+    const auto        writer = itk::ImageFileWriter<TImage>::New();
+    writer->SetInput(image);
+    writer->SetFileName(temporaryFileName);
+    try
+    {
+      writer->Update();
+    }
+    catch (const itk::ExceptionObject & excp)
+    {
+      xl::xout["warning"] << "WARNING: Failed to write " << fileName << " to the fixed image data cache.\n"
+                          << excp.GetDescription() << std::endl;
+      itksys::SystemTools::RemoveFile(temporaryFileName);
+      return;
+    }
+    this->CommitFile(temporaryFileName, fileName);
+  }
+
+  /** Retrieves the values stored by the specified key, from memory, or (when a directory is specified) from disk.
+   * Returns false when there are none. */
+  bool
+  GetValues(const std::string & key, ValuesType & values);
+
+  /** Stores the specified values by the specified key, in memory, and (when a directory is specified) on disk. */
+  void
+  SetValues(const std::string & key, const ValuesType & values);
+
+  /** Removes all data from the cache, in memory. The data in the directory of the on-disk cache are kept, as their
+   * keys are supposed to identify their content. */
+  void
+  Clear(void);
+
+  /** Returns the total number of entries in the cache (in memory). */
+  std::size_t
+  GetNumberOfEntries(void) const;
+
+protected:
+  FixedImageDataCache() = default;
+  ~FixedImageDataCache() override = default;
+
+private:
+  FixedImageDataCache(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+
+  /** Adds the geometry and the pixel data of the specified image to the specified hash value. */
+  template <typename TImage>
+  static std::uint64_t
+  AddImageToHash(const std::uint64_t hash, const TImage & image)
+  {
+    std::ostringstream geometry;
+    geometry << std::setprecision(std::numeric_limits<double>::max_digits10) << image.GetNameOfClass() << ' '
+             << sizeof(typename TImage::PixelType) << ' ' << image.GetBufferedRegion() << ' ' << image.GetSpacing()
+             << ' ' << image.GetOrigin() << ' ' << image.GetDirection();
+    const std::string geometryString = geometry.str();
+
+    return CacheUtilities::AddToHash(
+      CacheUtilities::AddToHash(hash, geometryString.data(), geometryString.size()),
+      image.GetBufferPointer(),
+      image.GetBufferedRegion().GetNumberOfPixels() * sizeof(typename TImage::PixelType));
+  }
+
+  /** Adds the number of the specified images, and the geometry and the pixel data of each of them that is not null,
+   * to the specified hash value. */
+  template <typename TImage>
+  static std::uint64_t
+  AddImagesToHash(std::uint64_t hash, const std::vector<const TImage *> & images)
+  {
+    hash = CacheUtilities::AddStringToHash(hash, std::to_string(images.size()));
+    for (const auto image : images)
+    {
+      hash = (image == nullptr) ? CacheUtilities::AddStringToHash(hash, "null") : AddImageToHash(hash, *image);
+    }
+    return hash;
+  }
+
+  /** Adds the values of the parameters that may affect the fixed image data to the specified hash value. */
+  static std::uint64_t
+  AddParametersToHash(std::uint64_t hash, const Configuration & configuration);
+
+  /** Adds the values of the parameters that may affect the moving image data to the specified hash value. */
+  static std::uint64_t
+  AddMovingParametersToHash(std::uint64_t hash, const Configuration & configuration);
+
+  /** Adds the values of the specified parameters of the specified configuration to the specified hash value. */
+  static std::uint64_t
+  AddParameterValuesToHash(std::uint64_t                    hash,
+                           const Configuration &            configuration,
+                           const std::vector<std::string> & parameterNames);
+
+  /** Makes a content key from the specified hash value. */
+  static std::string
+  HashToContentKey(const std::uint64_t hash);
+
+  /** Returns the name of the file that stores the data of the specified key in the directory of the on-disk cache,
+   * or an empty string when no directory is specified. */
+  std::string
+  MakeFileName(const std::string & key, const std::string & extension) const;
+
+  /** Renames the specified temporary file to the specified file name, by CacheUtilities::CommitFile(), and warns
+   * when it fails. */
+  static void
+  CommitFile(const std::string & temporaryFileName, const std::string & fileName);
+
+  std::string                              m_Directory;
+  mutable std::mutex                       m_Mutex;
+  std::map<std::string, DataObjectPointer> m_DataObjectMap;
+  std::map<std::string, ValuesType>        m_ValuesMap;
+};
+
+} // end namespace elastix
+
+#endif // end #ifndef elxFixedImageDataCache_h
@@ -127,6 +127,7 @@ TransformixMain::Run(void)
    * ElastixTemplate will try to load them from disk.
    */
   elastixBase.SetMovingImageContainer(this->GetModifiableMovingImageContainer());
+  elastixBase.SetResultImageBuffer(this->GetModifiableResultImageBuffer());
 
   /** Set the initial transform, if it happens to be there
    * \todo: Does this make sense for transformix?
@@ -20,9 +20,11 @@
 
 // First include the header file to be tested:
 #include <itkElastixRegistrationMethod.h>
+#include <itkElastixRegistrationSession.h>
 
 #include "elxCoreMainGTestUtilities.h"
 #include "elxTransformIO.h"
+#include "itkTransformixFilter.h"
 #include "GTesting/elxGTestUtilities.h"
 
 // ITK header file:
@@ -36,15 +38,22 @@
 #include <itkSimilarity2DTransform.h>
 #include <itkTranslationTransform.h>
 #include <itkTransformFileReader.h>
+#include <itksys/Directory.hxx>
+#include <itksys/SystemTools.hxx>
 
 // GoogleTest header file:
 #include <gtest/gtest.h>
 
-#include <algorithm> // For transform
+#include <algorithm> // For count and transform
 #include <cmath>     // For M_PI
+#include <fstream>
+#include <initializer_list>
+#include <iterator> // For istreambuf_iterator
 #include <map>
 #include <string>
+#include <thread>
 #include <utility> // For pair
+#include <vector>
 
 
 // Using-declarations:
@@ -52,6 +61,7 @@ using elx::CoreMainGTestUtilities::CheckNew;
 using elx::CoreMainGTestUtilities::ConvertToOffset;
 using elx::CoreMainGTestUtilities::CreateImage;
 using elx::CoreMainGTestUtilities::CreateImageFilledWithSequenceOfNaturalNumbers;
+using elx::CoreMainGTestUtilities::CreateParameterMap;
 using elx::CoreMainGTestUtilities::CreateParameterObject;
 using elx::CoreMainGTestUtilities::Deref;
 using elx::CoreMainGTestUtilities::DerefSmartPointer;
@@ -65,6 +75,63 @@ using elx::GTestUtilities::MakePoint;
 using elx::GTestUtilities::MakeVector;
 
 
+namespace
+{
+// The 2D translation fixture, shared by various tests: two small (5x6) binary images, of which the moving image is
+// translated by translationOffset with respect to the fixed image, and the parameters to register them.
+constexpr auto TranslationImageDimension = 2U;
+using TranslationImageType = itk::Image<float, TranslationImageDimension>;
+const itk::Offset<TranslationImageDimension> translationOffset{ { 1, -2 } };
+
+struct TranslatedImagePair
+{
+  TranslationImageType::Pointer fixedImage;
+  TranslationImageType::Pointer movingImage;
+};
+
+
+TranslatedImagePair
+CreateTranslatedImagePair()
+{
+  using SizeType = itk::Size<TranslationImageDimension>;
+  using IndexType = itk::Index<TranslationImageDimension>;
+
+  const auto      regionSize = SizeType::Filled(2);
+  const SizeType  imageSize{ { 5, 6 } };
+  const IndexType fixedImageRegionIndex{ { 1, 3 } };
+
+  const auto fixedImage = CreateImage<TranslationImageType::PixelType>(imageSize);
+  FillImageRegion(*fixedImage, fixedImageRegionIndex, regionSize);
+  const auto movingImage = CreateImage<TranslationImageType::PixelType>(imageSize);
+  FillImageRegion(*movingImage, fixedImageRegionIndex + translationOffset, regionSize);
+  return { fixedImage, movingImage };
+}
+
+
+// Creates the parameters to register the translated image pair. The specified parameters are added to (or override)
+// the default ones.
+elx::ParameterObject::Pointer
+CreateTranslationParameterObject(
+  const std::initializer_list<std::pair<std::string, std::string>> additionalParameters = {})
+{
+  auto parameterMap = CreateParameterMap({ // Parameters in alphabetic order:
+                                           { "ImageSampler", "Full" },
+                                           { "MaximumNumberOfIterations", "2" },
+                                           { "Metric", "AdvancedNormalizedCorrelation" },
+                                           { "Optimizer", "AdaptiveStochasticGradientDescent" },
+                                           { "Transform", "TranslationTransform" } });
+  for (const auto & parameter : additionalParameters)
+  {
+    parameterMap[parameter.first] = { parameter.second };
+  }
+  const auto parameterObject = elx::ParameterObject::New();
+  parameterObject->SetParameterMap(parameterMap);
+  return parameterObject;
+}
+
+} // namespace
+
+
 // Tests registering two small (5x6) binary images, which are translated with respect to each other.
 GTEST_TEST(itkElastixRegistrationMethod, Translation)
 {
@@ -102,6 +169,601 @@ GTEST_TEST(itkElastixRegistrationMethod, Translation)
 }
 
 
+// Tests running multiple registrations concurrently, each in its own thread, having its own thread budget.
+GTEST_TEST(itkElastixRegistrationMethod, ConcurrentTranslations)
+{
+  constexpr auto ImageDimension = 2U;
+  using PixelType = float;
+  using ImageType = itk::Image<PixelType, ImageDimension>;
+  using SizeType = itk::Size<ImageDimension>;
+  using IndexType = itk::Index<ImageDimension>;
+  using OffsetType = itk::Offset<ImageDimension>;
+
+  const OffsetType translationOffset{ { 1, -2 } };
+  const auto       regionSize = SizeType::Filled(2);
+  const SizeType   imageSize{ { 5, 6 } };
+  const IndexType  fixedImageRegionIndex{ { 1, 3 } };
+
+  const auto fixedImage = CreateImage<PixelType>(imageSize);
+  FillImageRegion(*fixedImage, fixedImageRegionIndex, regionSize);
+  const auto movingImage = CreateImage<PixelType>(imageSize);
+  FillImageRegion(*movingImage, fixedImageRegionIndex + translationOffset, regionSize);
+
+  constexpr auto numberOfRegistrations = 4;
+
+  std::vector<itk::ElastixRegistrationMethod<ImageType, ImageType>::Pointer> filters;
+
+  for (int i{}; i < numberOfRegistrations; ++i)
+  {
+    const auto filter = CheckNew<itk::ElastixRegistrationMethod<ImageType, ImageType>>();
+    filter->SetFixedImage(fixedImage);
+    filter->SetMovingImage(movingImage);
+    filter->SetNumberOfThreads(1);
+    filter->SetParameterObject(CreateParameterObject({ // Parameters in alphabetic order:
+                                                       { "ImageSampler", "Full" },
+                                                       { "MaximumNumberOfIterations", "2" },
+                                                       { "Metric", "AdvancedNormalizedCorrelation" },
+                                                       { "Optimizer", "AdaptiveStochasticGradientDescent" },
+                                                       { "Transform", "TranslationTransform" } }));
+    filters.push_back(filter);
+  }
+
+  std::vector<std::thread> threads;
+
+  for (const auto & filter : filters)
+  {
+    threads.emplace_back([&filter] { filter->Update(); });
+  }
+  for (auto & thread : threads)
+  {
+    thread.join();
+  }
+
+  for (const auto & filter : filters)
+  {
+    const auto transformParameters = GetTransformParametersFromFilter(*filter);
+    EXPECT_EQ(ConvertToOffset<ImageDimension>(transformParameters), translationOffset);
+  }
+}
+
+
+// Tests that registrations with a random sampler and a fixed "RandomSeed" yield the same results, whether they are run
+// sequentially or concurrently, as each registration has its own random number generator.
+GTEST_TEST(itkElastixRegistrationMethod, ConcurrentRandomSampling)
+{
+  constexpr auto ImageDimension = 2U;
+  using PixelType = float;
+  using ImageType = itk::Image<PixelType, ImageDimension>;
+  using SizeType = itk::Size<ImageDimension>;
+  using IndexType = itk::Index<ImageDimension>;
+  using OffsetType = itk::Offset<ImageDimension>;
+
+  const OffsetType translationOffset{ { 1, -2 } };
+  const auto       regionSize = SizeType::Filled(2);
+  const SizeType   imageSize{ { 5, 6 } };
+  const IndexType  fixedImageRegionIndex{ { 1, 3 } };
+
+  const auto fixedImage = CreateImage<PixelType>(imageSize);
+  FillImageRegion(*fixedImage, fixedImageRegionIndex, regionSize);
+  const auto movingImage = CreateImage<PixelType>(imageSize);
+  FillImageRegion(*movingImage, fixedImageRegionIndex + translationOffset, regionSize);
+
+  for (const std::string imageSampler : { "Random", "RandomCoordinate" })
+  {
+    const auto createFilter = [&] {
+      const auto filter = CheckNew<itk::ElastixRegistrationMethod<ImageType, ImageType>>();
+      filter->SetFixedImage(fixedImage);
+      filter->SetMovingImage(movingImage);
+      filter->SetNumberOfThreads(1);
+      filter->SetParameterObject(CreateParameterObject({ // Parameters in alphabetic order:
+                                                         { "ImageSampler", imageSampler },
+                                                         { "MaximumNumberOfIterations", "4" },
+                                                         { "Metric", "AdvancedNormalizedCorrelation" },
+                                                         { "NewSamplesEveryIteration", "true" },
+                                                         { "NumberOfSpatialSamples", "12" },
+                                                         { "Optimizer", "AdaptiveStochasticGradientDescent" },
+                                                         { "RandomSeed", "12345" },
+                                                         { "Transform", "TranslationTransform" } }));
+      return filter;
+    };
+
+    // Run the registrations sequentially, to obtain the expected results.
+    const auto sequentialFilter = createFilter();
+    sequentialFilter->Update();
+    const auto expectedTransformParameters = GetTransformParametersFromFilter(*sequentialFilter);
+
+    constexpr auto numberOfRegistrations = 4;
+
+    std::vector<itk::ElastixRegistrationMethod<ImageType, ImageType>::Pointer> filters;
+
+    for (int i{}; i < numberOfRegistrations; ++i)
+    {
+      filters.push_back(createFilter());
+    }
+
+    std::vector<std::thread> threads;
+
+    for (const auto & filter : filters)
+    {
+      threads.emplace_back([&filter] { filter->Update(); });
+    }
+    for (auto & thread : threads)
+    {
+      thread.join();
+    }
+
+    for (const auto & filter : filters)
+    {
+      EXPECT_EQ(GetTransformParametersFromFilter(*filter), expectedTransformParameters);
+    }
+
+    // Running it sequentially once more still yields the same result.
+    const auto filter = createFilter();
+    filter->Update();
+    EXPECT_EQ(GetTransformParametersFromFilter(*filter), expectedTransformParameters);
+  }
+}
+
+
+// Tests that registrations that share a FixedImageDataCache yield the same results as without the cache.
+GTEST_TEST(itkElastixRegistrationMethod, FixedImageDataCache)
+{
+  constexpr auto ImageDimension = 2U;
+  using PixelType = float;
+  using ImageType = itk::Image<PixelType, ImageDimension>;
+  using SizeType = itk::Size<ImageDimension>;
+  using IndexType = itk::Index<ImageDimension>;
+  using OffsetType = itk::Offset<ImageDimension>;
+
+  const OffsetType translationOffset{ { 1, -2 } };
+  const auto       regionSize = SizeType::Filled(2);
+  const SizeType   imageSize{ { 5, 6 } };
+  const IndexType  fixedImageRegionIndex{ { 1, 3 } };
+
+  const auto fixedImage = CreateImage<PixelType>(imageSize);
+  FillImageRegion(*fixedImage, fixedImageRegionIndex, regionSize);
+  const auto movingImage = CreateImage<PixelType>(imageSize);
+  FillImageRegion(*movingImage, fixedImageRegionIndex + translationOffset, regionSize);
+
+  const auto parameterObject = CreateParameterObject({ // Parameters in alphabetic order:
+                                                       { "ImageSampler", "Full" },
+                                                       { "MaximumNumberOfIterations", "2" },
+                                                       { "Metric", "AdvancedNormalizedCorrelation" },
+                                                       { "Optimizer", "AdaptiveStochasticGradientDescent" },
+                                                       { "Transform", "TranslationTransform" } });
+
+  const auto cache = elx::FixedImageDataCache::New();
+
+  const auto registerWithCache = [&](elx::FixedImageDataCache * const fixedImageDataCache) {
+    const auto filter = CheckNew<itk::ElastixRegistrationMethod<ImageType, ImageType>>();
+    filter->SetFixedImage(fixedImage);
+    filter->SetMovingImage(movingImage);
+    filter->SetParameterObject(parameterObject);
+    filter->SetFixedImageDataCache(fixedImageDataCache);
+    filter->Update();
+    return GetTransformParametersFromFilter(*filter);
+  };
+
+  const auto expectedTransformParameters = registerWithCache(nullptr);
+  EXPECT_EQ(ConvertToOffset<ImageDimension>(expectedTransformParameters), translationOffset);
+
+  EXPECT_EQ(registerWithCache(cache), expectedTransformParameters);
+  EXPECT_GT(cache->GetNumberOfEntries(), 0U);
+
+  // This time, the fixed image data are retrieved from the cache.
+  const auto numberOfEntries = cache->GetNumberOfEntries();
+  EXPECT_EQ(registerWithCache(cache), expectedTransformParameters);
+  EXPECT_EQ(cache->GetNumberOfEntries(), numberOfEntries);
+
+  // Changing a parameter of the fixed image pyramid should not retrieve the (now outdated) data from the cache.
+  parameterObject->SetParameter("FixedImagePyramid", "FixedGenericImagePyramid");
+  parameterObject->SetParameter("NumberOfResolutions", "1");
+
+  for (const auto smoothingSchedule : { "0", "0.5" })
+  {
+    parameterObject->SetParameter("ImagePyramidSmoothingSchedule",
+                                  elx::ParameterObject::ParameterValueVectorType(TranslationImageDimension,
+                                                                                 smoothingSchedule));
+    const auto expectedTransformParametersWithSmoothingSchedule = registerWithCache(nullptr);
+    const auto numberOfEntriesBefore = cache->GetNumberOfEntries();
+    EXPECT_EQ(registerWithCache(cache), expectedTransformParametersWithSmoothingSchedule);
+    EXPECT_GT(cache->GetNumberOfEntries(), numberOfEntriesBefore);
+  }
+}
+
+
+// Tests that the parameters key of the fixed image data cache changes whenever any of the parameters of the fixed
+// image pyramid or the mask erosion changes.
+GTEST_TEST(FixedImageDataCache, MakeParametersKey)
+{
+  using ParameterMapType = elx::Configuration::ParameterFileParserType::ParameterMapType;
+
+  const auto makeParametersKey = [](const ParameterMapType & parameterMap) {
+    const auto configuration = elx::Configuration::New();
+    configuration->Initialize({}, parameterMap);
+    return elx::FixedImageDataCache::MakeParametersKey(*configuration);
+  };
+
+  const auto defaultKey = makeParametersKey({});
+  EXPECT_EQ(makeParametersKey({}), defaultKey);
+  EXPECT_EQ(makeParametersKey({ { "MaximumNumberOfIterations", { "2" } } }), defaultKey);
+
+  for (const std::string parameterName : { "NumberOfResolutions",
+                                           "FixedImagePyramid",
+                                           "ImagePyramidSchedule",
+                                           "FixedImagePyramidSchedule",
+                                           "FixedImagePyramid0Schedule",
+                                           "ImagePyramidRescaleSchedule",
+                                           "FixedImagePyramidRescaleSchedule",
+                                           "ImagePyramidSmoothingSchedule",
+                                           "FixedImagePyramidSmoothingSchedule",
+                                           "ImagePyramidUseShrinkImageFilter",
+                                           "ComputePyramidImagesPerResolution",
+                                           "ErodeMask",
+                                           "ErodeFixedMask",
+                                           "ErodeFixedMask0",
+                                           "FixedLimitRangeRatio" })
+  {
+    const auto key = makeParametersKey({ { parameterName, { "1" } } });
+    EXPECT_NE(key, defaultKey) << parameterName;
+    EXPECT_NE(makeParametersKey({ { parameterName, { "2" } } }), key) << parameterName;
+  }
+}
+
+
+// Tests that the content key of the fixed image data cache depends on all fixed images and masks, and that the moving
+// content key depends on the moving image.
+GTEST_TEST(FixedImageDataCache, MakeContentKey)
+{
+  constexpr auto ImageDimension = 2U;
+  using ImageType = itk::Image<float, ImageDimension>;
+  using MaskType = itk::Image<unsigned char, ImageDimension>;
+  using ImagesType = std::vector<const ImageType *>;
+  using MasksType = std::vector<const MaskType *>;
+
+  const auto configuration = elx::Configuration::New();
+  configuration->Initialize({}, {});
+
+  const itk::Size<ImageDimension> imageSize{ { 5, 6 } };
+  const auto                      image0 = CreateImageFilledWithSequenceOfNaturalNumbers<float>(imageSize);
+  const auto                      image1 = CreateImageFilledWithSequenceOfNaturalNumbers<float>(imageSize);
+  const auto                      mask0 = CreateImage<unsigned char>(imageSize);
+  const auto                      mask1 = CreateImage<unsigned char>(imageSize);
+  mask0->FillBuffer(1);
+  mask1->FillBuffer(1);
+
+  const auto makeContentKey = [&configuration](const ImagesType & images, const MasksType & masks) {
+    return elx::FixedImageDataCache::MakeContentKey(images, masks, *configuration);
+  };
+
+  const auto key = makeContentKey({ image0, image1 }, { mask0, mask1 });
+  EXPECT_EQ(makeContentKey({ image0, image1 }, { mask0, mask1 }), key);
+  EXPECT_NE(makeContentKey({ image0 }, { mask0, mask1 }), key);
+  EXPECT_NE(makeContentKey({ image0, image1 }, { mask0 }), key);
+  EXPECT_NE(makeContentKey({ image0, image1 }, { mask0, nullptr }), key);
+  EXPECT_NE(makeContentKey({ image0, image1 }, {}), key);
+
+  const auto movingKey = elx::FixedImageDataCache::MakeMovingContentKey(*image1, *configuration);
+  EXPECT_EQ(elx::FixedImageDataCache::MakeMovingContentKey(*image0, *configuration), movingKey);
+
+  // Modifying the second image or the second mask changes the content key.
+  image1->SetPixel({ { 4, 5 } }, 0.0f);
+  EXPECT_NE(makeContentKey({ image0, image1 }, { mask0, mask1 }), key);
+  EXPECT_NE(elx::FixedImageDataCache::MakeMovingContentKey(*image1, *configuration), movingKey);
+  image1->SetPixel({ { 4, 5 } }, image0->GetPixel({ { 4, 5 } }));
+  EXPECT_EQ(makeContentKey({ image0, image1 }, { mask0, mask1 }), key);
+
+  mask1->SetPixel({ { 0, 0 } }, 0);
+  EXPECT_NE(makeContentKey({ image0, image1 }, { mask0, mask1 }), key);
+}
+
+
+// Tests that subsequent runs that specify a FixedImageDataCacheDirectory yield the same results as without the cache.
+GTEST_TEST(itkElastixRegistrationMethod, FixedImageDataCacheDirectory)
+{
+  constexpr auto ImageDimension = 2U;
+  using PixelType = float;
+  using ImageType = itk::Image<PixelType, ImageDimension>;
+  using SizeType = itk::Size<ImageDimension>;
+  using IndexType = itk::Index<ImageDimension>;
+  using OffsetType = itk::Offset<ImageDimension>;
+
+  const OffsetType translationOffset{ { 1, -2 } };
+  const auto       regionSize = SizeType::Filled(2);
+  const SizeType   imageSize{ { 5, 6 } };
+  const IndexType  fixedImageRegionIndex{ { 1, 3 } };
+
+  const auto fixedImage = CreateImage<PixelType>(imageSize);
+  FillImageRegion(*fixedImage, fixedImageRegionIndex, regionSize);
+  const auto movingImage = CreateImage<PixelType>(imageSize);
+  FillImageRegion(*movingImage, fixedImageRegionIndex + translationOffset, regionSize);
+
+  const std::string cacheDirectoryPath = GetCurrentBinaryDirectoryPath() + '/' + GetNameOfTest(*this);
+  itksys::SystemTools::RemoveADirectory(cacheDirectoryPath);
+
+  const auto registerImages = [&](const std::string & fixedImageDataCacheDirectory) {
+    const auto filter = CheckNew<itk::ElastixRegistrationMethod<ImageType, ImageType>>();
+    filter->SetFixedImage(fixedImage);
+    filter->SetMovingImage(movingImage);
+    filter->SetParameterObject(
+      CreateParameterObject({ // Parameters in alphabetic order:
+                              { "FixedImageDataCacheDirectory", fixedImageDataCacheDirectory },
+                              { "ImageSampler", "Full" },
+                              { "MaximumNumberOfIterations", "2" },
+                              { "Metric", "AdvancedNormalizedCorrelation" },
+                              { "Optimizer", "AdaptiveStochasticGradientDescent" },
+                              { "Transform", "TranslationTransform" } }));
+    filter->Update();
+    return GetTransformParametersFromFilter(*filter);
+  };
+
+  const auto expectedTransformParameters = registerImages("");
+  EXPECT_EQ(ConvertToOffset<ImageDimension>(expectedTransformParameters), translationOffset);
+
+  EXPECT_EQ(registerImages(cacheDirectoryPath), expectedTransformParameters);
+
+  itksys::Directory directory;
+  ASSERT_TRUE(directory.Load(cacheDirectoryPath));
+  const auto numberOfFiles = directory.GetNumberOfFiles();
+  EXPECT_GT(numberOfFiles, 2U); // More than just "." and "..".
+
+  // This time, the fixed image data are read from disk, and no more files are written.
+  EXPECT_EQ(registerImages(cacheDirectoryPath), expectedTransformParameters);
+  ASSERT_TRUE(directory.Load(cacheDirectoryPath));
+  EXPECT_EQ(directory.GetNumberOfFiles(), numberOfFiles);
+}
+
+
+// Tests that a FixedImageDataCacheDirectory also stores the moving image pyramid and the B-spline coefficients of the
+// moving image, by the content of the moving image, and that the results are the same as without the cache.
+GTEST_TEST(itkElastixRegistrationMethod, FixedImageDataCacheDirectoryStoresMovingImageData)
+{
+  const auto imagePair = CreateTranslatedImagePair();
+
+  const std::string cacheDirectoryPath = GetCurrentBinaryDirectoryPath() + '/' + GetNameOfTest(*this);
+  itksys::SystemTools::RemoveADirectory(cacheDirectoryPath);
+
+  const auto registerImages = [&imagePair](const TranslationImageType & movingImage,
+                                           const std::string &          fixedImageDataCacheDirectory) {
+    const auto filter = CheckNew<itk::ElastixRegistrationMethod<TranslationImageType, TranslationImageType>>();
+    filter->SetFixedImage(imagePair.fixedImage);
+    filter->SetMovingImage(&movingImage);
+    filter->SetParameterObject(
+      CreateTranslationParameterObject({ { "BSplineInterpolationOrder", "3" },
+                                         { "FixedImageDataCacheDirectory", fixedImageDataCacheDirectory },
+                                         { "Interpolator", "BSplineInterpolator" },
+                                         { "NumberOfResolutions", "2" } }));
+    filter->Update();
+    return GetTransformParametersFromFilter(*filter);
+  };
+
+  const auto countFiles = [&cacheDirectoryPath](const std::string & namePart) {
+    itksys::Directory directory;
+    EXPECT_TRUE(directory.Load(cacheDirectoryPath));
+    unsigned long numberOfFiles{};
+    for (unsigned long i{}; i < directory.GetNumberOfFiles(); ++i)
+    {
+      numberOfFiles += (std::string(directory.GetFile(i)).find(namePart) != std::string::npos) ? 1 : 0;
+    }
+    return numberOfFiles;
+  };
+
+  const auto expectedTransformParameters = registerImages(*imagePair.movingImage, "");
+  EXPECT_EQ(registerImages(*imagePair.movingImage, cacheDirectoryPath), expectedTransformParameters);
+
+  // One pyramid image and one coefficient image per resolution.
+  EXPECT_EQ(countFiles("MovingImagePyramid"), 2U);
+  EXPECT_EQ(countFiles("MovingBSplineCoefficients"), 2U);
+  const auto numberOfFiles = countFiles("");
+
+  // This time, the moving image data are read from disk, and no more files are written.
+  EXPECT_EQ(registerImages(*imagePair.movingImage, cacheDirectoryPath), expectedTransformParameters);
+  EXPECT_EQ(countFiles(""), numberOfFiles);
+
+  // Another moving image has its own moving image data, but shares the fixed image data.
+  const auto otherMovingImage = CreateTranslatedImagePair().fixedImage;
+  EXPECT_EQ(registerImages(*otherMovingImage, cacheDirectoryPath), registerImages(*otherMovingImage, ""));
+  EXPECT_EQ(countFiles("MovingImagePyramid"), 4U);
+  EXPECT_EQ(countFiles("MovingBSplineCoefficients"), 4U);
+  EXPECT_EQ(countFiles(""), numberOfFiles + 4);
+}
+
+
+// Tests that an ElastixRegistrationSession yields the same results as separate registrations, also when it registers
+// concurrently, and when its parameter object is modified in place.
+GTEST_TEST(itkElastixRegistrationSession, RegisterTranslatedImages)
+{
+  using SessionType = itk::ElastixRegistrationSession<TranslationImageType, TranslationImageType>;
+
+  const auto imagePair = CreateTranslatedImagePair();
+
+  const auto registerWithoutSession = [&imagePair](elx::ParameterObject * const parameterObject) {
+    const auto filter = CheckNew<itk::ElastixRegistrationMethod<TranslationImageType, TranslationImageType>>();
+    filter->SetFixedImage(imagePair.fixedImage);
+    filter->SetMovingImage(imagePair.movingImage);
+    filter->SetParameterObject(parameterObject);
+    filter->Update();
+    return GetTransformParametersFromFilter(*filter);
+  };
+
+  const auto parameterObject = CreateTranslationParameterObject({ { "NumberOfResolutions", "2" } });
+
+  const auto session = CheckNew<SessionType>();
+  session->SetFixedImage(imagePair.fixedImage);
+  session->SetParameterObject(parameterObject);
+  session->SetNumberOfThreads(1);
+
+  const auto expectedTransformParameters = registerWithoutSession(parameterObject);
+  EXPECT_EQ(ConvertToOffset<TranslationImageDimension>(expectedTransformParameters), translationOffset);
+
+  EXPECT_EQ(GetTransformParametersFromFilter(*session->Register(imagePair.movingImage)), expectedTransformParameters);
+
+  const elx::FixedImageDataCache & cache = Deref(session->GetFixedImageDataCache());
+  const auto                       numberOfEntries = cache.GetNumberOfEntries();
+  EXPECT_GT(numberOfEntries, 0U);
+
+  // Concurrent registrations retrieve the fixed image data from the cache.
+  std::vector<SessionType::RegistrationMethodPointer> registrations(4);
+  std::vector<std::thread>                            threads;
+
+  for (auto & registration : registrations)
+  {
+    threads.emplace_back([&registration, &session, &imagePair] {
+      registration = session->Register(imagePair.movingImage);
+    });
+  }
+  for (auto & thread : threads)
+  {
+    thread.join();
+  }
+  for (const auto & registration : registrations)
+  {
+    EXPECT_EQ(GetTransformParametersFromFilter(*registration), expectedTransformParameters);
+  }
+  EXPECT_EQ(cache.GetNumberOfEntries(), numberOfEntries);
+
+  // After modifying the parameter object in place, the fixed image data are not retrieved from the (stale) entries.
+  parameterObject->SetParameter("NumberOfResolutions", "1");
+  EXPECT_EQ(GetTransformParametersFromFilter(*session->Register(imagePair.movingImage)),
+            registerWithoutSession(parameterObject));
+  EXPECT_GT(cache.GetNumberOfEntries(), numberOfEntries);
+}
+
+
+// Tests that imported (caller-owned) buffers are used without copying, including the result image buffer.
+GTEST_TEST(itkElastixRegistrationMethod, ImportedImagesAndResultImageBuffer)
+{
+  constexpr auto ImageDimension = 2U;
+  using PixelType = float;
+  using ImageType = itk::Image<PixelType, ImageDimension>;
+  using SizeType = itk::Size<ImageDimension>;
+  using IndexType = itk::Index<ImageDimension>;
+  using OffsetType = itk::Offset<ImageDimension>;
+
+  const OffsetType translationOffset{ { 1, -2 } };
+  const auto       regionSize = SizeType::Filled(2);
+  const SizeType   imageSize{ { 5, 6 } };
+  const IndexType  fixedImageRegionIndex{ { 1, 3 } };
+
+  const auto fixedImage = CreateImage<PixelType>(imageSize);
+  FillImageRegion(*fixedImage, fixedImageRegionIndex, regionSize);
+  const auto movingImage = CreateImage<PixelType>(imageSize);
+  FillImageRegion(*movingImage, fixedImageRegionIndex + translationOffset, regionSize);
+
+  const auto numberOfPixels = fixedImage->GetBufferedRegion().GetNumberOfPixels();
+  std::vector<PixelType> fixedPixels(fixedImage->GetBufferPointer(), fixedImage->GetBufferPointer() + numberOfPixels);
+  std::vector<PixelType> movingPixels(movingImage->GetBufferPointer(),
+                                      movingImage->GetBufferPointer() + numberOfPixels);
+  std::vector<PixelType> resultPixels(numberOfPixels);
+
+  const auto importImage = [&imageSize, &fixedImage](std::vector<PixelType> & pixels) {
+    return elx::ImportImage<ImageType>(
+      pixels.data(), imageSize, fixedImage->GetSpacing(), fixedImage->GetOrigin(), fixedImage->GetDirection());
+  };
+
+  const auto parameterObject = CreateParameterObject({ // Parameters in alphabetic order:
+                                                       { "ImageSampler", "Full" },
+                                                       { "MaximumNumberOfIterations", "2" },
+                                                       { "Metric", "AdvancedNormalizedCorrelation" },
+                                                       { "Optimizer", "AdaptiveStochasticGradientDescent" },
+                                                       { "Transform", "TranslationTransform" } });
+
+  const auto expectedFilter = CheckNew<itk::ElastixRegistrationMethod<ImageType, ImageType>>();
+  expectedFilter->SetFixedImage(fixedImage);
+  expectedFilter->SetMovingImage(movingImage);
+  expectedFilter->SetParameterObject(parameterObject);
+  expectedFilter->Update();
+
+  const auto filter = CheckNew<itk::ElastixRegistrationMethod<ImageType, ImageType>>();
+  filter->SetFixedImage(importImage(fixedPixels));
+  filter->SetMovingImage(importImage(movingPixels));
+  filter->SetResultImageBuffer(importImage(resultPixels));
+  filter->SetParameterObject(parameterObject);
+  filter->Update();
+
+  EXPECT_EQ(ConvertToOffset<ImageDimension>(GetTransformParametersFromFilter(*filter)), translationOffset);
+  EXPECT_EQ(GetTransformParametersFromFilter(*filter), GetTransformParametersFromFilter(*expectedFilter));
+
+  // The result image is resampled straight into the caller-provided buffer.
+  EXPECT_EQ(Deref(filter->GetOutput()).GetBufferPointer(), resultPixels.data());
+
+  const PixelType * const expectedPixels = Deref(expectedFilter->GetOutput()).GetBufferPointer();
+  EXPECT_EQ(resultPixels, std::vector<PixelType>(expectedPixels, expectedPixels + numberOfPixels));
+}
+
+
+// Tests that asynchronous logging yields the same log output as synchronous logging.
+GTEST_TEST(itkElastixRegistrationMethod, AsynchronousLogging)
+{
+  constexpr auto ImageDimension = 2U;
+  using PixelType = float;
+  using ImageType = itk::Image<PixelType, ImageDimension>;
+  using SizeType = itk::Size<ImageDimension>;
+  using IndexType = itk::Index<ImageDimension>;
+  using OffsetType = itk::Offset<ImageDimension>;
+
+  const OffsetType translationOffset{ { 1, -2 } };
+  const auto       regionSize = SizeType::Filled(2);
+  const SizeType   imageSize{ { 5, 6 } };
+  const IndexType  fixedImageRegionIndex{ { 1, 3 } };
+
+  const auto fixedImage = CreateImage<PixelType>(imageSize);
+  FillImageRegion(*fixedImage, fixedImageRegionIndex, regionSize);
+  const auto movingImage = CreateImage<PixelType>(imageSize);
+  FillImageRegion(*movingImage, fixedImageRegionIndex + translationOffset, regionSize);
+
+  const std::string rootOutputDirectoryPath = GetCurrentBinaryDirectoryPath() + '/' + GetNameOfTest(*this);
+  itk::FileTools::CreateDirectory(rootOutputDirectoryPath);
+
+  const auto readLines = [](const std::string & fileName) {
+    std::ifstream            inputFileStream(fileName);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(inputFileStream, line);)
+    {
+      lines.push_back(line);
+    }
+    return lines;
+  };
+
+  std::map<bool, std::vector<std::string>> iterationInfoLines;
+
+  for (const bool asynchronousLogging : { false, true })
+  {
+    const std::string outputDirectoryPath =
+      rootOutputDirectoryPath + (asynchronousLogging ? "/Asynchronous" : "/Synchronous");
+    itk::FileTools::CreateDirectory(outputDirectoryPath);
+
+    const auto filter = CheckNew<itk::ElastixRegistrationMethod<ImageType, ImageType>>();
+    filter->SetFixedImage(fixedImage);
+    filter->SetMovingImage(movingImage);
+    filter->SetOutputDirectory(outputDirectoryPath);
+    filter->LogToFileOn();
+    filter->SetAsynchronousLogging(asynchronousLogging);
+    filter->SetParameterObject(CreateParameterObject({ // Parameters in alphabetic order:
+                                                       { "ImageSampler", "Full" },
+                                                       { "MaximumNumberOfIterations", "2" },
+                                                       { "Metric", "AdvancedNormalizedCorrelation" },
+                                                       { "Optimizer", "AdaptiveStochasticGradientDescent" },
+                                                       { "Transform", "TranslationTransform" } }));
+    filter->Update();
+
+    EXPECT_EQ(ConvertToOffset<ImageDimension>(GetTransformParametersFromFilter(*filter)), translationOffset);
+
+    // All output must have been written to the files when the filter is finished.
+    const auto logLines = readLines(outputDirectoryPath + "/elastix.log");
+    EXPECT_FALSE(logLines.empty());
+    EXPECT_EQ(std::count(logLines.cbegin(), logLines.cend(), "Resolution: 0"), 1);
+
+    iterationInfoLines[asynchronousLogging] = readLines(outputDirectoryPath + "/IterationInfo.0.R0.txt");
+  }
+
+  // The header plus at least one row of iteration info.
+  EXPECT_GT(iterationInfoLines[false].size(), 1U);
+  EXPECT_EQ(iterationInfoLines[true].size(), iterationInfoLines[false].size());
+  EXPECT_EQ(iterationInfoLines[true].front(), iterationInfoLines[false].front());
+}
+
+
 // Tests "MaximumNumberOfIterations" value "0"
 GTEST_TEST(itkElastixRegistrationMethod, MaximumNumberOfIterationsZero)
 {
@@ -459,6 +1121,109 @@ GTEST_TEST(itkElastixRegistrationMethod, InitialTransformParameterFileLinkToTran
 }
 
 
+// Tests that the transform parameters written to a binary file (having "WriteTransformParametersToBinaryFile" set) are
+// read back, when the transform parameter file is used as initial transform. The output directory has a dot in its
+// name, and the binary file is referred to by a path relative to the directory of the transform parameter file.
+GTEST_TEST(itkElastixRegistrationMethod, WriteTransformParametersToBinaryFile)
+{
+  const auto imagePair = CreateTranslatedImagePair();
+
+  const std::string outputDirectoryPath = GetCurrentBinaryDirectoryPath() + '/' + GetNameOfTest(*this) + ".dir";
+  itk::FileTools::CreateDirectory(outputDirectoryPath);
+
+  const auto filter = CheckNew<itk::ElastixRegistrationMethod<TranslationImageType, TranslationImageType>>();
+  filter->SetFixedImage(imagePair.fixedImage);
+  filter->SetMovingImage(imagePair.movingImage);
+  filter->SetOutputDirectory(outputDirectoryPath);
+  filter->SetParameterObject(CreateTranslationParameterObject({ { "WriteTransformParametersToBinaryFile", "true" } }));
+  filter->Update();
+
+  EXPECT_EQ(ConvertToOffset<TranslationImageDimension>(GetTransformParametersFromFilter(*filter)), translationOffset);
+  EXPECT_TRUE(itksys::SystemTools::FileExists(outputDirectoryPath + "/TransformParameters.0.bin", true));
+
+  const std::string transformParameterFileName = outputDirectoryPath + "/TransformParameters.0.txt";
+  std::ifstream     transformParameterFile(transformParameterFileName);
+  ASSERT_TRUE(transformParameterFile.is_open());
+  const std::string transformParameterFileContents{ std::istreambuf_iterator<char>(transformParameterFile),
+                                                    std::istreambuf_iterator<char>() };
+  EXPECT_NE(transformParameterFileContents.find("(TransformParametersBinaryFileName \"TransformParameters.0.bin\")"),
+            std::string::npos);
+  EXPECT_EQ(transformParameterFileContents.find("(TransformParameters "), std::string::npos);
+
+  // Use the written transform as initial transform, without further optimization. The result should then be equal to
+  // the result of the first registration.
+  const auto initialTransformFilter =
+    CheckNew<itk::ElastixRegistrationMethod<TranslationImageType, TranslationImageType>>();
+  initialTransformFilter->SetFixedImage(imagePair.fixedImage);
+  initialTransformFilter->SetMovingImage(imagePair.movingImage);
+  initialTransformFilter->SetInitialTransformParameterFileName(transformParameterFileName);
+  initialTransformFilter->SetParameterObject(
+    CreateTranslationParameterObject({ { "MaximumNumberOfIterations", "0" } }));
+  initialTransformFilter->Update();
+
+  const auto & expectedOutput = Deref(filter->GetOutput());
+  const auto & actualOutput = Deref(initialTransformFilter->GetOutput());
+  ASSERT_EQ(actualOutput.GetBufferedRegion(), expectedOutput.GetBufferedRegion());
+
+  for (const auto index :
+       itk::ZeroBasedIndexRange<TranslationImageDimension>(expectedOutput.GetBufferedRegion().GetSize()))
+  {
+    EXPECT_EQ(actualOutput.GetPixel(index), expectedOutput.GetPixel(index));
+  }
+}
+
+
+// Tests that the result image of a registration that has FlattenInitialTransform set is equal to the result of
+// transformix, applied to the resulting transform parameters. The flattened initial transform is only an approximation
+// (on a coarse grid) of the original initial transform, which is a B-spline transform.
+GTEST_TEST(itkElastixRegistrationMethod, FlattenInitialTransformYieldsSameResultAsTransformix)
+{
+  const auto imagePair = CreateTranslatedImagePair();
+
+  const std::string outputDirectoryPath = GetCurrentBinaryDirectoryPath() + '/' + GetNameOfTest(*this);
+  itk::FileTools::CreateDirectory(outputDirectoryPath);
+
+  // Create the initial transform, by a B-spline registration.
+  const auto bsplineFilter = CheckNew<itk::ElastixRegistrationMethod<TranslationImageType, TranslationImageType>>();
+  bsplineFilter->SetFixedImage(imagePair.fixedImage);
+  bsplineFilter->SetMovingImage(imagePair.movingImage);
+  bsplineFilter->SetOutputDirectory(outputDirectoryPath);
+  bsplineFilter->SetParameterObject(CreateTranslationParameterObject({ { "FinalGridSpacingInVoxels", "2" },
+                                                                       { "MaximumNumberOfIterations", "10" },
+                                                                       { "NumberOfResolutions", "1" },
+                                                                       { "Transform", "BSplineTransform" } }));
+  bsplineFilter->Update();
+
+  const auto bsplineParameters = GetTransformParametersFromFilter(*bsplineFilter);
+  ASSERT_TRUE(std::any_of(
+    bsplineParameters.cbegin(), bsplineParameters.cend(), [](const double parameter) { return parameter != 0.0; }));
+
+  const auto filter = CheckNew<itk::ElastixRegistrationMethod<TranslationImageType, TranslationImageType>>();
+  filter->SetFixedImage(imagePair.fixedImage);
+  filter->SetMovingImage(imagePair.movingImage);
+  filter->SetInitialTransformParameterFileName(outputDirectoryPath + "/TransformParameters.0.txt");
+  filter->SetParameterObject(CreateTranslationParameterObject({ { "FlattenInitialTransform", "true" },
+                                                                { "FlattenInitialTransformGridSpacing", "3" },
+                                                                { "MaximumNumberOfIterations", "0" } }));
+  filter->Update();
+
+  const auto transformixFilter = CheckNew<itk::TransformixFilter<TranslationImageType>>();
+  transformixFilter->SetMovingImage(imagePair.movingImage);
+  transformixFilter->SetTransformParameterObject(filter->GetTransformParameterObject());
+  transformixFilter->Update();
+
+  const auto & expectedOutput = Deref(transformixFilter->GetOutput());
+  const auto & actualOutput = Deref(filter->GetOutput());
+  ASSERT_EQ(actualOutput.GetBufferedRegion(), expectedOutput.GetBufferedRegion());
+
+  for (const auto index :
+       itk::ZeroBasedIndexRange<TranslationImageDimension>(expectedOutput.GetBufferedRegion().GetSize()))
+  {
+    EXPECT_EQ(actualOutput.GetPixel(index), expectedOutput.GetPixel(index));
+  }
+}
+
+
 GTEST_TEST(itkElastixRegistrationMethod, WriteCompositeTransform)
 {
   constexpr auto ImageDimension = 2U;
@@ -39,6 +39,8 @@
 #include <itkSimilarity2DTransform.h>
 #include <itkSimilarity3DTransform.h>
 #include <itkTranslationTransform.h>
+#include <itksys/Directory.hxx>
+#include <itksys/SystemTools.hxx>
 
 // GoogleTest header file:
 #include <gtest/gtest.h>
@@ -60,7 +62,9 @@ using elx::CoreMainGTestUtilities::CreateImageFilledWithSequenceOfNaturalNumbers
 using elx::CoreMainGTestUtilities::Deref;
 using elx::CoreMainGTestUtilities::DerefSmartPointer;
 using elx::CoreMainGTestUtilities::FillImageRegion;
+using elx::CoreMainGTestUtilities::GetCurrentBinaryDirectoryPath;
 using elx::CoreMainGTestUtilities::GetDataDirectoryPath;
+using elx::CoreMainGTestUtilities::GetNameOfTest;
 using elx::GTestUtilities::GeneratePseudoRandomParameters;
 using elx::GTestUtilities::MakePoint;
 using elx::GTestUtilities::MakeSize;
@@ -169,7 +173,8 @@ auto
 CreateTransformixFilter(itk::Image<TPixel, VImageDimension> &                            image,
                         const itk::Transform<double, VImageDimension, VImageDimension> & itkTransform,
                         const std::string & initialTransformParametersFileName = "NoInitialTransform",
-                        const std::string & howToCombineTransforms = "Compose")
+                        const std::string & howToCombineTransforms = "Compose",
+                        const ParameterMapType & additionalParameters = {})
 {
   const auto filter = CheckNew<itk::TransformixFilter<itk::Image<TPixel, VImageDimension>>>();
   filter->SetMovingImage(&image);
@@ -183,19 +188,27 @@ CreateTransformixFilter(itk::Image<TPixel, VImageDimension> &
     transformName.erase(dimensionPosition, 2);
   }
 
-  filter->SetTransformParameterObject(CreateParameterObject(
-    { // Parameters in alphabetic order:
-      { "Direction", CreateDefaultDirectionParameterValues<VImageDimension>() },
-      { "HowToCombineTransforms", { howToCombineTransforms } },
-      { "Index", ParameterValuesType(VImageDimension, "0") },
-      { "InitialTransformParametersFileName", { initialTransformParametersFileName } },
-      { "ITKTransformParameters", ConvertToParameterValues(itkTransform.GetParameters()) },
-      { "ITKTransformFixedParameters", ConvertToParameterValues(itkTransform.GetFixedParameters()) },
-      { "Origin", ParameterValuesType(VImageDimension, "0") },
-      { "ResampleInterpolator", { "FinalLinearInterpolator" } },
-      { "Size", ConvertToParameterValues(image.GetBufferedRegion().GetSize()) },
-      { "Transform", { transformName } },
-      { "Spacing", ParameterValuesType(VImageDimension, "1") } }));
+  ParameterMapType parameterMap{
+    // Parameters in alphabetic order:
+    { "Direction", CreateDefaultDirectionParameterValues<VImageDimension>() },
+    { "HowToCombineTransforms", { howToCombineTransforms } },
+    { "Index", ParameterValuesType(VImageDimension, "0") },
+    { "InitialTransformParametersFileName", { initialTransformParametersFileName } },
+    { "ITKTransformParameters", ConvertToParameterValues(itkTransform.GetParameters()) },
+    { "ITKTransformFixedParameters", ConvertToParameterValues(itkTransform.GetFixedParameters()) },
+    { "Origin", ParameterValuesType(VImageDimension, "0") },
+    { "ResampleInterpolator", { "FinalLinearInterpolator" } },
+    { "Size", ConvertToParameterValues(image.GetBufferedRegion().GetSize()) },
+    { "Transform", { transformName } },
+    { "Spacing", ParameterValuesType(VImageDimension, "1") }
+  };
+
+  for (const auto & parameter : additionalParameters)
+  {
+    parameterMap[parameter.first] = parameter.second;
+  }
+
+  filter->SetTransformParameterObject(CreateParameterObject(parameterMap));
   filter->Update();
   return filter;
 }
@@ -206,10 +219,11 @@ itk::SmartPointer<itk::Image<TPixel, VImageDimension>>
 RetrieveOutputFromTransformixFilter(itk::Image<TPixel, VImageDimension> &                            image,
                                     const itk::Transform<double, VImageDimension, VImageDimension> & itkTransform,
                                     const std::string & initialTransformParametersFileName = "NoInitialTransform",
-                                    const std::string & howToCombineTransforms = "Compose")
+                                    const std::string & howToCombineTransforms = "Compose",
+                                    const ParameterMapType & additionalParameters = {})
 {
-  const auto transformixFilter =
-    CreateTransformixFilter(image, itkTransform, initialTransformParametersFileName, howToCombineTransforms);
+  const auto transformixFilter = CreateTransformixFilter(
+    image, itkTransform, initialTransformParametersFileName, howToCombineTransforms, additionalParameters);
   const auto output = transformixFilter->GetOutput();
   EXPECT_NE(output, nullptr);
   return output;
@@ -689,3 +703,69 @@ GTEST_TEST(itkTransformixFilter, CombineTranslationAndScale)
   EXPECT_EQ(DerefSmartPointer(transformixOutput),
             *(CreateResampleImageFilter(*inputImage, scaleAndTranslationTransform)->GetOutput()));
 }
+
+
+GTEST_TEST(itkTransformixFilter, FlattenTransformChain)
+{
+  const auto imageSize = MakeSize(5, 6);
+  enum
+  {
+    dimension = decltype(imageSize)::Dimension
+  };
+  const auto inputImage = CreateImageFilledWithSequenceOfNaturalNumbers<float>(imageSize);
+
+  using ParametersValueType = double;
+
+  const std::string initialTransformParametersFileName =
+    GetDataDirectoryPath() + "/Translation(1,-2)/TransformParameters.txt";
+
+  // A chain of linear transforms is composed into a single affine transform.
+  elx::DefaultConstructibleSubclass<itk::AffineTransform<ParametersValueType, dimension>> scaleTransform;
+  scaleTransform.Scale(2.0);
+
+  EXPECT_EQ(DerefSmartPointer(RetrieveOutputFromTransformixFilter(*inputImage,
+                                                                  scaleTransform,
+                                                                  initialTransformParametersFileName,
+                                                                  "Compose",
+                                                                  { { "FlattenTransformChain", { "true" } } })),
+            DerefSmartPointer(
+              RetrieveOutputFromTransformixFilter(*inputImage, scaleTransform, initialTransformParametersFileName)));
+
+  // A chain that includes a B-spline is sampled at the output grid, possibly using a cache directory.
+  elx::DefaultConstructibleSubclass<itk::BSplineTransform<ParametersValueType, dimension>> bsplineTransform;
+  bsplineTransform.SetTransformDomainPhysicalDimensions(ConvertToItkVector(imageSize));
+  bsplineTransform.SetParameters(GeneratePseudoRandomParameters(bsplineTransform.GetParameters().size(), -1.0));
+
+  const auto expectedOutput =
+    RetrieveOutputFromTransformixFilter(*inputImage, bsplineTransform, initialTransformParametersFileName);
+
+  const std::string cacheDirectory = GetCurrentBinaryDirectoryPath() + '/' + GetNameOfTest(*this);
+  itksys::SystemTools::RemoveADirectory(cacheDirectory);
+
+  for (const auto & additionalParameters :
+       { ParameterMapType{ { "FlattenTransformChain", { "true" } } },
+         ParameterMapType{ { "FlattenTransformChain", { "true" } },
+                           { "FlattenedTransformChainCacheDirectory", { cacheDirectory } } } })
+  {
+    // When a cache directory is specified, the first iteration writes the cache file, the second one reads it.
+    for (int i = 0; i < 2; ++i)
+    {
+      const auto actualOutput = RetrieveOutputFromTransformixFilter(
+        *inputImage, bsplineTransform, initialTransformParametersFileName, "Compose", additionalParameters);
+
+      const itk::ImageBufferRange<const itk::Image<float, dimension>> actualRange(DerefSmartPointer(actualOutput));
+      const itk::ImageBufferRange<const itk::Image<float, dimension>> expectedRange(DerefSmartPointer(expectedOutput));
+      ASSERT_EQ(actualRange.size(), expectedRange.size());
+
+      for (std::size_t j = 0; j < actualRange.size(); ++j)
+      {
+        EXPECT_NEAR(actualRange[j], expectedRange[j], 1e-4);
+      }
+    }
+  }
+
+  itksys::Directory cacheDirectoryContents;
+  ASSERT_TRUE(cacheDirectoryContents.Load(cacheDirectory));
+  // The directory entries "." and "..", and exactly one cache file.
+  EXPECT_EQ(cacheDirectoryContents.GetNumberOfFiles(), 3U);
+}
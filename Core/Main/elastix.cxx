@@ -20,6 +20,7 @@
 #include "elastix.h"
 #include "elxConversion.h"
 #include "elxElastixMain.h"
+#include "itkParameterFileParser.h"
 #include <Core/elxVersionMacros.h>
 #include "itkUseMevisDicomTiff.h"
 
@@ -30,19 +31,321 @@
 
 // Standard C++ header files:
 #include <cassert>
+#include <cctype>  // For isspace.
 #include <climits> // For UINT_MAX.
 #include <cstddef> // For size_t.
+#include <exception>
 #include <iostream>
 #include <limits>
 #include <queue>
+#include <set>
+#include <string>
 #include <vector>
 
+
+namespace
+{
+
+/**
+ * *********************** MakeParameterFileKey ****************************
+ *
+ * Returns the key of the argument map entry of the specified (one-based)
+ * parameter file: "-p(1)", "-p(2)", etc., as printed by ElastixBase.
+ */
+
+std::string
+MakeParameterFileKey(const std::size_t parameterFileNumber)
+{
+  return "-p(" + std::to_string(parameterFileNumber) + ")";
+
+} // end MakeParameterFileKey()
+
+
+/**
+ * *********************** SplitJobLine ****************************
+ *
+ * Splits a job line of "--serve" into its fields. The fields are separated
+ * by white space (spaces or tabs). A field that is enclosed in double quotes
+ * may contain white space, for example: -m "C:/My Images/moving.mhd".
+ * Returns false when a quote is not closed, or not followed by white space.
+ */
+
+bool
+SplitJobLine(const std::string & line, std::vector<std::string> & fields)
+{
+  const auto isSpace = [](const char character) { return std::isspace(static_cast<unsigned char>(character)) != 0; };
+
+  fields.clear();
+  std::size_t i{};
+
+  while (true)
+  {
+    while ((i < line.size()) && isSpace(line[i]))
+    {
+      ++i;
+    }
+    if (i == line.size())
+    {
+      return true;
+    }
+
+    if (line[i] == '"')
+    {
+      const auto closingQuote = line.find('"', i + 1);
+      if (closingQuote == std::string::npos)
+      {
+        return false;
+      }
+      fields.push_back(line.substr(i + 1, closingQuote - i - 1));
+      i = closingQuote + 1;
+
+      if ((i < line.size()) && !isSpace(line[i]))
+      {
+        return false;
+      }
+    }
+    else
+    {
+      const auto start = i;
+      while ((i < line.size()) && !isSpace(line[i]))
+      {
+        ++i;
+      }
+      fields.push_back(line.substr(start, i - start));
+    }
+  }
+
+} // end SplitJobLine()
+
+
+/**
+ * *********************** Serve ****************************
+ *
+ * Runs elastix as a long-running process, registering a series of moving
+ * images against the same fixed image. The command line arguments (after
+ * "--serve") specify the fixed side: "-f", "-fMask", "-p" (once or more),
+ * and optionally "-threads" and "-priority". The priority is applied by
+ * each job. Each line that is read from std::cin specifies one job, by the
+ * arguments that are specific to that job: "-m" and "-out", and optionally
+ * "-mMask", "-t0", "-fp" and "-mp". The fields of a job line are separated
+ * by spaces or tabs, and may be enclosed in double quotes (see SplitJobLine).
+ * For each job, a line with its return code is written to std::cout: -2
+ * when the job line is invalid, -3 when an exception occurred, and
+ * otherwise the return code of the registration. These return codes are
+ * the only output to std::cout: any other output that is written to
+ * std::cout while serving is redirected to std::cerr.
+ * The process stops at end-of-input, or when an empty line is read.
+ *
+ * The parameter files are parsed only once, the fixed image and mask are
+ * read only once, and the fixed image data (pyramid, eroded masks,
+ * extrema) are cached across the jobs.
+ */
+
+int
+Serve(int argc, char ** argv)
+{
+  typedef elx::ElastixMain                            ElastixMainType;
+  typedef ElastixMainType::ObjectPointer              ObjectPointer;
+  typedef ElastixMainType::DataObjectContainerPointer DataObjectContainerPointer;
+  typedef ElastixMainType::FlatDirectionCosinesType   FlatDirectionCosinesType;
+  typedef ElastixMainType::ArgumentMapType            ArgumentMapType;
+  typedef ElastixMainType::ParameterMapType           ParameterMapType;
+
+  const std::set<std::string> serveKeys{ "-f", "-fMask", "-p", "-threads", "-priority" };
+  const std::set<std::string> jobKeys{ "-m", "-out", "-mMask", "-t0", "-fp", "-mp" };
+  const std::set<std::string> priorities{ "high", "abovenormal", "normal", "belownormal", "idle" };
+
+  ArgumentMapType          serveArgMap;
+  std::vector<std::string> parameterFileNames;
+
+  if ((argc % 2) != 0)
+  {
+    std::cerr << "ERROR: The command line option \"" << argv[argc - 1] << "\" has no value!" << std::endl;
+    return -1;
+  }
+
+  for (int i = 2; i < (argc - 1); i += 2)
+  {
+    const std::string key(argv[i]);
+    const std::string value(argv[i + 1]);
+
+    if (serveKeys.count(key) == 0)
+    {
+      std::cerr << "ERROR: The command line option \"" << key << "\" is not supported by \"--serve\"!" << std::endl;
+      return -1;
+    }
+    if (key == "-p")
+    {
+      parameterFileNames.push_back(value);
+      serveArgMap[MakeParameterFileKey(parameterFileNames.size())] = value;
+    }
+    else if (!serveArgMap.insert({ key, value }).second)
+    {
+      std::cerr << "ERROR: The command line option \"" << key << "\" is specified more than once!" << std::endl;
+      return -1;
+    }
+  }
+  serveArgMap["-argv0"] = argv[0];
+
+  if (parameterFileNames.empty() || (serveArgMap.count("-f") == 0))
+  {
+    std::cerr << "ERROR: \"--serve\" requires the command line options \"-f\" and \"-p\"!" << std::endl;
+    return -1;
+  }
+
+  const auto foundPriority = serveArgMap.find("-priority");
+  if ((foundPriority != serveArgMap.end()) && (priorities.count(foundPriority->second) == 0))
+  {
+    std::cerr << "ERROR: Unsupported -priority value \"" << foundPriority->second
+              << "\". Specify one of <high, abovenormal, normal, belownormal, idle>." << std::endl;
+    return -1;
+  }
+
+  /** Parse the parameter files once, for all jobs. */
+  std::vector<ParameterMapType> parameterMaps;
+  try
+  {
+    for (const auto & parameterFileName : parameterFileNames)
+    {
+      parameterMaps.push_back(itk::ParameterFileParser::ReadParameterMap(parameterFileName));
+    }
+  }
+  catch (const itk::ExceptionObject & excp)
+  {
+    std::cerr << "ERROR: when reading the parameter file:\n" << excp << std::endl;
+    return -1;
+  }
+
+  /** The return codes are written to the original standard output, which is reserved for them. Anything else that
+   * is written to std::cout while serving (for example, by the progress reports) goes to std::cerr instead.
+   */
+  std::ostream           protocolOutput(std::cout.rdbuf());
+  std::streambuf * const coutBuffer = std::cout.rdbuf(std::cerr.rdbuf());
+
+  /** The fixed side data, shared by all jobs. */
+  const auto                 fixedImageDataCache = elx::FixedImageDataCache::New();
+  DataObjectContainerPointer fixedImageContainer = nullptr;
+  DataObjectContainerPointer fixedMaskContainer = nullptr;
+  FlatDirectionCosinesType   fixedImageOriginalDirection;
+
+  std::string              line;
+  std::vector<std::string> fields;
+  while (std::getline(std::cin, line) && !line.empty())
+  {
+    /** Add the job specific arguments to the arguments of the server. A job may not override the fixed side. */
+    ArgumentMapType argMap = serveArgMap;
+    bool            isValidJob = SplitJobLine(line, fields) && ((fields.size() % 2) == 0);
+    for (std::size_t i{}; isValidJob && (i < fields.size()); i += 2)
+    {
+      isValidJob = (jobKeys.count(fields[i]) > 0) && argMap.insert({ fields[i], fields[i + 1] }).second;
+    }
+    if (!isValidJob)
+    {
+      protocolOutput << -2 << std::endl;
+      continue;
+    }
+
+    std::string & outFolder = argMap["-out"];
+    if (!outFolder.empty() && (outFolder.back() != '/') && (outFolder.back() != '\\'))
+    {
+      outFolder.append("/");
+    }
+    outFolder = elx::Conversion::ToNativePathNameSeparators(outFolder);
+
+    if ((argMap.count("-m") == 0) || outFolder.empty() || !itksys::SystemTools::FileIsDirectory(outFolder))
+    {
+      protocolOutput << -2 << std::endl;
+      continue;
+    }
+
+    int returndummy{};
+    try
+    {
+      const elx::xoutManager manager(outFolder + "elastix.log", true, false);
+
+      ObjectPointer              transform = nullptr;
+      DataObjectContainerPointer movingImageContainer = nullptr;
+      DataObjectContainerPointer movingMaskContainer = nullptr;
+      DataObjectContainerPointer levelFixedImageContainer = fixedImageContainer;
+      DataObjectContainerPointer levelFixedMaskContainer = fixedMaskContainer;
+      FlatDirectionCosinesType   levelFixedImageOriginalDirection = fixedImageOriginalDirection;
+
+      const auto nrOfParameterFiles = static_cast<unsigned int>(parameterFileNames.size());
+
+      for (unsigned int i{}; (i < nrOfParameterFiles) && (returndummy == 0); ++i)
+      {
+        const auto elastixMain = ElastixMainType::New();
+
+        elastixMain->SetInitialTransform(transform);
+        elastixMain->SetFixedImageContainer(levelFixedImageContainer);
+        elastixMain->SetMovingImageContainer(movingImageContainer);
+        elastixMain->SetFixedMaskContainer(levelFixedMaskContainer);
+        elastixMain->SetMovingMaskContainer(movingMaskContainer);
+        elastixMain->SetOriginalFixedImageDirectionFlat(levelFixedImageOriginalDirection);
+        elastixMain->SetFixedImageDataCache(fixedImageDataCache);
+        elastixMain->SetElastixLevel(i);
+        elastixMain->SetTotalNumberOfElastixLevels(nrOfParameterFiles);
+
+        argMap["-p"] = parameterFileNames[i];
+
+        returndummy = elastixMain->Run(argMap, parameterMaps[i]);
+
+        transform = elastixMain->GetModifiableFinalTransform();
+        levelFixedImageContainer = elastixMain->GetModifiableFixedImageContainer();
+        movingImageContainer = elastixMain->GetModifiableMovingImageContainer();
+        levelFixedMaskContainer = elastixMain->GetModifiableFixedMaskContainer();
+        movingMaskContainer = elastixMain->GetModifiableMovingMaskContainer();
+        levelFixedImageOriginalDirection = elastixMain->GetOriginalFixedImageDirectionFlat();
+      }
+
+      if ((returndummy == 0) && fixedImageContainer.IsNull())
+      {
+        /** Keep the fixed image and mask, as they were read by the first job. */
+        fixedImageContainer = levelFixedImageContainer;
+        fixedMaskContainer = levelFixedMaskContainer;
+        fixedImageOriginalDirection = levelFixedImageOriginalDirection;
+      }
+    }
+    catch (const itk::ExceptionObject & excp)
+    {
+      std::cerr << excp << std::endl;
+      returndummy = -3;
+    }
+    catch (const std::exception & excp)
+    {
+      std::cerr << "ERROR: " << excp.what() << std::endl;
+      returndummy = -3;
+    }
+    catch (...)
+    {
+      std::cerr << "ERROR: An unknown exception occurred." << std::endl;
+      returndummy = -3;
+    }
+
+    protocolOutput << returndummy << std::endl;
+  }
+
+  std::cout.rdbuf(coutBuffer);
+  return 0;
+
+} // end Serve()
+
+} // end unnamed namespace
+
+
 int
 main(int argc, char ** argv)
 {
   elastix::BaseComponent::InitializeElastixExecutable();
   assert(!elastix::BaseComponent::IsElastixLibrary());
 
+  /** Check if "--serve" was asked for. */
+  if ((argc > 1) && (std::string(argv[1]) == "--serve"))
+  {
+    RegisterMevisDicomTiff();
+    return Serve(argc, argv);
+  }
+
   /** Check if "--help" or "--version" was asked for. */
   if (argc == 1)
   {
@@ -120,10 +423,7 @@ main(int argc, char ** argv)
       parameterFileList.push(value);
       /** The different '-p' are stored in the argMap, with
        * keys p(1), p(2), etc. */
-      std::ostringstream tempPname;
-      tempPname << "-p(" << parameterFileList.size() << ")";
-      std::string tempPName = tempPname.str();
-      argMap.insert(ArgumentMapEntryType(tempPName, value));
+      argMap.insert(ArgumentMapEntryType(MakeParameterFileKey(parameterFileList.size()), value));
     }
     else
     {
@@ -344,7 +644,12 @@ PrintHelp(void)
             << "The registration-process is specified in the parameter file.\n"
             << "  --help, -h displays this message and exit\n"
             << "  --version  output version information and exit\n"
-            << "  --extended-version  output extended version information and exit\n\n";
+            << "  --extended-version  output extended version information and exit\n"
+            << "  --serve    keep running, to register the moving images that are specified\n"
+            << "             line by line (\"-m <image> -out <dir>\") via standard input,\n"
+            << "             against the fixed image that is specified by \"-f\", reusing\n"
+            << "             fixed image data. Writes the return code of each registration\n"
+            << "             to standard output.\n\n";
 
   /** Mandatory arguments.*/
   std::cout << "Call elastix from the command line with mandatory arguments:\n"
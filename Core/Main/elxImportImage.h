@@ -0,0 +1,61 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef elxImportImage_h
+#define elxImportImage_h
+
+#include "itkMacro.h"
+
+namespace elastix
+{
+
+/**
+ * Creates an itk::Image that borrows the specified caller-owned pixel buffer, without copying it.
+ * The buffer must hold (at least) as many pixels as specified by `size`, and it must stay alive
+ * as long as the image (or any filter output grafted from it) is in use. The image does not
+ * deallocate the buffer. May be used to pass raw image data to ElastixRegistrationMethod and
+ * TransformixFilter (both as input, and as result image buffer), without an extra copy.
+ */
+template <typename TImage>
+typename TImage::Pointer
+ImportImage(typename TImage::PixelType * const     pixelBuffer,
+            const typename TImage::SizeType &      size,
+            const typename TImage::SpacingType &   spacing,
+            const typename TImage::PointType &     origin,
+            const typename TImage::DirectionType & direction)
+{
+  if (pixelBuffer == nullptr)
+  {
+    itkGenericExceptionMacro(<< "ImportImage: the pixel buffer should not be null!");
+  }
+
+  const auto image = TImage::New();
+  image->SetRegions(size);
+  image->SetSpacing(spacing);
+  image->SetOrigin(origin);
+  image->SetDirection(direction);
+
+  /** Let the pixel container refer to the caller-owned buffer, without taking ownership. */
+  const auto numberOfPixels = image->GetLargestPossibleRegion().GetNumberOfPixels();
+  image->GetPixelContainer()->SetImportPointer(pixelBuffer, numberOfPixels, false);
+  return image;
+
+} // end ImportImage()
+
+} // end namespace elastix
+
+#endif // end #ifndef elxImportImage_h
@@ -38,6 +38,7 @@
 #include "itkImageSource.h"
 
 #include "elxElastixMain.h"
+#include "elxImportImage.h"
 #include "elxParameterObject.h"
 
 /**
@@ -240,9 +241,35 @@ public:
   itkGetConstReferenceMacro(LogToFile, bool);
   itkBooleanMacro(LogToFile);
 
+  /** Asynchronous logging on/off. When on, the log file, the console output and the IterationInfo files are written
+   * by background threads, so that the registration does not have to wait for slow I/O (for example, on a network
+   * file system). The output is buffered in a ring buffer of fixed size; output that does not fit is dropped, which
+   * is then reported in the log. Default: off. */
+  itkSetMacro(AsynchronousLogging, bool);
+  itkGetConstMacro(AsynchronousLogging, bool);
+  itkBooleanMacro(AsynchronousLogging);
+
+  /** Set/Get the maximum number of threads used by this registration. Zero (default) means no maximum. The
+   * maximum is specific to this registration object, so that multiple registrations may run concurrently (each in
+   * its own thread), dividing the available cores among them. */
   itkSetMacro(NumberOfThreads, int);
   itkGetConstMacro(NumberOfThreads, int);
 
+  /** Set/Get the cache of fixed image data (fixed image pyramid, eroded fixed masks, fixed image extrema). When
+   * multiple moving images are registered against the same fixed image, fixed mask and parameter object, the
+   * registrations may share a cache, so that these data are computed only once. Optional; default: null. \sa
+   * ElastixRegistrationSession */
+  itkSetObjectMacro(FixedImageDataCache, elastix::FixedImageDataCache);
+  itkGetModifiableObjectMacro(FixedImageDataCache, elastix::FixedImageDataCache);
+
+  /** Set/Get an (optional) image whose buffer, allocated by the caller, receives the result image. When its pixel
+   * type is equal to the internal moving image pixel type, and its number of pixels equals the size of the fixed
+   * image, elastix resamples straight into this buffer, and the output of this filter shares it. Otherwise a new
+   * buffer is allocated. Input images whose pixel type matches the internal pixel type are never copied either. \sa
+   * elastix::ImportImage */
+  itkSetObjectMacro(ResultImageBuffer, ResultImageType);
+  itkGetModifiableObjectMacro(ResultImageBuffer, ResultImageType);
+
 protected:
   ElastixRegistrationMethod();
 
@@ -284,9 +311,14 @@ private:
 
   bool m_LogToConsole;
   bool m_LogToFile;
+  bool m_AsynchronousLogging;
 
   int m_NumberOfThreads;
 
+  elastix::FixedImageDataCache::Pointer m_FixedImageDataCache;
+
+  typename ResultImageType::Pointer m_ResultImageBuffer;
+
   unsigned int m_InputUID;
 };
 
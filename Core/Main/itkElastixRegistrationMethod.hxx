@@ -61,6 +61,7 @@ ElastixRegistrationMethod<TFixedImage, TMovingImage>::ElastixRegistrationMethod(
 
   this->m_LogToConsole = false;
   this->m_LogToFile = false;
+  this->m_AsynchronousLogging = false;
 
   this->m_NumberOfThreads = 0;
 
@@ -217,7 +218,8 @@ ElastixRegistrationMethod<TFixedImage, TMovingImage>::GenerateData()
   }
 
   // Setup xout
-  const elastix::xoutManager manager(logFileName, this->GetLogToFile(), this->GetLogToConsole());
+  const elastix::xoutManager manager(
+    logFileName, this->GetLogToFile(), this->GetLogToConsole(), this->m_AsynchronousLogging);
 
   // Run the (possibly multiple) registration(s)
   for (unsigned int i = 0; i < parameterMapVector.size(); ++i)
@@ -250,6 +252,8 @@ ElastixRegistrationMethod<TFixedImage, TMovingImage>::GenerateData()
     elastix->SetMovingMaskContainer(movingMaskContainer);
     elastix->SetResultImageContainer(resultImageContainer);
     elastix->SetOriginalFixedImageDirectionFlat(fixedImageOriginalDirection);
+    elastix->SetFixedImageDataCache(this->m_FixedImageDataCache);
+    elastix->SetResultImageBuffer(this->m_ResultImageBuffer);
 
     // Start registration
     unsigned int isError = 0;
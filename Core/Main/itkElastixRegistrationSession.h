@@ -0,0 +1,127 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkElastixRegistrationSession_h
+#define itkElastixRegistrationSession_h
+
+#include "itkElastixRegistrationMethod.h"
+#include "elxFixedImageDataCache.h"
+
+/**
+ * \class ElastixRegistrationSession
+ * \brief Registers a series of moving images against the same fixed image, reusing fixed image data.
+ *
+ * The session holds a fixed image, an optional fixed mask, and a parameter object. Each call to Register()
+ * runs an ElastixRegistrationMethod for the specified moving image. The registrations share a
+ * FixedImageDataCache, so that the fixed image pyramid, the eroded fixed masks and the fixed image extrema are
+ * computed by the first registration only. The cache is cleared whenever the fixed image, the fixed mask or the
+ * parameter object is replaced.
+ *
+ * Register() may be called concurrently from multiple threads, as long as the fixed image, the fixed mask and the
+ * parameter object are not replaced meanwhile.
+ *
+ * \ingroup Elastix
+ */
+
+namespace itk
+{
+
+template <typename TFixedImage, typename TMovingImage>
+class ITK_TEMPLATE_EXPORT ElastixRegistrationSession : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(ElastixRegistrationSession);
+
+  /** Standard ITK typedefs. */
+  typedef ElastixRegistrationSession Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer<Self>         Pointer;
+  typedef SmartPointer<const Self>   ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ElastixRegistrationSession, Object);
+
+  /** Typedefs. */
+  typedef ElastixRegistrationMethod<TFixedImage, TMovingImage> RegistrationMethodType;
+  typedef typename RegistrationMethodType::Pointer             RegistrationMethodPointer;
+  typedef typename RegistrationMethodType::FixedMaskType       FixedMaskType;
+  typedef typename RegistrationMethodType::MovingMaskType      MovingMaskType;
+  typedef typename RegistrationMethodType::ParameterObjectType ParameterObjectType;
+  typedef elastix::FixedImageDataCache                         FixedImageDataCacheType;
+
+  /** Set/Get the fixed image. Setting it clears the cache. */
+  void
+  SetFixedImage(TFixedImage * fixedImage);
+  itkGetModifiableObjectMacro(FixedImage, TFixedImage);
+
+  /** Set/Get the fixed mask (optional). Setting it clears the cache. */
+  void
+  SetFixedMask(FixedMaskType * fixedMask);
+  itkGetModifiableObjectMacro(FixedMask, FixedMaskType);
+
+  /** Set/Get the parameter object. Setting it clears the cache. */
+  void
+  SetParameterObject(ParameterObjectType * parameterObject);
+  itkGetModifiableObjectMacro(ParameterObject, ParameterObjectType);
+
+  /** Set/Get the maximum number of threads of each registration. Zero (default) means no maximum. */
+  itkSetMacro(NumberOfThreads, int);
+  itkGetConstMacro(NumberOfThreads, int);
+
+  /** Log to std::cout on/off. */
+  itkSetMacro(LogToConsole, bool);
+  itkGetConstMacro(LogToConsole, bool);
+  itkBooleanMacro(LogToConsole);
+
+  /** Get the cache of fixed image data, shared by the registrations of this session. */
+  itkGetModifiableObjectMacro(FixedImageDataCache, FixedImageDataCacheType);
+
+  /** Registers the specified moving image (optionally with a mask) against the fixed image of this session.
+   * Returns the registration method after its update, providing both the result image and the transform
+   * parameter object. When an output directory is specified, the result and the log file are written there. */
+  RegistrationMethodPointer
+  Register(TMovingImage *      movingImage,
+           MovingMaskType *    movingMask = nullptr,
+           const std::string & outputDirectory = "") const;
+
+protected:
+  ElastixRegistrationSession() = default;
+  ~ElastixRegistrationSession() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  typename TFixedImage::Pointer          m_FixedImage;
+  typename FixedMaskType::Pointer        m_FixedMask;
+  typename ParameterObjectType::Pointer  m_ParameterObject;
+  const FixedImageDataCacheType::Pointer m_FixedImageDataCache{ FixedImageDataCacheType::New() };
+
+  int  m_NumberOfThreads{ 0 };
+  bool m_LogToConsole{ false };
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkElastixRegistrationSession.hxx"
+#endif
+
+#endif // itkElastixRegistrationSession_h
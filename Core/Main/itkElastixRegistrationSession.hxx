@@ -0,0 +1,124 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkElastixRegistrationSession_hxx
+#define itkElastixRegistrationSession_hxx
+
+#include "itkElastixRegistrationSession.h"
+
+namespace itk
+{
+
+template <typename TFixedImage, typename TMovingImage>
+void
+ElastixRegistrationSession<TFixedImage, TMovingImage>::SetFixedImage(TFixedImage * const fixedImage)
+{
+  if (this->m_FixedImage != fixedImage)
+  {
+    this->m_FixedImage = fixedImage;
+    this->m_FixedImageDataCache->Clear();
+    this->Modified();
+  }
+}
+
+
+template <typename TFixedImage, typename TMovingImage>
+void
+ElastixRegistrationSession<TFixedImage, TMovingImage>::SetFixedMask(FixedMaskType * const fixedMask)
+{
+  if (this->m_FixedMask != fixedMask)
+  {
+    this->m_FixedMask = fixedMask;
+    this->m_FixedImageDataCache->Clear();
+    this->Modified();
+  }
+}
+
+
+template <typename TFixedImage, typename TMovingImage>
+void
+ElastixRegistrationSession<TFixedImage, TMovingImage>::SetParameterObject(ParameterObjectType * const parameterObject)
+{
+  if (this->m_ParameterObject != parameterObject)
+  {
+    this->m_ParameterObject = parameterObject;
+    this->m_FixedImageDataCache->Clear();
+    this->Modified();
+  }
+}
+
+
+template <typename TFixedImage, typename TMovingImage>
+auto
+ElastixRegistrationSession<TFixedImage, TMovingImage>::Register(TMovingImage * const   movingImage,
+                                                               MovingMaskType * const movingMask,
+                                                               const std::string &    outputDirectory) const
+  -> RegistrationMethodPointer
+{
+  if (this->m_FixedImage.IsNull())
+  {
+    itkExceptionMacro("No fixed image has been set!");
+  }
+  if (this->m_ParameterObject.IsNull())
+  {
+    itkExceptionMacro("No parameter object has been set!");
+  }
+
+  const auto registration = RegistrationMethodType::New();
+
+  registration->SetFixedImage(this->m_FixedImage);
+  if (this->m_FixedMask.IsNotNull())
+  {
+    registration->SetFixedMask(this->m_FixedMask);
+  }
+  registration->SetMovingImage(movingImage);
+  if (movingMask != nullptr)
+  {
+    registration->SetMovingMask(movingMask);
+  }
+  registration->SetParameterObject(this->m_ParameterObject);
+  registration->SetFixedImageDataCache(this->m_FixedImageDataCache);
+  registration->SetNumberOfThreads(this->m_NumberOfThreads);
+  registration->SetLogToConsole(this->m_LogToConsole);
+
+  if (!outputDirectory.empty())
+  {
+    registration->SetOutputDirectory(outputDirectory);
+    registration->LogToFileOn();
+  }
+
+  registration->Update();
+  return registration;
+}
+
+
+template <typename TFixedImage, typename TMovingImage>
+void
+ElastixRegistrationSession<TFixedImage, TMovingImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "FixedImage: " << this->m_FixedImage.GetPointer() << '\n'
+     << indent << "FixedMask: " << this->m_FixedMask.GetPointer() << '\n'
+     << indent << "ParameterObject: " << this->m_ParameterObject.GetPointer() << '\n'
+     << indent << "NumberOfThreads: " << this->m_NumberOfThreads << '\n'
+     << indent << "LogToConsole: " << this->m_LogToConsole << '\n'
+     << indent << "NumberOfCacheEntries: " << this->m_FixedImageDataCache->GetNumberOfEntries() << std::endl;
+}
+
+} // namespace itk
+
+#endif
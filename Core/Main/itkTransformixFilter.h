@@ -38,6 +38,7 @@
 #include "itkImageSource.h"
 
 #include "elxTransformixMain.h"
+#include "elxImportImage.h"
 #include "elxParameterObject.h"
 
 /**
@@ -188,6 +189,17 @@ public:
   itkGetConstMacro(LogToFile, bool);
   itkBooleanMacro(LogToFile);
 
+  /** Set/Get the maximum number of threads used by this filter. Zero (default) means no maximum. The maximum is
+   * specific to this filter object, so that multiple filters may run concurrently (each in its own thread). */
+  itkSetMacro(NumberOfThreads, int);
+  itkGetConstMacro(NumberOfThreads, int);
+
+  /** Set/Get an (optional) image whose buffer, allocated by the caller, receives the result image. Only used when
+   * its pixel type is equal to the internal moving image pixel type, and its number of pixels equals the size of the
+   * result image. Otherwise a new buffer is allocated. \sa elastix::ImportImage */
+  itkSetObjectMacro(ResultImageBuffer, OutputImageType);
+  itkGetModifiableObjectMacro(ResultImageBuffer, OutputImageType);
+
 protected:
   TransformixFilter();
 
@@ -228,6 +240,10 @@ private:
 
   bool m_LogToConsole;
   bool m_LogToFile;
+
+  int m_NumberOfThreads;
+
+  typename OutputImageType::Pointer m_ResultImageBuffer;
 };
 
 } // namespace itk
@@ -59,6 +59,8 @@ TransformixFilter<TMovingImage>::TransformixFilter()
 
   this->m_LogToConsole = false;
   this->m_LogToFile = false;
+
+  this->m_NumberOfThreads = 0;
 }
 
 
@@ -155,6 +157,12 @@ TransformixFilter<TMovingImage>::GenerateData()
     }
   }
 
+  // Set Number of threads
+  if (this->m_NumberOfThreads > 0)
+  {
+    argumentMap.insert(ArgumentMapEntryType("-threads", std::to_string(this->m_NumberOfThreads)));
+  }
+
   // Setup xout
   const elx::xoutManager manager(logFileName, this->GetLogToFile(), this->GetLogToConsole());
 
@@ -170,6 +178,9 @@ TransformixFilter<TMovingImage>::GenerateData()
     transformix->SetInputImageContainer(inputImageContainer);
   }
 
+  // Let transformix resample into the caller-provided buffer, if any
+  transformix->SetResultImageBuffer(this->m_ResultImageBuffer);
+
   // Get ParameterMap
   ParameterObjectPointer transformParameterObject = this->GetTransformParameterObject();
   ParameterMapVectorType transformParameterMapVector = transformParameterObject->GetParameterMap();
@@ -22,6 +22,8 @@
 #include "itkTimeProbe.h"
 #include "itkTimeProbesCollectorBase.h"
 
+#include <algorithm> // For max.
+#include <cmath>     // For sin.
 #include <fstream>
 #include <iomanip>
 
@@ -352,6 +354,115 @@ main(int argc, char * argv[])
       return 1;
     }
 
+    //
+    // Test the decoupled solver and the accelerated point evaluation.
+    // Use a smooth deformation of the source landmarks as target landmarks.
+
+    PointsContainerPointer targetLandmarkPoints = PointsContainerType::New();
+    std::vector<PointType> testPoints;
+    for (unsigned long j = 0; j < numberOfLandmarks; ++j)
+    {
+      PointType source = usedLandmarkPoints->ElementAt(j);
+      PointType target = source;
+      PointType testPoint = source;
+      for (unsigned int d = 0; d < Dimension; ++d)
+      {
+        target[d] += 2.0 * std::sin(source[d] / 30.0);
+        testPoint[d] += d + 1.0;
+      }
+      targetLandmarkPoints->push_back(target);
+      testPoints.push_back(testPoint);
+    }
+    auto targetLandmarks = PointSetType::New();
+    targetLandmarks->SetPoints(targetLandmarkPoints);
+
+    auto coupledTransform = TransformType::New();
+    timeCollector.Start("SolveCoupled");
+    coupledTransform->SetSourceLandmarks(usedLandmarks);
+    coupledTransform->SetTargetLandmarks(targetLandmarks);
+    timeCollector.Stop("SolveCoupled");
+
+    auto decoupledTransform = TransformType::New();
+    decoupledTransform->SetUseDecoupledSolver(true);
+    timeCollector.Start("SolveDecoupled");
+    decoupledTransform->SetSourceLandmarks(usedLandmarks);
+    decoupledTransform->SetTargetLandmarks(targetLandmarks);
+    timeCollector.Stop("SolveDecoupled");
+
+    // Compare the Jacobians of both solvers
+    JacobianType jac3, jac4;
+    coupledTransform->GetJacobian(p, jac3, nzji);
+    decoupledTransform->GetJacobian(p, jac4, nzji);
+    const double diff_jac_decoupled = (jac3 - jac4).frobenius_norm();
+    std::cerr << "Frobenius difference of jacs of coupled and decoupled solver: " << diff_jac_decoupled << std::endl;
+    if (diff_jac_decoupled > 1e-6)
+    {
+      std::cerr << "ERROR: Jacobian of decoupled solver differs too much: " << diff_jac_decoupled << std::endl;
+      return 1;
+    }
+
+    // Compare the transformed points of both solvers
+    std::vector<PointType> exactPoints;
+    timeCollector.Start("TransformPointExact");
+    for (const auto & testPoint : testPoints)
+    {
+      exactPoints.push_back(decoupledTransform->TransformPoint(testPoint));
+    }
+    timeCollector.Stop("TransformPointExact");
+
+    double diff_decoupled = 0.0;
+    double maxDisplacement = 0.0;
+    for (std::size_t j = 0; j < testPoints.size(); ++j)
+    {
+      const PointType coupledPoint = coupledTransform->TransformPoint(testPoints[j]);
+      diff_decoupled = std::max(diff_decoupled, coupledPoint.EuclideanDistanceTo(exactPoints[j]));
+      maxDisplacement = std::max(maxDisplacement, testPoints[j].EuclideanDistanceTo(exactPoints[j]));
+    }
+    std::cerr << "Max difference of points of coupled and decoupled solver: " << diff_decoupled << std::endl;
+    if (diff_decoupled > 1e-4)
+    {
+      std::cerr << "ERROR: transformed points of decoupled solver differ too much: " << diff_decoupled << std::endl;
+      return 1;
+    }
+
+    // Batch evaluation should give exactly the same points
+    std::vector<PointType> batchPoints;
+    timeCollector.Start("TransformPointsBatch");
+    decoupledTransform->TransformPoints(testPoints, batchPoints);
+    timeCollector.Stop("TransformPointsBatch");
+
+    double diff_batch = 0.0;
+    for (std::size_t j = 0; j < testPoints.size(); ++j)
+    {
+      diff_batch = std::max(diff_batch, batchPoints[j].EuclideanDistanceTo(exactPoints[j]));
+    }
+    std::cerr << "Max difference of points of batch evaluation: " << diff_batch << std::endl;
+    if (diff_batch > tolerance)
+    {
+      std::cerr << "ERROR: batch evaluation differs from TransformPoint: " << diff_batch << std::endl;
+      return 1;
+    }
+
+    // The far-field approximation should be accurate to about a percent
+    std::vector<PointType> farFieldPoints;
+    decoupledTransform->SetFarFieldApproximationTolerance(0.2);
+    timeCollector.Start("TransformPointsFarField");
+    decoupledTransform->TransformPoints(testPoints, farFieldPoints);
+    timeCollector.Stop("TransformPointsFarField");
+
+    double diff_farField = 0.0;
+    for (std::size_t j = 0; j < testPoints.size(); ++j)
+    {
+      diff_farField = std::max(diff_farField, farFieldPoints[j].EuclideanDistanceTo(exactPoints[j]));
+    }
+    std::cerr << "Max difference of points of far-field approximation: " << diff_farField
+              << " (max displacement: " << maxDisplacement << ")" << std::endl;
+    if (diff_farField > 0.05 * maxDisplacement)
+    {
+      std::cerr << "ERROR: far-field approximation is not accurate enough: " << diff_farField << std::endl;
+      return 1;
+    }
+
     // Report timings
     timeCollector.Report();
     std::cout << std::endl;